@@ -1038,6 +1038,69 @@ void ptenc_set_infile_enc_auto(void)
    if (infile_enc_auto == 2) infile_enc_auto = 0;
 }
 
+#if defined(MIKTEX)
+#if defined(_MSC_VER)
+#define lock_stream(fp) _lock_file(fp)
+#define unlock_stream(fp) _unlock_file(fp)
+#define getc_unlocked(fp) _getc_nolock(fp)
+#else
+#define lock_stream(fp) flockfile(fp)
+#define unlock_stream(fp) funlockfile(fp)
+#endif
+
+/* Fast path of input_line2(): copies a run of characters which need no
+   conversion straight into the buffer, holding the stream lock for the
+   whole run.  These are ASCII characters other than ESC and, if both
+   the file and the internal encoding are UTF-8, valid UTF-8 characters
+   which get_utf8() would write back unchanged.  Returns the first byte
+   which has to go through the character by character conversion; the
+   bytes read after it are pushed back with ungetc4().  Stops before a
+   character which would take the buffer beyond buffsize-30, so that
+   the caller sees the same characters as without the fast path. */
+static int getc_fast(FILE *fp, int fd, const long buffsize, boolean injis)
+{
+    const long limit = buffsize-30;
+    const boolean copy_utf8 = (infile_enc[fd] == ENC_UTF8 && is_internalUPTEX());
+    int c, len, n;
+    int cc[3];
+    long u;
+
+    if (injis || ungetbuff[fd].size > 0) return getc4(fp);
+    lock_stream(fp);
+    for (;;) {
+        c = getc_unlocked(fp);
+        if (c < 0x80) {
+            if (c == EOF || c == '\n' || c == '\r' || c == ESC || last+1 >= limit) break;
+            buffer[last++] = c;
+            continue;
+        }
+        if (!copy_utf8) break;
+        len = UTF8length(c);
+        if (len < 2 || last+len >= limit) break;
+        u = c & (0x7F >> len);
+        for (n = 0; n < len-1; n++) {
+            cc[n] = getc_unlocked(fp);
+            if ((cc[n] & 0xC0) != 0x80) break;
+            u = (u << 6) | (cc[n] & 0x3F);
+        }
+        /* overlong forms, U+FFFF and U+10FFFF are not written back
+           unchanged, BOM and voiced sound marks are special */
+        if (n < len-1
+            || (len == 3 && u < 0x800) || (len == 4 && u < 0x10000)
+            || u == 0xFFFF || u >= 0x10FFFF
+            || u == U_BOM || u == U_VOICED || u == U_SEMI_VOICED) {
+            if (n < len-1) n++;
+            while (n > 0) ungetc4(cc[--n], fp);
+            break;
+        }
+        buffer[last++] = c;
+        for (n = 0; n < len-1; n++) buffer[last++] = cc[n];
+    }
+    unlock_stream(fp);
+    return c;
+}
+#endif
+
 /* input line with encoding conversion */
 long input_line2(FILE *fp, unsigned char *buff, unsigned char *buff2,
                  long pos, const long buffsize, int *lastchar)
@@ -1091,7 +1154,11 @@ long input_line2(FILE *fp, unsigned char *buff, unsigned char *buff2,
         }
     }
 
+#if defined(MIKTEX)
+    while (last < buffsize-30 && (i=getc_fast(fp, fd, buffsize, injis)) != EOF && i!='\n' && i!='\r') {
+#else
     while (last < buffsize-30 && (i=getc4(fp)) != EOF && i!='\n' && i!='\r') {
+#endif
         /* 30 is enough large size for one char */
         /* attention: 4 times of write_hex() eats 16byte */
 #ifdef WIN32
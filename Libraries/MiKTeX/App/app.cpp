@@ -38,9 +38,11 @@
 #include <miktex/Core/AutoResource>
 #include <miktex/Core/Cfg>
 #include <miktex/Core/CommandLineBuilder>
+#include <miktex/Core/Directory>
 #include <miktex/Core/Exceptions>
 #include <miktex/Core/File>
 #include <miktex/Core/FileType>
+#include <miktex/Core/Fndb>
 #include <miktex/Core/LockFile>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Process>
@@ -50,6 +52,7 @@
 #include <miktex/Setup/SetupService>
 #include <miktex/Trace/Trace>
 #include <miktex/UI/UI>
+#include <miktex/Util/StartupProfile>
 #include <miktex/Util/StringUtil>
 
 #if defined(MIKTEX_WINDOWS)
@@ -75,6 +78,8 @@ static Application* instance = nullptr;
 
 static bool initUiFrameworkDone = false;
 static bool isLog4cxxConfigured = false;
+static bool isLoggingDeferred = false;
+static bool isLoggingDisabled = false;
 static volatile sig_atomic_t cancelled;
 
 static void MIKTEXCEECALL SignalHandler(int signalToBeHandled)
@@ -122,6 +127,7 @@ public:
     bool initialized = false;
     shared_ptr<PackageInstaller> installer;
     log4cxx::LoggerPtr logger;
+    bool loggingEnabled = false;
     TriState mpmAutoAdmin = TriState::Undetermined;
     shared_ptr<PackageManager> packageManager;
     vector<TraceCallback::TraceMessage> pendingTraceMessages;
@@ -267,6 +273,39 @@ void Application::Init(const Session::InitInfo& initInfoArg, vector<char*>& args
 
 void Application::ConfigureLogging()
 {
+    // MIKTEX_LOG=off: no appenders at all
+    // MIKTEX_LOG=eager: configure log4cxx right now
+    // otherwise: keep log events in memory until one of them is a warning
+    // (or worse); a process which runs smoothly does not touch log4cxx
+    string mode;
+    if (Utils::GetEnvironmentString("MIKTEX_LOG", mode) && mode == "off")
+    {
+        isLoggingDisabled = true;
+        pimpl->pendingTraceMessages.clear();
+        return;
+    }
+    pimpl->loggingEnabled = true;
+    if (isLog4cxxConfigured)
+    {
+        pimpl->logger = log4cxx::Logger::getLogger(Utils::GetExeName());
+    }
+    else if (mode == "eager")
+    {
+        ConfigureLog4cxx();
+    }
+    else
+    {
+        isLoggingDeferred = true;
+    }
+}
+
+void Application::ConfigureLog4cxx() const
+{
+    isLoggingDeferred = false;
+    if (pimpl->session == nullptr)
+    {
+        return;
+    }
     string myName = Utils::GetExeName();
     PathName xmlFileName;
     if (pimpl->session->FindFile(myName + "." + MIKTEX_LOG4CXX_CONFIG_FILENAME, MIKTEX_PATH_TEXMF_PLACEHOLDER "/" MIKTEX_PATH_MIKTEX_PLATFORM_CONFIG_DIR, xmlFileName)
@@ -288,6 +327,7 @@ void Application::ConfigureLogging()
     }
     isLog4cxxConfigured = true;
     pimpl->logger = log4cxx::Logger::getLogger(myName);
+    FlushPendingTraceMessages();
 }
 
 inline bool IsNewer(const PathName& path1, const PathName& path2)
@@ -349,10 +389,10 @@ void Application::AutoMaintenance()
         {
             return;
         }
-        LOG4CXX_TRACE(pimpl->logger, "running MIKTEX_HOOK_AUTO_MAINTENANCE");
+        Log(TraceLevel::Trace, "running MIKTEX_HOOK_AUTO_MAINTENANCE");
         if (mustUpdateDb)
         {
-            LOG4CXX_INFO(pimpl->logger, "refreshing user's package database from cache");
+            LogInfo("refreshing user's package database from cache");
             if (pimpl->packageManager == nullptr)
             {
                 pimpl->packageManager = PackageManager::Create(PackageManager::InitInfo(this));
@@ -388,21 +428,21 @@ void Application::AutoMaintenance()
         {
             vector<string> args = commonArgs;
             args.insert(args.end(), { "fndb", "refresh" });
-            LOG4CXX_INFO(pimpl->logger, "running One MiKTeX Utility to refresh the file name database");
+            LogInfo("running One MiKTeX Utility to refresh the file name database");
             pimpl->session->UnloadFilenameDatabase();
             if (!Process::Run(oneMiKTeXUtility, args, nullptr, &exitCode, nullptr))
             {
-                LOG4CXX_ERROR(pimpl->logger, "One MiKTEX Utility exited with code " << exitCode);
+                LogError(fmt::format("One MiKTEX Utility exited with code {0}", exitCode));
             }
         }
         if (mustRefreshFndb)
         {
             vector<string> args = commonArgs;
             args.insert(args.end(), { "fontmaps", "configure" });
-            LOG4CXX_INFO(pimpl->logger, "running One MiKTeX Utility to create font map files");
+            LogInfo("running One MiKTeX Utility to create font map files");
             if (!Process::Run(oneMiKTeXUtility, args, nullptr, &exitCode, nullptr))
             {
-                LOG4CXX_ERROR(pimpl->logger, "One MiKTEX Utility exited with code " << exitCode);
+                LogError(fmt::format("One MiKTEX Utility exited with code {0}", exitCode));
             }
         }
         if (mustRefreshUserLanguageDat)
@@ -410,10 +450,10 @@ void Application::AutoMaintenance()
             MIKTEX_ASSERT(!pimpl->session->IsAdminMode());
             vector<string> args = commonArgs;
             args.insert(args.end(), { "languages", "configure" });
-            LOG4CXX_INFO(pimpl->logger, "running One MiKTeX Utility to refresh language.dat");
+            LogInfo("running One MiKTeX Utility to refresh language.dat");
             if (!Process::Run(oneMiKTeXUtility, args, nullptr, &exitCode, nullptr))
             {
-                LOG4CXX_ERROR(pimpl->logger, "One MiKTeX Utility exited with code " << exitCode);
+                LogError(fmt::format("One MiKTeX Utility exited with code {0}", exitCode));
             }
         }
     }
@@ -439,20 +479,17 @@ void Application::AutoDiagnose()
 
     for (const Setup::Issue& issue : issues)
     {
-        if (pimpl->logger != nullptr)
+        if (issue.severity == Setup::IssueSeverity::Critical)
         {
-            if (issue.severity == Setup::IssueSeverity::Critical)
-            {
-                LOG4CXX_FATAL(pimpl->logger, issue);
-            }
-            else if (issue.severity == Setup::IssueSeverity::Major)
-            {
-                LOG4CXX_ERROR(pimpl->logger, issue);
-            }
-            else
-            {
-                LOG4CXX_WARN(pimpl->logger, issue);
-            }
+            Log(TraceLevel::Fatal, issue.ToString());
+        }
+        else if (issue.severity == Setup::IssueSeverity::Major)
+        {
+            LogError(issue.ToString());
+        }
+        else
+        {
+            LogWarn(issue.ToString());
         }
         if ((issue.severity == Setup::IssueSeverity::Critical || issue.severity == Setup::IssueSeverity::Major) && !GetQuietFlag())
         {
@@ -465,12 +502,16 @@ void Application::Init(const Session::InitInfo& initInfoArg)
 {
     instance = this;
     pimpl->initialized = true;
+    StartupProfileSection startupProfileSection("Application::Init");
     Session::InitInfo initInfo(initInfoArg);
     initInfo.SetTraceCallback(this);
     pimpl->session = Session::Create(initInfo);
     pimpl->session->SetFindFileCallback(this);
     pimpl->translator = make_unique<Translator>(MIKTEX_COMP_ID, &pimpl->resources, pimpl->session);
-    ConfigureLogging();
+    {
+        StartupProfileSection startupProfileSection("configure logging");
+        ConfigureLogging();
+    }
     auto thisProcess = Process::GetCurrentProcess();
     auto parentProcess = thisProcess->get_Parent();
     string invokerName;
@@ -490,9 +531,9 @@ void Application::Init(const Session::InitInfo& initInfoArg)
     {
         PathName cwd;
         cwd.SetToCurrentDirectory();
-        LOG4CXX_INFO(pimpl->logger, fmt::format("this process ({0}) started by {1} in directory {2} with command line: {3}", thisProcess->GetSystemId(), Q_(invokerName), cwd.ToDisplayString(), pimpl->commandLine));
+        LogInfo(fmt::format("this process ({0}) started by {1} in directory {2} with command line: {3}", thisProcess->GetSystemId(), Q_(invokerName), cwd.ToDisplayString(), pimpl->commandLine));
 #if defined(MIKTEX_WINDOWS)
-        LOG4CXX_INFO(pimpl->logger, fmt::format("running on Windows {0}", WindowsVersion::GetMajorMinorBuildString()));
+        LogInfo(fmt::format("running on Windows {0}", WindowsVersion::GetMajorMinorBuildString()));
 #endif
     }
     pimpl->beQuiet = false;
@@ -556,10 +597,10 @@ void Application::Init(const string& programInvocationName)
 
 void Application::Finalize2(int exitCode)
 {
-    if (pimpl->logger != nullptr)
+    if (pimpl->loggingEnabled)
     {
         auto thisProcess = Process::GetCurrentProcess();
-        LOG4CXX_INFO(pimpl->logger, "this process (" << thisProcess->GetSystemId() << ") finishes with exit code " << exitCode);
+        LogInfo(fmt::format("this process ({0}) finishes with exit code {1}", thisProcess->GetSystemId(), exitCode));
     }
     Finalize();
 }
@@ -570,6 +611,12 @@ void Application::Finalize()
     {
         AutoDiagnose();
     }
+    if (isLoggingDeferred)
+    {
+        // nothing worth configuring log4cxx for
+        isLoggingDeferred = false;
+        pimpl->pendingTraceMessages.clear();
+    }
     FlushPendingTraceMessages();
     if (pimpl->installer != nullptr)
     {
@@ -590,14 +637,14 @@ void Application::Finalize()
         initUiFrameworkDone = false;
     }
     pimpl->logger = nullptr;
+    pimpl->loggingEnabled = false;
     pimpl->initialized = false;
     instance = nullptr;
 }
 
 void Application::ReportLine(const string& str)
 {
-    MIKTEX_ASSERT(pimpl->logger != nullptr);
-    LOG4CXX_INFO(pimpl->logger, "mpm: " << str);
+    LogInfo("mpm: " + str);
 }
 
 bool Application::OnRetryableError(const string& message)
@@ -696,7 +743,7 @@ bool Application::InstallPackage(const string& packageId, const PathName& trigge
     vector<string> fileList;
     fileList.push_back(packageId);
     pimpl->installer->SetFileLists(fileList, vector<string>());
-    LOG4CXX_INFO(pimpl->logger, "installing package " << packageId << " triggered by " << trigger.ToString());
+    LogInfo(fmt::format("installing package {0} triggered by {1}", packageId, trigger.ToString()));
     bool done = false;
     bool switchToAdminMode = (pimpl->mpmAutoAdmin == TriState::True && !pimpl->session->IsAdminMode());
     if (switchToAdminMode)
@@ -713,10 +760,10 @@ bool Application::InstallPackage(const string& packageId, const PathName& trigge
     {
         pimpl->enableInstaller = TriState::False;
         pimpl->ignoredPackages.insert(packageId);
-        LOG4CXX_FATAL(pimpl->logger, ex.GetErrorMessage());
-        LOG4CXX_FATAL(pimpl->logger, "Info: " << ex.GetInfo());
-        LOG4CXX_FATAL(pimpl->logger, "Source: " << ex.GetSourceFile());
-        LOG4CXX_FATAL(pimpl->logger, "Line: " << ex.GetSourceLine());
+        Log(TraceLevel::Fatal, ex.GetErrorMessage());
+        Log(TraceLevel::Fatal, "Info: " + ex.GetInfo().ToString());
+        Log(TraceLevel::Fatal, "Source: " + ex.GetSourceFile());
+        Log(TraceLevel::Fatal, fmt::format("Line: {0}", ex.GetSourceLine()));
     }
     if (switchToAdminMode)
     {
@@ -745,6 +792,7 @@ bool Application::TryCreateFile(const PathName& fileName, FileType fileType)
     }
     PathName makeUtility;
     PathName baseName = fileName.GetFileNameWithoutExtension();
+    PathName madeFile;
     switch (fileType)
     {
     case FileType::BASE:
@@ -767,25 +815,47 @@ bool Application::TryCreateFile(const PathName& fileName, FileType fileType)
         }
         args.push_back(baseName.ToString());
         break;
+    case FileType::MISCFONT:
+    {
+        // compiled TECkit mappings are made from their sources; the
+        // compiler is not part of MiKTeX, so it must be installed
+        // separately
+        PathName mappingSource;
+        if (!fileName.HasExtension(".tec")
+            || !pimpl->session->FindFile(PathName(baseName).AppendExtension(".map").ToString(), FileType::MISCFONT, mappingSource)
+            || !pimpl->session->FindFile("teckit_compile", FileType::EXE, makeUtility))
+        {
+            return false;
+        }
+        madeFile = pimpl->session->GetSpecialPath(pimpl->session->IsAdminMode() ? SpecialPath::CommonDataRoot : SpecialPath::UserDataRoot)
+            / PathName(MIKTEX_PATH_MISCFONT_DIR) / PathName("xetex") / PathName("fontmapping") / fileName.GetFileName();
+        Directory::Create(madeFile.GetDirectoryName());
+        args = { "", mappingSource.ToString(), "-o", madeFile.ToString() };
+        break;
+    }
     default:
         return false;
     }
-    LOG4CXX_INFO(pimpl->logger, "going to create file: " << fileName);
+    LogInfo("going to create file: " + fileName.ToDisplayString());
     ProcessOutput<50000> processOutput;
     int exitCode;
     args[0] = makeUtility.GetFileNameWithoutExtension().ToString();
     if (!Process::Run(makeUtility, args, &processOutput, &exitCode, nullptr))
     {
-        LOG4CXX_ERROR(pimpl->logger, makeUtility << " could not be started");
+        LogError(makeUtility.ToDisplayString() + " could not be started");
         return false;
     }
     if (exitCode != 0)
     {
-        LOG4CXX_ERROR(pimpl->logger, makeUtility << " did not succeed; exitCode: " << exitCode);
-        LOG4CXX_ERROR(pimpl->logger, "output:");
-        LOG4CXX_ERROR(pimpl->logger, processOutput.StdoutToString());
+        LogError(fmt::format("{0} did not succeed; exitCode: {1}", makeUtility.ToDisplayString(), exitCode));
+        LogError("output:");
+        LogError(processOutput.StdoutToString());
         return false;
     }
+    if (!madeFile.Empty() && !Fndb::FileExists(madeFile))
+    {
+        Fndb::Add({ {madeFile} });
+    }
     return true;
 }
 
@@ -801,6 +871,26 @@ TriState Application::GetEnableInstaller() const
 
 bool Application::Trace(const TraceCallback::TraceMessage& traceMessage)
 {
+    Log(traceMessage);
+    return true;
+}
+
+void Application::Log(TraceLevel level, const string& message) const
+{
+    if (!pimpl->loggingEnabled)
+    {
+        return;
+    }
+    // an empty facility denotes the application logger
+    Log(TraceCallback::TraceMessage("", "", level, message));
+}
+
+void Application::Log(const TraceCallback::TraceMessage& traceMessage) const
+{
+    if (isLoggingDisabled)
+    {
+        return;
+    }
     if (!isLog4cxxConfigured)
     {
         if (pimpl->pendingTraceMessages.size() > 100)
@@ -808,14 +898,17 @@ bool Application::Trace(const TraceCallback::TraceMessage& traceMessage)
             pimpl->pendingTraceMessages.clear();
         }
         pimpl->pendingTraceMessages.push_back(traceMessage);
-        return true;
+        if (isLoggingDeferred && traceMessage.level <= TraceLevel::Warning)
+        {
+            ConfigureLog4cxx();
+        }
+        return;
     }
     FlushPendingTraceMessages();
     TraceInternal(traceMessage);
-    return true;
 }
 
-void Application::FlushPendingTraceMessages()
+void Application::FlushPendingTraceMessages() const
 {
     for (const TraceCallback::TraceMessage& m : pimpl->pendingTraceMessages)
     {
@@ -824,11 +917,15 @@ void Application::FlushPendingTraceMessages()
     pimpl->pendingTraceMessages.clear();
 }
 
-void Application::TraceInternal(const TraceCallback::TraceMessage& traceMessage)
+void Application::TraceInternal(const TraceCallback::TraceMessage& traceMessage) const
 {
     if (isLog4cxxConfigured)
     {
-        log4cxx::LoggerPtr logger = log4cxx::Logger::getLogger(string("trace.") + Utils::GetExeName() + "." + traceMessage.facility);
+        log4cxx::LoggerPtr logger = traceMessage.facility.empty() ? pimpl->logger : log4cxx::Logger::getLogger(string("trace.") + Utils::GetExeName() + "." + traceMessage.facility);
+        if (logger == nullptr)
+        {
+            return;
+        }
         switch (traceMessage.level)
         {
         case TraceLevel::Fatal:
@@ -885,6 +982,10 @@ void Application::Sorry(const string& name, const string& description, const str
                 << endl;
         }
     }
+    if (isLoggingDeferred)
+    {
+        ConfigureLog4cxx();
+    }
     if (isLog4cxxConfigured)
     {
 #if defined(MIKTEX_LOG4CXX_12)
@@ -914,12 +1015,12 @@ void Application::Sorry(const string& name, const string& description, const str
 
 void Application::Sorry(const string& name, const MiKTeXException& ex)
 {
-    if (pimpl->logger != nullptr)
+    if (pimpl->loggingEnabled)
     {
-        LOG4CXX_FATAL(pimpl->logger, ex.GetErrorMessage());
-        LOG4CXX_FATAL(pimpl->logger, "Info: " << ex.GetInfo());
-        LOG4CXX_FATAL(pimpl->logger, "Source: " << ex.GetSourceFile());
-        LOG4CXX_FATAL(pimpl->logger, "Line: " << ex.GetSourceLine());
+        Log(TraceLevel::Fatal, ex.GetErrorMessage());
+        Log(TraceLevel::Fatal, "Info: " + ex.GetInfo().ToString());
+        Log(TraceLevel::Fatal, "Source: " + ex.GetSourceFile());
+        Log(TraceLevel::Fatal, fmt::format("Line: {0}", ex.GetSourceLine()));
     }
     else
     {
@@ -930,9 +1031,9 @@ void Application::Sorry(const string& name, const MiKTeXException& ex)
 
 void Application::Sorry(const string& name, const exception& ex)
 {
-    if (pimpl->logger != nullptr)
+    if (pimpl->loggingEnabled)
     {
-        LOG4CXX_FATAL(pimpl->logger, ex.what());
+        Log(TraceLevel::Fatal, ex.what());
     }
     else
     {
@@ -945,10 +1046,7 @@ void Application::Sorry(const string& name, const exception& ex)
 
 MIKTEXNORETURN void Application::FatalError(const string& s)
 {
-    if (pimpl->logger != nullptr)
-    {
-        LOG4CXX_FATAL(pimpl->logger, s);
-    }
+    Log(TraceLevel::Fatal, s);
     Sorry(Utils::GetExeName(), s);
     throw 1;
 
@@ -1100,24 +1198,15 @@ shared_ptr<Session> Application::GetSession() const
 
 void Application::LogInfo(const std::string& message) const
 {
-    if (pimpl->logger != nullptr)
-    {
-        LOG4CXX_INFO(pimpl->logger, message);
-    }
+    Log(TraceLevel::Info, message);
 }
 
 void Application::LogWarn(const std::string& message) const
 {
-    if (pimpl->logger != nullptr)
-    {
-        LOG4CXX_WARN(pimpl->logger, message);
-    }
+    Log(TraceLevel::Warning, message);
 }
 
 void Application::LogError(const std::string& message) const
 {
-    if (pimpl->logger != nullptr)
-    {
-        LOG4CXX_ERROR(pimpl->logger, message);
-    }
+    Log(TraceLevel::Error, message);
 }
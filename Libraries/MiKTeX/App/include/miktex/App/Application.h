@@ -251,9 +251,12 @@ protected:
 
 private:
 
-    void FlushPendingTraceMessages();
-    void TraceInternal(const MiKTeX::Trace::TraceCallback::TraceMessage& traceMessage);
+    void FlushPendingTraceMessages() const;
+    void TraceInternal(const MiKTeX::Trace::TraceCallback::TraceMessage& traceMessage) const;
+    void Log(MiKTeX::Trace::TraceLevel level, const std::string& message) const;
+    void Log(const MiKTeX::Trace::TraceCallback::TraceMessage& traceMessage) const;
     void ConfigureLogging();
+    void ConfigureLog4cxx() const;
     void AutoMaintenance();
     void AutoDiagnose();
 
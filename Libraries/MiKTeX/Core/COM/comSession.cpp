@@ -44,6 +44,8 @@ using namespace MiKTeX::Util;
 using namespace MiKTeXSessionLib;
 using namespace std;
 
+thread_local MiKTeXException comSession::lastMiKTeXException;
+
 comSession::~comSession()
 {
   try
@@ -90,10 +92,12 @@ STDMETHODIMP comSession::RegisterRootDirectories(BSTR rootDirectories)
   try
   {
     CreateSession();
+    lock_guard<mutex> lockGuard(stateMutex);
     for (const auto& root : StringUtil::Split(WU_(rootDirectories), PathNameUtil::PathNameDelimiter))
     {
       session->RegisterRootDirectory(PathName(root), false);
     }
+    setupInfoCache = nullptr;
   }
   catch (const _com_error& e)
   {
@@ -182,28 +186,53 @@ STDMETHODIMP comSession::GetMiKTeXSetupInfo(MiKTeXSetupInfo* setupInfo)
   try
   {
     CreateSession();
-    if (!session->IsAdminMode())
+    SetupInfo info;
+    {
+      lock_guard<mutex> lockGuard(stateMutex);
+      if (setupInfoCache == nullptr)
+      {
+        unique_ptr<SetupInfo> newInfo = make_unique<SetupInfo>();
+        newInfo->adminMode = session->IsAdminMode();
+        if (!newInfo->adminMode)
+        {
+          newInfo->userConfigRoot = session->GetSpecialPath(SpecialPath::UserConfigRoot).ToWideCharString();
+          newInfo->userDataRoot = session->GetSpecialPath(SpecialPath::UserDataRoot).ToWideCharString();
+        }
+        newInfo->sharedSetup = session->IsSharedSetup();
+        if (newInfo->sharedSetup)
+        {
+          newInfo->commonConfigRoot = session->GetSpecialPath(SpecialPath::CommonConfigRoot).ToWideCharString();
+          newInfo->commonDataRoot = session->GetSpecialPath(SpecialPath::CommonDataRoot).ToWideCharString();
+        }
+        newInfo->numRoots = session->GetNumberOfTEXMFRoots();
+        newInfo->binDirectory = session->GetSpecialPath(SpecialPath::BinDirectory).ToWideCharString();
+        newInfo->installRoot = session->GetSpecialPath(SpecialPath::InstallRoot).ToWideCharString();
+        setupInfoCache = std::move(newInfo);
+      }
+      info = *setupInfoCache;
+    }
+    if (!info.adminMode)
     {
-      _bstr_t userConfigRoot = UW_(session->GetSpecialPath(SpecialPath::UserConfigRoot).ToWideCharString());
-      _bstr_t userDataRoot = UW_(session->GetSpecialPath(SpecialPath::UserDataRoot).ToWideCharString());
+      _bstr_t userConfigRoot = info.userConfigRoot.c_str();
+      _bstr_t userDataRoot = info.userDataRoot.c_str();
       setupInfo->userConfigRoot = userConfigRoot.Detach();
       setupInfo->userDataRoot = userDataRoot.Detach();
     }
-    if (session->IsSharedSetup())
+    if (info.sharedSetup)
     {
-      _bstr_t commonConfigRoot = UW_(session->GetSpecialPath(SpecialPath::CommonConfigRoot).ToWideCharString());
-      _bstr_t commonDataRoot = UW_(session->GetSpecialPath(SpecialPath::CommonDataRoot).ToWideCharString());
+      _bstr_t commonConfigRoot = info.commonConfigRoot.c_str();
+      _bstr_t commonDataRoot = info.commonDataRoot.c_str();
       setupInfo->commonConfigRoot = commonConfigRoot.Detach();
       setupInfo->commonDataRoot = commonDataRoot.Detach();
     }
-    setupInfo->sharedSetup = session->IsSharedSetup() ? VARIANT_TRUE : VARIANT_FALSE;
+    setupInfo->sharedSetup = info.sharedSetup ? VARIANT_TRUE : VARIANT_FALSE;
     setupInfo->series = MIKTEX_MAJOR_MINOR_INT;
-    setupInfo->numRoots = session->GetNumberOfTEXMFRoots();
+    setupInfo->numRoots = info.numRoots;
     _bstr_t version = UW_(MIKTEX_LEGACY_MAJOR_MINOR_STR);
     setupInfo->version = version.Detach();
-    _bstr_t binDirectory = UW_(session->GetSpecialPath(SpecialPath::BinDirectory).ToWideCharString());
+    _bstr_t binDirectory = info.binDirectory.c_str();
     setupInfo->binDirectory = binDirectory.Detach();
-    _bstr_t installRoot = UW_(session->GetSpecialPath(SpecialPath::InstallRoot).ToWideCharString());
+    _bstr_t installRoot = info.installRoot.c_str();
     setupInfo->installRoot = installRoot.Detach();
     return S_OK;
 
@@ -295,6 +324,7 @@ STDMETHODIMP comSession::FindFile(BSTR fileName, BSTR* path, VARIANT_BOOL* found
 
 void comSession::CreateSession()
 {
+  lock_guard<mutex> lockGuard(stateMutex);
   if (session == nullptr)
   {
     session = Session::TryGet();
@@ -93,11 +93,35 @@ public:
 private:
   void CreateSession();
 
+  // the object is a singleton, called from many threads: the error of
+  // the last failed call is kept per thread, as COM does with
+  // SetErrorInfo()
 private:
-  MiKTeX::Core::MiKTeXException lastMiKTeXException;
+  static thread_local MiKTeX::Core::MiKTeXException lastMiKTeXException;
 
 private:
   std::shared_ptr<MiKTeX::Core::Session> session;
+
+private:
+  struct SetupInfo
+  {
+    bool adminMode = false;
+    std::wstring userConfigRoot;
+    std::wstring userDataRoot;
+    std::wstring commonConfigRoot;
+    std::wstring commonDataRoot;
+    bool sharedSetup = false;
+    long numRoots = 0;
+    std::wstring binDirectory;
+    std::wstring installRoot;
+  };
+
+  // editors ask for the setup info over and over again
+private:
+  std::unique_ptr<SetupInfo> setupInfoCache;
+
+private:
+  std::mutex stateMutex;
 };
 
 OBJECT_ENTRY_AUTO(__uuidof(MiKTeXSessionLib::MAKE_CURVER_ID(MiKTeXSession)), comSession);
@@ -28,6 +28,7 @@
 
 #include "internal.h"
 
+#include "Utils/LineReader.h"
 #include "Utils/inliners.h"
 
 using namespace std;
@@ -66,6 +67,17 @@ MIKTEXSTATICFUNC(string) Trim(const string& str)
     return result;
 }
 
+MIKTEXSTATICFUNC(string_view) Trim(string_view str)
+{
+    constexpr const char* WHITESPACE = " \t\r\n";
+    size_t pos = str.find_first_not_of(WHITESPACE);
+    if (pos == string_view::npos)
+    {
+        return string_view();
+    }
+    return str.substr(pos, str.find_last_not_of(WHITESPACE) - pos + 1);
+}
+
 Cfg::Value::~Value() noexcept
 {
 }
@@ -579,12 +591,18 @@ public:
         return !signature.empty();
     }
 
+    vector<PathName> MIKTEXTHISCALL GetInputFiles() const override
+    {
+        return inputFiles;
+    }
+
     void MIKTEXTHISCALL Write(const PathName& path, const string& header, IPrivateKeyProvider* pPrivateKeyProvider) override;
 
 private:
 
     void Read(const PathName& path, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile);
     void Read(std::istream& reader, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile);
+    void Read(LineReader& reader, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile);
 
     enum PutMode {
         None,
@@ -605,6 +623,7 @@ private:
     void PutValue(const string& keyName, const string& valueName, string&& value, PutMode putMode, string&& documentation, bool commentedOut);
 
     PathName currentFile;
+    vector<PathName> inputFiles;
     KeyMap keyMap;
     int lineno = 0;
     Options options;
@@ -872,12 +891,23 @@ void CfgImpl::Read(const PathName& path, const string& defaultKeyName, int level
     traceStream->WriteLine("core", fmt::format(T_("parsing: {0}..."), path.ToDisplayString()));
     AutoRestore<int> autoRestore1(lineno);
     AutoRestore<PathName> autoRestore(currentFile);
-    std::ifstream reader = File::CreateInputStream(path);
+    LineReader reader(path);
+    inputFiles.push_back(path);
     Read(reader, defaultKeyName, level, mustBeSigned, publicKeyFile);
-    reader.close();
 }
 
 void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile)
+{
+    string text((istreambuf_iterator<char>(reader)), istreambuf_iterator<char>());
+    if (reader.bad())
+    {
+        FATAL_CFG_ERROR(T_("error reading the configuration file"));
+    }
+    LineReader lineReader(std::move(text));
+    Read(lineReader, defaultKeyName, level, mustBeSigned, publicKeyFile);
+}
+
+void CfgImpl::Read(LineReader& reader, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile)
 {
     MIKTEX_ASSERT(!(level > 0 && mustBeSigned));
 
@@ -897,7 +927,7 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
 
     string documentation;
 
-    for (string line; std::getline(reader, line); )
+    for (string_view line; reader.ReadLine(line); )
     {
         ++lineno;
         line = Trim(line);
@@ -958,7 +988,7 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
             {
                 documentation += '\n';
             }
-            documentation += &line[3];
+            documentation += line.substr(3);
         }
         else if ((line.length() >= 2 && line[0] == COMMENT_CHAR && (IsAlphaNumericAScii(line[1]) || line[1] == '.')) || IsAlphaNumericAScii(line[0]) || line[0] == '.')
         {
@@ -967,7 +997,7 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
                 string valueName;
                 string value;
                 PutMode putMode;
-                if (!ParseValueDefinition(line[0] == COMMENT_CHAR ? line.substr(1) : line, valueName, value, putMode))
+                if (!ParseValueDefinition(string(line[0] == COMMENT_CHAR ? line.substr(1) : line), valueName, value, putMode))
                 {
                     FATAL_CFG_ERROR(T_("invalid value definition"));
                 }
@@ -992,11 +1022,6 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
         }
     }
 
-    if (reader.bad() || (reader.fail() && !reader.eof()))
-    {
-        FATAL_CFG_ERROR(T_("error reading the configuration file"));
-    }
-
     if (mustBeSigned && signature.empty())
     {
         FATAL_CFG_ERROR(T_("the configuration file is not signed"));
@@ -23,4 +23,34 @@ class MiKTeX::Core::Argv::impl
 {
 public:
   std::vector<char*> argv;
+
+  // the strings of a batch of arguments live in one allocation
+public:
+  std::vector<std::unique_ptr<char[]>> arenas;
+
+public:
+  void Append(const std::vector<std::string>& arguments)
+  {
+    MIKTEX_ASSERT(!argv.empty());
+    MIKTEX_ASSERT(argv.back() == nullptr);
+    argv.pop_back();
+    size_t size = 0;
+    for (const std::string& arg : arguments)
+    {
+      size += arg.length() + 1;
+    }
+    if (size > 0)
+    {
+      arenas.push_back(std::unique_ptr<char[]>(new char[size]));
+      char* pool = arenas.back().get();
+      argv.reserve(argv.size() + arguments.size() + 1);
+      for (const std::string& arg : arguments)
+      {
+        memcpy(pool, arg.c_str(), arg.length() + 1);
+        argv.push_back(pool);
+        pool += arg.length() + 1;
+      }
+    }
+    argv.push_back(nullptr);
+  }
 };
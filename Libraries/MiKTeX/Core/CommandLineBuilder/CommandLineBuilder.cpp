@@ -45,19 +45,6 @@ Argv::Argv(Argv&& rhs) :
 
 Argv::~Argv() noexcept
 {
-  try
-  {
-    if (pimpl != nullptr)
-    {
-      for (vector<char*>::iterator it = pimpl->argv.begin(); it != pimpl->argv.end() && *it != nullptr; ++it)
-      {
-        MIKTEX_FREE(*it);
-      }
-    }
-  }
-  catch (const exception&)
-  {
-  }
 }
 
 Argv::Argv(const string& commandLine) :
@@ -69,15 +56,7 @@ Argv::Argv(const string& commandLine) :
 Argv::Argv(const vector<string>& arguments) :
   pimpl(new impl{ { nullptr } })
 {
-  MIKTEX_ASSERT(!pimpl->argv.empty());
-  MIKTEX_ASSERT(pimpl->argv.back() == nullptr);
-  pimpl->argv.pop_back();
-  MIKTEX_ASSERT(pimpl->argv.empty());
-  for(const string& arg : arguments)
-  {
-    pimpl->argv.push_back(MIKTEX_STRDUP(arg.c_str()));
-  }
-  pimpl->argv.push_back(nullptr);
+  pimpl->Append(arguments);
 }
 
 const char* const* Argv::GetArgv() const
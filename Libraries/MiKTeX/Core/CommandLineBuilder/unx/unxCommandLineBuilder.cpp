@@ -35,9 +35,7 @@ using namespace std;
 // borrowed from the popt library
 void Argv::Append(const string& arguments)
 {
-  MIKTEX_ASSERT(!pimpl->argv.empty());
-  MIKTEX_ASSERT(pimpl->argv.back() == nullptr);
-  pimpl->argv.pop_back();
+  vector<string> args;
   string arg;
   char quote = 0;
   for (const char* lpsz = arguments.c_str(); *lpsz != 0; ++lpsz)
@@ -66,7 +64,7 @@ void Argv::Append(const string& arguments)
     {
       if (arg.length() > 0)
       {
-        pimpl->argv.push_back(MIKTEX_STRDUP(arg.c_str()));
+        args.push_back(arg);
         arg = "";
       }
     }
@@ -94,7 +92,7 @@ void Argv::Append(const string& arguments)
   }
   if (!arg.empty())
   {
-    pimpl->argv.push_back(MIKTEX_STRDUP(arg.c_str()));
+    args.push_back(arg);
   }
-  pimpl->argv.push_back(nullptr);
+  pimpl->Append(args);
 }
@@ -34,9 +34,7 @@ using namespace MiKTeX::Core;
 // mimic the behaviour of CommandLineToArgvW().
 void Argv::Append(const string& arguments)
 {
-  MIKTEX_ASSERT(!pimpl->argv.empty());
-  MIKTEX_ASSERT(pimpl->argv.back() == nullptr);
-  pimpl->argv.pop_back();
+  vector<string> args;
   for (const char* lpsz = arguments.c_str(); *lpsz != 0; )
   {
     for (; *lpsz == ' ' || *lpsz == '\t'; ++lpsz)
@@ -78,7 +76,7 @@ void Argv::Append(const string& arguments)
       }
       if (*lpsz == 0 || ((*lpsz == ' ' || *lpsz == '\t') && !inQuotation))
       {
-        pimpl->argv.push_back(MIKTEX_STRDUP(arg.c_str()));
+        args.push_back(arg);
         break;
       }
       else if (!quoteOrUnquote)
@@ -87,5 +85,5 @@ void Argv::Append(const string& arguments)
       }
     }
   }
-  pimpl->argv.push_back(nullptr);
+  pimpl->Append(args);
 }
@@ -21,12 +21,72 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <thread>
+
 #include <miktex/Core/DirectoryLister>
 
 #include "internal.h"
 
+using namespace std;
+
 using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
 
 DirectoryLister::~DirectoryLister() noexcept
 {
 }
+
+vector<vector<DirectoryEntry>> DirectoryLister::ReadDirectories(const vector<PathName>& directories, const char* pattern, int options)
+{
+  vector<vector<DirectoryEntry>> result(directories.size());
+  // directory reads are I/O bound: a few more readers than cores pay off
+  // on cold caches, but more than that only adds contention
+  const size_t maxReaders = 8;
+  size_t numReaders = min({ directories.size(), static_cast<size_t>(max(thread::hardware_concurrency(), 2u)), maxReaders });
+  if (numReaders <= 1)
+  {
+    for (size_t idx = 0; idx < directories.size(); ++idx)
+    {
+      result[idx] = ReadDirectory(directories[idx], pattern, options);
+    }
+    return result;
+  }
+  vector<exception_ptr> errors(directories.size());
+  atomic<size_t> next(0);
+  auto reader = [&]()
+  {
+    for (size_t idx = next++; idx < directories.size(); idx = next++)
+    {
+      try
+      {
+        result[idx] = ReadDirectory(directories[idx], pattern, options);
+      }
+      catch (...)
+      {
+        errors[idx] = current_exception();
+      }
+    }
+  };
+  vector<future<void>> readers;
+  for (size_t n = 1; n < numReaders; ++n)
+  {
+    readers.push_back(async(launch::async, reader));
+  }
+  reader();
+  for (future<void>& f : readers)
+  {
+    f.get();
+  }
+  for (const exception_ptr& e : errors)
+  {
+    if (e != nullptr)
+    {
+      rethrow_exception(e);
+    }
+  }
+  return result;
+}
@@ -22,6 +22,7 @@
 #include "config.h"
 
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 
 #include <miktex/Core/DirectoryLister>
@@ -112,6 +113,23 @@ inline bool IsDotDirectory(const char* entry)
   return entry[1] == '.' && entry[2] == 0;
 }
 
+// only consult the inode, if the file system doesn't tell the type
+static bool IsDirectoryEntry(DIR* dir, const struct dirent* dent, const PathName& directory)
+{
+#if defined(HAVE_STRUCT_DIRENT_D_TYPE)
+  if (dent->d_type != DT_UNKNOWN)
+  {
+    return dent->d_type == DT_DIR;
+  }
+#endif
+  struct stat statbuf;
+  if (fstatat(dirfd(dir), dent->d_name, &statbuf, AT_SYMLINK_NOFOLLOW) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("fstatat", "path", (directory / PathName(dent->d_name)).ToString());
+  }
+  return S_ISDIR(statbuf.st_mode) != 0;
+}
+
 bool unxDirectoryLister::GetNext(DirectoryEntry2& direntry2, bool simple)
 {
   if (dir == nullptr)
@@ -136,14 +154,7 @@ bool unxDirectoryLister::GetNext(DirectoryEntry2& direntry2, bool simple)
       }
       return false;
     }
-#if defined(HAVE_STRUCT_DIRENT_D_TYPE)
-    isDirectory = dent->d_type == DT_DIR;
-#else
-    if (options != (int)Options::None)
-    {
-      UNIMPLEMENTED();
-    }
-#endif
+    isDirectory = (options & ((int)Options::DirectoriesOnly | (int)Options::FilesOnly)) != 0 && IsDirectoryEntry(dir, dent, directory);
   } while ((IsDotDirectory(dent->d_name) && ((options & (int)Options::IncludeDotAndDotDot) == 0))
            || (!pattern.empty() && !PathName::Match(pattern.c_str(), dent->d_name))
            || ((options & (int)Options::DirectoriesOnly) != 0 && !isDirectory)
@@ -170,3 +181,43 @@ bool unxDirectoryLister::GetNext(DirectoryEntry2& direntry2, bool simple)
   }
   return true;
 }
+
+vector<DirectoryEntry> DirectoryLister::ReadDirectory(const PathName& directory, const char* pattern, int options)
+{
+  DIR* dir = opendir(directory.GetData());
+  if (dir == nullptr)
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("opendir", "dir", directory.ToString());
+  }
+  unique_ptr<DIR, int (*)(DIR*)> autoClose(dir, closedir);
+  vector<DirectoryEntry> entries;
+  while (true)
+  {
+    int olderrno = errno;
+    struct dirent* dent = readdir(dir);
+    if (dent == nullptr)
+    {
+      if (errno != olderrno)
+      {
+        MIKTEX_FATAL_CRT_ERROR_2("readdir", "dir", directory.ToString());
+      }
+      break;
+    }
+    if ((IsDotDirectory(dent->d_name) && (options & (int)Options::IncludeDotAndDotDot) == 0)
+      || (pattern != nullptr && *pattern != 0 && !PathName::Match(pattern, dent->d_name)))
+    {
+      continue;
+    }
+    bool isDirectory = IsDirectoryEntry(dir, dent, directory);
+    if (((options & (int)Options::DirectoriesOnly) != 0 && !isDirectory)
+      || ((options & (int)Options::FilesOnly) != 0 && isDirectory))
+    {
+      continue;
+    }
+    DirectoryEntry entry;
+    entry.name = dent->d_name;
+    entry.isDirectory = isDirectory;
+    entries.push_back(std::move(entry));
+  }
+  return entries;
+}
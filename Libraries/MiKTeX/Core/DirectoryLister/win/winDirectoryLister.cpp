@@ -158,3 +158,47 @@ bool winDirectoryLister::GetNext(DirectoryEntry2& direntry2)
     }
     return true;
 }
+
+vector<DirectoryEntry> DirectoryLister::ReadDirectory(const PathName& directory, const char* pattern, int options)
+{
+    PathName pathPattern(directory);
+    pathPattern /= (pattern == nullptr || *pattern == 0 ? "*" : pattern);
+    WIN32_FIND_DATAW ffdat;
+    HANDLE handle = FindFirstFileExW(
+        pathPattern.ToExtendedLengthPathName().ToWideCharString().c_str(),
+        IsWindows7OrGreater() ? FindExInfoBasic : FindExInfoStandard,
+        &ffdat,
+        (options & (int)Options::DirectoriesOnly) != 0 ? FindExSearchLimitToDirectories : FindExSearchNameMatch,
+        nullptr,
+        IsWindows7OrGreater() ? FIND_FIRST_EX_LARGE_FETCH : 0);
+    vector<DirectoryEntry> entries;
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        if (::GetLastError() != ERROR_FILE_NOT_FOUND)
+        {
+            MIKTEX_FATAL_WINDOWS_ERROR_2("FindFirstFileExW", "directory", directory.ToString());
+        }
+        return entries;
+    }
+    unique_ptr<void, BOOL(WINAPI*)(HANDLE)> autoClose(handle, FindClose);
+    do
+    {
+        bool isDirectory = (ffdat.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        if ((isDirectory && IsDotDirectory(ffdat.cFileName) && (options & (int)Options::IncludeDotAndDotDot) == 0)
+            || ((options & (int)Options::DirectoriesOnly) != 0 && !isDirectory)
+            || ((options & (int)Options::FilesOnly) != 0 && isDirectory))
+        {
+            continue;
+        }
+        DirectoryEntry entry;
+        entry.wname = ffdat.cFileName;
+        entry.name = WU_(ffdat.cFileName);
+        entry.isDirectory = isDirectory;
+        entries.push_back(std::move(entry));
+    } while (FindNextFileW(handle, &ffdat));
+    if (::GetLastError() != ERROR_NO_MORE_FILES)
+    {
+        MIKTEX_FATAL_WINDOWS_ERROR_2("FindNextFileW", "directory", directory.ToString());
+    }
+    return entries;
+}
@@ -174,6 +174,21 @@ size_t File::GetSize(const PathName& path)
   return statbuf.st_size;
 }
 
+void File::Preallocate(FILE* file, size_t size)
+{
+#if defined(HAVE_FALLOCATE)
+  int fd = fileno(file);
+  if (fd >= 0 && size > 0)
+  {
+    // not posix_fallocate(): it falls back to writing zeros
+    fallocate(fd, 0, 0, size);
+  }
+#else
+  UNUSED_ALWAYS(file);
+  UNUSED_ALWAYS(size);
+#endif
+}
+
 void File::SetTimes(int fd, time_t creationTime, time_t lastAccessTime, time_t lastWriteTime)
 {
   UNUSED_ALWAYS(creationTime);
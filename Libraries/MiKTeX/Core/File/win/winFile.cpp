@@ -275,6 +275,17 @@ MIKTEXINTERNALFUNC(void) SetTimesInternal(HANDLE handle, time_t creationTime, ti
 #define GET_OSFHANDLE(hf) \
   reinterpret_cast<HANDLE>(_get_osfhandle(static_cast<int>(hf)))
 
+void File::Preallocate(FILE* file, size_t size)
+{
+  HANDLE h = GET_OSFHANDLE(_fileno(file));
+  if (h != INVALID_HANDLE_VALUE && size > 0)
+  {
+    FILE_ALLOCATION_INFO allocationInfo;
+    allocationInfo.AllocationSize.QuadPart = size;
+    SetFileInformationByHandle(h, FileAllocationInfo, &allocationInfo, sizeof(allocationInfo));
+  }
+}
+
 void File::SetTimes(int fd, time_t creationTime, time_t lastAccessTime, time_t lastWriteTime)
 {
   SetTimesInternal(GET_OSFHANDLE(fd), creationTime, lastAccessTime, lastWriteTime);
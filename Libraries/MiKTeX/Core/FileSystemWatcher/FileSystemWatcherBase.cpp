@@ -21,6 +21,7 @@
 
 #include "config.h"
 
+#include <algorithm>
 #include <vector>
 
 #include <miktex/Core/AutoResource>
@@ -121,12 +122,27 @@ void FileSystemWatcherBase::NotifySubscribers()
     vector<FileSystemChangeEvent> notifications;
     std::swap(notifications, pendingNotifications);
     l.unlock();
-    for (const auto &ev : notifications)
+    Notify(notifications);
+  }
+}
+
+void FileSystemWatcherBase::Notify(const vector<FileSystemChangeEvent>& notifications)
+{
+  // coalesce: a burst of changes to the same file is reported once
+  vector<FileSystemChangeEvent> coalesced;
+  for (const auto& ev : notifications)
+  {
+    if (find_if(coalesced.begin(), coalesced.end(), [&ev](const FileSystemChangeEvent& other) { return other.action == ev.action && other.fileName == ev.fileName; }) == coalesced.end())
+    {
+      coalesced.push_back(ev);
+    }
+  }
+  shared_lock<shared_mutex> l(mutex);
+  for (const auto& ev : coalesced)
+  {
+    for (auto& c : callbacks)
     {
-      for (auto &c : callbacks)
-      {
-        c->OnChange(ev);
-      }
+      c->OnChange(ev);
     }
   }
 }
@@ -27,6 +27,7 @@
 #include <thread>
 #include <set>
 #include <shared_mutex>
+#include <vector>
 
 #include <miktex/Core/FileSystemWatcher>
 #include <miktex/Trace/Trace>
@@ -46,6 +47,9 @@ public:
 private:
   void NotifySubscribers();
 
+protected:
+  void Notify(const std::vector<MiKTeX::Core::FileSystemChangeEvent>& notifications);
+
 protected:
   void NotifyThreadFunction();
 
@@ -15,6 +15,7 @@
 
 #include <unistd.h>
 #include <sys/inotify.h>
+#include <sys/select.h>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -26,84 +27,157 @@
 using namespace std;
 
 using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
 
+// only changes of directory contents; IN_ALL_EVENTS would wake up the
+// watcher thread on every file access
+constexpr uint32_t WATCH_MASK = IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE;
+
 unique_ptr<FileSystemWatcher> FileSystemWatcher::Create()
 {
     return make_unique<unxFileSystemWatcher>();
 }
 
-unxFileSystemWatcher::unxFileSystemWatcher()
-{
-    watchFd = inotify_init();
-    if (watchFd < 0)
-    {
-        MIKTEX_FATAL_CRT_ERROR("inotify_init");
-    }
-}
-
 unxFileSystemWatcher::~unxFileSystemWatcher()
 {
     try
     {
         Stop();
-        if (close(watchFd) < 0)
-        {
-            MIKTEX_FATAL_CRT_ERROR("close");
-        }
     }
     catch (const exception&)
     {
     }
+    InotifyMultiplexer::GetInstance().RemoveWatcher(this);
 }
 
 void unxFileSystemWatcher::AddDirectories(const vector<PathName>& directories)
 {
-    unique_lock<shared_mutex> l(mutex);
     for (const auto& dir : directories)
     {
-        int wd = inotify_add_watch(watchFd, dir.GetData(), IN_ALL_EVENTS);
-        if (wd < 0)
-        {
-            MIKTEX_FATAL_CRT_ERROR_2("inotify_add_Watch", "path", dir.ToString());
-        }
-        if (this->directories.find(wd) != this->directories.end())
-        {
-            continue;
-        }
-        trace_files->WriteLine("core", fmt::format("watching directory: {0}", Q_(dir.ToDisplayString())));
-        this->directories[wd] = dir;
+        InotifyMultiplexer::GetInstance().AddDirectory(this, dir);
     }
 }
 
 bool unxFileSystemWatcher::Start()
 {
     bool runningExpected = false;
-    if (!running.compare_exchange_strong(runningExpected, true))
+    return running.compare_exchange_strong(runningExpected, true);
+}
+
+bool unxFileSystemWatcher::Stop()
+{
+    bool runningExpected = true;
+    if (!running.compare_exchange_strong(runningExpected, false))
     {
         return false;
     }
-    if (pipe(cancelEventPipe) != 0)
+    if (failure)
     {
-        MIKTEX_FATAL_CRT_ERROR("pipe");
+        throw threadMiKTeXException;
     }
-    StartThreads();
     return true;
 }
 
-bool unxFileSystemWatcher::Stop()
+void unxFileSystemWatcher::WatchDirectories()
 {
-    bool runningExpected = true;
-    if (!running.compare_exchange_strong(runningExpected, false))
+    // the directories are watched by the InotifyMultiplexer thread
+}
+
+void unxFileSystemWatcher::OnDirectoryChanges(const vector<FileSystemChangeEvent>& events)
+{
+    if (running)
     {
-        return false;
+        Notify(events);
+    }
+}
+
+void unxFileSystemWatcher::OnFailure(const MiKTeXException& e)
+{
+    threadMiKTeXException = e;
+    failure = true;
+}
+
+InotifyMultiplexer& InotifyMultiplexer::GetInstance()
+{
+    // never destroyed: watchers may outlive static destruction
+    static InotifyMultiplexer* instance = new InotifyMultiplexer();
+    return *instance;
+}
+
+void InotifyMultiplexer::AddDirectory(unxFileSystemWatcher* watcher, const PathName& dir)
+{
+    lock_guard<std::mutex> lifecycleLock(lifecycleMutex);
+    if (watchFd < 0)
+    {
+        watchFd = inotify_init1(IN_CLOEXEC);
+        if (watchFd < 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR("inotify_init1");
+        }
+    }
+    int wd = inotify_add_watch(watchFd, dir.GetData(), WATCH_MASK);
+    if (wd < 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR_2("inotify_add_watch", "path", dir.ToString());
+    }
+    unique_lock<std::mutex> l(mutex);
+    Watch& watch = watches[wd];
+    if (watch.watchers.empty())
+    {
+        trace_files->WriteLine("core", fmt::format("watching directory: {0}", Q_(dir.ToDisplayString())));
+        watch.directory = dir;
+    }
+    watch.watchers.insert(watcher);
+    l.unlock();
+    if (!thread.joinable())
+    {
+        StartThread();
+    }
+}
+
+void InotifyMultiplexer::RemoveWatcher(unxFileSystemWatcher* watcher)
+{
+    lock_guard<std::mutex> lifecycleLock(lifecycleMutex);
+    unique_lock<std::mutex> l(mutex);
+    for (auto it = watches.begin(); it != watches.end(); )
+    {
+        it->second.watchers.erase(watcher);
+        if (it->second.watchers.empty())
+        {
+            inotify_rm_watch(watchFd, it->first);
+            it = watches.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    bool idle = watches.empty();
+    l.unlock();
+    if (idle && thread.joinable())
+    {
+        StopThread();
     }
-    char buf[1];
+}
+
+void InotifyMultiplexer::StartThread()
+{
+    if (pipe(cancelEventPipe) != 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR("pipe");
+    }
+    thread = std::thread(&InotifyMultiplexer::ThreadFunction, this);
+}
+
+void InotifyMultiplexer::StopThread()
+{
+    char buf[1] = { 0 };
     if (write(cancelEventPipe[1], buf, 1) < 0)
     {
         MIKTEX_FATAL_CRT_ERROR("write");
     }
-    StopThreads();
+    thread.join();
     if (close(cancelEventPipe[0]) < 0)
     {
         MIKTEX_FATAL_CRT_ERROR("close");
@@ -112,10 +186,36 @@ bool unxFileSystemWatcher::Stop()
     {
         MIKTEX_FATAL_CRT_ERROR("close");
     }
-    return true;
 }
 
-void unxFileSystemWatcher::WatchDirectories()
+void InotifyMultiplexer::ThreadFunction()
+{
+    MiKTeXException failure;
+    try
+    {
+        WatchDirectories();
+        return;
+    }
+    catch (const MiKTeXException& e)
+    {
+        failure = e;
+    }
+    catch (const std::exception& e)
+    {
+        failure = MiKTeXException(e.what());
+    }
+    trace_error->WriteLine("core", TraceLevel::Error, fmt::format("file system watcher failure: {0}", failure.GetErrorMessage()));
+    lock_guard<std::mutex> l(mutex);
+    for (auto& watch : watches)
+    {
+        for (unxFileSystemWatcher* watcher : watch.second.watchers)
+        {
+            watcher->OnFailure(failure);
+        }
+    }
+}
+
+void InotifyMultiplexer::WatchDirectories()
 {
     vector<unsigned char> buffer;
     buffer.resize(4096);
@@ -136,42 +236,55 @@ void unxFileSystemWatcher::WatchDirectories()
         }
         if (select(maxFd + 1, &readfds, nullptr, nullptr, nullptr) < 0)
         {
+            if (errno == EINTR)
+            {
+                continue;
+            }
             MIKTEX_FATAL_CRT_ERROR("select");
         }
+        if (FD_ISSET(cancelEventPipe[0], &readfds))
+        {
+            return;
+        }
         if (FD_ISSET(watchFd, &readfds))
         {
             auto n = read(watchFd, &buffer[0], buffer.size());
             if (n < 0)
             {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
                 MIKTEX_FATAL_CRT_ERROR("read");
             }
+            unordered_map<unxFileSystemWatcher*, vector<FileSystemChangeEvent>> events;
+            lock_guard<std::mutex> l(mutex);
             for (size_t idx = 0; idx < n;)
             {
                 const struct inotify_event* evt = reinterpret_cast<const struct inotify_event*>(&buffer[idx]);
-                HandleDirectoryChange(evt);
+                HandleDirectoryChange(evt, events);
                 idx += sizeof(struct inotify_event) + evt->len;
             }
-            notifyCondition.notify_all();
-        }
-        if (FD_ISSET(cancelEventPipe[0], &readfds))
-        {
-            return;
+            for (const auto& e : events)
+            {
+                e.first->OnDirectoryChanges(e.second);
+            }
         }
     }
 }
 
-void unxFileSystemWatcher::HandleDirectoryChange(const inotify_event* evt)
+void InotifyMultiplexer::HandleDirectoryChange(const inotify_event* evt, unordered_map<unxFileSystemWatcher*, vector<FileSystemChangeEvent>>& events)
 {
     FileSystemChangeEvent ev;
-    if ((evt->mask & IN_CREATE) != 0)
+    if ((evt->mask & (IN_CREATE | IN_MOVED_TO)) != 0)
     {
         ev.action = FileSystemChangeAction::Added;
     }
-    else if ((evt->mask & IN_DELETE) != 0)
+    else if ((evt->mask & (IN_DELETE | IN_MOVED_FROM)) != 0)
     {
         ev.action = FileSystemChangeAction::Removed;
     }
-    else if ((evt->mask & IN_MODIFY) != 0)
+    else if ((evt->mask & IN_CLOSE_WRITE) != 0)
     {
         ev.action = FileSystemChangeAction::Modified;
     }
@@ -179,16 +292,15 @@ void unxFileSystemWatcher::HandleDirectoryChange(const inotify_event* evt)
     {
         return;
     }
-    unique_lock<shared_mutex> l(mutex);
-    const auto& it = directories.find(evt->wd);
-    if (it == directories.end())
+    const auto& it = watches.find(evt->wd);
+    if (it == watches.end())
     {
         return;
     }
-    PathName dir = it->second;
-    l.unlock();
-    ev.fileName = dir;
+    ev.fileName = it->second.directory;
     ev.fileName /= evt->name;
-    lock_guard<std::mutex> l2(notifyMutex);
-    pendingNotifications.push_back(ev);
+    for (unxFileSystemWatcher* watcher : it->second.watchers)
+    {
+        events[watcher].push_back(ev);
+    }
 }
@@ -15,7 +15,11 @@
 
 #include <sys/inotify.h>
 
+#include <mutex>
+#include <set>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "../FileSystemWatcherBase.h"
 
@@ -27,10 +31,12 @@ class unxFileSystemWatcher :
 
 public:
 
-    unxFileSystemWatcher();
-
     virtual MIKTEXTHISCALL ~unxFileSystemWatcher();
 
+    void OnDirectoryChanges(const std::vector<MiKTeX::Core::FileSystemChangeEvent>& events);
+
+    void OnFailure(const MiKTeX::Core::MiKTeXException& e);
+
 private:
 
     void MIKTEXTHISCALL AddDirectories(const std::vector<MiKTeX::Util::PathName>& directories) override;
@@ -40,12 +46,51 @@ private:
     bool MIKTEXTHISCALL Stop() override;
 
     void MIKTEXTHISCALL WatchDirectories() override;
+};
+
+/// Process-wide inotify instance: all watchers (i.e., all FNDBs and
+/// sessions) share one inotify file descriptor and one thread.
+class InotifyMultiplexer
+{
+
+public:
+
+    static InotifyMultiplexer& GetInstance();
+
+    void AddDirectory(unxFileSystemWatcher* watcher, const MiKTeX::Util::PathName& dir);
+
+    void RemoveWatcher(unxFileSystemWatcher* watcher);
+
+private:
+
+    struct Watch
+    {
+        MiKTeX::Util::PathName directory;
+        std::set<unxFileSystemWatcher*> watchers;
+    };
+
+    InotifyMultiplexer() = default;
+
+    void StartThread();
+
+    void StopThread();
+
+    void ThreadFunction();
+
+    void WatchDirectories();
 
-    void HandleDirectoryChange(const struct inotify_event* evt);
+    void HandleDirectoryChange(const struct inotify_event* evt, std::unordered_map<unxFileSystemWatcher*, std::vector<MiKTeX::Core::FileSystemChangeEvent>>& events);
 
     int cancelEventPipe[2];
-    std::unordered_map<int, MiKTeX::Util::PathName> directories;
-    int watchFd;
+    // serializes adding/removing watches, starting and stopping the thread
+    std::mutex lifecycleMutex;
+    // protects watches; held while events are dispatched
+    std::mutex mutex;
+    std::thread thread;
+    std::unordered_map<int, Watch> watches;
+    int watchFd = -1;
+    std::unique_ptr<MiKTeX::Trace::TraceStream> trace_error = MiKTeX::Trace::TraceStream::Open(MIKTEX_TRACE_ERROR);
+    std::unique_ptr<MiKTeX::Trace::TraceStream> trace_files = MiKTeX::Trace::TraceStream::Open(MIKTEX_TRACE_FILES);
 };
 
 CORE_INTERNAL_END_NAMESPACE;
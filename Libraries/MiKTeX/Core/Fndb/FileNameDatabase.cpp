@@ -63,6 +63,8 @@ void MIKTEXNORETURN ThrowFndbDamaged(const string& description, const MiKTeXExce
   Session::FatalMiKTeXError(T_("The file name database is damaged."), description, T_("Delete the file name database files. Then run 'initexmf -u' to recreate the FNDB."), "fndb-damaged", info, sourceLocation);
 }
 
+atomic_uint FileNameDatabase::generation(0);
+
 shared_ptr<FileNameDatabase> FileNameDatabase::Create(const PathName& fndbPath, const PathName& rootDirectory, shared_ptr<FileSystemWatcher> fsWatcher)
 {
   shared_ptr<FileNameDatabase> fndb = make_shared<FileNameDatabase>();
@@ -87,112 +89,110 @@ FileNameDatabase::~FileNameDatabase()
   }
 }
 
-// FIXME: not UTF-8 safe
-MIKTEXSTATICFUNC(bool) Match(const char* pathPattern, const char* path)
+bool FileNameDatabase::Search(const PathName& relativePath, const string& pathPattern, bool all, vector<Fndb::Record>& result)
 {
-  MIKTEX_ASSERT(PathName(pathPattern).IsComparable());
-  MIKTEX_ASSERT(PathName(path).IsComparable());
-  int lastch = 0;
-  for (; *pathPattern != 0 && *path != 0; ++pathPattern, ++path)
-  {
-    if (*pathPattern == *path)
-    {
-      lastch = *path;
-      continue;
-    }
-    MIKTEX_ASSERT(RECURSION_INDICATOR_LENGTH == 2);
-    MIKTEX_ASSERT(PathNameUtil::IsDirectoryDelimiter(RECURSION_INDICATOR[0]));
-    MIKTEX_ASSERT(PathNameUtil::IsDirectoryDelimiter(RECURSION_INDICATOR[1]));
-    if (*pathPattern == RECURSION_INDICATOR[1] && PathNameUtil::IsDirectoryDelimiter(lastch))
-    {
-      for (; PathNameUtil::IsDirectoryDelimiter(*pathPattern); ++pathPattern)
-      {
-      };
-      if (*pathPattern == 0)
-      {
-        return true;
-      }
-      for (; *path != 0; ++path)
-      {
-        if (PathNameUtil::IsDirectoryDelimiter(lastch))
-        {
-          // RECURSION
-          if (Match(pathPattern, path))
-          {
-            return true;
-          }
-        }
-        lastch = *path;
-      }
-    }
-    return false;
-  }
-  return (*pathPattern == 0 || strcmp(pathPattern, RECURSION_INDICATOR) == 0 || strcmp(pathPattern, "/") == 0) && *path == 0;
+  lock_guard<mutex> lockGuard(lookupMutex);
+  return Search_nolock(relativePath, pathPattern, all, result);
 }
 
-bool FileNameDatabase::Search(const PathName& relativePath, const string& pathPattern_, bool all, vector<Fndb::Record>& result)
+bool FileNameDatabase::Search_nolock(const PathName& relativePath, const string& pathPattern_, bool all, vector<Fndb::Record>& result)
 {
   string pathPattern = pathPattern_;
 
   ApplyChangeFile();
 
-  trace_fndb->WriteLine("core", fmt::format(T_("fndb search: rootDirectory={0}, relativePath={1}, pathPattern={2}"), Q_(rootDirectory), Q_(relativePath), Q_(pathPattern)));
+  MIKTEX_TRACE_WRITE_LINE(trace_fndb, "core", TraceLevel::Trace, fmt::format(T_("fndb search: rootDirectory={0}, relativePath={1}, pathPattern={2}"), Q_(rootDirectory), Q_(relativePath), Q_(pathPattern)));
 
   MIKTEX_ASSERT(result.size() == 0);
   MIKTEX_ASSERT(!PathNameUtil::IsAbsolutePath(relativePath.GetData()));
   MIKTEX_ASSERT(!IsExplicitlyRelativePath(relativePath.GetData()));
 
-  PathName dir = relativePath.GetDirectoryName();
-  PathName fileName = relativePath.GetFileName();
-
-  PathName scratch1;
+  // views into relativePath: no temporaries per candidate
+  PathNameView dir = relativePath.View().GetDirectoryName();
+  PathNameView fileName = relativePath.View().GetFileName();
 
   if (!dir.Empty())
   {
-    size_t l = dir.GetLength();
-    if (dir.EndsWithDirectoryDelimiter())
-    {
-      dir[l - 1] = 0;
-      --l;
-    }
-    scratch1 = pathPattern;
-    scratch1 /= dir;
+    PathName scratch1(pathPattern);
+    scratch1 /= dir.WithoutTrailingDirectoryDelimiter();
     pathPattern = scratch1.ToString();
   }
 
   // check to see whether we have this file name
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(fileName));
-  if (range.first == range.second)
+  const vector<Record>& bucket = GetBucket(MakeKey(fileName));
+  if (bucket.empty())
   {
     return false;
   }
 
-  // path pattern must be relative to root directory
-  if (PathName(pathPattern).IsAbsolute())
+  string comparablePathPattern = MakeComparablePathPattern(pathPattern);
+
+  for (const Record& record : bucket)
   {
-    const char* lpsz = Utils::GetRelativizedPath(pathPattern.c_str(), rootDirectory.GetData());
-    if (lpsz == nullptr)
+    const DirectoryInfo& relativeDirectory = directories[record.GetDirectoryId()];
+    if (PathPattern::Match(comparablePathPattern.c_str(), relativeDirectory.comparablePath.c_str()))
     {
-      MIKTEX_FATAL_ERROR_2(T_("Path pattern is not covered by file name database."), "pattern", pathPattern);
+      PathName path(rootDirectory);
+      path /= relativeDirectory.path;
+      path /= fileName;
+      MIKTEX_TRACE_WRITE_LINE(trace_fndb, "core", TraceLevel::Trace, fmt::format(T_("found: {0} ({1})"), Q_(path), Q_(record.GetInfo())));
+      result.push_back({ path, record.GetInfo() });
+      if (!all)
+      {
+        break;
+      }
     }
-    pathPattern = lpsz;
   }
 
-  PathName comparablePathPattern(pathPattern);
-  comparablePathPattern.TransformForComparison();
+  return !result.empty();
+}
 
-  for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
+bool FileNameDatabase::Search(const PathName& relativePath, const PathPattern& pathPattern, bool all, vector<Fndb::Record>& result)
+{
+  lock_guard<mutex> lockGuard(lookupMutex);
+
+  if (!relativePath.View().GetDirectoryName().Empty())
   {
-    PathName relativeDirectory;
-    relativeDirectory = it->second.GetDirectory();
-    if (Match(comparablePathPattern.GetData(), PathName(relativeDirectory).TransformForComparison().GetData()))
+    // the effective path pattern depends on the directory part
+    return Search_nolock(relativePath, pathPattern.ToString(), all, result);
+  }
+
+  ApplyChangeFile();
+
+  MIKTEX_TRACE_WRITE_LINE(trace_fndb, "core", TraceLevel::Trace, fmt::format(T_("fndb search: rootDirectory={0}, relativePath={1}, pathPattern={2}"), Q_(rootDirectory), Q_(relativePath), Q_(pathPattern.ToString())));
+
+  MIKTEX_ASSERT(result.size() == 0);
+  MIKTEX_ASSERT(!PathNameUtil::IsAbsolutePath(relativePath.GetData()));
+  MIKTEX_ASSERT(!IsExplicitlyRelativePath(relativePath.GetData()));
+
+  // check to see whether we have this file name
+  const vector<Record>& bucket = GetBucket(MakeKey(relativePath));
+  if (bucket.empty())
+  {
+    return false;
+  }
+
+  PatternMatches& patternMatches = GetPatternMatches(pathPattern);
+
+  for (const Record& record : bucket)
+  {
+    DirectoryId directoryId = record.GetDirectoryId();
+    if (directoryId >= patternMatches.directoryMatches.size())
     {
-      PathName path;
-      path = rootDirectory;
-      path /= relativeDirectory;
-      path /= fileName;
-      trace_fndb->WriteLine("core", fmt::format(T_("found: {0} ({1})"), Q_(path), Q_(it->second.GetInfo())));
-      result.push_back({ path, it->second.GetInfo() });
+      patternMatches.directoryMatches.resize(directories.size(), MatchState::Unknown);
+    }
+    MatchState& matchState = patternMatches.directoryMatches[directoryId];
+    if (matchState == MatchState::Unknown)
+    {
+      matchState = PathPattern::Match(patternMatches.comparablePathPattern.c_str(), directories[directoryId].comparablePath.c_str()) ? MatchState::Match : MatchState::NoMatch;
+    }
+    if (matchState == MatchState::Match)
+    {
+      PathName path(rootDirectory);
+      path /= directories[directoryId].path;
+      path /= relativePath;
+      MIKTEX_TRACE_WRITE_LINE(trace_fndb, "core", TraceLevel::Trace, fmt::format(T_("found: {0} ({1})"), Q_(path), Q_(record.GetInfo())));
+      result.push_back({ path, record.GetInfo() });
       if (!all)
       {
         break;
@@ -203,20 +203,64 @@ bool FileNameDatabase::Search(const PathName& relativePath, const string& pathPa
   return !result.empty();
 }
 
+string FileNameDatabase::MakeComparablePathPattern(const string& pathPattern) const
+{
+  // path pattern must be relative to root directory
+  PathName comparablePathPattern(pathPattern);
+  if (comparablePathPattern.IsAbsolute())
+  {
+    const char* lpsz = Utils::GetRelativizedPath(pathPattern.c_str(), rootDirectory.GetData());
+    if (lpsz == nullptr)
+    {
+      MIKTEX_FATAL_ERROR_2(T_("Path pattern is not covered by file name database."), "pattern", pathPattern);
+    }
+    comparablePathPattern = lpsz;
+  }
+  comparablePathPattern.TransformForComparison();
+  return comparablePathPattern.ToString();
+}
+
+FileNameDatabase::PatternMatches& FileNameDatabase::GetPatternMatches(const PathPattern& pathPattern)
+{
+  unordered_map<unsigned, PatternMatches>::iterator it = patternMatches.find(pathPattern.GetId());
+  if (it != patternMatches.end())
+  {
+    return it->second;
+  }
+  PatternMatches& result = patternMatches[pathPattern.GetId()];
+  result.comparablePathPattern = MakeComparablePathPattern(pathPattern.ToString());
+  return result;
+}
+
+void FileNameDatabase::AppendChangeRecord(FILE* file, FndbWord op, const string& fileName, const string& directory, const string& info)
+{
+  FileNameDatabaseChangeRecord rec;
+  rec.op = op;
+  rec.fileNameLength = static_cast<FndbWord>(fileName.length());
+  rec.directoryLength = static_cast<FndbWord>(directory.length());
+  rec.infoLength = static_cast<FndbWord>(info.length());
+  string payload = fileName + directory + info;
+  rec.checksum = FndbHash(payload.data(), payload.length());
+  if (fwrite(&rec, sizeof(rec), 1, file) != 1 || fwrite(payload.data(), 1, payload.length(), file) != payload.length())
+  {
+    MIKTEX_FATAL_CRT_ERROR_2("fwrite", "path", changeFile.ToString());
+  }
+  changeFileRecordCount++;
+  changeFileSize += sizeof(rec) + payload.length();
+}
+
 void FileNameDatabase::Add(const vector<Fndb::Record>& records)
 {
+  lock_guard<mutex> lockGuard(lookupMutex);
   FileStream writer(OpenChangeFileExclusively());
   for (const auto& rec : records)
   {
     string fileName;
     string directory;
     std::tie(fileName, directory) = SplitPath(rec.path);
-    if (InsertRecord(Record(fileName, directory, rec.fileNameInfo)))
+    if (InsertRecord(Record(fileName, InternDirectory(directory), rec.fileNameInfo)))
     {
-      string s = fmt::format("+{0}{1}{2}{1}{3}\n", fileName, char(PathNameUtil::PathNameDelimiter), directory, rec.fileNameInfo);
-      fputs(s.c_str(), writer.GetFile());
-      changeFileRecordCount++;
-      changeFileSize += s.length();
+      AppendChangeRecord(writer.GetFile(), FileNameDatabaseChangeRecord::Add, fileName, directory, rec.fileNameInfo);
     }
   }
   fflush(writer.GetFile());
@@ -237,21 +281,20 @@ void FileNameDatabase::Add(const vector<Fndb::Record>& records)
   File::Unlock(writer.GetFile());
   writer.Close();
   changeFileModified = true;
+  ++generation;
 }
 
 void FileNameDatabase::Remove(const vector<PathName>& paths)
 {
+  lock_guard<mutex> lockGuard(lookupMutex);
   FileStream writer(OpenChangeFileExclusively());
   for (const auto& path : paths)
   {
     string fileName;
     string directory;
     std::tie(fileName, directory) = SplitPath(path);
-    EraseRecord(Record(fileName, directory, ""));
-    string s = fmt::format("-{}{}{}\n", fileName, char(PathNameUtil::PathNameDelimiter), directory);
-    fputs(s.c_str(), writer.GetFile());
-    changeFileRecordCount++;
-    changeFileSize += s.length();
+    EraseRecord(Record(fileName, InternDirectory(directory), ""));
+    AppendChangeRecord(writer.GetFile(), FileNameDatabaseChangeRecord::Remove, fileName, directory, "");
   }
   fflush(writer.GetFile());
 #if 1
@@ -271,18 +314,26 @@ void FileNameDatabase::Remove(const vector<PathName>& paths)
   File::Unlock(writer.GetFile());
   writer.Close();
   changeFileModified = true;
+  ++generation;
 }
 
 bool FileNameDatabase::FileExists(const PathName& path)
 {
+  lock_guard<mutex> lockGuard(lookupMutex);
   ApplyChangeFile();
   string fileName;
   string directory;
   std::tie(fileName, directory) = SplitPath(path);
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(fileName));
-  for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
+  // materialize the bucket first: this interns the directories of the candidates
+  const vector<Record>& bucket = GetBucket(MakeKey(fileName));
+  DirectoryId directoryId;
+  if (!FindDirectory(directory, directoryId))
   {
-    if (PathName::Compare(it->second.GetDirectory(), directory) == 0)
+    return false;
+  }
+  for (const Record& record : bucket)
+  {
+    if (record.GetDirectoryId() == directoryId)
     {
       return true;
     }
@@ -317,76 +368,139 @@ tuple<string, string> FileNameDatabase::SplitPath(const PathName& path_) const
 
 void FileNameDatabase::FastInsertRecord(FileNameDatabase::Record&& record)
 {
-  fileNames.insert(pair<string, Record>(MakeKey(record.fileName), std::move(record)));
+  GetBucket(MakeKey(record.GetFileName())).push_back(std::move(record));
 }
 
 bool FileNameDatabase::InsertRecord(FileNameDatabase::Record&& record)
 {
-  string key = MakeKey(record.fileName);
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(key);
-  for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
+  vector<Record>& bucket = GetBucket(MakeKey(record.GetFileName()));
+  for (const Record& existing : bucket)
   {
-    if (PathName::Compare(it->second.GetDirectory(), record.GetDirectory()) == 0)
+    if (existing.GetDirectoryId() == record.GetDirectoryId())
     {
       return false;
     }
   }
-  fileNames.insert(pair<string, Record>(std::move(key), std::move(record)));
+  bucket.push_back(std::move(record));
   return true;
 }
 
-string FileNameDatabase::MakeKey(const string& fileName) const
+string FileNameDatabase::MakeKey(const PathName& fileName) const
 {
-  return MakeKey(PathName(fileName));
+  return MakeKey(fileName.View());
 }
 
-string FileNameDatabase::MakeKey(const PathName& fileName) const
+string FileNameDatabase::MakeKey(const PathNameView& fileName) const
 {
-  PathName key = fileName;
+#if defined(MIKTEX_WINDOWS)
+  PathName key(fileName);
   key.TransformForComparison();
   return key.ToString();
+#else
+  // file names are compared as they are
+  return fileName.ToString();
+#endif
 }
 
 void FileNameDatabase::EraseRecord(const FileNameDatabase::Record& record)
 {
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(record.fileName));
-  if (range.first == range.second)
+  vector<Record>& bucket = GetBucket(MakeKey(record.GetFileName()));
+  auto toBeRemoved = std::remove_if(bucket.begin(), bucket.end(), [&record](const Record& r) { return r.GetDirectoryId() == record.GetDirectoryId(); });
+  if (toBeRemoved == bucket.end())
   {
-    FNDB_DAMAGED_2(T_("The file name record could not be found in the database."), "fileName", record.fileName);
+    FNDB_DAMAGED_2(T_("The file name record could not be found in the database."), "fileName", record.GetFileName(), "directory", directories[record.GetDirectoryId()].path);
   }
-  vector<FileNameHashTable::const_iterator> toBeRemoved;
-  for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
+  bucket.erase(toBeRemoved, bucket.end());
+}
+
+vector<FileNameDatabase::Record>& FileNameDatabase::GetBucket(const string& key)
+{
+  FileNameHashTable::iterator it = fileNames.find(key);
+  if (it != fileNames.end())
   {
-    if (PathName::Compare(it->second.GetDirectory(), record.GetDirectory()) == 0)
-    {
-      toBeRemoved.push_back(it);
-    }
+    return it->second;
   }
-  if (toBeRemoved.empty())
+  // materialize the mapped records having this file name
+  vector<Record>& bucket = fileNames[key];
+  FndbWord first;
+  FndbWord last;
+  std::tie(first, last) = FindMappedRecords(key);
+  const FileNameDatabaseRecord* table = GetTable();
+  bucket.reserve(last - first);
+  for (FndbWord idx = first; idx < last; ++idx)
   {
-    FNDB_DAMAGED_2(T_("The file name record could not be found in the database."), "fileName", record.fileName, "directory", record.GetDirectory());
+    bucket.push_back(Record(this, table[idx].foFileName, InternDirectory(table[idx].foDirectory), table[idx].foInfo));
   }
-  for (const auto& it : toBeRemoved)
+  return bucket;
+}
+
+FileNameDatabase::DirectoryId FileNameDatabase::InternDirectory(FndbByteOffset foDirectory)
+{
+  unordered_map<FndbByteOffset, DirectoryId>::const_iterator it = mappedDirectoryIds.find(foDirectory);
+  if (it != mappedDirectoryIds.end())
   {
-    fileNames.erase(it);
+    return it->second;
   }
+  DirectoryId directoryId = InternDirectory(string(GetString(foDirectory)));
+  mappedDirectoryIds[foDirectory] = directoryId;
+  return directoryId;
 }
 
-void FileNameDatabase::ReadFileNames()
+FileNameDatabase::DirectoryId FileNameDatabase::InternDirectory(const string& directory)
 {
-  fileNames.clear();
-  fileNames.rehash(fndbHeader->numFiles);
-  CoreStopWatch stopWatch(fmt::format("fndb read file names {}", Q_(rootDirectory)));
-  ReadFileNames(GetTable());
+  string comparablePath = PathName(directory).TransformForComparison().ToString();
+  unordered_map<string, DirectoryId>::const_iterator it = directoryIds.find(comparablePath);
+  if (it != directoryIds.end())
+  {
+    return it->second;
+  }
+  DirectoryId directoryId = static_cast<DirectoryId>(directories.size());
+  directories.push_back({ directory, comparablePath });
+  directoryIds[std::move(comparablePath)] = directoryId;
+  return directoryId;
 }
 
-void FileNameDatabase::ReadFileNames(const FileNameDatabaseRecord* table)
+bool FileNameDatabase::FindDirectory(const string& directory, DirectoryId& directoryId) const
 {
-  for (size_t idx = 0; idx < fndbHeader->numFiles; ++idx)
+  unordered_map<string, DirectoryId>::const_iterator it = directoryIds.find(PathName(directory).TransformForComparison().ToString());
+  if (it == directoryIds.end())
   {
-    const FileNameDatabaseRecord* rec = &table[idx];
-    FastInsertRecord(Record(this, GetString(rec->foFileName), rec->foDirectory, rec->foInfo));
+    return false;
+  }
+  directoryId = it->second;
+  return true;
+}
+
+pair<FndbWord, FndbWord> FileNameDatabase::FindMappedRecords(const string& key) const
+{
+  const FileNameDatabaseHashSlot* slots = GetHashTable();
+  const FileNameDatabaseRecord* table = GetTable();
+  FndbWord mask = fndbHeader->hashTableSize - 1;
+  FndbWord hash = FndbHash(key.c_str());
+  FndbWord slotIdx = hash & mask;
+  for (FndbWord probe = 0; probe <= mask && slots[slotIdx].firstRecord != 0; ++probe, slotIdx = (slotIdx + 1) & mask)
+  {
+    if (slots[slotIdx].hash != hash)
+    {
+      continue;
+    }
+    FndbWord first = slots[slotIdx].firstRecord - 1;
+    if (first >= fndbHeader->numFiles)
+    {
+      FNDB_DAMAGED_2(T_("Invalid hash table slot."), "rootDirectory", rootDirectory.ToString());
+    }
+    if (PathName::Compare(GetString(table[first].foFileName), key.c_str()) != 0)
+    {
+      continue;
+    }
+    FndbWord last = first + 1;
+    while (last < fndbHeader->numFiles && PathName::Compare(GetString(table[last].foFileName), key.c_str()) == 0)
+    {
+      ++last;
+    }
+    return make_pair(first, last);
   }
+  return make_pair(0, 0);
 }
 
 void FileNameDatabase::Finalize()
@@ -401,6 +515,7 @@ void FileNameDatabase::Finalize()
     trace_fndb->WriteLine("core", fmt::format(T_("unloading fndb {0}"), Q_(this->rootDirectory)));
   }
   CloseFileNameDatabase();
+  ++generation;
   if (trace_fndb != nullptr)
   {
     trace_fndb->Close();
@@ -413,11 +528,14 @@ void FileNameDatabase::Initialize(const PathName& fndbPath, const PathName& root
   this->rootDirectory = rootDirectory;
 
   this->fsWatcher = fsWatcher;
-  fsWatcher->Subscribe(this);
-  fsWatcher->AddDirectories({fndbPath.GetDirectoryName()});
+  if (fsWatcher != nullptr)
+  {
+    fsWatcher->Subscribe(this);
+    fsWatcher->AddDirectories({fndbPath.GetDirectoryName()});
+  }
 
   OpenFileNameDatabase(fndbPath);
-  ReadFileNames();
+  ++generation;
 
   changeFile = fndbPath;
   changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
@@ -431,12 +549,19 @@ void FileNameDatabase::OnChange(const MiKTeX::Core::FileSystemChangeEvent& ev)
   if (ev.fileName == changeFile && ev.action == FileSystemChangeAction::Modified)
   {
     changeFileModified = true;
+    ++generation;
   }
 }
 
 void FileNameDatabase::ApplyChangeFile()
 {
-  lastAccessTime = chrono::high_resolution_clock::now();
+  chrono::time_point<chrono::high_resolution_clock> now = chrono::high_resolution_clock::now();
+  lastAccessTime = now;
+  if (fsWatcher == nullptr && now - lastChangeFilePoll >= CHANGE_FILE_POLL_INTERVAL)
+  {
+    lastChangeFilePoll = now;
+    changeFileModified = true;
+  }
   if (!changeFileModified)
   {
     return;
@@ -451,51 +576,80 @@ void FileNameDatabase::ApplyChangeFile()
   {
     return;
   }
-  MIKTEX_ASSERT(newChangeFileSize > changeFileSize);
-  CoreStopWatch stopWatch(fmt::format(T_("applying FNDB change file {0} starting at record #{1}"), Q_(changeFile), changeFileRecordCount));
+  if (newChangeFileSize < changeFileSize)
+  {
+    // the change file has been recreated
+    changeFileSize = 0;
+  }
+  CoreStopWatch stopWatch(CoreTimer::ApplyFndbChangeFile, [&]() { return fmt::format(T_("applying FNDB change file {0} starting at record #{1}"), Q_(changeFile), changeFileRecordCount); });
   FileStream reader(File::Open(changeFile, FileMode::Open, FileAccess::Read, false));
   if (!File::TryLock(reader.GetFile(), File::LockType::Shared, 2s))
   {
     MIKTEX_FATAL_ERROR_2(T_("Could not acquire shared lock."), "path", changeFile.ToString());
   }
-  if (changeFileSize > 0)
+  if (changeFileSize == 0)
+  {
+    FileNameDatabaseChangeFileHeader header;
+    if (reader.Read(&header, sizeof(header)) != sizeof(header)
+      || header.signature != FileNameDatabaseChangeFileHeader::Signature
+      || header.version != FileNameDatabaseChangeFileHeader::Version)
+    {
+      FNDB_DAMAGED_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
+    }
+    changeFileSize = sizeof(header);
+    if (header.fndbCreationTime != fndbHeader->creationTime)
+    {
+      // the log belongs to a newer FNDB, i.e., the FNDB has been
+      // rebuilt since we mapped it
+      trace_fndb->WriteLine("core", fmt::format(T_("ignoring FNDB change file {0}: the FNDB has been rebuilt"), Q_(changeFile)));
+      changeFileSize = newChangeFileSize;
+      File::Unlock(reader.GetFile());
+      reader.Close();
+      return;
+    }
+  }
+  else
   {
     reader.Seek(static_cast<long>(changeFileSize), SeekOrigin::Begin);
   }
-  for (string line; Utils::ReadLine(line, reader.GetFile(), false); )
+  int oldChangeFileRecordCount = changeFileRecordCount;
+  FileNameDatabaseChangeRecord rec;
+  string payload;
+  for (size_t n; (n = reader.Read(&rec, sizeof(rec))) > 0; )
   {
-    if (line.empty())
+    size_t payloadLength = static_cast<size_t>(rec.fileNameLength) + rec.directoryLength + rec.infoLength;
+    if (n != sizeof(rec) || changeFileSize + sizeof(rec) + payloadLength > newChangeFileSize)
     {
       FNDB_DAMAGED_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
     }
-    changeFileRecordCount++;
-    changeFileSize += line.length() + sizeof('\n');
-    string op = line.substr(0, 1);
-    vector<string> data = StringUtil::Split(line.substr(1), PathNameUtil::PathNameDelimiter);
-    if (data.size() < 2)
+    payload.resize(payloadLength);
+    if ((payloadLength > 0 && reader.Read(&payload[0], payloadLength) != payloadLength)
+      || FndbHash(payload.data(), payloadLength) != rec.checksum)
     {
       FNDB_DAMAGED_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
     }
-    string& fileName = data[0];
-    string& directory = data[1];
-    if (op == "+")
+    changeFileRecordCount++;
+    changeFileSize += sizeof(rec) + payloadLength;
+    string fileName = payload.substr(0, rec.fileNameLength);
+    string directory = payload.substr(rec.fileNameLength, rec.directoryLength);
+    if (rec.op == FileNameDatabaseChangeRecord::Add)
     {
-      if (data.size() < 3)
-      {
-        FNDB_DAMAGED_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
-      }
-      string& fileNameInfo = data[2];
-      FastInsertRecord(Record(std::move(fileName), std::move(directory), std::move(fileNameInfo)));
+      FastInsertRecord(Record(std::move(fileName), InternDirectory(directory), payload.substr(rec.fileNameLength + rec.directoryLength, rec.infoLength)));
     }
-    else if (op == "-")
+    else if (rec.op == FileNameDatabaseChangeRecord::Remove)
     {
-      EraseRecord(Record(std::move(fileName), std::move(directory), ""));
+      EraseRecord(Record(std::move(fileName), InternDirectory(directory), ""));
     }
     else
     {
       FNDB_DAMAGED_2(T_("FNDB change file has been tampered with."), "path", changeFile.ToString());
     }
   }
+  if (fsWatcher == nullptr && changeFileRecordCount != oldChangeFileRecordCount)
+  {
+    // there was no notification
+    ++generation;
+  }
   File::Unlock(reader.GetFile());
   reader.Close();
 }
@@ -508,6 +662,15 @@ FILE* FileNameDatabase::OpenChangeFileExclusively()
   {
     MIKTEX_FATAL_ERROR_2(T_("Could not acquire exclusive lock."), "path", changeFile.ToString());
   }
+  if (File::GetSize(changeFile) == 0)
+  {
+    FileNameDatabaseChangeFileHeader header;
+    header.signature = FileNameDatabaseChangeFileHeader::Signature;
+    header.version = FileNameDatabaseChangeFileHeader::Version;
+    header.fndbCreationTime = fndbHeader->creationTime;
+    writer.Write(&header, sizeof(header));
+    changeFileSize = sizeof(header);
+  }
   return writer.Detach();
 }
 
@@ -515,6 +678,10 @@ void FileNameDatabase::OpenFileNameDatabase(const PathName& fndbPath)
 {
   mmap->Open(fndbPath, false);
 
+  // look-ups touch a few pages of the hash table and the string pool:
+  // read-ahead would be wasted
+  mmap->Advise(MemoryMappedFileAccessPattern::Random);
+
   if (mmap->GetSize() < sizeof(*fndbHeader))
   {
     FNDB_DAMAGED_2(T_("Not a file name database file (wrong size)."), "path", fndbPath.ToString());
@@ -535,6 +702,16 @@ void FileNameDatabase::OpenFileNameDatabase(const PathName& fndbPath)
   {
     FNDB_DAMAGED_2(T_("Unknown file name database file version."), "path", fndbPath.ToString(), "versionFound", std::to_string(fndbHeader->Version), "versionExpected", std::to_string(FileNameDatabaseHeader::Version));
   }
+
+  // check hash table
+  FndbWord hashTableSize = fndbHeader->hashTableSize;
+  if (hashTableSize == 0
+    || (hashTableSize & (hashTableSize - 1)) != 0
+    || fndbHeader->foHashTable < sizeof(*fndbHeader)
+    || fndbHeader->foHashTable + static_cast<uint64_t>(hashTableSize) * sizeof(FileNameDatabaseHashSlot) > foEnd)
+  {
+    FNDB_DAMAGED_2(T_("Invalid hash table."), "path", fndbPath.ToString());
+  }
 }
 
 void FileNameDatabase::CloseFileNameDatabase()
@@ -26,7 +26,10 @@
 
 #include <atomic>
 #include <chrono>
+#include <mutex>
 #include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include <miktex/Core/Debug>
 #include <miktex/Core/DirectoryLister>
@@ -34,7 +37,9 @@
 #include <miktex/Core/Fndb>
 #include <miktex/Core/MemoryMappedFile>
 #include <miktex/Util/PathName>
+#include <miktex/Util/PathNameView>
 
+#include "PathPattern.h"
 #include "fndbmem.h"
 
 CORE_INTERNAL_BEGIN_NAMESPACE;
@@ -60,6 +65,14 @@ public:
 public:
   bool Search(const MiKTeX::Util::PathName& relativePath, const std::string& pathPattern, bool all, std::vector<MiKTeX::Core::Fndb::Record>& result);
 
+private:
+  bool Search_nolock(const MiKTeX::Util::PathName& relativePath, const std::string& pathPattern, bool all, std::vector<MiKTeX::Core::Fndb::Record>& result);
+
+  /// Searches the database; per-directory match results are memoized
+  /// for the given compiled path pattern.
+public:
+  bool Search(const MiKTeX::Util::PathName& relativePath, const PathPattern& pathPattern, bool all, std::vector<MiKTeX::Core::Fndb::Record>& result);
+
 public:
   void Add(const std::vector<MiKTeX::Core::Fndb::Record>& records);
 
@@ -75,46 +88,74 @@ public:
     return lastAccessTime;
   }
 
+  /// Gets the number of change records applied to the mapped FNDB.
+public:
+  int GetChangeFileRecordCount() const
+  {
+    return changeFileRecordCount;
+  }
+
+  /// The number of change records which triggers the compaction of
+  /// the change file (see Fndb::Add()).
+public:
+  static constexpr int MAX_CHANGE_FILE_RECORDS = 1000;
+
+  /// Gets the process-wide FNDB generation.  The generation changes
+  /// whenever a file name database is loaded, unloaded or modified.
+public:
+  static unsigned GetGeneration()
+  {
+    return generation;
+  }
+
+private:
+  typedef std::uint32_t DirectoryId;
+
 private:
   struct Record
   {
   public:
-    Record(const FileNameDatabase* fndb, std::string&& fileName, FndbByteOffset foDirectory, FndbByteOffset foInfo) :
+    Record(const FileNameDatabase* fndb, FndbByteOffset foFileName, DirectoryId directoryId, FndbByteOffset foInfo) :
       fndb(fndb),
-      fileName(std::move(fileName)),
-      foDirectory(foDirectory),
+      foFileName(foFileName),
+      directoryId(directoryId),
       foInfo(foInfo)
     {
     }
   public:
-    Record(const std::string& fileName, const std::string& directory, const std::string& info) :
+    Record(const std::string& fileName, DirectoryId directoryId, const std::string& info) :
       fileName(fileName),
-      directory(directory),
+      directoryId(directoryId),
       info(info)
     {
     }
   public:
-    Record(std::string&& fileName, std::string&& directory, std::string&& info) :
+    Record(std::string&& fileName, DirectoryId directoryId, std::string&& info) :
       fileName(std::move(fileName)),
-      directory(std::move(directory)),
+      directoryId(directoryId),
       info(std::move(info))
     {
     }
   public:
-    std::string GetDirectory() const
+    const char* GetFileName() const
     {
-      if (foDirectory != 0)
+      if (foFileName != 0)
       {
         MIKTEX_ASSERT(fndb != nullptr);
-        return fndb->GetString(foDirectory);
+        return fndb->GetString(foFileName);
       }
       else
       {
-        return directory;
+        return fileName.c_str();
       }
     }
   public:
-    std::string GetInfo() const
+    DirectoryId GetDirectoryId() const
+    {
+      return directoryId;
+    }
+  public:
+    const char* GetInfo() const
     {
       if (foInfo != 0)
       {
@@ -123,17 +164,17 @@ private:
       }
       else
       {
-        return info;
+        return info.c_str();
       }
     }
   private:
     const FileNameDatabase* fndb = nullptr;
-  public:
-    std::string fileName;
   private:
-    FndbByteOffset foDirectory = 0;
+    FndbByteOffset foFileName = 0;
   private:
-    std::string directory;
+    std::string fileName;
+  private:
+    DirectoryId directoryId = 0;
   private:
     FndbByteOffset foInfo = 0;
   private:
@@ -141,14 +182,55 @@ private:
   };
 
 private:
-  std::tuple<std::string, std::string> SplitPath(const MiKTeX::Util::PathName& path) const;
+  struct DirectoryInfo
+  {
+    // relative directory path (Unix-style)
+    std::string path;
+    // comparable form of path
+    std::string comparablePath;
+  };
 
 private:
-  std::string MakeKey(const std::string& fileName) const;
+  enum class MatchState : std::uint8_t
+  {
+    Unknown,
+    Match,
+    NoMatch
+  };
+
+private:
+  struct PatternMatches
+  {
+    // path pattern relative to the root directory; comparable form
+    std::string comparablePathPattern;
+    // indexed by DirectoryId
+    std::vector<MatchState> directoryMatches;
+  };
+
+private:
+  std::string MakeComparablePathPattern(const std::string& pathPattern) const;
+
+private:
+  PatternMatches& GetPatternMatches(const PathPattern& pathPattern);
+
+private:
+  DirectoryId InternDirectory(FndbByteOffset foDirectory);
+
+private:
+  DirectoryId InternDirectory(const std::string& directory);
+
+private:
+  bool FindDirectory(const std::string& directory, DirectoryId& directoryId) const;
+
+private:
+  std::tuple<std::string, std::string> SplitPath(const MiKTeX::Util::PathName& path) const;
 
 private:
   std::string MakeKey(const MiKTeX::Util::PathName& fileName) const;
 
+private:
+  std::string MakeKey(const MiKTeX::Util::PathNameView& fileName) const;
+
 private:
   void FastInsertRecord(Record&& record);
 
@@ -159,10 +241,11 @@ private:
   void EraseRecord(const Record& record);
   
 private:
-  void ReadFileNames();
+  std::pair<FndbWord, FndbWord> FindMappedRecords(const std::string& key) const;
 
 private:
-  void ReadFileNames(const FileNameDatabaseRecord* table);
+  std::vector<Record>& GetBucket(const std::string& key);
+
 private:
   void Finalize();
 
@@ -201,6 +284,12 @@ private:
     return reinterpret_cast<const FileNameDatabaseRecord*>(GetPointer(fndbHeader->foTable));
   }
 
+private:
+  const FileNameDatabaseHashSlot* GetHashTable() const
+  {
+    return reinterpret_cast<const FileNameDatabaseHashSlot*>(GetPointer(fndbHeader->foHashTable));
+  }
+
 private:
   void Initialize(const MiKTeX::Util::PathName& fndbPath, const MiKTeX::Util::PathName& rootDirectory, std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher);
 
@@ -210,6 +299,9 @@ private:
 private:
   FILE* OpenChangeFileExclusively();
 
+private:
+  void AppendChangeRecord(FILE* file, FndbWord op, const std::string& fileName, const std::string& directory, const std::string& info);
+
 private:
   void OpenFileNameDatabase(const MiKTeX::Util::PathName& fndbPath);
 
@@ -232,11 +324,29 @@ private:
   MiKTeX::Util::PathName rootDirectory;
 
 private:
-  typedef std::unordered_multimap<std::string, Record> FileNameHashTable;
+  typedef std::unordered_map<std::string, std::vector<Record>> FileNameHashTable;
 
+  // buckets of those file names which have been looked up so far;
+  // see GetBucket()
 private:
   FileNameHashTable fileNames;
 
+  // interned directories; indexed by DirectoryId
+private:
+  std::vector<DirectoryInfo> directories;
+
+  // comparable directory path => DirectoryId
+private:
+  std::unordered_map<std::string, DirectoryId> directoryIds;
+
+  // offset of the mapped directory string => DirectoryId
+private:
+  std::unordered_map<FndbByteOffset, DirectoryId> mappedDirectoryIds;
+
+  // PathPattern ID => memoized match results
+private:
+  std::unordered_map<unsigned, PatternMatches> patternMatches;
+
 private:
   std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher;
 
@@ -253,10 +363,26 @@ private:
   int changeFileRecordCount = 0;
 
 private:
-  std::chrono::time_point<std::chrono::high_resolution_clock> lastAccessTime = std::chrono::high_resolution_clock::now();
+  std::atomic<std::chrono::time_point<std::chrono::high_resolution_clock>> lastAccessTime{ std::chrono::high_resolution_clock::now() };
+
+  // how often to check the change file, if there is no file system
+  // watcher
+private:
+  static constexpr std::chrono::seconds CHANGE_FILE_POLL_INTERVAL = std::chrono::seconds(1);
+
+private:
+  std::chrono::time_point<std::chrono::high_resolution_clock> lastChangeFilePoll = std::chrono::high_resolution_clock::now();
 
 private:
   std::unique_ptr<MiKTeX::Trace::TraceStream> trace_fndb;
+
+private:
+  static std::atomic_uint generation;
+
+  // lookups fill in the caches (buckets, interned directories, pattern
+  // matches): concurrent lookups are serialized per database
+private:
+  std::mutex lookupMutex;
 };
 
 CORE_INTERNAL_END_NAMESPACE;
@@ -21,6 +21,9 @@
 
 #include "config.h"
 
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
 #include "internal.h"
 
 #include "Session/SessionImpl.h"
@@ -43,6 +46,26 @@ bool Fndb::Search(const PathName& fileName, const string& pathPattern, bool all,
   return fndb->Search(fileName, pathPattern, all, result);
 }
 
+// folds the change file into a rebuilt FNDB, so that the replay
+// cost stays bounded; this is a best-effort operation
+static void Compact(unsigned root)
+{
+  shared_ptr<SessionImpl> session = SESSION_IMPL();
+  if (!session->UnloadFilenameDatabaseInternal(root, chrono::seconds(0)))
+  {
+    // still in use
+    return;
+  }
+  try
+  {
+    Fndb::Refresh(session->GetRootDirectoryPath(root), nullptr);
+  }
+  catch (const MiKTeXException& e)
+  {
+    session->trace_error->WriteLine("core", fmt::format(T_("FNDB compaction failed: {0}"), e.GetErrorMessage()));
+  }
+}
+
 void Fndb::Add(const vector<Fndb::Record>& records)
 {
   if (records.empty())
@@ -61,6 +84,11 @@ void Fndb::Add(const vector<Fndb::Record>& records)
       MIKTEX_UNEXPECTED();
     }
     fndb->Add(records);
+    if (fndb->GetChangeFileRecordCount() >= FileNameDatabase::MAX_CHANGE_FILE_RECORDS)
+    {
+      fndb = nullptr;
+      Compact(root);
+    }
   }
   else
   {
@@ -91,6 +119,11 @@ void Fndb::Remove(const vector<PathName>& paths)
     MIKTEX_UNEXPECTED();
   }
   fndb->Remove(paths);
+  if (fndb->GetChangeFileRecordCount() >= FileNameDatabase::MAX_CHANGE_FILE_RECORDS)
+  {
+    fndb = nullptr;
+    Compact(root);
+  }
 }
 
 bool Fndb::FileExists(const PathName& path)
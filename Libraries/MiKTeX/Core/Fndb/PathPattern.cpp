@@ -0,0 +1,79 @@
+/* PathPattern.cpp: compiled path patterns
+
+   Copyright (C) 2022 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Util/PathName>
+#include <miktex/Util/PathNameUtil>
+
+#include "internal.h"
+
+#include "PathPattern.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+atomic_uint PathPattern::nextId(0);
+
+// FIXME: not UTF-8 safe
+bool PathPattern::Match(const char* pathPattern, const char* path)
+{
+  MIKTEX_ASSERT(PathName(pathPattern).IsComparable());
+  MIKTEX_ASSERT(PathName(path).IsComparable());
+  int lastch = 0;
+  for (; *pathPattern != 0 && *path != 0; ++pathPattern, ++path)
+  {
+    if (*pathPattern == *path)
+    {
+      lastch = *path;
+      continue;
+    }
+    MIKTEX_ASSERT(RECURSION_INDICATOR_LENGTH == 2);
+    MIKTEX_ASSERT(PathNameUtil::IsDirectoryDelimiter(RECURSION_INDICATOR[0]));
+    MIKTEX_ASSERT(PathNameUtil::IsDirectoryDelimiter(RECURSION_INDICATOR[1]));
+    if (*pathPattern == RECURSION_INDICATOR[1] && PathNameUtil::IsDirectoryDelimiter(lastch))
+    {
+      for (; PathNameUtil::IsDirectoryDelimiter(*pathPattern); ++pathPattern)
+      {
+      };
+      if (*pathPattern == 0)
+      {
+        return true;
+      }
+      for (; *path != 0; ++path)
+      {
+        if (PathNameUtil::IsDirectoryDelimiter(lastch))
+        {
+          // RECURSION
+          if (Match(pathPattern, path))
+          {
+            return true;
+          }
+        }
+        lastch = *path;
+      }
+    }
+    return false;
+  }
+  return (*pathPattern == 0 || strcmp(pathPattern, RECURSION_INDICATOR) == 0 || strcmp(pathPattern, "/") == 0) && *path == 0;
+}
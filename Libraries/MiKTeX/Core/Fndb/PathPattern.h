@@ -0,0 +1,83 @@
+/* PathPattern.h: compiled path patterns                 -*- C++ -*-
+
+   Copyright (C) 2022 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(D3C1A7E0B55E4B6C9F1E2A4C8B7D6E05)
+#define D3C1A7E0B55E4B6C9F1E2A4C8B7D6E05
+
+#include <atomic>
+#include <string>
+
+#include <miktex/Core/Debug>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// A path pattern which has been prepared for repeated FNDB searches.
+/// Each instance gets a process-unique ID so that file name databases
+/// can memoize per-directory match results.
+class PathPattern
+{
+public:
+  PathPattern(const std::string& pathPattern) :
+    id(++nextId),
+    pathPattern(pathPattern)
+  {
+  }
+
+public:
+  PathPattern(const PathPattern& other) = delete;
+
+public:
+  PathPattern& operator=(const PathPattern& other) = delete;
+
+public:
+  unsigned GetId() const
+  {
+    return id;
+  }
+
+public:
+  const std::string& ToString() const
+  {
+    return pathPattern;
+  }
+
+  /// Matches a comparable directory path against a comparable path pattern.
+  /// @param comparablePathPattern The path pattern (may contain `//`).
+  /// @param comparablePath The directory path.
+  /// @return Returns `true`, if the path matches.
+public:
+  static bool Match(const char* comparablePathPattern, const char* comparablePath);
+
+private:
+  unsigned id;
+
+private:
+  std::string pathPattern;
+
+private:
+  static std::atomic_uint nextId;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
+
+#endif
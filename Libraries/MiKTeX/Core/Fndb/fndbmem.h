@@ -1,6 +1,6 @@
 /* fndbmem.h: fndb file format                          -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2022 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -65,6 +65,21 @@ struct FileNameDatabaseHeader
   
   FndbWord reserved;
 
+  // pointer to the file name hash table
+  FndbByteOffset foHashTable;
+
+  // number of hash table slots (a power of two)
+  FndbWord hashTableSize;
+
+  // pointer to the directory table; zero, if there is none
+  FndbByteOffset foDirectoryTable;
+
+  // number of directory records
+  FndbWord numDirectoryRecords;
+
+  // time (seconds since the epoch) when the directory scan started
+  uint64_t creationTime;
+
   void Init()
   {
     MIKTEX_ASSERT(sizeof(*this) % 8 == 0);
@@ -72,9 +87,119 @@ struct FileNameDatabaseHeader
     version = Version;
     flags = 0;
     size = sizeof(*this);
+    reserved = 0;
+    foHashTable = 0;
+    hashTableSize = 0;
+    foDirectoryTable = 0;
+    numDirectoryRecords = 0;
+    creationTime = 0;
   }
 };
 
+/*
+ * The hash table is an open addressing table (linear probing) with
+ * one slot per distinct file name.  Records having the same
+ * (comparable) file name are stored contiguously in the record table,
+ * i.e., a slot refers to the first record of such a run.
+ */
+struct FileNameDatabaseHashSlot
+{
+  // hash value of the comparable file name
+  FndbWord hash;
+
+  // index of the first record plus one; zero marks an empty slot
+  FndbWord firstRecord;
+};
+
+// FNV-1a; must not change without bumping MIKTEX_FNDB_VERSION
+inline FndbWord FndbHash(const char* key)
+{
+  FndbWord hash = 0x811c9dc5;
+  for (; *key != 0; ++key)
+  {
+    hash ^= static_cast<uint8_t>(*key);
+    hash *= 0x01000193;
+  }
+  return hash;
+}
+
+inline FndbWord FndbHash(const void* data, size_t size, FndbWord hash = 0x811c9dc5)
+{
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  for (size_t idx = 0; idx < size; ++idx)
+  {
+    hash ^= bytes[idx];
+    hash *= 0x01000193;
+  }
+  return hash;
+}
+
+/*
+ * The directory table lists the scanned directories in pre-order,
+ * i.e., the root directory comes first and a parent always precedes
+ * its sub-directories.  It allows an incremental refresh to re-use
+ * the listings of unchanged directories.
+ */
+struct FileNameDatabaseDirectoryRecord
+{
+  // the directory path (relative to the root directory)
+  FndbByteOffset foPath;
+
+  // the directory name, as found in the parent directory
+  FndbByteOffset foName;
+
+  // index of the parent record plus one; zero for the root directory
+  FndbWord parent;
+
+  FndbWord reserved = 0;
+
+  // modification time of the directory; zero, if the listing must not
+  // be re-used
+  uint64_t lastWriteTime;
+};
+
+/*
+ * The change file (*.fndb-N.log) is an append-only log of records
+ * added to or removed from the FNDB.  It starts with a header which
+ * identifies the FNDB the log belongs to; each entry consists of a
+ * fixed-size record followed by the (unterminated) file name,
+ * directory and file name info strings.
+ */
+struct FileNameDatabaseChangeFileHeader
+{
+  static const FndbWord Signature = 0x4c444e46; // 'FNDL' (the x86 way)
+  static const FndbWord Version = MIKTEX_FNDB_VERSION;
+
+  FndbWord signature;
+
+  FndbWord version;
+
+  // creation time of the FNDB (see FileNameDatabaseHeader)
+  uint64_t fndbCreationTime;
+};
+
+struct FileNameDatabaseChangeRecord
+{
+  enum : FndbWord
+  {
+    Add = '+',
+    Remove = '-'
+  };
+
+  FndbWord op;
+
+  FndbWord fileNameLength;
+
+  FndbWord directoryLength;
+
+  FndbWord infoLength;
+
+  // FNV-1a of the strings following the record
+  FndbWord checksum;
+
+  FndbWord reserved = 0;
+};
+
 struct FileNameDatabaseRecord
 {
   FndbByteOffset foFileName;
@@ -21,7 +21,9 @@
 
 #include "config.h"
 
-#include <fstream>
+#include <algorithm>
+#include <future>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
@@ -42,6 +44,8 @@
 #include "internal.h"
 
 #include "Session/SessionImpl.h"
+#include "Utils/LineReader.h"
+
 #include "fndbmem.h"
 
 using namespace std;
@@ -57,10 +61,28 @@ const uint8_t null_byte = 0;
 struct FILENAMEINFO
 {
   string FileName;
+  string Key;
   const string* Directory = nullptr;
   const string* Info = nullptr;
 };
 
+struct DIRECTORYINFO
+{
+  const string* Path = nullptr;
+  string Name;
+  size_t Parent = 0;
+  time_t LastWriteTime = 0;
+};
+
+// a directory listing taken from the previous FNDB
+struct PREVIOUSDIRECTORYINFO
+{
+  string Name;
+  time_t LastWriteTime = 0;
+  vector<size_t> SubDirectories;
+  vector<FILENAMEINFO> FileNames;
+};
+
 class FndbManager
 {
 public:
@@ -71,7 +93,26 @@ public:
   }
 
 public:
-  bool Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo);
+  bool Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo)
+  {
+    if (!Collect(rootPath, callback, enableStringPooling, storeFileNameInfo, PathName()))
+    {
+      return false;
+    }
+    Write(fndbPath);
+    return true;
+  }
+
+  // scans the root directory and builds the FNDB in memory; doesn't
+  // touch the session, i.e., can run on a worker thread; the listings
+  // of unchanged directories are taken from previousFndbPath, if it
+  // is not empty
+public:
+  bool Collect(const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo, const PathName& previousFndbPath);
+
+  // writes the FNDB file; must run on the session thread
+public:
+  void Write(const PathName& fndbPath);
 
 private:
   void* GetMemPointer()
@@ -136,7 +177,19 @@ public:
   void ReadDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<FILENAMEINFO>& fileNames, bool doCleanUp);
 
 private:
-  void CollectFiles(const PathName& parentPath, const PathName& folderName, vector<FILENAMEINFO>& fileNames);
+  void CollectFiles(const PathName& parentPath, const PathName& folderName, vector<FILENAMEINFO>& fileNames, size_t parent, const PREVIOUSDIRECTORYINFO* previous);
+
+private:
+  bool CanReuse(const PREVIOUSDIRECTORYINFO& previous, const PathName& path, time_t lastWriteTime) const;
+
+private:
+  void LoadPreviousFndb(const PathName& fndbPath);
+
+private:
+  void WriteHashTable(FileNameDatabaseHeader& fndb, const vector<FILENAMEINFO>& fileNames);
+
+private:
+  void WriteDirectoryTable(FileNameDatabaseHeader& fndb);
 
 private:
   PathName rootPath;
@@ -156,6 +209,18 @@ private:
 private:
   size_t numFiles;
 
+private:
+  size_t numReusedDirectories;
+
+private:
+  vector<DIRECTORYINFO> directories;
+
+private:
+  vector<PREVIOUSDIRECTORYINFO> previousDirectories;
+
+private:
+  time_t previousCreationTime;
+
 private:
   ICreateFndbCallback* callback;
 
@@ -259,11 +324,11 @@ void FndbManager::GetIgnorableFiles(const PathName& dirPath, vector<string>& fil
   {
     return;
   }
-  ifstream reader = File::CreateInputStream(ignoreFile);
+  LineReader reader(ignoreFile);
   filesToBeIgnored.reserve(10);
-  for (string line; std::getline(reader, line); )
+  for (string_view line; reader.ReadLine(line); )
   {
-    filesToBeIgnored.push_back(line);
+    filesToBeIgnored.push_back(string(line));
   }
   sort(filesToBeIgnored.begin(), filesToBeIgnored.end(), StringComparerIgnoringCase());
 }
@@ -277,12 +342,11 @@ void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDire
   }
   vector<string> filesToBeIgnored;
   GetIgnorableFiles(dirPath, filesToBeIgnored);
-  unique_ptr<DirectoryLister> lister = DirectoryLister::Open(dirPath);
-  DirectoryEntry entry;
   vector<DirectoryEntry> toBeDeleted;
   PathName directory(Utils::GetRelativizedPath(dirPath.GetData(), rootPath.GetData()));
   directory = directory.ToUnix();
-  while (lister->GetNext(entry))
+  const string* pooledDirectory = &*stringPool.insert(directory.ToString()).first;
+  for (DirectoryEntry& entry : DirectoryLister::ReadDirectory(dirPath, nullptr, (int)DirectoryLister::Options::None))
   {
     if (binary_search(filesToBeIgnored.begin(), filesToBeIgnored.end(), entry.name, StringComparerIgnoringCase()))
     {
@@ -300,11 +364,11 @@ void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDire
     {
       FILENAMEINFO filenameinfo;
       filenameinfo.FileName = entry.name;
-      filenameinfo.Directory = &*stringPool.insert(directory.ToString()).first;
+      filenameinfo.Key = PathName(entry.name).TransformForComparison().ToString();
+      filenameinfo.Directory = pooledDirectory;
       fileNames.push_back(filenameinfo);
     }
   }
-  lister->Close();
 
   // silent clean-up
   for (const DirectoryEntry& e : toBeDeleted)
@@ -327,7 +391,18 @@ void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDire
   }
 }
 
-void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folderName, vector<FILENAMEINFO>& fileNames)
+bool FndbManager::CanReuse(const PREVIOUSDIRECTORYINFO& previous, const PathName& path, time_t lastWriteTime) const
+{
+  // a directory modified shortly before the previous scan might have
+  // been modified again within the timestamp resolution
+  const time_t racyInterval = 2;
+  return lastWriteTime != 0
+    && previous.LastWriteTime == lastWriteTime
+    && previous.LastWriteTime + racyInterval < previousCreationTime
+    && !File::Exists(PathName(path, PathName(FN_MIKTEXIGNORE)));
+}
+
+void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folderName, vector<FILENAMEINFO>& fileNames, size_t parent, const PREVIOUSDIRECTORYINFO* previous)
 {
   if (currentLevel > deepestLevel)
   {
@@ -345,6 +420,13 @@ void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folde
   PathName directory(Utils::GetRelativizedPath(path.GetData(), rootPath.GetData()));
   directory = directory.ToUnix();
 
+  size_t thisDirectory = directories.size();
+  DIRECTORYINFO directoryInfo;
+  directoryInfo.Path = &*stringPool.insert(directory.ToString()).first;
+  directoryInfo.Name = folderName.ToString();
+  directoryInfo.Parent = parent;
+  directories.push_back(directoryInfo);
+
   if (callback != nullptr)
   {
     if (!callback->OnProgress(static_cast<unsigned>(currentLevel), path))
@@ -363,6 +445,7 @@ void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folde
       {
         FILENAMEINFO filenameinfo;
         filenameinfo.FileName = files[i];
+        filenameinfo.Key = PathName(files[i]).TransformForComparison().ToString();
         filenameinfo.Directory = &*stringPool.insert(directory.ToString()).first;
         filenameinfo.Info = &*stringPool.insert(infos[i]).first;
         fileNames.push_back(filenameinfo);
@@ -372,28 +455,172 @@ void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folde
 
   if (!done)
   {
-    ReadDirectory(path, subDirectoryNames, fileNames, true);
+    time_t lastWriteTime = Directory::Exists(path) ? File::GetLastWriteTime(path) : 0;
+    if (previous != nullptr && CanReuse(*previous, path, lastWriteTime))
+    {
+      for (size_t idx : previous->SubDirectories)
+      {
+        subDirectoryNames.push_back(previousDirectories[idx].Name);
+      }
+      fileNames.insert(fileNames.end(), previous->FileNames.begin(), previous->FileNames.end());
+      ++numReusedDirectories;
+    }
+    else
+    {
+      ReadDirectory(path, subDirectoryNames, fileNames, true);
+    }
+    directories[thisDirectory].LastWriteTime = lastWriteTime;
   }
 
   numDirectories += subDirectoryNames.size();
 
+  unordered_map<string, const PREVIOUSDIRECTORYINFO*> previousSubDirectories;
+  if (previous != nullptr)
+  {
+    for (size_t idx : previous->SubDirectories)
+    {
+      previousSubDirectories[previousDirectories[idx].Name] = &previousDirectories[idx];
+    }
+  }
+
   // recurse into sub-directories
   PathName pathFolder(parentPath, folderName);
-  size_t i = 0;
   ++currentLevel;
   for (const string& s : subDirectoryNames)
   {
+    auto it = previousSubDirectories.find(s);
     // RECURSION
-    CollectFiles(pathFolder, PathName(s), fileNames);
-    ++i;
+    CollectFiles(pathFolder, PathName(s), fileNames, thisDirectory + 1, it == previousSubDirectories.end() ? nullptr : it->second);
   }
   --currentLevel;
 }
 
-bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo)
+void FndbManager::WriteHashTable(FileNameDatabaseHeader& fndb, const vector<FILENAMEINFO>& fileNames)
 {
-  trace_fndb->WriteLine("core", fmt::format(T_("creating fndb file {0}..."), Q_(fndbPath)));
-  unsigned rootIdx = SESSION_IMPL()->DeriveTEXMFRoot(rootPath);
+  MIKTEX_ASSERT(is_sorted(fileNames.begin(), fileNames.end(), [](const FILENAMEINFO& lhs, const FILENAMEINFO& rhs) { return lhs.Key < rhs.Key; }));
+  size_t numKeys = 0;
+  for (size_t idx = 0; idx < fileNames.size(); ++idx)
+  {
+    if (idx == 0 || fileNames[idx].Key != fileNames[idx - 1].Key)
+    {
+      ++numKeys;
+    }
+  }
+  // keep the load factor below 0.5
+  size_t hashTableSize = 16;
+  while (hashTableSize < 2 * numKeys)
+  {
+    hashTableSize *= 2;
+  }
+  AlignMem();
+  fndb.foHashTable = ReserveMem(hashTableSize * sizeof(FileNameDatabaseHashSlot));
+  fndb.hashTableSize = static_cast<FndbWord>(hashTableSize);
+  FileNameDatabaseHashSlot* slots = reinterpret_cast<FileNameDatabaseHashSlot*>(reinterpret_cast<uint8_t*>(GetMemPointer()) + fndb.foHashTable);
+  for (size_t idx = 0; idx < fileNames.size(); ++idx)
+  {
+    if (idx > 0 && fileNames[idx].Key == fileNames[idx - 1].Key)
+    {
+      continue;
+    }
+    FndbWord hash = FndbHash(fileNames[idx].Key.c_str());
+    size_t slotIdx = hash & (hashTableSize - 1);
+    while (slots[slotIdx].firstRecord != 0)
+    {
+      slotIdx = (slotIdx + 1) & (hashTableSize - 1);
+    }
+    slots[slotIdx].hash = hash;
+    slots[slotIdx].firstRecord = static_cast<FndbWord>(idx + 1);
+  }
+}
+
+void FndbManager::WriteDirectoryTable(FileNameDatabaseHeader& fndb)
+{
+  vector<FileNameDatabaseDirectoryRecord> records;
+  records.reserve(directories.size());
+  for (const DIRECTORYINFO& dir : directories)
+  {
+    FileNameDatabaseDirectoryRecord rec;
+    rec.foPath = PushBack(dir.Path->c_str());
+    rec.foName = PushBack(dir.Name.c_str());
+    rec.parent = static_cast<FndbWord>(dir.Parent);
+    rec.lastWriteTime = static_cast<uint64_t>(dir.LastWriteTime);
+    records.push_back(rec);
+  }
+  AlignMem();
+  fndb.foDirectoryTable = GetMemTop();
+  fndb.numDirectoryRecords = static_cast<FndbWord>(records.size());
+  for (const FileNameDatabaseDirectoryRecord& rec : records)
+  {
+    PushBack(&rec, sizeof(rec));
+  }
+}
+
+void FndbManager::LoadPreviousFndb(const PathName& fndbPath)
+{
+  previousDirectories.clear();
+  if (!File::Exists(fndbPath) || File::GetSize(fndbPath) < sizeof(FileNameDatabaseHeader))
+  {
+    return;
+  }
+  vector<unsigned char> bytes = File::ReadAllBytes(fndbPath);
+  const FileNameDatabaseHeader* header = reinterpret_cast<const FileNameDatabaseHeader*>(bytes.data());
+  if (header->signature != FileNameDatabaseHeader::Signature
+    || header->version != FileNameDatabaseHeader::Version
+    || header->size > bytes.size()
+    || header->foDirectoryTable == 0
+    || header->foDirectoryTable + static_cast<uint64_t>(header->numDirectoryRecords) * sizeof(FileNameDatabaseDirectoryRecord) > header->size
+    || header->foTable + static_cast<uint64_t>(header->numFiles) * sizeof(FileNameDatabaseRecord) > header->size)
+  {
+    trace_fndb->WriteLine("core", fmt::format(T_("cannot use {0} for an incremental scan"), Q_(fndbPath)));
+    return;
+  }
+  auto getString = [&](FndbByteOffset fo) {
+    if (fo >= header->size || memchr(bytes.data() + fo, 0, header->size - fo) == nullptr)
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    return reinterpret_cast<const char*>(bytes.data() + fo);
+  };
+  const FileNameDatabaseDirectoryRecord* dirRecords = reinterpret_cast<const FileNameDatabaseDirectoryRecord*>(bytes.data() + header->foDirectoryTable);
+  unordered_map<string, size_t> directoryIndex;
+  previousDirectories.resize(header->numDirectoryRecords);
+  for (size_t idx = 0; idx < header->numDirectoryRecords; ++idx)
+  {
+    const FileNameDatabaseDirectoryRecord& rec = dirRecords[idx];
+    if (rec.parent > idx || (rec.parent == 0 && idx > 0))
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    previousDirectories[idx].Name = getString(rec.foName);
+    previousDirectories[idx].LastWriteTime = static_cast<time_t>(rec.lastWriteTime);
+    if (rec.parent > 0)
+    {
+      previousDirectories[rec.parent - 1].SubDirectories.push_back(idx);
+    }
+    directoryIndex[getString(rec.foPath)] = idx;
+  }
+  const FileNameDatabaseRecord* records = reinterpret_cast<const FileNameDatabaseRecord*>(bytes.data() + header->foTable);
+  for (size_t idx = 0; idx < header->numFiles; ++idx)
+  {
+    auto it = directoryIndex.find(getString(records[idx].foDirectory));
+    if (it == directoryIndex.end())
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    string info = getString(records[idx].foInfo);
+    FILENAMEINFO filenameinfo;
+    filenameinfo.FileName = getString(records[idx].foFileName);
+    filenameinfo.Key = PathName(filenameinfo.FileName).TransformForComparison().ToString();
+    filenameinfo.Directory = &*stringPool.insert(it->first).first;
+    filenameinfo.Info = info.empty() ? nullptr : &*stringPool.insert(info).first;
+    previousDirectories[it->second].FileNames.push_back(filenameinfo);
+  }
+  previousCreationTime = static_cast<time_t>(header->creationTime);
+}
+
+bool FndbManager::Collect(const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo, const PathName& previousFndbPath)
+{
+  trace_fndb->WriteLine("core", fmt::format(T_("collecting files in {0}..."), Q_(rootPath)));
   this->rootPath = rootPath;
   this->enableStringPooling = enableStringPooling;
   this->storeFileNameInfo = storeFileNameInfo;
@@ -403,14 +630,33 @@ bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICr
     ReserveMem(sizeof(FileNameDatabaseHeader));
     FileNameDatabaseHeader fndb;
     fndb.Init();
+    fndb.creationTime = static_cast<uint64_t>(time(nullptr));
     numDirectories = 0;
     numFiles = 0;
+    numReusedDirectories = 0;
+    previousCreationTime = 0;
     deepestLevel = 0;
     currentLevel = 0;
     this->callback = callback;
+    if (!previousFndbPath.Empty())
+    {
+      try
+      {
+        LoadPreviousFndb(previousFndbPath);
+      }
+      catch (const MiKTeXException& e)
+      {
+        trace_error->WriteLine("core", fmt::format(T_("cannot use {0} for an incremental scan: {1}"), Q_(previousFndbPath), e.GetErrorMessage()));
+        previousDirectories.clear();
+      }
+    }
     vector<FILENAMEINFO> fileNames;
-    CollectFiles(rootPath, PathName(CURRENT_DIRECTORY), fileNames);
+    CollectFiles(rootPath, PathName(CURRENT_DIRECTORY), fileNames, 0, previousDirectories.empty() ? nullptr : &previousDirectories[0]);
+    previousDirectories.clear();
+    trace_fndb->WriteLine("core", fmt::format(T_("re-used the listings of {0} of {1} directories"), numReusedDirectories, directories.size()));
     numFiles = fileNames.size();
+    // records with the same file name must be adjacent (see WriteHashTable())
+    stable_sort(fileNames.begin(), fileNames.end(), [](const FILENAMEINFO& lhs, const FILENAMEINFO& rhs) { return lhs.Key < rhs.Key; });
     AlignMem();
     fndb.foTable = ReserveMem(fileNames.size() * sizeof(FileNameDatabaseRecord));
     AlignMem();
@@ -423,52 +669,14 @@ bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICr
       rec.foInfo = PushBack(fileNames[idx].Info == nullptr ? "" : fileNames[idx].Info->c_str());
       SetMem(static_cast<unsigned>(fndb.foTable + idx * sizeof(rec)), &rec, sizeof(rec));
     }
+    WriteHashTable(fndb, fileNames);
+    WriteDirectoryTable(fndb);
     fndb.numDirs = static_cast<unsigned>(numDirectories);
     fndb.numFiles = static_cast<unsigned>(numFiles);
     fndb.depth = static_cast<unsigned>(deepestLevel);
     fndb.size = GetMemTop();
     AlignMem(FNDB_PAGESIZE);
     SetMem(0, &fndb, sizeof(fndb));
-
-    // <fixme>
-    bool unloaded = false;
-    for (size_t i = 0; !unloaded && i < 100; ++i)
-    {
-      unloaded = SESSION_IMPL()->UnloadFilenameDatabaseInternal(rootIdx, chrono::seconds(0));
-      if (!unloaded)
-      {
-        trace_fndb->WriteLine("core", "sleep for 1ms");
-        this_thread::sleep_for(chrono::milliseconds(1));
-      }
-    }
-    if (!unloaded)
-    {
-      MIKTEX_FATAL_ERROR(T_("fndb cannot be unloaded"));
-    }
-    // </fixme>
-    
-    PathName tmpFndbPath(fndbPath);
-    tmpFndbPath.AppendExtension(".tmp");
-    unique_ptr<TemporaryFile> tmpFndbFile = TemporaryFile::Create(tmpFndbPath);
-    FileStream streamFndb;
-    streamFndb.Attach(File::Open(tmpFndbPath, FileMode::Create, FileAccess::Write, false));
-    streamFndb.Write(reinterpret_cast<const char*>(GetMemPointer()), GetMemTop());
-    streamFndb.Close();
-    if (File::Exists(fndbPath))
-    {
-      File::Delete(fndbPath, { FileDeleteOption::TryHard });
-    }
-    File::Move(tmpFndbPath, fndbPath);
-    tmpFndbFile->Keep();
-
-    PathName changeFile = fndbPath;
-    changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
-    if (File::Exists(changeFile))
-    {
-      File::Delete(changeFile);
-    }
-    trace_fndb->WriteLine("core", T_("fndb creation completed"));
-    SESSION_IMPL()->RecordMaintenance();
     return true;
   }
   catch (const OperationCancelledException&)
@@ -478,37 +686,124 @@ bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICr
   }
 }
 
-bool Fndb::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback)
+void FndbManager::Write(const PathName& fndbPath)
 {
-  return Fndb::Create(fndbPath, rootPath, callback, true, false);
-}
+  trace_fndb->WriteLine("core", fmt::format(T_("creating fndb file {0}..."), Q_(fndbPath)));
+  unsigned rootIdx = SESSION_IMPL()->DeriveTEXMFRoot(rootPath);
 
-bool Fndb::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo)
-{
-  FndbManager fndbmngr;
+  // <fixme>
+  bool unloaded = false;
+  for (size_t i = 0; !unloaded && i < 100; ++i)
+  {
+    unloaded = SESSION_IMPL()->UnloadFilenameDatabaseInternal(rootIdx, chrono::seconds(0));
+    if (!unloaded)
+    {
+      trace_fndb->WriteLine("core", "sleep for 1ms");
+      this_thread::sleep_for(chrono::milliseconds(1));
+    }
+  }
+  if (!unloaded)
+  {
+    MIKTEX_FATAL_ERROR(T_("fndb cannot be unloaded"));
+  }
+  // </fixme>
+
+  PathName tmpFndbPath(fndbPath);
+  tmpFndbPath.AppendExtension(".tmp");
+  unique_ptr<TemporaryFile> tmpFndbFile = TemporaryFile::Create(tmpFndbPath);
+  FileStream streamFndb;
+  streamFndb.Attach(File::Open(tmpFndbPath, FileMode::Create, FileAccess::Write, false));
+  streamFndb.Write(reinterpret_cast<const char*>(GetMemPointer()), GetMemTop());
+  streamFndb.Close();
+  if (File::Exists(fndbPath))
+  {
+    File::Delete(fndbPath, { FileDeleteOption::TryHard });
+  }
+  File::Move(tmpFndbPath, fndbPath);
+  tmpFndbFile->Keep();
 
-  if (!fndbmngr.Create(fndbPath, rootPath, callback, enableStringPooling, storeFileNameInfo))
+  PathName changeFile = fndbPath;
+  changeFile.SetExtension(MIKTEX_FNDB_CHANGE_FILE_SUFFIX);
+  if (File::Exists(changeFile))
   {
-    return false;
+    File::Delete(changeFile);
   }
+  trace_fndb->WriteLine("core", T_("fndb creation completed"));
+  SESSION_IMPL()->RecordMaintenance();
 
 #if defined(MIKTEX_WINDOWS) && REPORT_EVENTS
   ReportMiKTeXEvent(EVENTLOG_INFORMATION_TYPE, MIKTEX_EVENT_FNDB_CREATED, fndbPath, rootPath, 0);
 #endif
+}
 
-  return true;
+// serializes callback invocations from concurrent FNDB scans
+class SynchronizedCreateFndbCallback :
+  public ICreateFndbCallback
+{
+public:
+  SynchronizedCreateFndbCallback(ICreateFndbCallback* callback) :
+    callback(callback)
+  {
+  }
+
+public:
+  bool MIKTEXTHISCALL ReadDirectory(const PathName& path, vector<string>& subDirNames, vector<string>& fileNames, vector<string>& fileNameInfos) override
+  {
+    lock_guard<mutex> lockGuard(callbackMutex);
+    return callback->ReadDirectory(path, subDirNames, fileNames, fileNameInfos);
+  }
+
+public:
+  bool MIKTEXTHISCALL OnProgress(unsigned level, const PathName& directory) override
+  {
+    lock_guard<mutex> lockGuard(callbackMutex);
+    return callback->OnProgress(level, directory);
+  }
+
+private:
+  ICreateFndbCallback* callback;
+
+private:
+  mutex callbackMutex;
+};
+
+bool Fndb::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback)
+{
+  return Fndb::Create(fndbPath, rootPath, callback, true, false);
+}
+
+bool Fndb::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo)
+{
+  FndbManager fndbmngr;
+  return fndbmngr.Create(fndbPath, rootPath, callback, enableStringPooling, storeFileNameInfo);
 }
 
 bool Fndb::Refresh(const PathName& path, ICreateFndbCallback* callback)
 {
   unsigned root = SESSION_IMPL()->DeriveTEXMFRoot(path);
   PathName pathFndbPath = SESSION_IMPL()->GetFilenameDatabasePathName(root);
-  return Fndb::Create(pathFndbPath, SESSION_IMPL()->GetRootDirectoryPath(root), callback);
+  FndbManager fndbmngr;
+  if (!fndbmngr.Collect(SESSION_IMPL()->GetRootDirectoryPath(root), callback, true, false, pathFndbPath))
+  {
+    return false;
+  }
+  fndbmngr.Write(pathFndbPath);
+  return true;
 }
 
 bool Fndb::Refresh(ICreateFndbCallback* callback)
 {
   shared_ptr<SessionImpl> session = SESSION_IMPL();
+  // must outlive the jobs
+  SynchronizedCreateFndbCallback synchronizedCallback(callback);
+  struct RefreshJob
+  {
+    PathName fndbPath;
+    PathName rootDirectory;
+    unique_ptr<FndbManager> fndbManager;
+    future<bool> collected;
+  };
+  vector<RefreshJob> jobs;
   unsigned n = session->GetNumberOfTEXMFRoots();
   for (unsigned ord = 0; ord < n; ++ord)
   {
@@ -522,12 +817,50 @@ bool Fndb::Refresh(ICreateFndbCallback* callback)
       // skipping common root directory
       continue;
     }
-    PathName rootDirectory = session->GetRootDirectoryPath(ord);
-    PathName pathFndbPath = session->GetFilenameDatabasePathName(ord);
-    if (!Fndb::Create(pathFndbPath, rootDirectory, callback))
+    jobs.push_back({ session->GetFilenameDatabasePathName(ord), session->GetRootDirectoryPath(ord) });
+  }
+  if (jobs.size() <= 1)
+  {
+    for (const RefreshJob& job : jobs)
     {
-      return false;
+      FndbManager fndbmngr;
+      if (!fndbmngr.Collect(job.rootDirectory, callback, true, false, job.fndbPath))
+      {
+        return false;
+      }
+      fndbmngr.Write(job.fndbPath);
     }
+    return true;
+  }
+  // scan the root directories concurrently; the FNDB files are written
+  // sequentially afterwards because this requires the session
+  ICreateFndbCallback* jobCallback = callback == nullptr ? nullptr : &synchronizedCallback;
+  for (RefreshJob& job : jobs)
+  {
+    job.fndbManager = make_unique<FndbManager>();
+    FndbManager* fndbManager = job.fndbManager.get();
+    PathName rootDirectory = job.rootDirectory;
+    PathName fndbPath = job.fndbPath;
+    job.collected = async(launch::async, [fndbManager, rootDirectory, fndbPath, jobCallback]() {
+      return fndbManager->Collect(rootDirectory, jobCallback, true, false, fndbPath);
+    });
+  }
+  bool collected = true;
+  for (RefreshJob& job : jobs)
+  {
+    // get() rethrows exceptions raised by the worker
+    if (!job.collected.get())
+    {
+      collected = false;
+    }
+  }
+  if (!collected)
+  {
+    return false;
+  }
+  for (RefreshJob& job : jobs)
+  {
+    job.fndbManager->Write(job.fndbPath);
   }
   return true;
 }
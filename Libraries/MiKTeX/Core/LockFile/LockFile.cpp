@@ -21,7 +21,19 @@
 
 #include "config.h"
 
+#if defined(MIKTEX_UNIX)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 
 #include <fmt/format.h>
@@ -29,7 +41,6 @@
 
 #include <miktex/Core/LockFile>
 #include <miktex/Core/Process>
-#include <miktex/Core/StreamReader>
 
 #include <miktex/Trace/Trace>
 #include <miktex/Trace/TraceStream>
@@ -79,17 +90,36 @@ public:
     trace_lockfile = TraceStream::Open(MIKTEX_TRACE_LOCKFILE);
   }
 public:
-  bool MIKTEXTHISCALL TryLock(chrono::milliseconds timeout) override;
+  bool MIKTEXTHISCALL TryLock(chrono::milliseconds timeout) override
+  {
+    return TryLock(true, timeout);
+  }
+public:
+  bool MIKTEXTHISCALL TryLockShared(chrono::milliseconds timeout) override
+  {
+    return TryLock(false, timeout);
+  }
 public:
   void MIKTEXTHISCALL Unlock() override;
 private:
-  tuple<int, string> ReadLockFile();
+  bool TryLock(bool exclusive, chrono::milliseconds timeout);
 private:
-  tuple<bool, int, string> CheckLockFile();
+  bool IsPermanentlyLocked();
+private:
+  void WriteOwner();
 private:
   PathName path;
 private:
   bool locked = false;
+private:
+  bool exclusive = false;
+#if defined(MIKTEX_WINDOWS)
+private:
+  HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+private:
+  int fd = -1;
+#endif
 private:
   unique_ptr<TraceStream> trace_lockfile;
 };
@@ -103,139 +133,382 @@ unique_ptr<MiKTeX::Core::LockFile> LockFile::Create(const PathName& path)
   return make_unique<LockFileImpl>(path);
 }
 
-bool LockFileImpl::TryLock(chrono::milliseconds timeout)
+static string OwnerInfo()
+{
+  return fmt::format("{0}\n{1}\n", Process::GetCurrentProcess()->GetSystemId(), Process::GetCurrentProcess()->get_ProcessName());
+}
+
+#if defined(MIKTEX_WINDOWS)
+
+// Windows: the lock is a byte range lock (LockFileEx) on the lock file;
+// contended locks are waited for with an overlapped request, i.e., the
+// waiting thread is woken up as soon as the lock is released
+
+static DWORD RemainingMilliseconds(chrono::steady_clock::time_point deadline)
+{
+  chrono::steady_clock::time_point now = chrono::steady_clock::now();
+  return now >= deadline ? 0 : static_cast<DWORD>(chrono::duration_cast<chrono::milliseconds>(deadline - now).count());
+}
+
+static bool WaitForOverlapped(HANDLE handle, OVERLAPPED& overlapped, DWORD timeout, DWORD& n)
+{
+  if (WaitForSingleObject(overlapped.hEvent, timeout) == WAIT_TIMEOUT)
+  {
+    CancelIoEx(handle, &overlapped);
+  }
+  return GetOverlappedResult(handle, &overlapped, &n, TRUE) ? true : false;
+}
+
+bool LockFileImpl::TryLock(bool exclusive, chrono::milliseconds timeout)
 {
-  trace_lockfile->WriteLine("core", fmt::format(T_("trying to create lock file {0}"), Q_(path)));
+  trace_lockfile->WriteLine("core", fmt::format(T_("trying to acquire {0} lock on {1}"), exclusive ? "exclusive" : "shared", Q_(path)));
   if (locked)
   {
     MIKTEX_FATAL_ERROR_2(T_("File is locked: {0}"), "path", path.ToString());
   }
-  chrono::time_point<chrono::high_resolution_clock> tryUntil = chrono::high_resolution_clock::now() + timeout;
-  bool tryAgain;
-  do
+  chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + timeout;
+  wstring widePath = path.ToExtendedLengthPathName().ToWideCharString();
+  while (true)
   {
-    tryAgain = false;
-    if (!File::Exists(path))
+    HANDLE h = CreateFileW(widePath.c_str(), GENERIC_READ | GENERIC_WRITE | DELETE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr);
+    if (h == INVALID_HANDLE_VALUE && GetLastError() == ERROR_ACCESS_DENIED && !exclusive)
     {
-      try
+      // read-only installation directory
+      h = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr);
+      if (h == INVALID_HANDLE_VALUE && GetLastError() == ERROR_FILE_NOT_FOUND)
       {
-        ofstream os = File::CreateOutputStream(path);
-        os
-          << Process::GetCurrentProcess()->GetSystemId() << "\n"
-          << Process::GetCurrentProcess()->get_ProcessName() << "\n";
-        os.close();
-        trace_lockfile->WriteLine("core", fmt::format(T_("lock file {0} successfully created"), Q_(path)));
+        // nobody can hold an exclusive lock
+        trace_lockfile->WriteLine("core", fmt::format(T_("{0} cannot be created; assuming shared access"), Q_(path)));
+        this->exclusive = false;
         locked = true;
+        return true;
       }
-      catch (const FileExistsException&)
+    }
+    if (h == INVALID_HANDLE_VALUE)
+    {
+      DWORD error = GetLastError();
+      if (error != ERROR_ACCESS_DENIED && error != ERROR_SHARING_VIOLATION)
       {
+        MIKTEX_FATAL_WINDOWS_ERROR_2("CreateFileW", "path", path.ToString());
       }
-      catch (const UnauthorizedAccessException&)
+      // the previous lock file is about to be removed
+      if (chrono::steady_clock::now() >= deadline)
       {
+        trace_lockfile->WriteLine("core", fmt::format(T_("{0} cannot be opened"), Q_(path)));
+        return false;
       }
+      this_thread::sleep_for(1ms);
+      continue;
+    }
+    OVERLAPPED overlapped;
+    memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (overlapped.hEvent == nullptr)
+    {
+      CloseHandle(h);
+      MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
     }
-    if (!locked)
+    bool acquired = LockFileEx(h, exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, MAXDWORD, MAXDWORD, &overlapped) ? true : false;
+    if (!acquired)
     {
-      bool isGarbage;
-      int pid;
-      string processName;
-      tie(isGarbage, pid, processName) = CheckLockFile();
-      if (isGarbage)
+      DWORD error = GetLastError();
+      DWORD n;
+      if (error == ERROR_IO_PENDING)
       {
-        trace_lockfile->WriteLine("core", TraceLevel::Warning, fmt::format(T_("removing lock file {0} created by {1} ({2})"), Q_(path), processName, pid));
-        try
-        {
-          File::Delete(path);
-        }
-        catch (const FileNotFoundException&)
-        {
-        }
-        catch (const exception&)
-        {
-          throw;
-        }
-        tryAgain = true;
+        acquired = WaitForOverlapped(h, overlapped, RemainingMilliseconds(deadline), n);
+        error = acquired ? ERROR_SUCCESS : GetLastError();
       }
-      else
+      if (!acquired && error != ERROR_OPERATION_ABORTED && error != ERROR_LOCK_VIOLATION)
       {
-        this_thread::sleep_for(10ms);
+        CloseHandle(overlapped.hEvent);
+        CloseHandle(h);
+        MIKTEX_FATAL_WINDOWS_ERROR_2("LockFileEx", "path", path.ToString());
       }
     }
-  } while (!locked && (tryAgain || chrono::high_resolution_clock::now() < tryUntil));
-  return locked;
+    CloseHandle(overlapped.hEvent);
+    if (!acquired)
+    {
+      CloseHandle(h);
+      trace_lockfile->WriteLine("core", fmt::format(T_("{0} is locked by another process"), Q_(path)));
+      return false;
+    }
+    FILE_STANDARD_INFO info;
+    if (GetFileInformationByHandleEx(h, FileStandardInfo, &info, sizeof(info)) && info.DeletePending)
+    {
+      // we got the lock on a file which is being removed
+      OVERLAPPED unlockOverlapped;
+      memset(&unlockOverlapped, 0, sizeof(unlockOverlapped));
+      UnlockFileEx(h, 0, MAXDWORD, MAXDWORD, &unlockOverlapped);
+      CloseHandle(h);
+      continue;
+    }
+    handle = h;
+    this->exclusive = exclusive;
+    locked = true;
+    break;
+  }
+  if (IsPermanentlyLocked())
+  {
+    Unlock();
+    return false;
+  }
+  if (exclusive)
+  {
+    WriteOwner();
+  }
+  trace_lockfile->WriteLine("core", fmt::format(T_("{0} successfully locked"), Q_(path)));
+  return true;
 }
 
 void MIKTEXTHISCALL LockFileImpl::Unlock()
 {
-  trace_lockfile->WriteLine("core", fmt::format(T_("removing lock file {0}"), Q_(path)));
+  trace_lockfile->WriteLine("core", fmt::format(T_("unlocking {0}"), Q_(path)));
   if (!locked)
   {
     MIKTEX_FATAL_ERROR_2(T_("File is not locked: {0}"), "path", path.ToString());
   }
   locked = false;
-  File::Delete(path);
+  if (handle == INVALID_HANDLE_VALUE)
+  {
+    return;
+  }
+  // the last owner removes the lock file; waiters detect this and
+  // start over
+  OVERLAPPED overlapped;
+  memset(&overlapped, 0, sizeof(overlapped));
+  if (!exclusive)
+  {
+    UnlockFileEx(handle, 0, MAXDWORD, MAXDWORD, &overlapped);
+  }
+  if (exclusive || LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, MAXDWORD, MAXDWORD, &overlapped))
+  {
+    FILE_DISPOSITION_INFO disposition;
+    disposition.DeleteFile = TRUE;
+    SetFileInformationByHandle(handle, FileDispositionInfo, &disposition, sizeof(disposition));
+    memset(&overlapped, 0, sizeof(overlapped));
+    UnlockFileEx(handle, 0, MAXDWORD, MAXDWORD, &overlapped);
+  }
+  CloseHandle(handle);
+  handle = INVALID_HANDLE_VALUE;
 }
 
-tuple<int, string> LockFileImpl::ReadLockFile()
+bool LockFileImpl::IsPermanentlyLocked()
 {
-  string pid;
-  string processName;
-  StreamReader reader(path);
-  reader.ReadLine(pid);
-  reader.ReadLine(processName);
-  reader.Close();
-  return make_tuple(std::stoi(pid), processName);
+  if (handle == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+  char buffer[8];
+  OVERLAPPED overlapped;
+  memset(&overlapped, 0, sizeof(overlapped));
+  overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+  if (overlapped.hEvent == nullptr)
+  {
+    MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
+  }
+  DWORD n = 0;
+  bool ok = ReadFile(handle, buffer, sizeof(buffer), &n, &overlapped) || (GetLastError() == ERROR_IO_PENDING && WaitForOverlapped(handle, overlapped, INFINITE, n));
+  CloseHandle(overlapped.hEvent);
+  return ok && n >= 3 && memcmp(buffer, "-1\n", 3) == 0;
 }
 
-tuple<bool, int, string> LockFileImpl::CheckLockFile()
+void LockFileImpl::WriteOwner()
 {
-  int pid;
-  string processName;
-  try
+  string owner = OwnerInfo();
+  FILE_END_OF_FILE_INFO endOfFile;
+  endOfFile.EndOfFile.QuadPart = 0;
+  SetFileInformationByHandle(handle, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile));
+  OVERLAPPED overlapped;
+  memset(&overlapped, 0, sizeof(overlapped));
+  overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+  if (overlapped.hEvent == nullptr)
   {
-    tie(pid, processName) = ReadLockFile();
+    MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
   }
-  catch (const UnauthorizedAccessException&)
+  DWORD n;
+  if (!WriteFile(handle, owner.c_str(), static_cast<DWORD>(owner.length()), &n, &overlapped) && GetLastError() == ERROR_IO_PENDING)
   {
-    trace_lockfile->WriteLine("core", fmt::format(T_("permission denied: {0}"), Q_(path)));
-    return make_tuple(false, pid, processName);
+    WaitForOverlapped(handle, overlapped, INFINITE, n);
   }
-  catch (const IOException&)
+  CloseHandle(overlapped.hEvent);
+}
+
+#else
+
+// Unix: the lock is a flock() lock on the lock file; contended locks
+// are waited for by a thread blocking in flock(), i.e., the waiting
+// thread is woken up as soon as the lock is released
+
+namespace
+{
+  struct LockWaiter
   {
-    trace_lockfile->WriteLine("core", fmt::format(T_("could not read lock file {0}"), Q_(path)));
-    return make_tuple(false, pid, processName);
-  }
-  if (pid == -1)
+    mutex mux;
+    condition_variable cv;
+    bool done = false;
+    bool abandoned = false;
+    int error = 0;
+  };
+}
+
+// Waits until the lock has been acquired or the deadline has passed.
+// In the latter case, the file descriptor is handed over to the
+// waiting thread, which closes it as soon as flock() returns.
+static bool WaitForLock(int fd, int operation, chrono::steady_clock::time_point deadline, int& error)
+{
+  shared_ptr<LockWaiter> waiter = make_shared<LockWaiter>();
+  thread([waiter, fd, operation]()
+  {
+    int result;
+    do
+    {
+      result = flock(fd, operation);
+    } while (result != 0 && errno == EINTR);
+    int lockError = result == 0 ? 0 : errno;
+    lock_guard<mutex> lockGuard(waiter->mux);
+    if (waiter->abandoned)
+    {
+      close(fd);
+      return;
+    }
+    waiter->done = true;
+    waiter->error = lockError;
+    waiter->cv.notify_one();
+  }).detach();
+  unique_lock<mutex> lock(waiter->mux);
+  if (!waiter->cv.wait_until(lock, deadline, [waiter]() { return waiter->done; }))
   {
-    // permanently locked
-    return make_tuple(false, pid, processName);
+    waiter->abandoned = true;
+    return false;
   }
-  if (pid == Process::GetCurrentProcess()->GetSystemId())
+  error = waiter->error;
+  return true;
+}
+
+bool LockFileImpl::TryLock(bool exclusive, chrono::milliseconds timeout)
+{
+  trace_lockfile->WriteLine("core", fmt::format(T_("trying to acquire {0} lock on {1}"), exclusive ? "exclusive" : "shared", Q_(path)));
+  if (locked)
   {
-    MIKTEX_UNEXPECTED();
+    MIKTEX_FATAL_ERROR_2(T_("File is locked: {0}"), "path", path.ToString());
   }
-  try
+  chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + timeout;
+  int operation = exclusive ? LOCK_EX : LOCK_SH;
+  while (true)
   {
-    unique_ptr<Process> p = Process::GetProcess(pid);
-    if (p == nullptr)
+    int f = open(path.GetData(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+    if (f < 0 && (errno == EACCES || errno == EROFS) && !exclusive)
     {
-      trace_lockfile->WriteLine("core", fmt::format(T_("owner of lock file {0} does not exist"), Q_(path)));
-      return make_tuple(true, pid, processName);
+      // read-only installation directory
+      f = open(path.GetData(), O_RDONLY | O_CLOEXEC);
+      if (f < 0 && errno == ENOENT)
+      {
+        // nobody can hold an exclusive lock
+        trace_lockfile->WriteLine("core", fmt::format(T_("{0} cannot be created; assuming shared access"), Q_(path)));
+        this->exclusive = false;
+        locked = true;
+        return true;
+      }
+    }
+    if (f < 0)
+    {
+      if (errno == EACCES || errno == EROFS)
+      {
+        trace_lockfile->WriteLine("core", fmt::format(T_("{0} cannot be opened"), Q_(path)));
+        return false;
+      }
+      MIKTEX_FATAL_CRT_ERROR_2("open", "path", path.ToString());
     }
-    if (p->get_ProcessName() != processName)
+    if (flock(f, operation | LOCK_NB) != 0)
     {
-      trace_lockfile->WriteLine("core", fmt::format(T_("owner process {0} ({1}) of lock file {2} does not exist"), processName, pid, Q_(path)));
-      return make_tuple(true, pid, processName);
+      int error = errno;
+      if (error == EWOULDBLOCK && chrono::steady_clock::now() < deadline)
+      {
+        if (!WaitForLock(f, operation, deadline, error))
+        {
+          // f is owned by the waiting thread
+          trace_lockfile->WriteLine("core", fmt::format(T_("{0} is locked by another process"), Q_(path)));
+          return false;
+        }
+      }
+      if (error != 0)
+      {
+        close(f);
+        if (error == EWOULDBLOCK)
+        {
+          trace_lockfile->WriteLine("core", fmt::format(T_("{0} is locked by another process"), Q_(path)));
+          return false;
+        }
+        errno = error;
+        MIKTEX_FATAL_CRT_ERROR_2("flock", "path", path.ToString());
+      }
     }
-    if (p->GetProcessInfo().status == ProcessStatus::Zombie)
+    struct stat fileStat;
+    struct stat pathStat;
+    if (fstat(f, &fileStat) != 0 || stat(path.GetData(), &pathStat) != 0 || fileStat.st_dev != pathStat.st_dev || fileStat.st_ino != pathStat.st_ino)
     {
-      trace_lockfile->WriteLine("core", fmt::format(T_("owner process {0} ({1}) of lock file {2} is a zombie"), processName, pid, Q_(path)));
-      return make_tuple(true, pid, processName);
+      // we got the lock on a file which has been removed in the meantime
+      close(f);
+      continue;
     }
+    fd = f;
+    this->exclusive = exclusive;
+    locked = true;
+    break;
+  }
+  if (IsPermanentlyLocked())
+  {
+    Unlock();
+    return false;
+  }
+  if (exclusive)
+  {
+    WriteOwner();
+  }
+  trace_lockfile->WriteLine("core", fmt::format(T_("{0} successfully locked"), Q_(path)));
+  return true;
+}
+
+void MIKTEXTHISCALL LockFileImpl::Unlock()
+{
+  trace_lockfile->WriteLine("core", fmt::format(T_("unlocking {0}"), Q_(path)));
+  if (!locked)
+  {
+    MIKTEX_FATAL_ERROR_2(T_("File is not locked: {0}"), "path", path.ToString());
   }
-  catch (const UnauthorizedAccessException&)
+  locked = false;
+  if (fd < 0)
+  {
+    return;
+  }
+  // the last owner removes the lock file; waiters detect this and
+  // start over
+  if (exclusive || flock(fd, LOCK_EX | LOCK_NB) == 0)
+  {
+    unlink(path.GetData());
+  }
+  close(fd);
+  fd = -1;
+}
+
+bool LockFileImpl::IsPermanentlyLocked()
+{
+  if (fd < 0)
   {
-    trace_lockfile->WriteLine("core", fmt::format(T_("permission denied: process {0} ({1})"), processName, pid));
+    return false;
   }
-  return make_tuple(false, pid, processName);
+  char buffer[8];
+  ssize_t n = pread(fd, buffer, sizeof(buffer), 0);
+  return n >= 3 && memcmp(buffer, "-1\n", 3) == 0;
 }
+
+void LockFileImpl::WriteOwner()
+{
+  string owner = OwnerInfo();
+  if (ftruncate(fd, 0) != 0 || pwrite(fd, owner.c_str(), owner.length(), 0) < 0)
+  {
+    trace_lockfile->WriteLine("core", TraceLevel::Warning, fmt::format(T_("could not write owner of lock file {0}"), Q_(path)));
+  }
+}
+
+#endif
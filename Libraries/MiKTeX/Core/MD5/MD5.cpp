@@ -42,6 +42,7 @@ MD5 MD5::FromFile(const PathName& path)
   {
     unique_ptr<MemoryMappedFile> mmapFile(MemoryMappedFile::Create());
     const void* ptr = mmapFile->Open(path, false);
+    mmapFile->Advise(MemoryMappedFileAccessPattern::Sequential);
     md5Builder.Update(ptr, size);
   }
   md5Builder.Final();
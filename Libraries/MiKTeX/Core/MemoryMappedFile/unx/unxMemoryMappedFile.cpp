@@ -1,6 +1,6 @@
 /* unxMemoryMappedFile.cpp:
 
-   Copyright (C) 1996-2021 Christian Schenk
+   Copyright (C) 1996-2022 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -21,6 +21,8 @@
 
 #include "config.h"
 
+#include <algorithm>
+
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -166,3 +168,39 @@ void unxMemoryMappedFile::Flush()
     MIKTEX_FATAL_CRT_ERROR_2("msync", "path", path.ToString());
   }
 }
+
+void unxMemoryMappedFile::Advise(MemoryMappedFileAccessPattern accessPattern)
+{
+  if (ptr == nullptr)
+  {
+    return;
+  }
+  int advice;
+  switch (accessPattern)
+  {
+  case MemoryMappedFileAccessPattern::Sequential:
+    advice = POSIX_MADV_SEQUENTIAL;
+    break;
+  case MemoryMappedFileAccessPattern::Random:
+    advice = POSIX_MADV_RANDOM;
+    break;
+  default:
+    advice = POSIX_MADV_NORMAL;
+    break;
+  }
+  // errors are not fatal: this is a hint
+  posix_madvise(ptr, size, advice);
+}
+
+void unxMemoryMappedFile::Prefetch(size_t offset, size_t length)
+{
+  if (ptr == nullptr || offset >= size)
+  {
+    return;
+  }
+  // the range must start on a page boundary
+  size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t start = offset - offset % pageSize;
+  length = std::min(length + (offset - start), size - start);
+  posix_madvise(reinterpret_cast<char*>(ptr) + start, length, POSIX_MADV_WILLNEED);
+}
@@ -1,6 +1,6 @@
 /* unxMemoryMappedFile.h:                               -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2022 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -65,6 +65,12 @@ public:
 public:
   void Flush() override;
 
+public:
+  void Advise(MiKTeX::Core::MemoryMappedFileAccessPattern accessPattern) override;
+
+public:
+  void Prefetch(size_t offset, size_t length) override;
+
 private:
   void OpenFile();
 
@@ -1,6 +1,6 @@
 /* winMemoryMappedFile.cpp: memory mapped files
 
-   Copyright (C) 1996-2021 Christian Schenk
+   Copyright (C) 1996-2022 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -21,6 +21,8 @@
 
 #include "config.h"
 
+#include <algorithm>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -257,3 +259,34 @@ void winMemoryMappedFile::Flush()
     MIKTEX_FATAL_WINDOWS_ERROR("FlushViewOfFile");
   }
 }
+
+void winMemoryMappedFile::Advise(MemoryMappedFileAccessPattern accessPattern)
+{
+  // Windows has no access pattern hints for mapped views
+  UNUSED_ALWAYS(accessPattern);
+}
+
+void winMemoryMappedFile::Prefetch(size_t offset, size_t length)
+{
+  if (ptr == nullptr || offset >= size)
+  {
+    return;
+  }
+  // PrefetchVirtualMemory() is available since Windows 8
+  struct MemoryRangeEntry
+  {
+    PVOID VirtualAddress;
+    SIZE_T NumberOfBytes;
+  };
+  typedef BOOL(WINAPI* PrefetchVirtualMemoryProc)(HANDLE, ULONG_PTR, MemoryRangeEntry*, ULONG);
+  static PrefetchVirtualMemoryProc prefetchVirtualMemory = reinterpret_cast<PrefetchVirtualMemoryProc>(GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "PrefetchVirtualMemory"));
+  if (prefetchVirtualMemory == nullptr)
+  {
+    return;
+  }
+  MemoryRangeEntry range;
+  range.VirtualAddress = reinterpret_cast<char*>(ptr) + offset;
+  range.NumberOfBytes = std::min(length, size - offset);
+  // errors are not fatal: this is a hint
+  prefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
@@ -1,6 +1,6 @@
 /* winMemoryMappedFile.h: memory mapped files           -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2022 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -67,6 +67,12 @@ public:
 public:
   void MIKTEXTHISCALL Flush() override;
 
+public:
+  void MIKTEXTHISCALL Advise(MiKTeX::Core::MemoryMappedFileAccessPattern accessPattern) override;
+
+public:
+  void MIKTEXTHISCALL Prefetch(size_t offset, size_t length) override;
+
 private:
   void OpenFile();
 
@@ -21,6 +21,8 @@
 
 #include "config.h"
 
+#include <mutex>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -42,6 +44,44 @@ Process::~Process() noexcept
 {
 }
 
+namespace {
+  // keep the most recent records only
+  constexpr size_t MAX_CHILD_PROCESS_RECORDS = 10000;
+  mutex accountingMutex;
+  string accountingJob;
+  vector<ChildProcessRecord> childProcessRecords;
+}
+
+void Process::SetAccountingJob(const string& job)
+{
+  lock_guard<mutex> lockGuard(accountingMutex);
+  accountingJob = job;
+}
+
+vector<ChildProcessRecord> Process::GetChildProcessRecords()
+{
+  lock_guard<mutex> lockGuard(accountingMutex);
+  return childProcessRecords;
+}
+
+MIKTEXINTERNALFUNC(string) GetAccountingJob()
+{
+  lock_guard<mutex> lockGuard(accountingMutex);
+  return accountingJob;
+}
+
+MIKTEXINTERNALFUNC(void) RecordChildProcess(ChildProcessRecord&& record)
+{
+  auto trace_process = TraceStream::Open(MIKTEX_TRACE_PROCESS);
+  trace_process->WriteLine("core", fmt::format("child process {0} ({1}): {2:.3f}s wall, {3:.3f}s CPU", record.systemId, Q_(record.commandLine), chrono::duration<double>(record.wallTime).count(), chrono::duration<double>(record.cpuTime).count()));
+  lock_guard<mutex> lockGuard(accountingMutex);
+  if (childProcessRecords.size() >= MAX_CHILD_PROCESS_RECORDS)
+  {
+    childProcessRecords.erase(childProcessRecords.begin());
+  }
+  childProcessRecords.push_back(move(record));
+}
+
 void Process::Start(const PathName& fileName, const vector<string>& arguments, FILE* pFileStandardInput, FILE** ppFileStandardInput, FILE** ppFileStandardOutput, FILE** ppFileStandardError, const char* workingDirectory)
 {
   MIKTEX_ASSERT_STRING_OR_NIL(workingDirectory);
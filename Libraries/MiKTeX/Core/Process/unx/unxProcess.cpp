@@ -16,7 +16,12 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <fcntl.h>
 #include <signal.h>
+#if defined(HAVE_POSIX_SPAWN)
+#  include <spawn.h>
+#endif
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -170,29 +175,160 @@ private:
     int twofd[2] = { -1, -1 };
 };
 
-tuple<char*, char**> CreateEnvironmentBlock(const unordered_map<string, string>& envMap)
+// envp in a single allocation: the pointers, followed by the strings;
+// entries of overrides replace those of envMap
+unique_ptr<char*[]> CreateEnvironmentBlock(const unordered_map<string, string>& envMap, const unordered_map<string, string>& overrides)
 {
+    size_t count = overrides.size();
     size_t envSize = 0;
     for (const auto& p : envMap)
+    {
+        if (overrides.find(p.first) == overrides.end())
+        {
+            ++count;
+            envSize += p.first.length() + 1 + p.second.length() + 1;
+        }
+    }
+    for (const auto& p : overrides)
     {
         envSize += p.first.length() + 1 + p.second.length() + 1;
     }
-    char* environmentStrings = new char[envSize];
-    char** environmentPointers = new char* [envMap.size() + 1];
-    size_t stringIdx = 0;
+    size_t pointersSize = count + 1;
+    unique_ptr<char*[]> block(new char* [pointersSize + (envSize + sizeof(char*) - 1) / sizeof(char*)]);
+    char** environmentPointers = block.get();
+    char* environmentStrings = reinterpret_cast<char*>(block.get() + pointersSize);
     size_t pointerIdx = 0;
+    auto append = [&](const string& name, const string& value)
+    {
+        environmentPointers[pointerIdx++] = environmentStrings;
+        memcpy(environmentStrings, name.c_str(), name.length());
+        environmentStrings += name.length();
+        *environmentStrings++ = '=';
+        memcpy(environmentStrings, value.c_str(), value.length() + 1);
+        environmentStrings += value.length() + 1;
+    };
     for (const auto& p : envMap)
     {
-        string s = fmt::format("{}={}", p.first, p.second);
-        strcpy(environmentStrings + stringIdx, s.c_str());
-        environmentPointers[pointerIdx] = environmentStrings + stringIdx;
-        stringIdx += s.length() + 1;
-        ++pointerIdx;
+        if (overrides.find(p.first) == overrides.end())
+        {
+            append(p.first, p.second);
+        }
+    }
+    for (const auto& p : overrides)
+    {
+        append(p.first, p.second);
     }
     environmentPointers[pointerIdx] = nullptr;
-    return make_tuple(environmentStrings, environmentPointers);
+    return block;
+}
+
+#if defined(HAVE_POSIX_SPAWN)
+// posix_spawn() does not have to duplicate the page tables of the
+// parent process (which is expensive for engines with big memory
+// arrays); returns 0 or an errno value
+MIKTEXSTATICFUNC(int) Spawn(const ProcessStartInfo& startinfo, const PathName& fileName, const Argv& argv, char** environmentPointers, const Pipe& pipeStdout, const Pipe& pipeStderr, const Pipe& pipeStdin, int fdChildStdin, int fdChildStderr, pid_t& pid)
+{
+    posix_spawn_file_actions_t fileActions;
+    int err = posix_spawn_file_actions_init(&fileActions);
+    if (err != 0)
+    {
+        return err;
+    }
+    MIKTEX_AUTO(posix_spawn_file_actions_destroy(&fileActions));
+    posix_spawnattr_t attr;
+    err = posix_spawnattr_init(&attr);
+    if (err != 0)
+    {
+        return err;
+    }
+    MIKTEX_AUTO(posix_spawnattr_destroy(&attr));
+    // the same redirections as in the fork() case
+    auto dup2Action = [&fileActions](int fd, int fd2)
+    {
+        return posix_spawn_file_actions_adddup2(&fileActions, fd, fd2);
+    };
+    auto closeAction = [&fileActions](int fd)
+    {
+        return fd > filenoStderr ? posix_spawn_file_actions_addclose(&fileActions, fd) : 0;
+    };
+    if (err == 0 && pipeStdout.GetWriteEnd() >= 0)
+    {
+        err = dup2Action(pipeStdout.GetWriteEnd(), filenoStdout);
+    }
+    if (err == 0 && pipeStderr.GetWriteEnd() >= 0)
+    {
+        err = dup2Action(pipeStderr.GetWriteEnd(), filenoStderr);
+    }
+    else if (err == 0 && fdChildStderr >= 0)
+    {
+        err = dup2Action(fdChildStderr, filenoStderr);
+        if (err == 0)
+        {
+            err = closeAction(fdChildStderr);
+        }
+    }
+    if (err == 0 && pipeStdin.GetReadEnd() >= 0)
+    {
+        err = dup2Action(pipeStdin.GetReadEnd(), filenoStdin);
+    }
+    else if (err == 0 && fdChildStdin >= 0)
+    {
+        err = dup2Action(fdChildStdin, filenoStdin);
+        if (err == 0)
+        {
+            err = closeAction(fdChildStdin);
+        }
+    }
+    for (const Pipe* pipe : { &pipeStdout, &pipeStderr, &pipeStdin })
+    {
+        if (err == 0 && pipe->GetReadEnd() >= 0)
+        {
+            err = closeAction(pipe->GetReadEnd());
+        }
+        if (err == 0 && pipe->GetWriteEnd() >= 0)
+        {
+            err = closeAction(pipe->GetWriteEnd());
+        }
+    }
+#if defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP)
+    if (err == 0 && !startinfo.WorkingDirectory.empty())
+    {
+        err = posix_spawn_file_actions_addchdir_np(&fileActions, startinfo.WorkingDirectory.c_str());
+    }
+#endif
+#if defined(POSIX_SPAWN_SETSID)
+    if (err == 0 && startinfo.Daemonize)
+    {
+        err = posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID);
+    }
+#endif
+    if (err != 0)
+    {
+        return err;
+    }
+    return posix_spawn(&pid, fileName.GetData(), &fileActions, &attr, const_cast<char* const*>(argv.GetArgv()), environmentPointers);
 }
 
+// whether the start options can be carried out without running code in
+// the child process
+MIKTEXSTATICFUNC(bool) CanSpawn(const ProcessStartInfo& startinfo)
+{
+#if !defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP)
+    if (!startinfo.WorkingDirectory.empty())
+    {
+        return false;
+    }
+#endif
+#if !defined(POSIX_SPAWN_SETSID)
+    if (startinfo.Daemonize)
+    {
+        return false;
+    }
+#endif
+    return true;
+}
+#endif
+
 unique_ptr<Process> Process::Start(const ProcessStartInfo& startinfo)
 {
     return make_unique<unxProcess>(startinfo);
@@ -259,26 +395,47 @@ void unxProcess::Create()
     else if (startinfo.RedirectStandardInput)
     {
         pipeStdin.Create();
+#if defined(F_SETPIPE_SZ)
+        if (startinfo.StandardInputPipeSize > 0)
+        {
+            // not fatal: the default size will do
+            fcntl(pipeStdin.GetWriteEnd(), F_SETPIPE_SZ, static_cast<int>(startinfo.StandardInputPipeSize));
+        }
+#endif
     }
 
     tmpFile = TemporaryFile::Create();
 
-    unordered_map<string, string> envMap = session->CreateChildEnvironment(!startinfo.WorkingDirectory.empty());
-    envMap[MIKTEX_ENV_EXCEPTION_PATH] = tmpFile->GetPathName().ToString();
-    char* environmentStrings;
-    char** environmentPointers;
-    tie(environmentStrings, environmentPointers) = CreateEnvironmentBlock(envMap);
-    MIKTEX_AUTO(delete[]environmentStrings);
-    MIKTEX_AUTO(delete[]environmentPointers);
+    auto envMap = session->CreateChildEnvironment(!startinfo.WorkingDirectory.empty());
+    unique_ptr<char*[]> environmentBlock = CreateEnvironmentBlock(*envMap, { { MIKTEX_ENV_EXCEPTION_PATH, tmpFile->GetPathName().ToString() } });
+    char** environmentPointers = environmentBlock.get();
 
     session->UnloadFilenameDatabase();
 
-    // fork
-    trace_process->WriteLine("core", TraceLevel::Info, "forking...");
-    pid = fork();
-    if (pid < 0)
+#if defined(HAVE_POSIX_SPAWN)
+    if (CanSpawn(startinfo))
     {
-        MIKTEX_FATAL_CRT_ERROR("fork");
+        trace_process->WriteLine("core", TraceLevel::Info, "spawning...");
+        int err = Spawn(startinfo, fileName, argv, environmentPointers, pipeStdout, pipeStderr, pipeStdin, fdChildStdin, fdChildStderr, pid);
+        if (err != 0)
+        {
+            // behave like a child which could not execute the file
+            trace_process->WriteLine("core", TraceLevel::Error, fmt::format("posix_spawn {0} failed: {1}", Q_(fileName), strerror(err)));
+            pid = -1;
+            status = 127 << 8;
+            MIKTEX_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 127);
+        }
+    }
+    else
+#endif
+    {
+        // fork
+        trace_process->WriteLine("core", TraceLevel::Info, "forking...");
+        pid = fork();
+        if (pid < 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR("fork");
+        }
     }
 
     if (pid == 0)
@@ -331,7 +488,9 @@ void unxProcess::Create()
         _exit(127);
     }
 
-    MIKTEX_ASSERT(pid > 0);
+    startTime = chrono::steady_clock::now();
+    commandLine = CommandLineBuilder(argv.ToStringVector()).ToString();
+    job = GetAccountingJob();
 
     if (startinfo.RedirectStandardOutput)
     {
@@ -392,6 +551,11 @@ void unxProcess::Close()
         close(fdStandardInput);
         fdStandardInput = -1;
     }
+    if (this->pid > 0)
+    {
+        // not waited for
+        Account(this->pid, nullptr);
+    }
     this->pid = -1;
     if (tmpFile != nullptr)
     {
@@ -453,13 +617,15 @@ void unxProcess::WaitForExit()
         trace_process->WriteLine("core", fmt::format("waiting for process {0}", this->pid));
         pid_t pid = this->pid;
         this->pid = -1;
-        while (waitpid(pid, &status, 0) <= 0)
+        struct rusage usage;
+        while (wait4(pid, &status, 0, &usage) <= 0)
         {
             if (errno != EINTR)
             {
-                MIKTEX_FATAL_CRT_ERROR("waitpid");
+                MIKTEX_FATAL_CRT_ERROR("wait4");
             }
         }
+        Account(pid, &usage);
         if (WIFEXITED(status) != 0)
         {
             trace_process->WriteLine("core", fmt::format("process {0} exited with status {1}", pid, WEXITSTATUS(status)));
@@ -479,16 +645,18 @@ bool unxProcess::WaitForExit(int milliseconds)
     }
     do
     {
-        pid_t pid = waitpid(this->pid, &status, WNOHANG);
+        struct rusage usage;
+        pid_t pid = wait4(this->pid, &status, WNOHANG, &usage);
         if (pid == this->pid)
         {
             this->pid = -1;
+            Account(pid, &usage);
             return true;
         }
         else if (pid < 0)
         {
             this->pid = -1;
-            MIKTEX_FATAL_CRT_ERROR("waitpid");
+            MIKTEX_FATAL_CRT_ERROR("wait4");
         }
         MIKTEX_ASSERT(pid == 0);
         this_thread::sleep_for(chrono::milliseconds(1));
@@ -497,6 +665,26 @@ bool unxProcess::WaitForExit(int milliseconds)
     return false;
 }
 
+void unxProcess::Account(pid_t pid, const struct rusage* usage)
+{
+    ChildProcessRecord record;
+    record.commandLine = commandLine;
+    record.job = job;
+    record.systemId = pid;
+    record.wallTime = chrono::steady_clock::now() - startTime;
+    if (usage != nullptr)
+    {
+        record.exitStatus = get_ExitStatus();
+        record.exitCode = WIFEXITED(status) != 0 ? WEXITSTATUS(status) : -1;
+        auto toNanoseconds = [](const struct timeval& tv)
+        {
+            return chrono::seconds(tv.tv_sec) + chrono::microseconds(tv.tv_usec);
+        };
+        record.cpuTime = toNanoseconds(usage->ru_utime) + toNanoseconds(usage->ru_stime);
+    }
+    RecordChildProcess(move(record));
+}
+
 ProcessExitStatus unxProcess::get_ExitStatus() const
 {
     if (WIFEXITED(status) != 0)
@@ -819,12 +1007,9 @@ void Process::Overlay(const PathName& fileName, const vector<string>& arguments)
         trace_process->WriteLine("core", TraceLevel::Info, fmt::format(" argv[{0}]: {1}", idx, argv[idx]));
     }
     shared_ptr<SessionImpl> session = SESSION_IMPL();
-    unordered_map<string, string> envMap = session->CreateChildEnvironment(false);
-    char* environmentStrings;
-    char** environmentPointers;
-    tie(environmentStrings, environmentPointers) = CreateEnvironmentBlock(envMap);
-    MIKTEX_AUTO(delete[]environmentStrings);
-    MIKTEX_AUTO(delete[]environmentPointers);
+    auto envMap = session->CreateChildEnvironment(false);
+    unique_ptr<char*[]> environmentBlock = CreateEnvironmentBlock(*envMap, {});
+    char** environmentPointers = environmentBlock.get();
     session->UnloadFilenameDatabase();
     execve(fileName.GetData(), const_cast<char* const*>(argv.GetArgv()), const_cast<char* const*>(environmentPointers));
 
@@ -16,7 +16,11 @@
 #if !defined(B6278A08DFEE4038A08449DD17C4E3D3)
 #define B6278A08DFEE4038A08449DD17C4E3D3
 
+#include <sys/resource.h>
+
+#include <chrono>
 #include <memory>
+#include <string>
 
 #include <miktex/Core/Process>
 #include <miktex/Core/TemporaryFile>
@@ -67,6 +71,8 @@ private:
 
     void Create();
 
+    void Account(pid_t pid, const struct rusage* usage);
+
     int fdStandardError = -1;
     int fdStandardInput = -1;
     int fdStandardOutput = -1;
@@ -77,6 +83,9 @@ private:
     MiKTeX::Core::ProcessStartInfo startinfo;
     int status;
     std::unique_ptr<MiKTeX::Core::TemporaryFile> tmpFile;
+    std::chrono::steady_clock::time_point startTime;
+    std::string commandLine;
+    std::string job;
 
     friend class MiKTeX::Core::Process;
 };
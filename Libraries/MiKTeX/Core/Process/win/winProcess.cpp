@@ -243,7 +243,7 @@ void winProcess::Create()
 #endif
       // create child stdin pipe
       AutoHANDLE hStdinWr;
-      if (!CreatePipe(&hChildStdin, &hStdinWr, const_cast<LPSECURITY_ATTRIBUTES>(&SAPIPE), PIPE_BUF_SIZE))
+      if (!CreatePipe(&hChildStdin, &hStdinWr, const_cast<LPSECURITY_ATTRIBUTES>(&SAPIPE), startinfo.StandardInputPipeSize > 0 ? static_cast<unsigned long>(startinfo.StandardInputPipeSize) : PIPE_BUF_SIZE))
       {
         MIKTEX_FATAL_WINDOWS_ERROR_2("CreatePipe", "processFileName", startinfo.FileName, "commandLine", commandLine.ToString());
       }
@@ -280,28 +280,30 @@ void winProcess::Create()
     trace_process->WriteLine("core", TraceLevel::Info, fmt::format("start process: {0}", commandLine.ToString()));
 
     // create environment map
-    unordered_map<string, string> envMap = session->CreateChildEnvironment(!startinfo.WorkingDirectory.empty());
+    auto envMap = session->CreateChildEnvironment(!startinfo.WorkingDirectory.empty());
 
     tmpFile = TemporaryFile::Create();
-    envMap[MIKTEX_ENV_EXCEPTION_PATH] = tmpFile->GetPathName().ToString();
+    string exceptionPath = tmpFile->GetPathName().ToString();
 
-    // create environment strings
-    size_t envSize = 0;
-    for (const auto& p : envMap)
+    // create environment strings in one go
+    wstring environmentBlock;
+    auto append = [&environmentBlock](const string& name, const string& value)
     {
-      envSize += p.first.length() + 1 + p.second.length() + 1;
-    }
-    envSize += 1;
-    wchar_t* environmentStrings = new wchar_t[envSize];
-    MIKTEX_AUTO(delete[]environmentStrings);
-    size_t stringIdx = 0;
-    for (const auto& p : envMap)
-    {
-      wstring s = fmt::format(L"{}={}"s, UW_(p.first), UW_(p.second));
-      wcscpy_s(environmentStrings + stringIdx, envSize - stringIdx, s.c_str());
-      stringIdx += s.length() + 1;
+      environmentBlock += UW_(name);
+      environmentBlock += L'=';
+      environmentBlock += UW_(value);
+      environmentBlock += wchar_t();
+    };
+    for (const auto& p : *envMap)
+    {
+      if (p.first != MIKTEX_ENV_EXCEPTION_PATH)
+      {
+        append(p.first, p.second);
+      }
     }
-    environmentStrings[stringIdx] = wchar_t();
+    append(MIKTEX_ENV_EXCEPTION_PATH, exceptionPath);
+    environmentBlock += wchar_t();
+    wchar_t* environmentStrings = &environmentBlock[0];
 
     session->UnloadFilenameDatabase();
 
@@ -310,6 +312,10 @@ void winProcess::Create()
       MIKTEX_FATAL_WINDOWS_ERROR_2("CreateProcess", "fileName", startinfo.FileName, "commandLine", commandLine.ToString());
     }
     processStarted = true;
+    accountingPending = true;
+    startTime = chrono::steady_clock::now();
+    accountingCommandLine = commandLine.ToString();
+    accountingJob = GetAccountingJob();
   }
 
   catch (const exception&)
@@ -394,6 +400,10 @@ void winProcess::Close()
   }
   if (processStarted)
   {
+    if (accountingPending)
+    {
+      Account(WaitForSingleObject(processInformation.hProcess, 0) == WAIT_OBJECT_0);
+    }
     processStarted = false;
     CloseHandle(processInformation.hProcess);
     if (processInformation.hThread != nullptr)
@@ -471,11 +481,52 @@ FILE* winProcess::get_StandardError()
 void winProcess::WaitForExit()
 {
   WaitForSingleObject(processInformation.hProcess, INFINITE);
+  if (accountingPending)
+  {
+    Account(true);
+  }
 }
 
 bool winProcess::WaitForExit(int milliseconds)
 {
-  return WaitForSingleObject(processInformation.hProcess, static_cast<DWORD>(milliseconds)) == WAIT_OBJECT_0;
+  if (WaitForSingleObject(processInformation.hProcess, static_cast<DWORD>(milliseconds)) != WAIT_OBJECT_0)
+  {
+    return false;
+  }
+  if (accountingPending)
+  {
+    Account(true);
+  }
+  return true;
+}
+
+void winProcess::Account(bool exited)
+{
+  accountingPending = false;
+  ChildProcessRecord record;
+  record.commandLine = accountingCommandLine;
+  record.job = accountingJob;
+  record.systemId = static_cast<int>(processInformation.dwProcessId);
+  record.wallTime = chrono::steady_clock::now() - startTime;
+  if (exited)
+  {
+    DWORD exitCode;
+    if (GetExitCodeProcess(processInformation.hProcess, &exitCode))
+    {
+      record.exitStatus = exitCode < 128 ? ProcessExitStatus::Exited : ProcessExitStatus::Other;
+      record.exitCode = static_cast<int>(exitCode);
+    }
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (GetProcessTimes(processInformation.hProcess, &creationTime, &exitTime, &kernelTime, &userTime))
+    {
+      auto to100ns = [](const FILETIME& ft)
+      {
+        return (static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+      };
+      record.cpuTime = chrono::nanoseconds((to100ns(kernelTime) + to100ns(userTime)) * 100);
+    }
+  }
+  RecordChildProcess(move(record));
 }
 
 ProcessExitStatus winProcess::get_ExitStatus() const
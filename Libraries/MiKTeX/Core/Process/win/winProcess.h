@@ -21,7 +21,9 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <string>
 
 #include <miktex/Core/Process>
 #include <miktex/Core/TemporaryFile>
@@ -82,6 +84,9 @@ public:
 private:
   void Create();
 
+private:
+  void Account(bool exited);
+
 private:
   MiKTeX::Core::ProcessStartInfo startinfo;
 
@@ -107,6 +112,18 @@ private:
 private:
   std::unique_ptr<MiKTeX::Core::TemporaryFile> tmpFile;
 
+private:
+  bool accountingPending = false;
+
+private:
+  std::chrono::steady_clock::time_point startTime;
+
+private:
+  std::string accountingCommandLine;
+
+private:
+  std::string accountingJob;
+
 private:
   static PROCESSENTRY32W GetProcessEntry(DWORD processId);
 
@@ -24,10 +24,14 @@
 #if !defined(INTERNAL_CORE_SESSION_SESSIONIMPL_H)
 #define INTERNAL_CORE_SESSION_SESSIONIMPL_H
 
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <fstream>
 #include <map>
+#include <mutex>
 #include <set>
+#include <shared_mutex>
 
 #if defined(HAVE_ATLBASE_H)
 #  define _ATL_FREE_THREADED
@@ -42,7 +46,9 @@
 #include "core-version.h"
 
 #include <miktex/Core/Cfg>
+#include <miktex/Core/DirectoryLister>
 #include <miktex/Core/FileSystemWatcher>
+#include <miktex/Core/MemoryMappedFile>
 #include <miktex/Core/Session>
 #include <miktex/Core/Stream>
 #include <miktex/Core/equal_icase>
@@ -111,7 +117,9 @@ inline bool operator<(const LanguageInfo_& lhs, const LanguageInfo_& rhs)
 struct InternalFileTypeInfo :
   public MiKTeX::Core::FileTypeInfo
 {
+  // the expanded search path; valid if havePathPatterns is set
   std::vector<MiKTeX::Util::PathName> pathPatterns;
+  bool havePathPatterns = false;
 };
 
 struct DvipsPaperSizeInfo :
@@ -321,6 +329,9 @@ public:
 public:
   void RecordFileInfo(const MiKTeX::Util::PathName& path, MiKTeX::Core::FileAccess access) override;
 
+private:
+  std::size_t RecordFileInfo(const MiKTeX::Util::PathName& path, MiKTeX::Core::FileAccess access, std::chrono::steady_clock::duration openTime);
+
 public:
   std::vector<MiKTeX::Core::FileInfoRecord> GetFileInfoRecords() override;
 
@@ -330,6 +341,12 @@ public:
 public:
   MiKTeX::Core::LocateResult MIKTEXTHISCALL Locate(const std::string& fileName, const MiKTeX::Core::LocateOptions& options) override;
 
+public:
+  std::vector<MiKTeX::Core::LocateResult> MIKTEXTHISCALL FindFiles(const std::vector<std::string>& fileNames, const MiKTeX::Core::LocateOptions& options) override;
+
+public:
+  MiKTeX::Core::LocateStatistics MIKTEXTHISCALL GetLocateStatistics() override;
+
 public:
   bool FindFile(const std::string& fileName, const std::string& searchPath, FindFileOptionSet options, std::vector<MiKTeX::Util::PathName>& result) override;
 
@@ -414,6 +431,21 @@ public:
 public:
   bool GetFontInfo(const std::string& fontName, std::string& supplier, std::string& typeface, double* genSize) override;
 
+public:
+  std::vector<MiKTeX::Core::FontInfo> GetFontInfos(const std::vector<std::string>& fontNames) override;
+
+public:
+  bool GetFontMetrics(const std::string& fontName, std::uint32_t checkSum, MiKTeX::Core::FontMetrics& metrics) override;
+
+public:
+  void WriteFontMapIndex(const MiKTeX::Util::PathName& mapFile) override;
+
+public:
+  MiKTeX::Core::FontMapIndexLookup LookupFontMapIndex(const std::string& mapFileName, const std::string& fontName, std::vector<std::string>& lines) override;
+
+public:
+  bool ReduceBibDatabase(const std::string& database, const std::vector<std::string>& citeKeys, std::string& reduced) override;
+
 public:
   MiKTeX::Util::PathName GetGhostscript(unsigned long* versionNumber) override;
 
@@ -771,6 +803,9 @@ private:
 private:
   std::vector<MiKTeX::Util::PathName> GetDirectoryPatterns(MiKTeX::Core::FileType fileType);
 
+private:
+  std::vector<MiKTeX::Util::PathName> MakeDirectoryPatterns(const InternalFileTypeInfo& fti);
+
 private:
   void TraceDirectoryPatterns(const std::string& fileType, const std::vector<MiKTeX::Util::PathName>& pathPatterns);
 
@@ -780,6 +815,67 @@ private:
 private:
   void UnregisterLibraryTraceStreams();
 
+private:
+  struct FontMap
+  {
+    MiKTeX::Util::PathName path;
+    time_t lastWriteTime = 0;
+    // tokenized lines
+    std::vector<std::vector<std::string>> lines;
+    // first token => index of the first line with at least two tokens
+    std::unordered_map<std::string, std::size_t> index;
+  };
+
+  // loads the font map, unless it has been loaded and is unchanged
+private:
+  const FontMap& GetFontMap(const std::string& fileName);
+
+  // font map file name => parsed font map
+private:
+  std::unordered_map<std::string, FontMap> fontMaps;
+
+  // the directories holding font metric cache files, in search order:
+  // the first one is written to
+private:
+  std::vector<MiKTeX::Util::PathName> GetFontMetricCacheDirectories();
+
+private:
+  bool ReadFontMetricCacheFile(const MiKTeX::Util::PathName& path, std::uint32_t checkSum, MiKTeX::Core::FontMetrics& metrics);
+
+private:
+  void WriteFontMetricCacheFile(const MiKTeX::Util::PathName& path, const MiKTeX::Core::FontMetrics& metrics);
+
+  // font name and checksum => character dimensions; fonts are loaded by
+  // several threads (e.g., the page loaders of libdvi)
+private:
+  std::unordered_map<std::string, MiKTeX::Core::FontMetrics> fontMetrics;
+
+private:
+  std::mutex fontMetricsMutex;
+
+private:
+  struct FontMapIndex
+  {
+    std::unique_ptr<MiKTeX::Core::MemoryMappedFile> mapping;
+    const unsigned char* data = nullptr;
+    std::size_t size = 0;
+    std::uint32_t tableSize = 0;
+  };
+
+  // maps the index of the font map, unless it is missing or outdated
+private:
+  std::shared_ptr<FontMapIndex> OpenFontMapIndex(const std::string& mapFileName);
+
+  // font map file name => mapped index (nullptr, if there is none)
+private:
+  std::unordered_map<std::string, std::shared_ptr<FontMapIndex>> fontMapIndexes;
+
+private:
+  std::mutex fontMapIndexesMutex;
+
+private:
+  MiKTeX::Util::PathName GetBibIndexCacheDirectory();
+
 private:
   bool FindInTypefaceMap(const std::string& fontName, std::string& typeface);
 
@@ -798,26 +894,109 @@ private:
 private:
   bool FindFileInDirectories(const std::string& fileName, const std::vector<MiKTeX::Util::PathName>& pathPatterns, bool all, bool useFndb, bool searchFileSystem, std::vector<MiKTeX::Util::PathName>& result, MiKTeX::Core::IFindFileCallback* callback);
 
+private:
+  MiKTeX::Core::LocateResult LocateInternal(const std::string& givenFileName, const std::vector<MiKTeX::Util::PathName>& pathPatterns, const MiKTeX::Core::LocateOptions& options);
+
+private:
+  MiKTeX::Core::LocateResult LocateTimed(const std::string& givenFileName, const std::vector<MiKTeX::Util::PathName>& pathPatterns, const MiKTeX::Core::LocateOptions& options);
+
 private:
   bool FindFileByType(const std::string& fileName, MiKTeX::Core::FileType fileType, bool all, bool tryHard, bool create, bool renew, std::vector<MiKTeX::Util::PathName>& result, MiKTeX::Core::IFindFileCallback* callback);
 
+private:
+  MiKTeX::Util::PathName GetSharedCacheEntryPath(const MiKTeX::Util::PathName& cacheDirectory, const std::string& fileName, MiKTeX::Core::FileType fileType);
+
+private:
+  bool TryGetFromSharedCache(const std::string& fileName, MiKTeX::Core::FileType fileType);
+
+private:
+  void PutIntoSharedCache(const std::string& fileName, MiKTeX::Core::FileType fileType, const MiKTeX::Util::PathName& path);
+
 private:
   bool SearchFileSystem(const std::string& fileName, const char* dirPath, bool all, std::vector<MiKTeX::Util::PathName>& result, MiKTeX::Core::IFindFileCallback* callback);
 
+private:
+  const PathPattern& GetCompiledPathPattern(const MiKTeX::Util::PathName& pathPattern);
+
+private:
+  std::string MakeNegativeLookupKey(const std::string& fileName, const std::vector<MiKTeX::Util::PathName>& pathPatterns, MiKTeX::Core::IFindFileCallback* callback);
+
+private:
+  bool IsKnownMissing(const std::string& negativeLookupKey);
+
+private:
+  void RememberMissing(const std::string& negativeLookupKey);
+
 private:
   bool CheckCandidate(MiKTeX::Util::PathName& path, const char* fileInfo, MiKTeX::Core::IFindFileCallback* callback);
 
+  /// Gets a configuration value.  Results obtained without a
+  /// callback are memoized until the configuration generation changes.
 private:
   bool GetSessionValue(const std::string& sectionName, const std::string& valueName, std::string& value, MiKTeX::Configuration::HasNamedValues* callback);
 
+private:
+  bool LookupSessionValue(const std::string& sectionName, const std::string& valueName, std::string& value, MiKTeX::Configuration::HasNamedValues* callback);
+
+  /// Invalidates memoized configuration values.  To be called when
+  /// configuration files, environment variables, application names
+  /// or the administrator mode change.
+public:
+  static void BumpConfigGeneration()
+  {
+    ++configGeneration;
+  }
+
 private:
   void ReadAllConfigFiles(const std::string& baseName, MiKTeX::Core::Cfg& cfg);
 
+private:
+  MiKTeX::Util::PathName GetConfigSnapshotPath(const std::string& baseName);
+
+  /// Fills `cfg` from the configuration snapshot, if the snapshot is
+  /// up-to-date with respect to `configFiles`.
+private:
+  bool ReadConfigSnapshot(const std::string& baseName, const std::vector<MiKTeX::Util::PathName>& configFiles, MiKTeX::Core::Cfg& cfg);
+
+private:
+  void WriteConfigSnapshot(const std::string& baseName, const std::vector<MiKTeX::Util::PathName>& configFiles, MiKTeX::Core::Cfg& cfg);
+
 private:
   std::deque<MiKTeX::Util::PathName> inputDirectories;
 
+  /// Gets the environment for child processes.
+  ///
+  /// The result is cached: it is recomputed only if the environment of
+  /// this process, the list of working directories or the admin mode
+  /// has changed since the last call.
 public:
-  std::unordered_map<std::string, std::string> CreateChildEnvironment(bool changeDirectory);
+  std::shared_ptr<const std::unordered_map<std::string, std::string>> CreateChildEnvironment(bool changeDirectory);
+
+  /// The environment of this process: "NAME=value\0NAME=value\0...".
+private:
+#if defined(MIKTEX_WINDOWS)
+  typedef std::wstring EnvironmentStrings;
+#else
+  typedef std::string EnvironmentStrings;
+#endif
+
+private:
+  std::unordered_map<std::string, std::string> MakeChildEnvironment(const EnvironmentStrings& environmentStrings, const std::string& cwdList);
+
+private:
+  struct ChildEnvironmentCache
+  {
+    EnvironmentStrings environmentStrings;
+    std::string cwdList;
+    bool adminMode = false;
+    std::shared_ptr<const std::unordered_map<std::string, std::string>> envMap;
+  };
+
+private:
+  std::mutex childEnvironmentMutex;
+
+private:
+  ChildEnvironmentCache childEnvironmentCache;
 
 private:
   std::vector<MiKTeX::Util::PathName> GetFilenameDatabasePathNames(unsigned r);
@@ -828,6 +1007,11 @@ private:
 private:
   bool IsMpmFile(const char* path);
 
+  /// Looks up the package which contains a TEXMF file.  The MPM FNDB
+  /// maps file names to package IDs, so this is a hash probe.
+private:
+  bool TryGetPackageOfFile(const MiKTeX::Util::PathName& relativePath, std::string& packageId);
+
 public:
   unsigned GetDataRoot();
 
@@ -985,6 +1169,9 @@ private:
 private:
   void DirectoryWalk(const MiKTeX::Util::PathName& directory, const MiKTeX::Util::PathName& pathPattern, std::vector<MiKTeX::Util::PathName>& paths);
 
+private:
+  void DirectoryWalk(const MiKTeX::Util::PathName& directory, const MiKTeX::Util::PathName& pathPattern, std::vector<MiKTeX::Util::PathName>& paths, const std::vector<MiKTeX::Core::DirectoryEntry>& subdirEntries);
+
 private:
   void ExpandBraces(const std::string& toBeExpanded, std::vector<MiKTeX::Util::PathName>& paths);
 
@@ -1022,11 +1209,51 @@ private:
   MiKTeX::Core::VersionNumber gsVersion;
 
 private:
-  MiKTeX::Core::IFindFileCallback* findFileCallback = nullptr;
+  std::atomic<MiKTeX::Core::IFindFileCallback*> findFileCallback{ nullptr };
+
+  // search statistics (see GetLocateStatistics())
+private:
+  std::atomic<std::size_t> locateCount{ 0 };
+
+private:
+  std::atomic<std::chrono::steady_clock::rep> locateTicks{ 0 };
+
+private:
+  std::atomic<std::size_t> missCount{ 0 };
+
+private:
+  std::atomic<std::chrono::steady_clock::rep> missTicks{ 0 };
+
+private:
+  std::atomic<std::size_t> installationCount{ 0 };
+
+private:
+  std::atomic<std::chrono::steady_clock::rep> installationTicks{ 0 };
+
+private:
+  struct LookupRecord
+  {
+    MiKTeX::Core::FileLookupSource source = MiKTeX::Core::FileLookupSource::None;
+    std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero();
+  };
+
+private:
+  // the searches of the files which have not been opened yet; taken
+  // over by the file information records
+  std::unordered_map<std::string, LookupRecord> pendingLookups;
+
+private:
+  std::mutex pendingLookupsMutex;
 
 private:
   std::vector<InternalFileTypeInfo> fileTypes;
 
+  // guards the session state which is built on demand by lookups
+  // (file type information, configuration settings); recursive,
+  // because building one part might require another
+private:
+  std::recursive_mutex lazyStateMutex;
+
 private:
   std::vector<MiKTeX::Core::MIKTEXMFMODE> metafontModes;
 
@@ -1035,6 +1262,7 @@ private:
     public MiKTeX::Core::Session::OpenFileInfo
   {
     std::unique_ptr<MiKTeX::Core::Process> process;
+    std::size_t fileInfoRecordIndex = SIZE_MAX;
   };
 
 private:
@@ -1048,6 +1276,19 @@ private:
 private:
   SearchPathDictionary expandedPathPatterns;
 
+private:
+  // caching compiled path patterns (for FNDB searches)
+  std::unordered_map<std::string, std::unique_ptr<PathPattern>> compiledPathPatterns;
+
+private:
+  // caching unsuccessful FNDB searches; the value is the FNDB generation
+  std::unordered_map<std::string, unsigned> negativeLookups;
+
+  // guards expandedPathPatterns, compiledPathPatterns and
+  // negativeLookups
+private:
+  std::shared_mutex lookupCachesMutex;
+
 private:
   // file access history
   std::vector<MiKTeX::Core::FileInfoRecord> fileInfoRecords;
@@ -1076,6 +1317,33 @@ private:
 private:
   ConfigurationSettings configurationSettings;
 
+private:
+  static std::atomic_uint configGeneration;
+
+private:
+  struct MemoizedValue
+  {
+    bool haveValue;
+    std::string value;
+  };
+
+  // lower-cased "[section]value" => result of LookupSessionValue()
+private:
+  std::unordered_map<std::string, MemoizedValue> memoizedValues;
+
+private:
+  unsigned memoizedValuesGeneration = 0;
+
+  // guards memoizedValues and memoizedValuesGeneration
+private:
+  std::shared_mutex memoizedValuesMutex;
+
+private:
+  std::atomic<std::size_t> memoizedValueHits{ 0 };
+
+private:
+  std::atomic<std::size_t> memoizedValueMisses{ 0 };
+
 private:
   std::vector<FormatInfo_> formats;
 
@@ -1211,9 +1479,16 @@ private:
 private:
   void StartFinishScript(int delay);
 
+  // starts the file system watcher when the first FNDB is loaded
+private:
+  std::shared_ptr<MiKTeX::Core::FileSystemWatcher> GetFileSystemWatcher();
+
 private:
   std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher;
 
+private:
+  bool haveFileSystemWatcher = false;
+
 private:
   // indicates whether the session has been initialized
   bool initialized = false;
@@ -0,0 +1,82 @@
+/* WorkingDirectoryContext.cpp: per-thread working directories
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/Debug>
+#include <miktex/Core/WorkingDirectoryContext>
+
+#include "internal.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+static thread_local const WorkingDirectoryContext* currentContext = nullptr;
+
+class WorkingDirectoryContext::impl
+{
+public:
+  PathName workingDirectory;
+public:
+  vector<PathName> inputDirectories;
+public:
+  const WorkingDirectoryContext* previous = nullptr;
+};
+
+WorkingDirectoryContext::WorkingDirectoryContext(const PathName& workingDirectory, const vector<PathName>& inputDirectories) :
+  pimpl(new impl{ workingDirectory, inputDirectories, currentContext })
+{
+  if (!workingDirectory.IsAbsolute())
+  {
+    INVALID_ARGUMENT("workingDirectory", workingDirectory.ToString());
+  }
+  for (const PathName& dir : inputDirectories)
+  {
+    if (!dir.IsAbsolute())
+    {
+      INVALID_ARGUMENT("inputDirectories", dir.ToString());
+    }
+  }
+  currentContext = this;
+}
+
+WorkingDirectoryContext::~WorkingDirectoryContext() noexcept
+{
+  MIKTEX_ASSERT(currentContext == this);
+  currentContext = pimpl->previous;
+}
+
+const PathName& WorkingDirectoryContext::GetWorkingDirectory() const
+{
+  return pimpl->workingDirectory;
+}
+
+const vector<PathName>& WorkingDirectoryContext::GetInputDirectories() const
+{
+  return pimpl->inputDirectories;
+}
+
+const WorkingDirectoryContext* WorkingDirectoryContext::GetCurrent()
+{
+  return currentContext;
+}
@@ -63,6 +63,7 @@ void SessionImpl::PushAppName(const string& name)
   }
   fileTypes.clear();
   applicationNames = newApplicationNames;
+  BumpConfigGeneration();
   trace_config->WriteLine("core", T_("application tags: ") + applicationNames);
 }
 
@@ -91,5 +92,6 @@ void SessionImpl::PushBackAppName(const string& name)
     return;
   }
   applicationNames = newApplicationNames;
+  BumpConfigGeneration();
   trace_config->WriteLine("core", T_("application tags: ") + applicationNames);
 }
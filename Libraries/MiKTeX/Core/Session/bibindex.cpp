@@ -0,0 +1,544 @@
+/* bibindex.cpp: BibTeX database indexes
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <unordered_set>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/MD5>
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Core/Paths>
+#include <miktex/Core/TemporaryFile>
+
+#include "internal.h"
+
+#include "Session/SessionImpl.h"
+
+using namespace std;
+
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+/*
+ * A BibTeX database index is written to the cache directory; the file
+ * name is the MD5 of the database contents:
+ *
+ *   signature version flags numRecords
+ *   { kind begin end keyLength key crossrefLength crossref }
+ *
+ * A record describes an @string command, a @preamble command or an
+ * entry: [begin, end) is the extent of the command in the database.
+ * Keys and crossref values are stored in lower case.  Numbers are
+ * stored as 32-bit words.
+ *
+ * A database is reducible only if it is parsed the way BibTeX parses
+ * it: anything unusual (syntax errors, control characters, computed
+ * crossref values) makes BibTeX read the whole database.
+ */
+
+const uint32_t BIB_INDEX_SIGNATURE = 0x58424d4d; // 'MMBX' (the x86 way)
+const uint32_t BIB_INDEX_VERSION = 1;
+
+const uint32_t BIB_INDEX_NOT_REDUCIBLE = 1;
+
+const uint32_t BIB_RECORD_ENTRY = 0;
+const uint32_t BIB_RECORD_STRING = 1;
+const uint32_t BIB_RECORD_PREAMBLE = 2;
+
+struct BibIndexRecord
+{
+  uint32_t kind = BIB_RECORD_ENTRY;
+  uint32_t begin = 0;
+  uint32_t end = 0;
+  string key;
+  string crossref;
+};
+
+MIKTEXSTATICFUNC(bool) IsBibWhite(char ch)
+{
+  return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+// see the lex_class and id_class tables of bibtex.web
+MIKTEXSTATICFUNC(bool) IsBibIdChar(char ch)
+{
+  unsigned char uch = static_cast<unsigned char>(ch);
+  return uch > ' ' && uch != 127 && strchr("\"#%'(),={}", ch) == nullptr;
+}
+
+MIKTEXSTATICFUNC(bool) IsBibDigit(char ch)
+{
+  return ch >= '0' && ch <= '9';
+}
+
+MIKTEXSTATICFUNC(string) BibLowerCase(string s)
+{
+  for (char& ch : s)
+  {
+    if (ch >= 'A' && ch <= 'Z')
+    {
+      ch = ch - 'A' + 'a';
+    }
+  }
+  return s;
+}
+
+MIKTEXSTATICFUNC(bool) HasNonAsciiChars(const string& s)
+{
+  for (char ch : s)
+  {
+    if (static_cast<unsigned char>(ch) >= 128)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+MIKTEXSTATICFUNC(bool) ScanBibDatabase(const string& text, vector<BibIndexRecord>& records)
+{
+  size_t length = text.length();
+  if (length > UINT32_MAX)
+  {
+    return false;
+  }
+  for (char ch : text)
+  {
+    unsigned char uch = static_cast<unsigned char>(ch);
+    if ((uch < ' ' && !IsBibWhite(ch)) || uch == 127)
+    {
+      return false;
+    }
+  }
+  size_t pos = 0;
+  auto skipWhite = [&]()
+  {
+    while (pos < length && IsBibWhite(text[pos]))
+    {
+      ++pos;
+    }
+  };
+  auto scanIdentifier = [&]()
+  {
+    size_t start = pos;
+    while (pos < length && IsBibIdChar(text[pos]))
+    {
+      ++pos;
+    }
+    return text.substr(start, pos - start);
+  };
+  // a brace group or a quoted string; braces must be balanced
+  auto scanDelimited = [&](char closing)
+  {
+    int depth = 0;
+    for (++pos; pos < length; ++pos)
+    {
+      char ch = text[pos];
+      if (ch == '{')
+      {
+        ++depth;
+      }
+      else if (ch == '}' && depth > 0)
+      {
+        --depth;
+      }
+      else if (ch == '}' || (ch == closing && depth == 0))
+      {
+        ++pos;
+        return ch == closing;
+      }
+    }
+    return false;
+  };
+  // token { # token }; a crossref value must be a single string
+  auto scanValue = [&](string* str)
+  {
+    while (true)
+    {
+      skipWhite();
+      if (pos >= length)
+      {
+        return false;
+      }
+      size_t start = pos;
+      char ch = text[pos];
+      bool isString = ch == '{' || ch == '"';
+      if (isString)
+      {
+        if (!scanDelimited(ch == '{' ? '}' : '"'))
+        {
+          return false;
+        }
+      }
+      else if (IsBibDigit(ch))
+      {
+        while (pos < length && IsBibDigit(text[pos]))
+        {
+          ++pos;
+        }
+      }
+      else if (scanIdentifier().empty())
+      {
+        return false;
+      }
+      if (str != nullptr)
+      {
+        if (!isString)
+        {
+          return false;
+        }
+        *str = text.substr(start + 1, pos - start - 2);
+      }
+      skipWhite();
+      if (pos >= length || text[pos] != '#')
+      {
+        return true;
+      }
+      if (str != nullptr)
+      {
+        return false;
+      }
+      ++pos;
+    }
+  };
+  while ((pos = text.find('@', pos)) != string::npos)
+  {
+    BibIndexRecord record;
+    record.begin = static_cast<uint32_t>(pos);
+    ++pos;
+    skipWhite();
+    string type = BibLowerCase(scanIdentifier());
+    if (type.empty() || IsBibDigit(type[0]))
+    {
+      return false;
+    }
+    if (type == "comment")
+    {
+      // BibTeX skips the word only
+      continue;
+    }
+    skipWhite();
+    if (pos >= length || (text[pos] != '{' && text[pos] != '('))
+    {
+      return false;
+    }
+    char closing = text[pos] == '{' ? '}' : ')';
+    ++pos;
+    skipWhite();
+    if (type == "preamble")
+    {
+      record.kind = BIB_RECORD_PREAMBLE;
+      if (!scanValue(nullptr))
+      {
+        return false;
+      }
+    }
+    else if (type == "string")
+    {
+      record.kind = BIB_RECORD_STRING;
+      string name = scanIdentifier();
+      if (name.empty() || IsBibDigit(name[0]))
+      {
+        return false;
+      }
+      skipWhite();
+      if (pos >= length || text[pos] != '=')
+      {
+        return false;
+      }
+      ++pos;
+      if (!scanValue(nullptr))
+      {
+        return false;
+      }
+    }
+    else
+    {
+      record.kind = BIB_RECORD_ENTRY;
+      size_t start = pos;
+      while (pos < length && !IsBibWhite(text[pos]) && text[pos] != ',' && !(closing == '}' && text[pos] == '}'))
+      {
+        ++pos;
+      }
+      record.key = BibLowerCase(text.substr(start, pos - start));
+      if (record.key.empty() || record.key.find_first_of("{}()\"") != string::npos)
+      {
+        return false;
+      }
+      while (true)
+      {
+        skipWhite();
+        if (pos < length && text[pos] == closing)
+        {
+          break;
+        }
+        if (pos >= length || text[pos] != ',')
+        {
+          return false;
+        }
+        ++pos;
+        skipWhite();
+        if (pos < length && text[pos] == closing)
+        {
+          break;
+        }
+        string fieldName = BibLowerCase(scanIdentifier());
+        if (fieldName.empty() || IsBibDigit(fieldName[0]))
+        {
+          return false;
+        }
+        skipWhite();
+        if (pos >= length || text[pos] != '=')
+        {
+          return false;
+        }
+        ++pos;
+        if (fieldName == "crossref")
+        {
+          string crossref;
+          // BibTeX compresses white space in field values
+          if (!scanValue(&crossref) || crossref.empty() || crossref.find_first_of(" \t\r\n{}") != string::npos)
+          {
+            return false;
+          }
+          // BibTeX ignores repeated fields
+          if (record.crossref.empty())
+          {
+            record.crossref = BibLowerCase(crossref);
+          }
+        }
+        else if (!scanValue(nullptr))
+        {
+          return false;
+        }
+      }
+    }
+    skipWhite();
+    if (pos >= length || text[pos] != closing)
+    {
+      return false;
+    }
+    ++pos;
+    record.end = static_cast<uint32_t>(pos);
+    records.push_back(record);
+  }
+  return true;
+}
+
+MIKTEXSTATICFUNC(bool) ReadBibIndex(const PathName& path, vector<BibIndexRecord>& records)
+{
+  unique_ptr<MemoryMappedFile> mapping(MemoryMappedFile::Create());
+  const unsigned char* data = static_cast<const unsigned char*>(mapping->Open(path, false));
+  size_t dataSize = mapping->GetSize();
+  size_t pos = 0;
+  auto readWord = [data, dataSize, &pos]()
+  {
+    if (sizeof(uint32_t) > dataSize - pos)
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    uint32_t word;
+    memcpy(&word, data + pos, sizeof(word));
+    pos += sizeof(word);
+    return word;
+  };
+  auto readString = [data, dataSize, &pos, &readWord]()
+  {
+    size_t length = readWord();
+    if (length > dataSize - pos)
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    string s(reinterpret_cast<const char*>(data + pos), length);
+    pos += length;
+    return s;
+  };
+  if (readWord() != BIB_INDEX_SIGNATURE || readWord() != BIB_INDEX_VERSION)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  uint32_t flags = readWord();
+  uint32_t numRecords = readWord();
+  for (uint32_t idx = 0; idx < numRecords; ++idx)
+  {
+    BibIndexRecord record;
+    record.kind = readWord();
+    record.begin = readWord();
+    record.end = readWord();
+    record.key = readString();
+    record.crossref = readString();
+    records.push_back(record);
+  }
+  if (pos != dataSize)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  return (flags & BIB_INDEX_NOT_REDUCIBLE) == 0;
+}
+
+MIKTEXSTATICFUNC(void) WriteBibIndex(const PathName& path, bool isReducible, const vector<BibIndexRecord>& records)
+{
+  string buf;
+  auto writeWord = [&buf](uint32_t word)
+  {
+    buf.append(reinterpret_cast<const char*>(&word), sizeof(word));
+  };
+  auto writeString = [&buf, &writeWord](const string& s)
+  {
+    writeWord(static_cast<uint32_t>(s.length()));
+    buf += s;
+  };
+  writeWord(BIB_INDEX_SIGNATURE);
+  writeWord(BIB_INDEX_VERSION);
+  writeWord(isReducible ? 0 : BIB_INDEX_NOT_REDUCIBLE);
+  writeWord(static_cast<uint32_t>(records.size()));
+  for (const BibIndexRecord& record : records)
+  {
+    writeWord(record.kind);
+    writeWord(record.begin);
+    writeWord(record.end);
+    writeString(record.key);
+    writeString(record.crossref);
+  }
+  Directory::Create(path.GetDirectoryName());
+  // other processes might read the index at the same time
+  PathName tmpPath(path);
+  tmpPath.AppendExtension(".tmp");
+  unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create(tmpPath);
+  FileStream stream(File::Open(tmpPath, FileMode::Create, FileAccess::Write, false));
+  stream.Write(buf.data(), buf.length());
+  stream.Close();
+  File::Move(tmpPath, path, { FileMoveOption::ReplaceExisting });
+  tmpFile->Keep();
+}
+
+PathName SessionImpl::GetBibIndexCacheDirectory()
+{
+  PathName cacheDir = PathName(MIKTEX_PATH_MIKTEX_CACHE_DIR) / PathName("bibtex");
+  return GetSpecialPath(IsAdminMode() ? SpecialPath::CommonDataRoot : SpecialPath::UserDataRoot) / cacheDir;
+}
+
+bool SessionImpl::ReduceBibDatabase(const string& database, const vector<string>& citeKeys, string& reduced)
+{
+  unordered_set<string> needed;
+  for (const string& key : citeKeys)
+  {
+    // \nocite{*}
+    if (key == "*")
+    {
+      return false;
+    }
+    needed.insert(BibLowerCase(key));
+  }
+
+  PathName path = GetBibIndexCacheDirectory() / PathName(MD5::FromChars(database).ToString());
+  path.AppendExtension(".bix");
+  vector<BibIndexRecord> records;
+  bool isReducible = false;
+  bool haveIndex = false;
+  if (File::Exists(path))
+  {
+    try
+    {
+      isReducible = ReadBibIndex(path, records);
+      haveIndex = true;
+    }
+    catch (const MiKTeXException& e)
+    {
+      trace_error->WriteLine("core", fmt::format(T_("BibTeX database index {0} could not be read: {1}"), Q_(path), e.GetErrorMessage()));
+      records.clear();
+    }
+  }
+  if (!haveIndex)
+  {
+    isReducible = ScanBibDatabase(database, records);
+    if (!isReducible)
+    {
+      records.clear();
+    }
+    try
+    {
+      WriteBibIndex(path, isReducible, records);
+      trace_files->WriteLine("core", fmt::format(T_("BibTeX database index {0} has been written ({1} records)"), Q_(path), records.size()));
+    }
+    catch (const MiKTeXException& e)
+    {
+      // not fatal: the database will be parsed again next time
+      trace_error->WriteLine("core", fmt::format(T_("BibTeX database index {0} could not be written: {1}"), Q_(path), e.GetErrorMessage()));
+    }
+  }
+  if (!isReducible)
+  {
+    trace_files->WriteLine("core", T_("BibTeX database cannot be reduced"));
+    return false;
+  }
+
+  // BibTeX lower-cases ASCII letters only: entries with other letters in
+  // their keys are always kept
+  auto isNeeded = [&needed](const BibIndexRecord& record)
+  {
+    return record.kind != BIB_RECORD_ENTRY || needed.find(record.key) != needed.end() || HasNonAsciiChars(record.key);
+  };
+  // cross-referenced entries are needed, too
+  bool changed = true;
+  while (changed)
+  {
+    changed = false;
+    for (const BibIndexRecord& record : records)
+    {
+      if (record.kind == BIB_RECORD_ENTRY && !record.crossref.empty() && isNeeded(record) && needed.insert(record.crossref).second)
+      {
+        changed = true;
+      }
+    }
+  }
+
+  reduced.clear();
+  reduced.reserve(database.length());
+  size_t pos = 0;
+  size_t numDropped = 0;
+  for (const BibIndexRecord& record : records)
+  {
+    if (record.begin < pos || record.end < record.begin || record.end > database.length())
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    if (isNeeded(record))
+    {
+      continue;
+    }
+    reduced.append(database, pos, record.begin - pos);
+    // keep the line numbers
+    reduced.append(count(database.begin() + record.begin, database.begin() + record.end, '\n'), '\n');
+    pos = record.end;
+    ++numDropped;
+  }
+  reduced.append(database, pos, string::npos);
+  trace_files->WriteLine("core", fmt::format(T_("BibTeX database reduced: {0} of {1} records dropped"), numDropped, records.size()));
+  return true;
+}
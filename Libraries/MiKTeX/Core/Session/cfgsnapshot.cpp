@@ -0,0 +1,333 @@
+/* cfgsnapshot.cpp: binary snapshots of merged configuration files
+
+   Copyright (C) 2022 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/Paths>
+#include <miktex/Core/TemporaryFile>
+
+#include "internal.h"
+
+#include "Session/SessionImpl.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+/*
+ * A snapshot starts with a header, followed by the list of the
+ * configuration files (in search order), the list of the files which
+ * have been read (with size and modification time), and the merged
+ * sections and values:
+ *
+ *   signature version
+ *   #configFiles { path }
+ *   #inputFiles { path size lastWriteTime }
+ *   #keys { name #values { name commentedOut #strings { string } } }
+ *
+ * Numbers are stored as 32-bit words (64-bit for sizes and times),
+ * strings are prefixed by their length.
+ */
+
+const uint32_t CFG_SNAPSHOT_SIGNATURE = 0x4746434d; // 'MCFG' (the x86 way)
+const uint32_t CFG_SNAPSHOT_VERSION = 1;
+
+#define CFG_SNAPSHOT_SUFFIX ".cfgsnapshot"
+
+namespace
+{
+  class SnapshotWriter
+  {
+  public:
+    void Put(uint32_t word)
+    {
+      buf.append(reinterpret_cast<const char*>(&word), sizeof(word));
+    }
+
+  public:
+    void Put64(uint64_t word)
+    {
+      buf.append(reinterpret_cast<const char*>(&word), sizeof(word));
+    }
+
+  public:
+    void Put(const string& str)
+    {
+      Put(static_cast<uint32_t>(str.length()));
+      buf.append(str);
+    }
+
+  public:
+    const string& GetData() const
+    {
+      return buf;
+    }
+
+  private:
+    string buf;
+  };
+
+  class SnapshotReader
+  {
+  public:
+    SnapshotReader(const vector<unsigned char>& bytes) :
+      bytes(bytes)
+    {
+    }
+
+  public:
+    uint32_t Get()
+    {
+      uint32_t word;
+      Read(&word, sizeof(word));
+      return word;
+    }
+
+  public:
+    uint64_t Get64()
+    {
+      uint64_t word;
+      Read(&word, sizeof(word));
+      return word;
+    }
+
+  public:
+    string GetString()
+    {
+      size_t length = Get();
+      if (length > bytes.size() - pos)
+      {
+        MIKTEX_UNEXPECTED();
+      }
+      string result(reinterpret_cast<const char*>(bytes.data()) + pos, length);
+      pos += length;
+      return result;
+    }
+
+  public:
+    bool AtEnd() const
+    {
+      return pos == bytes.size();
+    }
+
+  private:
+    void Read(void* data, size_t size)
+    {
+      if (size > bytes.size() - pos)
+      {
+        MIKTEX_UNEXPECTED();
+      }
+      memcpy(data, bytes.data() + pos, size);
+      pos += size;
+    }
+
+  private:
+    const vector<unsigned char>& bytes;
+
+  private:
+    size_t pos = 0;
+  };
+}
+
+PathName SessionImpl::GetConfigSnapshotPath(const string& baseName)
+{
+  unsigned r = GetDataRoot();
+  if (r == INVALID_ROOT_INDEX)
+  {
+    return PathName();
+  }
+  PathName path = GetRootDirectoryPath(r) / PathName(MIKTEX_PATH_MIKTEX_CACHE_DIR) / PathName(baseName);
+  path.AppendExtension(CFG_SNAPSHOT_SUFFIX);
+  return path;
+}
+
+bool SessionImpl::ReadConfigSnapshot(const string& baseName, const vector<PathName>& configFiles, Cfg& cfg)
+{
+  PathName snapshotPath = GetConfigSnapshotPath(baseName);
+  if (snapshotPath.Empty() || !File::Exists(snapshotPath))
+  {
+    return false;
+  }
+  try
+  {
+    vector<unsigned char> bytes = File::ReadAllBytes(snapshotPath);
+    SnapshotReader reader(bytes);
+    if (reader.Get() != CFG_SNAPSHOT_SIGNATURE || reader.Get() != CFG_SNAPSHOT_VERSION)
+    {
+      return false;
+    }
+    size_t numConfigFiles = reader.Get();
+    if (numConfigFiles != configFiles.size())
+    {
+      return false;
+    }
+    for (const PathName& path : configFiles)
+    {
+      if (reader.GetString() != path.ToString())
+      {
+        return false;
+      }
+    }
+    for (size_t numInputFiles = reader.Get(); numInputFiles > 0; --numInputFiles)
+    {
+      PathName path(reader.GetString());
+      uint64_t size = reader.Get64();
+      uint64_t lastWriteTime = reader.Get64();
+      if (!File::Exists(path) || File::GetSize(path) != size || static_cast<uint64_t>(File::GetLastWriteTime(path)) != lastWriteTime)
+      {
+        trace_config->WriteLine("core", fmt::format(T_("configuration snapshot {0} is out of date: {1} has changed"), Q_(snapshotPath), Q_(path)));
+        return false;
+      }
+    }
+    struct Value
+    {
+      string keyName;
+      string valueName;
+      bool commentedOut;
+      vector<string> strings;
+    };
+    vector<Value> values;
+    for (size_t numKeys = reader.Get(); numKeys > 0; --numKeys)
+    {
+      string keyName = reader.GetString();
+      for (size_t numValues = reader.Get(); numValues > 0; --numValues)
+      {
+        Value value;
+        value.keyName = keyName;
+        value.valueName = reader.GetString();
+        value.commentedOut = reader.Get() != 0;
+        for (size_t numStrings = reader.Get(); numStrings > 0; --numStrings)
+        {
+          value.strings.push_back(reader.GetString());
+        }
+        values.push_back(std::move(value));
+      }
+    }
+    if (!reader.AtEnd())
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    // the snapshot is valid: fill the configuration
+    for (const Value& value : values)
+    {
+      if (value.strings.empty())
+      {
+        // the value has been cleared
+        cfg.PutValue(value.keyName, value.valueName, "", "", value.commentedOut);
+        cfg.ClearValue(value.keyName, value.valueName);
+      }
+      for (const string& str : value.strings)
+      {
+        cfg.PutValue(value.keyName, value.valueName, str, "", value.commentedOut);
+      }
+    }
+  }
+  catch (const MiKTeXException& e)
+  {
+    trace_error->WriteLine("core", fmt::format(T_("configuration snapshot {0} could not be read: {1}"), Q_(snapshotPath), e.GetErrorMessage()));
+    return false;
+  }
+  trace_config->WriteLine("core", fmt::format(T_("using configuration snapshot {0}"), Q_(snapshotPath)));
+  return true;
+}
+
+void SessionImpl::WriteConfigSnapshot(const string& baseName, const vector<PathName>& configFiles, Cfg& cfg)
+{
+  PathName snapshotPath = GetConfigSnapshotPath(baseName);
+  if (snapshotPath.Empty())
+  {
+    return;
+  }
+  try
+  {
+    SnapshotWriter writer;
+    writer.Put(CFG_SNAPSHOT_SIGNATURE);
+    writer.Put(CFG_SNAPSHOT_VERSION);
+    writer.Put(static_cast<uint32_t>(configFiles.size()));
+    for (const PathName& path : configFiles)
+    {
+      writer.Put(path.ToString());
+    }
+    time_t now = time(nullptr);
+    vector<PathName> inputFiles = cfg.GetInputFiles();
+    writer.Put(static_cast<uint32_t>(inputFiles.size()));
+    for (const PathName& path : inputFiles)
+    {
+      time_t lastWriteTime = File::GetLastWriteTime(path);
+      if (lastWriteTime + 2 >= now)
+      {
+        // the file might be modified again within the timestamp
+        // resolution; try again later
+        return;
+      }
+      writer.Put(path.ToString());
+      writer.Put64(static_cast<uint64_t>(File::GetSize(path)));
+      writer.Put64(static_cast<uint64_t>(lastWriteTime));
+    }
+    writer.Put(static_cast<uint32_t>(cfg.GetSize()));
+    for (const shared_ptr<Cfg::Key>& key : cfg)
+    {
+      vector<shared_ptr<Cfg::Value>> values;
+      for (const shared_ptr<Cfg::Value>& value : *key)
+      {
+        values.push_back(value);
+      }
+      writer.Put(key->GetName());
+      writer.Put(static_cast<uint32_t>(values.size()));
+      for (const shared_ptr<Cfg::Value>& value : values)
+      {
+        writer.Put(value->GetName());
+        writer.Put(value->IsCommentedOut() ? 1 : 0);
+        writer.Put(static_cast<uint32_t>(value->end() - value->begin()));
+        for (const string& str : *value)
+        {
+          writer.Put(str);
+        }
+      }
+    }
+    Directory::Create(snapshotPath.GetDirectoryName());
+    PathName tmpSnapshotPath(snapshotPath);
+    tmpSnapshotPath.AppendExtension(".tmp");
+    unique_ptr<TemporaryFile> tmpSnapshotFile = TemporaryFile::Create(tmpSnapshotPath);
+    FileStream stream(File::Open(tmpSnapshotPath, FileMode::Create, FileAccess::Write, false));
+    stream.Write(writer.GetData().data(), writer.GetData().length());
+    stream.Close();
+    if (File::Exists(snapshotPath))
+    {
+      File::Delete(snapshotPath, { FileDeleteOption::TryHard });
+    }
+    File::Move(tmpSnapshotPath, snapshotPath);
+    tmpSnapshotFile->Keep();
+    trace_config->WriteLine("core", fmt::format(T_("configuration snapshot {0} has been written"), Q_(snapshotPath)));
+  }
+  catch (const MiKTeXException& e)
+  {
+    // not fatal: the configuration files will be parsed again
+    trace_error->WriteLine("core", fmt::format(T_("configuration snapshot {0} could not be written: {1}"), Q_(snapshotPath), e.GetErrorMessage()));
+  }
+}
@@ -32,6 +32,7 @@
 #include <miktex/Core/FileStream>
 #include <miktex/Util/PathName>
 #include <miktex/Core/Paths>
+#include <miktex/Util/StartupProfile>
 #include <miktex/Util/Tokenizer>
 
 #include "internal.h"
@@ -160,22 +161,33 @@ PathName SessionImpl::GetBinDirectory(bool canonicalized)
 
 void SessionImpl::ReadAllConfigFiles(const string& baseName, Cfg& cfg)
 {
+  StartupProfileSection startupProfileSection("read config " + baseName);
   PathName fileName = PathName(MIKTEX_PATH_MIKTEX_CONFIG_DIR) / PathName(baseName);
   fileName.AppendExtension(".ini");
-  vector<PathName> configFiles;
-  if (!FindFile(fileName.ToString(), MIKTEX_PATH_TEXMF_PLACEHOLDER, { FindFileOption::All }, configFiles))
+  vector<PathName> foundFiles;
+  if (!FindFile(fileName.ToString(), MIKTEX_PATH_TEXMF_PLACEHOLDER, { FindFileOption::All }, foundFiles))
   {
     return;
   }
-  for (vector<PathName>::const_reverse_iterator it = configFiles.rbegin(); it != configFiles.rend(); ++it)
+  vector<PathName> configFiles;
+  for (vector<PathName>::const_reverse_iterator it = foundFiles.rbegin(); it != foundFiles.rend(); ++it)
   {
     unsigned r = TryDeriveTEXMFRoot(*it);
     if (r != INVALID_ROOT_INDEX && !IsManagedRoot(r))
     {
       continue;
     }
-    cfg.Read(*it);
+    configFiles.push_back(*it);
+  }
+  if (ReadConfigSnapshot(baseName, configFiles, cfg))
+  {
+    return;
+  }
+  for (const PathName& path : configFiles)
+  {
+    cfg.Read(path);
   }
+  WriteConfigSnapshot(baseName, configFiles, cfg);
 }
 
 MIKTEXSTATICFUNC(void) AppendToEnvVarName(string& name, const string& part)
@@ -193,7 +205,56 @@ MIKTEXSTATICFUNC(void) AppendToEnvVarName(string& name, const string& part)
   }
 }
 
+atomic_uint SessionImpl::configGeneration(0);
+
 bool SessionImpl::GetSessionValue(const string& sectionName, const string& valueName, string& value, HasNamedValues* callback)
+{
+  if (callback != nullptr)
+  {
+    // the expansion depends on the callback
+    lock_guard<recursive_mutex> lockGuard(lazyStateMutex);
+    return LookupSessionValue(sectionName, valueName, value, callback);
+  }
+  unsigned generation = configGeneration;
+  string key = Utils::MakeLower("[" + sectionName + "]" + valueName);
+  {
+    shared_lock<shared_mutex> readLock(memoizedValuesMutex);
+    if (memoizedValuesGeneration == generation)
+    {
+      unordered_map<string, MemoizedValue>::const_iterator it = memoizedValues.find(key);
+      if (it != memoizedValues.end())
+      {
+        ++memoizedValueHits;
+        if (it->second.haveValue)
+        {
+          value = it->second.value;
+        }
+        return it->second.haveValue;
+      }
+    }
+  }
+  ++memoizedValueMisses;
+  bool haveValue;
+  {
+    lock_guard<recursive_mutex> lockGuard(lazyStateMutex);
+    haveValue = LookupSessionValue(sectionName, valueName, value, nullptr);
+  }
+  unique_lock<shared_mutex> writeLock(memoizedValuesMutex);
+  // the lookup itself might have changed the configuration
+  if (configGeneration != generation)
+  {
+    return haveValue;
+  }
+  if (memoizedValuesGeneration != generation)
+  {
+    memoizedValues.clear();
+    memoizedValuesGeneration = generation;
+  }
+  memoizedValues[key] = { haveValue, haveValue ? value : "" };
+  return haveValue;
+}
+
+bool SessionImpl::LookupSessionValue(const string& sectionName, const string& valueName, string& value, HasNamedValues* callback)
 {
   bool haveValue = false;
 
@@ -474,6 +535,7 @@ void SessionImpl::SetConfigValue(const std::string& sectionName, const string& v
     && !GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_NO_REGISTRY, ConfigValue(USE_WINDOWS_REGISTRY ? false : true)).GetBool())
   {
     winRegistry::SetValue(IsAdminMode() ? ConfigurationScope::Common : ConfigurationScope::User, sectionName, valueName, value.GetString());
+    BumpConfigGeneration();
     string newValue;
     if (GetSessionValue(sectionName, valueName, newValue, nullptr))
     {
@@ -493,7 +555,11 @@ void SessionImpl::SetConfigValue(const std::string& sectionName, const string& v
   {
     Fndb::Add({ { pathConfigFile } });
   }
-  configurationSettings.clear();
+  {
+    lock_guard<recursive_mutex> lockGuard(lazyStateMutex);
+    configurationSettings.clear();
+  }
+  BumpConfigGeneration();
 }
 
 void SessionImpl::SetAdminMode(bool adminMode, bool force)
@@ -515,6 +581,7 @@ void SessionImpl::SetAdminMode(bool adminMode, bool force)
   fileTypes.clear();
   UnloadFilenameDatabase();
   this->adminMode = adminMode;
+  BumpConfigGeneration();
   if (!rootDirectories.empty())
   {
     // reinitialize root directories
@@ -46,7 +46,6 @@
 
 #include "internal.h"
 
-#include "Fndb/FileNameDatabase.h"
 #include "Session/SessionImpl.h"
 
 using namespace std;
@@ -102,29 +101,37 @@ static array<unique_ptr<FileStream>, 2> CreatePipe(size_t pipeSize)
 }
 
 void SessionImpl::RecordFileInfo(const PathName& path, FileAccess access)
+{
+  RecordFileInfo(path, access, chrono::steady_clock::duration::zero());
+}
+
+size_t SessionImpl::RecordFileInfo(const PathName& path, FileAccess access, chrono::steady_clock::duration openTime)
 {
   if (!(recordingFileNames || recordingPackageNames || packageHistoryFile.length() > 0))
   {
-    return;
+    return SIZE_MAX;
   }
   fileInfoRecords.reserve(50);
   FileInfoRecord fir;
   fir.fileName = path.ToString();
   fir.access = access;
+  fir.openTime = openTime;
+  {
+    lock_guard<mutex> lockGuard(pendingLookupsMutex);
+    auto it = pendingLookups.find(fir.fileName);
+    if (it != pendingLookups.end())
+    {
+      fir.lookupSource = it->second.source;
+      fir.lookupTime = it->second.time;
+      pendingLookups.erase(it);
+    }
+  }
   if (recordingPackageNames || !packageHistoryFile.empty())
   {
     PathName pathRelPath;
     if (IsTEXMFFile(path, pathRelPath))
     {
-      shared_ptr<FileNameDatabase> fndb = GetFileNameDatabase(GetMpmRoot());
-      if (fndb != nullptr)
-      {
-        vector<Fndb::Record> records;
-        if (fndb->Search(pathRelPath, MPM_ROOT_PATH, false, records))
-        {
-          fir.packageName = records[0].fileNameInfo;
-        }
-      }
+      TryGetPackageOfFile(pathRelPath, fir.packageName);
     }
   }
   fileInfoRecords.push_back(fir);
@@ -132,6 +139,7 @@ void SessionImpl::RecordFileInfo(const PathName& path, FileAccess access)
   {
     fileNameRecorderStream << (fir.access == FileAccess::Read ? "INPUT" : "OUTPUT") << " " << PathName(fir.fileName).ToUnix() << std::endl;
   }
+  return fileInfoRecords.size() - 1;
 }
 
 FILE* SessionImpl::TryOpenFile(const PathName& path, FileMode mode, FileAccess access, bool text)
@@ -163,6 +171,8 @@ FILE* SessionImpl::OpenFile(const PathName& path, FileMode mode, FileAccess acce
   unique_ptr<Process> process;
   FILE* file = nullptr;
 
+  auto start = chrono::steady_clock::now();
+
   if (mode == FileMode::Command)
   {
     MIKTEX_ASSERT(access == FileAccess::Read || access == FileAccess::Write);
@@ -175,9 +185,11 @@ FILE* SessionImpl::OpenFile(const PathName& path, FileMode mode, FileAccess acce
     file = File::Open(path, mode, access, text);
   }
 
+  size_t fileInfoRecordIndex;
+
   try
   {
-    RecordFileInfo(path, access);
+    fileInfoRecordIndex = RecordFileInfo(path, access, chrono::steady_clock::now() - start);
   }
   catch (const exception&)
   {
@@ -198,6 +210,7 @@ FILE* SessionImpl::OpenFile(const PathName& path, FileMode mode, FileAccess acce
   info.mode = mode;
   info.access = access;
   info.process = move(process);
+  info.fileInfoRecordIndex = fileInfoRecordIndex;
   openFilesMap[file] = move(info);
   if (setvbuf(file, 0, _IOFBF, 1024 * 4) != 0)
   {
@@ -310,6 +323,17 @@ void SessionImpl::CloseFile(FILE* file, int& exitCode)
     isCommand = (it->second.mode == FileMode::Command);
     command = it->second.fileName;
     process = move(it->second.process);
+    size_t idx = it->second.fileInfoRecordIndex;
+    if (!isCommand && idx < fileInfoRecords.size())
+    {
+      // files are read and written sequentially: the position is the
+      // number of bytes transferred
+      long pos = ftell(file);
+      if (pos > 0)
+      {
+        (it->second.access == FileAccess::Write ? fileInfoRecords[idx].bytesWritten : fileInfoRecords[idx].bytesRead) = pos;
+      }
+    }
     openFilesMap.erase(it);
   }
   if (isCommand)
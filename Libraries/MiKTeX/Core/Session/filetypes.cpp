@@ -241,6 +241,7 @@ void SessionImpl::RegisterFileType(FileType fileType)
 
 void SessionImpl::RegisterFileTypes()
 {
+  lock_guard<recursive_mutex> lockGuard(lazyStateMutex);
   for (int ft = (int)FileType::None + 1; ft < (int)FileType::E_N_D; ++ft)
   {
     RegisterFileType((FileType)ft);
@@ -249,6 +250,7 @@ void SessionImpl::RegisterFileTypes()
 
 InternalFileTypeInfo* SessionImpl::GetInternalFileTypeInfo(FileType fileType)
 {
+  lock_guard<recursive_mutex> lockGuard(lazyStateMutex);
   RegisterFileType(fileType);
   return &fileTypes[(size_t)fileType];
 }
@@ -298,5 +300,6 @@ void SessionImpl::ClearSearchVectors()
   for (InternalFileTypeInfo& info : fileTypes)
   {
     info.pathPatterns.clear();
+    info.havePathPatterns = false;
   }
 }
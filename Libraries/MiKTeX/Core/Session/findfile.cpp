@@ -38,6 +38,7 @@ using namespace std;
 
 using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
 
 void SessionImpl::SetFindFileCallback(IFindFileCallback* callback)
@@ -45,6 +46,17 @@ void SessionImpl::SetFindFileCallback(IFindFileCallback* callback)
   findFileCallback = callback;
 }
 
+// where the current search has found the file first
+static thread_local FileLookupSource lookupSource = FileLookupSource::None;
+
+inline void NoteLookupSource(FileLookupSource source)
+{
+  if (lookupSource == FileLookupSource::None)
+  {
+    lookupSource = source;
+  }
+}
+
 bool SessionImpl::CheckCandidate(PathName& path, const char* fileInfo, IFindFileCallback* callback)
 {
   bool found = false;
@@ -52,7 +64,15 @@ bool SessionImpl::CheckCandidate(PathName& path, const char* fileInfo, IFindFile
   {
     PathName trigger(Utils::GetRelativizedPath(path.GetData(), MPM_ROOT_PATH));
     PathName installRoot;
-    if (fileInfo != nullptr && callback != nullptr && callback->InstallPackage(fileInfo, trigger, installRoot))
+    bool installed = false;
+    if (fileInfo != nullptr && callback != nullptr)
+    {
+      auto start = chrono::steady_clock::now();
+      installed = callback->InstallPackage(fileInfo, trigger, installRoot);
+      installationCount += 1;
+      installationTicks += (chrono::steady_clock::now() - start).count();
+    }
+    if (installed)
     {
       PathName temp = installRoot;
       temp /= path.GetData() + MPM_ROOT_PATH_LEN;
@@ -71,6 +91,23 @@ bool SessionImpl::CheckCandidate(PathName& path, const char* fileInfo, IFindFile
   return found;
 }
 
+bool SessionImpl::TryGetPackageOfFile(const PathName& relativePath, string& packageId)
+{
+  shared_ptr<FileNameDatabase> fndb = GetFileNameDatabase(GetMpmRoot());
+  if (fndb == nullptr)
+  {
+    return false;
+  }
+  // the compiled pattern memoizes the directory matches
+  vector<Fndb::Record> records;
+  if (!fndb->Search(relativePath, GetCompiledPathPattern(PathName(MPM_ROOT_PATH)), false, records))
+  {
+    return false;
+  }
+  packageId = records[0].fileNameInfo;
+  return true;
+}
+
 bool SessionImpl::SearchFileSystem(const string& fileName, const char* pathPattern, bool all, vector<PathName>& result, IFindFileCallback* callback)
 {
   MIKTEX_ASSERT(result.empty());
@@ -80,30 +117,38 @@ bool SessionImpl::SearchFileSystem(const string& fileName, const char* pathPatte
     return false;
   }
 
-  trace_filesearch->WriteLine("core", fmt::format(T_("file system search: fileName={0}, pathPattern={1}"), Q_(fileName), Q_(pathPattern)));
-
-  vector<PathName> directories;
+  MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", TraceLevel::Trace, fmt::format(T_("file system search: fileName={0}, pathPattern={1}"), Q_(fileName), Q_(pathPattern)));
 
   PathName comparablePathPattern(pathPattern);
   comparablePathPattern.TransformForComparison();
 
-  SearchPathDictionary::const_iterator it = expandedPathPatterns.find(comparablePathPattern.ToString());
-
-  if (it == expandedPathPatterns.end())
+  // map references remain valid when more entries are added (entries
+  // are never removed)
+  const vector<PathName>* expandedDirectories = nullptr;
   {
-    ExpandPathPattern(PathName(), PathName(pathPattern), directories);
-    expandedPathPatterns[comparablePathPattern.ToString()] = directories;
+    shared_lock<shared_mutex> readLock(lookupCachesMutex);
+    SearchPathDictionary::const_iterator it = expandedPathPatterns.find(comparablePathPattern.ToString());
+    if (it != expandedPathPatterns.end())
+    {
+      expandedDirectories = &it->second;
+    }
   }
-  else
+
+  if (expandedDirectories == nullptr)
   {
-    directories = it->second;
+    vector<PathName> directories;
+    ExpandPathPattern(PathName(), PathName(pathPattern), directories);
+    unique_lock<shared_mutex> writeLock(lookupCachesMutex);
+    expandedDirectories = &expandedPathPatterns.insert(make_pair(comparablePathPattern.ToString(), std::move(directories))).first->second;
   }
 
+  const vector<PathName>& directories = *expandedDirectories;
+
   bool found = false;
 
   for (vector<PathName>::const_iterator it = directories.begin(); (!found || all) && it != directories.end(); ++it)
   {
-    PathName path(*it, PathName(fileName));
+    PathName path(it->GetData(), fileName.c_str());
     if (CheckCandidate(path, nullptr, callback))
     {
       found = true;
@@ -114,9 +159,61 @@ bool SessionImpl::SearchFileSystem(const string& fileName, const char* pathPatte
   return found;
 }
 
+const PathPattern& SessionImpl::GetCompiledPathPattern(const PathName& pathPattern)
+{
+  string key = pathPattern.ToString();
+  {
+    shared_lock<shared_mutex> readLock(lookupCachesMutex);
+    unordered_map<string, unique_ptr<PathPattern>>::const_iterator it = compiledPathPatterns.find(key);
+    if (it != compiledPathPatterns.end())
+    {
+      return *it->second;
+    }
+  }
+  unique_lock<shared_mutex> writeLock(lookupCachesMutex);
+  unique_ptr<PathPattern>& compiledPathPattern = compiledPathPatterns[key];
+  if (compiledPathPattern == nullptr)
+  {
+    compiledPathPattern = make_unique<PathPattern>(key);
+  }
+  return *compiledPathPattern;
+}
+
+// hard limit for the number of cached unsuccessful searches
+const size_t MAX_NEGATIVE_LOOKUPS = 10000;
+
+string SessionImpl::MakeNegativeLookupKey(const string& fileName, const vector<PathName>& pathPatterns, IFindFileCallback* callback)
+{
+  string key = fileName;
+  key += callback == nullptr ? '-' : '+';
+  for (const PathName& pathPattern : pathPatterns)
+  {
+    key += PathNameUtil::PathNameDelimiter;
+    key += pathPattern.ToString();
+  }
+  return key;
+}
+
+bool SessionImpl::IsKnownMissing(const string& negativeLookupKey)
+{
+  shared_lock<shared_mutex> readLock(lookupCachesMutex);
+  unordered_map<string, unsigned>::const_iterator it = negativeLookups.find(negativeLookupKey);
+  return it != negativeLookups.end() && it->second == FileNameDatabase::GetGeneration();
+}
+
+void SessionImpl::RememberMissing(const string& negativeLookupKey)
+{
+  unique_lock<shared_mutex> writeLock(lookupCachesMutex);
+  if (negativeLookups.size() >= MAX_NEGATIVE_LOOKUPS)
+  {
+    negativeLookups.clear();
+  }
+  negativeLookups[negativeLookupKey] = FileNameDatabase::GetGeneration();
+}
+
 bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<PathName>& pathPatterns, bool all, bool useFndb, bool searchFileSystem, vector<PathName>& result, IFindFileCallback* callback)
 {
-  CoreStopWatch stopWatch(fmt::format("find file {}", Q_(fileName)));
+  CoreStopWatch stopWatch(CoreTimer::FindFile, [&fileName]() { return fmt::format("find file {}", Q_(fileName)); });
 
   MIKTEX_ASSERT(useFndb || searchFileSystem);
 
@@ -135,6 +232,7 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
     found = CheckCandidate(path, nullptr, callback);
     if (found)
     {
+      NoteLookupSource(FileLookupSource::FileSystem);
       result.push_back(path);
     }
     return found;
@@ -152,6 +250,7 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
       if (CheckCandidate(path, nullptr, callback))
       {
         found = true;
+        NoteLookupSource(FileLookupSource::FileSystem);
 #if FIND_FILE_PREFER_RELATIVE_PATH_NAMES
         // 2015-01-15
         if (idx == 0)
@@ -176,6 +275,7 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
       found = CheckCandidate(p.second, nullptr, callback);
       if (found)
       {
+        NoteLookupSource(FileLookupSource::FileSystem);
         result.push_back(p.second);
       }
       return found;
@@ -185,9 +285,23 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
   // make use of the file name database
   if (useFndb)
   {
+    // only pure FNDB searches can be remembered: the file system isn't watched
+    bool searchedFileSystem = false;
+    string negativeLookupKey;
+    if (!searchFileSystem)
+    {
+      negativeLookupKey = MakeNegativeLookupKey(fileName, pathPatterns, callback);
+      if (IsKnownMissing(negativeLookupKey))
+      {
+        MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", TraceLevel::Trace, fmt::format(T_("{0} is known to be missing"), Q_(fileName)));
+        return false;
+      }
+    }
+    unsigned generation = FileNameDatabase::GetGeneration();
+    PathName relativePath(fileName);
     for (vector<PathName>::const_iterator it = pathPatterns.begin(); (!found || all) && it != pathPatterns.end(); ++it)
     {
-      trace_filesearch->WriteLine("core", fmt::format(T_("going to search in FNDB: filename={0}, directory={1}"), Q_(fileName), Q_(it->ToString())));
+      MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", TraceLevel::Trace, fmt::format(T_("going to search in FNDB: filename={0}, directory={1}"), Q_(fileName), Q_(it->ToString())));
 #if FIND_FILE_DONT_TRIGGER_INSTALLER_IF_ALL
       if (found && all && IsMpmFile(it->GetData()))
       {
@@ -200,7 +314,7 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
       {
         // search fndb
         vector<Fndb::Record> records;
-        bool foundInFndb = fndb->Search(PathName(fileName), it->ToString(), all, records);
+        bool foundInFndb = fndb->Search(relativePath, GetCompiledPathPattern(*it), all, records);
         // we must release the FNDB handle since CheckCandidate() might request an unload of the FNDB
         fndb = nullptr;
         if (foundInFndb)
@@ -210,6 +324,7 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
             if (CheckCandidate(records[idx].path, records[idx].fileNameInfo.c_str(), callback))
             {
               found = true;
+              NoteLookupSource(FileLookupSource::Fndb);
               result.push_back(records[idx].path);
             }
           }
@@ -218,15 +333,21 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
       else
       {
         // search the file system because the FNDB does not exist
-        trace_filesearch->WriteLine("core", fmt::format(T_("no FNDB found, so going to continue on disk: filename={0}, directory={1}"), Q_(fileName), Q_(*it)));
+        MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", TraceLevel::Trace, fmt::format(T_("no FNDB found, so going to continue on disk: filename={0}, directory={1}"), Q_(fileName), Q_(*it)));
+        searchedFileSystem = true;
         vector<PathName> paths;
         if (SearchFileSystem(fileName, it->GetData(), all, paths, callback))
         {
           found = true;
+          NoteLookupSource(FileLookupSource::FileSystem);
           result.insert(result.end(), paths.begin(), paths.end());
         }
       }
     }
+    if (!found && !searchFileSystem && !searchedFileSystem && generation == FileNameDatabase::GetGeneration())
+    {
+      RememberMissing(negativeLookupKey);
+    }
   }
 
   if (found || !searchFileSystem)
@@ -260,6 +381,7 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
     if (SearchFileSystem(fileName, it->GetData(), all, paths, callback))
     {
       found = true;
+      NoteLookupSource(FileLookupSource::FileSystem);
       result.insert(result.end(), paths.begin(), paths.end());
     }
   }
@@ -287,7 +409,7 @@ bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool
     fileType = DeriveFileType(PathName(fileName));
     if (fileType == FileType::None)
     {
-      trace_filesearch->WriteLine("core", fmt::format(T_("cannot derive file type from {0}"), Q_(fileName)));
+      MIKTEX_TRACE_WRITE_LINE(trace_filesearch, "core", TraceLevel::Trace, fmt::format(T_("cannot derive file type from {0}"), Q_(fileName)));
       return false;
     }
   }
@@ -297,7 +419,8 @@ bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool
     return false;
   }
 
-  // construct the search vector
+  // construct the search vector; this is a copy because the callback
+  // might invalidate the file type information
   vector<PathName> pathPatterns = GetDirectoryPatterns(fileType);
 
   // get the file type information
@@ -305,10 +428,10 @@ bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool
   MIKTEX_ASSERT(fti != nullptr);
 
   // check to see whether the file name has a registered file name extension
-  PathName extension(PathName(fileName).GetExtension());
-  bool hasRegisteredExtension = !extension.Empty()
-    && (std::find_if(fti->fileNameExtensions.begin(), fti->fileNameExtensions.end(), [extension](const string& ext) { return extension == PathName(ext); }) != fti->fileNameExtensions.end()
-      || std::find_if(fti->alternateExtensions.begin(), fti->alternateExtensions.end(), [extension](const string& ext) { return extension == PathName(ext); }) != fti->alternateExtensions.end());
+  string extension = PathNameView(fileName).GetExtension().ToString();
+  bool hasRegisteredExtension = !extension.empty()
+    && (std::find_if(fti->fileNameExtensions.begin(), fti->fileNameExtensions.end(), [&extension](const string& ext) { return PathName::Compare(extension, ext) == 0; }) != fti->fileNameExtensions.end()
+      || std::find_if(fti->alternateExtensions.begin(), fti->alternateExtensions.end(), [&extension](const string& ext) { return PathName::Compare(extension, ext) == 0; }) != fti->alternateExtensions.end());
 
   vector<PathName> fileNamesToTry;
 
@@ -349,10 +472,19 @@ bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool
   {
     if (result.empty())
     {
-      if (callback != nullptr && callback->TryCreateFile(PathName(fileName), fileType))
+      // another user might have made the file already
+      if (IsSharedSetup() && TryGetFromSharedCache(fileName, fileType))
       {
         FindFileInDirectories(fileName, pathPatterns, all, true, false, result, callback);
       }
+      if (result.empty() && callback != nullptr && callback->TryCreateFile(PathName(fileName), fileType))
+      {
+        FindFileInDirectories(fileName, pathPatterns, all, true, false, result, callback);
+        if (IsSharedSetup() && !result.empty())
+        {
+          PutIntoSharedCache(fileName, fileType, result[0]);
+        }
+      }
     }
     else if ((fileType == FileType::BASE || fileType == FileType::FMT || fileType == FileType::MEM) && callback != nullptr && GetConfigValue(MIKTEX_CONFIG_SECTION_TEXANDFRIENDS, MIKTEX_CONFIG_VALUE_RENEW_FORMATS_ON_UPDATE).GetBool())
     {
@@ -374,6 +506,10 @@ bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool
         {
           result.clear();
           FindFileInDirectories(fileName, pathPatterns, all, true, false, result, callback);
+          if (IsSharedSetup() && !result.empty())
+          {
+            PutIntoSharedCache(fileName, fileType, result[0]);
+          }
         }
       }
     }
@@ -383,13 +519,84 @@ bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool
 }
 
 LocateResult MIKTEXTHISCALL SessionImpl::Locate(const string& givenFileName, const LocateOptions& options)
+{
+  vector<PathName> pathPatterns;
+  if (options.fileType == FileType::None)
+  {
+    pathPatterns = SplitSearchPath(options.searchPath.empty() ? MIKTEX_PATH_TEXMF_PLACEHOLDER : options.searchPath);
+  }
+  return LocateTimed(givenFileName, pathPatterns, options);
+}
+
+vector<LocateResult> MIKTEXTHISCALL SessionImpl::FindFiles(const vector<string>& fileNames, const LocateOptions& options)
+{
+  CoreStopWatch stopWatch(CoreTimer::FindFiles, [&fileNames]() { return fmt::format("find {} files", fileNames.size()); });
+  // split the search path only once
+  vector<PathName> pathPatterns;
+  if (options.fileType == FileType::None)
+  {
+    pathPatterns = SplitSearchPath(options.searchPath.empty() ? MIKTEX_PATH_TEXMF_PLACEHOLDER : options.searchPath);
+  }
+  vector<LocateResult> results;
+  results.reserve(fileNames.size());
+  for (const string& fileName : fileNames)
+  {
+    results.push_back(LocateTimed(fileName, pathPatterns, options));
+  }
+  return results;
+}
+
+LocateStatistics MIKTEXTHISCALL SessionImpl::GetLocateStatistics()
+{
+  LocateStatistics statistics;
+  statistics.count = locateCount;
+  statistics.duration = chrono::steady_clock::duration(locateTicks);
+  statistics.misses = missCount;
+  statistics.missDuration = chrono::steady_clock::duration(missTicks);
+  statistics.installations = installationCount;
+  statistics.installationDuration = chrono::steady_clock::duration(installationTicks);
+  return statistics;
+}
+
+// the number of searches remembered for the file information records
+constexpr size_t MAX_PENDING_LOOKUPS = 1000;
+
+LocateResult SessionImpl::LocateTimed(const string& givenFileName, const vector<PathName>& pathPatterns, const LocateOptions& options)
+{
+  lookupSource = FileLookupSource::None;
+  auto start = chrono::steady_clock::now();
+  LocateResult result = LocateInternal(givenFileName, pathPatterns, options);
+  auto duration = chrono::steady_clock::now() - start;
+  locateCount += 1;
+  locateTicks += duration.count();
+  if (result.pathNames.empty())
+  {
+    missCount += 1;
+    missTicks += duration.count();
+  }
+  else if (recordingFileNames || recordingPackageNames)
+  {
+    // the file is probably opened next: see RecordFileInfo()
+    lock_guard<mutex> lockGuard(pendingLookupsMutex);
+    if (pendingLookups.size() >= MAX_PENDING_LOOKUPS)
+    {
+      pendingLookups.clear();
+    }
+    for (const PathName& path : result.pathNames)
+    {
+      pendingLookups[path.ToString()] = LookupRecord{ lookupSource, duration };
+    }
+  }
+  return result;
+}
+
+LocateResult SessionImpl::LocateInternal(const string& givenFileName, const vector<PathName>& pathPatterns, const LocateOptions& options)
 {
   string fileName = this->ExpandValues(givenFileName, nullptr);
   bool found = false;
   vector<PathName> pathNames;
   if (options.fileType == FileType::None)
   {
-    auto pathPatterns = SplitSearchPath(options.searchPath.empty() ? MIKTEX_PATH_TEXMF_PLACEHOLDER : options.searchPath);
     found = FindFileInDirectories(fileName, pathPatterns, options.all, true, false, pathNames, options.callback);
     if (!found && options.searchFileSystem)
     {
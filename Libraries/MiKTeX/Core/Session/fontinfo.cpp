@@ -23,8 +23,6 @@
 
 #include "config.h"
 
-#include <fstream>
-
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -36,6 +34,7 @@
 #include "internal.h"
 
 #include "Session/SessionImpl.h"
+#include "Utils/LineReader.h"
 #include "Utils/inliners.h"
 
 using namespace std;
@@ -53,7 +52,46 @@ MIKTEXSTATICFUNC(int) IsPrefixOf(const string& s1, const string& s2)
   return l1 <= s2.length() && strncmp(s1.c_str(), s2.c_str(), l1) == 0;
 }
 
-MIKTEXSTATICFUNC(bool) SessionImpl::FindInTypefaceMap(const string& fontName, string& typeface)
+const SessionImpl::FontMap& SessionImpl::GetFontMap(const string& fileName)
+{
+  PathName path;
+  if (!FindFile(fileName, MAP_SEARCH_PATH, path))
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  time_t lastWriteTime = File::GetLastWriteTime(path);
+  FontMap& fontMap = fontMaps[fileName];
+  if (fontMap.path == path && fontMap.lastWriteTime == lastWriteTime)
+  {
+    return fontMap;
+  }
+  trace_fonts->WriteLine("core", fmt::format(T_("loading font map {0}"), Q_(path)));
+  // mark the entry valid only after it has been read completely
+  fontMap = FontMap();
+  LineReader reader(path);
+  for (string_view line; reader.ReadLine(line); )
+  {
+    vector<string> tokens;
+    for (Tokenizer tok(line, WHITESPACE); tok; ++tok)
+    {
+      tokens.push_back(*tok);
+    }
+    if (tokens.empty())
+    {
+      continue;
+    }
+    if (tokens.size() >= 2)
+    {
+      fontMap.index.insert(make_pair(tokens[0], fontMap.lines.size()));
+    }
+    fontMap.lines.push_back(std::move(tokens));
+  }
+  fontMap.path = path;
+  fontMap.lastWriteTime = lastWriteTime;
+  return fontMap;
+}
+
+bool SessionImpl::FindInTypefaceMap(const string& fontName, string& typeface)
 {
   const size_t FONT_ABBREV_LENGTH = 2;
 
@@ -65,32 +103,16 @@ MIKTEXSTATICFUNC(bool) SessionImpl::FindInTypefaceMap(const string& fontName, st
   // "ptmr8r" => "tm"
   string fontAbbrev = fontName.substr(1, FONT_ABBREV_LENGTH);
 
-  PathName typefaceMap;
-  if (!FindFile("typeface.map", MAP_SEARCH_PATH, typefaceMap))
-  {
-    MIKTEX_UNEXPECTED();
-  }
+  const FontMap& typefaceMap = GetFontMap("typeface.map");
 
-  ifstream reader = File::CreateInputStream(typefaceMap);  
-  
-  for (string line; std::getline(reader, line); )
+  auto it = typefaceMap.index.find(fontAbbrev);
+  if (it == typefaceMap.index.end())
   {
-    Tokenizer tok(line, WHITESPACE);
-    if (!tok || fontAbbrev != *tok)
-    {
-      continue;
-    }
-    ++tok;
-    if (!tok)
-    {
-      continue;
-    }
-    typeface = *tok;
-    trace_fonts->WriteLine("core", fmt::format(T_("found {0} in typeface.map"), Q_(typeface)));
-    return true;
+    return false;
   }
-
-  return false;
+  typeface = typefaceMap.lines[it->second][1];
+  trace_fonts->WriteLine("core", fmt::format(T_("found {0} in typeface.map"), Q_(typeface)));
+  return true;
 }
 
 bool SessionImpl::FindInSupplierMap(const string& fontName, string& supplier, string& typeface)
@@ -105,33 +127,17 @@ bool SessionImpl::FindInSupplierMap(const string& fontName, string& supplier, st
   // "ptmr8r" => "p"
   string supplierAbbrev = fontName.substr(0, SUPPLIER_ABBREV_LENGTH);
 
-  PathName supplierMap;
-  if (!FindFile("supplier.map", MAP_SEARCH_PATH, supplierMap))
-  {
-    MIKTEX_UNEXPECTED();
-  }
-
-  ifstream reader = File::CreateInputStream(supplierMap);
+  const FontMap& supplierMap = GetFontMap("supplier.map");
 
-  bool found = false;
-  for (string line; !found && std::getline(reader, line); )
+  auto it = supplierMap.index.find(supplierAbbrev);
+  if (it == supplierMap.index.end())
   {
-    Tokenizer tok(line, WHITESPACE);
-    if (!tok || supplierAbbrev != *tok)
-    {
-      continue;
-    }
-    ++tok;
-    if (!tok)
-    {
-      continue;
-    }
-    supplier = *tok;
-    trace_fonts->WriteLine("core", fmt::format(T_("found {0} in supplier.map"), Q_(supplier)));
-    found = true;
+    return false;
   }
+  supplier = supplierMap.lines[it->second][1];
+  trace_fonts->WriteLine("core", fmt::format(T_("found {0} in supplier.map"), Q_(supplier)));
 
-  return found && FindInTypefaceMap(fontName, typeface);
+  return FindInTypefaceMap(fontName, typeface);
 }
 
 char GetLastChar(const string& s)
@@ -142,38 +148,29 @@ char GetLastChar(const string& s)
 
 bool SessionImpl::FindInSpecialMap(const string& fontName, string& supplier, string& typeface)
 {
-  PathName specialMap;
-  if (!FindFile("special.map", MAP_SEARCH_PATH, specialMap))
-  {
-    MIKTEX_UNEXPECTED();
-  }
+  const FontMap& specialMap = GetFontMap("special.map");
 
-  ifstream reader = File::CreateInputStream(specialMap);
-
-  bool found = false;
-  for (string line; !found && std::getline(reader, line); )
+  // entries may be prefixes of font names: try them in order
+  for (const vector<string>& tokens : specialMap.lines)
   {
-    Tokenizer tok(line, WHITESPACE);
-    if (!tok
-      || !(fontName == *tok
-        || (IsPrefixOf(*tok, fontName)
-          && (IsDecimalDigitAscii(GetLastChar(fontName)))
-          && (!IsDecimalDigitAscii(GetLastChar(*tok))))))
+    const string& name = tokens[0];
+    if (!(fontName == name
+      || (IsPrefixOf(name, fontName)
+        && (IsDecimalDigitAscii(GetLastChar(fontName)))
+        && (!IsDecimalDigitAscii(GetLastChar(name))))))
     {
       continue;
     }
-    ++tok;
-    if (!tok)
+    if (tokens.size() < 2)
     {
       continue;
     }
-    supplier = *tok;
-    ++tok;
-    if (!tok)
+    supplier = tokens[1];
+    if (tokens.size() < 3)
     {
       continue;
     }
-    typeface = *tok;
+    typeface = tokens[2];
     trace_fonts->WriteLine("core", fmt::format(T_("found {0}/{1} in special.map"), Q_(supplier), Q_(typeface)));
     return true;
   }
@@ -386,6 +383,19 @@ bool SessionImpl::GetFontInfo(const string& fontName, string& supplier, string&
   return true;
 }
 
+vector<FontInfo> SessionImpl::GetFontInfos(const vector<string>& fontNames)
+{
+  vector<FontInfo> result;
+  result.reserve(fontNames.size());
+  for (const string& fontName : fontNames)
+  {
+    FontInfo fontInfo;
+    fontInfo.found = GetFontInfo(fontName, fontInfo.supplier, fontInfo.typeface, &fontInfo.genSize);
+    result.push_back(fontInfo);
+  }
+  return result;
+}
+
 vector<string> SessionImpl::GetFontDirectories()
 {
   if (!flags.test((size_t)InternalFlag::CachedSystemFontDirs))
@@ -0,0 +1,313 @@
+/* fontmapindex.cpp: font map indexes
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Core/TemporaryFile>
+
+#include "internal.h"
+
+#include "Session/SessionImpl.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+/*
+ * A font map index is written next to the font map file (pdftex.map =>
+ * pdftex.map.idx):
+ *
+ *   signature version flags tableSize mapFileSize mapFileTime
+ *   table
+ *   { keyLength key textLength text }
+ *
+ * The table is an open-addressing hash table (linear probing) of record
+ * offsets; 0 marks an empty slot.  A record holds the map lines of a
+ * font, separated by newlines.  Numbers are stored as 32-bit words (the
+ * size and the time of the font map file as 64-bit words).  The index is
+ * outdated, if the font map file size or time differ.
+ */
+
+const uint32_t FONT_MAP_INDEX_SIGNATURE = 0x584d464d; // 'MFMX' (the x86 way)
+const uint32_t FONT_MAP_INDEX_VERSION = 1;
+
+const uint32_t FONT_MAP_INDEX_HAS_SUBFONTS = 1;
+
+const size_t FONT_MAP_INDEX_HEADER_SIZE = 4 * 4 + 2 * 8;
+
+MIKTEXSTATICFUNC(PathName) GetFontMapIndexPath(const PathName& mapFile)
+{
+  PathName path(mapFile);
+  path.AppendExtension(".idx");
+  return path;
+}
+
+// FNV-1a
+MIKTEXSTATICFUNC(uint32_t) HashFontName(const char* name, size_t length)
+{
+  uint32_t hash = 2166136261u;
+  for (size_t idx = 0; idx < length; ++idx)
+  {
+    hash ^= static_cast<unsigned char>(name[idx]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+void SessionImpl::WriteFontMapIndex(const PathName& mapFile)
+{
+  vector<unsigned char> bytes = File::ReadAllBytes(mapFile);
+  string text(bytes.begin(), bytes.end());
+
+  // font name => map lines, in file order
+  vector<pair<string, string>> records;
+  unordered_map<string, size_t> recordIndexes;
+  uint32_t flags = 0;
+  size_t pos = 0;
+  while (pos < text.length())
+  {
+    size_t end = text.find('\n', pos);
+    if (end == string::npos)
+    {
+      end = text.length();
+    }
+    string line = text.substr(pos, end - pos);
+    pos = end + 1;
+    if (!line.empty() && line.back() == '\r')
+    {
+      line.pop_back();
+    }
+    size_t start = line.find_first_not_of(" \t");
+    // the comment characters of dvips, dvipdfmx and pdfTeX
+    if (start == string::npos || strchr("%#;*", line[start]) != nullptr)
+    {
+      continue;
+    }
+    size_t keyEnd = line.find_first_of(" \t", start);
+    string key = line.substr(start, keyEnd == string::npos ? string::npos : keyEnd - start);
+    if (key.find('@') != string::npos)
+    {
+      flags |= FONT_MAP_INDEX_HAS_SUBFONTS;
+    }
+    auto it = recordIndexes.find(key);
+    if (it == recordIndexes.end())
+    {
+      recordIndexes[key] = records.size();
+      records.push_back(make_pair(key, line.substr(start)));
+    }
+    else
+    {
+      records[it->second].second += '\n';
+      records[it->second].second += line.substr(start);
+    }
+  }
+
+  uint32_t tableSize = 16;
+  while (tableSize < 2 * records.size())
+  {
+    tableSize *= 2;
+  }
+  vector<uint32_t> table(tableSize, 0);
+  string recordData;
+  size_t recordStart = FONT_MAP_INDEX_HEADER_SIZE + tableSize * sizeof(uint32_t);
+  auto writeWord = [](string& buf, uint32_t word)
+  {
+    buf.append(reinterpret_cast<const char*>(&word), sizeof(word));
+  };
+  for (const auto& record : records)
+  {
+    uint32_t slot = HashFontName(record.first.c_str(), record.first.length()) & (tableSize - 1);
+    while (table[slot] != 0)
+    {
+      slot = (slot + 1) & (tableSize - 1);
+    }
+    if (recordStart + recordData.length() > UINT32_MAX)
+    {
+      MIKTEX_FATAL_ERROR_2(T_("The font map file is too large."), "path", mapFile.ToString());
+    }
+    table[slot] = static_cast<uint32_t>(recordStart + recordData.length());
+    writeWord(recordData, static_cast<uint32_t>(record.first.length()));
+    recordData += record.first;
+    writeWord(recordData, static_cast<uint32_t>(record.second.length()));
+    recordData += record.second;
+  }
+
+  string buf;
+  writeWord(buf, FONT_MAP_INDEX_SIGNATURE);
+  writeWord(buf, FONT_MAP_INDEX_VERSION);
+  writeWord(buf, flags);
+  writeWord(buf, tableSize);
+  uint64_t mapFileSize = bytes.size();
+  buf.append(reinterpret_cast<const char*>(&mapFileSize), sizeof(mapFileSize));
+  int64_t mapFileTime = File::GetLastWriteTime(mapFile);
+  buf.append(reinterpret_cast<const char*>(&mapFileTime), sizeof(mapFileTime));
+  buf.append(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(uint32_t));
+  buf += recordData;
+
+  // other processes might read the index at the same time
+  PathName path = GetFontMapIndexPath(mapFile);
+  PathName tmpPath(path);
+  tmpPath.AppendExtension(".tmp");
+  unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create(tmpPath);
+  FileStream stream(File::Open(tmpPath, FileMode::Create, FileAccess::Write, false));
+  stream.Write(buf.data(), buf.length());
+  stream.Close();
+  File::Move(tmpPath, path, { FileMoveOption::ReplaceExisting });
+  tmpFile->Keep();
+  trace_fonts->WriteLine("core", fmt::format(T_("font map index {0} has been written ({1} fonts)"), Q_(path), records.size()));
+}
+
+shared_ptr<SessionImpl::FontMapIndex> SessionImpl::OpenFontMapIndex(const string& mapFileName)
+{
+  PathName mapFile;
+  if (!FindFile(mapFileName, FileType::MAP, mapFile))
+  {
+    return nullptr;
+  }
+  PathName path = GetFontMapIndexPath(mapFile);
+  if (!File::Exists(path))
+  {
+    return nullptr;
+  }
+  shared_ptr<FontMapIndex> index = make_shared<FontMapIndex>();
+  index->mapping.reset(MemoryMappedFile::Create());
+  index->data = static_cast<const unsigned char*>(index->mapping->Open(path, false));
+  index->size = index->mapping->GetSize();
+  if (index->size < FONT_MAP_INDEX_HEADER_SIZE)
+  {
+    return nullptr;
+  }
+  uint32_t header[4];
+  memcpy(header, index->data, sizeof(header));
+  uint64_t mapFileSize;
+  memcpy(&mapFileSize, index->data + sizeof(header), sizeof(mapFileSize));
+  int64_t mapFileTime;
+  memcpy(&mapFileTime, index->data + sizeof(header) + sizeof(mapFileSize), sizeof(mapFileTime));
+  if (header[0] != FONT_MAP_INDEX_SIGNATURE || header[1] != FONT_MAP_INDEX_VERSION)
+  {
+    return nullptr;
+  }
+  if ((header[2] & FONT_MAP_INDEX_HAS_SUBFONTS) != 0)
+  {
+    trace_fonts->WriteLine("core", fmt::format(T_("font map {0} has subfont entries"), Q_(mapFile)));
+    return nullptr;
+  }
+  if (mapFileSize != File::GetSize(mapFile) || mapFileTime != File::GetLastWriteTime(mapFile))
+  {
+    trace_fonts->WriteLine("core", fmt::format(T_("font map index {0} is outdated"), Q_(path)));
+    return nullptr;
+  }
+  index->tableSize = header[3];
+  if (index->tableSize == 0 || (index->tableSize & (index->tableSize - 1)) != 0 || index->tableSize > (index->size - FONT_MAP_INDEX_HEADER_SIZE) / sizeof(uint32_t))
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  trace_fonts->WriteLine("core", fmt::format(T_("using font map index {0}"), Q_(path)));
+  return index;
+}
+
+FontMapIndexLookup SessionImpl::LookupFontMapIndex(const string& mapFileName, const string& fontName, vector<string>& lines)
+{
+  shared_ptr<FontMapIndex> index;
+  {
+    lock_guard<mutex> lockGuard(fontMapIndexesMutex);
+    auto it = fontMapIndexes.find(mapFileName);
+    if (it == fontMapIndexes.end())
+    {
+      try
+      {
+        index = OpenFontMapIndex(mapFileName);
+      }
+      catch (const MiKTeXException& e)
+      {
+        // not fatal: the font map will be parsed
+        trace_error->WriteLine("core", fmt::format(T_("font map index for {0} could not be read: {1}"), Q_(mapFileName), e.GetErrorMessage()));
+      }
+      fontMapIndexes[mapFileName] = index;
+    }
+    else
+    {
+      index = it->second;
+    }
+  }
+  if (index == nullptr)
+  {
+    return FontMapIndexLookup::NoIndex;
+  }
+  auto getWord = [&index](size_t pos)
+  {
+    if (pos + sizeof(uint32_t) > index->size)
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    uint32_t word;
+    memcpy(&word, index->data + pos, sizeof(word));
+    return word;
+  };
+  uint32_t mask = index->tableSize - 1;
+  uint32_t slot = HashFontName(fontName.c_str(), fontName.length()) & mask;
+  for (uint32_t probes = 0; probes < index->tableSize; ++probes, slot = (slot + 1) & mask)
+  {
+    size_t pos = getWord(FONT_MAP_INDEX_HEADER_SIZE + slot * sizeof(uint32_t));
+    if (pos == 0)
+    {
+      break;
+    }
+    size_t keyLength = getWord(pos);
+    pos += sizeof(uint32_t);
+    if (keyLength > index->size - pos)
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    if (keyLength != fontName.length() || memcmp(index->data + pos, fontName.c_str(), keyLength) != 0)
+    {
+      continue;
+    }
+    pos += keyLength;
+    size_t textLength = getWord(pos);
+    pos += sizeof(uint32_t);
+    if (textLength > index->size - pos)
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    string text(reinterpret_cast<const char*>(index->data + pos), textLength);
+    lines.clear();
+    for (size_t start = 0; start <= text.length(); )
+    {
+      size_t end = text.find('\n', start);
+      if (end == string::npos)
+      {
+        end = text.length();
+      }
+      lines.push_back(text.substr(start, end - start));
+      start = end + 1;
+    }
+    return FontMapIndexLookup::Found;
+  }
+  return FontMapIndexLookup::NotFound;
+}
@@ -0,0 +1,303 @@
+/* fontmetrics.cpp: font metric cache
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/MD5>
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Core/Paths>
+#include <miktex/Core/TemporaryFile>
+
+#include "internal.h"
+
+#include "Session/SessionImpl.h"
+
+using namespace std;
+
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+/*
+ * A font metric cache file holds the character dimensions of a TFM file:
+ *
+ *   signature version checkSum designSize firstChar #chars
+ *   { width height depth } path
+ *
+ * The file name is derived from the font name and from the checksum, so
+ * that a DVI consumer, which knows both from the font definition, finds
+ * the dimensions without searching the TFM file.  Numbers are stored as
+ * 32-bit words, the path is prefixed by its length.
+ */
+
+const uint32_t FONT_METRIC_CACHE_SIGNATURE = 0x4d46544d; // 'MTFM' (the x86 way)
+const uint32_t FONT_METRIC_CACHE_VERSION = 1;
+
+MIKTEXSTATICFUNC(PathName) GetFontMetricCacheFileName(const string& fontName, uint32_t checkSum)
+{
+  return PathName(MD5::FromChars(fmt::format("{0}/{1:08x}", fontName, checkSum)).ToString() + ".tfm.bin");
+}
+
+MIKTEXSTATICFUNC(void) ReadTfmFile(const PathName& path, FontMetrics& metrics)
+{
+  vector<unsigned char> bytes = File::ReadAllBytes(path);
+  auto get = [&bytes, &path](size_t pos, size_t n)
+  {
+    if (pos + n > bytes.size())
+    {
+      MIKTEX_FATAL_ERROR_2(T_("Invalid TFM file."), "path", path.ToString());
+    }
+    uint32_t result = 0;
+    for (size_t idx = 0; idx < n; ++idx)
+    {
+      result = (result << 8) | bytes[pos + idx];
+    }
+    return result;
+  };
+  size_t lh = get(2, 2);
+  int bc = get(4, 2);
+  int ec = get(6, 2);
+  size_t nw = get(8, 2);
+  size_t nh = get(10, 2);
+  size_t nd = get(12, 2);
+  if (get(0, 2) == 0 || lh < 2 || ec + 1 < bc || ec > 255)
+  {
+    MIKTEX_FATAL_ERROR_2(T_("Invalid TFM file."), "path", path.ToString());
+  }
+  metrics.path = path;
+  metrics.checkSum = get(24, 4);
+  metrics.designSize = static_cast<int32_t>(get(28, 4));
+  metrics.firstChar = bc;
+  size_t numChars = ec + 1 - bc;
+  size_t charInfoPos = 24 + lh * 4;
+  size_t widthPos = charInfoPos + numChars * 4;
+  size_t heightPos = widthPos + nw * 4;
+  size_t depthPos = heightPos + nh * 4;
+  metrics.widths.resize(numChars);
+  metrics.heights.resize(numChars);
+  metrics.depths.resize(numChars);
+  for (size_t idx = 0; idx < numChars; ++idx)
+  {
+    size_t widthIndex = get(charInfoPos + idx * 4, 1);
+    size_t heightDepth = get(charInfoPos + idx * 4 + 1, 1);
+    size_t heightIndex = (heightDepth >> 4) & 15;
+    size_t depthIndex = heightDepth & 15;
+    if (widthIndex >= nw || heightIndex >= nh || depthIndex >= nd)
+    {
+      MIKTEX_FATAL_ERROR_2(T_("Invalid TFM file."), "path", path.ToString());
+    }
+    metrics.widths[idx] = static_cast<int32_t>(get(widthPos + widthIndex * 4, 4));
+    metrics.heights[idx] = static_cast<int32_t>(get(heightPos + heightIndex * 4, 4));
+    metrics.depths[idx] = static_cast<int32_t>(get(depthPos + depthIndex * 4, 4));
+  }
+}
+
+vector<PathName> SessionImpl::GetFontMetricCacheDirectories()
+{
+  vector<PathName> result;
+  PathName cacheDir = PathName(MIKTEX_PATH_MIKTEX_CACHE_DIR) / PathName("fontmetrics");
+  if (!IsAdminMode())
+  {
+    result.push_back(GetSpecialPath(SpecialPath::UserDataRoot) / cacheDir);
+  }
+  if (IsSharedSetup() || IsAdminMode())
+  {
+    // the cache files written by the administrator are shared with all
+    // users
+    PathName commonCacheDir = GetSpecialPath(SpecialPath::CommonDataRoot) / cacheDir;
+    if (result.empty() || result[0] != commonCacheDir)
+    {
+      result.push_back(commonCacheDir);
+    }
+  }
+  return result;
+}
+
+bool SessionImpl::ReadFontMetricCacheFile(const PathName& path, uint32_t checkSum, FontMetrics& metrics)
+{
+  unique_ptr<MemoryMappedFile> mapping(MemoryMappedFile::Create());
+  const unsigned char* data = static_cast<const unsigned char*>(mapping->Open(path, false));
+  size_t dataSize = mapping->GetSize();
+  size_t pos = 0;
+  auto read = [data, dataSize, &pos](void* buf, size_t n)
+  {
+    if (n > dataSize - pos)
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    memcpy(buf, data + pos, n);
+    pos += n;
+  };
+  uint32_t signature, version, cachedCheckSum, numChars, length;
+  read(&signature, sizeof(signature));
+  read(&version, sizeof(version));
+  if (signature != FONT_METRIC_CACHE_SIGNATURE || version != FONT_METRIC_CACHE_VERSION)
+  {
+    return false;
+  }
+  read(&cachedCheckSum, sizeof(cachedCheckSum));
+  if (cachedCheckSum != checkSum)
+  {
+    return false;
+  }
+  metrics.checkSum = cachedCheckSum;
+  read(&metrics.designSize, sizeof(metrics.designSize));
+  int32_t firstChar;
+  read(&firstChar, sizeof(firstChar));
+  metrics.firstChar = firstChar;
+  read(&numChars, sizeof(numChars));
+  if (numChars > 256)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  metrics.widths.resize(numChars);
+  metrics.heights.resize(numChars);
+  metrics.depths.resize(numChars);
+  for (size_t idx = 0; idx < numChars; ++idx)
+  {
+    read(&metrics.widths[idx], sizeof(int32_t));
+    read(&metrics.heights[idx], sizeof(int32_t));
+    read(&metrics.depths[idx], sizeof(int32_t));
+  }
+  read(&length, sizeof(length));
+  string tfmPath(length, '\0');
+  read(&tfmPath[0], length);
+  metrics.path = tfmPath;
+  if (pos != dataSize)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  return true;
+}
+
+void SessionImpl::WriteFontMetricCacheFile(const PathName& path, const FontMetrics& metrics)
+{
+  string buf;
+  auto write = [&buf](const void* data, size_t n)
+  {
+    buf.append(reinterpret_cast<const char*>(data), n);
+  };
+  uint32_t word = FONT_METRIC_CACHE_SIGNATURE;
+  write(&word, sizeof(word));
+  word = FONT_METRIC_CACHE_VERSION;
+  write(&word, sizeof(word));
+  write(&metrics.checkSum, sizeof(metrics.checkSum));
+  write(&metrics.designSize, sizeof(metrics.designSize));
+  int32_t firstChar = metrics.firstChar;
+  write(&firstChar, sizeof(firstChar));
+  word = static_cast<uint32_t>(metrics.widths.size());
+  write(&word, sizeof(word));
+  for (size_t idx = 0; idx < metrics.widths.size(); ++idx)
+  {
+    write(&metrics.widths[idx], sizeof(int32_t));
+    write(&metrics.heights[idx], sizeof(int32_t));
+    write(&metrics.depths[idx], sizeof(int32_t));
+  }
+  string tfmPath = metrics.path.ToString();
+  word = static_cast<uint32_t>(tfmPath.length());
+  write(&word, sizeof(word));
+  write(tfmPath.c_str(), tfmPath.length());
+  Directory::Create(path.GetDirectoryName());
+  // other processes might read the cache file at the same time
+  PathName tmpPath(path);
+  tmpPath.AppendExtension(".tmp");
+  unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create(tmpPath);
+  FileStream stream(File::Open(tmpPath, FileMode::Create, FileAccess::Write, false));
+  stream.Write(buf.data(), buf.length());
+  stream.Close();
+  File::Move(tmpPath, path, { FileMoveOption::ReplaceExisting });
+  tmpFile->Keep();
+}
+
+bool SessionImpl::GetFontMetrics(const string& fontName, uint32_t checkSum, FontMetrics& metrics)
+{
+  string key = fmt::format("{0}/{1:08x}", fontName, checkSum);
+  {
+    lock_guard<mutex> lockGuard(fontMetricsMutex);
+    auto it = fontMetrics.find(key);
+    if (it != fontMetrics.end())
+    {
+      metrics = it->second;
+      return true;
+    }
+  }
+  // a checksum of zero does not identify the TFM file
+  vector<PathName> cacheDirectories;
+  if (checkSum != 0)
+  {
+    cacheDirectories = GetFontMetricCacheDirectories();
+  }
+  bool found = false;
+  for (const PathName& dir : cacheDirectories)
+  {
+    PathName path = dir / GetFontMetricCacheFileName(fontName, checkSum);
+    if (!File::Exists(path))
+    {
+      continue;
+    }
+    try
+    {
+      found = ReadFontMetricCacheFile(path, checkSum, metrics);
+    }
+    catch (const MiKTeXException& e)
+    {
+      // not fatal: the TFM file will be read
+      trace_error->WriteLine("core", fmt::format(T_("font metric cache file {0} could not be read: {1}"), Q_(path), e.GetErrorMessage()));
+    }
+    if (found)
+    {
+      trace_fonts->WriteLine("core", fmt::format(T_("using font metric cache file {0}"), Q_(path)));
+      break;
+    }
+  }
+  if (!found)
+  {
+    PathName tfmPath;
+    if (!FindTfmFile(fontName, tfmPath, false))
+    {
+      return false;
+    }
+    ReadTfmFile(tfmPath, metrics);
+    if (!cacheDirectories.empty() && metrics.checkSum == checkSum)
+    {
+      PathName path = cacheDirectories[0] / GetFontMetricCacheFileName(fontName, checkSum);
+      try
+      {
+        WriteFontMetricCacheFile(path, metrics);
+        trace_fonts->WriteLine("core", fmt::format(T_("font metric cache file {0} has been written"), Q_(path)));
+      }
+      catch (const MiKTeXException& e)
+      {
+        // not fatal: the TFM file will be read again next time
+        trace_error->WriteLine("core", fmt::format(T_("font metric cache file {0} could not be written: {1}"), Q_(path), e.GetErrorMessage()));
+      }
+    }
+  }
+  lock_guard<mutex> lockGuard(fontMetricsMutex);
+  fontMetrics[key] = metrics;
+  return true;
+}
@@ -21,13 +21,24 @@
 
 #include "config.h"
 
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Paths>
+#include <miktex/Core/TemporaryFile>
+
 #include "internal.h"
 
 #include "Session/SessionImpl.h"
 
 using namespace std;
 
+using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
 
 bool SessionImpl::FindGraphicsRule(const string& fromExt, const string& toExt, string& rule)
@@ -51,8 +62,30 @@ bool SessionImpl::ConvertToBitmapFile(const PathName& sourceFileName, PathName&
     MIKTEX_FATAL_ERROR_2(T_("No conversion rule found."), "path", sourceFileName.ToString());
   }
 
+  // converted files are cached by the digest of the source file and
+  // the rule
+  PathName cachedFile;
+  try
+  {
+    string key = MD5::FromFile(sourceFileName).ToString() + "\n" + rule;
+    cachedFile = GetSpecialPath(IsAdminMode() ? SpecialPath::CommonDataRoot : SpecialPath::UserDataRoot)
+      / PathName(MIKTEX_PATH_MIKTEX_CACHE_DIR) / PathName("graphics") / PathName(MD5::FromChars(key).ToString() + ".bmp");
+  }
+  catch (const MiKTeXException& e)
+  {
+    // not fatal: nothing will be cached
+    trace_process->WriteLine("core", TraceLevel::Warning, fmt::format(T_("{0} cannot be cached: {1}"), Q_(sourceFileName), e.GetErrorMessage()));
+  }
+
   destFileName.SetToTempFile();
 
+  if (!cachedFile.Empty() && File::Exists(cachedFile))
+  {
+    trace_process->WriteLine("core", fmt::format(T_("using cached conversion {0}"), Q_(cachedFile)));
+    File::Copy(cachedFile, destFileName);
+    return true;
+  }
+
   string commandLine;
 
   for (const char* lpsz = rule.c_str(); *lpsz != 0; ++lpsz)
@@ -82,6 +115,24 @@ bool SessionImpl::ConvertToBitmapFile(const PathName& sourceFileName, PathName&
   {
     File::Delete(destFileName, { FileDeleteOption::TryHard });
   }
+  else if (!cachedFile.Empty())
+  {
+    try
+    {
+      Directory::Create(cachedFile.GetDirectoryName());
+      PathName tmpPath = cachedFile;
+      tmpPath.AppendExtension(".tmp");
+      unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create(tmpPath);
+      File::Copy(destFileName, tmpPath);
+      File::Move(tmpPath, cachedFile, { FileMoveOption::ReplaceExisting });
+      tmpFile->Keep();
+    }
+    catch (const MiKTeXException& e)
+    {
+      // not fatal: the file will be converted again next time
+      trace_process->WriteLine("core", TraceLevel::Warning, fmt::format(T_("{0} could not be cached: {1}"), Q_(destFileName), e.GetErrorMessage()));
+    }
+  }
 
   return done;
 }
@@ -47,10 +47,12 @@ extern char** environ;
 #include <miktex/Core/Environment>
 #include <miktex/Core/Paths>
 #include <miktex/Core/TemporaryDirectory>
+#include <miktex/Util/StartupProfile>
 
 #include "internal.h"
 
 #include "Session/SessionImpl.h"
+#include "Utils/CoreStopWatch.h"
 
 #if defined(MIKTEX_WINDOWS)
 #  include "win/winRegistry.h"
@@ -68,6 +70,7 @@ weak_ptr<SessionImpl> SessionImpl::theSession;
 shared_ptr<Session> Session::Create(const Session::InitInfo& initInfo)
 {
   MIKTEX_EXPECT(SessionImpl::theSession.expired());
+  StartupProfileSection startupProfileSection("Session::Create");
   shared_ptr<SessionImpl> session = make_shared<SessionImpl>();
   SessionImpl::theSession = session;
   session->Initialize(initInfo);
@@ -126,6 +129,8 @@ SessionImpl::~SessionImpl()
 
 void SessionImpl::Initialize(const Session::InitInfo& initInfo)
 {
+  StartupProfileSection startupProfileSection("SessionImpl::Initialize");
+
   adminMode = initInfo.GetOptions()[InitOption::AdminMode];
   if (!adminMode)
   {
@@ -143,9 +148,6 @@ void SessionImpl::Initialize(const Session::InitInfo& initInfo)
 
   initialized = true;
 
-  fsWatcher = FileSystemWatcher::Create();
-  fsWatcher->Start();
-
   this->initInfo = initInfo;
 
   theNameOfTheGame = initInfo.GetTheNameOfTheGame();
@@ -173,9 +175,17 @@ void SessionImpl::Initialize(const Session::InitInfo& initInfo)
     TraceStream::SetOptions(traceOptions);
   }
 
-  InitializeStartupConfig();
+  {
+    CoreStopWatch stopWatch(CoreTimer::InitializeStartupConfig);
+    StartupProfileSection startupProfileSection("startup configuration");
+    InitializeStartupConfig();
+  }
 
-  InitializeRootDirectories(initStartupConfig, false);
+  {
+    CoreStopWatch stopWatch(CoreTimer::InitializeRootDirectories);
+    StartupProfileSection startupProfileSection("root directories");
+    InitializeRootDirectories(initStartupConfig, false);
+  }
 
   Utils::GetEnvironmentString(MIKTEX_ENV_PACKAGE_LIST_FILE, packageHistoryFile);
 
@@ -223,6 +233,26 @@ void SessionImpl::Initialize(const Session::InitInfo& initInfo)
 #endif
 }
 
+shared_ptr<FileSystemWatcher> SessionImpl::GetFileSystemWatcher()
+{
+  if (haveFileSystemWatcher)
+  {
+    return fsWatcher;
+  }
+  haveFileSystemWatcher = true;
+  // processes which don't need immediate change notifications (e.g.,
+  // many concurrent engine runs) can save the watcher thread; the FNDB
+  // change files are polled instead
+  string fndbPoll;
+  if (!Utils::GetEnvironmentString(MIKTEX_ENV_FNDB_POLL, fndbPoll))
+  {
+    CoreStopWatch stopWatch(CoreTimer::StartFileSystemWatcher);
+    fsWatcher = FileSystemWatcher::Create();
+    fsWatcher->Start();
+  }
+  return fsWatcher;
+}
+
 void SessionImpl::RecordMaintenance()
 {
   time_t now = time(nullptr);
@@ -252,11 +282,15 @@ void SessionImpl::Close()
     fsWatcher->Stop();
     fsWatcher = nullptr;
   }
+  haveFileSystemWatcher = false;
   CheckOpenFiles();
   WritePackageHistory();
   inputDirectories.clear();
+  trace_config->WriteLine("core", fmt::format(T_("memoized configuration values: {0} hits, {1} misses"), memoizedValueHits.load(), memoizedValueMisses.load()));
   UnregisterLibraryTraceStreams();
   configurationSettings.clear();
+  memoizedValues.clear();
+  BumpConfigGeneration();
 }
 
 void SessionImpl::ScheduleSystemCommand(const std::string& commandLine)
@@ -380,56 +414,108 @@ void SessionImpl::Reset()
   this->onFinishScript = move(onFinishScript);
 }
 
-unordered_map<string, string> SessionImpl::CreateChildEnvironment(bool changeDirectory)
-{
-  unordered_map<string, string> envMap;
-
 #if defined(MIKTEX_WINDOWS)
+MIKTEXSTATICFUNC(wstring) SnapshotEnvironment()
+{
   auto environmentStrings = GetEnvironmentStringsW();
   MIKTEX_AUTO(FreeEnvironmentStringsW(environmentStrings));
-  for (const wchar_t* env = environmentStrings; *env != 0; ++env)
+  const wchar_t* end = environmentStrings;
+  while (*end != 0)
   {
-    wstring name;
-    if (*env == L'=')
-    {
-      name += *env++;
-    }
-    for (; *env != L'=' && *env != 0; ++env)
-    {
-      name += *env;
-    }
-    if (*env == L'=')
-    {
-      ++env;
-    }
-    wstring value;
-    for (; *env != 0; ++env)
+    end += wcslen(end) + 1;
+  }
+  return wstring(environmentStrings, end);
+}
+
+MIKTEXSTATICFUNC(bool) IsSameEnvironment(const wstring& environmentStrings)
+{
+  auto current = GetEnvironmentStringsW();
+  MIKTEX_AUTO(FreeEnvironmentStringsW(current));
+  size_t pos = 0;
+  for (const wchar_t* env = current; *env != 0; env += wcslen(env) + 1)
+  {
+    size_t len = wcslen(env);
+    if (pos + len >= environmentStrings.length() || environmentStrings.compare(pos, len, env) != 0 || environmentStrings[pos + len] != 0)
     {
-      value += *env;
+      return false;
     }
-    envMap[WU_(name)] = WU_(value);
+    pos += len + 1;
   }
+  return pos == environmentStrings.length();
+}
 #else
+MIKTEXSTATICFUNC(string) SnapshotEnvironment()
+{
+  string environmentStrings;
   for (char** env = environ; *env != nullptr; ++env)
   {
-    string name;
-    auto s = *env;
-    for (; *s != '=' && *s != 0; ++s)
-    {
-      name += *s;
-    }
-    if (*s == '=')
-    {
-      ++s;
-    }
-    string value;
-    for (; *s != 0; ++s)
+    environmentStrings += *env;
+    environmentStrings += '\0';
+  }
+  return environmentStrings;
+}
+
+MIKTEXSTATICFUNC(bool) IsSameEnvironment(const string& environmentStrings)
+{
+  size_t pos = 0;
+  for (char** env = environ; *env != nullptr; ++env)
+  {
+    size_t len = strlen(*env);
+    if (pos + len >= environmentStrings.length() || environmentStrings.compare(pos, len, *env) != 0 || environmentStrings[pos + len] != 0)
     {
-      value += *s;
+      return false;
     }
-    envMap[name] = value;
+    pos += len + 1;
   }
+  return pos == environmentStrings.length();
+}
+#endif
+
+shared_ptr<const unordered_map<string, string>> SessionImpl::CreateChildEnvironment(bool changeDirectory)
+{
+  vector<string> cwdList;
+  for (const PathName& dir : inputDirectories)
+  {
+    cwdList.push_back(dir.ToString());
+  }
+  if (changeDirectory)
+  {
+    cwdList.push_back(PathName().SetToCurrentDirectory().ToString());
+  }
+  string flatCwdList = StringUtil::Flatten(cwdList, PathNameUtil::PathNameDelimiter);
+  bool adminMode = IsAdminMode();
+  lock_guard<mutex> lockGuard(childEnvironmentMutex);
+  ChildEnvironmentCache& cache = childEnvironmentCache;
+  if (cache.envMap != nullptr && cache.adminMode == adminMode && cache.cwdList == flatCwdList && IsSameEnvironment(cache.environmentStrings))
+  {
+    return cache.envMap;
+  }
+  cache.environmentStrings = SnapshotEnvironment();
+  cache.cwdList = flatCwdList;
+  cache.adminMode = adminMode;
+  cache.envMap = make_shared<const unordered_map<string, string>>(MakeChildEnvironment(cache.environmentStrings, flatCwdList));
+  return cache.envMap;
+}
+
+unordered_map<string, string> SessionImpl::MakeChildEnvironment(const EnvironmentStrings& environmentStrings, const string& cwdList)
+{
+  unordered_map<string, string> envMap;
+
+  typedef EnvironmentStrings::value_type CharType;
+  for (size_t pos = 0; pos < environmentStrings.length();)
+  {
+    size_t end = environmentStrings.find(CharType(0), pos);
+    // search from pos + 1: Windows has names like "=C:"
+    size_t equal = min(environmentStrings.find(CharType('='), pos + 1), end);
+    auto name = environmentStrings.substr(pos, equal - pos);
+    auto value = equal < end ? environmentStrings.substr(equal + 1, end - equal - 1) : EnvironmentStrings();
+#if defined(MIKTEX_WINDOWS)
+    envMap[WU_(name)] = WU_(value);
+#else
+    envMap[name] = value;
 #endif
+    pos = end + 1;
+  }
 
   envMap["TEXSYSTEM"] = "miktex";
 
@@ -521,16 +607,7 @@ unordered_map<string, string> SessionImpl::CreateChildEnvironment(bool changeDir
     }
   }
 
-  vector<string> cwdList;
-  for (const PathName& dir : inputDirectories)
-  {
-    cwdList.push_back(dir.ToString());
-  }
-  if (changeDirectory)
-  {
-    cwdList.push_back(PathName().SetToCurrentDirectory().ToString());
-  }
-  envMap[MIKTEX_ENV_CWD_LIST] = StringUtil::Flatten(cwdList, PathNameUtil::PathNameDelimiter);
+  envMap[MIKTEX_ENV_CWD_LIST] = cwdList;
 
   if (!initInfo.GetOptions()[InitOption::NoFixPath])
   {
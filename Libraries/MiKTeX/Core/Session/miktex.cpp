@@ -33,6 +33,7 @@
 #include <miktex/Core/FileStream>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Urls>
+#include <miktex/Core/WorkingDirectoryContext>
 #include <miktex/Trace/Trace>
 
 #include "internal.h"
@@ -42,6 +43,7 @@
 #endif
 
 #include "Session/SessionImpl.h"
+#include "Utils/CoreStopWatch.h"
 
 #if defined(MIKTEX_WINDOWS)
 #  include "win/winRegistry.h"
@@ -100,6 +102,7 @@ void SessionImpl::RegisterLibraryTraceStreams()
   trace_mmap = TraceStream::Open(MIKTEX_TRACE_MMAP, callback);
   trace_process = TraceStream::Open(MIKTEX_TRACE_PROCESS, callback);
   trace_stopwatch = TraceStream::Open(MIKTEX_TRACE_STOPWATCH, callback);
+  CoreStopWatch::SetTraceStream(trace_stopwatch.get());
   trace_tempfile = TraceStream::Open(MIKTEX_TRACE_TEMPFILE, callback);
   trace_values = TraceStream::Open(MIKTEX_TRACE_VALUES, callback);
 };
@@ -117,6 +120,8 @@ void SessionImpl::UnregisterLibraryTraceStreams()
   trace_fonts->Close();
   trace_mem->Close();
   trace_process->Close();
+  CoreStopWatch::TraceCounters();
+  CoreStopWatch::SetTraceStream(nullptr);
   trace_stopwatch->Close();
   trace_tempfile->Close();
   trace_values->Close();
@@ -711,6 +716,21 @@ void SessionImpl::AddInputDirectory(const PathName& path, bool atEnd)
 
 bool SessionImpl::GetWorkingDirectory(unsigned n, PathName& path)
 {
+  const WorkingDirectoryContext* context = WorkingDirectoryContext::GetCurrent();
+  if (context != nullptr)
+  {
+    const vector<PathName>& contextInputDirectories = context->GetInputDirectories();
+    if (n == contextInputDirectories.size() + 1)
+    {
+      return false;
+    }
+    if (n > contextInputDirectories.size() + 1)
+    {
+      INVALID_ARGUMENT("index", std::to_string(n));
+    }
+    path = n == 0 ? context->GetWorkingDirectory() : contextInputDirectories[n - 1];
+    return true;
+  }
   if (n == inputDirectories.size() + 1)
   {
     return false;
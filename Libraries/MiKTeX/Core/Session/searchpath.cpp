@@ -25,6 +25,7 @@
 #include <fmt/ostream.h>
 
 #include <miktex/Core/Directory>
+#include <miktex/Core/WorkingDirectoryContext>
 #include <miktex/Trace/Trace>
 #include <miktex/Trace/TraceStream>
 
@@ -117,7 +118,7 @@ void SessionImpl::PushBackPath(vector<PathName>& pathNames, const PathName& path
         trace_error->WriteLine("core", TraceLevel::Error, fmt::format(T_("{0} is not fully qualified"), Q_(pathFQ)));
         continue;
       }
-      if (PathName::Compare(path, PathName(CURRENT_DIRECTORY)) != 0)
+      if (PathName::Compare(path.GetData(), CURRENT_DIRECTORY) != 0)
       {
         pathFQ /= path;
       }
@@ -178,29 +179,45 @@ void SessionImpl::TraceDirectoryPatterns(const std::string& fileType, const vect
   }
 }
 
-vector<PathName> SessionImpl::GetDirectoryPatterns(FileType fileType)
+vector<PathName> SessionImpl::MakeDirectoryPatterns(const InternalFileTypeInfo& fti)
 {
-  InternalFileTypeInfo* fti = GetInternalFileTypeInfo(fileType);
-  if (fti->pathPatterns.empty())
+  vector<PathName> pathPatterns;
+  for (const string& env : fti.envVarNames)
   {
-    for (const string& env : fti->envVarNames)
+    string searchPath;
+    if (Utils::GetEnvironmentString(env, searchPath))
     {
-      string searchPath;
-      if (Utils::GetEnvironmentString(env, searchPath))
+      for (const string& s : StringUtil::Split(searchPath, PathNameUtil::PathNameDelimiter))
       {
-        for (const string& s : StringUtil::Split(searchPath, PathNameUtil::PathNameDelimiter))
-        {
-          PushBackPath(fti->pathPatterns, PathName(s));
-        }
+        PushBackPath(pathPatterns, PathName(s));
       }
     }
-    for (const string& s : fti->searchPath)
-    {
-      PushBackPath(fti->pathPatterns, PathName(s));
-    }
-    TraceDirectoryPatterns(fti->fileTypeString, fti->pathPatterns);
   }
-  return fti->pathPatterns;
+  for (const string& s : fti.searchPath)
+  {
+    PushBackPath(pathPatterns, PathName(s));
+  }
+  return pathPatterns;
+}
+
+vector<PathName> SessionImpl::GetDirectoryPatterns(FileType fileType)
+{
+  const InternalFileTypeInfo* fti = GetInternalFileTypeInfo(fileType);
+  if (WorkingDirectoryContext::GetCurrent() != nullptr)
+  {
+    // relative search path entries depend on the working directories
+    // of this thread: don't cache
+    return MakeDirectoryPatterns(*fti);
+  }
+  lock_guard<recursive_mutex> lockGuard(lazyStateMutex);
+  InternalFileTypeInfo& info = fileTypes[(size_t)fileType];
+  if (!info.havePathPatterns)
+  {
+    info.pathPatterns = MakeDirectoryPatterns(info);
+    TraceDirectoryPatterns(info.fileTypeString, info.pathPatterns);
+    info.havePathPatterns = true;
+  }
+  return info.pathPatterns;
 }
 
 string SessionImpl::GetExpandedSearchPath(FileType fileType)
@@ -210,6 +227,11 @@ string SessionImpl::GetExpandedSearchPath(FileType fileType)
 }
 
 void SessionImpl::DirectoryWalk(const PathName& directory, const PathName& pathPattern, vector<PathName>& paths)
+{
+  DirectoryWalk(directory, pathPattern, paths, DirectoryLister::ReadDirectory(directory, nullptr, (int)DirectoryLister::Options::DirectoriesOnly));
+}
+
+void SessionImpl::DirectoryWalk(const PathName& directory, const PathName& pathPattern, vector<PathName>& paths, const vector<DirectoryEntry>& subdirEntries)
 {
   if (pathPattern.Empty())
   {
@@ -219,26 +241,26 @@ void SessionImpl::DirectoryWalk(const PathName& directory, const PathName& pathP
   {
     ExpandPathPattern(directory, pathPattern, paths);
   }
-  unique_ptr<DirectoryLister> dirLister = DirectoryLister::Open(directory, nullptr, (int)DirectoryLister::Options::DirectoriesOnly);
-  DirectoryEntry entry;
   vector<PathName> subdirs;
-  while (dirLister->GetNext(entry))
+  subdirs.reserve(subdirEntries.size());
+  for (const DirectoryEntry& entry : subdirEntries)
   {
     MIKTEX_ASSERT(entry.isDirectory);
     PathName subdir(directory);
     subdir /= entry.name;
-    subdirs.push_back(subdir);
+    subdirs.push_back(std::move(subdir));
   }
-  dirLister->Close();
-  // TODO: async?
-  for (const PathName& subdir : subdirs)
+  // read the sibling directories concurrently; the walk itself stays
+  // sequential, so that the order of the result doesn't change
+  vector<vector<DirectoryEntry>> subsubdirEntries = DirectoryLister::ReadDirectories(subdirs, nullptr, (int)DirectoryLister::Options::DirectoriesOnly);
+  for (size_t idx = 0; idx < subdirs.size(); ++idx)
   {
     if (!pathPattern.Empty())
     {
-      ExpandPathPattern(subdir, pathPattern, paths);
+      ExpandPathPattern(subdirs[idx], pathPattern, paths);
     }
     // RECURSION
-    DirectoryWalk(subdir, pathPattern, paths);
+    DirectoryWalk(subdirs[idx], pathPattern, paths, subsubdirEntries[idx]);
   }
 }
 
@@ -261,7 +283,7 @@ void SessionImpl::ExpandPathPattern(const PathName& rootDirectory, const PathNam
   {
     // recursion; decompose the path pattern into two parts:
     // (1) sub directory (2) smaller (possibly empty) path pattern
-    string subDir(pathPattern.GetData(), lpszRecursionIndicator - pathPattern.GetData());
+    PathNameView subDir(pathPattern.GetData(), lpszRecursionIndicator - pathPattern.GetData());
     const char* lpszSmallerPathPattern = lpszRecursionIndicator + RECURSION_INDICATOR_LENGTH;
     for (; PathNameUtil::IsDirectoryDelimiter(*lpszSmallerPathPattern); ++lpszSmallerPathPattern)
     {
@@ -283,18 +305,21 @@ vector<PathName> SessionImpl::ExpandPathPatterns(const string& toBeExpanded)
   {
     PathName comparablePathPattern(pattern);
     comparablePathPattern.TransformForComparison();
-    SearchPathDictionary::const_iterator it2 = expandedPathPatterns.find(comparablePathPattern.GetData());
-    if (it2 == expandedPathPatterns.end())
     {
-      vector<PathName> paths2;
-      ExpandPathPattern(PathName(), pattern, paths2);
-      expandedPathPatterns[comparablePathPattern.GetData()] = paths2;
-      pathNames.insert(pathNames.end(), paths2.begin(), paths2.end());
-    }
-    else
-    {
-      pathNames.insert(pathNames.end(), it2->second.begin(), it2->second.end());
+      shared_lock<shared_mutex> readLock(lookupCachesMutex);
+      SearchPathDictionary::const_iterator it2 = expandedPathPatterns.find(comparablePathPattern.GetData());
+      if (it2 != expandedPathPatterns.end())
+      {
+        pathNames.insert(pathNames.end(), it2->second.begin(), it2->second.end());
+        continue;
+      }
     }
+    vector<PathName> paths2;
+    ExpandPathPattern(PathName(), pattern, paths2);
+    pathNames.insert(pathNames.end(), paths2.begin(), paths2.end());
+    // cached entries are never replaced: see SearchFileSystem()
+    unique_lock<shared_mutex> writeLock(lookupCachesMutex);
+    expandedPathPatterns.insert(make_pair(comparablePathPattern.ToString(), std::move(paths2)));
   }
   return pathNames;
 }
@@ -0,0 +1,193 @@
+/* sharedcache.cpp: cross-user cache of generated files
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Configuration/ConfigNames>
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Paths>
+#include <miktex/Core/TemporaryFile>
+#include <miktex/Core/Utils>
+
+#include "internal.h"
+
+#include "Session/SessionImpl.h"
+
+using namespace std;
+
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+/*
+ * The shared cache is a directory which holds files generated by
+ * TryCreateFile() (formats, TFM files) for all users of a shared
+ * setup:
+ *
+ *   objects/<digest>                      the file contents
+ *   index/<file type>[/<engine>]/<name>   relative path and digest
+ *
+ * The relative path tells where the file lives below a TEXMF root
+ * directory.  A cached file is copied into the data root directory of
+ * the user; it is only used if its digest matches and if it is newer
+ * than the package database.
+ */
+
+inline bool IsSharedCacheFileType(FileType fileType)
+{
+  return fileType == FileType::BASE || fileType == FileType::FMT || fileType == FileType::MEM || fileType == FileType::TFM;
+}
+
+PathName SessionImpl::GetSharedCacheEntryPath(const PathName& cacheDirectory, const string& fileName, FileType fileType)
+{
+  PathName entryPath = cacheDirectory / PathName("index") / PathName(GetFileTypeInfo(fileType).fileTypeString);
+  if (fileType == FileType::FMT)
+  {
+    entryPath /= GetEngineName();
+  }
+  return entryPath / PathName(fileName).GetFileName();
+}
+
+bool SessionImpl::TryGetFromSharedCache(const string& fileName, FileType fileType)
+{
+  PathName cacheDirectory(GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_SHARED_CACHE_DIRECTORY, ConfigValue("")).GetString());
+  if (cacheDirectory.Empty() || !IsSharedCacheFileType(fileType))
+  {
+    return false;
+  }
+  PathName entryPath = GetSharedCacheEntryPath(cacheDirectory, fileName, fileType);
+  try
+  {
+    if (!File::Exists(entryPath))
+    {
+      return false;
+    }
+    // the file must have been made after the last package update
+    time_t entryTime = File::GetLastWriteTime(entryPath);
+    PathName commonPackagesIni(GetSpecialPath(SpecialPath::CommonInstallRoot), PathName(MIKTEX_PATH_PACKAGES_INI));
+    if (File::Exists(commonPackagesIni) && File::GetLastWriteTime(commonPackagesIni) > entryTime)
+    {
+      return false;
+    }
+    if (!IsAdminMode())
+    {
+      PathName userPackagesIni(GetSpecialPath(SpecialPath::UserInstallRoot), PathName(MIKTEX_PATH_PACKAGES_INI));
+      if (File::Exists(userPackagesIni) && File::GetLastWriteTime(userPackagesIni) > entryTime)
+      {
+        return false;
+      }
+    }
+    ifstream stream = File::CreateInputStream(entryPath, ios_base::in, ios_base::badbit);
+    string relPath;
+    string digest;
+    if (!getline(stream, relPath) || !getline(stream, digest) || relPath.empty() || PathNameUtil::IsAbsolutePath(relPath) || relPath.find("..") != string::npos)
+    {
+      trace_filesearch->WriteLine("core", TraceLevel::Warning, fmt::format(T_("ignoring bad shared cache entry {0}"), Q_(entryPath)));
+      return false;
+    }
+    stream.close();
+    PathName objectPath = cacheDirectory / PathName("objects") / PathName(digest);
+    if (!File::Exists(objectPath) || MD5::FromFile(objectPath).ToString() != digest)
+    {
+      trace_filesearch->WriteLine("core", TraceLevel::Warning, fmt::format(T_("shared cache object {0} is missing or damaged"), Q_(objectPath)));
+      return false;
+    }
+    PathName dest = GetSpecialPath(IsAdminMode() ? SpecialPath::CommonDataRoot : SpecialPath::UserDataRoot) / PathName(relPath);
+    Directory::Create(dest.GetDirectoryName());
+    PathName tmpPath = dest;
+    tmpPath.AppendExtension(".tmp");
+    unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create(tmpPath);
+    File::Copy(objectPath, tmpPath);
+    File::Move(tmpPath, dest, { FileMoveOption::ReplaceExisting });
+    tmpFile->Keep();
+    if (!Fndb::FileExists(dest))
+    {
+      Fndb::Add({ { dest } });
+    }
+    trace_filesearch->WriteLine("core", fmt::format(T_("{0} has been taken from the shared cache"), Q_(dest)));
+    return true;
+  }
+  catch (const MiKTeXException& e)
+  {
+    // not fatal: the file will be made
+    trace_filesearch->WriteLine("core", TraceLevel::Warning, fmt::format(T_("{0} could not be taken from the shared cache: {1}"), Q_(fileName), e.GetErrorMessage()));
+    return false;
+  }
+}
+
+void SessionImpl::PutIntoSharedCache(const string& fileName, FileType fileType, const PathName& path)
+{
+  PathName cacheDirectory(GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_SHARED_CACHE_DIRECTORY, ConfigValue("")).GetString());
+  if (cacheDirectory.Empty() || !IsSharedCacheFileType(fileType))
+  {
+    return;
+  }
+  unsigned r = TryDeriveTEXMFRoot(path);
+  if (r == INVALID_ROOT_INDEX)
+  {
+    return;
+  }
+  const char* relPath = Utils::GetRelativizedPath(path.GetData(), GetRootDirectoryPath(r).GetData());
+  if (relPath == nullptr)
+  {
+    return;
+  }
+  PathName entryPath = GetSharedCacheEntryPath(cacheDirectory, fileName, fileType);
+  try
+  {
+    string digest = MD5::FromFile(path).ToString();
+    PathName objectPath = cacheDirectory / PathName("objects") / PathName(digest);
+    if (!File::Exists(objectPath))
+    {
+      Directory::Create(objectPath.GetDirectoryName());
+      PathName tmpPath = objectPath;
+      tmpPath.AppendExtension(".tmp");
+      unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create(tmpPath);
+      File::Copy(path, tmpPath);
+      File::Move(tmpPath, objectPath, { FileMoveOption::ReplaceExisting });
+      tmpFile->Keep();
+    }
+    // the entry is written last, so that it never refers to a
+    // missing object
+    Directory::Create(entryPath.GetDirectoryName());
+    PathName tmpPath = entryPath;
+    tmpPath.AppendExtension(".tmp");
+    unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create(tmpPath);
+    ofstream stream = File::CreateOutputStream(tmpPath, ios_base::out, ios_base::badbit | ios_base::failbit);
+    stream << relPath << "\n" << digest << "\n";
+    stream.close();
+    File::Move(tmpPath, entryPath, { FileMoveOption::ReplaceExisting });
+    tmpFile->Keep();
+    trace_filesearch->WriteLine("core", fmt::format(T_("{0} has been put into the shared cache"), Q_(path)));
+  }
+  catch (const MiKTeXException& e)
+  {
+    // not fatal: the shared cache may be read-only for this user
+    trace_filesearch->WriteLine("core", fmt::format(T_("{0} could not be put into the shared cache: {1}"), Q_(path), e.GetErrorMessage()));
+  }
+}
@@ -31,6 +31,7 @@
 #include <miktex/Core/Paths>
 #include <miktex/Core/RootDirectoryInfo>
 #include <miktex/Util/DateUtil>
+#include <miktex/Util/StartupProfile>
 
 #include "internal.h"
 
@@ -41,6 +42,7 @@
 
 #include "Fndb/FileNameDatabase.h"
 #include "Session/SessionImpl.h"
+#include "Utils/CoreStopWatch.h"
 
 using namespace std;
 
@@ -861,7 +863,10 @@ shared_ptr<FileNameDatabase> SessionImpl::GetFileNameDatabase(unsigned r)
 
   trace_fndb->WriteLine("core", fmt::format(T_("loading fndb: {0}"), fqFndbFileName.ToDisplayString()));
 
-  shared_ptr<FileNameDatabase> pFndb = FileNameDatabase::Create(fqFndbFileName, root.get_Path(), fsWatcher);
+  CoreStopWatch stopWatch(CoreTimer::LoadFndb, [&fqFndbFileName]() { return fmt::format(T_("loading fndb {0}"), Q_(fqFndbFileName)); });
+  StartupProfileSection startupProfileSection(fmt::format("load fndb {0}", fqFndbFileName.ToDisplayString()));
+
+  shared_ptr<FileNameDatabase> pFndb = FileNameDatabase::Create(fqFndbFileName, root.get_Path(), GetFileSystemWatcher());
 
   root.SetFndb(pFndb);
 
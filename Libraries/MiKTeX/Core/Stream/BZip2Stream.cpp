@@ -44,7 +44,7 @@ class BZip2StreamImpl :
 public:
   BZip2StreamImpl(const PathName& path, bool reading)
   {
-    StartThread(path, reading);
+    Start(path, reading);
   }
 
 public:
@@ -52,7 +52,7 @@ public:
   {
     try
     {
-      StopThread();
+      Stop();
     }
     catch (const exception &)
     {
@@ -80,45 +80,30 @@ private:
   };
 
 protected:
-  virtual void DoUncompress(const PathName& path)
+  bool Decode(const unsigned char*& in, size_t& inSize, bool eof, unsigned char*& out, size_t& outSize) override
   {
-    const size_t BUFFER_SIZE = 1024 * 16;
-    char inbuf[BUFFER_SIZE];
-    char outbuf[BUFFER_SIZE];
-    unique_ptr<FileStream> fileStream = make_unique<FileStream>(File::Open(path, FileMode::Open, FileAccess::Read, false));
-    unique_ptr<bz_stream_wrapper> bzStream = make_unique<bz_stream_wrapper>();
-    bzStream->next_in = nullptr;
-    bzStream->avail_in = 0;
-    bzStream->next_out = outbuf;
-    bzStream->avail_out = BUFFER_SIZE;
-    bool eof = false;
-    while (true)
+    bzStream.next_in = const_cast<char*>(reinterpret_cast<const char*>(in));
+    bzStream.avail_in = static_cast<unsigned int>(inSize);
+    bzStream.next_out = reinterpret_cast<char*>(out);
+    bzStream.avail_out = static_cast<unsigned int>(outSize);
+    int ret = BZ2_bzDecompress(&bzStream);
+    in = reinterpret_cast<const unsigned char*>(bzStream.next_in);
+    inSize = bzStream.avail_in;
+    out = reinterpret_cast<unsigned char*>(bzStream.next_out);
+    outSize = bzStream.avail_out;
+    if (ret == BZ_STREAM_END)
     {
-      if (bzStream->avail_in == 0 && !eof)
-      {
-        bzStream->next_in = inbuf;
-        bzStream->avail_in = static_cast<unsigned int>(fileStream->Read(inbuf, BUFFER_SIZE));
-        eof = bzStream->avail_in == 0;
-      }
-      int ret = BZ2_bzDecompress(bzStream.get());
-      if (bzStream->avail_out == 0 || ret == BZ_STREAM_END)
-      {
-        pipe.Write(outbuf, sizeof(outbuf) - bzStream->avail_out);
-        bzStream->next_out = outbuf;
-        bzStream->avail_out = BUFFER_SIZE;
-      }
-      if (ret != BZ_OK)
-      {
-        if (ret == BZ_STREAM_END)
-        {
-          bzStream.reset();
-          fileStream->Close();
-          return;
-        }
-        MIKTEX_FATAL_ERROR_2("BZ2 decoder did not succeed.", "ret", std::to_string(ret));
-      }
+      return true;
+    }
+    if (ret != BZ_OK)
+    {
+      MIKTEX_FATAL_ERROR_2("BZ2 decoder did not succeed.", "ret", std::to_string(ret));
     }
+    return false;
   }
+
+private:
+  bz_stream_wrapper bzStream;
 };
 
 unique_ptr<BZip2Stream> BZip2Stream::Create(const PathName& path, bool reading)
@@ -1,6 +1,6 @@
 /* CompressedStreamBase.h:
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2022 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -19,8 +19,13 @@
    Software Foundation, 59 Temple Place - Suite 330, Boston, MA
    02111-1307, USA. */
 
+#include <algorithm>
+#include <memory>
 #include <thread>
 
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+
 #include "Utils/Pipe.h"
 
 CORE_INTERNAL_BEGIN_NAMESPACE;
@@ -28,9 +33,22 @@ CORE_INTERNAL_BEGIN_NAMESPACE;
 template<typename Interface> class CompressedStreamBase :
   public Interface
 {
+  // size of the input buffer
+protected:
+  static constexpr size_t BUFFER_SIZE = 1024 * 64;
+
+  // compressed files of this size (or larger) are decompressed in a
+  // separate thread, so that decompression overlaps with consumption
+protected:
+  static constexpr size_t THREADED_DECOMPRESSION_MIN_SIZE = 1024 * 1024 * 16;
+
 public:
   size_t Read(void* data, size_t count) override
   {
+    if (!threaded)
+    {
+      return Uncompress(static_cast<unsigned char*>(data), count);
+    }
     if (IsUnsuccessful())
     {
       throw threadMiKTeXException;
@@ -57,28 +75,80 @@ public:
   }
 
 protected:
-  void StartThread(const MiKTeX::Util::PathName& path, bool reading)
+  void Start(const MiKTeX::Util::PathName& path, bool reading)
   {
-    thrd = std::thread(&CompressedStreamBase::UncompressThread, this, path, reading);
+    if (!reading)
+    {
+      UNIMPLEMENTED();
+    }
+    fileStream = std::make_unique<MiKTeX::Core::FileStream>(MiKTeX::Core::File::Open(path, MiKTeX::Core::FileMode::Open, MiKTeX::Core::FileAccess::Read, false));
+    threaded = MiKTeX::Core::File::GetSize(path) >= THREADED_DECOMPRESSION_MIN_SIZE;
+    if (threaded)
+    {
+      thrd = std::thread(&CompressedStreamBase::UncompressThread, this);
+    }
   }
 
 protected:
-  void StopThread()
+  void Stop()
   {
-    pipe.Close();
-    thrd.join();
+    if (threaded)
+    {
+      pipe.Close();
+      thrd.join();
+      threaded = false;
+    }
   }
 
+  // runs the decoder once; consumes input from `in` and produces output
+  // to `out`; returns true if the end of the compressed stream has been
+  // reached
 protected:
-  void UncompressThread(MiKTeX::Util::PathName path, bool reading)
+  virtual bool Decode(const unsigned char*& in, size_t& inSize, bool eof, unsigned char*& out, size_t& outSize) = 0;
+
+  // decompresses up to `count` bytes
+private:
+  size_t Uncompress(unsigned char* data, size_t count)
+  {
+    const size_t MAX_CHUNK_SIZE = 1024 * 1024 * 1024;
+    size_t remaining = count;
+    while (remaining > 0 && !endOfStream)
+    {
+      if (inSize == 0 && !eof)
+      {
+        inPtr = inbuf;
+        inSize = fileStream->Read(inbuf, BUFFER_SIZE);
+        eof = inSize == 0;
+      }
+      size_t outSize = std::min(remaining, MAX_CHUNK_SIZE);
+      size_t oldOutSize = outSize;
+      size_t oldInSize = inSize;
+      endOfStream = Decode(inPtr, inSize, eof, data, outSize);
+      remaining -= oldOutSize - outSize;
+      if (!endOfStream && eof && outSize == oldOutSize && inSize == oldInSize)
+      {
+        MIKTEX_FATAL_ERROR(T_("The compressed stream ended unexpectedly."));
+      }
+    }
+    if (endOfStream && fileStream != nullptr)
+    {
+      fileStream->Close();
+      fileStream = nullptr;
+    }
+    return count - remaining;
+  }
+
+private:
+  void UncompressThread()
   {
     try
     {
-      if (!reading)
+      std::unique_ptr<unsigned char[]> outbuf = std::make_unique<unsigned char[]>(BUFFER_SIZE);
+      size_t n;
+      while ((n = Uncompress(outbuf.get(), BUFFER_SIZE)) > 0)
       {
-        UNIMPLEMENTED();
+        pipe.Write(outbuf.get(), n);
       }
-      DoUncompress(path);
       pipe.Close();
       Finish(true);
     }
@@ -94,8 +164,26 @@ protected:
     }
   }
 
-protected:
-  virtual void DoUncompress(const MiKTeX::Util::PathName& path) = 0;
+private:
+  std::unique_ptr<MiKTeX::Core::FileStream> fileStream;
+
+private:
+  unsigned char inbuf[BUFFER_SIZE];
+
+private:
+  const unsigned char* inPtr = inbuf;
+
+private:
+  size_t inSize = 0;
+
+private:
+  bool eof = false;
+
+private:
+  bool endOfStream = false;
+
+private:
+  bool threaded = false;
 
 protected:
   std::thread thrd;
@@ -44,7 +44,7 @@ class GzipStreamImpl :
 public:
   GzipStreamImpl(const PathName& path, bool reading)
   {
-    StartThread(path, reading);
+    Start(path, reading);
   }
 
 public:
@@ -52,7 +52,7 @@ public:
   {
     try
     {
-      StopThread();
+      Stop();
     }
     catch (const exception &)
     {
@@ -80,45 +80,30 @@ private:
   };
 
 protected:
-  void DoUncompress(const PathName& path)
+  bool Decode(const unsigned char*& in, size_t& inSize, bool eof, unsigned char*& out, size_t& outSize) override
   {
-    const size_t BUFFER_SIZE = 1024 * 16;
-    unsigned char inbuf[BUFFER_SIZE];
-    unsigned char outbuf[BUFFER_SIZE];
-    unique_ptr<FileStream> fileStream = make_unique<FileStream>(File::Open(path, FileMode::Open, FileAccess::Read, false));
-    unique_ptr<gz_stream_wrapper> gzStream = make_unique<gz_stream_wrapper>();
-    gzStream->next_in = nullptr;
-    gzStream->avail_in = 0;
-    gzStream->next_out = outbuf;
-    gzStream->avail_out = BUFFER_SIZE;
-    bool eof = false;
-    while (true)
+    gzStream.next_in = const_cast<unsigned char*>(in);
+    gzStream.avail_in = static_cast<uInt>(inSize);
+    gzStream.next_out = out;
+    gzStream.avail_out = static_cast<uInt>(outSize);
+    int ret = inflate(&gzStream, eof ? Z_FINISH : Z_NO_FLUSH);
+    in = gzStream.next_in;
+    inSize = gzStream.avail_in;
+    out = gzStream.next_out;
+    outSize = gzStream.avail_out;
+    if (ret == Z_STREAM_END)
     {
-      if (gzStream->avail_in == 0 && !eof)
-      {
-        gzStream->next_in = inbuf;
-        gzStream->avail_in = static_cast<uInt>(fileStream->Read(inbuf, BUFFER_SIZE));
-        eof = gzStream->avail_in == 0;
-      }
-      int ret = inflate(gzStream.get(), eof ? Z_FINISH : Z_NO_FLUSH);
-      if (gzStream->avail_out == 0 || ret == Z_STREAM_END)
-      {
-        pipe.Write(outbuf, sizeof(outbuf) - gzStream->avail_out);
-        gzStream->next_out = outbuf;
-        gzStream->avail_out = BUFFER_SIZE;
-      }
-      if (ret != Z_OK)
-      {
-        if (ret == Z_STREAM_END)
-        {
-          gzStream.reset();
-          fileStream->Close();
-          return;
-        }
-        MIKTEX_FATAL_ERROR_2("GZ decoder did not succeed.", "ret", std::to_string(ret));
-      }
+      return true;
+    }
+    if (ret != Z_OK)
+    {
+      MIKTEX_FATAL_ERROR_2("GZ decoder did not succeed.", "ret", std::to_string(ret));
     }
+    return false;
   }
+
+private:
+  gz_stream_wrapper gzStream;
 };
 
 unique_ptr<GzipStream> GzipStream::Create(const PathName& path, bool reading)
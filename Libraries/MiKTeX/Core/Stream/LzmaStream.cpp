@@ -1,6 +1,6 @@
 /* LzmaStream.cpp: LZMA file stream
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2022 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -21,6 +21,8 @@
 
 #include "config.h"
 
+#include <cstring>
+
 #include <lzma.h>
 
 #include <miktex/Core/FileStream>
@@ -44,7 +46,7 @@ class LzmaStreamImpl :
 public:
   LzmaStreamImpl(const PathName& path, bool reading)
   {
-    StartThread(path, reading);
+    Start(path, reading);
   }
 
 public:
@@ -52,7 +54,7 @@ public:
   {
     try
     {
-      StopThread();
+      Stop();
     }
     catch (const exception &)
     {
@@ -66,59 +68,78 @@ private:
     lzma_stream_wrapper() :
       lzma_stream(LZMA_STREAM_INIT)
     {
-      lzma_ret ret = lzma_auto_decoder(this, UINT64_MAX, 0);
-      if (ret != LZMA_OK)
-      {
-        MIKTEX_FATAL_ERROR_2("LZMA decoder initialization did not succeed.", "ret", std::to_string(ret));
-      }
     }
   public:
     ~lzma_stream_wrapper()
     {
-      lzma_end(this);
+      if (initialized)
+      {
+        lzma_end(this);
+      }
     }
-  };
-
-protected:
-  virtual void DoUncompress(const PathName& path)
-  {
-    const size_t BUFFER_SIZE = 1024 * 16;
-    uint8_t inbuf[BUFFER_SIZE];
-    uint8_t outbuf[BUFFER_SIZE];
-    unique_ptr<FileStream> fileStream = make_unique<FileStream>(File::Open(path, FileMode::Open, FileAccess::Read, false));
-    unique_ptr<lzma_stream_wrapper> lzmaStream = make_unique<lzma_stream_wrapper>();
-    lzmaStream->next_in = nullptr;
-    lzmaStream->avail_in = 0;
-    lzmaStream->next_out = outbuf;
-    lzmaStream->avail_out = BUFFER_SIZE;
-    bool eof = false;
-    while (true)
+  public:
+    void Initialize(const unsigned char* in, size_t inSize)
     {
-      if (lzmaStream->avail_in == 0 && !eof)
+      lzma_ret ret;
+#if LZMA_VERSION >= UINT32_C(50040002)
+      // .xz streams made of several blocks can be decoded by multiple
+      // threads; single-block streams are decoded as usual
+      static const unsigned char xzMagic[] = { 0xfd, '7', 'z', 'X', 'Z', 0x00 };
+      uint32_t threads = lzma_cputhreads();
+      if (threads > 1 && inSize >= sizeof(xzMagic) && memcmp(in, xzMagic, sizeof(xzMagic)) == 0)
       {
-        lzmaStream->next_in = inbuf;
-        lzmaStream->avail_in = fileStream->Read(inbuf, BUFFER_SIZE);
-        eof = lzmaStream->avail_in == 0;
+        lzma_mt mt;
+        memset(&mt, 0, sizeof(mt));
+        mt.threads = threads;
+        uint64_t physmem = lzma_physmem();
+        mt.memlimit_threading = physmem > 0 ? physmem / 4 : UINT64_MAX;
+        mt.memlimit_stop = UINT64_MAX;
+        ret = lzma_stream_decoder_mt(this, &mt);
       }
-      lzma_ret ret = lzma_code(lzmaStream.get(), eof ? LZMA_FINISH : LZMA_RUN);
-      if (lzmaStream->avail_out == 0 || ret == LZMA_STREAM_END)
+      else
+#endif
       {
-        pipe.Write(outbuf, sizeof(outbuf) - lzmaStream->avail_out);
-        lzmaStream->next_out = outbuf;
-        lzmaStream->avail_out = BUFFER_SIZE;
+        ret = lzma_auto_decoder(this, UINT64_MAX, 0);
       }
       if (ret != LZMA_OK)
       {
-        if (ret == LZMA_STREAM_END)
-        {
-          lzmaStream.reset();
-          fileStream->Close();
-          return;
-        }
-        MIKTEX_FATAL_ERROR_2("LZMA decoder did not succeed.", "ret", std::to_string(ret));
+        MIKTEX_FATAL_ERROR_2("LZMA decoder initialization did not succeed.", "ret", std::to_string(ret));
       }
+      initialized = true;
     }
+  public:
+    bool initialized = false;
+  };
+
+protected:
+  bool Decode(const unsigned char*& in, size_t& inSize, bool eof, unsigned char*& out, size_t& outSize) override
+  {
+    if (!lzmaStream.initialized)
+    {
+      lzmaStream.Initialize(in, inSize);
+    }
+    lzmaStream.next_in = in;
+    lzmaStream.avail_in = inSize;
+    lzmaStream.next_out = out;
+    lzmaStream.avail_out = outSize;
+    lzma_ret ret = lzma_code(&lzmaStream, eof ? LZMA_FINISH : LZMA_RUN);
+    in = lzmaStream.next_in;
+    inSize = lzmaStream.avail_in;
+    out = lzmaStream.next_out;
+    outSize = lzmaStream.avail_out;
+    if (ret == LZMA_STREAM_END)
+    {
+      return true;
+    }
+    if (ret != LZMA_OK)
+    {
+      MIKTEX_FATAL_ERROR_2("LZMA decoder did not succeed.", "ret", std::to_string(ret));
+    }
+    return false;
   }
+
+private:
+  lzma_stream_wrapper lzmaStream;
 };
 
 unique_ptr<LzmaStream> LzmaStream::Create(const PathName& path, bool reading)
@@ -21,6 +21,12 @@
 
 #include "config.h"
 
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include <miktex/Core/StreamReader>
 #include <miktex/Core/Utils>
 #include <miktex/Util/PathName>
@@ -32,11 +38,201 @@ using namespace std;
 using namespace MiKTeX::Core;
 using namespace MiKTeX::Util;
 
+// the file is read in blocks of this size when reading ahead
+const size_t READ_AHEAD_BLOCK_SIZE = 256 * 1024;
+
+/*
+ * A background thread fills two buffers in turn: while the reader
+ * consumes one block, the next block is read from the file.
+ */
+class StreamReader::ReadAhead
+{
+public:
+  ReadAhead(FILE* file) :
+    file(file)
+  {
+    for (Block& block : blocks)
+    {
+      block.data.resize(READ_AHEAD_BLOCK_SIZE);
+    }
+    thread = std::thread(&ReadAhead::Run, this);
+  }
+
+public:
+  ~ReadAhead()
+  {
+    {
+      lock_guard<mutex> lock(mtx);
+      stopping = true;
+    }
+    cv.notify_all();
+    thread.join();
+  }
+
+public:
+  bool ReadLine(string& line)
+  {
+    line.clear();
+    if (skipLF)
+    {
+      skipLF = false;
+      if (NextBlock() && blocks[current].data[pos] == '\n')
+      {
+        ++pos;
+      }
+    }
+    while (NextBlock())
+    {
+      const Block& block = blocks[current];
+      const char* begin = block.data.data() + pos;
+      const char* end = block.data.data() + block.size;
+      const char* lineEnd = begin;
+      while (lineEnd != end && *lineEnd != '\n' && *lineEnd != '\r')
+      {
+        ++lineEnd;
+      }
+      line.append(begin, lineEnd);
+      if (lineEnd != end)
+      {
+        skipLF = *lineEnd == '\r';
+        pos = lineEnd - block.data.data() + 1;
+        return true;
+      }
+      pos = block.size;
+    }
+    return !line.empty();
+  }
+
+private:
+  // makes sure that the current block has unread data; returns false at end of file
+  bool NextBlock()
+  {
+    if (haveCurrent)
+    {
+      if (pos < blocks[current].size)
+      {
+        return true;
+      }
+      {
+        lock_guard<mutex> lock(mtx);
+        blocks[current].full = false;
+      }
+      cv.notify_all();
+      current = 1 - current;
+      haveCurrent = false;
+    }
+    unique_lock<mutex> lock(mtx);
+    cv.wait(lock, [this] { return blocks[current].full; });
+    if (readError)
+    {
+      MIKTEX_FATAL_CRT_ERROR("fread");
+    }
+    if (blocks[current].size == 0)
+    {
+      return false;
+    }
+    haveCurrent = true;
+    pos = 0;
+    return true;
+  }
+
+private:
+  void Run()
+  {
+    size_t next = 0;
+    while (true)
+    {
+      {
+        unique_lock<mutex> lock(mtx);
+        cv.wait(lock, [this, next] { return stopping || !blocks[next].full; });
+        if (stopping)
+        {
+          return;
+        }
+      }
+      Block& block = blocks[next];
+      size_t n = fread(block.data.data(), 1, block.data.size(), file);
+      bool error = n == 0 && ferror(file) != 0;
+      {
+        lock_guard<mutex> lock(mtx);
+        block.size = n;
+        block.full = true;
+        readError = error;
+      }
+      cv.notify_all();
+      if (n == 0)
+      {
+        return;
+      }
+      next = 1 - next;
+    }
+  }
+
+private:
+  struct Block
+  {
+    vector<char> data;
+    size_t size = 0;
+    bool full = false;
+  };
+
+private:
+  FILE* file;
+
+private:
+  array<Block, 2> blocks;
+
+private:
+  size_t current = 0;
+
+private:
+  bool haveCurrent = false;
+
+private:
+  size_t pos = 0;
+
+private:
+  bool skipLF = false;
+
+private:
+  bool stopping = false;
+
+private:
+  bool readError = false;
+
+private:
+  mutex mtx;
+
+private:
+  condition_variable cv;
+
+private:
+  std::thread thread;
+};
+
+StreamReader::StreamReader()
+{
+}
+
+StreamReader::StreamReader(bool readStdin) :
+  stream(readStdin ? stdin : nullptr)
+{
+}
+
 StreamReader::StreamReader(const PathName& path) :
   stream(File::Open(path, FileMode::Open, FileAccess::Read))
 {
 }
 
+StreamReader::StreamReader(const PathName& path, bool readAhead) :
+  stream(File::Open(path, FileMode::Open, FileAccess::Read))
+{
+  if (readAhead)
+  {
+    this->readAhead = make_unique<ReadAhead>(stream.GetFile());
+  }
+}
+
 StreamReader::~StreamReader() noexcept
 {
   try
@@ -50,10 +246,15 @@ StreamReader::~StreamReader() noexcept
 
 void StreamReader::Close()
 {
+  readAhead = nullptr;
   stream.Close();
 }
 
 bool StreamReader::ReadLine(string& line)
 {
+  if (readAhead != nullptr)
+  {
+    return readAhead->ReadLine(line);
+  }
   return Utils::ReadLine(line, stream.GetFile(), false);
 }
@@ -25,7 +25,15 @@
 #  include <sys/stat.h>
 #endif
 
+#if defined(__linux__)
+#  include <cstdlib>
+#  include <sys/vfs.h>
+#  include <unistd.h>
+#endif
+
 #include <random>
+#include <string>
+#include <vector>
 
 #include <miktex/Core/Directory>
 #include <miktex/Core/TemporaryDirectory>
@@ -49,10 +57,13 @@ class TemporaryDirectoryImpl :
   public TemporaryDirectory
 {
 public:
-  TemporaryDirectoryImpl()
+  TemporaryDirectoryImpl(TemporaryDirectoryOptionSet options)
   {
     PathName parent;
-    parent.SetToTempDirectory();
+    if (!(options[TemporaryDirectoryOption::InMemory] && GetMemoryDirectory(parent)))
+    {
+      parent.SetToTempDirectory();
+    }
     random_device rd;
     mt19937 gen(rd());
     uniform_int_distribution<> dist(1, 99999);
@@ -129,6 +140,39 @@ public:
     Directory::SetCurrent(path);
   }
 
+private:
+  // finds a writable tmpfs directory with enough free space; intermediate
+  // files stored there never hit the disk
+  static bool GetMemoryDirectory(PathName& result)
+  {
+#if defined(__linux__)
+    const long TMPFS_MAGIC = 0x01021994;
+    const unsigned long long MIN_FREE_SPACE = 512 * 1024 * 1024;
+    vector<string> candidates;
+    const char* runtimeDir = getenv("XDG_RUNTIME_DIR");
+    if (runtimeDir != nullptr && *runtimeDir != 0)
+    {
+      candidates.push_back(runtimeDir);
+    }
+    candidates.push_back("/dev/shm");
+    for (const string& dir : candidates)
+    {
+      struct statfs buf;
+      if (statfs(dir.c_str(), &buf) != 0 || static_cast<long>(buf.f_type) != TMPFS_MAGIC || access(dir.c_str(), W_OK | X_OK) != 0)
+      {
+        continue;
+      }
+      if (static_cast<unsigned long long>(buf.f_bavail) * buf.f_bsize < MIN_FREE_SPACE)
+      {
+        continue;
+      }
+      result = dir;
+      return true;
+    }
+#endif
+    return false;
+  }
+
 private:
   static bool NameExists(const PathName& name)
   {
@@ -150,7 +194,12 @@ private:
 
 unique_ptr<TemporaryDirectory> TemporaryDirectory::Create()
 {
-  return make_unique<TemporaryDirectoryImpl>();
+  return make_unique<TemporaryDirectoryImpl>(TemporaryDirectoryOptionSet());
+}
+
+unique_ptr<TemporaryDirectory> TemporaryDirectory::Create(TemporaryDirectoryOptionSet options)
+{
+  return make_unique<TemporaryDirectoryImpl>(options);
 }
 
 unique_ptr<TemporaryDirectory> TemporaryDirectory::Create(const PathName& path)
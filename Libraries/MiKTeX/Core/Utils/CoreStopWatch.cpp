@@ -0,0 +1,98 @@
+/* CoreStopWatch.cpp: always-on timing
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include "internal.h"
+
+#include "Utils/CoreStopWatch.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+
+CoreStopWatch::Counter CoreStopWatch::counters[static_cast<size_t>(CoreTimer::Count)];
+
+atomic<TraceStream*> CoreStopWatch::traceStream(nullptr);
+
+const char* const CoreStopWatch::timerNames[static_cast<size_t>(CoreTimer::Count)] = {
+  "find file",
+  "find files",
+  "load fndb",
+  "apply fndb change file",
+  "initialize startup configuration",
+  "initialize root directories",
+  "start file system watcher",
+};
+
+void CoreStopWatch::TraceStart() noexcept
+{
+  try
+  {
+    TraceStream* traceStream = CoreStopWatch::traceStream;
+    if (traceStream != nullptr)
+    {
+      traceStream->WriteLine("core", fmt::format("stopwatch START: {}", message));
+    }
+  }
+  catch (const exception&)
+  {
+  }
+}
+
+void CoreStopWatch::TraceStop(uint64_t ns) noexcept
+{
+  try
+  {
+    TraceStream* traceStream = CoreStopWatch::traceStream;
+    if (traceStream != nullptr)
+    {
+      traceStream->WriteLine("core", fmt::format("stopwatch STOP: {} ({:.4f} seconds)", message, ns / 1e9));
+    }
+  }
+  catch (const exception&)
+  {
+  }
+}
+
+void CoreStopWatch::TraceCounters()
+{
+  TraceStream* traceStream = CoreStopWatch::traceStream;
+  if (traceStream == nullptr || !traceStream->IsEnabled("core", TraceLevel::Trace))
+  {
+    return;
+  }
+  for (size_t idx = 0; idx < static_cast<size_t>(CoreTimer::Count); ++idx)
+  {
+    uint64_t count = counters[idx].count;
+    if (count == 0)
+    {
+      continue;
+    }
+    uint64_t totalNs = counters[idx].totalNs;
+    uint64_t maxNs = counters[idx].maxNs;
+    traceStream->WriteLine("core", fmt::format("stopwatch {}: {} calls, {:.4f} seconds total, {:.4f} seconds max", timerNames[idx], count, totalNs / 1e9, maxNs / 1e9));
+  }
+}
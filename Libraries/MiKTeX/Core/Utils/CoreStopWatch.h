@@ -1,6 +1,6 @@
 /* CoreStopWatch.h:
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2023 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -21,34 +21,132 @@
 
 #pragma once
 
-#include <miktex/Trace/StopWatch>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
 
-#include "Session/SessionImpl.h"
+#include <miktex/Trace/EventRecorder>
+#include <miktex/Trace/TraceStream>
 
 CORE_INTERNAL_BEGIN_NAMESPACE;
 
+// the operations which are timed
+enum class CoreTimer
+{
+  FindFile,
+  FindFiles,
+  LoadFndb,
+  ApplyFndbChangeFile,
+  InitializeStartupConfig,
+  InitializeRootDirectories,
+  StartFileSystemWatcher,
+  Count
+};
+
+/*
+ * Always-on timing: a CoreStopWatch adds the time between construction
+ * and destruction to the counters of its timer (number of calls, total
+ * and maximum time).  The counters are written to the stopwatch trace
+ * stream when the session ends.  The timed operations are also recorded
+ * as event spans (see EventRecorder).
+ *
+ * The message, which is only needed for START/STOP trace lines, is a
+ * function object which is not called unless stopwatch tracing is
+ * enabled.
+ */
 class CoreStopWatch
 {
 public:
-  CoreStopWatch(const std::string& message) :
-    stopWatch(MiKTeX::Trace::StopWatch::Start(SESSION_IMPL()->trace_stopwatch.get(), "core", message))
+  CoreStopWatch(CoreTimer timer) :
+    timer(timer)
+  {
+    MiKTeX::Trace::EventRecorder::Begin(timerNames[static_cast<std::size_t>(timer)]);
+  }
+
+public:
+  template<typename MessageFunc> CoreStopWatch(CoreTimer timer, MessageFunc makeMessage) :
+    timer(timer)
   {
+    MiKTeX::Trace::EventRecorder::Begin(timerNames[static_cast<std::size_t>(timer)]);
+    if (IsTracing())
+    {
+      message = makeMessage();
+      TraceStart();
+    }
   }
 
+public:
+  CoreStopWatch(const CoreStopWatch& other) = delete;
+
+public:
+  CoreStopWatch& operator=(const CoreStopWatch& other) = delete;
+
 public:
   ~CoreStopWatch()
   {
-    try
+    std::uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    Counter& counter = counters[static_cast<std::size_t>(timer)];
+    counter.count.fetch_add(1, std::memory_order_relaxed);
+    counter.totalNs.fetch_add(ns, std::memory_order_relaxed);
+    std::uint64_t maxNs = counter.maxNs.load(std::memory_order_relaxed);
+    while (ns > maxNs && !counter.maxNs.compare_exchange_weak(maxNs, ns, std::memory_order_relaxed))
     {
-      stopWatch->Stop();
     }
-    catch (const std::exception&)
+    MiKTeX::Trace::EventRecorder::End(timerNames[static_cast<std::size_t>(timer)]);
+    if (!message.empty())
     {
+      TraceStop(ns);
     }
   }
 
+public:
+  static void SetTraceStream(MiKTeX::Trace::TraceStream* traceStream)
+  {
+    CoreStopWatch::traceStream = traceStream;
+  }
+
+public:
+  static void TraceCounters();
+
+private:
+  static bool IsTracing()
+  {
+    MiKTeX::Trace::TraceStream* traceStream = CoreStopWatch::traceStream;
+    return traceStream != nullptr && traceStream->IsEnabled("core", MiKTeX::Trace::TraceLevel::Trace);
+  }
+
+private:
+  void TraceStart() noexcept;
+
+private:
+  void TraceStop(std::uint64_t ns) noexcept;
+
+private:
+  struct Counter
+  {
+    std::atomic<std::uint64_t> count{ 0 };
+    std::atomic<std::uint64_t> totalNs{ 0 };
+    std::atomic<std::uint64_t> maxNs{ 0 };
+  };
+
+private:
+  CoreTimer timer;
+
+private:
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+private:
+  std::string message;
+
+private:
+  static Counter counters[static_cast<std::size_t>(CoreTimer::Count)];
+
+private:
+  static const char* const timerNames[static_cast<std::size_t>(CoreTimer::Count)];
+
 private:
-  std::unique_ptr<MiKTeX::Trace::StopWatch> stopWatch;
+  static std::atomic<MiKTeX::Trace::TraceStream*> traceStream;
 };
 
 CORE_INTERNAL_END_NAMESPACE;
@@ -0,0 +1,87 @@
+/* LineReader.h:
+
+   Copyright (C) 2022 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#include <cstring>
+
+#include <string>
+#include <string_view>
+
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+/// Reads a text file in one go and hands out its lines without
+/// copying them.  Lines are separated by LF, just like `std::getline()`
+/// separates them; the returned views remain valid for the lifetime
+/// of the reader.
+class LineReader
+{
+public:
+  LineReader(const MiKTeX::Util::PathName& path)
+  {
+    MiKTeX::Core::FileStream stream(MiKTeX::Core::File::Open(path, MiKTeX::Core::FileMode::Open, MiKTeX::Core::FileAccess::Read, false));
+    text.resize(MiKTeX::Core::File::GetSize(path));
+    size_t n = text.empty() ? 0 : stream.Read(&text[0], text.length());
+    text.resize(n);
+    stream.Close();
+  }
+
+public:
+  LineReader(std::string&& text) :
+    text(std::move(text))
+  {
+  }
+
+public:
+  bool ReadLine(std::string_view& line)
+  {
+    if (pos >= text.length())
+    {
+      return false;
+    }
+    const char* begin = text.data() + pos;
+    size_t avail = text.length() - pos;
+    const char* lineEnd = static_cast<const char*>(memchr(begin, '\n', avail));
+    if (lineEnd == nullptr)
+    {
+      line = std::string_view(begin, avail);
+      pos = text.length();
+    }
+    else
+    {
+      line = std::string_view(begin, lineEnd - begin);
+      pos += line.length() + 1;
+    }
+    return true;
+  }
+
+private:
+  std::string text;
+
+private:
+  size_t pos = 0;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
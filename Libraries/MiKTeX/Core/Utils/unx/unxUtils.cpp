@@ -88,6 +88,7 @@ void Utils::SetEnvironmentString(const string& valueName, const string& value)
   {
     MIKTEX_FATAL_CRT_ERROR_2("setenv", "name", valueName);
   }
+  SessionImpl::BumpConfigGeneration();
 }
 
 void Utils::RemoveEnvironmentString(const string& valueName)
@@ -98,6 +99,7 @@ void Utils::RemoveEnvironmentString(const string& valueName)
   {
     MIKTEX_FATAL_CRT_ERROR_2("unsetenv", "name", valueName);
   }
+  SessionImpl::BumpConfigGeneration();
 }
 
 void Utils::CheckHeap()
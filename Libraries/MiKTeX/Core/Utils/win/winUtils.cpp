@@ -123,6 +123,7 @@ void Utils::SetEnvironmentString(const string& valueName, const string& value)
         FATAL_CRT_ERROR("putenv", str.c_str());
     }
 #endif
+    SessionImpl::BumpConfigGeneration();
 }
 
 void Utils::RemoveEnvironmentString(const string& valueName)
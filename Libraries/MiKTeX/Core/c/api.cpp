@@ -13,7 +13,11 @@
 
 #include "config.h"
 
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <miktex/Core/BufferSizes>
 #include <miktex/Core/CommandLineBuilder>
@@ -336,6 +340,40 @@ MIKTEXCORECEEAPI(int) miktex_pclose(FILE* file)
     }
 }
 
+const size_t STREAM_BUFFER_SIZE = 256 * 1024;
+
+// buffers of the files opened by miktex_fopen_stream()
+static mutex streamBuffersMutex;
+static unordered_map<FILE*, unique_ptr<char[]>> streamBuffers;
+
+MIKTEXCORECEEAPI(FILE*) miktex_fopen_stream(const char* fileName, const char* mode)
+{
+#if defined(MIKTEX_WINDOWS)
+    FILE* file = _wfopen(PathName(fileName).ToExtendedLengthPathName().ToWideCharString().c_str(), UW_(mode));
+#else
+    FILE* file = fopen(fileName, mode);
+#endif
+    if (file == nullptr)
+    {
+        return nullptr;
+    }
+    unique_ptr<char[]> buffer(new char[STREAM_BUFFER_SIZE]);
+    if (setvbuf(file, buffer.get(), _IOFBF, STREAM_BUFFER_SIZE) == 0)
+    {
+        lock_guard<mutex> lockGuard(streamBuffersMutex);
+        streamBuffers[file] = move(buffer);
+    }
+    return file;
+}
+
+MIKTEXCORECEEAPI(int) miktex_fclose_stream(FILE* file)
+{
+    int ret = fclose(file);
+    lock_guard<mutex> lockGuard(streamBuffersMutex);
+    streamBuffers.erase(file);
+    return ret;
+}
+
 MIKTEXCORECEEAPI(int) miktex_is_pipe(FILE* file)
 {
     try
@@ -347,4 +385,81 @@ MIKTEXCORECEEAPI(int) miktex_is_pipe(FILE* file)
     {
         return -1;
     }
-}
\ No newline at end of file
+}
+
+// below this number of elements, a range is not split between threads
+const size_t PARALLEL_SORT_MIN = 4096;
+
+// stable merge sort; tmp has room for n elements
+static void MergeSort(char* base, char* tmp, size_t n, size_t size, int (*compare)(const void*, const void*), unsigned numThreads)
+{
+    if (n < 2)
+    {
+        return;
+    }
+    if (n <= 16)
+    {
+        for (size_t i = 1; i < n; ++i)
+        {
+            memcpy(tmp, base + i * size, size);
+            size_t j = i;
+            for (; j > 0 && compare(base + (j - 1) * size, tmp) > 0; --j)
+            {
+                memcpy(base + j * size, base + (j - 1) * size, size);
+            }
+            memcpy(base + j * size, tmp, size);
+        }
+        return;
+    }
+    size_t mid = n / 2;
+    if (numThreads > 1 && n >= PARALLEL_SORT_MIN)
+    {
+        thread worker(MergeSort, base, tmp, mid, size, compare, numThreads / 2);
+        MergeSort(base + mid * size, tmp + mid * size, n - mid, size, compare, numThreads - numThreads / 2);
+        worker.join();
+    }
+    else
+    {
+        MergeSort(base, tmp, mid, size, compare, 1);
+        MergeSort(base + mid * size, tmp + mid * size, n - mid, size, compare, 1);
+    }
+    if (compare(base + (mid - 1) * size, base + mid * size) <= 0)
+    {
+        return;
+    }
+    memcpy(tmp, base, n * size);
+    const char* left = tmp;
+    const char* leftEnd = tmp + mid * size;
+    const char* right = leftEnd;
+    const char* rightEnd = tmp + n * size;
+    char* out = base;
+    while (left < leftEnd && right < rightEnd)
+    {
+        // on ties, the left element comes first
+        if (compare(right, left) < 0)
+        {
+            memcpy(out, right, size);
+            right += size;
+        }
+        else
+        {
+            memcpy(out, left, size);
+            left += size;
+        }
+        out += size;
+    }
+    memcpy(out, left, leftEnd - left);
+    out += leftEnd - left;
+    memcpy(out, right, rightEnd - right);
+}
+
+MIKTEXCORECEEAPI(void) miktex_parallel_sort(void* base, size_t n, size_t size, int (*compare)(const void*, const void*))
+{
+    if (n < 2)
+    {
+        return;
+    }
+    vector<char> tmp(n * size);
+    unsigned numThreads = thread::hardware_concurrency();
+    MergeSort(static_cast<char*>(base), tmp.data(), n, size, compare, numThreads == 0 ? 1 : numThreads);
+}
@@ -339,6 +339,13 @@ public:
 public:
   virtual bool MIKTEXTHISCALL IsSigned() const = 0;
 
+  /// Gets the files which have been read, including the files read
+  /// by `!include` directives.
+  /// @return Returns the file system paths in the order the files
+  /// have been read.
+public:
+  virtual std::vector<MiKTeX::Util::PathName> MIKTEXTHISCALL GetInputFiles() const = 0;
+
   /// Gets an iterator to the first container section.
 public:
   virtual KeyIterator MIKTEXTHISCALL begin() = 0;
@@ -29,6 +29,7 @@
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <miktex/Util/PathName>
 
@@ -113,6 +114,22 @@ public:
   /// @return Returns a smart pointer to the `DirectoryLister` interface.
 public:
   static MIKTEXCORECEEAPI(std::unique_ptr<DirectoryLister>) Open(const MiKTeX::Util::PathName& directory, const char* pattern, int options);
+
+  /// Reads all entries of a directory at once.
+  /// @param directory File system path to the directory.
+  /// @param pattern The glob pattern to be used as the filter (can be `nullptr`).
+  /// @param options Read options.
+  /// @return Returns the directory entries.
+public:
+  static MIKTEXCORECEEAPI(std::vector<DirectoryEntry>) ReadDirectory(const MiKTeX::Util::PathName& directory, const char* pattern, int options);
+
+  /// Reads the entries of several directories concurrently.
+  /// @param directories File system paths to the directories.
+  /// @param pattern The glob pattern to be used as the filter (can be `nullptr`).
+  /// @param options Read options.
+  /// @return Returns the directory entries, one vector per directory.
+public:
+  static MIKTEXCORECEEAPI(std::vector<std::vector<DirectoryEntry>>) ReadDirectories(const std::vector<MiKTeX::Util::PathName>& directories, const char* pattern, int options);
 };
 
 MIKTEX_CORE_END_NAMESPACE;
@@ -35,6 +35,7 @@
 #define MIKTEX_ENV_COMMON_STARTUP_FILE MIKTEX_ENV_PREFIX_ "COMMONSTARTUPFILE"
 #define MIKTEX_ENV_CWD_LIST MIKTEX_ENV_PREFIX_ "CWDLIST"
 #define MIKTEX_ENV_EXCEPTION_PATH MIKTEX_ENV_PREFIX_ "EXCEPTION_PATH"
+#define MIKTEX_ENV_FNDB_POLL MIKTEX_ENV_PREFIX_ "FNDBPOLL"
 #define MIKTEX_ENV_OTHER_COMMON_ROOTS MIKTEX_ENV_PREFIX_ "OTHERCOMMONROOTS"
 #define MIKTEX_ENV_OTHER_USER_ROOTS MIKTEX_ENV_PREFIX_ "OTHERUSERROOTS"
 #define MIKTEX_ENV_PACKAGE_LIST_FILE MIKTEX_ENV_PREFIX_ "PKGLISTFILE"
@@ -364,6 +364,14 @@ public:
     return CreateOutputStream(path, std::ios_base::out, std::ios_base::badbit | std::ios_base::failbit);
   }
 
+  /// Reserves disk space for a file which is about to be written.
+  /// This is a hint only: the call fails silently if the file system
+  /// does not support preallocation.
+  /// @param file The pointer to the `FILE` object.
+  /// @param size The expected file size.
+public:
+  static MIKTEXCORECEEAPI(void) Preallocate(FILE* file, std::size_t size);
+
   /// Sets file attributes.
   /// @param path The file system path to the file.
   /// @param attributes The attributes to set.
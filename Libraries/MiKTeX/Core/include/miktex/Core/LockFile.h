@@ -41,13 +41,19 @@ class MIKTEXNOVTABLE LockFile
 public:
   virtual MIKTEXTHISCALL ~LockFile() noexcept = 0;
 
-  /// Tries to create the lock file.
-  /// @param time The maximum time waited for the operation to succeed.
-  /// @return Returns `true`, if the lock file has been created.
+  /// Tries to lock the file exclusively.
+  /// @param timeout The maximum time waited for the operation to succeed.
+  /// @return Returns `true`, if the file has been locked.
 public:
   virtual bool MIKTEXTHISCALL TryLock(std::chrono::milliseconds timeout) = 0;
 
-  /// Removes the lock file.
+  /// Tries to lock the file for shared (read-only) access.
+  /// @param timeout The maximum time waited for the operation to succeed.
+  /// @return Returns `true`, if the file has been locked.
+public:
+  virtual bool MIKTEXTHISCALL TryLockShared(std::chrono::milliseconds timeout) = 0;
+
+  /// Releases the lock. The last owner removes the lock file.
 public:
   virtual void MIKTEXTHISCALL Unlock() = 0;
 
@@ -1,6 +1,6 @@
 /* miktex/Core/MemoryMappedFile.h:                      -*- C++ -*-
 
-   Copyright (C) 1996-2021 Christian Schenk
+   Copyright (C) 1996-2022 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -32,6 +32,17 @@
 
 MIKTEX_CORE_BEGIN_NAMESPACE;
 
+/// The expected access pattern of a memory-mapped file.
+enum class MemoryMappedFileAccessPattern
+{
+  /// No particular pattern.
+  Normal,
+  /// The file will be read from start to end.
+  Sequential,
+  /// Small portions of the file will be accessed in random order.
+  Random
+};
+
 /// Instances of this class provide access to memory-mapped files.
 class MIKTEXNOVTABLE MemoryMappedFile
 {
@@ -75,6 +86,19 @@ public:
 public:
   virtual void MIKTEXTHISCALL Flush() = 0;
 
+  /// Tells the operating system how the memory-mapped file will be
+  /// accessed. This is a hint only.
+  /// @param accessPattern The expected access pattern.
+public:
+  virtual void MIKTEXTHISCALL Advise(MemoryMappedFileAccessPattern accessPattern) = 0;
+
+  /// Asks the operating system to read a portion of the memory-mapped
+  /// file ahead of time. This is a hint only.
+  /// @param offset The start of the portion.
+  /// @param length The size (in bytes) of the portion.
+public:
+  virtual void MIKTEXTHISCALL Prefetch(std::size_t offset, std::size_t length) = 0;
+
   /// Creates a new `MemoryMappedFile` object. The caller is responsible
   /// for deleting the object.
   /// @return Returns the pointer to a new `MemoryMappedFile` object.
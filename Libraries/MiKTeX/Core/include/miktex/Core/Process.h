@@ -31,6 +31,7 @@
 #include <cstdio>
 
 #include <algorithm>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <string>
@@ -153,6 +154,10 @@ struct ProcessStartInfo
   /// Indicates whether output shall be written to a pipe.
   bool RedirectStandardOutput = false;
 
+  /// Requested capacity (in bytes) of the `stdin` pipe; `0` means the
+  /// system default.
+  std::size_t StandardInputPipeSize = 0;
+
   /// Working directory for the process.
   std::string WorkingDirectory;
   
@@ -197,6 +202,25 @@ struct ProcessInfo
   int parent = -1;
 };
 
+/// Child process accounting record.
+struct ChildProcessRecord
+{
+  /// The command line of the child process.
+  std::string commandLine;
+  /// The job on whose behalf the child process was started.
+  std::string job;
+  /// The system process ID.
+  int systemId = -1;
+  /// How the child process has terminated (`None`, if it was not waited for).
+  ProcessExitStatus exitStatus = ProcessExitStatus::None;
+  /// The exit code (only valid if the process has exited).
+  int exitCode = -1;
+  /// The time elapsed between start and termination.
+  std::chrono::steady_clock::duration wallTime = std::chrono::steady_clock::duration::zero();
+  /// The CPU time (user and system) consumed by the child process.
+  std::chrono::nanoseconds cpuTime = std::chrono::nanoseconds::zero();
+};
+
 /// An instance of this class manages a child process.
 class MIKTEXNOVTABLE Process
 {
@@ -426,6 +450,16 @@ public:
 
 public:
   static MIKTEXCORECEEAPI(void) Overlay(const MiKTeX::Util::PathName& fileName, const std::vector<std::string>& arguments);
+
+  /// Sets the job name which is recorded for subsequently started child processes.
+  /// @param job The job name.
+public:
+  static MIKTEXCORECEEAPI(void) SetAccountingJob(const std::string& job);
+
+  /// Gets the accounting records of the child processes started so far.
+  /// @return Returns the records in the order of termination.
+public:
+  static MIKTEXCORECEEAPI(std::vector<ChildProcessRecord>) GetChildProcessRecords();
 };
 
 MIKTEX_CORE_END_NAMESPACE;
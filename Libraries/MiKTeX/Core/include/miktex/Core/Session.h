@@ -31,6 +31,7 @@
 #endif
 
 #include <cstddef>
+#include <cstdint>
 
 #include <chrono>
 #include <memory>
@@ -252,12 +253,33 @@ struct FileTypeInfo
   std::vector<std::string> envVarNames;
 };
 
+/// Where a file has been found.
+enum class FileLookupSource
+{
+  /// The file has not been searched.
+  None,
+  /// The file has been found in a file name database.
+  Fndb,
+  /// The file has been found by searching the file system.
+  FileSystem
+};
+
 /// File information.
 struct FileInfoRecord
 {
   std::string fileName;
   std::string packageName;
   FileAccess access = FileAccess::None;
+  /// Where the file has been found.
+  FileLookupSource lookupSource = FileLookupSource::None;
+  /// The time spent searching the file.
+  std::chrono::steady_clock::duration lookupTime = std::chrono::steady_clock::duration::zero();
+  /// The time spent opening the file.
+  std::chrono::steady_clock::duration openTime = std::chrono::steady_clock::duration::zero();
+  /// The number of bytes read (known when the file has been closed).
+  std::size_t bytesRead = 0;
+  /// The number of bytes written (known when the file has been closed).
+  std::size_t bytesWritten = 0;
 };
 
 /// User information.
@@ -397,7 +419,66 @@ struct LocateResult {
   std::vector<MiKTeX::Util::PathName> pathNames;
 };
 
+/// Search statistics.
+struct LocateStatistics {
+  /// The number of searches.
+  std::size_t count = 0;
+  /// The time spent searching.
+  std::chrono::steady_clock::duration duration = std::chrono::steady_clock::duration::zero();
+  /// The number of unsuccessful searches.
+  std::size_t misses = 0;
+  /// The time spent in unsuccessful searches.
+  std::chrono::steady_clock::duration missDuration = std::chrono::steady_clock::duration::zero();
+  /// The number of package installation requests made while searching.
+  std::size_t installations = 0;
+  /// The time spent in package installation requests.
+  std::chrono::steady_clock::duration installationDuration = std::chrono::steady_clock::duration::zero();
+};
+
+struct FontInfo {
+  bool found = false;
+  std::string supplier;
+  std::string typeface;
+  double genSize = 0.0;
+};
+
+/// Character dimensions of a TFM file.
+struct FontMetrics {
+  /// The file system path to the TFM file.
+  MiKTeX::Util::PathName path;
+  /// The checksum of the TFM file.
+  std::uint32_t checkSum = 0;
+  /// The design size (a fix_word).
+  std::int32_t designSize = 0;
+  /// The smallest character code.
+  int firstChar = 0;
+  /// The character widths (fix_words), indexed by `charCode - firstChar`.
+  std::vector<std::int32_t> widths;
+  /// The character heights (fix_words), indexed by `charCode - firstChar`.
+  std::vector<std::int32_t> heights;
+  /// The character depths (fix_words), indexed by `charCode - firstChar`.
+  std::vector<std::int32_t> depths;
+};
+
+/// The result of a font map index lookup.
+enum class FontMapIndexLookup {
+  /// The font name was found.
+  Found,
+  /// The font name is not in the font map.
+  NotFound,
+  /// The font map has no up-to-date index: the caller must parse the
+  /// font map file.
+  NoIndex
+};
+
 /// The MiKTeX session interface.
+///
+/// File lookups (`FindFile()`, `Locate()`, `FindFiles()`) and
+/// configuration value lookups can be made concurrently from several
+/// threads. Calls which change the session state (e.g.,
+/// `SetConfigValue()`, `AddInputDirectory()`, `PushAppName()`) must
+/// not run concurrently with lookups. Threads which need their own
+/// working directories use a `WorkingDirectoryContext`.
 class MIKTEXNOVTABLE Session :
   public MiKTeX::Configuration::ConfigurationProvider
 {
@@ -800,6 +881,17 @@ public:
   /// @return Return the result of the search.
   virtual LocateResult MIKTEXTHISCALL Locate(const std::string& fileName, const LocateOptions& options) = 0;
 
+  /// Searches several files.
+  /// @param fileNames The names of the files to search.
+  /// @param options Search options; they apply to each file.
+  /// @return Returns the search results in the order of `fileNames`.
+  virtual std::vector<LocateResult> MIKTEXTHISCALL FindFiles(const std::vector<std::string>& fileNames, const LocateOptions& options) = 0;
+
+  /// Gets search statistics.
+  /// @return Returns the number of searches (`Locate()`, `FindFile()`, `FindFiles()`)
+  /// and the time spent searching, since the session was initialized.
+  virtual LocateStatistics MIKTEXTHISCALL GetLocateStatistics() = 0;
+
   /// Searches a file.
   /// @param fileName The name of the file to search.
   /// @param searchPath The search path.
@@ -896,6 +988,48 @@ public:
   /// @return Returns `true`, if the font was found.
   virtual bool MIKTEXTHISCALL GetFontInfo(const std::string& fontName, std::string& supplier, std::string& typeface, double* genSize) = 0;
 
+  /// Searches several font files.
+  /// @param fontNames The names of the fonts to search.
+  /// @return Returns the font information in the order of `fontNames`.
+  virtual std::vector<FontInfo> MIKTEXTHISCALL GetFontInfos(const std::vector<std::string>& fontNames) = 0;
+
+  /// Gets the character dimensions of a font. The dimensions are taken
+  /// from the font metric cache, which is shared by all MiKTeX programs.
+  /// Otherwise the TFM file is searched (not created) and read, and the
+  /// dimensions are added to the cache.
+  /// @param fontName The name of the font.
+  /// @param checkSum The expected checksum of the TFM file; `0`, if unknown.
+  /// @param[out] metrics The character dimensions.
+  /// @return Returns `true`, if the TFM file was found.
+  virtual bool MIKTEXTHISCALL GetFontMetrics(const std::string& fontName, std::uint32_t checkSum, FontMetrics& metrics) = 0;
+
+  /// Writes the index of a font map file. The index is stored next to the
+  /// font map file and allows to look up a font without parsing the font map.
+  /// @param mapFile The file system path to the font map file.
+  virtual void MIKTEXTHISCALL WriteFontMapIndex(const MiKTeX::Util::PathName& mapFile) = 0;
+
+  /// Looks up a font in the index of a font map file.
+  /// @param mapFileName The name of the font map file (e.g., `pdftex.map`).
+  /// @param fontName The name of the font (the first word of a map line).
+  /// @param[out] lines The map lines for the font, in file order.
+  /// @return Returns `FontMapIndexLookup::NoIndex`, if the font map file has
+  /// no index, or if the index is outdated, or if the font map contains
+  /// subfont entries (`name@sfd@`), which cannot be looked up by font name.
+  virtual FontMapIndexLookup MIKTEXTHISCALL LookupFontMapIndex(const std::string& mapFileName, const std::string& fontName, std::vector<std::string>& lines) = 0;
+
+  /// Reduces a BibTeX database to the entries needed for a set of cite keys.
+  /// The database is parsed once; the parse result is cached, keyed by the
+  /// MD5 of the contents. Entries which are neither cited nor
+  /// cross-referenced are replaced by their line breaks, so that line
+  /// numbers are preserved. `@string` and `@preamble` commands are kept.
+  /// @param database The contents of the `.bib` file.
+  /// @param citeKeys The cite keys.
+  /// @param[out] reduced The reduced contents.
+  /// @return Returns `false`, if the database cannot be reduced safely (e.g.,
+  /// if it contains syntax errors, which BibTeX must report), or if `*` is
+  /// cited.
+  virtual bool MIKTEXTHISCALL ReduceBibDatabase(const std::string& database, const std::vector<std::string>& citeKeys, std::string& reduced) = 0;
+
   /// Searches the Ghostscript program.
   /// @param[out] versionNumber The Ghostscript version number
   /// @return Returns the file system path to the Ghostscript program file.
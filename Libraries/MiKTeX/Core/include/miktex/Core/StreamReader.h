@@ -26,6 +26,9 @@
 
 #include <miktex/Core/config.h>
 
+#include <memory>
+#include <string>
+
 #include <miktex/Util/PathName>
 
 #include "FileStream.h"
@@ -35,7 +38,7 @@ MIKTEX_CORE_BEGIN_NAMESPACE;
 class StreamReader
 {
 public:
-  StreamReader() = default;
+  MIKTEXCOREEXPORT MIKTEXTHISCALL StreamReader();
 
 public:
   StreamReader(const StreamReader& other) = delete;
@@ -55,11 +58,15 @@ public:
 public:
   MIKTEXCOREEXPORT MIKTEXTHISCALL StreamReader(const MiKTeX::Util::PathName& path);
 
+  /// Opens a file for reading.
+  /// @param path The path to the file.
+  /// @param readAhead Indicates whether the next block of the file shall be
+  /// read by a background thread while the current block is being consumed.
+public:
+  MIKTEXCOREEXPORT MIKTEXTHISCALL StreamReader(const MiKTeX::Util::PathName& path, bool readAhead);
+
 public:
-  StreamReader(bool readStdin) :
-    stream(readStdin ? stdin : nullptr)
-  {
-  }
+  MIKTEXCOREEXPORT MIKTEXTHISCALL StreamReader(bool readStdin);
 
 public:
   MIKTEXCORETHISAPI(bool) ReadLine(std::string& line);
@@ -69,6 +76,12 @@ public:
 
 private:
   FileStream stream;
+
+private:
+  class ReadAhead;
+
+private:
+  std::unique_ptr<ReadAhead> readAhead;
 };
 
 MIKTEX_CORE_END_NAMESPACE;
@@ -28,10 +28,22 @@
 
 #include <memory>
 
+#include <miktex/Util/OptionSet>
 #include <miktex/Util/PathName>
 
 MIKTEX_CORE_BEGIN_NAMESPACE;
 
+/// Temporary directory options.
+enum class TemporaryDirectoryOption
+{
+  /// Create the directory on a memory-backed file system (tmpfs), if
+  /// there is one with enough free space; otherwise in the temporary
+  /// directory.
+  InMemory
+};
+
+typedef MiKTeX::Util::OptionSet<TemporaryDirectoryOption> TemporaryDirectoryOptionSet;
+
 class MIKTEXNOVTABLE TemporaryDirectory
 {
 public:
@@ -52,6 +64,9 @@ public:
 public:
   static MIKTEXCORECEEAPI(std::unique_ptr<TemporaryDirectory>) Create();
 
+public:
+  static MIKTEXCORECEEAPI(std::unique_ptr<TemporaryDirectory>) Create(TemporaryDirectoryOptionSet options);
+
 public:
   static MIKTEXCORECEEAPI(std::unique_ptr<TemporaryDirectory>) Create(const MiKTeX::Util::PathName& path);
 };
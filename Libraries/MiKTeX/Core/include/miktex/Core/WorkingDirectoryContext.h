@@ -0,0 +1,94 @@
+/* miktex/Core/WorkingDirectoryContext.h:               -*- C++ -*-
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(C41D7E0A9B3F4E6D8A2C5F1B7E9D3A60)
+#define C41D7E0A9B3F4E6D8A2C5F1B7E9D3A60
+
+#include <miktex/Core/config.h>
+
+#include <memory>
+#include <vector>
+
+#include <miktex/Util/PathName>
+
+MIKTEX_CORE_BEGIN_NAMESPACE;
+
+/// Working directories of the calling thread.
+///
+/// While an instance is alive, the session resolves relative file
+/// names looked up by the creating thread against the given working
+/// directory and input directories, instead of the process-wide ones
+/// (see `Session::AddInputDirectory()`). Contexts nest: the previous
+/// context of the thread is restored on destruction.
+///
+/// Hosts which serve several documents from one process create a
+/// context per request.
+class WorkingDirectoryContext
+{
+public:
+  WorkingDirectoryContext() = delete;
+
+public:
+  WorkingDirectoryContext(const WorkingDirectoryContext& other) = delete;
+
+public:
+  WorkingDirectoryContext& operator=(const WorkingDirectoryContext& other) = delete;
+
+public:
+  WorkingDirectoryContext(WorkingDirectoryContext&& other) = delete;
+
+public:
+  WorkingDirectoryContext& operator=(WorkingDirectoryContext&& other) = delete;
+
+  /// Makes this the context of the calling thread.
+  /// @param workingDirectory The fully qualified working directory.
+  /// @param inputDirectories Fully qualified input directories.
+public:
+  MIKTEXCOREEXPORT MIKTEXTHISCALL WorkingDirectoryContext(const MiKTeX::Util::PathName& workingDirectory, const std::vector<MiKTeX::Util::PathName>& inputDirectories);
+
+  /// Restores the previous context of the calling thread.
+public:
+  virtual MIKTEXCOREEXPORT MIKTEXTHISCALL ~WorkingDirectoryContext() noexcept;
+
+  /// Gets the working directory.
+public:
+  MIKTEXCORETHISAPI(const MiKTeX::Util::PathName&) GetWorkingDirectory() const;
+
+  /// Gets the input directories.
+public:
+  MIKTEXCORETHISAPI(const std::vector<MiKTeX::Util::PathName>&) GetInputDirectories() const;
+
+  /// Gets the context of the calling thread.
+  /// @return Returns `nullptr`, if the thread uses the process-wide
+  /// working directories.
+public:
+  static MIKTEXCORECEEAPI(const WorkingDirectoryContext*) GetCurrent();
+
+private:
+  class impl;
+  std::unique_ptr<impl> pimpl;
+};
+
+MIKTEX_CORE_END_NAMESPACE;
+
+#endif
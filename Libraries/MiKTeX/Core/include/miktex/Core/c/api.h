@@ -28,6 +28,7 @@ MIKTEX_BEGIN_EXTERN_C_BLOCK;
 MIKTEXCORECEEAPI(void) miktex_create_temp_file_name(char* fileName);
 MIKTEXCOREEXPORT MIKTEXNORETURN void MIKTEXCEECALL miktex_exit(int status);
 MIKTEXCORECEEAPI(int) miktex_execute_system_command(const char* command, int* exitCode);
+MIKTEXCORECEEAPI(int) miktex_fclose_stream(FILE* file);
 MIKTEXCORECEEAPI(int) miktex_find_input_file(const char* applicationName, const char* fileName, char* path);
 MIKTEXCORECEEAPI(int) miktex_find_enc_file(const char* fontName, char* path);
 MIKTEXCORECEEAPI(int) miktex_find_file(const char* fileName, const char* pathList, char* path);
@@ -36,11 +37,18 @@ MIKTEXCORECEEAPI(int) miktex_find_miktex_executable(const char* exeName, char* e
 MIKTEXCORECEEAPI(int) miktex_find_psheader_file(const char* headerName, char* path);
 MIKTEXCORECEEAPI(int) miktex_find_tfm_file(const char* fontName, char* path);
 MIKTEXCORECEEAPI(int) miktex_find_ttf_file(const char* fontName, char* path);
+/* Opens a file like fopen(), but with a large stream buffer, so that
+   the file is read and written in big chunks.  Close the file with
+   miktex_fclose_stream(). */
+MIKTEXCORECEEAPI(FILE*) miktex_fopen_stream(const char* fileName, const char* mode);
 MIKTEXCORECEEAPI(int) miktex_get_miktex_banner(char* buf, size_t bufSize);
 MIKTEXCORECEEAPI(int) miktex_get_miktex_version_string_ex(char* version, size_t maxsize);
 MIKTEXCORECEEAPI(unsigned) miktex_get_number_of_texmf_roots();
 MIKTEXCORECEEAPI(char*) miktex_get_root_directory(unsigned r, char* path);
 MIKTEXCORECEEAPI(int) miktex_is_pipe(FILE* fi9le);
+/* Sorts like qsort(), but stable; large arrays are sorted by several
+   threads, i.e., compare must be thread-safe. */
+MIKTEXCORECEEAPI(void) miktex_parallel_sort(void* base, size_t n, size_t size, int (*compare)(const void*, const void*));
 MIKTEXCORECEEAPI(int) miktex_pathcmp(const char* path1, const char* path2);
 MIKTEXCORECEEAPI(int) miktex_pclose(FILE* file);
 MIKTEXCORECEEAPI(FILE*) miktex_popen(const char* commandLine, const char* mode);
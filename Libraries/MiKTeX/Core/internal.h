@@ -25,6 +25,7 @@
 
 #include <miktex/Trace/TraceStream>
 
+#include <miktex/Core/Process>
 #include <miktex/Core/Quoter>
 #include <miktex/Core/Session>
 
@@ -222,6 +223,10 @@ bool GetWindowsErrorMessage(unsigned long functionResult, std::string& errorMess
 
 const char* GetFileNameExtension(const char* path);
 
+void RecordChildProcess(MiKTeX::Core::ChildProcessRecord&& record);
+
+std::string GetAccountingJob();
+
 enum class CryptoLib
 {
     None,
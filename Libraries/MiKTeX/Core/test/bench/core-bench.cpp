@@ -0,0 +1,513 @@
+/* core-bench.cpp: micro-benchmarks of the Core library
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/BZip2Stream>
+#include <miktex/Core/Cfg>
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/FileType>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/GzipStream>
+#include <miktex/Core/LzmaStream>
+#include <miktex/Core/Session>
+#include <miktex/Core/Utils>
+#include <miktex/Util/PathName>
+#include <miktex/Wrappers/PoptWrapper>
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+using namespace MiKTeX::Wrappers;
+using namespace std;
+
+/*
+ * core-bench times the hot paths of the Core library and writes the
+ * results as JSON, one fixture per line, so that two runs can be
+ * compared with diff:
+ *
+ *   {"name": "fndb/lookup/hit", "iterations": 100000, "total_ns": ..., "ns_per_op": ...}
+ *
+ * The synthetic file name database is built from an in-memory tree, so
+ * that a large tree does not have to exist on disk.
+ */
+
+enum {
+  OPT_AAA = 1234,
+  OPT_FILES,
+  OPT_FILTER,
+  OPT_ITERATIONS,
+  OPT_OUTPUT,
+};
+
+static const struct poptOption long_options[] = {
+  {
+    "files", 0, POPT_ARG_STRING, nullptr, OPT_FILES, "Sets the number of files in the synthetic tree.", "N"
+  },
+  {
+    "filter", 0, POPT_ARG_STRING, nullptr, OPT_FILTER, "Runs only the fixtures whose name starts with PREFIX.", "PREFIX"
+  },
+  {
+    "iterations", 0, POPT_ARG_STRING, nullptr, OPT_ITERATIONS, "Sets the number of iterations of the lookup fixtures.", "N"
+  },
+  {
+    "output", 0, POPT_ARG_STRING, nullptr, OPT_OUTPUT, "Writes the results to FILE.", "FILE"
+  },
+  POPT_AUTOHELP
+  POPT_TABLEEND
+};
+
+// the categories of the synthetic tree: one directory out of five
+// belongs to each of them
+struct Category
+{
+  const char* directory;
+  const char* extension;
+  FileType fileType;
+};
+
+static const Category categories[] = {
+  { "tex/latex", ".sty", FileType::TEX },
+  { "fonts/tfm/public", ".tfm", FileType::TFM },
+  { "fonts/type1/public", ".pfb", FileType::TYPE1 },
+  { "fonts/opentype/public", ".otf", FileType::OTF },
+  { "bibtex/bst", ".bst", FileType::BST },
+};
+
+constexpr size_t FILES_PER_DIRECTORY = 100;
+
+class SyntheticTree :
+  public ICreateFndbCallback
+{
+public:
+  SyntheticTree(const PathName& rootDirectory, size_t numFiles) :
+    rootDirectory(rootDirectory)
+  {
+    size_t numDirectories = (numFiles + FILES_PER_DIRECTORY - 1) / FILES_PER_DIRECTORY;
+    for (size_t dirIdx = 0; dirIdx < numDirectories; ++dirIdx)
+    {
+      const Category& category = categories[dirIdx % size(categories)];
+      string packageDirectory = fmt::format("{0}/pkg{1}", category.directory, dirIdx);
+      AddDirectory(packageDirectory);
+      vector<string>& fileNames = directories[packageDirectory].fileNames;
+      for (size_t fileIdx = 0; fileIdx < FILES_PER_DIRECTORY && dirIdx * FILES_PER_DIRECTORY + fileIdx < numFiles; ++fileIdx)
+      {
+        fileNames.push_back(FileName(dirIdx, fileIdx));
+      }
+    }
+  }
+
+public:
+  bool MIKTEXTHISCALL ReadDirectory(const PathName& path, vector<string>& subDirNames, vector<string>& fileNames, vector<string>& fileNameInfos) override
+  {
+    string relativePath;
+    const char* rel = Utils::GetRelativizedPath(path.GetData(), rootDirectory.GetData());
+    if (rel != nullptr)
+    {
+      relativePath = PathName(rel).ToUnix().ToString();
+    }
+    auto it = directories.find(relativePath);
+    if (it == directories.end())
+    {
+      return true;
+    }
+    subDirNames = it->second.subDirNames;
+    fileNames = it->second.fileNames;
+    fileNameInfos.assign(fileNames.size(), "");
+    return true;
+  }
+
+public:
+  bool MIKTEXTHISCALL OnProgress(unsigned level, const PathName& directory) override
+  {
+    return true;
+  }
+
+public:
+  static string FileName(size_t dirIdx, size_t fileIdx)
+  {
+    return fmt::format("f{0}-{1}{2}", dirIdx, fileIdx, categories[dirIdx % size(categories)].extension);
+  }
+
+private:
+  void AddDirectory(const string& relativePath)
+  {
+    if (directories.find(relativePath) != directories.end())
+    {
+      return;
+    }
+    directories[relativePath];
+    size_t slash = relativePath.rfind('/');
+    string parent = slash == string::npos ? "" : relativePath.substr(0, slash);
+    if (!relativePath.empty())
+    {
+      AddDirectory(parent);
+      directories[parent].subDirNames.push_back(relativePath.substr(slash == string::npos ? 0 : slash + 1));
+    }
+  }
+
+private:
+  struct DirectoryContents
+  {
+    vector<string> subDirNames;
+    vector<string> fileNames;
+  };
+
+private:
+  unordered_map<string, DirectoryContents> directories;
+
+private:
+  PathName rootDirectory;
+};
+
+class CoreBench
+{
+public:
+  void Run(int argc, const char** argv);
+
+private:
+  void BenchFndb();
+
+private:
+  void BenchFindFile();
+
+private:
+  void BenchCfg();
+
+private:
+  void BenchPathName();
+
+private:
+  void BenchCompression();
+
+private:
+  void Measure(const string& name, size_t iterations, function<void()> body, size_t bytesPerIteration = 0);
+
+private:
+  // NAME is a fixture or a group of fixtures (e.g. "fndb/")
+  bool Enabled(const string& name) const
+  {
+    size_t n = min(name.length(), filter.length());
+    return name.compare(0, n, filter, 0, n) == 0;
+  }
+
+private:
+  size_t numFiles = 500000;
+
+private:
+  size_t iterations = 100000;
+
+private:
+  string filter;
+
+private:
+  ostream* out = &cout;
+
+private:
+  PathName treeRoot;
+
+private:
+  shared_ptr<Session> session;
+};
+
+void CoreBench::Measure(const string& name, size_t iterations, function<void()> body, size_t bytesPerIteration)
+{
+  if (!Enabled(name))
+  {
+    return;
+  }
+  auto start = chrono::steady_clock::now();
+  for (size_t idx = 0; idx < iterations; ++idx)
+  {
+    body();
+  }
+  auto totalNs = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+  string line = fmt::format("{{\"name\": \"{0}\", \"iterations\": {1}, \"total_ns\": {2}, \"ns_per_op\": {3}", name, iterations, totalNs, iterations == 0 ? 0 : totalNs / iterations);
+  if (bytesPerIteration > 0 && totalNs > 0)
+  {
+    line += fmt::format(", \"mb_per_s\": {0:.1f}", (static_cast<double>(bytesPerIteration) * iterations / (1024.0 * 1024.0)) / (totalNs / 1e9));
+  }
+  line += "}";
+  *out << line << endl;
+}
+
+void CoreBench::BenchFndb()
+{
+  if (!Enabled("fndb/") && !Enabled("findfile/"))
+  {
+    return;
+  }
+  SyntheticTree tree(treeRoot, numFiles);
+  unsigned root = session->DeriveTEXMFRoot(treeRoot);
+  PathName fndbPath = session->GetFilenameDatabasePathName(root);
+  auto create = [&]() {
+    Fndb::Create(fndbPath, treeRoot, &tree);
+  };
+  if (Enabled("fndb/create"))
+  {
+    Measure("fndb/create", 1, create);
+  }
+  else
+  {
+    // the FindFile() fixtures need the database
+    create();
+  }
+  string pattern = (treeRoot / PathName("tex//")).ToString();
+  vector<Fndb::Record> records;
+  Measure("fndb/load", 5, [&]() {
+    session->UnloadFilenameDatabase();
+    records.clear();
+    Fndb::Search(PathName(SyntheticTree::FileName(0, 0)), pattern, false, records);
+  });
+  size_t numDirectories = (numFiles + FILES_PER_DIRECTORY - 1) / FILES_PER_DIRECTORY;
+  // only the directories of the first category are below tex/
+  size_t texDirectories = (numDirectories + size(categories) - 1) / size(categories);
+  size_t n = 0;
+  Measure("fndb/lookup/hit", iterations, [&]() {
+    records.clear();
+    size_t dirIdx = (n++ % texDirectories) * size(categories);
+    Fndb::Search(PathName(SyntheticTree::FileName(dirIdx, n % FILES_PER_DIRECTORY)), pattern, false, records);
+  });
+  Measure("fndb/lookup/miss", iterations, [&]() {
+    records.clear();
+    Fndb::Search(PathName(fmt::format("nonexistent{0}.sty", n++)), pattern, false, records);
+  });
+}
+
+void CoreBench::BenchFindFile()
+{
+  // FindFile() checks that a candidate exists: the first file of each
+  // category is created on disk
+  for (size_t catIdx = 0; catIdx < size(categories) && catIdx * FILES_PER_DIRECTORY < numFiles; ++catIdx)
+  {
+    PathName dir = treeRoot / PathName(fmt::format("{0}/pkg{1}", categories[catIdx].directory, catIdx));
+    Directory::Create(dir);
+    PathName path = dir / PathName(SyntheticTree::FileName(catIdx, 0));
+    if (!File::Exists(path))
+    {
+      File::WriteBytes(path, {});
+    }
+  }
+  for (size_t catIdx = 0; catIdx < size(categories) && catIdx * FILES_PER_DIRECTORY < numFiles; ++catIdx)
+  {
+    const Category& category = categories[catIdx];
+    string typeName = session->GetFileTypeInfo(category.fileType).fileTypeString;
+    string hitName = SyntheticTree::FileName(catIdx, 0);
+    PathName path;
+    Measure(fmt::format("findfile/{0}/hit", typeName), iterations / 10, [&]() {
+      session->FindFile(hitName, category.fileType, path);
+    });
+    size_t n = 0;
+    Measure(fmt::format("findfile/{0}/miss", typeName), iterations / 10, [&]() {
+      session->FindFile(fmt::format("nonexistent{0}{1}", n++, category.extension), category.fileType, path);
+    });
+  }
+}
+
+void CoreBench::BenchCfg()
+{
+  if (!Enabled("cfg/"))
+  {
+    return;
+  }
+  PathName iniFile = treeRoot / PathName("bench.ini");
+  {
+    ofstream stream = File::CreateOutputStream(iniFile);
+    for (size_t keyIdx = 0; keyIdx < 2000; ++keyIdx)
+    {
+      stream << fmt::format("[section{0}]\n", keyIdx);
+      for (size_t valueIdx = 0; valueIdx < 50; ++valueIdx)
+      {
+        stream << fmt::format("value{0}=the quick brown fox jumps over the lazy dog {1}\n", valueIdx, keyIdx * valueIdx);
+      }
+    }
+    stream.close();
+  }
+  size_t fileSize = File::GetSize(iniFile);
+  Measure("cfg/read", 10, [&]() {
+    unique_ptr<Cfg> cfg = Cfg::Create();
+    cfg->Read(iniFile);
+  }, fileSize);
+  unique_ptr<Cfg> cfg = Cfg::Create();
+  cfg->Read(iniFile);
+  size_t n = 0;
+  string value;
+  Measure("cfg/lookup", iterations, [&]() {
+    cfg->TryGetValueAsString(fmt::format("section{0}", n % 2000), fmt::format("value{0}", n % 50), value);
+    ++n;
+  });
+}
+
+void CoreBench::BenchPathName()
+{
+  const PathName samples[] = {
+    PathName("/usr/local/share/texmf/tex/latex/base/article.cls"),
+    PathName("tex/latex/../latex/./base//article.cls"),
+    PathName("C:\\Users\\Joe\\AppData\\Roaming\\MiKTeX\\tex\\latex\\base\\article.cls"),
+    PathName("fonts/tfm/public/cm/cmr10.tfm"),
+  };
+  size_t n = 0;
+  Measure("pathname/canonicalize", iterations, [&]() {
+    PathName path = samples[n++ % size(samples)];
+    path.Canonicalize();
+  });
+  Measure("pathname/transform-for-comparison", iterations, [&]() {
+    PathName path = samples[n++ % size(samples)];
+    path.TransformForComparison();
+  });
+  Measure("pathname/compare", iterations, [&]() {
+    PathName::Compare(samples[n % size(samples)], samples[(n + 1) % size(samples)]);
+    ++n;
+  });
+  Measure("pathname/append", iterations, [&]() {
+    PathName path = samples[0].GetDirectoryName();
+    path /= samples[3];
+  });
+}
+
+void CoreBench::BenchCompression()
+{
+  struct Sample
+  {
+    const char* name;
+    const char* fileName;
+    function<unique_ptr<Stream>(const PathName&)> open;
+  };
+  const Sample samples[] = {
+    { "bzip2", "largefile.bin.bz2", [](const PathName& path) -> unique_ptr<Stream> { return BZip2Stream::Create(path, true); } },
+    { "gzip", "test1.txt.gz", [](const PathName& path) -> unique_ptr<Stream> { return GzipStream::Create(path, true); } },
+    { "xz", "test1.txt.xz", [](const PathName& path) -> unique_ptr<Stream> { return LzmaStream::Create(path, true); } },
+  };
+  for (const Sample& sample : samples)
+  {
+    PathName path = PathName(TEST_SOURCE_DIR) / PathName("compression") / PathName(sample.fileName);
+    auto decompress = [&]() {
+      unique_ptr<Stream> stream = sample.open(path);
+      char buf[65536];
+      size_t n;
+      size_t total = 0;
+      while ((n = stream->Read(buf, sizeof(buf))) > 0)
+      {
+        total += n;
+      }
+      return total;
+    };
+    size_t bytes = decompress();
+    Measure(fmt::format("decompress/{0}", sample.name), 10, decompress, bytes);
+  }
+}
+
+void CoreBench::Run(int argc, const char** argv)
+{
+  PoptWrapper popt(argc, argv, long_options);
+
+  int option;
+
+  string outputFile;
+
+  while ((option = popt.GetNextOpt()) >= 0)
+  {
+    string optArg = popt.GetOptArg();
+    switch (option)
+    {
+    case OPT_FILES:
+      numFiles = std::stoul(optArg);
+      break;
+    case OPT_FILTER:
+      filter = optArg;
+      break;
+    case OPT_ITERATIONS:
+      iterations = std::stoul(optArg);
+      break;
+    case OPT_OUTPUT:
+      outputFile = optArg;
+      break;
+    }
+  }
+
+  if (option < -1)
+  {
+    cerr << popt.BadOption(POPT_BADOPTION_NOALIAS) << ": " << popt.Strerror(option) << endl;
+    throw 1;
+  }
+
+  treeRoot = PathName(TEST_BINARY_DIR) / PathName("bench-tree");
+  Directory::Create(treeRoot);
+
+  Session::InitInfo initInfo(argv[0]);
+  StartupConfig startupConfig;
+  startupConfig.userRoots = treeRoot.ToString();
+  startupConfig.userDataRoot = DATAROOT;
+  startupConfig.userInstallRoot = INSTALLROOT;
+  initInfo.SetStartupConfig(startupConfig);
+  session = Session::Create(initInfo);
+
+  ofstream outputStream;
+  if (!outputFile.empty())
+  {
+    outputStream = File::CreateOutputStream(PathName(outputFile));
+    out = &outputStream;
+  }
+
+  BenchFndb();
+  BenchFindFile();
+  BenchCfg();
+  BenchPathName();
+  BenchCompression();
+
+  session->Close();
+  session = nullptr;
+}
+
+int main(int argc, const char** argv)
+{
+  try
+  {
+    CoreBench app;
+    app.Run(argc, argv);
+    return 0;
+  }
+  catch (const MiKTeXException& e)
+  {
+    Utils::PrintException(e);
+    return 1;
+  }
+  catch (const exception& e)
+  {
+    Utils::PrintException(e);
+    return 1;
+  }
+  catch (int retCode)
+  {
+    return retCode;
+  }
+}
@@ -34,6 +34,7 @@
 
 #include <miktex/Core/BufferSizes>
 #include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
 #include <miktex/Core/Exceptions>
 #include <miktex/Core/File>
 #include <miktex/Core/FileSystemWatcher>
@@ -244,6 +245,35 @@ BEGIN_TEST_FUNCTION(8);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(9);
+{
+  TESTX(Directory::Create(PathName("9/a/x")));
+  TESTX(Directory::Create(PathName("9/b")));
+  Touch("9/a/1.txt");
+  Touch("9/a/2.txt");
+  Touch("9/b/3.txt");
+  vector<DirectoryEntry> entries = DirectoryLister::ReadDirectory(PathName("9"), nullptr, (int)DirectoryLister::Options::DirectoriesOnly);
+  TEST(entries.size() == 2);
+  vector<PathName> subdirs;
+  for (const DirectoryEntry& entry : entries)
+  {
+    TEST(entry.isDirectory);
+    subdirs.push_back(PathName("9") / PathName(entry.name));
+  }
+  vector<vector<DirectoryEntry>> subdirEntries = DirectoryLister::ReadDirectories(subdirs, "*.txt", (int)DirectoryLister::Options::FilesOnly);
+  TEST(subdirEntries.size() == 2);
+  TEST(subdirEntries[0].size() + subdirEntries[1].size() == 3);
+  for (const vector<DirectoryEntry>& v : subdirEntries)
+  {
+    for (const DirectoryEntry& entry : v)
+    {
+      TEST(!entry.isDirectory);
+    }
+  }
+  TESTX(Directory::Delete(PathName("9"), true));
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
@@ -256,6 +286,7 @@ BEGIN_TEST_PROGRAM();
 #endif
   CALL_TEST_FUNCTION(7);
   CALL_TEST_FUNCTION(8);
+  CALL_TEST_FUNCTION(9);
 }
 END_TEST_PROGRAM();
 
@@ -23,14 +23,17 @@
 
 #include <miktex/Core/Test>
 
+#include <future>
 #include <string>
 #include <vector>
 
+#include <miktex/Configuration/ConfigNames>
 #include <miktex/Core/Directory>
 #include <miktex/Core/File>
 #include <miktex/Core/Fndb>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Utils>
+#include <miktex/Core/WorkingDirectoryContext>
 #include <miktex/Util/PathName>
 #include <miktex/Util/StringUtil>
 
@@ -120,12 +123,62 @@ BEGIN_TEST_FUNCTION(4);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(5);
+{
+  LocateOptions options;
+  options.searchPath = StringUtil::Flatten({ "%R/ab//", "%R/jk//" }, PathNameUtil::PathNameDelimiter);
+  vector<LocateResult> results = pSession->FindFiles({ "xyz.txt", "abrakadabra-does-not-exist.txt", "xyz.txt" }, options);
+  TEST(results.size() == 3);
+  TEST(!results[0].pathNames.empty());
+  TEST(results[1].pathNames.empty());
+  TEST(results[2].pathNames == results[0].pathNames);
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(6);
+{
+  PathName cwd;
+  cwd.SetToCurrentDirectory();
+  PathName dir1 = cwd / PathName("wd1");
+  PathName dir2 = cwd / PathName("wd2");
+  TESTX(Directory::Create(dir1));
+  TESTX(Directory::Create(dir2));
+  Touch((dir1 / PathName("only-in-wd1.tex")).GetData());
+  auto lookups = [this](const PathName& workingDirectory, bool expectFound)
+  {
+    WorkingDirectoryContext context(workingDirectory, {});
+    bool ok = true;
+    for (int n = 0; n < 100; ++n)
+    {
+      vector<PathName> paths;
+      ok = ok && pSession->FindFile("xyz.txt", StringUtil::Flatten({ "%R/ab//", "%R/jk//" }, PathNameUtil::PathNameDelimiter), paths) && paths.size() == 2;
+      PathName path;
+      ok = ok && pSession->FindFile("./only-in-wd1.tex", "%R/tex//", path) == expectFound;
+      string value;
+      ok = ok && !pSession->TryGetConfigValue(MIKTEX_CONFIG_SECTION_CORE, "NoSuchValue", value);
+    }
+    return ok;
+  };
+  future<bool> f1 = async(launch::async, lookups, dir1, true);
+  future<bool> f2 = async(launch::async, lookups, dir2, false);
+  future<bool> f3 = async(launch::async, lookups, dir1, true);
+  TEST(f1.get());
+  TEST(f2.get());
+  TEST(f3.get());
+  TEST(WorkingDirectoryContext::GetCurrent() == nullptr);
+  TESTX(Directory::Delete(dir1, true));
+  TESTX(Directory::Delete(dir2, true));
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
   CALL_TEST_FUNCTION(2);
   CALL_TEST_FUNCTION(3);
   CALL_TEST_FUNCTION(4);
+  CALL_TEST_FUNCTION(5);
+  CALL_TEST_FUNCTION(6);
 }
 END_TEST_PROGRAM();
 
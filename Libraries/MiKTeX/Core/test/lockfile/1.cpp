@@ -96,12 +96,32 @@ BEGIN_TEST_FUNCTION(4);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(5);
+{
+  unique_ptr<MiKTeX::Core::LockFile> reader1 = LockFile::Create(PathName("lockfile-1-4"));
+  unique_ptr<MiKTeX::Core::LockFile> reader2 = LockFile::Create(PathName("lockfile-1-4"));
+  unique_ptr<MiKTeX::Core::LockFile> writer = LockFile::Create(PathName("lockfile-1-4"));
+  TEST(reader1->TryLockShared(0s));
+  TEST(reader2->TryLockShared(0s));
+  TEST(!writer->TryLock(100ms));
+  reader1->Unlock();
+  TEST(File::Exists(PathName("lockfile-1-4")));
+  reader2->Unlock();
+  TEST(!File::Exists(PathName("lockfile-1-4")));
+  TEST(writer->TryLock(0s));
+  TEST(!reader1->TryLockShared(100ms));
+  writer->Unlock();
+  TEST(!File::Exists(PathName("lockfile-1-4")));
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
   CALL_TEST_FUNCTION(2);
   CALL_TEST_FUNCTION(3);
   CALL_TEST_FUNCTION(4);
+  CALL_TEST_FUNCTION(5);
 }
 END_TEST_PROGRAM();
 
@@ -26,6 +26,7 @@
 
 #include <miktex/Util/PathName>
 #include <miktex/Util/PathNameParser>
+#include <miktex/Util/PathNameView>
 
 #if defined(MIKTEX_WINDOWS)
 #include <direct.h>
@@ -299,6 +300,24 @@ BEGIN_TEST_FUNCTION(15);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(16);
+{
+  PathName path("/abc/def/ghi.jkl");
+  PathNameView view = path.View();
+  TEST(view.GetDirectoryName().ToString() == "/abc/def/");
+  TEST(view.GetDirectoryName().WithoutTrailingDirectoryDelimiter().ToString() == "/abc/def");
+  TEST(view.GetFileName().ToString() == "ghi.jkl");
+  TEST(view.GetExtension().ToString() == ".jkl");
+  TEST(PathNameView("ghi").GetDirectoryName().Empty());
+  TEST(PathNameView("ghi").GetExtension().Empty());
+  PathName path2("/abc");
+  path2 /= PathNameView("def/xyz", 3);
+  path2 /= view.GetFileName();
+  TEST(PathName::Compare(path2, PathName("/abc/def/ghi.jkl")) == 0);
+  TEST(PathName(view.GetDirectoryName()) == PathName("/abc/def"));
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
@@ -318,6 +337,7 @@ BEGIN_TEST_PROGRAM();
   CALL_TEST_FUNCTION(14);
 #endif
   CALL_TEST_FUNCTION(15);
+  CALL_TEST_FUNCTION(16);
 }
 END_TEST_PROGRAM();
 
@@ -1,6 +1,6 @@
 /* DibChunker.cpp:
 
-   Copyright (C) 2002-2020 Christian Schenk
+   Copyright (C) 2002-2023 Christian Schenk
 
    This file is part of the MiKTeX DibChunker Library.
 
@@ -21,6 +21,8 @@
 
 #include <Windows.h>
 
+#include <cstdint>
+#include <cstring>
 #include <memory>
 
 #include <fmt/format.h>
@@ -50,6 +52,53 @@ const RGBQUAD RGBQUAD_BLACK = { 0, 0, 0, 0 };
 
 const RGBQUAD whiteAndBlack[2] = { RGBQUAD_WHITE, RGBQUAD_BLACK };
 
+// The scan functions below compare eight bytes at a time; the
+// compiler turns the loops into vector code.
+
+// returns the index of the first byte which is not equal to value (or
+// n, if there is no such byte)
+inline size_t FindFirstNot(const unsigned char* p, size_t n, unsigned char value)
+{
+  const uint64_t pattern = 0x0101010101010101ULL * value;
+  size_t idx = 0;
+  for (; idx + 8 <= n; idx += 8)
+  {
+    uint64_t word;
+    memcpy(&word, p + idx, 8);
+    if (word != pattern)
+    {
+      break;
+    }
+  }
+  while (idx < n && p[idx] == value)
+  {
+    ++idx;
+  }
+  return idx;
+}
+
+// returns the index of the last byte which is not equal to value (or
+// n, if there is no such byte)
+inline size_t FindLastNot(const unsigned char* p, size_t n, unsigned char value)
+{
+  const uint64_t pattern = 0x0101010101010101ULL * value;
+  size_t end = n;
+  for (; end >= 8; end -= 8)
+  {
+    uint64_t word;
+    memcpy(&word, p + end - 8, 8);
+    if (word != pattern)
+    {
+      break;
+    }
+  }
+  while (end > 0 && p[end - 1] == value)
+  {
+    --end;
+  }
+  return end == 0 ? n : end - 1;
+}
+
 DibChunk::~DibChunk()
 {
 }
@@ -77,16 +126,6 @@ DibChunkerImpl::~DibChunkerImpl()
       delete[] colors;
       colors = nullptr;
     }
-    if (scanLine != nullptr)
-    {
-      delete[] scanLine;
-      scanLine = nullptr;
-    }
-    if (bits != nullptr)
-    {
-      delete[] bits;
-      bits = nullptr;
-    }
     if (trace_dib != nullptr)
     {
       trace_dib->Close();
@@ -202,9 +241,54 @@ void DibChunkerImpl::ReadBitmapInfo()
     Read(p, n);
   }
   MIKTEX_ASSERT(bitmapFileHeader.bfOffBits == numBytesRead);
+  MakeByteClasses();
   trace_dib->WriteLine("libdib", fmt::format(T_("chunking bitmap %{0}x{1}, {2} colors"), bitmapInfoHeader.biWidth, bitmapInfoHeader.biHeight, numColors));
 }
 
+void DibChunkerImpl::MakeByteClasses()
+{
+  // classify the bytes of 4-bit and 8-bit scan lines, so that the
+  // color table need not be consulted for each pixel
+  auto classOf = [this](unsigned long idx) {
+    if (idx >= numColors)
+    {
+      return ByteClass::Other;
+    }
+    COLORREF clr = GetColor(idx);
+    return clr == RGB_WHITE ? ByteClass::White : clr == RGB_BLACK ? ByteClass::Black : ByteClass::Other;
+  };
+  whiteByte = -1;
+  int numWhiteBytes = 0;
+  for (unsigned byte = 0; byte < 256; ++byte)
+  {
+    ByteClass byteClass;
+    if (bitmapInfoHeader.biBitCount == 4)
+    {
+      ByteClass high = classOf((byte >> 4) & 15);
+      ByteClass low = classOf(byte & 15);
+      byteClass = high == low ? high : ByteClass::Other;
+    }
+    else if (bitmapInfoHeader.biBitCount == 8)
+    {
+      byteClass = classOf(byte);
+    }
+    else
+    {
+      byteClass = ByteClass::Other;
+    }
+    byteClasses[byte] = byteClass;
+    if (byteClass == ByteClass::White)
+    {
+      whiteByte = byte;
+      numWhiteBytes += 1;
+    }
+  }
+  if (numWhiteBytes != 1)
+  {
+    whiteByte = -1;
+  }
+}
+
 bool DibChunkerImpl::Crop1(unsigned long& left, unsigned long& right)
 {
   left = UINT_MAX;
@@ -229,82 +313,61 @@ bool DibChunkerImpl::Crop1(unsigned long& left, unsigned long& right)
   unsigned long n = (bitmapInfoHeader.biWidth + 7) / 8;
 
   // crop
-  for (unsigned long idx = 0; idx < n; idx += 1)
+  size_t first = FindFirstNot(scanLine, n, white);
+  if (first < n)
   {
-    if (scanLine[idx] != white)
-    {
-      if (idx < left)
-      {
-        left = idx;
-      }
-      right = idx;
-    }
+    left = static_cast<unsigned long>(first);
+    right = static_cast<unsigned long>(FindLastNot(scanLine, n, white));
   }
 
   return true;
 }
 
-bool DibChunkerImpl::Crop4(unsigned long& left, unsigned long& right)
+bool DibChunkerImpl::CropIndexed(unsigned long& left, unsigned long& right)
 {
   left = UINT_MAX;
   right = UINT_MAX;
 
   // number of bytes to check
-  unsigned long n = (bitmapInfoHeader.biWidth + 1) / 2;
-
-  bool isBlackAndWhite = true;
+  unsigned long n = bitmapInfoHeader.biBitCount == 4 ? (bitmapInfoHeader.biWidth + 1) / 2 : bitmapInfoHeader.biWidth;
 
   // crop
-  for (unsigned long idx = 0; idx < n; idx += 1)
+  size_t first;
+  size_t last;
+  if (whiteByte >= 0)
   {
-    unsigned char byte = scanLine[idx];
-    unsigned high = (byte >> 4) & 15;
-    unsigned low = byte & 15;
-    if (!(GetColor(high) == RGB_WHITE && GetColor(low) == RGB_WHITE))
+    first = FindFirstNot(scanLine, n, static_cast<unsigned char>(whiteByte));
+    if (first == n)
     {
-      if (idx < left)
-      {
-        left = idx;
-      }
-      right = idx;
-      if (!(GetColor(high) == RGB_BLACK && GetColor(low) == RGB_BLACK))
-      {
-        isBlackAndWhite = false;
-      }
+      return true;
     }
+    last = FindLastNot(scanLine, n, static_cast<unsigned char>(whiteByte));
   }
+  else
+  {
+    for (first = 0; first < n && byteClasses[scanLine[first]] == ByteClass::White; ++first)
+    {
+    }
+    if (first == n)
+    {
+      return true;
+    }
+    for (last = n - 1; byteClasses[scanLine[last]] == ByteClass::White; --last)
+    {
+    }
+  }
+  left = static_cast<unsigned long>(first);
+  right = static_cast<unsigned long>(last);
 
-  return isBlackAndWhite;
-}
-
-bool DibChunkerImpl::Crop8(unsigned long& left, unsigned long& right)
-{
-  left = UINT_MAX;
-  right = UINT_MAX;
-
-  // number of bytes to check
-  unsigned long n = bitmapInfoHeader.biWidth;
-
-  bool isBlackAndWhite = true;
-
-  // crop
-  for (unsigned long idx = 0; idx < n; idx += 1)
+  for (size_t idx = first; idx <= last; ++idx)
   {
-    if (GetColor(scanLine[idx]) != RGB_WHITE)
+    if (byteClasses[scanLine[idx]] == ByteClass::Other)
     {
-      if (idx < left)
-      {
-        left = idx;
-      }
-      right = idx;
-      if (GetColor(scanLine[idx]) != RGB_BLACK)
-      {
-        isBlackAndWhite = false;
-      }
+      return false;
     }
   }
 
-  return isBlackAndWhite;
+  return true;
 }
 
 bool DibChunkerImpl::Crop24(unsigned long& left, unsigned long& right)
@@ -315,37 +378,34 @@ bool DibChunkerImpl::Crop24(unsigned long& left, unsigned long& right)
   // number of bytes to check
   unsigned long n = bitmapInfoHeader.biWidth * 3;
 
-  bool isBlackAndWhite = true;
-
   // crop
-  for (unsigned long idx = 0; idx < n; idx += 3)
+  size_t first = FindFirstNot(scanLine, n, 255);
+  if (first == n)
+  {
+    return true;
+  }
+  size_t last = FindLastNot(scanLine, n, 255);
+  left = static_cast<unsigned long>(first - first % 3);
+  right = static_cast<unsigned long>(last - last % 3 + 2);
+
+  for (unsigned long idx = left; idx < right; idx += 3)
   {
     COLORREF clr = RGB(scanLine[idx + 2], scanLine[idx + 1], scanLine[idx]);
-    if (clr != RGB_WHITE)
+    if (clr != RGB_WHITE && clr != RGB_BLACK)
     {
-      if (idx < left)
-      {
-        left = idx;
-      }
-      right = idx + 2;
-      if (clr != RGB_BLACK)
-      {
-        isBlackAndWhite = false;
-      }
+      return false;
     }
   }
 
-  return isBlackAndWhite;
+  return true;
 }
 
 bool DibChunkerImpl::ReadScanLine(unsigned long& left, unsigned long& right)
 {
   unsigned long n = BytesPerLine();
 
-  if (scanLine == nullptr)
-  {
-    scanLine = new unsigned char[n];
-  }
+  // the scan line is read into its place in the current chunk
+  scanLine = bits.get() + numScanLines * n;
 
   Read(scanLine, n);
 
@@ -361,10 +421,8 @@ bool DibChunkerImpl::ReadScanLine(unsigned long& left, unsigned long& right)
       Crop1(left, right);
       break;
     case 4:
-      isBlackAndWhite = Crop4(left, right);
-      break;
     case 8:
-      isBlackAndWhite = Crop8(left, right);
+      isBlackAndWhite = CropIndexed(left, right);
       break;
     case 24:
       isBlackAndWhite = Crop24(left, right);
@@ -387,7 +445,7 @@ bool DibChunkerImpl::ReadScanLine(unsigned long& left, unsigned long& right)
       right = (bitmapInfoHeader.biWidth + 1) / 2 - 1;
       break;
     case 8:
-      right = bitmapInfoHeader.biWidth;
+      right = bitmapInfoHeader.biWidth - 1;
       break;
     case 24:
       right = bitmapInfoHeader.biWidth * 3 - 1;
@@ -402,8 +460,7 @@ bool DibChunkerImpl::ReadScanLine(unsigned long& left, unsigned long& right)
 
 void DibChunkerImpl::AddScanLine()
 {
-  unsigned long n = BytesPerLine();
-  memcpy(&bits[n * numScanLines], scanLine, n);
+  MIKTEX_ASSERT(scanLine == bits.get() + numScanLines * BytesPerLine());
   numScanLines += 1;
 }
 
@@ -420,9 +477,23 @@ void DibChunkerImpl::BeginChunk()
 
 void DibChunkerImpl::Monochromize24(const unsigned char* src, unsigned char* dst, unsigned long width)
 {
+  // dst may be equal to src: a destination byte is written after the
+  // source pixels it is made of have been read
   unsigned char byte = 0;
-  unsigned long idx;
-  for (idx = 0; idx < width; ++idx)
+  unsigned long idx = 0;
+  // eight white pixels (24 bytes) make a white byte
+  const uint64_t allWhite = ~static_cast<uint64_t>(0);
+  for (; idx + 8 <= width; idx += 8)
+  {
+    uint64_t words[3];
+    memcpy(words, src + idx * 3, sizeof(words));
+    if ((words[0] & words[1] & words[2]) != allWhite)
+    {
+      break;
+    }
+    *dst++ = 0;
+  }
+  for (; idx < width; ++idx)
   {
     unsigned n = (idx % 8);
     COLORREF clr = RGB(src[idx * 3 + 2], src[idx * 3 + 1], src[idx * 3 + 0]);
@@ -490,7 +561,46 @@ void DibChunkerImpl::EndChunk()
     MIKTEX_UNEXPECTED();
   }
 
-  shared_ptr<DibChunkImpl> chunk = make_shared<DibChunkImpl>(bytesPerLine, numScanLines);
+  // make the chunk bits in place: the lines get shorter, so that a
+  // line is never overwritten before it has been read
+  unsigned long srcBytesPerLine = BytesPerLine();
+  MIKTEX_ASSERT(bytesPerLine <= srcBytesPerLine);
+  unsigned char* bits = this->bits.get();
+  for (unsigned long i = 0; i < numScanLines; ++i)
+  {
+    const unsigned char* src = bits + i * srcBytesPerLine + leftPos;
+    unsigned char* dest = bits + i * bytesPerLine;
+    unsigned long n;
+    if (monochromize24)
+    {
+      Monochromize24(src, dest, biWidth);
+      n = (biWidth + 7) / 8;
+    }
+    else
+    {
+      if (dest != src)
+      {
+        memmove(dest, src, bytesInChunk);
+      }
+      n = bytesInChunk;
+    }
+    memset(dest + n, 0, bytesPerLine - n);
+  }
+
+  // hand over the chunk buffer, unless it is mostly unused
+  size_t size = static_cast<size_t>(bytesPerLine) * numScanLines;
+  shared_ptr<DibChunkImpl> chunk;
+  if (size * 2 >= bitsCapacity)
+  {
+    chunk = make_shared<DibChunkImpl>(this->bits, bitsCapacity);
+    this->bits = shared_ptr<unsigned char[]>(new unsigned char[bitsCapacity]);
+  }
+  else
+  {
+    shared_ptr<unsigned char[]> chunkBits(new unsigned char[size]);
+    memcpy(chunkBits.get(), bits, size);
+    chunk = make_shared<DibChunkImpl>(chunkBits, size);
+  }
 
   chunk->SetX(x);
 
@@ -518,24 +628,9 @@ void DibChunkerImpl::EndChunk()
   y += bitmapinfoheader.biHeight - 1;
   y = this->bitmapInfoHeader.biHeight - y;
   chunk->SetY(y);
-  //
-  unsigned char* bits = reinterpret_cast<unsigned char*>(chunk->GetBits2());
-  for (unsigned long i = 0; i < numScanLines; ++i)
-  {
-    const unsigned char* src = this->bits + i * BytesPerLine() + leftPos;
-    unsigned char* dest = bits + i * bytesPerLine;
-    memset(dest, 0, bytesPerLine);
-    if (monochromize24)
-    {
-      Monochromize24(src, dest, biWidth);
-    }
-    else
-    {
-      memcpy(dest, src, bytesInChunk);
-    }
-  }
   trace_dib->WriteLine("libdib", fmt::format(T_("shipping chunk: x={0}, y={1}, w={2}, h={3}, monochromized=%s"), chunk->GetX(), chunk->GetY(), bitmapinfoheader.biWidth, bitmapinfoheader.biHeight, (monochromize24 ? "true" : "false")));
   inChunk = false;
+  numScanLines = 0;
   chunk->SetBitmapInfo(bitmapinfoheader, numColors, colors);
   callback->OnNewChunk(chunk);
 }
@@ -554,10 +649,14 @@ bool DibChunkerImpl::Process(unsigned long flags, unsigned long chunkSize, IDibC
   {
     MIKTEX_UNEXPECTED();
   }
-  bits = new unsigned char[chunkSize];
+  // one line more than a chunk can take: the line which does not fit
+  // anymore is read before the chunk is shipped
+  bitsCapacity = chunkSize + BytesPerLine();
+  bits = shared_ptr<unsigned char[]>(new unsigned char[bitsCapacity]);
   try
   {
     inChunk = false;
+    numScanLines = 0;
     blankLines = 0;
     for (yPos = 0; yPos < bitmapInfoHeader.biHeight; yPos += 1)
     {
@@ -594,8 +693,12 @@ bool DibChunkerImpl::Process(unsigned long flags, unsigned long chunkSize, IDibC
         {
           MIKTEX_UNEXPECTED();
         }
+        // keep the buffer alive: the scan line may live in it
+        shared_ptr<unsigned char[]> oldBits = bits;
         EndChunk();
         BeginChunk();
+        memmove(bits.get(), scanLine, BytesPerLine());
+        scanLine = bits.get();
       }
       AddScanLine();
       if (left < this->leftPos)
@@ -611,14 +714,14 @@ bool DibChunkerImpl::Process(unsigned long flags, unsigned long chunkSize, IDibC
     {
       EndChunk();
     }
-    delete[] bits;
     bits = nullptr;
+    scanLine = nullptr;
     return true;
   }
   catch (const exception &)
   {
-    delete[] bits;
     bits = nullptr;
+    scanLine = nullptr;
     throw;
   }
 }
@@ -1,6 +1,6 @@
 /* internal.h:                                          -*- C++ -*-
 
-   Copyright (C) 2002-2018 Christian Schenk
+   Copyright (C) 2002-2023 Christian Schenk
 
    This file is part of the MiKTeX DibChunker Library.
 
@@ -36,14 +36,10 @@ class DibChunkImpl :
   public MiKTeX::Graphics::DibChunk
 {
 public:
-  DibChunkImpl(unsigned bytesPerLine, unsigned numScanLines) :
-    size(bytesPerLine * numScanLines)
+  DibChunkImpl(std::shared_ptr<unsigned char[]> bits, size_t size) :
+    bits(bits),
+    size(size)
   {
-    bits = malloc(size);
-    if (bits == nullptr)
-    {
-      OUT_OF_MEMORY("malloc");
-    }
   }
 
 public:
@@ -54,11 +50,6 @@ public:
       free(bitmapInfo);
       bitmapInfo = nullptr;
     }
-    if (bits != nullptr)
-    {
-      free(bits);
-      bits = nullptr;
-    }
   }
 
 public:
@@ -88,7 +79,7 @@ public:
 public:
   const void* MIKTEXTHISCALL GetBits() const override
   {
-    return bits;
+    return bits.get();
   }
 
 public:
@@ -135,12 +126,6 @@ public:
     }
   }
 
-public:
-  void* GetBits2()
-  {
-    return bits;
-  }
-
 private:
   int x;
 
@@ -151,7 +136,7 @@ private:
   BITMAPINFO* bitmapInfo = nullptr;
 
 private:
-  void* bits;
+  std::shared_ptr<unsigned char[]> bits;
 
 private:
   size_t size;
@@ -220,10 +205,7 @@ private:
   bool Crop1(unsigned long& left, unsigned long& right);
 
 private:
-  bool Crop4(unsigned long& left, unsigned long& right);
-
-private:
-  bool Crop8(unsigned long& left, unsigned long& right);
+  bool CropIndexed(unsigned long& left, unsigned long& right);
 
 private:
   bool Crop24(unsigned long& left, unsigned long& right);
@@ -240,11 +222,26 @@ private:
 private:
   size_t numBytesRead;
 
+private:
+  void MakeByteClasses();
+
+private:
+  enum class ByteClass : unsigned char { White, Black, Other };
+
+private:
+  ByteClass byteClasses[256];
+
+private:
+  int whiteByte;
+
 private:
   unsigned char* scanLine = nullptr;
 
 private:
-  unsigned char* bits = nullptr;
+  std::shared_ptr<unsigned char[]> bits;
+
+private:
+  size_t bitsCapacity;
 
 private:
   unsigned numScanLines;
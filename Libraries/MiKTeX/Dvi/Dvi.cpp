@@ -69,6 +69,9 @@ int DviImpl::RulePixels(int x)
   }
 }
 
+// the maximum number of page loader threads
+const unsigned maxPageLoaders = 4;
+
 DviImpl::DviImpl(const char* fileName, const char* metafontMode, int resolution, int shrinkFactor, DviAccess dviAccess, DviPageMode pageMode, const PaperSizeInfo & paperSizeInfo, bool landscape, IDviCallback* dviCallback, TraceCallback* traceCallback) :
   currentColor(rgbDefaultColor),
   dviAccess(dviAccess),
@@ -101,12 +104,8 @@ DviImpl::DviImpl(const char* fileName, const char* metafontMode, int resolution,
   {
     MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
   }
-  hNewPageEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
-  if (hNewPageEvent == nullptr)
-  {
-    MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
-  }
-  hScannedEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+  // manual-reset: it releases all page loader threads
+  hScannedEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
   if (hScannedEvent == nullptr)
   {
     MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
@@ -114,7 +113,18 @@ DviImpl::DviImpl(const char* fileName, const char* metafontMode, int resolution,
   if (dviAccess == DviAccess::Random)
   {
     garbageCollectorThread = thread(&DviImpl::GarbageCollector, this);
-    pageLoaderThread = thread(&DviImpl::PageLoader, this);
+    // in Dvips mode, each page loader gets its Ghostscript process from
+    // the GhostscriptPool
+    unsigned numberOfPageLoaders = 1;
+    unsigned numberOfCores = thread::hardware_concurrency();
+    if (numberOfCores > 2)
+    {
+      numberOfPageLoaders = std::min(maxPageLoaders, numberOfCores - 1);
+    }
+    for (unsigned i = 0; i < numberOfPageLoaders; ++i)
+    {
+      pageLoaderThreads.push_back(thread(&DviImpl::PageLoader, this));
+    }
   }
 }
 
@@ -142,10 +152,14 @@ void DviImpl::Dispose()
   {
     garbageCollectorThread.join();
   }
-  if (pageLoaderThread.joinable())
+  for (thread& pageLoaderThread : pageLoaderThreads)
   {
-    pageLoaderThread.join();
+    if (pageLoaderThread.joinable())
+    {
+      pageLoaderThread.join();
+    }
   }
+  pageLoaderThreads.clear();
   BEGIN_CRITICAL_SECTION(dviMutex)
   {
     FreeContents();
@@ -159,11 +173,6 @@ void DviImpl::Dispose()
       CloseHandle(hByeByeEvent);
       hByeByeEvent = nullptr;
     }
-    if (hNewPageEvent != nullptr)
-    {
-      CloseHandle(hNewPageEvent);
-      hNewPageEvent = nullptr;
-    }
     if (hScannedEvent != nullptr)
     {
       CloseHandle(hScannedEvent);
@@ -225,6 +234,7 @@ void DviImpl::FreeContents(bool keepFonts)
     it->second = nullptr;
   }
   fontMap->clear();
+  fontDefinitions.clear();
   tempFiles.clear();
 }
 
@@ -368,10 +378,69 @@ const int dvi_id = 2;
 
 void DviImpl::Scan()
 {
-  InputStream inputStream(dviFileName.GetData());
+  // keep the loaded pages of the previous scan: unchanged pages are reused
+  PageDigestMap previousPages;
+  for (DviPageImpl* dviPage : pages)
+  {
+    if (pageMode != DviPageMode::Dvips && dviPage->IsFrozen() && !dviPage->incomplete)
+    {
+      previousPages.insert(PageDigestMap::value_type(dviPage->digest, dviPage));
+    }
+    else
+    {
+      delete dviPage;
+    }
+  }
+  pages.clear();
+  try
+  {
+    Scan(previousPages);
+  }
+  catch (const exception&)
+  {
+    DeletePages(previousPages);
+    throw;
+  }
+  if (!previousPages.empty())
+  {
+    trace_dvifile->WriteLine("libdvi", fmt::format(T_("discarding {0} changed pages"), previousPages.size()));
+  }
+  DeletePages(previousPages);
+}
 
-  // reset this object
-  FreeContents(false);
+void DviImpl::DeletePages(PageDigestMap& pageMap)
+{
+  for (PageDigestMap::iterator it = pageMap.begin(); it != pageMap.end(); ++it)
+  {
+    delete it->second;
+  }
+  pageMap.clear();
+}
+
+MD5 DviImpl::GetPageDigest(InputStream& inputStream, long bopPosition, long endPosition)
+{
+  MD5Builder md5Builder;
+  char buffer[4096];
+  // the counts, but not the pointer to the previous page: it changes
+  // with the length of the preceding pages
+  inputStream.SetReadPosition(bopPosition + 1, SeekOrigin::Begin);
+  inputStream.Read(buffer, 40);
+  md5Builder.Update(buffer, 40);
+  long position = bopPosition + 45;
+  inputStream.SetReadPosition(position, SeekOrigin::Begin);
+  while (position < endPosition)
+  {
+    size_t n = std::min(sizeof(buffer), static_cast<size_t>(endPosition - position));
+    inputStream.Read(buffer, n);
+    md5Builder.Update(buffer, n);
+    position += static_cast<long>(n);
+  }
+  return md5Builder.Final();
+}
+
+void DviImpl::Scan(PageDigestMap& previousPages)
+{
+  InputStream inputStream(dviFileName.GetData());
 
   trace_dvifile->WriteLine("libdvi", fmt::format(T_("going to scan {0}"), Q_(dviFileName)));
 
@@ -384,6 +453,10 @@ void DviImpl::Scan()
     FATAL_DVI_ERROR_2(T_("Not a DVI file."), "fileName", dviFileName.ToString());
   }
 
+  int previousNumerator = numerator;
+  int previousDenominator = denominator;
+  int previousMag = mag;
+
   // compute the conversion factor
   numerator = inputStream.ReadSignedQuad();
   denominator = inputStream.ReadSignedQuad();
@@ -399,6 +472,14 @@ void DviImpl::Scan()
   mag = inputStream.ReadSignedQuad();
   trace_dvifile->WriteLine("libdvi", fmt::format("mag: {0}", mag));
 
+  // the fonts (and the pages) of the previous scan can only be kept, if
+  // the conversion factors are the same
+  if (numerator != previousNumerator || denominator != previousDenominator || mag != previousMag)
+  {
+    DeletePages(previousPages);
+    FreeContents(false);
+  }
+
   tfmConv = (((25400000.0 / numerator) * (denominator / 473628672)) / 16.0);
 
   conv = ((static_cast<double>(numerator) * static_cast<double>(mag) * static_cast<double>(resolution)) / (static_cast<double>(denominator) * 254000000.0));
@@ -414,33 +495,95 @@ void DviImpl::Scan()
 
   trace_dvifile->WriteLine("libdvi", fmt::format("comment: {0}", dviInfo.comment));
 
-  // find the postamble, working back from the end
-  int k;
+  long firstPagePosition = inputStream.GetReadPosition();
+
   inputStream.SetReadPosition(0, SeekOrigin::End);
-  int filelength = inputStream.GetReadPosition();
-  int m = filelength - 1;
+  long fileLength = inputStream.GetReadPosition();
+  followedFileSize = fileLength;
+
+  minPageNumber = INT_MAX;
+  maxPageNumber = INT_MIN;
+
+  long postamblePosition = FindPostamble(inputStream, firstPagePosition, fileLength);
+
+  // without a postamble, TeX is still writing the DVI file: follow it
+  following = postamblePosition < 0;
+
+  bool scanned;
+  if (following)
+  {
+    trace_dvifile->WriteLine("libdvi", T_("no postamble; scanning the complete pages"));
+    scanned = ScanForward(inputStream, firstPagePosition, fileLength, previousPages);
+  }
+  else
+  {
+    scanned = ScanBackward(inputStream, postamblePosition, previousPages);
+  }
+
+  if (!scanned)
+  {
+    // a font number has been redefined: start from scratch
+    trace_dvifile->WriteLine("libdvi", T_("font definitions have changed"));
+    DeletePages(previousPages);
+    FreeContents(false);
+    Scan(previousPages);
+    return;
+  }
+
+  lastChecked = clock();
+
+#if 0
+  // load the first DVI page
+  if (pages.size() > 0)
+  {
+    DviPage* dviPage = GetLoadedPage(0);
+    dviPage->Unlock();
+  }
+#endif
+
+  // wake up page loader thread
+  SetEvent(hScannedEvent);
+
+  hasDviFileChanged = false;
+}
+
+long DviImpl::FindPostamble(InputStream& inputStream, long firstPagePosition, long fileLength)
+{
+  // work back from the end
+  int k;
+  long m = fileLength - 1;
   do
   {
+    if (m < firstPagePosition)
+    {
+      return -1;
+    }
     inputStream.SetReadPosition(m, SeekOrigin::Begin);
     k = inputStream.ReadByte();
     --m;
   } while (k == 223);
-  if (k != dvi_id)
+  if (k != dvi_id || m - 3 < firstPagePosition)
   {
-    FATAL_DVI_ERROR_2(T_("Invalid DVI file."), "fileName", dviFileName.ToString());
+    return -1;
   }
   inputStream.SetReadPosition(m - 3, SeekOrigin::Begin);
-  int q = inputStream.ReadSignedQuad();
-  if (q < 0 || q > m - 33)
+  long q = inputStream.ReadSignedQuad();
+  if (q < firstPagePosition || q > m - 33)
   {
-    FATAL_DVI_ERROR_2(T_("Invalid DVI file."), "fileName", dviFileName.ToString());
+    return -1;
   }
   inputStream.SetReadPosition(q, SeekOrigin::Begin);
   k = inputStream.ReadByte();
   if (k != post)
   {
-    FATAL_DVI_ERROR_2(T_("Invalid DVI file."), "fileName", dviFileName.ToString());
+    return -1;
   }
+  return q;
+}
+
+bool DviImpl::ScanBackward(InputStream& inputStream, long postamblePosition, PageDigestMap& previousPages)
+{
+  inputStream.SetReadPosition(postamblePosition + 1, SeekOrigin::Begin);
 
   // process the postamble
   int firstbackpointer =        // pointer to last page
@@ -458,13 +601,17 @@ void DviImpl::Scan()
   trace_dvifile->WriteLine("libdvi", fmt::format("dviInfo.nPages: {0}", dviInfo.nPages));
 
   // process the font definitions of the postamble
+  int k;
   do
   {
     k = inputStream.ReadByte();
     if (k >= fnt_def1 && k < fnt_def1 + 4)
     {
       int p = FirstParam(inputStream, k);
-      DefineFont(inputStream, p);
+      if (!DefineFont(inputStream, p))
+      {
+        return false;
+      }
       k = nop;
     }
   } while (k == nop);
@@ -476,57 +623,225 @@ void DviImpl::Scan()
 
   // build the page table
   int backpointer = firstbackpointer;
-  minPageNumber = INT_MAX;
-  maxPageNumber = INT_MIN;
+  long endOfPage = postamblePosition;
   pages.reserve(dviInfo.nPages);
   while (backpointer >= 0 && (dviInfo.nPages-- > 0))
   {
+    long bopPosition = backpointer;
     inputStream.SetReadPosition(backpointer, SeekOrigin::Begin);
     if (inputStream.ReadByte() != bop)
     {
       FATAL_DVI_ERROR_2(T_("Invalid DVI file."), "fileName", dviFileName.ToString());
     }
-    int count0 = inputStream.ReadSignedQuad();
-    if (count0 < minPageNumber)
+    int counts[10];
+    for (int& count : counts)
     {
-      minPageNumber = count0;
+      count = inputStream.ReadSignedQuad();
     }
-    if (count0 > maxPageNumber)
-    {
-      maxPageNumber = count0;
-    }
-    int count1 = inputStream.ReadSignedQuad();
-    int count2 = inputStream.ReadSignedQuad();
-    int count3 = inputStream.ReadSignedQuad();
-    int count4 = inputStream.ReadSignedQuad();
-    int count5 = inputStream.ReadSignedQuad();
-    int count6 = inputStream.ReadSignedQuad();
-    int count7 = inputStream.ReadSignedQuad();
-    int count8 = inputStream.ReadSignedQuad();
-    int count9 = inputStream.ReadSignedQuad();
     backpointer = inputStream.ReadSignedQuad();
-    DviPageImpl* dviPage = new DviPageImpl(this, dviInfo.nPages, pageMode, inputStream.GetReadPosition(), count0, count1, count2, count3, count4, count5, count6, count7, count8, count9);
-    pages.push_back(dviPage);
+    pages.push_back(MakePage(inputStream, dviInfo.nPages, bopPosition, endOfPage, counts, previousPages));
+    endOfPage = bopPosition;
   }
   reverse(pages.begin(), pages.end());
-  lastChecked = clock();
 
-#if 0
-  // load the first DVI page
-  if (pages.size() > 0)
+  return true;
+}
+
+bool DviImpl::ScanForward(InputStream& inputStream, long firstPagePosition, long fileLength, PageDigestMap& previousPages)
+{
+  // the postamble is not there yet
+  maxV = 0;
+  maxH = 0;
+
+  long position = firstPagePosition;
+  while (position < fileLength)
   {
-    DviPage* dviPage = GetLoadedPage(0);
-    dviPage->Unlock();
+    inputStream.SetReadPosition(position, SeekOrigin::Begin);
+    int k = inputStream.ReadByte();
+    if (k == nop)
+    {
+      position += 1;
+      continue;
+    }
+    if (k != bop || position + 45 > fileLength)
+    {
+      // the postamble is being written, or the page is not complete
+      break;
+    }
+    int counts[10];
+    for (int& count : counts)
+    {
+      count = inputStream.ReadSignedQuad();
+    }
+    inputStream.ReadSignedQuad(); // pointer to previous page
+    vector<long> fontDefinitions;
+    long endOfPage = FindEndOfPage(inputStream, fileLength, fontDefinitions);
+    if (endOfPage < 0)
+    {
+      // TeX has not written the page completely
+      break;
+    }
+    // the font definitions of the postamble are not there yet; TeX
+    // defines every font on the page it is used first
+    for (long fontDefinitionPosition : fontDefinitions)
+    {
+      inputStream.SetReadPosition(fontDefinitionPosition, SeekOrigin::Begin);
+      k = inputStream.ReadByte();
+      int p = FirstParam(inputStream, k);
+      if (!DefineFont(inputStream, p))
+      {
+        return false;
+      }
+    }
+    pages.push_back(MakePage(inputStream, static_cast<int>(pages.size()), position, endOfPage, counts, previousPages));
+    position = endOfPage;
   }
-#endif
 
-  // wake up page loader thread
-  SetEvent(hScannedEvent);
+  dviInfo.nPages = static_cast<long>(pages.size());
+  trace_dvifile->WriteLine("libdvi", fmt::format("dviInfo.nPages: {0}", dviInfo.nPages));
 
-  hasDviFileChanged = false;
+  return true;
 }
 
-void DviImpl::DefineFont(InputStream & inputStream, int fontNum)
+long DviImpl::FindEndOfPage(InputStream& inputStream, long fileLength, vector<long>& fontDefinitions)
+{
+  long position = inputStream.GetReadPosition();
+  auto skip = [&inputStream, &position, fileLength](long n)
+  {
+    if (n < 0 || position + n > fileLength)
+    {
+      return false;
+    }
+    position += n;
+    inputStream.SetReadPosition(position, SeekOrigin::Begin);
+    return true;
+  };
+  auto readParam = [&inputStream, &position, fileLength](int n, long& value)
+  {
+    if (position + n > fileLength)
+    {
+      return false;
+    }
+    value = 0;
+    for (int i = 0; i < n; ++i)
+    {
+      value = (value << 8) | inputStream.ReadByte();
+    }
+    position += n;
+    return true;
+  };
+  while (position < fileLength)
+  {
+    long opCodePosition = position;
+    int opCode = inputStream.ReadByte();
+    position += 1;
+    long len;
+    switch (opCode)
+    {
+    case eop:
+      return position;
+    case FOUR_CASES(set1):
+      len = opCode - set1 + 1;
+      break;
+    case set_rule:
+    case put_rule:
+      len = 8;
+      break;
+    case FOUR_CASES(put1):
+      len = opCode - put1 + 1;
+      break;
+    case nop: case p_ush: case p_op: case w0: case x0: case y_0: case z0:
+      len = 0;
+      break;
+    case FOUR_CASES(right1):
+      len = opCode - right1 + 1;
+      break;
+    case FOUR_CASES(w1):
+      len = opCode - w1 + 1;
+      break;
+    case FOUR_CASES(x1):
+      len = opCode - x1 + 1;
+      break;
+    case FOUR_CASES(down1):
+      len = opCode - down1 + 1;
+      break;
+    case FOUR_CASES(y_1):
+      len = opCode - y_1 + 1;
+      break;
+    case FOUR_CASES(z1):
+      len = opCode - z1 + 1;
+      break;
+    case FOUR_CASES(fnt1):
+      len = opCode - fnt1 + 1;
+      break;
+    case FOUR_CASES(xxx1):
+      if (!readParam(opCode - xxx1 + 1, len))
+      {
+        return -1;
+      }
+      break;
+    case FOUR_CASES(fnt_def1):
+    {
+      long nameLength;
+      long areaNameLength;
+      if (!skip(opCode - fnt_def1 + 1 + 12) || !readParam(1, areaNameLength) || !readParam(1, nameLength))
+      {
+        return -1;
+      }
+      fontDefinitions.push_back(opCodePosition);
+      len = areaNameLength + nameLength;
+      break;
+    }
+    case bop:
+    case pre:
+    case post:
+    case post_post:
+    case undefined_commands:
+      FATAL_DVI_ERROR_2(T_("Invalid DVI file."), "fileName", dviFileName.ToString());
+    default:
+      // set_char_0..set_char_127, fnt_num_0..fnt_num_63
+      len = 0;
+      break;
+    }
+    if (!skip(len))
+    {
+      return -1;
+    }
+  }
+  return -1;
+}
+
+DviPageImpl* DviImpl::MakePage(InputStream& inputStream, int pageIdx, long bopPosition, long endPosition, const int counts[10], PageDigestMap& previousPages)
+{
+  if (counts[0] < minPageNumber)
+  {
+    minPageNumber = counts[0];
+  }
+  if (counts[0] > maxPageNumber)
+  {
+    maxPageNumber = counts[0];
+  }
+  long readPosition = bopPosition + 45;
+  MD5 pageDigest;
+  if (pageMode != DviPageMode::Dvips)
+  {
+    pageDigest = GetPageDigest(inputStream, bopPosition, endPosition);
+  }
+  PageDigestMap::iterator it = previousPages.find(pageDigest);
+  if (it != previousPages.end())
+  {
+    // unchanged page: keep its contents and rasters
+    DviPageImpl* dviPage = it->second;
+    previousPages.erase(it);
+    dviPage->Relocate(pageIdx, readPosition);
+    return dviPage;
+  }
+  DviPageImpl* dviPage = new DviPageImpl(this, pageIdx, pageMode, readPosition, counts[0], counts[1], counts[2], counts[3], counts[4], counts[5], counts[6], counts[7], counts[8], counts[9]);
+  dviPage->digest = pageDigest;
+  return dviPage;
+}
+
+bool DviImpl::DefineFont(InputStream & inputStream, int fontNum)
 {
   trace_dvifile->WriteLine("libdvi", fmt::format(T_("going to define font {0}"), fontNum));
 
@@ -547,6 +862,14 @@ void DviImpl::DefineFont(InputStream & inputStream, int fontNum)
   inputStream.Read(fontName, fontNameLen);
   fontName[fontNameLen] = 0;
 
+  // the font might have been defined by a previous scan (or by a page)
+  string definition = fmt::format("{0}/{1}/{2}/{3}/{4}", checkSum, scaledSize, designSize, areaName, fontName);
+  FontDefinitionMap::const_iterator it = fontDefinitions.find(fontNum);
+  if (it != fontDefinitions.end())
+  {
+    return it->second == definition;
+  }
+
   trace_dvifile->WriteLine("libdvi", fmt::format("areaName: {0}", areaName));
   trace_dvifile->WriteLine("libdvi", fmt::format("fontname: {0}", fontName));
   trace_dvifile->WriteLine("libdvi", fmt::format("checkSum: {0:o}", checkSum));
@@ -572,6 +895,9 @@ void DviImpl::DefineFont(InputStream & inputStream, int fontNum)
   }
 
   (*fontMap)[fontNum] = dviFont;
+  fontDefinitions[fontNum] = definition;
+
+  return true;
 }
 
 PageStatus DviImpl::GetPageStatus(int pageIdx)
@@ -613,6 +939,18 @@ PageStatus DviImpl::GetPageStatus(int pageIdx)
 
     lastChecked = now;
 
+    if (following)
+    {
+      // TeX is still writing the DVI file: rescan, when new pages have
+      // been appended
+      if (File::Exists(dviFileName) && File::GetSize(dviFileName) != followedFileSize)
+      {
+        hasDviFileChanged = true;
+        return PageStatus::Changed;
+      }
+      return PageStatus::Loaded;
+    }
+
     if (session->IsFileAlreadyOpen(dviFileName))
     {
       return PageStatus::Loaded;
@@ -655,7 +993,7 @@ void DviImpl::DoPage(int pageIdx)
 
   Progress(DviNotification::BeginLoadPage, fmt::format(T_("loading page #{0}..."), pageIdx));
 
-  bool background = pageLoaderThread.joinable() && this_thread::get_id() == pageLoaderThread.get_id();
+  bool background = IsPageLoaderThread();
 
   if (background)
   {
@@ -668,7 +1006,8 @@ void DviImpl::DoPage(int pageIdx)
 
   try
   {
-    if (session->IsFileAlreadyOpen(dviFileName))
+    // the complete pages of a followed DVI file do not change anymore
+    if (!following && session->IsFileAlreadyOpen(dviFileName))
     {
       trace_error->WriteLine("libdvi", T_("the DVI file is used by another process"));
       throw DviFileInUseException("", T_("The DVI file is used by another process."), MiKTeXException::KVMAP(), MIKTEX_SOURCE_LOCATION());
@@ -691,6 +1030,7 @@ void DviImpl::DoPage(int pageIdx)
   catch (const DviFileInUseException&)
   {
     page.Freeze();
+    page.incomplete = true;
     throw;
   }
 }
@@ -1244,7 +1584,7 @@ DviPage* DviImpl::GetPage(int pageIdx)
     dviPage->Lock();
     try
     {
-      if ((!pageLoaderThread.joinable() || this_thread::get_id() != pageLoaderThread.get_id())
+      if (!IsPageLoaderThread()
         && (!garbageCollectorThread.joinable() || this_thread::get_id() != garbageCollectorThread.get_id())
         && currentPageIdx != pageIdx)
       {
@@ -1258,10 +1598,6 @@ DviPage* DviImpl::GetPage(int pageIdx)
           direction = 1;
         }
         currentPageIdx = pageIdx;
-        if (!SetEvent(hNewPageEvent))
-        {
-          MIKTEX_FATAL_WINDOWS_ERROR("SetEvent");
-        }
       }
       return dviPage;
     }
@@ -1321,7 +1657,9 @@ DviPage* DviImpl::GetLoadedPage(int pageIdx)
     case PageStatus::Unknown:
       return 0;
     case PageStatus::Changed:
-      Scan();              // fall through
+      Scan();
+      // unchanged pages have survived the scan
+      return GetLoadedPage(pageIdx);
     case PageStatus::NotLoaded:
       DoPage(pageIdx);     // fall through
     case PageStatus::Loaded:
@@ -1342,7 +1680,7 @@ DviPage* DviImpl::GetLoadedPage(int pageIdx)
 
 void DviImpl::Progress(DviNotification nf, const string& msg)
 {
-  if ((pageLoaderThread.joinable() && this_thread::get_id() == pageLoaderThread.get_id())
+  if (IsPageLoaderThread()
     || (garbageCollectorThread.joinable() && this_thread::get_id() == garbageCollectorThread.get_id()))
   {
     return;
@@ -1377,8 +1715,75 @@ const unsigned long limitNormalPrio = 20 * 1024 * 1024;
 const unsigned long limitAboveNormalPrio = 50 * 1024 * 1024;
 const unsigned long limitHighestPrio = 100 * 1024 * 1024;
 
+// the number of pages ahead of the current page which are loaded in the
+// background
+const int pageLoaderWindow = 10;
+
+namespace
+{
+  // set by the page loader threads (of any DVI object)
+  thread_local bool isPageLoaderThread = false;
+}
+
+bool DviImpl::IsPageLoaderThread()
+{
+  return isPageLoaderThread;
+}
+
+// returns the page nearest to the current page (in scroll direction) which
+// has to be loaded or rasterized, and which no other thread is working on;
+// -1, if there is no such page
+int DviImpl::NextPageToLoad()
+{
+  for (set<int>::iterator it = requestedPages.begin(); it != requestedPages.end(); )
+  {
+    int pageIdx = *it;
+    if (pageIdx >= GetNumberOfPages())
+    {
+      it = requestedPages.erase(it);
+      continue;
+    }
+    DviPageImpl* dviPage = pages[pageIdx];
+    if (!dviPage->TryLock())
+    {
+      ++it;
+      continue;
+    }
+    bool done = dviPage->IsFrozen() && dviPage->HasShrinkedRaster(defaultShrinkFactor);
+    dviPage->Unlock();
+    it = requestedPages.erase(it);
+    if (!done)
+    {
+      return pageIdx;
+    }
+  }
+  // no page has been viewed yet: start with the first one
+  int firstPageIdx = std::max(currentPageIdx, 0);
+  for (int distance = 0; distance < pageLoaderWindow; ++distance)
+  {
+    int pageIdx = firstPageIdx + distance * direction;
+    if (pageIdx < 0 || pageIdx >= GetNumberOfPages())
+    {
+      break;
+    }
+    DviPageImpl* dviPage = pages[pageIdx];
+    if (!dviPage->TryLock())
+    {
+      continue;
+    }
+    bool done = dviPage->IsFrozen() && dviPage->HasShrinkedRaster(defaultShrinkFactor);
+    dviPage->Unlock();
+    if (!done)
+    {
+      return pageIdx;
+    }
+  }
+  return -1;
+}
+
 void DviImpl::PageLoader()
 {
+  isPageLoaderThread = true;
   try
   {
 #if 1
@@ -1389,7 +1794,6 @@ void DviImpl::PageLoader()
 #endif
 
     MIKTEX_ASSERT(hByeByeEvent != nullptr);
-    MIKTEX_ASSERT(hNewPageEvent != nullptr);
     MIKTEX_ASSERT(hScannedEvent != nullptr);
 
     HANDLE handles[2];
@@ -1409,7 +1813,9 @@ void DviImpl::PageLoader()
       return;
     }
 
-    for (int pageIdx = currentPageIdx + 1; (wait = WaitForSingleObject(hByeByeEvent, sleepDurationBelowNormalPrio)) != WAIT_OBJECT_0; pageIdx += direction)
+    bool idle = false;
+
+    while ((wait = WaitForSingleObject(hByeByeEvent, idle ? sleepDurationBelowNormalPrio : 0)) != WAIT_OBJECT_0)
     {
       if (wait == WAIT_FAILED)
       {
@@ -1417,49 +1823,25 @@ void DviImpl::PageLoader()
       }
       DviPage* dviPage = nullptr;
       AutoUnlockPage autoUnlockPage(nullptr);
+      int shrinkFactor;
       BEGIN_CRITICAL_SECTION(dviMutex)
       {
-        wait = WaitForSingleObject(hNewPageEvent, 0);
-        if (wait == WAIT_FAILED)
-        {
-          MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
-        }
-        if (wait == WAIT_OBJECT_0)
-        {
-          pageIdx = currentPageIdx;
-        }
-        if (pageIdx < 0 || pageIdx >= GetNumberOfPages())
-        {
-          pageIdx = currentPageIdx;
-          continue;
-        }
-        if (direction > 0)
-        {
-          if (!(pageIdx >= currentPageIdx && pageIdx < currentPageIdx + 10))
-          {
-            continue;
-          }
-        }
-        else
-        {
-          MIKTEX_ASSERT(direction < 0);
-          if (!(pageIdx <= currentPageIdx && pageIdx > currentPageIdx - 10))
-          {
-            continue;
-          }
-        }
-        DviPageImpl* pPageImpl = pages[pageIdx];
-        if (pPageImpl->IsLocked())
+        int pageIdx = NextPageToLoad();
+        idle = pageIdx < 0;
+        if (idle)
         {
           continue;
         }
+        shrinkFactor = defaultShrinkFactor;
+        // interpreting the DVI file needs the DVI object
         dviPage = GetLoadedPage(pageIdx);
         autoUnlockPage.Attach(dviPage);
       }
       END_CRITICAL_SECTION();
+      // the page is locked: other threads rasterize other pages meanwhile
       if (dviPage != nullptr)
       {
-        dviPage->GetNumberOfDviBitmaps(defaultShrinkFactor);
+        dviPage->GetNumberOfDviBitmaps(shrinkFactor);
       }
     }
   }
@@ -1477,6 +1859,46 @@ void DviImpl::PageLoader()
   }
 }
 
+void DviImpl::SetPreferredShrinkFactor(int shrinkFactor)
+{
+  CheckCondition();
+  BEGIN_CRITICAL_SECTION(dviMutex)
+  {
+    defaultShrinkFactor = shrinkFactor;
+  }
+  END_CRITICAL_SECTION();
+}
+
+bool DviImpl::IsPagePending(int pageIdx, int shrinkFactor)
+{
+  CheckCondition();
+  if (pageLoaderThreads.empty())
+  {
+    return false;
+  }
+  BEGIN_CRITICAL_SECTION(dviMutex)
+  {
+    if (pageIdx < 0 || pageIdx >= GetNumberOfPages())
+    {
+      return false;
+    }
+    DviPageImpl* dviPage = pages[pageIdx];
+    // a locked page is being worked on
+    bool ready = false;
+    if (dviPage->TryLock())
+    {
+      ready = dviPage->IsFrozen() && dviPage->HasShrinkedRaster(shrinkFactor);
+      dviPage->Unlock();
+    }
+    if (!ready && shrinkFactor == defaultShrinkFactor)
+    {
+      requestedPages.insert(pageIdx);
+    }
+    return !ready && shrinkFactor == defaultShrinkFactor;
+  }
+  END_CRITICAL_SECTION();
+}
+
 const time_t timeKeepBitmapsLowestPrio = 120; // seconds
 const time_t timeKeepBitmapsBelowNormalPrio = 60;
 const time_t timeKeepBitmapsNormalPrio = 30;
@@ -1501,6 +1923,7 @@ void DviImpl::GarbageCollector()
       {
         MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
       }
+      GlyphCache::GetInstance().Trim();
       size_t sizeBiggest = 0;
       int biggestPageIdx = -1;
       DviPageImpl* dviPage;
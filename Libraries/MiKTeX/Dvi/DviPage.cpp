@@ -38,7 +38,7 @@ const int MaxVerticalWhite = 2;
 const int MaxHorizontalWhite = 32;
 #endif
 
-size_t DviPageImpl::totalSize = 0;
+atomic<size_t> DviPageImpl::totalSize{ 0 };
 
 #if defined(max)
 #undef max
@@ -262,20 +262,22 @@ void DviPageImpl::MakeDviBitmaps(int shrinkFactor)
   vector<DviItem>::iterator it = dviItems.begin();
 
   // initialize band
-  vector<DviItem*> dviItemPointers;
-  dviItemPointers.reserve(200);
-  dviItemPointers.push_back(&*it);
+  vector<vector<DviItem*>> bands(1);
+  bands.back().reserve(200);
+  bands.back().push_back(&*it);
   int bandBottom = it->GetBottomShr(shrinkFactor);
 
   // divide vertically
-  for (; it != dviItems.end(); ++it)
+  for (++it; it != dviItems.end(); ++it)
   {
     int itemTop = it->GetTopShr(shrinkFactor);
     int itemBottom = it->GetBottomShr(shrinkFactor);
 
     if (itemTop > bandBottom + MaxVerticalWhite)
     {
-      ProcessBand(shrinkFactor, dviItemPointers);
+      // start a new band
+      bands.emplace_back();
+      bands.back().reserve(200);
       bandBottom = itemBottom;
     }
     else
@@ -283,14 +285,92 @@ void DviPageImpl::MakeDviBitmaps(int shrinkFactor)
       bandBottom = std::max(bandBottom, itemBottom);
     }
 
-    dviItemPointers.push_back(&*it);
+    bands.back().push_back(&*it);
   }
 
-  // process last band
-  ProcessBand(shrinkFactor, dviItemPointers);
+  ProcessBands(shrinkFactor, bands);
 }
 
-void DviPageImpl::ProcessBand(int shrinkFactor, vector<DviItem*>& dviItemPointers)
+// pages with fewer items are not worth the thread start-up
+const size_t minItemsForParallelBands = 1000;
+
+const unsigned maxBandWorkers = 4;
+
+void DviPageImpl::ProcessBands(int shrinkFactor, vector<vector<DviItem*>>& bands)
+{
+  vector<vector<DviBitmap>> bandBitmaps(bands.size());
+
+  // the bands do not overlap: they can be processed in parallel; page
+  // loader threads already work in parallel on different pages
+  unsigned numberOfWorkers = 1;
+  if (dviItems.size() >= minItemsForParallelBands && bands.size() > 1 && !dviImpl->IsPageLoaderThread())
+  {
+    unsigned numberOfCores = std::max(thread::hardware_concurrency(), 1u);
+    numberOfWorkers = static_cast<unsigned>(std::min<size_t>({ maxBandWorkers, numberOfCores, bands.size() }));
+  }
+
+  atomic<size_t> nextBand{ 0 };
+  auto work = [this, shrinkFactor, &bands, &bandBitmaps, &nextBand]()
+  {
+    for (size_t idx = nextBand++; idx < bands.size(); idx = nextBand++)
+    {
+      ProcessBand(shrinkFactor, bands[idx], bandBitmaps[idx]);
+    }
+  };
+
+  exception_ptr error;
+  vector<future<void>> workers;
+  for (unsigned n = 1; n < numberOfWorkers; ++n)
+  {
+    workers.push_back(async(launch::async, work));
+  }
+  try
+  {
+    work();
+  }
+  catch (const exception&)
+  {
+    error = current_exception();
+    // let the others stop early
+    nextBand = bands.size();
+  }
+  for (future<void>& worker : workers)
+  {
+    try
+    {
+      worker.get();
+    }
+    catch (const exception&)
+    {
+      if (error == nullptr)
+      {
+        error = current_exception();
+      }
+    }
+  }
+
+  // merge the bitmaps in band order (even if a band failed: they are
+  // owned by the page from now on)
+  vector<DviBitmap>& bitmaps = shrinkedDviBitmaps[shrinkFactor];
+  for (const vector<DviBitmap>& bandResult : bandBitmaps)
+  {
+    for (const DviBitmap& bitmap : bandResult)
+    {
+      traceBitmap->WriteLine("libdvi", fmt::format(T_("bitmap {0}; bounding box: {1},{2},{3},{4}"), bitmaps.size(), bitmap.x, bitmap.y, bitmap.width, bitmap.height));
+      size_t rasterSize = bitmap.bytesPerLine * bitmap.height;
+      size += rasterSize;
+      totalSize += rasterSize;
+      bitmaps.push_back(bitmap);
+    }
+  }
+
+  if (error != nullptr)
+  {
+    rethrow_exception(error);
+  }
+}
+
+void DviPageImpl::ProcessBand(int shrinkFactor, vector<DviItem*>& dviItemPointers, vector<DviBitmap>& bitmaps)
 {
   MIKTEX_ASSERT(dviItemPointers.size() > 0);
 
@@ -333,7 +413,7 @@ void DviPageImpl::ProcessBand(int shrinkFactor, vector<DviItem*>& dviItemPointer
       // add the current bitmap
       if (currentBitmap.width > 0 && currentBitmap.height > 0)
       {
-        MakeDviBitmap(shrinkFactor, currentBitmap, itItemPtrMark, itItemPtr);
+        MakeDviBitmap(shrinkFactor, currentBitmap, itItemPtrMark, itItemPtr, bitmaps);
       }
 
       itItemPtrMark = itItemPtr;
@@ -367,22 +447,16 @@ void DviPageImpl::ProcessBand(int shrinkFactor, vector<DviItem*>& dviItemPointer
   }
 
   // add the current bitmap
-  MakeDviBitmap(shrinkFactor, currentBitmap, itItemPtrMark, dviItemPointers.end());
+  MakeDviBitmap(shrinkFactor, currentBitmap, itItemPtrMark, dviItemPointers.end(), bitmaps);
 
   // clear the band, since we are ready
   dviItemPointers.clear();
 }
 
-void DviPageImpl::MakeDviBitmap(int shrinkFactor, DviBitmap& bitmap, vector<DviItem*>::iterator itItemPtrBegin, vector<DviItem*>::iterator itItemPtrEnd)
+void DviPageImpl::MakeDviBitmap(int shrinkFactor, DviBitmap& bitmap, vector<DviItem*>::iterator itItemPtrBegin, vector<DviItem*>::iterator itItemPtrEnd, vector<DviBitmap>& bitmaps)
 {
   MIKTEX_ASSERT(bitmap.pixels == nullptr);
 
-  vector<DviBitmap>& bitmaps = shrinkedDviBitmaps[shrinkFactor];
-
-  bitmaps.reserve(1000 / shrinkFactor);
-
-  traceBitmap->WriteLine("libdvi", fmt::format(T_("bitmap {0}; bounding box: {1},{2},{3},{4}"), bitmaps.size(), bitmap.x, bitmap.y, bitmap.width, bitmap.height));
-
   int bytesPerLine = dviImpl->GetBytesPerLine(shrinkFactor, bitmap.width);
   MIKTEX_ASSERT(bytesPerLine > 0);
   bitmap.bytesPerLine = bytesPerLine;
@@ -393,8 +467,6 @@ void DviPageImpl::MakeDviBitmap(int shrinkFactor, DviBitmap& bitmap, vector<DviI
   {
     OUT_OF_MEMORY("malloc");
   }
-  size += rasterSize;
-  totalSize += rasterSize;
   memset(const_cast<void*>(bitmap.pixels), 0, rasterSize);
 
   int bitsPerPixel = dviImpl->GetBitsPerPixel(shrinkFactor);
@@ -524,6 +596,18 @@ void DviPageImpl::FreeContents(bool keepSpecials, bool keepItems)
   haveGraphicsInclusions.clear();
   graphicsInclusions.clear();
   frozen = false;
+  incomplete = false;
+}
+
+void DviPageImpl::Relocate(int pageIdx, long readPosition)
+{
+  Lock();
+  AutoUnlockPage autoUnlock(this);
+  this->pageIdx = pageIdx;
+  this->readPosition = readPosition;
+  // the included graphics files might have changed
+  haveGraphicsInclusions.clear();
+  graphicsInclusions.clear();
 }
 
 const char* DviPageImpl::GetName()
@@ -680,6 +764,18 @@ void DviPageImpl::Lock()
   nLocks += 1;
 }
 
+bool DviPageImpl::TryLock()
+{
+  if (!pageMutex.try_lock())
+  {
+    return false;
+  }
+  MIKTEX_ASSERT(nLocks >= 0);
+  MIKTEX_ASSERT(nLocks < 1000);
+  nLocks += 1;
+  return true;
+}
+
 void DviPageImpl::Unlock()
 {
   MIKTEX_ASSERT(nLocks > 0);
@@ -722,6 +818,7 @@ void DviPageImpl::MakeDibChunks(int shrinkFactor)
     pDvips = StartDvips();
     thread dvipsTranscriptReader(&DviPageImpl::DvipsTranscriptReader, this);
     pGhostscript = StartGhostscript(shrinkFactor);
+    thread dvipsOutputCopier(&DviPageImpl::CopyDvipsOutput, this);
     thread ghostscriptTranscriptReader(&DviPageImpl::GhostscriptTranscriptReader, this);
     unique_ptr<DibChunker> pChunker(DibChunker::Create());
     const size_t CHUNK_SIZE = 1024 * 64;
@@ -730,6 +827,7 @@ void DviPageImpl::MakeDibChunks(int shrinkFactor)
     while (pChunker->Process(DibChunker::Default, CHUNK_SIZE, this))
     {
     }
+    dvipsOutputCopier.join();
     dvipsTranscriptReader.join();
     ghostscriptTranscriptReader.join();
   }
@@ -740,6 +838,10 @@ void DviPageImpl::MakeDibChunks(int shrinkFactor)
     {
       dvipsOut.Close();
     }
+    if (gsIn.GetFile() != nullptr)
+    {
+      gsIn.Close();
+    }
     gsOut.Close();
     gsErr.Close();
     throw;
@@ -794,6 +896,36 @@ void DviPageImpl::DvipsTranscriptReader()
   }
 }
 
+// feeds the pooled Ghostscript process with the output of Dvips
+void DviPageImpl::CopyDvipsOutput()
+{
+  try
+  {
+    const size_t CHUNK_SIZE = 1024 * 16;
+    char buf[CHUNK_SIZE];
+    try
+    {
+      size_t n;
+      while ((n = dvipsOut.Read(buf, CHUNK_SIZE)) > 0)
+      {
+        gsIn.Write(buf, n);
+      }
+    }
+    catch (const BrokenPipeException&)
+    {
+    }
+  }
+  catch (const MiKTeXException&)
+  {
+  }
+  catch (const exception&)
+  {
+  }
+  // end of input: Ghostscript exits after the page
+  dvipsOut.Close();
+  gsIn.Close();
+}
+
 void DviPageImpl::GhostscriptTranscriptReader()
 {
   try
@@ -931,24 +1063,15 @@ unique_ptr<Process> DviPageImpl::StartGhostscript(int shrinkFactor)
   arguments.push_back("-sOutputFile="s + "-");
   arguments.push_back("-");
 
-  ProcessStartInfo processStartInfo;
-
-  processStartInfo.Arguments = arguments;
-  processStartInfo.FileName = gsPath.ToString();
-  processStartInfo.StandardInput = dvipsOut.GetFile();
-  processStartInfo.RedirectStandardError = true;
-  processStartInfo.RedirectStandardOutput = true;
-  processStartInfo.WorkingDirectory = dviImpl->GetDviFileName().MakeFullyQualified().RemoveFileSpec().ToString();
-
-  unique_ptr<Process> pGhostscript(Process::Start(processStartInfo));
-
-  // close unused file stream (this prevents a hang situation)
-  dvipsOut.Close();
+  // Dvips sends its own prologue; the output of Dvips is copied to the
+  // process by CopyDvipsOutput()
+  GhostscriptPool::Job job = GhostscriptPool::GetInstance().Acquire(arguments, dviImpl->GetDviFileName().MakeFullyQualified().RemoveFileSpec(), {});
 
-  gsOut.Attach(pGhostscript->get_StandardOutput());
-  gsErr.Attach(pGhostscript->get_StandardError());
+  gsIn.Attach(job.standardInput);
+  gsOut.Attach(job.standardOutput);
+  gsErr.Attach(job.standardError);
 
-  return pGhostscript;
+  return move(job.process);
 }
 
 int DviPageImpl::GetNumberOfGraphicsInclusions(int shrinkFactor)
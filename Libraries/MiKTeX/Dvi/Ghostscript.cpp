@@ -92,21 +92,27 @@ void Ghostscript::Start()
 
   tracePS->WriteLine("libdvi", CommandLineBuilder(arguments).ToString());
 
-  ProcessStartInfo startinfo;
+  // the pooled process has run the standard headers already
+  vector<PathName> prologue;
+  for (const string& headerName : standardHeaders)
+  {
+    PathName fileName;
+    if (!session->FindFile(headerName, FileType::PSHEADER, fileName))
+    {
+      MIKTEX_FATAL_ERROR_2(T_("Cannot find PostScript header file."), "path", headerName);
+    }
+    prologue.push_back(fileName);
+  }
+
+  GhostscriptPool::Job job = GhostscriptPool::GetInstance().Acquire(arguments, dviImpl->GetDviFileName().MakeFullyQualified().RemoveFileSpec(), prologue);
 
-  startinfo.Arguments = arguments;
-  startinfo.FileName = gsExe.ToString();
-  startinfo.StandardInput = nullptr;
-  startinfo.RedirectStandardInput = true;
-  startinfo.RedirectStandardOutput = true;
-  startinfo.RedirectStandardError = true;
-  startinfo.WorkingDirectory = dviImpl->GetDviFileName().MakeFullyQualified().RemoveFileSpec().ToString();
+  process = move(job.process);
 
-  process = Process::Start(startinfo);
+  gsIn.Attach(job.standardInput);
+  gsOut.Attach(job.standardOutput);
+  gsErr.Attach(job.standardError);
 
-  gsIn.Attach(process->get_StandardInput());
-  gsOut.Attach(process->get_StandardOutput());
-  gsErr.Attach(process->get_StandardError());
+  preloadedHeaders = standardHeaders;
 
   // start chunker thread
   chunkerThread = thread(&Ghostscript::Chunker, this);
@@ -218,6 +224,15 @@ void Ghostscript::Execute(const string& s)
   Write(s.c_str(), static_cast<unsigned>(s.length()));
 }
 
+bool Ghostscript::IsPreloaded(const string& headerName)
+{
+  if (process == nullptr)
+  {
+    Start();
+  }
+  return find(preloadedHeaders.begin(), preloadedHeaders.end(), headerName) != preloadedHeaders.end();
+}
+
 void Ghostscript::Finalize()
 {
   // close Ghostscript's input stream
@@ -39,6 +39,9 @@ public:
 public:
   void Execute(const std::string& s) override;
 
+private:
+  bool IsPreloaded(const string& headerName) override;
+
 public:
   size_t MIKTEXTHISCALL Read(void* data, size_t size) override;
 
@@ -77,4 +80,8 @@ private:
 
 private:
   string stderrBuffer;
+
+  // the standard headers, run by the pooled Ghostscript process
+private:
+  vector<string> preloadedHeaders;
 };
@@ -0,0 +1,166 @@
+/* GhostscriptPool.cpp: pool of started Ghostscript processes
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX DVI Library.
+
+   The MiKTeX DVI Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2, or (at your option) any later version.
+
+   The MiKTeX DVI Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with the MiKTeX DVI Library; if not, write to the
+   Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139,
+   USA.  */
+
+#include "config.h"
+
+#include "internal.h"
+
+// command lines differ in the resolution (shrink factor) and in the
+// paper size
+const size_t GhostscriptPool::maxEntries = 2;
+
+// enough for the page loader threads of a DVI document
+const size_t GhostscriptPool::sparesPerEntry = 2;
+
+GhostscriptPool& GhostscriptPool::GetInstance()
+{
+  static GhostscriptPool instance;
+  return instance;
+}
+
+GhostscriptPool::~GhostscriptPool()
+{
+  for (Entry& entry : entries)
+  {
+    for (future<Job>& spare : entry.spares)
+    {
+      Discard(spare);
+    }
+  }
+}
+
+GhostscriptPool::Job GhostscriptPool::Start(vector<string> arguments, PathName workingDirectory, vector<PathName> prologue)
+{
+  shared_ptr<Session> session = MIKTEX_SESSION();
+
+  ProcessStartInfo processStartInfo;
+
+  processStartInfo.Arguments = arguments;
+  processStartInfo.FileName = session->GetGhostscript(nullptr).ToString();
+  processStartInfo.StandardInput = nullptr;
+  processStartInfo.RedirectStandardInput = true;
+  processStartInfo.RedirectStandardOutput = true;
+  processStartInfo.RedirectStandardError = true;
+  processStartInfo.WorkingDirectory = workingDirectory.ToString();
+
+  Job job;
+
+  job.process = Process::Start(processStartInfo);
+  job.standardInput = job.process->get_StandardInput();
+  job.standardOutput = job.process->get_StandardOutput();
+  job.standardError = job.process->get_StandardError();
+
+  // run the prologue; see PostScript::ExecuteBatch()
+  for (PathName fileName : prologue)
+  {
+    fileName.Convert({ ConvertPathNameOption::ToUnix, ConvertPathNameOption::MakeFullyQualified });
+    string command = fmt::format("({0}) run\n", fileName.ToString());
+    if (fwrite(command.c_str(), 1, command.length(), job.standardInput) != command.length())
+    {
+      MIKTEX_FATAL_CRT_ERROR("fwrite");
+    }
+  }
+  if (fflush(job.standardInput) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR("fflush");
+  }
+
+  return job;
+}
+
+void GhostscriptPool::Discard(future<Job>& spare)
+{
+  try
+  {
+    Job job = spare.get();
+    // Ghostscript exits at the end of its input
+    fclose(job.standardInput);
+    job.process->WaitForExit(1000);
+    fclose(job.standardOutput);
+    fclose(job.standardError);
+  }
+  catch (const exception&)
+  {
+  }
+}
+
+GhostscriptPool::Job GhostscriptPool::Acquire(const vector<string>& arguments, const PathName& workingDirectory, const vector<PathName>& prologue)
+{
+  string key = workingDirectory.ToString();
+  for (const string& argument : arguments)
+  {
+    key += '\n';
+    key += argument;
+  }
+  for (const PathName& fileName : prologue)
+  {
+    key += '\n';
+    key += fileName.ToString();
+  }
+  future<Job> spare;
+  list<Entry> evicted;
+  {
+    lock_guard<mutex> lockGuard(mtx);
+    auto it = find_if(entries.begin(), entries.end(), [&key](const Entry& entry) { return entry.key == key; });
+    if (it == entries.end())
+    {
+      entries.push_front(Entry{ key });
+    }
+    else
+    {
+      entries.splice(entries.begin(), entries, it);
+    }
+    Entry& entry = entries.front();
+    if (!entry.spares.empty())
+    {
+      spare = move(entry.spares.front());
+      entry.spares.pop_front();
+    }
+    // start the processes for the next pages
+    while (entry.spares.size() < sparesPerEntry)
+    {
+      entry.spares.push_back(async(launch::async, &GhostscriptPool::Start, arguments, workingDirectory, prologue));
+    }
+    while (entries.size() > maxEntries)
+    {
+      evicted.splice(evicted.end(), entries, prev(entries.end()));
+    }
+  }
+  for (Entry& entry : evicted)
+  {
+    for (future<Job>& evictedSpare : entry.spares)
+    {
+      Discard(evictedSpare);
+    }
+  }
+  if (spare.valid())
+  {
+    try
+    {
+      return spare.get();
+    }
+    catch (const exception&)
+    {
+      // try again below
+    }
+  }
+  return Start(arguments, workingDirectory, prologue);
+}
@@ -0,0 +1,78 @@
+/* GhostscriptPool.h:                                   -*- C++ -*-
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX DVI Library.
+
+   The MiKTeX DVI Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2, or (at your option) any later version.
+
+   The MiKTeX DVI Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with the MiKTeX DVI Library; if not, write to the
+   Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139,
+   USA.  */
+
+#pragma once
+
+// Ghostscript processes which are started before they are needed, shared
+// by all DVI documents of the process.  Ghostscript reads the PostScript
+// code from stdin and exits at the end of it, i.e., a process renders
+// exactly one page.  While a page is being rendered, the pool starts the
+// process for the next page, which then has finished its initialization
+// (and has run the PostScript prologue) by the time it is acquired.
+class GhostscriptPool
+{
+public:
+  struct Job
+  {
+    unique_ptr<Process> process;
+    FILE* standardInput = nullptr;
+    FILE* standardOutput = nullptr;
+    FILE* standardError = nullptr;
+  };
+
+public:
+  static GhostscriptPool& GetInstance();
+
+public:
+  ~GhostscriptPool();
+
+  // returns a started Ghostscript process; the caller owns the streams
+  // of the job; prologue contains the PostScript files to be run before
+  // the job's PostScript code
+public:
+  Job Acquire(const vector<string>& arguments, const PathName& workingDirectory, const vector<PathName>& prologue);
+
+private:
+  static Job Start(vector<string> arguments, PathName workingDirectory, vector<PathName> prologue);
+
+private:
+  static void Discard(future<Job>& spare);
+
+private:
+  struct Entry
+  {
+    string key;
+    list<future<Job>> spares;
+  };
+
+private:
+  mutex mtx;
+
+  // most recently used command line first
+private:
+  list<Entry> entries;
+
+private:
+  static const size_t maxEntries;
+
+private:
+  static const size_t sparesPerEntry;
+};
@@ -0,0 +1,75 @@
+/* GlyphCache.cpp: process-wide cache for shrunk PK glyphs
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX DVI Library.
+
+   The MiKTeX DVI Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2, or (at your option) any later version.
+
+   The MiKTeX DVI Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with the MiKTeX DVI Library; if not, write to the
+   Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139,
+   USA.  */
+
+#include "config.h"
+
+#include "internal.h"
+
+const size_t GlyphCache::maxSize = 32 * 1024 * 1024;
+
+GlyphCache& GlyphCache::GetInstance()
+{
+  static GlyphCache instance;
+  return instance;
+}
+
+string GlyphCache::MakeKey(const MD5& pkDigest, int charCode, int shrinkFactor)
+{
+  return fmt::format("{0}/{1}/{2}", pkDigest.ToString(), charCode, shrinkFactor);
+}
+
+shared_ptr<void> GlyphCache::Get(const MD5& pkDigest, int charCode, int shrinkFactor)
+{
+  lock_guard<mutex> lockGuard(mtx);
+  auto it = entries.find(MakeKey(pkDigest, charCode, shrinkFactor));
+  if (it == entries.end())
+  {
+    return nullptr;
+  }
+  lru.splice(lru.begin(), lru, it->second.lruPosition);
+  return it->second.raster;
+}
+
+void GlyphCache::Put(const MD5& pkDigest, int charCode, int shrinkFactor, shared_ptr<void> raster, size_t size)
+{
+  string key = MakeKey(pkDigest, charCode, shrinkFactor);
+  lock_guard<mutex> lockGuard(mtx);
+  if (entries.find(key) != entries.end())
+  {
+    return;
+  }
+  lru.push_front(key);
+  entries[key] = Entry{ raster, size, lru.begin() };
+  this->size += size;
+}
+
+void GlyphCache::Trim()
+{
+  lock_guard<mutex> lockGuard(mtx);
+  while (size > maxSize && !lru.empty())
+  {
+    // the raster is freed when the last PkChar using it goes away
+    auto it = entries.find(lru.back());
+    size -= it->second.size;
+    entries.erase(it);
+    lru.pop_back();
+  }
+}
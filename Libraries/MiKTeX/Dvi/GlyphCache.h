@@ -0,0 +1,69 @@
+/* GlyphCache.h:                                        -*- C++ -*-
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX DVI Library.
+
+   The MiKTeX DVI Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2, or (at your option) any later version.
+
+   The MiKTeX DVI Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with the MiKTeX DVI Library; if not, write to the
+   Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139,
+   USA.  */
+
+#pragma once
+
+// Shrunk PK glyphs, shared by all DVI documents of the process: a document
+// which is reloaded (or opened a second time) finds the glyphs it has
+// shrunk before.  Glyphs are identified by the digest of the PK file.
+class GlyphCache
+{
+public:
+  static GlyphCache& GetInstance();
+
+public:
+  shared_ptr<void> Get(const MD5& pkDigest, int charCode, int shrinkFactor);
+
+public:
+  void Put(const MD5& pkDigest, int charCode, int shrinkFactor, shared_ptr<void> raster, size_t size);
+
+  // evicts the least recently used glyphs, until the cache is not bigger
+  // than maxSize
+public:
+  void Trim();
+
+private:
+  static string MakeKey(const MD5& pkDigest, int charCode, int shrinkFactor);
+
+private:
+  struct Entry
+  {
+    shared_ptr<void> raster;
+    size_t size;
+    list<string>::iterator lruPosition;
+  };
+
+private:
+  mutex mtx;
+
+private:
+  unordered_map<string, Entry> entries;
+
+  // most recently used glyph first
+private:
+  list<string> lru;
+
+private:
+  size_t size = 0;
+
+private:
+  static const size_t maxSize;
+};
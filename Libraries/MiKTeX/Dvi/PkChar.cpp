@@ -21,6 +21,12 @@
 
 #include "config.h"
 
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -78,11 +84,7 @@ PkChar::~PkChar()
       delete[] unpackedRaster;
       unpackedRaster = nullptr;
     }
-    for (MAPINTTORASTER::iterator it = bitmaps.begin(); it != bitmaps.end(); ++it)
-    {
-      free(it->second);
-      it->second = nullptr;
-    }
+    bitmaps.clear();
     if (trace_error != nullptr)
     {
       trace_error->Close();
@@ -365,44 +367,105 @@ void PkChar::Unpack()
   }
 }
 
-const unsigned long maxBitFieldLength = bitsPerRasterWord;
-
 namespace {
   const unsigned char bitcounts[] =
   {
 #include "bitcounts.h"
   };
-}
 
-unsigned long PkChar::CountBits(const RASTERWORD* rasterWord, int xStart, int rasterWordsPerLine, int w, int h)
-{
-  unsigned long result = 0;
+  struct TablePopCount
+  {
+    unsigned long operator()(uint32_t bits) const
+    {
+      return bitcounts[bits >> 16] + bitcounts[bits & 0xffff];
+    }
+  };
 
-  unsigned long rightShift = bitsPerRasterWord - (xStart % bitsPerRasterWord);
-  rasterWord += xStart / bitsPerRasterWord;
+  // counts the pixels of a w x h cell; a cell is processed in slices of up
+  // to 32 pixels (two raster words), which are counted row by row
+  template<class PopCount> inline unsigned long CountCellBits(const PkChar::RASTERWORD* rasterWord, int xStart, int rasterWordsPerLine, int w, int h, PopCount popCount)
+  {
+    unsigned long result = 0;
+    int xEnd = xStart + w;
+    for (int x = xStart; x < xEnd; )
+    {
+      int firstBit = x % bitsPerRasterWord;
+      int sliceLength = std::min(xEnd - x, static_cast<int>(2 * bitsPerRasterWord) - firstBit);
+      // the second raster word is within the row only if it contains pixels of the cell
+      bool twoWords = firstBit + sliceLength > static_cast<int>(bitsPerRasterWord);
+      uint32_t mask = (0xffffffffu >> firstBit) & ~(firstBit + sliceLength == 32 ? 0 : 0xffffffffu >> (firstBit + sliceLength));
+      const PkChar::RASTERWORD* pRasterWord = rasterWord + x / bitsPerRasterWord;
+      for (int i = 0; i < h; ++i, pRasterWord += rasterWordsPerLine)
+      {
+        uint32_t bits = static_cast<uint32_t>(static_cast<uint16_t>(pRasterWord[0])) << 16;
+        if (twoWords)
+        {
+          bits |= static_cast<uint16_t>(pRasterWord[1]);
+        }
+        result += popCount(bits & mask);
+      }
+      x += sliceLength;
+    }
+    return result;
+  }
 
-  while (w > 0)
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_POPCNT_KERNEL 1
+  struct HardwarePopCount
   {
-    unsigned long bitFieldLength = std::min(rightShift, static_cast<unsigned long>(w));
-    bitFieldLength = std::min(bitFieldLength, maxBitFieldLength);
-    rightShift -= bitFieldLength;
-    const RASTERWORD* pRasterWord2 = rasterWord;
-    for (int i = 0; i < h; ++i, pRasterWord2 += rasterWordsPerLine)
+    unsigned long operator()(uint32_t bits) const
     {
-      RASTERWORD rw = *pRasterWord2;
-      rw >>= rightShift;
-      rw &= gpower[bitFieldLength];
-      result += bitcounts[rw];
+      return __builtin_popcount(bits);
     }
-    if (rightShift == 0)
+  };
+
+  // compiled with POPCNT: the pop count must be inlined
+  __attribute__((target("popcnt"))) unsigned long CountCellBitsPopcnt(const PkChar::RASTERWORD* rasterWord, int xStart, int rasterWordsPerLine, int w, int h)
+  {
+    return CountCellBits(rasterWord, xStart, rasterWordsPerLine, w, h, HardwarePopCount());
+  }
+
+  bool HavePopcnt()
+  {
+    return __builtin_cpu_supports("popcnt");
+  }
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define HAVE_POPCNT_KERNEL 1
+  struct HardwarePopCount
+  {
+    unsigned long operator()(uint32_t bits) const
     {
-      rightShift = bitsPerRasterWord;
-      rasterWord++;
+      return __popcnt(bits);
     }
-    w -= bitFieldLength;
+  };
+
+  unsigned long CountCellBitsPopcnt(const PkChar::RASTERWORD* rasterWord, int xStart, int rasterWordsPerLine, int w, int h)
+  {
+    return CountCellBits(rasterWord, xStart, rasterWordsPerLine, w, h, HardwarePopCount());
   }
 
-  return result;
+  bool HavePopcnt()
+  {
+    int cpuInfo[4];
+    __cpuid(cpuInfo, 1);
+    return (cpuInfo[2] & (1 << 23)) != 0;
+  }
+#endif
+
+#if defined(HAVE_POPCNT_KERNEL)
+  const bool havePopcnt = HavePopcnt();
+#endif
+}
+
+unsigned long PkChar::CountBits(const RASTERWORD* rasterWord, int xStart, int rasterWordsPerLine, int w, int h)
+{
+#if defined(HAVE_POPCNT_KERNEL)
+  if (havePopcnt)
+  {
+    return CountCellBitsPopcnt(rasterWord, xStart, rasterWordsPerLine, w, h);
+  }
+#endif
+  return CountCellBits(rasterWord, xStart, rasterWordsPerLine, w, h, TablePopCount());
 }
 
 void PkChar::Print()
@@ -423,8 +486,7 @@ void* PkChar::Shrink(int shrinkFactor)
     unsigned long cbLine = ((rasterWidth + 31) / 32) * 4;
     unsigned long rasterWordsPerLine = (rasterWidth + bitsPerRasterWord - 1) / bitsPerRasterWord;
 
-    unsigned char* pShrinkedRaster = reinterpret_cast<unsigned char*>(malloc(rasterHeight * cbLine));
-    memset(pShrinkedRaster, 0, rasterHeight * cbLine);
+    unsigned char* pShrinkedRaster = reinterpret_cast<unsigned char*>(calloc(rasterHeight, cbLine));
 
     int shrinkedRasterHeight = 0;
 
@@ -471,8 +533,7 @@ void* PkChar::Shrink(int shrinkFactor)
 
   unsigned long rasterWordsPerLine = (rasterWidth + bitsPerRasterWord - 1) / bitsPerRasterWord;
 
-  unsigned char* pShrinkedRaster = reinterpret_cast<unsigned char*>(malloc(heightShr * lineSizeShr));
-  memset(pShrinkedRaster, 0, heightShr * lineSizeShr);
+  unsigned char* pShrinkedRaster = reinterpret_cast<unsigned char*>(calloc(heightShr, lineSizeShr));
 
   int shrinkedRasterHeight = 0;
 
@@ -524,13 +585,29 @@ void* PkChar::Shrink(int shrinkFactor)
 
 const void* PkChar::GetBitmap(int shrinkFactor)
 {
+  lock_guard<mutex> lockGuard(static_cast<PkFont*>(dviFont)->GetBitmapMutex());
   MAPINTTORASTER::const_iterator it = bitmaps.find(shrinkFactor);
   if (it != bitmaps.end())
   {
-    return it->second;
+    return it->second.get();
+  }
+  // characters which are missing in the PK file are not cached
+  const MD5* pkDigest = rasterWidth > 0 && rasterHeight > 0 ? static_cast<PkFont*>(dviFont)->GetPkDigest() : nullptr;
+  shared_ptr<void> raster;
+  if (pkDigest != nullptr)
+  {
+    raster = GlyphCache::GetInstance().Get(*pkDigest, GetCharacterCode(), shrinkFactor);
+  }
+  if (raster == nullptr)
+  {
+    Unpack();
+    raster = shared_ptr<void>(Shrink(shrinkFactor), free);
+    if (pkDigest != nullptr)
+    {
+      size_t size = GetHeightShr(shrinkFactor) * dviFont->GetDviObject()->GetBytesPerLine(shrinkFactor, GetWidthShr(shrinkFactor));
+      GlyphCache::GetInstance().Put(*pkDigest, GetCharacterCode(), shrinkFactor, raster, size);
+    }
   }
-  Unpack();
-  void* p = Shrink(shrinkFactor);
-  bitmaps[shrinkFactor] = p;
-  return p;
+  bitmaps[shrinkFactor] = raster;
+  return raster.get();
 }
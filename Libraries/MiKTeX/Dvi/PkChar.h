@@ -93,7 +93,7 @@ public:
     Print();
 
   // 16-bit raster word, big-endian
-private:
+public:
   typedef short int RASTERWORD;
 
 private:
@@ -124,7 +124,7 @@ private:
   inline int WidthShrink(int shrinkFactor, int pxl);
 
 private:
-  typedef unordered_map<int, void*> MAPINTTORASTER;
+  typedef unordered_map<int, shared_ptr<void>> MAPINTTORASTER;
 
 private:
   MAPINTTORASTER bitmaps;
@@ -210,6 +210,9 @@ void PkFont::Read()
 
   dviInfo.fileName = fileName.ToString();
 
+  pkDigest = MD5::FromFile(fileName);
+  hasPkDigest = true;
+
   trace_pkfont->WriteLine("libdvi", fmt::format(T_("opening pk file {0}"), Q_(fileName.ToDisplayString())));
 
   InputStream inputstream(fileName.GetData());
@@ -56,6 +56,21 @@ public:
 public:
   void ReadTFM();
 
+  // the digest of the PK file; nullptr, if the font has not been loaded
+public:
+  const MD5* GetPkDigest()
+  {
+    return hasPkDigest ? &pkDigest : nullptr;
+  }
+
+  // serializes the shrinking of glyphs: pages are rasterized by several
+  // threads
+public:
+  mutex& GetBitmapMutex()
+  {
+    return bitmapMutex;
+  }
+
 private:
   int mag;
 
@@ -68,6 +83,15 @@ private:
 private:
   MAPNUMTOPKCHAR pkChars;
 
+private:
+  MD5 pkDigest;
+
+private:
+  bool hasPkDigest = false;
+
+private:
+  mutex bitmapMutex;
+
 private:
   int existSizes[30];
 
@@ -42,14 +42,21 @@ PostScript::~PostScript()
 {
 }
 
-void PostScript::Initialize()
-{
-  AddHeader("tex.pro");
+const vector<string> PostScript::standardHeaders = {
+  "tex.pro",
 #if 0
-  AddHeader("finclude.pro");
+  "finclude.pro",
 #endif
-  AddHeader("special.pro");
-  AddHeader("gs_permitfilereading.pro");
+  "special.pro",
+  "gs_permitfilereading.pro",
+};
+
+void PostScript::Initialize()
+{
+  for (const string& headerName : standardHeaders)
+  {
+    AddHeader(headerName.c_str());
+  }
 }
 
 // Process a PostScript file. This is done with the help of 'run',
@@ -194,7 +201,10 @@ void PostScript::DoProlog()
   vector<string>::iterator it;
   for (it = headers.begin(); it != headers.end(); ++it)
   {
-    SendHeader(it->c_str());
+    if (!IsPreloaded(*it))
+    {
+      SendHeader(it->c_str());
+    }
   }
   DoDefinitions();
 }
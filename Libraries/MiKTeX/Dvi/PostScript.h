@@ -88,6 +88,13 @@ public:
 protected:
   void AddHeader(const char* fileName);
 
+  // true, if the header has been run before the prologue is sent
+protected:
+  virtual bool IsPreloaded(const string& headerName)
+  {
+    return false;
+  }
+
 protected:
   FILE* ConvertToEPS(const char* fileName);
 
@@ -134,6 +141,9 @@ protected:
 protected:
   bool pageBegunFlag = false;
 
+protected:
+  static const vector<string> standardHeaders;
+
 protected:
   vector<string> definitions;
 
@@ -88,15 +88,17 @@ void Tfm::Read()
 
   trace_tfm->WriteLine("libdvi", fmt::format(T_("going to load TFM file {0}"), dviInfo.name));
 
-  PathName fileName;
+  // the metrics are shared by all DVI documents (and by other MiKTeX
+  // programs) through the font metric cache
+  FontMetrics metrics;
 
-  bool tfmFileExists = session->FindTfmFile(dviInfo.name, fileName, false);
+  bool tfmFileExists = session->GetFontMetrics(dviInfo.name, static_cast<uint32_t>(checkSum), metrics);
 
   if (!tfmFileExists)
   {
     if (Make(dviInfo.name))
     {
-      tfmFileExists = session->FindTfmFile(dviInfo.name, fileName, false);
+      tfmFileExists = session->GetFontMetrics(dviInfo.name, static_cast<uint32_t>(checkSum), metrics);
       if (!tfmFileExists)
       {
         // this shouldn't happen; but it does (#521481)
@@ -107,7 +109,7 @@ void Tfm::Read()
       dviInfo.transcript += "\r\n";
       dviInfo.transcript += T_("Loading 'cmr10' instead.\r\n");
       trace_error->WriteLine("libdvi", fmt::format(T_("'{0}' not loadable - loading 'cmr10' instead!"), dviInfo.name));
-      if (!(session->FindTfmFile("cmr10", fileName, false) || (Make("cmr10") && session->FindTfmFile("cmr10", fileName, false))))
+      if (!(session->GetFontMetrics("cmr10", 0, metrics) || (Make("cmr10") && session->GetFontMetrics("cmr10", 0, metrics))))
       {
         dviInfo.transcript += T_("'cmr10' not loadable either!");
         trace_error->WriteLine("libdvi", T_("'cmr10' not loadable - will display blank chars!"));
@@ -116,48 +118,18 @@ void Tfm::Read()
     }
   }
 
-  dviInfo.fileName = fileName.ToString();
+  dviInfo.fileName = metrics.path.ToString();
 
-  trace_tfm->WriteLine("libdvi", fmt::format(T_("opening TFM file {0}"), Q_(fileName.ToDisplayString())));
+  trace_tfm->WriteLine("libdvi", fmt::format(T_("using metrics of TFM file {0}"), Q_(metrics.path.ToDisplayString())));
 
-  InputStream inputStream(fileName.GetData());
+  trace_tfm->WriteLine("libdvi", fmt::format(T_("smallest character code: {0}"), metrics.firstChar));
+  trace_tfm->WriteLine("libdvi", fmt::format(T_("number of characters: {0}"), metrics.widths.size()));
 
-  long lf = inputStream.ReadSignedPair();
-
-  if (lf == 0)
-  {
-    FATAL_DVI_ERROR(T_("Invalid TFM file."));
-  }
-
-  long lh = inputStream.ReadSignedPair();
-  long bc = inputStream.ReadSignedPair();
-  long ec = inputStream.ReadSignedPair();
-  long nw = inputStream.ReadSignedPair();
-  long nh = inputStream.ReadSignedPair();
-  long nd = inputStream.ReadSignedPair();
-  long ni = inputStream.ReadSignedPair();
-  long nl = inputStream.ReadSignedPair();
-  long nk = inputStream.ReadSignedPair();
-  long ne = inputStream.ReadSignedPair();
-  long np = inputStream.ReadSignedPair();
-
-  trace_tfm->WriteLine("libdvi", fmt::format(T_("header size: {0}"), lh));
-  trace_tfm->WriteLine("libdvi", fmt::format(T_("smallest character code: {0}"), bc));
-  trace_tfm->WriteLine("libdvi", fmt::format(T_("largest character code: {0}"), ec));
-  trace_tfm->WriteLine("libdvi", fmt::format(T_("width table size: {0}"), nw));
-  trace_tfm->WriteLine("libdvi", fmt::format(T_("height table size: {0}"), nh));
-  trace_tfm->WriteLine("libdvi", fmt::format(T_("depth table size: {0}"), nd));
-  trace_tfm->WriteLine("libdvi", fmt::format(T_("italic correction table size: {0}"), ni));
-  trace_tfm->WriteLine("libdvi", fmt::format(T_("lig/kern table size: {0}"), nl));
-  trace_tfm->WriteLine("libdvi", fmt::format(T_("kern table size: {0}"), nk));
-  trace_tfm->WriteLine("libdvi", fmt::format(T_("extensible character table size: {0}"), ne));
-  trace_tfm->WriteLine("libdvi", fmt::format(T_("font parameter size: {0}"), np));
-
-  int my_checkSum = inputStream.ReadSignedQuad();
+  int my_checkSum = static_cast<int>(metrics.checkSum);
 
   trace_tfm->WriteLine("libdvi", fmt::format("checkSum: {0:o}", my_checkSum));
 
-  int my_designSize = inputStream.ReadSignedQuad();
+  int my_designSize = metrics.designSize;
 
   trace_tfm->WriteLine("libdvi", fmt::format("designSize: {0}", my_designSize));
 
@@ -171,58 +143,14 @@ void Tfm::Read()
     trace_error->WriteLine("libdvi", fmt::format(T_("{0}: designSize mismatch"), dviInfo.name));
   }
 
-  inputStream.SkipBytes((lh - 2) * 4);
-
-  struct TfmIndex
-  {
-    int widthIndex;
-    int heightIndex;
-    int depthIndex;
-  };
-
-  vector<TfmIndex> infoTable(ec);
-
-  for (int charCode = bc; charCode < ec; ++charCode)
+  for (size_t idx = 0; idx < metrics.widths.size(); ++idx)
   {
+    int charCode = metrics.firstChar + static_cast<int>(idx);
     DviChar* dviChar = new DviChar(this);
     dviChars[charCode] = dviChar;
     dviChar->SetCharacterCode(charCode);
-    TfmIndex tfmIndex;
-    tfmIndex.widthIndex = inputStream.ReadSignedByte();
-    int heightDepth = inputStream.ReadSignedByte();
-    tfmIndex.heightIndex = ((heightDepth >> 4) & 15);
-    tfmIndex.depthIndex = (heightDepth & 15);
-    inputStream.SkipBytes(2);
-    infoTable[charCode] = tfmIndex;
-  }
-
-  vector<int> widths(nw);
-
-  for (int idx = 0; idx < nw; ++idx)
-  {
-    widths[idx] = inputStream.ReadSignedQuad();
-  }
-
-  vector<int> heights(nh);
-
-  for (int idx = 0; idx < nh; ++idx)
-  {
-    heights[idx] = inputStream.ReadSignedQuad();
-  }
-
-  vector<int> depths(nd);
-
-  for (int idx = 0; idx < nd; ++idx)
-  {
-    depths[idx] = inputStream.ReadSignedQuad();
-  }
-
-  // inputStream.Close ();
-
-  for (int charCode = bc; charCode < ec; ++charCode)
-  {
-    int tfmWidth = ScaleFix(widths[infoTable[charCode].widthIndex], GetScaledAt());
-    dviChars[charCode]->SetDviWidth(tfmWidth);
+    int tfmWidth = ScaleFix(metrics.widths[idx], GetScaledAt());
+    dviChar->SetDviWidth(tfmWidth);
     int pixelWidth;
     if (tfmWidth >= 0)
     {
@@ -232,7 +160,7 @@ void Tfm::Read()
     {
       pixelWidth = -static_cast<int>(conv * -tfmWidth + 0.5);
     }
-    dviChars[charCode]->SetWidth(pixelWidth);
+    dviChar->SetWidth(pixelWidth);
   }
 }
 
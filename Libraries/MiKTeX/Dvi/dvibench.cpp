@@ -0,0 +1,336 @@
+/* dvibench.cpp: times the rendering phases of the DVI library
+
+   Copyright (C) 2023 Christian Schenk
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.  */
+
+#include <cstdlib>
+
+#include <chrono>
+#include <iostream>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/App/Application>
+#include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/Text>
+#include <miktex/DVI/Dvi>
+#include <miktex/Util/StringUtil>
+#include <miktex/Wrappers/PoptWrapper>
+
+using namespace MiKTeX::App;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::DVI;
+using namespace MiKTeX::Util;
+using namespace MiKTeX::Wrappers;
+using namespace std;
+
+#define T_(x) MIKTEXTEXT(x)
+
+enum {
+  OPT_AAA = 1234,
+  OPT_MODE,
+  OPT_PAGE_MODE,
+  OPT_PGM_DIRECTORY,
+  OPT_RESOLUTION,
+  OPT_SHRINK_FACTOR,
+  OPT_TRACE
+};
+
+static const struct poptOption long_options[] = {
+  {
+    "mode", 0, POPT_ARG_STRING, nullptr, OPT_MODE, "Sets the METAFONT mode.", "MODE"
+  },
+  {
+    "page-mode", 0, POPT_ARG_STRING, nullptr, OPT_PAGE_MODE, "Sets the DVI page mode.", "PAGEMODE"
+  },
+  {
+    "pgm-directory", 0, POPT_ARG_STRING, nullptr, OPT_PGM_DIRECTORY, "Writes the rendered pages as PGM files into DIR.", "DIR"
+  },
+  {
+    "resolution", 0, POPT_ARG_STRING, nullptr, OPT_RESOLUTION, "Sets the resolution (in dots per inch).", "DPI"
+  },
+  {
+    "shrink-factor", 0, POPT_ARG_STRING, nullptr, OPT_SHRINK_FACTOR, "Sets the shrink factor.", "N"
+  },
+  {
+    "trace", 0, POPT_ARG_STRING, nullptr, OPT_TRACE, "Turn on tracing.", "TRACESTREAMS"
+  },
+  POPT_AUTOHELP
+  POPT_TABLEEND
+};
+
+// the time spent in the phases of rendering a DVI file
+struct Timings
+{
+  chrono::steady_clock::duration scan = chrono::steady_clock::duration::zero();
+  chrono::steady_clock::duration fonts = chrono::steady_clock::duration::zero();
+  chrono::steady_clock::duration raster = chrono::steady_clock::duration::zero();
+  chrono::steady_clock::duration shrink = chrono::steady_clock::duration::zero();
+  int pages = 0;
+
+  Timings& operator+=(const Timings& other)
+  {
+    scan += other.scan;
+    fonts += other.fonts;
+    raster += other.raster;
+    shrink += other.shrink;
+    pages += other.pages;
+    return *this;
+  }
+};
+
+class DviBench :
+  public Application
+{
+public:
+  void Run(int argc, const char** argv);
+
+private:
+  vector<PathName> CollectDviFiles(const vector<string>& arguments);
+
+private:
+  Timings Bench(const PathName& dviFileName);
+
+private:
+  void Report(const string& name, const Timings& timings);
+
+private:
+  string metafontMode = "ljfour";
+
+private:
+  int resolution = 600;
+
+private:
+  int shrinkFactor = 5;
+
+private:
+  DviPageMode pageMode = DviPageMode::Pk;
+
+private:
+  PathName pgmDirectory;
+
+private:
+  shared_ptr<Session> session;
+};
+
+// arguments are DVI files or directories containing DVI files
+vector<PathName> DviBench::CollectDviFiles(const vector<string>& arguments)
+{
+  vector<PathName> result;
+  for (const string& argument : arguments)
+  {
+    PathName path(argument);
+    if (!Directory::Exists(path))
+    {
+      result.push_back(path);
+      continue;
+    }
+    unique_ptr<DirectoryLister> lister = DirectoryLister::Open(path, "*.dvi", static_cast<int>(DirectoryLister::Options::FilesOnly));
+    DirectoryEntry entry;
+    while (lister->GetNext(entry))
+    {
+      result.push_back(path / PathName(entry.name));
+    }
+    lister->Close();
+  }
+  return result;
+}
+
+Timings DviBench::Bench(const PathName& dviFileName)
+{
+  Timings timings;
+  auto start = chrono::steady_clock::now();
+  auto stop = [&start]()
+  {
+    auto now = chrono::steady_clock::now();
+    auto duration = now - start;
+    start = now;
+    return duration;
+  };
+  unique_ptr<Dvi> dvi(Dvi::Create(dviFileName.GetData(), metafontMode.c_str(), resolution, shrinkFactor, DviAccess::Sequential, pageMode, session->GetPaperSizeInfo("A4size"), false, nullptr, nullptr));
+  dvi->Scan();
+  timings.scan += stop();
+  dvi->MakeFonts();
+  timings.fonts += stop();
+  for (int pageIdx = 0; pageIdx < dvi->GetNumberOfPages(); ++pageIdx)
+  {
+    DviPage* dviPage = dvi->GetLoadedPage(pageIdx);
+    if (dviPage == nullptr)
+    {
+      break;
+    }
+    AutoUnlockPage autoUnlockPage(dviPage);
+    if (pageMode == DviPageMode::Dvips)
+    {
+      // Ghostscript rasterizes at the final resolution
+      dviPage->GetNumberOfDibChunks(shrinkFactor);
+      timings.raster += stop();
+    }
+    else
+    {
+      dviPage->GetNumberOfDviBitmaps(1);
+      timings.raster += stop();
+      dviPage->GetNumberOfDviBitmaps(shrinkFactor);
+      timings.shrink += stop();
+    }
+    autoUnlockPage.Reset();
+    timings.pages += 1;
+    if (!pgmDirectory.Empty())
+    {
+      // not timed
+      DviGrayMap grayMap = dvi->RenderPage(pageIdx, shrinkFactor);
+      string pgm = Dvi::MakePgm(grayMap);
+      PathName pgmFileName = pgmDirectory / PathName(fmt::format("{0}-{1}.pgm", dviFileName.GetFileNameWithoutExtension().ToString(), pageIdx + 1));
+      FileStream stream(File::Open(pgmFileName, FileMode::Create, FileAccess::Write, false));
+      stream.Write(pgm.data(), pgm.length());
+      stream.Close();
+      stop();
+    }
+  }
+  dvi->Dispose();
+  dvi = nullptr;
+  return timings;
+}
+
+void DviBench::Report(const string& name, const Timings& timings)
+{
+  auto ms = [](chrono::steady_clock::duration duration)
+  {
+    return chrono::duration_cast<chrono::milliseconds>(duration).count();
+  };
+  cout << fmt::format("{0:<40} {1:>6} {2:>9} {3:>9} {4:>9} {5:>9}", name, timings.pages, ms(timings.scan), ms(timings.fonts), ms(timings.raster), ms(timings.shrink)) << endl;
+}
+
+void DviBench::Run(int argc, const char** argv)
+{
+  Session::InitInfo initInfo(argv[0]);
+
+  PoptWrapper popt(argc, argv, long_options);
+
+  popt.SetOtherOptionHelp(T_("[OPTION...] DVIFILE|DIR..."));
+
+  int option;
+
+  while ((option = popt.GetNextOpt()) >= 0)
+  {
+    string optArg = popt.GetOptArg();
+    switch (option)
+    {
+    case OPT_MODE:
+      metafontMode = optArg;
+      break;
+    case OPT_PAGE_MODE:
+      if (optArg == "pk")
+      {
+        pageMode = DviPageMode::Pk;
+      }
+      else if (optArg == "dvips")
+      {
+        pageMode = DviPageMode::Dvips;
+      }
+      else
+      {
+        throw T_("invalid page mode");
+      }
+      break;
+    case OPT_PGM_DIRECTORY:
+      pgmDirectory = optArg;
+      break;
+    case OPT_RESOLUTION:
+      resolution = std::stoi(optArg);
+      break;
+    case OPT_SHRINK_FACTOR:
+      shrinkFactor = std::stoi(optArg);
+      if (shrinkFactor < 1)
+      {
+        throw T_("invalid shrink factor");
+      }
+      break;
+    case OPT_TRACE:
+      initInfo.SetTraceFlags(optArg);
+      break;
+    }
+  }
+
+  if (option < -1)
+  {
+    cerr << popt.BadOption(POPT_BADOPTION_NOALIAS) << ": " << popt.Strerror(option) << endl;
+    throw 1;
+  }
+
+  vector<string> leftovers = popt.GetLeftovers();
+
+  if (leftovers.empty())
+  {
+    cerr << "missing file name argument" << endl;
+    throw 1;
+  }
+
+  Init(initInfo);
+  session = GetSession();
+
+  if (!pgmDirectory.Empty())
+  {
+    Directory::Create(pgmDirectory);
+  }
+
+  cout << fmt::format("{0:<40} {1:>6} {2:>9} {3:>9} {4:>9} {5:>9}", "file", "pages", "scan/ms", "fonts/ms", "raster/ms", "shrink/ms") << endl;
+
+  Timings total;
+  for (const PathName& dviFileName : CollectDviFiles(leftovers))
+  {
+    Timings timings = Bench(dviFileName);
+    Report(dviFileName.GetFileName().ToString(), timings);
+    total += timings;
+  }
+  Report("total", total);
+
+  Finalize();
+}
+
+int main(int argc, const char** argv)
+
+{
+  try
+  {
+    DviBench app;
+    app.Run(argc, argv);
+    return 0;
+  }
+  catch (const MiKTeXException& e)
+  {
+    Utils::PrintException(e);
+    return 1;
+  }
+  catch (const exception& e)
+  {
+    Utils::PrintException(e);
+    return 1;
+  }
+  catch (const char* message)
+  {
+    cerr << "fatal error: " << message << endl;
+    return 1;
+  }
+  catch (int retCode)
+  {
+    return retCode;
+  }
+}
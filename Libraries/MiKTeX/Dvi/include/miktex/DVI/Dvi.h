@@ -551,6 +551,17 @@ public:
   int y = 0;
 };
 
+/// A page rendered into an 8-bit gray map.
+struct DviGrayMap
+{
+  /// The width (in pixels).
+  int width = 0;
+  /// The height (in pixels).
+  int height = 0;
+  /// The gray values (`0` is black, `255` is white), top row first.
+  std::vector<unsigned char> pixels;
+};
+
 class MIKTEXNOVTABLE Dvi
 {
 public:
@@ -624,6 +635,37 @@ public:
 
 public:
   virtual void MIKTEXTHISCALL Scan() = 0;
+
+  /// Renders a page without a display: the page is loaded, and its
+  /// bitmaps and rules are drawn onto the paper.  Colors are drawn as
+  /// black.
+  /// @param pageIdx The page index.
+  /// @param shrinkFactor The shrink factor.
+  /// @return Returns the rendered page.
+public:
+  virtual DviGrayMap MIKTEXTHISCALL RenderPage(int pageIdx, int shrinkFactor) = 0;
+
+  /// Sets the shrink factor at which the page loader threads rasterize
+  /// pages in the background.
+  /// @param shrinkFactor The shrink factor.
+public:
+  virtual void MIKTEXTHISCALL SetPreferredShrinkFactor(int shrinkFactor) = 0;
+
+  /// Tests whether a page is still being rasterized in the background.
+  /// If the page has not been rasterized yet, a page loader thread is
+  /// asked to do it next.  This function does not block.
+  /// @param pageIdx The page index.
+  /// @param shrinkFactor The shrink factor.
+  /// @return Returns `true`, if the page is not ready yet.  Returns
+  /// `false`, if there are no page loader threads.
+public:
+  virtual bool MIKTEXTHISCALL IsPagePending(int pageIdx, int shrinkFactor) = 0;
+
+  /// Encodes a gray map as a binary PGM image (Netpbm format P5).
+  /// @param grayMap The gray map.
+  /// @return Returns the PGM image.
+public:
+  static MIKTEXDVICEEAPI(std::string) MakePgm(const DviGrayMap& grayMap);
 };
 
 class UnlockDviPage_
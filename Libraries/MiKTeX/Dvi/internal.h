@@ -20,7 +20,11 @@
    USA.  */
 
 #include <atomic>
+#include <future>
+#include <list>
+#include <map>
 #include <mutex>
+#include <set>
 #include <stack>
 
 #include <fmt/format.h>
@@ -29,6 +33,7 @@
 #include <miktex/Core/BufferSizes>
 #include <miktex/Core/Debug>
 #include <miktex/Core/FileStream>
+#include <miktex/Core/MD5>
 #include <miktex/Core/Quoter>
 #include <miktex/Core/TemporaryFile>
 #include <miktex/Core/Utils>
@@ -250,10 +255,16 @@ typedef unordered_map<string, unique_ptr<TemporaryFile> > TempFileCollection;
 
 typedef unordered_map<int, vector<shared_ptr<GraphicsInclusion> > > MAPNUMTOGRINCVEC;
 
+typedef multimap<MD5, class DviPageImpl*> PageDigestMap;
+
+typedef unordered_map<int, string> FontDefinitionMap;
+
 #include "Dib.h"
 #include "DviChar.h"
 #include "DviFont.h"
 #include "Ghostscript.h"
+#include "GhostscriptPool.h"
+#include "GlyphCache.h"
 #include "PkChar.h"
 #include "PkFont.h"
 #include "PostScript.h"
@@ -656,6 +667,9 @@ public:
 public:
   void MIKTEXTHISCALL Unlock() override;
 
+public:
+  bool TryLock();
+
 public:
   HypertexSpecial* MIKTEXTHISCALL GetNextHyperref(int& idx) override;
 
@@ -704,6 +718,14 @@ public:
     return nLocks > 0;
   }
 
+public:
+  bool HasShrinkedRaster(int shrinkFactor)
+  {
+    MIKTEX_ASSERT(IsLocked());
+    MAPNUMTOBOOL::const_iterator it = haveShrinkedRaster.find(shrinkFactor);
+    return it != haveShrinkedRaster.end() && it->second;
+  }
+
 public:
   size_t GetSize()
   {
@@ -767,10 +789,13 @@ private:
   void MakeDviBitmaps(int shrinkFactor);
 
 private:
-  void ProcessBand(int shrinkFactor, vector<DviItem*>& vecDviItemPtr);
+  void ProcessBands(int shrinkFactor, vector<vector<DviItem*>>& bands);
+
+private:
+  void ProcessBand(int shrinkFactor, vector<DviItem*>& vecDviItemPtr, vector<DviBitmap>& bitmaps);
 
 private:
-  void MakeDviBitmap(int shrinkFactor, DviBitmap& bitmap, vector<DviItem*>::iterator ititemptrBegin, vector<DviItem*>::iterator ititemptrEnd);
+  void MakeDviBitmap(int shrinkFactor, DviBitmap& bitmap, vector<DviItem*>::iterator ititemptrBegin, vector<DviItem*>::iterator ititemptrEnd, vector<DviBitmap>& bitmaps);
 
 private:
   void CheckRules();
@@ -790,6 +815,9 @@ private:
 private:
   void DvipsTranscriptReader();
 
+private:
+  void CopyDvipsOutput();
+
 private:
   void GhostscriptTranscriptReader();
 
@@ -808,6 +836,9 @@ private:
     return readPosition;
   }
 
+private:
+  void Relocate(int pageIdx, long readPosition);
+
 private:
   inline int PixelShrink(int shrinkFactor, int pxl); // FIXME
 
@@ -844,6 +875,14 @@ private:
 private:
   int pageIdx;
 
+  // digest of the page contents within the DVI file
+private:
+  MD5 digest;
+
+  // true, if the page could not be loaded completely
+private:
+  bool incomplete = false;
+
   // item vector
 private:
   vector<DviItem> dviItems;
@@ -913,14 +952,18 @@ private:
 private:
   FileStream dvipsErr;
 
+private:
+  FileStream gsIn;
+
 private:
   FileStream gsOut;
 
 private:
   FileStream gsErr;
 
+  // pages are rasterized by several threads
 private:
-  static size_t totalSize;
+  static atomic<size_t> totalSize;
 
 private:
   friend DviImpl; // FIXME
@@ -1001,6 +1044,15 @@ public:
 public:
   void MIKTEXTHISCALL Scan() override;
 
+public:
+  DviGrayMap MIKTEXTHISCALL RenderPage(int pageIdx, int shrinkFactor) override;
+
+public:
+  void MIKTEXTHISCALL SetPreferredShrinkFactor(int shrinkFactor) override;
+
+public:
+  bool MIKTEXTHISCALL IsPagePending(int pageIdx, int shrinkFactor) override;
+
 private:
   DviImpl(const char* fileName, const char* metafontMode, int resolution, int shrinkFactor, DviAccess access, DviPageMode pageMode, const PaperSizeInfo& paperSizeInfo, bool landscape, IDviCallback* dviCallback, TraceCallback* traceCallback);
 
@@ -1153,7 +1205,31 @@ private:
   int PixelRound(int du); // FIXME
 
 private:
-  void DefineFont(InputStream& inputstream, int fontnum);
+  void Scan(PageDigestMap& previousPages);
+
+private:
+  long FindPostamble(InputStream& inputStream, long firstPagePosition, long fileLength);
+
+private:
+  bool ScanBackward(InputStream& inputStream, long postamblePosition, PageDigestMap& previousPages);
+
+private:
+  bool ScanForward(InputStream& inputStream, long firstPagePosition, long fileLength, PageDigestMap& previousPages);
+
+private:
+  long FindEndOfPage(InputStream& inputStream, long fileLength, vector<long>& fontDefinitions);
+
+private:
+  DviPageImpl* MakePage(InputStream& inputStream, int pageIdx, long bopPosition, long endPosition, const int counts[10], PageDigestMap& previousPages);
+
+private:
+  MD5 GetPageDigest(InputStream& inputStream, long bopPosition, long endPosition);
+
+private:
+  void DeletePages(PageDigestMap& pageMap);
+
+private:
+  bool DefineFont(InputStream& inputstream, int fontnum);
 
 private:
   void DoPage(int pageidx);
@@ -1201,13 +1277,16 @@ private:
   void PageLoader();
 
 private:
-  shared_ptr<Session> session = MIKTEX_SESSION();
+  int NextPageToLoad();
+
+public:
+  bool IsPageLoaderThread();
 
 private:
-  HANDLE hByeByeEvent;
+  shared_ptr<Session> session = MIKTEX_SESSION();
 
 private:
-  HANDLE hNewPageEvent;
+  HANDLE hByeByeEvent;
 
 private:
   HANDLE hScannedEvent;
@@ -1218,6 +1297,11 @@ private:
 private:
   int direction = 1;
 
+  // pages which are displayed but not rasterized yet: page loaders take
+  // them first
+private:
+  set<int> requestedPages;
+
 private:
   DviPageMode pageMode;
 
@@ -1239,8 +1323,9 @@ private:
 private:
   thread garbageCollectorThread;
 
+  // render the pages ahead of the current page in parallel
 private:
-  thread pageLoaderThread;
+  vector<thread> pageLoaderThreads;
 
   // resolution in dots per inch
 private:
@@ -1268,11 +1353,11 @@ private:
 
   // stated conversion ratio
 private:
-  int numerator, denominator;
+  int numerator = 0, denominator = 0;
 
   // magnification factor times 1000
 private:
-  int mag;
+  int mag = 0;
 
   // the value of abs(v) should probably not exceed this
 private:
@@ -1339,6 +1424,18 @@ private:
 private:
   clock_t lastChecked = 0;
 
+  // the font definitions read so far (by font number)
+private:
+  FontDefinitionMap fontDefinitions;
+
+  // true, if the DVI file has no postamble (yet)
+private:
+  bool following = false;
+
+  // the size of the followed DVI file when it was scanned
+private:
+  size_t followedFileSize = 0;
+
 private:
   bool hasDviFileChanged = false;
 
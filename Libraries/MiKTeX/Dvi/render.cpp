@@ -0,0 +1,149 @@
+/* render.cpp: headless page rendering
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX DVI Library.
+
+   The MiKTeX DVI Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2, or (at your option) any later version.
+
+   The MiKTeX DVI Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with the MiKTeX DVI Library; if not, write to the
+   Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139,
+   USA.  */
+
+#include "config.h"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include "internal.h"
+
+namespace
+{
+  // darkens a pixel; pixels outside of the paper are ignored
+  inline void Darken(DviGrayMap& grayMap, int x, int y, unsigned char gray)
+  {
+    if (x < 0 || y < 0 || x >= grayMap.width || y >= grayMap.height)
+    {
+      return;
+    }
+    unsigned char& pixel = grayMap.pixels[static_cast<size_t>(y) * grayMap.width + x];
+    pixel = std::min(pixel, gray);
+  }
+
+  // DVI bitmaps are bottom-up; at shrink factor 1 they have one bit per
+  // pixel, otherwise four bits (16 levels of ink coverage)
+  void DrawBitmap(DviGrayMap& grayMap, const DviBitmap& bitmap, int bitsPerPixel)
+  {
+    const BYTE* pixels = reinterpret_cast<const BYTE*>(bitmap.pixels);
+    int maxValue = (1 << bitsPerPixel) - 1;
+    for (int row = 0; row < bitmap.height; ++row)
+    {
+      const BYTE* line = pixels + static_cast<size_t>(bitmap.height - 1 - row) * bitmap.bytesPerLine;
+      for (int column = 0; column < bitmap.width; ++column)
+      {
+        int bitOffset = column * bitsPerPixel;
+        int value = (line[bitOffset / 8] >> (8 - bitsPerPixel - bitOffset % 8)) & maxValue;
+        if (value != 0)
+        {
+          Darken(grayMap, bitmap.x + column, bitmap.y + row, static_cast<unsigned char>(255 - (value * 255) / maxValue));
+        }
+      }
+    }
+  }
+
+  // DIB chunks (made by Ghostscript) are bottom-up with 24 bits per pixel
+  void DrawDibChunk(DviGrayMap& grayMap, const DibChunk& dibChunk)
+  {
+    const BITMAPINFOHEADER& header = dibChunk.GetBitmapInfo()->bmiHeader;
+    if (header.biBitCount != 24)
+    {
+      MIKTEX_UNEXPECTED();
+    }
+    int width = header.biWidth;
+    int height = header.biHeight;
+    size_t bytesPerLine = ((width * 24 + 31) & ~31) >> 3;
+    const BYTE* bits = reinterpret_cast<const BYTE*>(dibChunk.GetBits());
+    for (int row = 0; row < height; ++row)
+    {
+      const BYTE* line = bits + static_cast<size_t>(height - 1 - row) * bytesPerLine;
+      for (int column = 0; column < width; ++column)
+      {
+        const BYTE* bgr = line + column * 3;
+        int gray = (bgr[2] * 30 + bgr[1] * 59 + bgr[0] * 11) / 100;
+        Darken(grayMap, dibChunk.GetX() + column, dibChunk.GetY() + row, static_cast<unsigned char>(gray));
+      }
+    }
+  }
+}
+
+DviGrayMap DviImpl::RenderPage(int pageIdx, int shrinkFactor)
+{
+  DviPage* dviPage = GetLoadedPage(pageIdx);
+  if (dviPage == nullptr)
+  {
+    throw DviPageNotFoundException("", T_("The DVI page could not be found."), MiKTeXException::KVMAP(), MIKTEX_SOURCE_LOCATION());
+  }
+  AutoUnlockPage autoUnlockPage(dviPage);
+
+  // the paper, as in Ghostscript::Start()
+  int width = paperSizeInfo.width;
+  int height = paperSizeInfo.height;
+  if (landscape)
+  {
+    swap(width, height);
+  }
+  DviGrayMap grayMap;
+  grayMap.width = static_cast<int>(((resolution * width) / 72.0) / shrinkFactor);
+  grayMap.height = static_cast<int>(((resolution * height) / 72.0) / shrinkFactor);
+  grayMap.pixels.assign(static_cast<size_t>(grayMap.width) * grayMap.height, 255);
+
+  if (dviPage->GetDviPageMode() == DviPageMode::Dvips)
+  {
+    int nChunks = dviPage->GetNumberOfDibChunks(shrinkFactor);
+    for (int idx = 0; idx < nChunks; ++idx)
+    {
+      DrawDibChunk(grayMap, *dviPage->GetDibChunk(shrinkFactor, idx));
+    }
+    return grayMap;
+  }
+
+  int nBitmaps = dviPage->GetNumberOfDviBitmaps(shrinkFactor);
+  for (int idx = 0; idx < nBitmaps; ++idx)
+  {
+    DrawBitmap(grayMap, dviPage->GetDviBitmap(shrinkFactor, idx), GetBitsPerPixel(shrinkFactor));
+  }
+
+  DviRule* rule;
+  for (int idx = 0; (rule = dviPage->GetRule(idx)) != nullptr; ++idx)
+  {
+    if (rule->IsBlackboard())
+    {
+      continue;
+    }
+    for (int y = rule->GetTop(shrinkFactor); y <= rule->GetBottom(shrinkFactor); ++y)
+    {
+      for (int x = rule->GetLeft(shrinkFactor); x <= rule->GetRight(shrinkFactor); ++x)
+      {
+        Darken(grayMap, x, y, 0);
+      }
+    }
+  }
+
+  return grayMap;
+}
+
+string Dvi::MakePgm(const DviGrayMap& grayMap)
+{
+  string pgm = fmt::format("P5\n{0} {1}\n255\n", grayMap.width, grayMap.height);
+  pgm.append(reinterpret_cast<const char*>(grayMap.pixels.data()), grayMap.pixels.size());
+  return pgm;
+}
@@ -27,6 +27,14 @@
 
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -45,6 +53,15 @@ using namespace MiKTeX::Extractor;
 using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
 
+// upper limit for the number of threads decoding cabinet folders
+const unsigned MAX_EXTRACT_THREADS = 4;
+
+// size of the input buffer used by the decompressor
+const int DECOMPRESSION_BUFFER_SIZE = 64 * 1024;
+
+// size of the stdio buffer for extracted files
+const size_t WRITE_BUFFER_SIZE = 256 * 1024;
+
 struct mspack_file* CabExtractor::Open(struct mspack_system* self, const char* fileName, int mode)
 {
   UNUSED_ALWAYS(self);
@@ -79,6 +96,11 @@ struct mspack_file* CabExtractor::Open(struct mspack_system* self, const char* f
     try
     {
       myFile->stdioFile = File::Open(PathName(fileName), fileMode, fileAccess, false);
+      if (fileAccess == FileAccess::Write)
+      {
+        // the decompressor writes small frames: collect them
+        setvbuf(myFile->stdioFile, nullptr, _IOFBF, WRITE_BUFFER_SIZE);
+      }
     }
     catch (const exception&)
     {
@@ -246,11 +268,18 @@ CabExtractor::CabExtractor() :
   mspackSystem.free = Free;
   mspackSystem.copy = Copy;
   mspackSystem.null_ptr = nullptr;
-  decompressor = mspack_create_cab_decompressor(&mspackSystem);
-  if (decompressor == nullptr)
+  decompressor = CreateDecompressor();
+}
+
+mscab_decompressor* CabExtractor::CreateDecompressor()
+{
+  mscab_decompressor* result = mspack_create_cab_decompressor(&mspackSystem);
+  if (result == nullptr)
   {
     MIKTEX_UNEXPECTED();
   }
+  result->set_param(result, MSCABD_PARAM_DECOMPBUF, DECOMPRESSION_BUFFER_SIZE);
+  return result;
 }
 
 CabExtractor::~CabExtractor()
@@ -326,6 +355,34 @@ static void SetAttributes(const PathName& path, int cabattr)
   File::SetNativeAttributes(path, nativeAttributes);
 }
 
+static void ExtractMember(mscab_decompressor* decompressor, mscabd_file* cabFile, const PathName& cabinetPath, const PathName& path)
+{
+  int r = decompressor->extract(decompressor, cabFile, const_cast<char*>(path.GetData()));
+  if (r != MSPACK_ERR_OK)
+  {
+    MIKTEX_FATAL_ERROR_2(T_("The member could not bex extracted from the cabinet file."), "cabinetPath", cabinetPath.ToString(), "member", cabFile->filename, "ret", std::to_string(r));
+  }
+
+  // set time when the file was created
+  struct tm tm;
+  tm.tm_sec = cabFile->time_s;
+  tm.tm_min = cabFile->time_m;
+  tm.tm_hour = cabFile->time_h;
+  tm.tm_mday = cabFile->date_d;
+  tm.tm_mon = cabFile->date_m - 1;
+  tm.tm_year = cabFile->date_y - 1900;
+  tm.tm_isdst = 0;
+  time_t time = mktime(&tm);
+  if (time == static_cast<time_t>(-1))
+  {
+    MIKTEX_FATAL_CRT_ERROR("mktime");
+  }
+  File::SetTimes(path, time, time, time);
+
+  // set file attributes
+  SetAttributes(path, cabFile->attribs);
+}
+
 void CabExtractor::Extract(const PathName& cabinetPath, const PathName& destDir, bool makeDirectories, IExtractCallback* callback, const string& prefix)
 {
   unique_ptr<StopWatch> stopWatch = StopWatch::Start(traceStopWatch.get(), TRACE_FACILITY, cabinetPath.GetFileName().ToString());
@@ -342,9 +399,15 @@ void CabExtractor::Extract(const PathName& cabinetPath, const PathName& destDir,
       MIKTEX_FATAL_ERROR_2(T_("The cabinet file could not be opened."), "path", cabinetPath.ToString());
     }
 
+    unordered_map<mscabd_folder*, unsigned> folderIndex;
+    for (mscabd_folder* folder = cabinet->folders; folder != nullptr; folder = folder->next)
+    {
+      folderIndex[folder] = static_cast<unsigned>(folderIndex.size());
+    }
+
     size_t prefixLen = prefix.length();
 
-    unsigned fileCount = 0;
+    vector<Member> members;
 
     for (mscabd_file* cabFile = cabinet->files; cabFile != nullptr; cabFile = cabFile->next)
     {
@@ -369,12 +432,6 @@ void CabExtractor::Extract(const PathName& cabinetPath, const PathName& destDir,
       }
       path /= dest;
 
-      // notify the client
-      if (callback != nullptr)
-      {
-        callback->OnBeginFileExtraction(path.ToString(), cabFile->length);
-      }
-
       // create the destination directory
       Directory::Create(PathName(path).RemoveFileSpec());
 
@@ -384,54 +441,168 @@ void CabExtractor::Extract(const PathName& cabinetPath, const PathName& destDir,
         File::Delete(path, { FileDeleteOption::TryHard });
       }
 
-      // extract the file
-      int r = decompressor->extract(decompressor, cabFile, path.GetData());
-      if (r != MSPACK_ERR_OK)
+      members.push_back({ path, cabFile->length, folderIndex[cabFile->folder] });
+    }
+
+    unsigned numThreads = std::min({ std::max(thread::hardware_concurrency(), 1u), MAX_EXTRACT_THREADS, static_cast<unsigned>(folderIndex.size()) });
+
+    if (numThreads > 1)
+    {
+      // folders are compressed independently: decode them in parallel
+      decompressor->close(decompressor, cabinet);
+      cabinet = nullptr;
+      ExtractFolders(cabinetPath, members, numThreads, callback);
+    }
+    else
+    {
+      size_t idx = 0;
+      for (mscabd_file* cabFile = cabinet->files; cabFile != nullptr; cabFile = cabFile->next, ++idx)
       {
-         MIKTEX_FATAL_ERROR_2(T_("The member could not bex extracted from the cabinet file."), "cabinetPath", cabinetPath.ToString(), "member", cabFile->filename, "ret", std::to_string(r));
+        const Member& member = members[idx];
+
+        // notify the client
+        if (callback != nullptr)
+        {
+          callback->OnBeginFileExtraction(member.path.ToString(), member.length);
+        }
+
+        // extract the file
+        ExtractMember(decompressor, cabFile, cabinetPath, member.path);
+
+        // notify the client
+        if (callback != nullptr)
+        {
+          callback->OnEndFileExtraction("", member.length);
+        }
       }
+      decompressor->close(decompressor, cabinet);
+      cabinet = nullptr;
+    }
 
-      fileCount += 1;
-
-      // set time when the file was created
-      struct tm tm;
-      tm.tm_sec = cabFile->time_s;
-      tm.tm_min = cabFile->time_m;
-      tm.tm_hour = cabFile->time_h;
-      tm.tm_mday = cabFile->date_d;
-      tm.tm_mon = cabFile->date_m - 1;
-      tm.tm_year = cabFile->date_y - 1900;
-      tm.tm_isdst = 0;
-      time_t time = mktime(&tm);
-      if (time == static_cast<time_t>(-1))
+    traceStream->WriteLine(TRACE_FACILITY, fmt::format(T_("extracted {0} file(s)"), members.size()));
+  }
+  catch (const exception&)
+  {
+    if (cabinet != nullptr)
+    {
+      decompressor->close(decompressor, cabinet);
+    }
+    throw;
+  }
+}
+
+void CabExtractor::ExtractFolders(const PathName& cabinetPath, const vector<Member>& members, unsigned numThreads, IExtractCallback* callback)
+{
+  mutex mtx;
+  condition_variable extractedCondition;
+  queue<size_t> extracted;
+  unsigned runningThreads = numThreads;
+  bool stopping = false;
+  exception_ptr error;
+
+  // each thread has its own decompressor and takes every numThreads-th folder
+  vector<thread> threads;
+  for (unsigned threadIdx = 0; threadIdx < numThreads; ++threadIdx)
+  {
+    threads.emplace_back([&, threadIdx]()
+    {
+      mscab_decompressor* threadDecompressor = nullptr;
+      mscabd_cabinet* cabinet = nullptr;
+      try
       {
-        MIKTEX_FATAL_CRT_ERROR("mktime");
+        threadDecompressor = CreateDecompressor();
+        cabinet = threadDecompressor->open(threadDecompressor, const_cast<char*>(cabinetPath.GetData()));
+        if (cabinet == nullptr)
+        {
+          MIKTEX_FATAL_ERROR_2(T_("The cabinet file could not be opened."), "path", cabinetPath.ToString());
+        }
+        size_t idx = 0;
+        for (mscabd_file* cabFile = cabinet->files; cabFile != nullptr && idx < members.size(); cabFile = cabFile->next, ++idx)
+        {
+          if (members[idx].folder % numThreads != threadIdx)
+          {
+            continue;
+          }
+          {
+            lock_guard<mutex> lock(mtx);
+            if (stopping)
+            {
+              break;
+            }
+          }
+          ExtractMember(threadDecompressor, cabFile, cabinetPath, members[idx].path);
+          {
+            lock_guard<mutex> lock(mtx);
+            extracted.push(idx);
+          }
+          extractedCondition.notify_one();
+        }
       }
-      File::SetTimes(path, time, time, time);
-
-      // set file attributes
-      SetAttributes(path, cabFile->attribs);
+      catch (const exception&)
+      {
+        lock_guard<mutex> lock(mtx);
+        if (error == nullptr)
+        {
+          error = current_exception();
+        }
+        stopping = true;
+      }
+      if (cabinet != nullptr)
+      {
+        threadDecompressor->close(threadDecompressor, cabinet);
+      }
+      if (threadDecompressor != nullptr)
+      {
+        mspack_destroy_cab_decompressor(threadDecompressor);
+      }
+      {
+        lock_guard<mutex> lock(mtx);
+        --runningThreads;
+      }
+      extractedCondition.notify_one();
+    });
+  }
 
-      // notify the client
+  // notify the client on the calling thread
+  try
+  {
+    unique_lock<mutex> lock(mtx);
+    while (true)
+    {
+      extractedCondition.wait(lock, [&]() { return !extracted.empty() || runningThreads == 0; });
+      if (extracted.empty())
+      {
+        break;
+      }
+      size_t idx = extracted.front();
+      extracted.pop();
       if (callback != nullptr)
       {
-        callback->OnEndFileExtraction("", cabFile->length);
+        lock.unlock();
+        callback->OnBeginFileExtraction(members[idx].path.ToString(), members[idx].length);
+        callback->OnEndFileExtraction("", members[idx].length);
+        lock.lock();
       }
     }
-
-    traceStream->WriteLine(TRACE_FACILITY, fmt::format(T_("extracted {0} file(s)"), fileCount));
-
-    decompressor->close(decompressor, cabinet);
-    cabinet = nullptr;
-
   }
   catch (const exception&)
   {
-    if (cabinet != nullptr)
+    lock_guard<mutex> lock(mtx);
+    if (error == nullptr)
     {
-      decompressor->close(decompressor, cabinet);
+      error = current_exception();
     }
-    throw;
+    stopping = true;
+  }
+
+  for (thread& t : threads)
+  {
+    t.join();
+  }
+
+  if (error != nullptr)
+  {
+    rethrow_exception(error);
   }
 }
 
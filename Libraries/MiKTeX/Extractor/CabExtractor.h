@@ -24,6 +24,9 @@
 #if !defined(AE5923232DF04F7888B2DD7F583253A4)
 #define AE5923232DF04F7888B2DD7F583253A4
 
+#include <string>
+#include <vector>
+
 #include <mspack.h>
 
 #include <miktex/Extractor/Extractor>
@@ -46,6 +49,20 @@ public:
 public:
   void MIKTEXTHISCALL Extract(MiKTeX::Core::Stream* stream, const MiKTeX::Util::PathName& destDir, bool makeDirectories, IExtractCallback* callback, const std::string& str) override;
 
+private:
+  struct Member
+  {
+    MiKTeX::Util::PathName path;
+    std::size_t length;
+    unsigned folder;
+  };
+
+private:
+  mscab_decompressor* CreateDecompressor();
+
+private:
+  void ExtractFolders(const MiKTeX::Util::PathName& cabinetPath, const std::vector<Member>& members, unsigned numThreads, IExtractCallback* callback);
+
 private:
   mscab_decompressor* decompressor = nullptr;
 
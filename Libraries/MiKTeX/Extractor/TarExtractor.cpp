@@ -1,6 +1,6 @@
 /* TarExtractor.cpp:
 
-   Copyright (C) 2001-2021 Christian Schenk
+   Copyright (C) 2001-2022 Christian Schenk
 
    This file is part of MiKTeX Extractor.
 
@@ -21,6 +21,8 @@
 
 #include "config.h"
 
+#include <algorithm>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -42,6 +44,13 @@ using namespace MiKTeX::Util;
 
 const size_t BLOCKSIZE = 512;
 
+// the tar stream is read in chunks of this size; headers, padding and
+// member data are then served from memory
+const size_t INPUT_BUFFER_SIZE = 1024 * 1024;
+
+// disk space is reserved in advance for members of at least this size
+const size_t PREALLOCATE_MIN_SIZE = 256 * 1024;
+
 struct Header
 {
 private:
@@ -265,11 +274,55 @@ private:
   char reserved[12];
 };
 
+bool TarExtractor::FillBuffer()
+{
+  inputBufferPos = 0;
+  inputBufferEnd = 0;
+  while (inputBufferEnd < inputBuffer.size())
+  {
+    size_t n = streamIn->Read(inputBuffer.data() + inputBufferEnd, inputBuffer.size() - inputBufferEnd);
+    if (n == 0)
+    {
+      break;
+    }
+    inputBufferEnd += n;
+  }
+  totalBytesRead += inputBufferEnd;
+  return inputBufferEnd > 0;
+}
+
+size_t TarExtractor::ReadAvailable(const unsigned char*& data, size_t maxBytes)
+{
+  if (inputBufferPos == inputBufferEnd && !FillBuffer())
+  {
+    return 0;
+  }
+  size_t n = std::min(maxBytes, inputBufferEnd - inputBufferPos);
+  data = inputBuffer.data() + inputBufferPos;
+  inputBufferPos += n;
+  return n;
+}
+
+size_t TarExtractor::Read(void* data, size_t numBytes)
+{
+  size_t bytesRead = 0;
+  while (bytesRead < numBytes)
+  {
+    const unsigned char* chunk;
+    size_t n = ReadAvailable(chunk, numBytes - bytesRead);
+    if (n == 0)
+    {
+      break;
+    }
+    memcpy(static_cast<unsigned char*>(data) + bytesRead, chunk, n);
+    bytesRead += n;
+  }
+  return bytesRead;
+}
+
 void TarExtractor::ReadBlock(void* data)
 {
-  size_t n = streamIn->Read(data, BLOCKSIZE);
-  totalBytesRead += n;
-  if (n != BLOCKSIZE)
+  if (Read(data, BLOCKSIZE) != BLOCKSIZE)
   {
     MIKTEX_UNEXPECTED();
   }
@@ -277,18 +330,16 @@ void TarExtractor::ReadBlock(void* data)
 
 void TarExtractor::Skip(size_t numBytes)
 {
-  const size_t BUFSIZE = 4096;
-  char buffer[BUFSIZE];
-  size_t bytesRead = 0;
-  while (bytesRead < numBytes)
+  size_t bytesSkipped = 0;
+  while (bytesSkipped < numBytes)
   {
-    size_t remaining = numBytes - bytesRead;
-    size_t n = (remaining > BUFSIZE ? BUFSIZE : remaining);
-    if (Read(buffer, n) != n)
+    const unsigned char* chunk;
+    size_t n = ReadAvailable(chunk, numBytes - bytesSkipped);
+    if (n == 0)
     {
       MIKTEX_UNEXPECTED();
     }
-    bytesRead += n;
+    bytesSkipped += n;
   }
 }
 
@@ -309,6 +360,9 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
   {
     streamIn = streamIn_;
     totalBytesRead = 0;
+    inputBuffer.resize(INPUT_BUFFER_SIZE);
+    inputBufferPos = 0;
+    inputBufferEnd = 0;
 
     traceStream->WriteLine(TRACE_FACILITY, fmt::format(T_("extracting to {0} ({1})"), Q_(destDir), (makeDirectories ? T_("make directories") : T_("don't make directories"))));
 
@@ -319,8 +373,7 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
 
     bool checkHeader = true;
 
-    CharBuffer<char> buffer;
-    buffer.Reserve(1024 * 1024);
+    PathName lastDirectory;
 
     while ((len = Read(&header, sizeof(header))) > 0)
     {
@@ -398,7 +451,12 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
       }
 
       // create the destination directory
-      Directory::Create(PathName(path).RemoveFileSpec());
+      PathName directory = PathName(path).RemoveFileSpec();
+      if (directory != lastDirectory)
+      {
+        Directory::Create(directory);
+        lastDirectory = directory;
+      }
 
       // remove the existing file
       if (File::Exists(path))
@@ -408,16 +466,21 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
 
       // extract the file
       FileStream streamOut(File::Open(path, FileMode::Create, FileAccess::Write, false));
+      if (size >= PREALLOCATE_MIN_SIZE)
+      {
+        File::Preallocate(streamOut.GetFile(), size);
+      }
+      // write straight from the input buffer
       size_t bytesRead = 0;
       while (bytesRead < size)
       {
-        size_t remaining = size - bytesRead;
-        size_t n = (remaining > buffer.GetCapacity() ? buffer.GetCapacity() : remaining);
-        if (Read(buffer.GetData(), n) != n)
+        const unsigned char* chunk;
+        size_t n = ReadAvailable(chunk, size - bytesRead);
+        if (n == 0)
         {
           MIKTEX_UNEXPECTED();
         }
-        streamOut.Write(buffer.GetData(), n);
+        streamOut.Write(chunk, n);
         bytesRead += n;
       }
       // set time when the file was created
@@ -1,6 +1,6 @@
 /* TarExtractor.h:                                      -*- C++ -*-
 
-   Copyright (C) 2001-2018 Christian Schenk
+   Copyright (C) 2001-2022 Christian Schenk
 
    This file is part of MiKTeX Extractor.
 
@@ -24,6 +24,8 @@
 #if !defined(BF702FE409EC4B9592640F4FD967F75B)
 #define BF702FE409EC4B9592640F4FD967F75B
 
+#include <vector>
+
 #include <miktex/Trace/TraceStream>
 
 #include "miktex/Extractor/Extractor"
@@ -45,12 +47,13 @@ public:
   void MIKTEXTHISCALL Extract(MiKTeX::Core::Stream* stream, const MiKTeX::Util::PathName& destDir, bool makeDirectories, IExtractCallback* callback, const std::string& prefix) override;
 
 protected:
-  size_t Read(void* data, size_t numBytes)
-  {
-    size_t n = streamIn->Read(data, numBytes);
-    totalBytesRead += n;
-    return n;
-  }
+  size_t Read(void* data, size_t numBytes);
+
+protected:
+  size_t ReadAvailable(const unsigned char*& data, size_t maxBytes);
+
+private:
+  bool FillBuffer();
 
 protected:
   void ReadBlock(void* data);
@@ -73,6 +76,15 @@ protected:
 protected:
   MiKTeX::Core::Stream* streamIn = nullptr;
 
+private:
+  std::vector<unsigned char> inputBuffer;
+
+private:
+  size_t inputBufferPos = 0;
+
+private:
+  size_t inputBufferEnd = 0;
+
 protected:
   void Skip(size_t bytes);
 
@@ -1111,6 +1111,30 @@ MIKTEXKPSCEEAPI(char*) miktex_kpse_program_basename(const char* argv0);
 MIKTEXKPSCEEAPI(char*) miktex_kpsemu_create_texmf_cnf();
 #endif
 
+/* Like kpathsea_find_file(), but the result is owned by the library
+   and must not be freed. Repeated queries for the same file name and
+   format are answered without a search and return the same pointer. */
+MIKTEXKPSCEEAPI(const char*) miktex_kpsemu_find_file_interned(kpathsea kpseInstance, const char* fileName, kpse_file_format_type format, int mustExist);
+
+/* Looks up count file names at once. results[i] is set to the interned
+   (not to be freed) path of fileNames[i], or to NULL, if the file was
+   not found. Returns the number of files found. */
+MIKTEXKPSCEEAPI(size_t) miktex_kpsemu_find_files(kpathsea kpseInstance, const char* const* fileNames, size_t count, kpse_file_format_type format, int mustExist, const char** results);
+
+/* Looks up a font in the index of a font map file. Returns 1, if the font
+   was found: *lines is set to the map lines (separated by newlines), which
+   the caller must free. Returns 0, if the font is not in the font map.
+   Returns -1, if the font map has no up-to-date index: the caller must
+   parse the font map file. */
+MIKTEXKPSCEEAPI(int) miktex_kpsemu_lookup_font_map(const char* mapFileName, const char* fontName, char** lines);
+
+/* Reduces an opened BibTeX database to the entries needed for the given
+   cite keys. Returns a temporary file with the reduced database, which
+   has the line numbers of the original; the caller closes bibFile and
+   reads the returned file instead. Returns NULL, if the database cannot
+   be reduced: bibFile is rewound. */
+MIKTEXKPSCEEAPI(FILE*) miktex_kpsemu_reduce_bib_database(FILE* bibFile, const char* const* citeKeys, size_t numCiteKeys);
+
 MIKTEXKPSCEEAPI(char*) miktex_find_suffix(const char* path);
 
 MIKTEXKPSCEEAPI(char*) miktex_read_line(FILE* file);
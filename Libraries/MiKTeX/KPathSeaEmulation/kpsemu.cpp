@@ -27,7 +27,10 @@
 
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #if defined(MIKTEX_UNIX)
 #include <sys/time.h>
@@ -62,6 +65,12 @@ using namespace MiKTeX;
 namespace {
   unsigned kpse_baseResolution = 600;
   std::string kpse_mode;
+
+  // interned find-file results (Unix notation); the strings live
+  // until the process terminates
+  std::mutex findFileCacheMutex;
+  std::unordered_set<std::string> internedFileNames;
+  std::unordered_map<std::string, const char*> findFileCache;
 }
 
 MIKTEXKPSDATA(const char*) miktex_kpathsea_bug_address = T_("Visit miktex.org for bug reports.");
@@ -243,11 +252,34 @@ MIKTEXSTATICFUNC(FileType) ToFileType(kpse_file_format_type format)
   return ft;
 }
 
-MIKTEXKPSCEEAPI(char*) miktex_kpathsea_find_file(kpathsea kpseInstance, const char* fileName, kpse_file_format_type format, int mustExist)
+MIKTEXSTATICFUNC(std::string) MakeFindFileCacheKey(const char* fileName, kpse_file_format_type format)
 {
-  MIKTEX_ASSERT(kpseInstance != nullptr);
-  MIKTEX_ASSERT(fileName != nullptr);
-  bool found = false;
+  std::string key = std::to_string(static_cast<int>(format));
+  key += ':';
+  key += fileName;
+  return key;
+}
+
+// "./foo.tex" depends on the current directory
+MIKTEXSTATICFUNC(bool) IsCacheable(const char* fileName)
+{
+  return !PathNameUtil::IsExplicitlyRelative(fileName);
+}
+
+MIKTEXSTATICFUNC(const char*) FindFileInterned(const char* fileName, kpse_file_format_type format, bool mustExist)
+{
+  bool cacheable = IsCacheable(fileName);
+  std::string key;
+  if (cacheable)
+  {
+    key = MakeFindFileCacheKey(fileName, format);
+    lock_guard<mutex> lockGuard(findFileCacheMutex);
+    auto it = findFileCache.find(key);
+    if (it != findFileCache.end())
+    {
+      return it->second;
+    }
+  }
   PathName result;
   shared_ptr<Session> session = MIKTEX_SESSION();
   FileType ft = ToFileType(format);
@@ -257,27 +289,80 @@ MIKTEXKPSCEEAPI(char*) miktex_kpathsea_find_file(kpathsea kpseInstance, const ch
     options += Session::FindFileOption::Create;
     options += Session::FindFileOption::SearchFileSystem;
   }
-  found = session->FindFile(fileName, ft, options, result);
-  if (!found)
+  // negative results are not cached: the file might get installed or
+  // created later on
+  if (!session->FindFile(fileName, ft, options, result))
   {
     return nullptr;
   }
   result.ConvertToUnix();
-  return xstrdup(result.GetData());
+  lock_guard<mutex> lockGuard(findFileCacheMutex);
+  // element references are stable, even if the table gets rehashed
+  const char* internedFileName = internedFileNames.insert(result.ToString()).first->c_str();
+  if (cacheable)
+  {
+    findFileCache[key] = internedFileName;
+  }
+  return internedFileName;
+}
+
+MIKTEXKPSCEEAPI(char*) miktex_kpathsea_find_file(kpathsea kpseInstance, const char* fileName, kpse_file_format_type format, int mustExist)
+{
+  MIKTEX_ASSERT(kpseInstance != nullptr);
+  MIKTEX_ASSERT(fileName != nullptr);
+  const char* result = FindFileInterned(fileName, format, mustExist != 0);
+  if (result == nullptr)
+  {
+    return nullptr;
+  }
+  return xstrdup(result);
+}
+
+MIKTEXKPSCEEAPI(const char*) miktex_kpsemu_find_file_interned(kpathsea kpseInstance, const char* fileName, kpse_file_format_type format, int mustExist)
+{
+  MIKTEX_ASSERT(kpseInstance != nullptr);
+  MIKTEX_ASSERT(fileName != nullptr);
+  return FindFileInterned(fileName, format, mustExist != 0);
+}
+
+MIKTEXKPSCEEAPI(size_t) miktex_kpsemu_find_files(kpathsea kpseInstance, const char* const* fileNames, size_t count, kpse_file_format_type format, int mustExist, const char** results)
+{
+  MIKTEX_ASSERT(kpseInstance != nullptr);
+  MIKTEX_ASSERT(count == 0 || (fileNames != nullptr && results != nullptr));
+  size_t found = 0;
+  for (size_t idx = 0; idx < count; ++idx)
+  {
+    MIKTEX_ASSERT(fileNames[idx] != nullptr);
+    results[idx] = FindFileInterned(fileNames[idx], format, mustExist != 0);
+    if (results[idx] != nullptr)
+    {
+      ++found;
+    }
+  }
+  return found;
 }
 
 MIKTEXKPSCEEAPI(char**) miktex_kpathsea_find_file_generic(kpathsea kpseInstance, const char* fileName, kpse_file_format_type format, boolean mustExist, boolean all)
 {
   MIKTEX_ASSERT(kpseInstance != nullptr);
   MIKTEX_ASSERT(fileName != nullptr);
+  if (!all)
+  {
+    const char* result = FindFileInterned(fileName, format, mustExist != 0);
+    if (result == nullptr)
+    {
+      return nullptr;
+    }
+    char** stringList = XTALLOC(2, char*);
+    stringList[0] = xstrdup(result);
+    stringList[1] = nullptr;
+    return stringList;
+  }
   bool found = false;
   vector<PathName> result;
   FileType fileType = ToFileType(format);
   Session::FindFileOptionSet options;
-  if (all)
-  {
-    options += Session::FindFileOption::All;
-  }
+  options += Session::FindFileOption::All;
   if (mustExist)
   {
     options += Session::FindFileOption::Create;
@@ -1111,6 +1196,64 @@ MIKTEXKPSCEEAPI(boolean) miktex_kpathsea_dir_p(kpathsea kpseInstance, ::string f
   return Directory::Exists(PathName(fn)) ? 1 : 0;
 }
 
+MIKTEXKPSCEEAPI(int) miktex_kpsemu_lookup_font_map(const char* mapFileName, const char* fontName, char** lines)
+{
+  try
+  {
+    shared_ptr<Session> session = MIKTEX_SESSION();
+    vector<std::string> result;
+    switch (session->LookupFontMapIndex(mapFileName, fontName, result))
+    {
+    case FontMapIndexLookup::Found:
+      *lines = xstrdup(StringUtil::Flatten(result, '\n').c_str());
+      return 1;
+    case FontMapIndexLookup::NotFound:
+      return 0;
+    default:
+      return -1;
+    }
+  }
+  catch (const MiKTeXException&)
+  {
+    // the font map will be parsed
+    return -1;
+  }
+}
+
+MIKTEXKPSCEEAPI(FILE*) miktex_kpsemu_reduce_bib_database(FILE* bibFile, const char* const* citeKeys, size_t numCiteKeys)
+{
+  std::string database;
+  char buf[8192];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), bibFile)) > 0)
+  {
+    database.append(buf, n);
+  }
+  std::string reduced;
+  bool isReduced = false;
+  try
+  {
+    shared_ptr<Session> session = MIKTEX_SESSION();
+    isReduced = session->ReduceBibDatabase(database, vector<std::string>(citeKeys, citeKeys + numCiteKeys), reduced);
+  }
+  catch (const MiKTeXException&)
+  {
+    // the whole database will be read
+  }
+  FILE* reducedFile = isReduced ? tmpfile() : nullptr;
+  if (reducedFile != nullptr && fwrite(reduced.data(), 1, reduced.length(), reducedFile) == reduced.length())
+  {
+    rewind(reducedFile);
+    return reducedFile;
+  }
+  if (reducedFile != nullptr)
+  {
+    fclose(reducedFile);
+  }
+  rewind(bibFile);
+  return nullptr;
+}
+
 #if WITH_CONTEXT_SUPPORT
 MIKTEXKPSCEEAPI(char*) miktex_kpsemu_create_texmf_cnf()
 {
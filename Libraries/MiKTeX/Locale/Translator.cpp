@@ -43,6 +43,7 @@
 
 #include <miktex/Configuration/ConfigNames>
 #include <miktex/Util/CharBuffer>
+#include <miktex/Util/StartupProfile>
 #include <miktex/Util/StringUtil>
 
 #include "miktex/Locale/Translator.h"
@@ -95,6 +96,9 @@ public:
   ResourceRepository* resources = nullptr;
 public:
   std::locale uiLocale;
+  // true, if messages are not translated (English or no catalog)
+public:
+  bool passThrough = false;
 };
 
 Translator::Translator(const string& domain, ResourceRepository* resources, shared_ptr<ConfigurationProvider> config) :
@@ -146,9 +150,62 @@ static vector<char> LoadFile(ResourceRepository* resources, string const& fileNa
   return vector<char>();
 }
 
+static bool CatalogExists(ResourceRepository* resources, const vector<string>& paths, const string& domain, const string& language, const string& country, const string& variant)
+{
+  // the locale names which are tried by boost::locale::gnu_gettext
+  vector<string> localeNames;
+  if (!variant.empty())
+  {
+    if (!country.empty())
+    {
+      localeNames.push_back(language + "_" + country + "@" + variant);
+    }
+    localeNames.push_back(language + "@" + variant);
+  }
+  if (!country.empty())
+  {
+    localeNames.push_back(language + "_" + country);
+  }
+  localeNames.push_back(language);
+  for (const string& path : paths)
+  {
+    for (const string& localeName : localeNames)
+    {
+      string fileName = path + "/" + localeName + "/LC_MESSAGES/" + domain + ".mo";
+      if (fileName[0] == ':')
+      {
+        if (resources != nullptr && resources->GetResource(fileName.c_str()).data != nullptr)
+        {
+          return true;
+        }
+      }
+      else if (ifstream(fileName, ios::binary))
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 void Translator::Init()
 {
+  StartupProfileSection startupProfileSection("load translations");
 #if defined(WITH_BOOST_LOCALE)
+  string localeIdentifier;
+  auto uiLanguages = GetSystemUILanguages();
+  if (!uiLanguages.empty())
+  {
+    localeIdentifier = uiLanguages[0];
+  }
+  string language, country, encoding, variant;
+  try
+  {
+    std::tie(language, country, encoding, variant) = ParseLocaleIdentifier(localeIdentifier);
+  }
+  catch (const InvalidLocaleIdentifier&)
+  {
+  }
   boost::locale::gnu_gettext::messages_info messagesInfo;
   string localeDir;
   if (pimpl->config->TryGetConfigValue("Translator", "BaseDir", localeDir))
@@ -156,17 +213,18 @@ void Translator::Init()
     messagesInfo.paths.push_back(localeDir);
   }
   messagesInfo.paths.push_back(":");
+  // the message IDs are English: setting up a boost locale is
+  // expensive and can be avoided, if there is nothing to translate
+  if (language.empty() || language == "en" || !CatalogExists(pimpl->resources, messagesInfo.paths, pimpl->domain, language, country, variant))
+  {
+    pimpl->passThrough = true;
+    return;
+  }
   messagesInfo.domains.push_back(boost::locale::gnu_gettext::messages_info::domain(pimpl->domain));
   std::function<vector<char>(const string&, const string&)> callback = [this](const string& fileName, const string& encoding) { return LoadFile(pimpl->resources, fileName, encoding); };
   messagesInfo.callback = callback;
   boost::locale::generator gen;
-  string localeIdentifier;
-  auto uiLanguages = GetSystemUILanguages();
-  if (!uiLanguages.empty())
-  {
-    localeIdentifier = uiLanguages[0] + ".UTF-8";
-  }
-  std::locale baseLocale = gen(localeIdentifier);
+  std::locale baseLocale = gen(localeIdentifier + ".UTF-8");
   boost::locale::info const& properties = std::use_facet<boost::locale::info>(baseLocale);
   messagesInfo.country = properties.country();
   messagesInfo.encoding = properties.encoding();
@@ -180,6 +238,10 @@ std::string Translator::Translate(const char* msgId)
 {
 #if defined(WITH_BOOST_LOCALE)
   std::call_once(pimpl->initFlag, [this]() { Init(); });
+  if (pimpl->passThrough)
+  {
+    return msgId;
+  }
   return boost::locale::gettext(msgId, pimpl->uiLocale);
 #else
   return msgId;
@@ -26,20 +26,26 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <miktex/Core/Utils>
+
 #include "CurlWebFile.h"
 #include "CurlWebSession.h"
 
 using namespace std;
 
+using namespace MiKTeX::Core;
 using namespace MiKTeX::Trace;
 
 using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
 
 const int READ_TIMEOUT_SECONDS = 40;
 
-CurlWebFile::CurlWebFile(shared_ptr<CurlWebSession> webSession, const std::string& url, const std::unordered_map<std::string, std::string>& formData) :
+CurlWebFile::CurlWebFile(shared_ptr<CurlWebSession> webSession, const std::string& url, const std::unordered_map<std::string, std::string>& formData, size_t offset, const string& etag, const string& lastModified) :
   webSession(webSession),
   url(url),
+  offset(offset),
+  etag(etag),
+  lastModified(lastModified),
   trace_mpm(TraceStream::Open(MIKTEX_TRACE_MPM))
 {
   try
@@ -87,9 +93,44 @@ void CurlWebFile::Initialize()
   {
     webSession->SetOption(CURLOPT_HTTPGET, 1);
   }
+  // the easy handle is reused: always (re)set the byte range
+  if (offset > 0)
+  {
+    range = std::to_string(offset) + "-";
+    webSession->SetOption(CURLOPT_RANGE, range.c_str());
+  }
+  else
+  {
+    webSession->SetOption(CURLOPT_RANGE, static_cast<const char*>(nullptr));
+  }
+  // conditional request: the custom headers of the session plus the
+  // validators
+  if (!etag.empty() || !lastModified.empty())
+  {
+    for (const struct curl_slist* h = webSession->GetCustomHeaders(); h != nullptr; h = h->next)
+    {
+      requestHeaders = curl_slist_append(requestHeaders, h->data);
+    }
+    if (!etag.empty())
+    {
+      requestHeaders = curl_slist_append(requestHeaders, ("If-None-Match: " + etag).c_str());
+    }
+    if (!lastModified.empty())
+    {
+      requestHeaders = curl_slist_append(requestHeaders, ("If-Modified-Since: " + lastModified).c_str());
+    }
+    webSession->SetOption(CURLOPT_HTTPHEADER, requestHeaders);
+  }
+  else
+  {
+    webSession->SetOption(CURLOPT_HTTPHEADER, webSession->GetCustomHeaders());
+  }
   webSession->SetOption(CURLOPT_WRITEDATA, reinterpret_cast<void*>(this));
   curl_write_callback writeCallback = WriteCallback;
   webSession->SetOption(CURLOPT_WRITEFUNCTION, writeCallback);
+  webSession->SetOption(CURLOPT_HEADERDATA, reinterpret_cast<void*>(this));
+  curl_write_callback headerCallback = HeaderCallback;
+  webSession->SetOption(CURLOPT_HEADERFUNCTION, headerCallback);
   CURLMcode code = curl_multi_add_handle(webSession->GetMultiHandle(), webSession->GetEasyHandle());
   if (code != CURLM_OK && code != CURLM_CALL_MULTI_PERFORM)
   {
@@ -120,7 +161,35 @@ size_t CurlWebFile::WriteCallback(char* data, size_t elemSize, size_t numElement
   }
 }
 
-size_t CurlWebFile::Read(void* data, size_t n)
+// remember the validators of the response
+size_t CurlWebFile::HeaderCallback(char* data, size_t elemSize, size_t numElements, void* pv)
+{
+  CurlWebFile* This = reinterpret_cast<CurlWebFile*>(pv);
+  size_t size = elemSize * numElements;
+  string line(data, size);
+  while (!line.empty() && (line.back() == '\r' || line.back() == '\n'))
+  {
+    line.pop_back();
+  }
+  size_t colon = line.find(':');
+  if (colon != string::npos)
+  {
+    string name = line.substr(0, colon);
+    size_t start = line.find_first_not_of(" \t", colon + 1);
+    string value = start == string::npos ? "" : line.substr(start);
+    if (Utils::EqualsIgnoreCase(name, "ETag"))
+    {
+      This->responseETag = value;
+    }
+    else if (Utils::EqualsIgnoreCase(name, "Last-Modified"))
+    {
+      This->responseLastModified = value;
+    }
+  }
+  return size;
+}
+
+void CurlWebFile::Fill(size_t n)
 {
   clock_t now = clock();
   clock_t due = now + READ_TIMEOUT_SECONDS * CLOCKS_PER_SEC;
@@ -132,6 +201,61 @@ size_t CurlWebFile::Read(void* data, size_t n)
   {
     MIKTEX_FATAL_ERROR(T_("A timeout was reached while receiving data from the server."));
   }
+  if (!rangeChecked)
+  {
+    CheckRange();
+  }
+}
+
+void CurlWebFile::CheckRange()
+{
+  rangeChecked = true;
+  if (offset == 0)
+  {
+    return;
+  }
+  // the response header has arrived together with the first data
+  long responseCode = 0;
+  webSession->ExpectOK(curl_easy_getinfo(webSession->GetEasyHandle(), CURLINFO_RESPONSE_CODE, &responseCode), url.c_str());
+  if (responseCode == 206)
+  {
+    return;
+  }
+  if (responseCode >= 400)
+  {
+    // discard the error document and let the session report the error
+    while (!webSession->IsReady())
+    {
+      buffer.Clear();
+      webSession->Perform();
+    }
+    buffer.Clear();
+    MIKTEX_FATAL_ERROR_2(T_("The server did not accept the byte range."), "url", url, "responseCode", std::to_string(responseCode));
+  }
+  trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("the server ignored the byte range; receiving {0} from the beginning"), Q_(url)));
+  offset = 0;
+}
+
+size_t CurlWebFile::GetOffset()
+{
+  if (!rangeChecked)
+  {
+    Fill(1);
+  }
+  return offset;
+}
+
+bool CurlWebFile::IsNotModified()
+{
+  Fill(1);
+  long responseCode = 0;
+  webSession->ExpectOK(curl_easy_getinfo(webSession->GetEasyHandle(), CURLINFO_RESPONSE_CODE, &responseCode), url.c_str());
+  return responseCode == 304;
+}
+
+size_t CurlWebFile::Read(void* data, size_t n)
+{
+  Fill(n);
   n = min(n, buffer.GetSize());
   if (n > 0)
   {
@@ -148,6 +272,12 @@ void CurlWebFile::Close()
     initialized = false;
     webSession->ExpectOK(curl_multi_remove_handle(webSession->GetMultiHandle(), webSession->GetEasyHandle()));
   }
+  if (requestHeaders != nullptr)
+  {
+    webSession->SetOption(CURLOPT_HTTPHEADER, webSession->GetCustomHeaders());
+    curl_slist_free_all(requestHeaders);
+    requestHeaders = nullptr;
+  }
   buffer.Clear();
 }
 
@@ -152,7 +152,7 @@ class CurlWebFile :
   public WebFile
 {
 public:
-  CurlWebFile(std::shared_ptr<CurlWebSession> webSession, const std::string& url, const std::unordered_map<std::string, std::string>& formData);
+  CurlWebFile(std::shared_ptr<CurlWebSession> webSession, const std::string& url, const std::unordered_map<std::string, std::string>& formData, std::size_t offset, const std::string& etag, const std::string& lastModified);
 
 public:
   ~CurlWebFile() override;
@@ -160,15 +160,42 @@ public:
 public:
   std::size_t Read(void* data, std::size_t n) override;
 
+public:
+  std::size_t GetOffset() override;
+
+public:
+  bool IsNotModified() override;
+
+public:
+  std::string GetETag() override
+  {
+    return responseETag;
+  }
+
+public:
+  std::string GetLastModified() override
+  {
+    return responseLastModified;
+  }
+
 public:
   void Close() override;
 
 private:
   static std::size_t WriteCallback(char* data, std::size_t elemSize, std::size_t numElements, void* pv);
 
+private:
+  static std::size_t HeaderCallback(char* data, std::size_t elemSize, std::size_t numElements, void* pv);
+
 private:
   void Initialize();
 
+private:
+  void Fill(std::size_t n);
+
+private:
+  void CheckRange();
+
 private:
   bool initialized = false;
 
@@ -178,9 +205,33 @@ private:
 private:
   std::string url;
 
+private:
+  std::size_t offset = 0;
+
+private:
+  std::string range;
+
+private:
+  bool rangeChecked = false;
+
 private:
   std::string urlEncodedpostFields;
 
+private:
+  std::string etag;
+
+private:
+  std::string lastModified;
+
+private:
+  struct curl_slist* requestHeaders = nullptr;
+
+private:
+  std::string responseETag;
+
+private:
+  std::string responseLastModified;
+
 private:
   CircularBuffer buffer;
 
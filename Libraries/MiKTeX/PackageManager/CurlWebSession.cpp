@@ -24,6 +24,7 @@
 #if defined(HAVE_LIBCURL)
 
 #include <algorithm>
+#include <mutex>
 #include <sstream>
 #include <thread>
 
@@ -66,6 +67,64 @@ const long DEFAULT_FTP_RESPONSE_TIMEOUT_SECONDS = 30;
 
 #define ALLOW_REDIRECTS 1
 
+// all sessions of the process share DNS, TLS session and connection
+// caches: a transfer started by a new session (e.g., a download worker
+// or the REST client) can reuse a connection or resume a TLS session
+// set up by another session
+class CurlShare
+{
+public:
+  static CURLSH* Get()
+  {
+    // never destroyed: the share handle must outlive all easy handles
+    static CurlShare* instance = new CurlShare();
+    return instance->pCurlsh;
+  }
+
+private:
+  CurlShare()
+  {
+    pCurlsh = curl_share_init();
+    if (pCurlsh == nullptr)
+    {
+      return;
+    }
+    curl_lock_function lockFunction = Lock;
+    curl_unlock_function unlockFunction = Unlock;
+    curl_share_setopt(pCurlsh, CURLSHOPT_LOCKFUNC, lockFunction);
+    curl_share_setopt(pCurlsh, CURLSHOPT_UNLOCKFUNC, unlockFunction);
+    curl_share_setopt(pCurlsh, CURLSHOPT_USERDATA, reinterpret_cast<void*>(this));
+    curl_share_setopt(pCurlsh, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(pCurlsh, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x73900
+    if (curl_version_info(CURLVERSION_NOW)->version_num >= 0x73900)
+    {
+      curl_share_setopt(pCurlsh, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+#endif
+  }
+
+private:
+  static void Lock(CURL* pCurl, curl_lock_data data, curl_lock_access access, void* pv)
+  {
+    CurlShare* This = reinterpret_cast<CurlShare*>(pv);
+    This->mutexes[data < CURL_LOCK_DATA_LAST ? data : 0].lock();
+  }
+
+private:
+  static void Unlock(CURL* pCurl, curl_lock_data data, void* pv)
+  {
+    CurlShare* This = reinterpret_cast<CurlShare*>(pv);
+    This->mutexes[data < CURL_LOCK_DATA_LAST ? data : 0].unlock();
+  }
+
+private:
+  CURLSH* pCurlsh = nullptr;
+
+private:
+  mutex mutexes[CURL_LOCK_DATA_LAST];
+};
+
 CurlWebSession::CurlWebSession(IProgressNotify_* callback) :
   trace_curl(TraceStream::Open(MIKTEX_TRACE_CURL)),
   trace_mpm(TraceStream::Open(MIKTEX_TRACE_MPM))
@@ -125,6 +184,14 @@ void CurlWebSession::Initialize()
     MIKTEX_FATAL_ERROR(T_("The cURL multi interface could not be initialized."));
   }
 
+#if LIBCURL_VERSION_NUM >= 0x72b00
+  if (curlVersionInfo->version_num >= 0x72b00)
+  {
+    // multiplex transfers on one HTTP/2 connection, if the server supports it
+    curl_multi_setopt(pCurlm, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+  }
+#endif
+
   pCurl = curl_easy_init();
 
   if (pCurl == nullptr)
@@ -152,6 +219,28 @@ void CurlWebSession::Initialize()
 
   SetOption(CURLOPT_CONNECTTIMEOUT, DEFAULT_CONNECTION_TIMEOUT_SECONDS);
 
+  CURLSH* pCurlsh = CurlShare::Get();
+  if (pCurlsh != nullptr)
+  {
+    SetOption(CURLOPT_SHARE, pCurlsh);
+  }
+
+#if LIBCURL_VERSION_NUM >= 0x71900
+  if (curlVersionInfo->version_num >= 0x71900)
+  {
+    // keep idle connections alive for reuse
+    SetOption(CURLOPT_TCP_KEEPALIVE, static_cast<long>(true));
+  }
+#endif
+
+#if LIBCURL_VERSION_NUM >= 0x72f00
+  if (curlVersionInfo->version_num >= 0x72f00 && (curlVersionInfo->features & CURL_VERSION_HTTP2) != 0)
+  {
+    // negotiate HTTP/2 for https:// URLs
+    SetOption(CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+  }
+#endif
+
 #if LIBCURL_VERSION_NUM >= 0x70a08
   if (curlVersionInfo->version_num >= 0x70a08)
   {
@@ -255,7 +344,29 @@ unique_ptr<WebFile> CurlWebSession::OpenUrl(const string& url, const std::unorde
     Initialize();
   }
   trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, fmt::format(T_("going to download {0}"), Q_(url)));
-  return make_unique<CurlWebFile>(shared_from_this(), url, formData);
+  return make_unique<CurlWebFile>(shared_from_this(), url, formData, 0, "", "");
+}
+
+unique_ptr<WebFile> CurlWebSession::OpenUrlRange(const string& url, size_t offset)
+{
+  runningHandles = -1;
+  if (pCurl == nullptr)
+  {
+    Initialize();
+  }
+  trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, fmt::format(T_("going to download {0} starting at byte {1}"), Q_(url), offset));
+  return make_unique<CurlWebFile>(shared_from_this(), url, unordered_map<string, string>(), offset, "", "");
+}
+
+unique_ptr<WebFile> CurlWebSession::OpenUrlIfModified(const string& url, const string& etag, const string& lastModified)
+{
+  runningHandles = -1;
+  if (pCurl == nullptr)
+  {
+    Initialize();
+  }
+  trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, fmt::format(T_("going to download {0} if modified"), Q_(url)));
+  return make_unique<CurlWebFile>(shared_from_this(), url, unordered_map<string, string>(), 0, etag, lastModified);
 }
 
 void CurlWebSession::SetCustomHeaders(const unordered_map<string, string>& headers)
@@ -429,7 +540,11 @@ void CurlWebSession::ReadInformationals()
     }
     ExpectOK(r, effectiveUrl);
     trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("response code: {0}"), responseCode));
-    if (responseCode >= 300 && responseCode <= 399)
+    if (responseCode == 304)
+    {
+      // answer to a conditional request; see CurlWebFile::IsNotModified()
+    }
+    else if (responseCode >= 300 && responseCode <= 399)
     {
 #if ALLOW_REDIRECTS
       MIKTEX_UNEXPECTED();
@@ -58,6 +58,12 @@ public:
 public:
   std::unique_ptr<WebFile> OpenUrl(const std::string& url, const std::unordered_map<std::string, std::string>& formData) override;
 
+public:
+  std::unique_ptr<WebFile> OpenUrlRange(const std::string& url, std::size_t offset) override;
+
+public:
+  std::unique_ptr<WebFile> OpenUrlIfModified(const std::string& url, const std::string& etag, const std::string& lastModified) override;
+
 public:
   void Dispose() override;
 
@@ -177,6 +183,12 @@ public:
 public:
   void SetCustomHeaders(const std::unordered_map<std::string, std::string>& headers) override;
 
+public:
+  const struct curl_slist* GetCustomHeaders() const
+  {
+    return headers;
+  }
+
 private:
   void Initialize();
 
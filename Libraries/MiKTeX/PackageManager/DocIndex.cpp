@@ -0,0 +1,205 @@
+/**
+ * @file DocIndex.cpp
+ * @author Christian Schenk
+ * @brief Documentation index
+ *
+ * @copyright Copyright © 2023 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#include "config.h"
+
+#include <fstream>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/TemporaryFile>
+#include <miktex/Trace/Trace>
+#include <miktex/Trace/TraceStream>
+
+#include "internal.h"
+
+#include "DocIndex.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+/*
+ * The index file is a text file: a header line, the list of the INI
+ * files (with size and modification time) and one line per
+ * documentation file:
+ *
+ *   miktex-doc-index version
+ *   #manifestFiles
+ *   { size lastWriteTime path }
+ *   { packageId TAB path }
+ *
+ * Paths are relative to the TEXMF root directory.
+ */
+
+const char* const INDEX_SIGNATURE = "miktex-doc-index";
+const int INDEX_VERSION = 1;
+
+void DocIndex::Add(const PackageInfo& packageInfo)
+{
+    for (const string& file : packageInfo.docFiles)
+    {
+        string path;
+        if (PackageManager::StripTeXMFPrefix(file, path))
+        {
+            Add(packageInfo.id, path);
+        }
+    }
+}
+
+void DocIndex::Add(const string& packageId, const string& path)
+{
+    PathName pathName(path);
+    DocumentationFile file;
+    file.packageId = packageId;
+    file.name = pathName.GetFileNameWithoutExtension().ToString();
+    file.type = pathName.GetExtension();
+    file.path = path;
+    byPackage[file.packageId].push_back(files.size());
+    byName[file.name].push_back(files.size());
+    files.push_back(std::move(file));
+}
+
+void DocIndex::Clear()
+{
+    files.clear();
+    byPackage.clear();
+    byName.clear();
+}
+
+vector<DocumentationFile> DocIndex::FindByPackage(const string& packageId) const
+{
+    vector<DocumentationFile> result;
+    IndexTable::const_iterator it = byPackage.find(packageId);
+    if (it != byPackage.end())
+    {
+        for (size_t idx : it->second)
+        {
+            result.push_back(files[idx]);
+        }
+    }
+    return result;
+}
+
+vector<DocumentationFile> DocIndex::FindByName(const string& name) const
+{
+    vector<DocumentationFile> result;
+    IndexTable::const_iterator it = byName.find(name);
+    if (it != byName.end())
+    {
+        for (size_t idx : it->second)
+        {
+            result.push_back(files[idx]);
+        }
+    }
+    return result;
+}
+
+bool DocIndex::Read(const PathName& indexPath, const vector<PathName>& manifestFiles)
+{
+    auto trace_mpm = TraceStream::Open(MIKTEX_TRACE_MPM);
+    Clear();
+    if (!File::Exists(indexPath))
+    {
+        return false;
+    }
+    try
+    {
+        ifstream stream = File::CreateInputStream(indexPath);
+        string signature;
+        int version;
+        size_t numManifestFiles;
+        if (!(stream >> signature >> version >> numManifestFiles) || signature != INDEX_SIGNATURE || version != INDEX_VERSION || numManifestFiles != manifestFiles.size())
+        {
+            return false;
+        }
+        for (const PathName& path : manifestFiles)
+        {
+            uint64_t size;
+            uint64_t lastWriteTime;
+            string line;
+            if (!(stream >> size >> lastWriteTime) || !getline(stream >> ws, line) || line != path.ToString())
+            {
+                return false;
+            }
+            if (!File::Exists(path) || File::GetSize(path) != size || static_cast<uint64_t>(File::GetLastWriteTime(path)) != lastWriteTime)
+            {
+                trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("documentation index {0} is out of date: {1} has changed"), Q_(indexPath), Q_(path)));
+                return false;
+            }
+        }
+        string line;
+        while (getline(stream, line))
+        {
+            if (line.empty())
+            {
+                continue;
+            }
+            string::size_type tab = line.find('\t');
+            if (tab == string::npos)
+            {
+                Clear();
+                return false;
+            }
+            Add(line.substr(0, tab), line.substr(tab + 1));
+        }
+    }
+    catch (const MiKTeXException& e)
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Error, fmt::format(T_("documentation index {0} could not be read: {1}"), Q_(indexPath), e.GetErrorMessage()));
+        Clear();
+        return false;
+    }
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("using documentation index {0}"), Q_(indexPath)));
+    return true;
+}
+
+void DocIndex::Write(const PathName& indexPath, const vector<PathName>& manifestFiles) const
+{
+    auto trace_mpm = TraceStream::Open(MIKTEX_TRACE_MPM);
+    try
+    {
+        Directory::Create(indexPath.GetDirectoryName());
+        PathName tmpIndexPath(indexPath);
+        tmpIndexPath.AppendExtension(".tmp");
+        unique_ptr<TemporaryFile> tmpIndexFile = TemporaryFile::Create(tmpIndexPath);
+        ofstream stream = File::CreateOutputStream(tmpIndexPath, ios_base::out | ios_base::binary, ios_base::badbit | ios_base::failbit);
+        stream << INDEX_SIGNATURE << " " << INDEX_VERSION << "\n";
+        stream << manifestFiles.size() << "\n";
+        for (const PathName& path : manifestFiles)
+        {
+            stream << static_cast<uint64_t>(File::GetSize(path)) << " " << static_cast<uint64_t>(File::GetLastWriteTime(path)) << " " << path.ToString() << "\n";
+        }
+        for (const DocumentationFile& file : files)
+        {
+            stream << file.packageId << "\t" << file.path << "\n";
+        }
+        stream.close();
+        File::Move(tmpIndexPath, indexPath, { FileMoveOption::ReplaceExisting });
+        tmpIndexFile->Keep();
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("documentation index {0} has been written"), Q_(indexPath)));
+    }
+    catch (const MiKTeXException& e)
+    {
+        // not fatal: the index will be made again
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Error, fmt::format(T_("documentation index {0} could not be written: {1}"), Q_(indexPath), e.GetErrorMessage()));
+    }
+}
@@ -0,0 +1,98 @@
+/**
+ * @file DocIndex.h
+ * @author Christian Schenk
+ * @brief Documentation index
+ *
+ * @copyright Copyright © 2023 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/Core/equal_icase>
+#include <miktex/Core/hash_icase>
+#include <miktex/Util/PathName>
+
+#include <miktex/PackageManager/PackageManager>
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+/**
+ * @brief Maps package IDs and file names to documentation files.
+ *
+ * The index is made from the package manifests when the package database is
+ * updated. Like a package manifests snapshot, it records the size and
+ * modification time of the INI files it was made from; it is used as long as
+ * these files are unchanged.
+ */
+class DocIndex
+{
+public:
+
+    /**
+     * @brief Adds the documentation files of a package.
+     *
+     * @param packageInfo The package record.
+     */
+    void Add(const MiKTeX::Packages::PackageInfo& packageInfo);
+
+    /**
+     * @brief Clears the index.
+     */
+    void Clear();
+
+    /**
+     * @brief Looks up the documentation files of a package.
+     *
+     * @param packageId The package ID.
+     * @return Returns the documentation files (in manifest order).
+     */
+    std::vector<MiKTeX::Packages::DocumentationFile> FindByPackage(const std::string& packageId) const;
+
+    /**
+     * @brief Looks up documentation files by name.
+     *
+     * @param name The file name without directory and extension.
+     * @return Returns the documentation files.
+     */
+    std::vector<MiKTeX::Packages::DocumentationFile> FindByName(const std::string& name) const;
+
+    /**
+     * @brief Reads the index.
+     *
+     * @param indexPath Path to the index file.
+     * @param manifestFiles The INI files (in load order) which the index must
+     * have been made from.
+     * @return Returns `false`, if the index does not exist or is out of date.
+     */
+    bool Read(const MiKTeX::Util::PathName& indexPath, const std::vector<MiKTeX::Util::PathName>& manifestFiles);
+
+    /**
+     * @brief Writes the index.
+     *
+     * @param indexPath Path to the index file.
+     * @param manifestFiles The INI files (in load order) the package manifests
+     * were read from.
+     */
+    void Write(const MiKTeX::Util::PathName& indexPath, const std::vector<MiKTeX::Util::PathName>& manifestFiles) const;
+
+private:
+
+    void Add(const std::string& packageId, const std::string& path);
+
+    typedef std::unordered_map<std::string, std::vector<std::size_t>, MiKTeX::Core::hash_icase, MiKTeX::Core::equal_icase> IndexTable;
+
+    std::vector<MiKTeX::Packages::DocumentationFile> files;
+    IndexTable byPackage;
+    IndexTable byName;
+};
+
+MPM_INTERNAL_END_NAMESPACE;
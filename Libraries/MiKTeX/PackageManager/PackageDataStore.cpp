@@ -13,7 +13,11 @@
 
 #include "config.h"
 
+#include <atomic>
+#include <exception>
 #include <future>
+#include <mutex>
+#include <thread>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -21,6 +25,7 @@
 #include <miktex/Core/Directory>
 #include <miktex/Core/DirectoryLister>
 #include <miktex/Core/VersionNumber>
+#include <miktex/Trace/EventRecorder>
 #include <miktex/Trace/StopWatch>
 #include <miktex/Trace/Trace>
 #include <miktex/Trace/TraceStream>
@@ -34,6 +39,7 @@
 
 #include "PackageDataStore.h"
 #include "PackageManagerImpl.h"
+#include "PackageManifestsSnapshot.h"
 #include "TpmParser.h"
 
 using namespace std;
@@ -46,6 +52,11 @@ using namespace MiKTeX::Util;
 
 using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
 
+const char* const PACKAGE_MANIFESTS_SNAPSHOT_FILE_NAME = "package-manifests.snapshot";
+
+// spawning a thread does not pay off for fewer package manifests
+const size_t MIN_PACKAGE_MANIFESTS_PER_THREAD = 64;
+
 PackageDataStore::PackageDataStore() :
     // TODO: trace callback
     trace_mpm(TraceStream::Open(MIKTEX_TRACE_MPM)),
@@ -66,7 +77,7 @@ void PackageDataStore::LoadAllPackageManifests(const PathName& packageManifestsP
     unique_ptr<Cfg> cfg = Cfg::Create();
     cfg->Read(packageManifestsPath, mustBeSigned);
 
-    Load(*cfg);
+    Load(GetPackageManifests(*cfg));
 
     loadedAllPackageManifests = true;
 }
@@ -223,6 +234,29 @@ void PackageDataStore::NeedPackageManifestsIni()
     }
 }
 
+vector<PathName> PackageDataStore::GetManifestFiles()
+{
+    // user manifests take precedence over system-wide manifests
+    vector<PathName> manifestFiles;
+    if (!session->IsAdminMode())
+    {
+        PathName userPath = session->GetSpecialPath(SpecialPath::UserInstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_INI);
+        if (File::Exists(userPath))
+        {
+            manifestFiles.push_back(userPath);
+        }
+    }
+    if (session->IsAdminMode() || session->IsSharedSetup() && session->GetSpecialPath(SpecialPath::UserInstallRoot).Canonicalize() != session->GetSpecialPath(SpecialPath::CommonInstallRoot).Canonicalize())
+    {
+        PathName commonPath = session->GetSpecialPath(SpecialPath::CommonInstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_INI);
+        if (File::Exists(commonPath))
+        {
+            manifestFiles.push_back(commonPath);
+        }
+    }
+    return manifestFiles;
+}
+
 PackageDataStore& PackageDataStore::Load()
 {
     if (loadedAllPackageManifests)
@@ -230,44 +264,106 @@ PackageDataStore& PackageDataStore::Load()
         // we do this once
         return *this;
     }
+    EventSpan eventSpan("mpm: load package manifests");
     unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "loading all package manifests");
     NeedPackageManifestsIni();
-    unique_ptr<Cfg> cfg = Cfg::Create();
-    if (!session->IsAdminMode())
+    vector<PathName> manifestFiles = GetManifestFiles();
+    PathName snapshotPath = session->GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_MIKTEX_PACKAGE_CACHE_DIR) / PathName(PACKAGE_MANIFESTS_SNAPSHOT_FILE_NAME);
+    vector<PackageInfo> packageManifests;
+    bool needsRefresh = false;
+    if (manifestFiles.empty())
     {
-        PathName userPath = session->GetSpecialPath(SpecialPath::UserInstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_INI);
-        if (File::Exists(userPath))
+        // nothing to load
+    }
+    else if (PackageManifestsSnapshot::Read(snapshotPath, manifestFiles, packageManifests, needsRefresh))
+    {
+        if (needsRefresh)
         {
-            cfg->Read(userPath);
+            PackageManifestsSnapshot::Write(snapshotPath, manifestFiles, packageManifests);
         }
     }
-    if (session->IsAdminMode() || session->IsSharedSetup() && session->GetSpecialPath(SpecialPath::UserInstallRoot).Canonicalize() != session->GetSpecialPath(SpecialPath::CommonInstallRoot).Canonicalize())
+    else
     {
-        PathName commonPath = session->GetSpecialPath(SpecialPath::CommonInstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_INI);
-        if (File::Exists(commonPath))
+        unique_ptr<Cfg> cfg = Cfg::Create();
+        for (const PathName& path : manifestFiles)
         {
+            cfg->Read(path);
             cfg->SetOptions({ Cfg::Option::NoOverwriteKeys });
-            cfg->Read(commonPath);
         }
+        packageManifests = GetPackageManifests(*cfg);
+        PackageManifestsSnapshot::Write(snapshotPath, manifestFiles, packageManifests);
     }
-    Load(*cfg);
+    Load(packageManifests);
     loadedAllPackageManifests = true;
     return *this;
 }
 
-void PackageDataStore::Load(Cfg& cfg)
+vector<PackageInfo> PackageDataStore::GetPackageManifests(Cfg& cfg)
 {
-    unsigned count = 0;
+    vector<string> packageIds;
     for (const auto& key : cfg)
+    {
+        packageIds.push_back(key->GetName());
+    }
+    return GetPackageManifests(cfg, packageIds);
+}
+
+vector<PackageInfo> PackageDataStore::GetPackageManifests(const Cfg& cfg, const vector<string>& packageIds)
+{
+    // the INI data is only read: each worker picks the next package
+    // and parses its manifest into its own slot
+    vector<PackageInfo> result(packageIds.size());
+    atomic<size_t> nextJob(0);
+    mutex errorMutex;
+    exception_ptr error;
+    auto worker = [&]()
+    {
+        try
+        {
+            for (size_t i = nextJob++; i < packageIds.size(); i = nextJob++)
+            {
+                result[i] = PackageManager::GetPackageManifest(cfg, packageIds[i], TEXMF_PREFIX_DIRECTORY);
+            }
+        }
+        catch (const exception&)
+        {
+            lock_guard<mutex> lockGuard(errorMutex);
+            if (error == nullptr)
+            {
+                error = current_exception();
+            }
+            nextJob = packageIds.size();
+        }
+    };
+    size_t numThreads = std::min<size_t>(std::max(thread::hardware_concurrency(), 1u), packageIds.size() / MIN_PACKAGE_MANIFESTS_PER_THREAD);
+    vector<thread> threads;
+    for (size_t i = 1; i < numThreads; ++i)
+    {
+        threads.push_back(thread(worker));
+    }
+    worker();
+    for (thread& t : threads)
+    {
+        t.join();
+    }
+    if (error != nullptr)
+    {
+        rethrow_exception(error);
+    }
+    return result;
+}
+
+void PackageDataStore::Load(const vector<PackageInfo>& packageManifests)
+{
+    unsigned count = 0;
+    for (const PackageInfo& packageInfo : packageManifests)
     {
         // ignore redefinition
-        if (packageTable.find(key->GetName()) != packageTable.end())
+        if (packageTable.find(packageInfo.id) != packageTable.end())
         {
             continue;
         }
 
-        PackageInfo packageInfo = PackageManager::GetPackageManifest(cfg, key->GetName(), TEXMF_PREFIX_DIRECTORY);
-
 #if IGNORE_OTHER_SYSTEMS
         string targetSystems = packageInfo.targetSystem;
         if (targetSystems != "" && !StringUtil::Contains(targetSystems.c_str(), MIKTEX_SYSTEM_TAG))
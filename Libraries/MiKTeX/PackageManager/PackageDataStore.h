@@ -72,6 +72,12 @@ public:
      */
     void DefinePackage(const MiKTeX::Packages::PackageInfo& packageinfo);
 
+    /**
+     * Gets the INI files which hold the package manifests.
+     * @return Returns the paths (in load order).
+     */
+    std::vector<MiKTeX::Util::PathName> GetManifestFiles();
+
     /**
      * Gets the number of installed packages.
      * @param common Indicates whether to retrieve the number of packages for
@@ -87,6 +93,17 @@ public:
      */
     unsigned long GetFileRefCount(const MiKTeX::Util::PathName& path);
 
+    /**
+     * @brief Parses package manifests.
+     *
+     * The manifests are parsed by a pool of worker threads.
+     *
+     * @param cfg The INI data containing the package manifests.
+     * @param packageIds The IDs of the packages to be parsed.
+     * @return Returns the package manifests (in the order of `packageIds`).
+     */
+    static std::vector<MiKTeX::Packages::PackageInfo> GetPackageManifests(const MiKTeX::Core::Cfg& cfg, const std::vector<std::string>& packageIds);
+
     /**
      * Retrieves a record from the data store.
      * @exception std::exception Record not found.
@@ -233,7 +250,8 @@ private:
     std::time_t GetTimeInstalled(const std::string& packageId);
     std::time_t GetTimeInstalled(const std::string& packageId, MiKTeX::Core::ConfigurationScope scope);
     void IncrementFileRefCounts(const std::vector<std::string>& files);
-    void Load(MiKTeX::Core::Cfg& cfg);
+    std::vector<MiKTeX::Packages::PackageInfo> GetPackageManifests(MiKTeX::Core::Cfg& cfg);
+    void Load(const std::vector<MiKTeX::Packages::PackageInfo>& packageManifests);
     void LoadVarData();
 
     ComboCfg comboCfg;
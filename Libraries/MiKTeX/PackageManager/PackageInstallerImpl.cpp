@@ -13,6 +13,11 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <future>
 #include <set>
 #include <unordered_set>
 
@@ -26,6 +31,7 @@
 #include <miktex/Core/TemporaryDirectory>
 #include <miktex/Core/TemporaryFile>
 #include <miktex/Extractor/Extractor>
+#include <miktex/Trace/EventRecorder>
 #include <miktex/Trace/StopWatch>
 
 #if defined(MIKTEX_WINDOWS)
@@ -55,6 +61,45 @@ using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
 
 constexpr const char* LF = "\n";
 
+// upper bound for the number of threads which copy package files
+constexpr size_t MAX_COPY_THREADS = 4;
+
+// default number of archive files which are downloaded at the same time
+constexpr int DEFAULT_MAX_CONCURRENT_DOWNLOADS = 6;
+
+// interval in which the client is notified while waiting for a download
+constexpr int DOWNLOAD_WAIT_INTERVAL_MILLISECONDS = 250;
+
+// default number of mirrors which share the downloads
+constexpr int DEFAULT_MAX_MIRRORS = 3;
+
+// assumed throughput of a mirror which has not been measured yet
+constexpr double UNMEASURED_BYTES_PER_SECOND = 1e12;
+
+// a transfer is considered stalled, if it gets less than this many
+// bytes per second within a check interval
+constexpr double STALLED_BYTES_PER_SECOND = 2048;
+constexpr int STALL_CHECK_INTERVAL_SECONDS = 15;
+
+// partially received archive files are kept for the next attempt
+const char* const PARTIAL_DOWNLOAD_DIRECTORY = "partial";
+const char* const PARTIAL_DOWNLOAD_SUFFIX = ".part";
+const char* const PARTIAL_DOWNLOAD_STATE_SUFFIX = ".state";
+constexpr size_t PARTIAL_DOWNLOAD_CHECKPOINT_SIZE = 1024 * 1024;
+
+// the validators (ETag, Last-Modified) of a downloaded database archive
+// file are kept in its cache directory
+const char* const HTTP_VALIDATORS_FILE_NAME = "http-validators.txt";
+
+// a prefetched repository manifest is only used if it is younger than this
+constexpr time_t REPOSITORY_MANIFEST_PREFETCH_MAX_AGE_SECONDS = 300;
+
+// identifies the state of a file: last write time and size
+static string GetFileStamp(const PathName& path)
+{
+    return std::to_string(File::GetLastWriteTime(path)) + ":" + std::to_string(File::GetSize(path));
+}
+
 template<typename T1, typename T2> double Divide(T1 a, T2 b)
 {
     return static_cast<double>(a) / static_cast<double>(b);
@@ -134,8 +179,6 @@ void PackageInstallerImpl::OnProgress()
 
 void PackageInstallerImpl::Download(const string& url, const PathName& dest, size_t expectedSize)
 {
-    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("going to download: {0} => {1}"), Q_(url), Q_(dest)));
-
     if (expectedSize > 0)
     {
         ReportLine(fmt::format(T_("downloading {0} (expecting {1} bytes)..."), Q_(url), expectedSize));
@@ -145,14 +188,99 @@ void PackageInstallerImpl::Download(const string& url, const PathName& dest, siz
         ReportLine(fmt::format(T_("downloading {0}..."), Q_(url)));
     }
 
+    Receive(packageManager->GetWebSession(), url, dest, expectedSize, true);
+}
+
+PackageInstallerImpl::HttpValidators PackageInstallerImpl::LoadHttpValidators(const PathName& cacheDirectory, const PathName& cachedFile)
+{
+    HttpValidators validators;
+    PathName path = cacheDirectory / PathName(HTTP_VALIDATORS_FILE_NAME);
+    if (!File::Exists(path) || !File::Exists(cachedFile))
+    {
+        return validators;
+    }
+    ifstream stream = File::CreateInputStream(path);
+    getline(stream, validators.url);
+    getline(stream, validators.etag);
+    getline(stream, validators.lastModified);
+    getline(stream, validators.stamp);
+    stream.close();
+    return validators;
+}
+
+void PackageInstallerImpl::SaveHttpValidators(const PathName& cacheDirectory, const HttpValidators& validators)
+{
+    ofstream stream = File::CreateOutputStream(cacheDirectory / PathName(HTTP_VALIDATORS_FILE_NAME));
+    stream << validators.url << LF << validators.etag << LF << validators.lastModified << LF << validators.stamp << LF;
+    stream.close();
+}
+
+bool PackageInstallerImpl::DownloadIfModified(WebSession* webSession, const string& url, const PathName& dest, HttpValidators& validators, bool notify)
+{
+    if (validators.url != url)
+    {
+        validators = HttpValidators();
+    }
+    if (notify)
+    {
+        ReportLine(fmt::format(T_("downloading {0}..."), Q_(url)));
+    }
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("going to download: {0} => {1}"), Q_(url), Q_(dest)));
+    // without validators, this is an ordinary request
+    unique_ptr<WebFile> webFile(webSession->OpenUrlIfModified(url, validators.etag, validators.lastModified));
+    if (webFile->IsNotModified())
+    {
+        webFile->Close();
+        if (notify)
+        {
+            ReportLine(fmt::format(T_("{0} has not been modified"), Q_(url)));
+        }
+        return false;
+    }
+    FileStream destStream(File::Open(dest, FileMode::Create, FileAccess::Write, false));
+    Transfer(*webFile, url, destStream, notify, nullptr);
+    destStream.Close();
+    validators = HttpValidators();
+    validators.url = url;
+    validators.etag = webFile->GetETag();
+    validators.lastModified = webFile->GetLastModified();
+    webFile->Close();
+    return true;
+}
+
+void PackageInstallerImpl::DownloadArchiveFile(const string& packageId, const string& url, const PathName& dest)
+{
+    size_t expectedSize = repositoryManifest.GetArchiveFileSize(packageId);
+    ReportLine(fmt::format(T_("downloading {0} (expecting {1} bytes)..."), Q_(url), expectedSize));
+    ReceiveArchiveFile(packageManager->GetWebSession(), url, dest, expectedSize, repositoryManifest.GetArchiveFileDigest(packageId), true);
+}
+
+void PackageInstallerImpl::Receive(WebSession* webSession, const string& url, const PathName& dest, size_t expectedSize, bool notify)
+{
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("going to download: {0} => {1}"), Q_(url), Q_(dest)));
+
     // open the remote file
-    unique_ptr<WebFile> webFile(packageManager->GetWebSession()->OpenUrl(url.c_str()));
+    unique_ptr<WebFile> webFile(webSession->OpenUrl(url.c_str()));
 
     // open the local file
     FileStream destStream(File::Open(dest, FileMode::Create, FileAccess::Write, false));
 
     // receive the data
     trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("start writing on {0}"), Q_(dest)));
+    size_t received = Transfer(*webFile, url, destStream, notify, nullptr);
+
+    // close files
+    destStream.Close();
+    webFile->Close();
+
+    if (expectedSize > 0 && expectedSize != received)
+    {
+        MIKTEX_FATAL_ERROR_2(FatalError(ERROR_SIZE_MISMATCH), "dest", dest.ToString(), "expectecSize", std::to_string(expectedSize), "received", std::to_string(received));
+    }
+}
+
+size_t PackageInstallerImpl::Transfer(WebFile& webFile, const string& url, FileStream& destStream, bool notify, const function<void(size_t)>& checkpoint)
+{
 #if defined(CURL_MAX_WRITE_SIZE)
     const size_t bufsize = 2 * CURL_MAX_WRITE_SIZE;
 #else
@@ -161,10 +289,13 @@ void PackageInstallerImpl::Download(const string& url, const PathName& dest, siz
     char buf[bufsize];
     size_t n;
     size_t received = 0;
+    size_t checkpointReceived = 0;
     clock_t start = clock();
     clock_t start1 = start;
     size_t received1 = 0;
-    while ((n = webFile->Read(buf, sizeof(buf))) > 0)
+    chrono::time_point<chrono::steady_clock> stallCheckTime = chrono::steady_clock::now();
+    size_t stallCheckReceived = 0;
+    while ((n = webFile.Read(buf, sizeof(buf))) > 0)
     {
         clock_t end1 = clock();
 
@@ -173,6 +304,12 @@ void PackageInstallerImpl::Download(const string& url, const PathName& dest, siz
         received += n;
         received1 += n;
 
+        if (checkpoint && received - checkpointReceived >= PARTIAL_DOWNLOAD_CHECKPOINT_SIZE)
+        {
+            checkpoint(received);
+            checkpointReceived = received;
+        }
+
         // update progress info
         {
             lock_guard<mutex> lockGuard(progressIndicatorMutex);
@@ -189,13 +326,32 @@ void PackageInstallerImpl::Download(const string& url, const PathName& dest, siz
             progressInfo.timeRemaining = static_cast<unsigned long>((timeTotal - timePassed) / CLOCKS_PER_SEC);
         }
 
-        Notify();
+        if (notify)
+        {
+            Notify();
+        }
+        else
+        {
+            if (stopDownloads)
+            {
+                throw OperationCancelledException();
+            }
+            // give up on a stalled transfer: another mirror might do better
+            stallCheckReceived += n;
+            chrono::time_point<chrono::steady_clock> now = chrono::steady_clock::now();
+            double seconds = chrono::duration<double>(now - stallCheckTime).count();
+            if (seconds >= STALL_CHECK_INTERVAL_SECONDS)
+            {
+                if (stallCheckReceived / seconds < STALLED_BYTES_PER_SECOND)
+                {
+                    MIKTEX_FATAL_ERROR_2(T_("The data transfer has stalled."), "url", url, "received", std::to_string(received));
+                }
+                stallCheckTime = now;
+                stallCheckReceived = 0;
+            }
+        }
     }
 
-    // close files
-    destStream.Close();
-    webFile->Close();
-
     clock_t end = clock();
 
     if (start == end)
@@ -207,12 +363,259 @@ void PackageInstallerImpl::Download(const string& url, const PathName& dest, siz
     double mb = Divide(received, 1000000);
     double seconds = Divide(end - start, CLOCKS_PER_SEC);
     trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("downloaded {0:.2f} MB in {1:.2f} seconds"), mb, seconds));
-    ReportLine(fmt::format(T_("{0:.2f} MB, {1:.2f} Mbit/s"), mb, Divide(8 * mb, seconds)));
+    if (notify)
+    {
+        ReportLine(fmt::format(T_("{0:.2f} MB, {1:.2f} Mbit/s"), mb, Divide(8 * mb, seconds)));
+    }
 
-    if (expectedSize > 0 && expectedSize != received)
+    return received;
+}
+
+PathName PackageInstallerImpl::GetPartialDownloadDirectory()
+{
+    if (!downloadDirectory.Empty())
+    {
+        return downloadDirectory;
+    }
+    return session->GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_MIKTEX_PACKAGE_CACHE_DIR) / PathName(PARTIAL_DOWNLOAD_DIRECTORY);
+}
+
+MPMSTATICFUNC(size_t) ReadPartialDownloadState(const PathName& statePath, const PathName& partialPath, size_t expectedSize, const MD5& expectedDigest)
+{
+    if (!File::Exists(statePath) || !File::Exists(partialPath))
+    {
+        return 0;
+    }
+    try
+    {
+        unique_ptr<Cfg> state(Cfg::Create());
+        state->Read(statePath);
+        string digest;
+        string size;
+        string received;
+        if (state->TryGetValueAsString("partial", "MD5", digest)
+            && state->TryGetValueAsString("partial", "Size", size)
+            && state->TryGetValueAsString("partial", "Received", received)
+            && digest == expectedDigest.ToString()
+            && std::stoull(size) == expectedSize)
+        {
+            // the partial file might have a few bytes more, if the
+            // last checkpoint was missed
+            size_t offset = std::stoull(received);
+            if (offset < expectedSize && offset <= File::GetSize(partialPath))
+            {
+                return offset;
+            }
+        }
+    }
+    catch (const exception&)
+    {
+    }
+    return 0;
+}
+
+MPMSTATICFUNC(void) WritePartialDownloadState(const PathName& statePath, size_t expectedSize, const MD5& expectedDigest, size_t received)
+{
+    unique_ptr<Cfg> state(Cfg::Create());
+    state->PutValue("partial", "MD5", expectedDigest.ToString());
+    state->PutValue("partial", "Size", std::to_string(expectedSize));
+    state->PutValue("partial", "Received", std::to_string(received));
+    state->Write(statePath);
+}
+
+MPMSTATICFUNC(void) RemovePartialDownload(const PathName& partialPath, const PathName& statePath)
+{
+    for (const PathName& path : { partialPath, statePath })
+    {
+        if (File::Exists(path))
+        {
+            File::Delete(path);
+        }
+    }
+}
+
+bool PackageInstallerImpl::TryGetFromArchiveCache(WebSession* webSession, const PathName& dest, size_t expectedSize, const MD5& expectedDigest, bool notify)
+{
+    // the archive cache of this machine
+    PathName cacheDirectory(session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_ARCHIVE_CACHE_DIRECTORY, ConfigValue("")).GetString());
+    if (!cacheDirectory.Empty())
+    {
+        PathName cachedPath = cacheDirectory / PathName(expectedDigest.ToString());
+        if (File::Exists(cachedPath) && File::GetSize(cachedPath) == expectedSize && MD5::FromFile(cachedPath) == expectedDigest)
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("using cached archive file {0}"), Q_(cachedPath)));
+            File::Copy(cachedPath, dest);
+            lock_guard<mutex> lockGuard(progressIndicatorMutex);
+            progressInfo.cbPackageDownloadCompleted += expectedSize;
+            progressInfo.cbDownloadCompleted += expectedSize;
+            return true;
+        }
+    }
+
+    // the archive cache of another machine
+    string cacheUrl = session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_ARCHIVE_CACHE_URL, ConfigValue("")).GetString();
+    if (cacheUrl.empty())
+    {
+        return false;
+    }
+    string url = ::MakeUrl(cacheUrl, expectedDigest.ToString());
+    size_t packageDownloadCompleted;
+    size_t downloadCompleted;
     {
+        lock_guard<mutex> lockGuard(progressIndicatorMutex);
+        packageDownloadCompleted = progressInfo.cbPackageDownloadCompleted;
+        downloadCompleted = progressInfo.cbDownloadCompleted;
+    }
+    try
+    {
+        Receive(webSession, url, dest, expectedSize, notify);
+        if (MD5::FromFile(dest) == expectedDigest)
+        {
+            return true;
+        }
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("archive cache returned a bad file: {0}"), Q_(url)));
+    }
+    catch (const OperationCancelledException&)
+    {
+        throw;
+    }
+    catch (const MiKTeXException& e)
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("{0} could not be downloaded from the archive cache: {1}"), Q_(url), e.GetErrorMessage()));
+    }
+    // the package repository will deliver the file
+    lock_guard<mutex> lockGuard(progressIndicatorMutex);
+    progressInfo.cbPackageDownloadCompleted = packageDownloadCompleted;
+    progressInfo.cbDownloadCompleted = downloadCompleted;
+    return false;
+}
+
+void PackageInstallerImpl::PutIntoArchiveCache(const PathName& path, size_t expectedSize, const MD5& expectedDigest)
+{
+    PathName cacheDirectory(session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_ARCHIVE_CACHE_DIRECTORY, ConfigValue("")).GetString());
+    if (cacheDirectory.Empty())
+    {
+        return;
+    }
+    PathName cachedPath = cacheDirectory / PathName(expectedDigest.ToString());
+    try
+    {
+        if (File::Exists(cachedPath) || File::GetSize(path) != expectedSize || MD5::FromFile(path) != expectedDigest)
+        {
+            return;
+        }
+        Directory::Create(cacheDirectory);
+        PathName tmpPath = cachedPath;
+        tmpPath.AppendExtension(".tmp");
+        unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create(tmpPath);
+        File::Copy(path, tmpPath);
+        File::Move(tmpPath, cachedPath, { FileMoveOption::ReplaceExisting });
+        tmpFile->Keep();
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("archive file has been cached: {0}"), Q_(cachedPath)));
+    }
+    catch (const MiKTeXException& e)
+    {
+        // not fatal: the archive cache is an optimization
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("archive file {0} could not be cached: {1}"), Q_(cachedPath), e.GetErrorMessage()));
+    }
+}
+
+void PackageInstallerImpl::ReceiveArchiveFile(WebSession* webSession, const string& url, const PathName& dest, size_t expectedSize, const MD5& expectedDigest, bool notify)
+{
+    if (expectedSize == 0)
+    {
+        Receive(webSession, url, dest, expectedSize, notify);
+        return;
+    }
+
+    if (TryGetFromArchiveCache(webSession, dest, expectedSize, expectedDigest, notify))
+    {
+        return;
+    }
+
+    // the data is received into a partial file; a state file records
+    // how much of it has been checked in
+    PathName partialDirectory = GetPartialDownloadDirectory();
+    PathName partialPath = partialDirectory / dest.GetFileName();
+    partialPath.AppendExtension(PARTIAL_DOWNLOAD_SUFFIX);
+    PathName statePath = partialPath;
+    statePath.AppendExtension(PARTIAL_DOWNLOAD_STATE_SUFFIX);
+
+    size_t offset = ReadPartialDownloadState(statePath, partialPath, expectedSize, expectedDigest);
+    if (offset == 0)
+    {
+        RemovePartialDownload(partialPath, statePath);
+    }
+    Directory::Create(partialDirectory);
+
+    // open the remote file
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("going to download: {0} => {1}"), Q_(url), Q_(partialPath)));
+    unique_ptr<WebFile> webFile = offset > 0 ? webSession->OpenUrlRange(url, offset) : webSession->OpenUrl(url);
+    if (offset > 0 && webFile->GetOffset() != offset)
+    {
+        offset = 0;
+    }
+    else if (offset > 0)
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("resuming download of {0} at byte {1}"), Q_(url), offset));
+        lock_guard<mutex> lockGuard(progressIndicatorMutex);
+        progressInfo.cbPackageDownloadCompleted += offset;
+        progressInfo.cbDownloadCompleted += offset;
+    }
+
+    // open the local file
+    FileStream partialStream(File::Open(partialPath, offset > 0 ? FileMode::Open : FileMode::Create, offset > 0 ? FileAccess::ReadWrite : FileAccess::Write, false));
+    partialStream.Seek(static_cast<long>(offset), SeekOrigin::Begin);
+
+    // receive the data, checking in what has been written so far
+    size_t received = offset;
+    try
+    {
+        received += Transfer(*webFile, url, partialStream, notify, [&](size_t n) {
+            if (fflush(partialStream.GetFile()) == 0)
+            {
+                WritePartialDownloadState(statePath, expectedSize, expectedDigest, offset + n);
+            }
+        });
+        partialStream.Close();
+        webFile->Close();
+    }
+    catch (const exception&)
+    {
+        // keep what we have got for the next attempt
+        try
+        {
+            partialStream.Close();
+            size_t written = File::GetSize(partialPath);
+            if (written > 0 && written < expectedSize)
+            {
+                WritePartialDownloadState(statePath, expectedSize, expectedDigest, written);
+            }
+        }
+        catch (const exception&)
+        {
+        }
+        throw;
+    }
+
+    // verify the reassembled file; start over, if it is bad
+    if (offset > 0 && (received != expectedSize || MD5::FromFile(partialPath) != expectedDigest))
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("resumed download of {0} is corrupted; starting over"), Q_(url)));
+        RemovePartialDownload(partialPath, statePath);
+        ReceiveArchiveFile(webSession, url, dest, expectedSize, expectedDigest, notify);
+        return;
+    }
+    if (received != expectedSize)
+    {
+        RemovePartialDownload(partialPath, statePath);
         MIKTEX_FATAL_ERROR_2(FatalError(ERROR_SIZE_MISMATCH), "dest", dest.ToString(), "expectecSize", std::to_string(expectedSize), "received", std::to_string(received));
     }
+    // a fresh download is checked by the caller (the manifest might be
+    // outdated)
+    File::Move(partialPath, dest, { FileMoveOption::ReplaceExisting });
+    RemovePartialDownload(partialPath, statePath);
+    PutIntoArchiveCache(dest, expectedSize, expectedDigest);
 }
 
 void PackageInstallerImpl::OnBeginFileExtraction(const string& fileName, size_t uncompressedSize)
@@ -318,14 +721,13 @@ void PackageInstallerImpl::InstallRepositoryManifest(bool fromCache)
     }
 
     // prepare the cache directory for writing
-    if (!fromCache)
-    {
+    auto prepareCacheDirectory = [cacheDirectory]() {
         if (Directory::Exists(cacheDirectory))
         {
             Directory::Delete(cacheDirectory, true);
         }
         Directory::Create(cacheDirectory);
-    }
+    };
 
     if (fromCache)
     {
@@ -340,6 +742,11 @@ void PackageInstallerImpl::InstallRepositoryManifest(bool fromCache)
         // full path to the database file
         PathName pathZzdb1;
 
+        // the cached manifest is kept, if the server says that the
+        // database file has not been modified
+        HttpValidators validators;
+        bool modified = true;
+
         // pick up the database file
         if (repositoryType == RepositoryType::Remote)
         {
@@ -357,8 +764,17 @@ void PackageInstallerImpl::InstallRepositoryManifest(bool fromCache)
                 progressInfo.cbPackageDownloadTotal = ZZDB1_SIZE;
             }
 
-            // download the database file
-            Download(MakeUrl(MIKTEX_REPOSITORY_MANIFEST_ARCHIVE_FILE_NAME), temporaryFile->GetPathName());
+            // download the database file, unless it has been prefetched
+            string url = MakeUrl(MIKTEX_REPOSITORY_MANIFEST_ARCHIVE_FILE_NAME);
+            if (TryTakeRepositoryManifestPrefetch(url, temporaryFile, validators, modified))
+            {
+                pathZzdb1 = temporaryFile->GetPathName();
+            }
+            else
+            {
+                validators = LoadHttpValidators(cacheDirectory, cacheDirectory / PathName(MIKTEX_MPM_INI_FILENAME));
+                modified = DownloadIfModified(packageManager->GetWebSession(), url, temporaryFile->GetPathName(), validators, true);
+            }
         }
         else
         {
@@ -366,15 +782,25 @@ void PackageInstallerImpl::InstallRepositoryManifest(bool fromCache)
             pathZzdb1 = PathName(repository) / PathName(MIKTEX_REPOSITORY_MANIFEST_ARCHIVE_FILE_NAME);
         }
 
-        MiKTeX::Extractor::Extractor::CreateExtractor(DB_ARCHIVE_FILE_TYPE)->Extract(pathZzdb1, cacheDirectory);
+        if (modified)
+        {
+            prepareCacheDirectory();
+            MiKTeX::Extractor::Extractor::CreateExtractor(DB_ARCHIVE_FILE_TYPE)->Extract(pathZzdb1, cacheDirectory);
+            if (repositoryType == RepositoryType::Remote)
+            {
+                SaveHttpValidators(cacheDirectory, validators);
+            }
+        }
     }
     else if (repositoryType == RepositoryType::MiKTeXDirect)
     {
+        prepareCacheDirectory();
         size_t size;
         MyCopyFile(PathName(repository) / PathName(MIKTEXDIRECT_PREFIX_DIR) / PathName(MIKTEX_PATH_MPM_INI), cacheDirectory / PathName(MIKTEX_MPM_INI_FILENAME), size);
     }
     else if (repositoryType == RepositoryType::MiKTeXInstallation)
     {
+        prepareCacheDirectory();
         size_t size;
         MyCopyFile(PathName(repository) / PathName(MIKTEX_PATH_MPM_INI), cacheDirectory / PathName(MIKTEX_MPM_INI_FILENAME), size);
     }
@@ -408,8 +834,75 @@ void PackageInstallerImpl::LoadRepositoryManifest(bool download)
     ReportLine(fmt::format(T_("package repository digest: {0}"), repositoryManifest.GetDigest().ToString()));
 }
 
+void PackageInstallerImpl::StartRepositoryManifestPrefetch()
+{
+    if (repositoryType != RepositoryType::Remote)
+    {
+        return;
+    }
+    if (repositoryManifestPrefetch.valid())
+    {
+        // an unused prefetch is dropped
+        repositoryManifestPrefetch.wait();
+    }
+    string url = MakeUrl(MIKTEX_REPOSITORY_MANIFEST_ARCHIVE_FILE_NAME);
+    PathName cacheDirectory = session->GetSpecialPath(SpecialPath::DataRoot)
+        / PathName(MIKTEX_PATH_MIKTEX_PACKAGE_CACHE_DIR)
+        / PathName(MIKTEX_REPOSITORY_MANIFEST_ARCHIVE_FILE_NAME_NO_SUFFIX);
+    HttpValidators validators = LoadHttpValidators(cacheDirectory, cacheDirectory / PathName(MIKTEX_MPM_INI_FILENAME));
+    // the web session of the package manager is used by this thread;
+    // initialize the new session on this thread: this reads the proxy
+    // settings
+    shared_ptr<WebSession> webSession = WebSession::Create(nullptr);
+    webSession->SetCustomHeaders({});
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("prefetching {0}"), Q_(url)));
+    repositoryManifestPrefetch = std::async(launch::async, [this, url, validators, webSession]() {
+        RepositoryManifestPrefetch prefetch;
+        prefetch.url = url;
+        prefetch.timeStarted = time(nullptr);
+        prefetch.validators = validators;
+        prefetch.archiveFile = TemporaryFile::Create();
+        prefetch.modified = DownloadIfModified(webSession.get(), url, prefetch.archiveFile->GetPathName(), prefetch.validators, false);
+        return prefetch;
+    });
+}
+
+bool PackageInstallerImpl::TryTakeRepositoryManifestPrefetch(const string& url, unique_ptr<TemporaryFile>& archiveFile, HttpValidators& validators, bool& modified)
+{
+    if (!repositoryManifestPrefetch.valid())
+    {
+        return false;
+    }
+    RepositoryManifestPrefetch prefetch;
+    try
+    {
+        prefetch = repositoryManifestPrefetch.get();
+    }
+    catch (const MiKTeXException& e)
+    {
+        // not fatal: the archive file will be downloaded again
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("{0} could not be prefetched: {1}"), Q_(url), e.GetErrorMessage()));
+        return false;
+    }
+    catch (const exception& e)
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("{0} could not be prefetched: {1}"), Q_(url), e.what()));
+        return false;
+    }
+    if (prefetch.url != url || prefetch.timeStarted + REPOSITORY_MANIFEST_PREFETCH_MAX_AGE_SECONDS < time(nullptr))
+    {
+        return false;
+    }
+    archiveFile = std::move(prefetch.archiveFile);
+    validators = prefetch.validators;
+    modified = prefetch.modified;
+    ReportLine(modified ? fmt::format(T_("{0} has been prefetched"), Q_(url)) : fmt::format(T_("{0} has not been modified"), Q_(url)));
+    return true;
+}
+
 void PackageInstallerImpl::FindUpdatesNoLock()
 {
+    EventSpan eventSpan("mpm: check for updates");
     unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "checking for updates");
 
     packageDataStore->Load();
@@ -418,6 +911,19 @@ void PackageInstallerImpl::FindUpdatesNoLock()
 
     UpdateDbNoLock({});
 
+    // reuse the last result, if neither the repository manifest nor the
+    // package database have changed since
+    string updateCheckKey = GetUpdateCheckKey();
+    if (packageManager->TryGetUpdateCheckResult(updateCheckKey, updates))
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, T_("nothing has changed since the last check"));
+        session->SetConfigValue(
+            MIKTEX_CONFIG_SECTION_MPM,
+            session->IsAdminMode() ? MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE_CHECK : MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE_CHECK,
+            ConfigValue(std::to_string(time(nullptr))));
+        return;
+    }
+
     LoadRepositoryManifest(false);
 
     updates.clear();
@@ -575,12 +1081,44 @@ void PackageInstallerImpl::FindUpdatesNoLock()
         updates.push_back(updateInfo);
     }
 
+    packageManager->SetUpdateCheckResult(updateCheckKey, updates);
+
     session->SetConfigValue(
         MIKTEX_CONFIG_SECTION_MPM,
         session->IsAdminMode() ? MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE_CHECK : MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE_CHECK,
         ConfigValue(std::to_string(time(nullptr))));
 }
 
+string PackageInstallerImpl::GetUpdateCheckKey()
+{
+    PathName pathMpmIni = session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_MPM_INI);
+    if (!File::Exists(pathMpmIni))
+    {
+        return "";
+    }
+    string key = repository;
+    key += LF;
+    key += session->IsAdminMode() ? "admin" : "user";
+    key += LF;
+    key += std::to_string(static_cast<int>(repositoryReleaseState));
+    key += LF;
+    key += MD5::FromFile(pathMpmIni).ToString();
+    for (const PathName& path : {
+        session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_INI),
+        session->GetSpecialPath(SpecialPath::UserInstallRoot) / PathName(MIKTEX_PATH_PACKAGES_INI),
+        session->GetSpecialPath(SpecialPath::CommonInstallRoot) / PathName(MIKTEX_PATH_PACKAGES_INI) })
+    {
+        key += LF;
+        key += path.ToString();
+        if (File::Exists(path))
+        {
+            key += " ";
+            key += GetFileStamp(path);
+        }
+    }
+    return key;
+}
+
 void PackageInstallerImpl::FindUpdatesAsync()
 {
     StartWorkerThread(&PackageInstallerImpl::FindUpdatesThread);
@@ -720,6 +1258,7 @@ void PackageInstallerImpl::RemoveFiles(const vector<string>& toBeRemoved, bool s
             {
                 File::Delete(path, { FileDeleteOption::TryHard });
                 removedFiles.insert(path);
+                NoteChangedFontFile(path);
                 directories.insert(path.GetDirectoryName());
                 done = true;
             }
@@ -760,6 +1299,7 @@ void PackageInstallerImpl::RemoveFiles(const vector<string>& toBeRemoved, bool s
 
 void PackageInstallerImpl::RemovePackage(const string& packageId, Cfg& packageManifests)
 {
+    EventSpan eventSpan("mpm: remove package");
     trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, fmt::format(T_("going to remove {0}"), Q_(packageId)));
 
     // notify client
@@ -872,11 +1412,21 @@ void PackageInstallerImpl::MyCopyFile(const PathName& source, const PathName& de
     fromStream.Close();
     toStream.Close();
 
+    lock_guard<mutex> lockGuard(installedFilesMutex);
     installedFiles.insert(dest);
 }
 
 void PackageInstallerImpl::CopyFiles(const PathName& pathSourceRoot, const vector<string>& fileList)
 {
+    struct CopyJob
+    {
+        PathName source;
+        PathName dest;
+    };
+
+    // collect the files and create the destination folders
+    vector<CopyJob> jobs;
+    PathName lastDestFolder;
     for (const string& f : fileList)
     {
         Notify();
@@ -900,34 +1450,132 @@ void PackageInstallerImpl::CopyFiles(const PathName& pathSourceRoot, const vecto
         PathName pathDestFolder(pathDest);
         pathDestFolder.RemoveFileSpec();
 
-        // notify client: beginning of file copy operation
-        Notify(Notification::InstallFileStart);
-
         // create the destination folder
-        Directory::Create(pathDestFolder);
+        if (pathDestFolder != lastDestFolder)
+        {
+            Directory::Create(pathDestFolder);
+            lastDestFolder = pathDestFolder;
+        }
+
+        jobs.push_back({ pathSource, pathDest });
+    }
 
+    if (jobs.empty())
+    {
+        return;
+    }
+
+    // copy the files on a bounded number of threads; this thread
+    // reports the progress as the copy operations complete
+    mutex jobMutex;
+    condition_variable jobDone;
+    size_t nextJob = 0;
+    vector<pair<size_t, size_t>> completedJobs;
+    exception_ptr jobError;
+    bool stopping = false;
+    auto worker = [&]()
+    {
+        while (true)
         {
-            lock_guard<mutex> lockGuard(progressIndicatorMutex);
-            progressInfo.fileName = pathDest;
+            size_t idx;
+            {
+                lock_guard<mutex> lockGuard(jobMutex);
+                if (stopping || nextJob == jobs.size())
+                {
+                    return;
+                }
+                idx = nextJob++;
+            }
+            try
+            {
+                size_t size;
+                MyCopyFile(jobs[idx].source, jobs[idx].dest, size);
+                lock_guard<mutex> lockGuard(jobMutex);
+                completedJobs.push_back({ idx, size });
+            }
+            catch (const exception&)
+            {
+                lock_guard<mutex> lockGuard(jobMutex);
+                if (jobError == nullptr)
+                {
+                    jobError = current_exception();
+                }
+                stopping = true;
+            }
+            jobDone.notify_one();
+        }
+    };
+    size_t numThreads = std::min<size_t>(std::max(thread::hardware_concurrency(), 1u), MAX_COPY_THREADS);
+    numThreads = std::min(numThreads, jobs.size());
+    vector<thread> threads;
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        threads.push_back(thread(worker));
+    }
+    auto joinThreads = [&]()
+    {
+        for (thread& t : threads)
+        {
+            t.join();
         }
+    };
 
-        size_t size;
+    try
+    {
+        size_t numCompleted = 0;
+        while (numCompleted < jobs.size())
+        {
+            vector<pair<size_t, size_t>> batch;
+            {
+                unique_lock<mutex> lock(jobMutex);
+                jobDone.wait(lock, [&]() { return !completedJobs.empty() || jobError != nullptr; });
+                if (completedJobs.empty())
+                {
+                    break;
+                }
+                batch.swap(completedJobs);
+            }
+            for (const pair<size_t, size_t>& c : batch)
+            {
+                // notify client: beginning of file copy operation
+                {
+                    lock_guard<mutex> lockGuard(progressIndicatorMutex);
+                    progressInfo.fileName = jobs[c.first].dest;
+                }
+                Notify(Notification::InstallFileStart);
+
+                // update progress info
+                {
+                    lock_guard<mutex> lockGuard(progressIndicatorMutex);
+                    progressInfo.fileName = "";
+                    progressInfo.cFilesPackageInstallCompleted += 1;
+                    progressInfo.cFilesInstallCompleted += 1;
+                    progressInfo.cbPackageInstallCompleted += c.second;
+                    progressInfo.cbInstallCompleted += c.second;
+                }
 
-        // copy the file
-        MyCopyFile(pathSource, pathDest, size);
+                // notify client: end of file copy operation
+                Notify(Notification::InstallFileEnd);
 
-        // update progress info
+                numCompleted += 1;
+            }
+        }
+    }
+    catch (const exception&)
+    {
         {
-            lock_guard<mutex> lockGuard(progressIndicatorMutex);
-            progressInfo.fileName = "";
-            progressInfo.cFilesPackageInstallCompleted += 1;
-            progressInfo.cFilesInstallCompleted += 1;
-            progressInfo.cbPackageInstallCompleted += size;
-            progressInfo.cbInstallCompleted += size;
+            lock_guard<mutex> lockGuard(jobMutex);
+            stopping = true;
         }
+        joinThreads();
+        throw;
+    }
+
+    joinThreads();
 
-        // notify client: end of file copy operation
-        Notify(Notification::InstallFileEnd);
+    if (jobError != nullptr)
+    {
+        rethrow_exception(jobError);
     }
 }
 
@@ -983,34 +1631,66 @@ MPMSTATICFUNC(unordered_set<PathName>) GetFiles(const PathName& rootDir, const P
 
 void PackageInstallerImpl::UpdateFndb(const unordered_set<PathName>& installedFiles, const unordered_set<PathName>& removedFiles, const string& packageId)
 {
-    vector<PathName> toBeRemoved;
+    // the changes are collected here and applied once per transaction
+    // (see FlushFndbUpdates())
     for (const PathName& f : removedFiles)
     {
-        if (installedFiles.find(f) == installedFiles.end() && Fndb::FileExists(f))
+        if (installedFiles.find(f) == installedFiles.end())
         {
-            toBeRemoved.push_back(f);
+            fndbToBeAdded.erase(f);
+            if (Fndb::FileExists(f))
+            {
+                fndbToBeRemoved.insert(f);
+            }
         }
     }
-    if (!toBeRemoved.empty())
-    {
-        Fndb::Remove(toBeRemoved);
-    }
-    vector<Fndb::Record> toBeAdded;
     for (const PathName& f : installedFiles)
     {
-        if (!Fndb::FileExists(f))
+        if (fndbToBeAdded.find(f) == fndbToBeAdded.end() && (fndbToBeRemoved.find(f) != fndbToBeRemoved.end() || !Fndb::FileExists(f)))
         {
-            toBeAdded.push_back({ f, packageId });
+            fndbToBeAdded[f] = packageId;
         }
     }
-    if (!toBeAdded.empty())
+}
+
+// remembers the directory of an installed/removed TrueType/OpenType font
+// file: only the fontconfig caches of these directories need to be
+// refreshed (see PostProcess())
+void PackageInstallerImpl::NoteChangedFontFile(const PathName& path)
+{
+    PathName dir = path.GetDirectoryName();
+    string unixDir = dir.ToUnix().ToString() + "/";
+    if (unixDir.find("/fonts/opentype/") != string::npos || unixDir.find("/fonts/truetype/") != string::npos)
+    {
+        changedFontDirectories.insert(dir);
+    }
+}
+
+void PackageInstallerImpl::FlushFndbUpdates()
+{
+    if (!fndbToBeRemoved.empty())
+    {
+        vector<PathName> toBeRemoved(fndbToBeRemoved.begin(), fndbToBeRemoved.end());
+        fndbToBeRemoved.clear();
+        Fndb::Remove(toBeRemoved);
+    }
+    if (!fndbToBeAdded.empty())
     {
+        vector<Fndb::Record> toBeAdded;
+        toBeAdded.reserve(fndbToBeAdded.size());
+        for (const auto& kv : fndbToBeAdded)
+        {
+            toBeAdded.push_back({ kv.first, kv.second });
+        }
+        fndbToBeAdded.clear();
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("adding {0} file(s) to the file name database"), toBeAdded.size()));
         Fndb::Add(toBeAdded);
     }
 }
 
 void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageManifests)
 {
+    EventSpan eventSpan("mpm: install package");
     trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, fmt::format(T_("installing package {0}"), Q_(packageId)));
 
     // search the package table
@@ -1051,9 +1731,17 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
         if (repositoryType == RepositoryType::Remote)
         {
             // take hold of the package
-            temporaryFile = TemporaryFile::Create();
-            pathArchiveFile = temporaryFile->GetPathName();
-            Download(MakeUrl(packageFileName.ToString()), temporaryFile->GetPathName());
+            pathArchiveFile = WaitForDownload(packageId);
+            if (!pathArchiveFile.Empty())
+            {
+                temporaryFile = TemporaryFile::Create(pathArchiveFile);
+            }
+            else
+            {
+                temporaryFile = TemporaryFile::Create();
+                pathArchiveFile = temporaryFile->GetPathName();
+                DownloadArchiveFile(packageId, MakeUrl(packageFileName.ToString()), temporaryFile->GetPathName());
+            }
         }
         else
         {
@@ -1127,6 +1815,11 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
     UpdateFndb(installedFiles, removedFiles, "");
     UpdateFndb(GetFiles(session->GetMpmRootPath(), newPackage), GetFiles(session->GetMpmRootPath(), package), packageId);
 
+    for (const PathName& f : installedFiles)
+    {
+        NoteChangedFontFile(f);
+    }
+
     // set the timeInstalled value => package is installed
     time_t now = time(nullptr);
     newPackage.SetTimeInstalled(now, session->IsAdminMode() ? ConfigurationScope::Common : ConfigurationScope::User);
@@ -1152,8 +1845,7 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
 
 void PackageInstallerImpl::DownloadPackage(const string& packageId)
 {
-    size_t expectedSize;
-
+    EventSpan eventSpan("mpm: download package");
     NeedRepository();
 
     // update progress info
@@ -1164,7 +1856,6 @@ void PackageInstallerImpl::DownloadPackage(const string& packageId)
         MIKTEX_ASSERT(repositoryType == RepositoryType::Remote);
         progressInfo.cbPackageDownloadCompleted = 0;
         progressInfo.cbPackageDownloadTotal = repositoryManifest.GetArchiveFileSize(packageId);
-        expectedSize = progressInfo.cbPackageDownloadTotal;
     }
 
     // notify client: beginning of package download
@@ -1175,8 +1866,13 @@ void PackageInstallerImpl::DownloadPackage(const string& packageId)
     PathName pathArchiveFile(packageId);
     pathArchiveFile.AppendExtension(MiKTeX::Extractor::Extractor::GetFileNameExtension(aft));
 
-    // download the archive file
-    Download(pathArchiveFile, expectedSize);
+    // download the archive file, unless it has been scheduled
+    if (WaitForDownload(packageId).Empty())
+    {
+        unique_ptr<TemporaryFile> temporaryFile = TemporaryFile::Create(downloadDirectory / pathArchiveFile);
+        DownloadArchiveFile(packageId, MakeUrl(pathArchiveFile.ToString()), temporaryFile->GetPathName());
+        temporaryFile->Keep();
+    }
 
     // check to see whether the archive file is ok
     CheckArchiveFile(packageId, downloadDirectory / pathArchiveFile, true);
@@ -1185,6 +1881,306 @@ void PackageInstallerImpl::DownloadPackage(const string& packageId)
     Notify(Notification::DownloadPackageEnd);
 }
 
+unsigned PackageInstallerImpl::GetMaxConcurrentDownloads()
+{
+    int maxConcurrentDownloads = session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_MAX_CONCURRENT_DOWNLOADS, ConfigValue(DEFAULT_MAX_CONCURRENT_DOWNLOADS)).GetInt();
+    return maxConcurrentDownloads > 0 ? maxConcurrentDownloads : 1;
+}
+
+MPMSTATICFUNC(string) WithoutTrailingSlash(const string& url)
+{
+    return !url.empty() && url.back() == '/' ? url.substr(0, url.length() - 1) : url;
+}
+
+vector<string> PackageInstallerImpl::FindMirrors()
+{
+    vector<string> result{ repository };
+    int maxMirrors = session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_MAX_MIRRORS, ConfigValue(DEFAULT_MAX_MIRRORS)).GetInt();
+    if (maxMirrors <= 1)
+    {
+        return result;
+    }
+    try
+    {
+        packageManager->DownloadRepositoryList();
+        vector<RepositoryInfo> repositories = packageManager->GetRepositories();
+        auto primary = find_if(repositories.begin(), repositories.end(), [this](const RepositoryInfo& r) { return WithoutTrailingSlash(r.url) == WithoutTrailingSlash(repository); });
+        if (primary == repositories.end())
+        {
+            // not a known mirror: the other mirrors might serve different files
+            return result;
+        }
+        vector<RepositoryInfo> candidates;
+        for (const RepositoryInfo& r : repositories)
+        {
+            if (r != *primary
+                && r.type == RepositoryType::Remote
+                && r.status != RepositoryStatus::Offline
+                && r.integrity != RepositoryIntegrity::Corrupted
+                && r.releaseState == primary->releaseState
+                && r.version == primary->version)
+            {
+                candidates.push_back(r);
+            }
+        }
+        // fastest first; unmeasured mirrors are ordered by the server's ranking
+        sort(candidates.begin(), candidates.end(), [](const RepositoryInfo& lhs, const RepositoryInfo& rhs) {
+            return lhs.dataTransferRate != rhs.dataTransferRate ? lhs.dataTransferRate > rhs.dataTransferRate : lhs.ranking < rhs.ranking;
+        });
+        for (const RepositoryInfo& r : candidates)
+        {
+            if (result.size() >= static_cast<size_t>(maxMirrors))
+            {
+                break;
+            }
+            result.push_back(r.url);
+        }
+    }
+    catch (const MiKTeXException& e)
+    {
+        // not fatal: download everything from the primary repository
+        trace_error->WriteLine(TRACE_FACILITY, TraceLevel::Error, fmt::format(T_("could not find mirrors: {0}"), e.GetErrorMessage()));
+    }
+    return result;
+}
+
+void PackageInstallerImpl::StartDownloads(const vector<string>& packages, const PathName& directory)
+{
+    MIKTEX_ASSERT(downloadThreads.empty());
+    maxTransfersPerMirror = GetMaxConcurrentDownloads();
+    if (maxTransfersPerMirror <= 1 || packages.size() <= 1)
+    {
+        // the archive files will be downloaded one after another
+        return;
+    }
+    mirrors.clear();
+    vector<RepositoryInfo> repositories = packageManager->GetRepositories();
+    for (const string& url : FindMirrors())
+    {
+        Mirror mirror;
+        mirror.url = url;
+        for (const RepositoryInfo& r : repositories)
+        {
+            if (r.url == url)
+            {
+                mirror.bytesPerSecond = r.dataTransferRate;
+                break;
+            }
+        }
+        mirrors.push_back(mirror);
+    }
+    size_t numThreads = min<size_t>(static_cast<size_t>(maxTransfersPerMirror) * mirrors.size(), packages.size());
+    scheduledDownloads.clear();
+    scheduledDownloadIndex.clear();
+    for (const string& packageId : packages)
+    {
+        ArchiveFileType aft = repositoryManifest.GetArchiveFileType(packageId);
+        PathName archiveFileName(packageId);
+        archiveFileName.AppendExtension(MiKTeX::Extractor::Extractor::GetFileNameExtension(aft));
+        ScheduledDownload download;
+        download.fileName = archiveFileName.ToString();
+        download.path = directory / archiveFileName;
+        download.expectedSize = repositoryManifest.GetArchiveFileSize(packageId);
+        download.digest = repositoryManifest.GetArchiveFileDigest(packageId);
+        scheduledDownloadIndex[packageId] = scheduledDownloads.size();
+        scheduledDownloads.push_back(download);
+    }
+    nextScheduledDownload = 0;
+    stopDownloads = false;
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("downloading {0} archive files from {1} mirror(s) with {2} concurrent transfers"), packages.size(), mirrors.size(), numThreads));
+    for (size_t idx = 0; idx < numThreads; ++idx)
+    {
+        shared_ptr<WebSession> webSession = WebSession::Create(nullptr);
+        // initialize the session on this thread: this reads the proxy settings
+        webSession->SetCustomHeaders({});
+        downloadThreads.push_back(thread(&PackageInstallerImpl::ScheduledDownloadThread, this, webSession));
+    }
+}
+
+size_t PackageInstallerImpl::PickMirror(const vector<bool>& tried)
+{
+    // prefer the mirror with the best expected throughput per
+    // transfer; mirrors which have not been measured yet get a chance
+    // first
+    size_t best = mirrors.size();
+    double bestScore = 0.0;
+    for (int pass = 0; pass < 2 && best == mirrors.size(); ++pass)
+    {
+        for (size_t idx = 0; idx < mirrors.size(); ++idx)
+        {
+            const Mirror& mirror = mirrors[idx];
+            if (tried[idx] || (pass == 0 && mirror.activeTransfers >= maxTransfersPerMirror))
+            {
+                continue;
+            }
+            double rate = mirror.bytesPerSecond > 0 ? mirror.bytesPerSecond : UNMEASURED_BYTES_PER_SECOND;
+            double score = rate / (1 + mirror.activeTransfers) / (1 + 4 * mirror.failures);
+            if (best == mirrors.size() || score > bestScore)
+            {
+                best = idx;
+                bestScore = score;
+            }
+        }
+    }
+    return best;
+}
+
+void PackageInstallerImpl::ScheduledDownloadThread(shared_ptr<WebSession> webSession)
+{
+    while (true)
+    {
+        ScheduledDownload* download;
+        {
+            lock_guard<mutex> lockGuard(downloadMutex);
+            if (stopDownloads || nextScheduledDownload == scheduledDownloads.size())
+            {
+                break;
+            }
+            download = &scheduledDownloads[nextScheduledDownload++];
+        }
+        exception_ptr error;
+        // a failed or stalled transfer is restarted on the next best mirror
+        vector<bool> tried(mirrors.size(), false);
+        while (!stopDownloads)
+        {
+            size_t mirrorIdx;
+            string mirrorUrl;
+            {
+                lock_guard<mutex> lockGuard(downloadMutex);
+                mirrorIdx = PickMirror(tried);
+                if (mirrorIdx == mirrors.size())
+                {
+                    break;
+                }
+                tried[mirrorIdx] = true;
+                mirrors[mirrorIdx].activeTransfers += 1;
+                mirrorUrl = mirrors[mirrorIdx].url;
+            }
+            chrono::time_point<chrono::steady_clock> start = chrono::steady_clock::now();
+            bool ok = false;
+            bool cancelled = false;
+            try
+            {
+                ReceiveArchiveFile(webSession.get(), ::MakeUrl(mirrorUrl, download->fileName), download->path, download->expectedSize, download->digest, false);
+                ok = true;
+                error = nullptr;
+            }
+            catch (const OperationCancelledException&)
+            {
+                error = current_exception();
+                cancelled = true;
+            }
+            catch (const exception&)
+            {
+                error = current_exception();
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            {
+                lock_guard<mutex> lockGuard(downloadMutex);
+                Mirror& mirror = mirrors[mirrorIdx];
+                mirror.activeTransfers -= 1;
+                if (ok)
+                {
+                    if (seconds > 0 && download->expectedSize > 0)
+                    {
+                        double bytesPerSecond = download->expectedSize / seconds;
+                        mirror.bytesPerSecond = mirror.bytesPerSecond > 0 ? 0.7 * mirror.bytesPerSecond + 0.3 * bytesPerSecond : bytesPerSecond;
+                        mirror.bytesReceived += download->expectedSize;
+                        mirror.secondsElapsed += seconds;
+                    }
+                }
+                else if (!cancelled)
+                {
+                    mirror.failures += 1;
+                }
+            }
+            if (ok || cancelled)
+            {
+                break;
+            }
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("{0} could not be downloaded from {1}"), Q_(download->fileName), Q_(mirrorUrl)));
+            try
+            {
+                if (File::Exists(download->path))
+                {
+                    File::Delete(download->path);
+                }
+            }
+            catch (const exception&)
+            {
+            }
+        }
+        {
+            lock_guard<mutex> lockGuard(downloadMutex);
+            download->done = true;
+            download->error = error;
+        }
+        downloadCondition.notify_all();
+    }
+    try
+    {
+        webSession->Dispose();
+    }
+    catch (const exception&)
+    {
+    }
+}
+
+PathName PackageInstallerImpl::WaitForDownload(const string& packageId)
+{
+    auto it = scheduledDownloadIndex.find(packageId);
+    if (it == scheduledDownloadIndex.end())
+    {
+        return PathName();
+    }
+    ScheduledDownload& download = scheduledDownloads[it->second];
+    scheduledDownloadIndex.erase(it);
+    unique_lock<mutex> lock(downloadMutex);
+    while (!download.done)
+    {
+        downloadCondition.wait_for(lock, chrono::milliseconds(DOWNLOAD_WAIT_INTERVAL_MILLISECONDS));
+        if (!download.done)
+        {
+            // keep the client informed; this also allows the client to cancel
+            lock.unlock();
+            Notify();
+            lock.lock();
+        }
+    }
+    if (download.error != nullptr)
+    {
+        rethrow_exception(download.error);
+    }
+    return download.path;
+}
+
+void PackageInstallerImpl::StopDownloads()
+{
+    stopDownloads = true;
+    for (thread& t : downloadThreads)
+    {
+        t.join();
+    }
+    downloadThreads.clear();
+    // remember the measured throughput for the next mirror ranking
+    for (const Mirror& mirror : mirrors)
+    {
+        if (mirror.secondsElapsed > 0)
+        {
+            try
+            {
+                packageManager->RecordDataTransferRate(mirror.url, mirror.bytesReceived / mirror.secondsElapsed);
+            }
+            catch (const exception&)
+            {
+            }
+        }
+    }
+    mirrors.clear();
+    scheduledDownloadIndex.clear();
+    scheduledDownloads.clear();
+}
+
 void PackageInstallerImpl::CalculateExpenditure(bool downloadOnly)
 {
     ProgressInfo package;
@@ -1743,35 +2739,70 @@ void PackageInstallerImpl::InstallRemove(Role role)
             packageManifests->Read(packageManifestsIni);
         }
 
-        // install packages
-        for (const string& p : toBeInstalled)
+        // download the archive files in the background while the
+        // packages are being installed
+        unique_ptr<TemporaryDirectory> downloadCache;
+        if (repositoryType == RepositoryType::Remote && toBeInstalled.size() > 1 && GetMaxConcurrentDownloads() > 1)
         {
-            InstallPackage(p, *packageManifests);
+            downloadCache = TemporaryDirectory::Create();
+            StartDownloads(toBeInstalled, downloadCache->GetPathName());
         }
 
-        // remove packages
-        for (const string& p : toBeRemoved)
+        try
         {
-            RemovePackage(p, *packageManifests);
-        }
+            // install packages
+            for (const string& p : toBeInstalled)
+            {
+                InstallPackage(p, *packageManifests);
+            }
 
-        if (role == Role::Updater)
-        {
-            session->SetConfigValue(
-                MIKTEX_CONFIG_SECTION_MPM,
-                session->IsAdminMode() ? MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE : MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE,
-                ConfigValue(std::to_string(time(nullptr))));
-        }
+            // remove packages
+            for (const string& p : toBeRemoved)
+            {
+                RemovePackage(p, *packageManifests);
+            }
 
-        // check dependencies (install missing required packages)
-        tmp.clear();
-        for (const string& p : toBeInstalled)
+            if (role == Role::Updater)
+            {
+                session->SetConfigValue(
+                    MIKTEX_CONFIG_SECTION_MPM,
+                    session->IsAdminMode() ? MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE : MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE,
+                    ConfigValue(std::to_string(time(nullptr))));
+            }
+
+            // check dependencies (install missing required packages)
+            tmp.clear();
+            for (const string& p : toBeInstalled)
+            {
+                CheckDependencies(tmp, p, false, 0);
+            }
+            for (const string& p : tmp)
+            {
+                InstallPackage(p, *packageManifests);
+            }
+        }
+        catch (const exception&)
         {
-            CheckDependencies(tmp, p, false, 0);
+            StopDownloads();
+            // keep the file name database in line with the packages
+            // which have been installed so far
+            try
+            {
+                FlushFndbUpdates();
+            }
+            catch (const exception&)
+            {
+            }
+            throw;
         }
-        for (const string& p : tmp)
+
+        StopDownloads();
+
+        // update the file name database (unless this is done when the
+        // transaction is committed)
+        if (!inTransaction)
         {
-            InstallPackage(p, *packageManifests);
+            FlushFndbUpdates();
         }
 
         if (File::Exists(packageManifestsIni))
@@ -1783,55 +2814,104 @@ void PackageInstallerImpl::InstallRemove(Role role)
     }
     MPM_LOCK_END();
 
-    if (enablePostProcessing)
+    if (inTransaction)
     {
-        RegisterComponents(true, toBeInstalled);
+        // post-processing is deferred until the transaction is committed
+        transactionInstalled.insert(toBeInstalled.begin(), toBeInstalled.end());
+        transactionPending = true;
     }
+    else if (enablePostProcessing)
+    {
+        PostProcess(toBeInstalled);
+    }
+}
+
+void PackageInstallerImpl::BeginTransaction()
+{
+    if (inTransaction)
+    {
+        MIKTEX_UNEXPECTED();
+    }
+    inTransaction = true;
+    transactionInstalled.clear();
+    transactionPending = false;
+}
+
+void PackageInstallerImpl::CommitTransaction()
+{
+    if (!inTransaction)
+    {
+        MIKTEX_UNEXPECTED();
+    }
+    inTransaction = false;
+    MPM_LOCK_BEGIN(this->packageManager)
+    {
+        FlushFndbUpdates();
+    }
+    MPM_LOCK_END();
+    if (transactionPending && enablePostProcessing)
+    {
+        PostProcess(vector<string>(transactionInstalled.begin(), transactionInstalled.end()));
+    }
+    transactionInstalled.clear();
+    transactionPending = false;
+}
+
+void PackageInstallerImpl::PostProcess(const vector<string>& installedPackages)
+{
+    RegisterComponents(true, installedPackages);
 
-    if (enablePostProcessing)
+    // fontconfig caches are only refreshed for the font directories
+    // which have changed
+    unique_ptr<TemporaryFile> changedFontDirectoriesFile = TemporaryFile::Create();
+    ofstream stream = File::CreateOutputStream(changedFontDirectoriesFile->GetPathName());
+    for (const PathName& dir : changedFontDirectories)
+    {
+        stream << dir.ToString() << "\n";
+    }
+    stream.close();
+    changedFontDirectories.clear();
+    RunOneMiKTeXUtility({ "fontmaps", "configure", "--changed-font-directories", changedFontDirectoriesFile->GetPathName().ToString() });
+    if (session->IsAdminMode())
+    {
+        RunOneMiKTeXUtility({ "links", "install" });
+    }
+    else
     {
-        RunOneMiKTeXUtility({ "fontmaps", "configure" });
-        if (session->IsAdminMode())
+#if defined(MIKTEX_UNIX)
+        // FIXME: duplicate code (initexmf.cpp)
+        PathName scriptsIni;
+        if (!session->FindFile(MIKTEX_PATH_SCRIPTS_INI, MIKTEX_PATH_TEXMF_PLACEHOLDER, scriptsIni))
         {
-            RunOneMiKTeXUtility({ "links", "install" });
+            MIKTEX_FATAL_ERROR(T_("Script configuration file not found."));
         }
-        else
+        unique_ptr<Cfg> config(Cfg::Create());
+        config->Read(scriptsIni, true);
+        for (const shared_ptr<Cfg::Key>& key : *config)
         {
-#if defined(MIKTEX_UNIX)
-            // FIXME: duplicate code (initexmf.cpp)
-            PathName scriptsIni;
-            if (!session->FindFile(MIKTEX_PATH_SCRIPTS_INI, MIKTEX_PATH_TEXMF_PLACEHOLDER, scriptsIni))
+            if (key->GetName() != "sh" && key->GetName() != "exe")
             {
-                MIKTEX_FATAL_ERROR(T_("Script configuration file not found."));
+                continue;
             }
-            unique_ptr<Cfg> config(Cfg::Create());
-            config->Read(scriptsIni, true);
-            for (const shared_ptr<Cfg::Key>& key : *config)
+            for (const shared_ptr<Cfg::Value>& val : *key)
             {
-                if (key->GetName() != "sh" && key->GetName() != "exe")
+                if (EndsWith(val->GetName(), "[]"))
                 {
                     continue;
                 }
-                for (const shared_ptr<Cfg::Value>& val : *key)
+                PathName scriptPath;
+                if (!session->FindFile(session->Expand(val->AsString()), MIKTEX_PATH_TEXMF_PLACEHOLDER_NO_MPM, scriptPath))
                 {
-                    if (EndsWith(val->GetName(), "[]"))
-                    {
-                        continue;
-                    }
-                    PathName scriptPath;
-                    if (!session->FindFile(session->Expand(val->AsString()), MIKTEX_PATH_TEXMF_PLACEHOLDER_NO_MPM, scriptPath))
-                    {
-                        continue;
-                    }
-                    if (session->GetRootDirectories()[session->DeriveTEXMFRoot(scriptPath)].IsCommon() && !session->IsAdminMode())
-                    {
-                        continue;
-                    }
-                    File::SetAttributes(scriptPath, File::GetAttributes(scriptPath) + FileAttribute::Executable);
+                    continue;
+                }
+                if (session->GetRootDirectories()[session->DeriveTEXMFRoot(scriptPath)].IsCommon() && !session->IsAdminMode())
+                {
+                    continue;
                 }
+                File::SetAttributes(scriptPath, File::GetAttributes(scriptPath) + FileAttribute::Executable);
             }
-#endif
         }
+#endif
     }
 }
 
@@ -1959,10 +3039,20 @@ void PackageInstallerImpl::Download()
     Download(PathName(MIKTEX_PACKAGE_MANIFESTS_ARCHIVE_FILE_NAME));
 
     // download archive files
-    for (const string& p : toBeInstalled)
+    StartDownloads(toBeInstalled, downloadDirectory);
+    try
+    {
+        for (const string& p : toBeInstalled)
+        {
+            DownloadPackage(p);
+        }
+    }
+    catch (const exception&)
     {
-        DownloadPackage(p);
+        StopDownloads();
+        throw;
     }
+    StopDownloads();
 }
 
 void PackageInstallerImpl::DownloadAsync()
@@ -2103,6 +3193,7 @@ void PackageInstallerImpl::HandleObsoletePackageManifests(Cfg& existingManifests
 
 void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
 {
+    EventSpan eventSpan("mpm: update package database");
     unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "update package database");
 
     packageDataStore->Load();
@@ -2146,6 +3237,10 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
         {
             repositoryReleaseState = packageManager->VerifyPackageRepository(repository).releaseState;
         }
+
+        // get the repository manifest while the package manifests are
+        // being updated
+        StartRepositoryManifestPrefetch();
     }
 
     PathName cacheDirectory;
@@ -2177,15 +3272,13 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
             / PathName(MIKTEX_PACKAGE_MANIFESTS_ARCHIVE_FILE_NAME_NO_SUFFIX);
     }
 
-    // prepare the cache directory for writing
-    if (!options[UpdateDbOption::FromCache])
-    {
-        if (Directory::Exists(cacheDirectory))
-        {
-            Directory::Delete(cacheDirectory, true);
-        }
-        Directory::Create(cacheDirectory);
-    }
+    PathName existingPackageManifestsIni = session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_INI);
+
+    // the validators of the archive file; the stamp identifies the
+    // package-manifests.ini which was written when the archive file was
+    // merged
+    HttpValidators validators;
+    bool modified = true;
 
     if (!options[UpdateDbOption::FromCache])
     {
@@ -2196,10 +3289,11 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
 
         if (repositoryType == RepositoryType::Remote)
         {
-            // download the archive file
+            // download the archive file, unless it has not been modified
             temporaryFile = TemporaryFile::Create();
             archivePath = temporaryFile->GetPathName();
-            Download(MakeUrl(MIKTEX_PACKAGE_MANIFESTS_ARCHIVE_FILE_NAME), archivePath);
+            validators = LoadHttpValidators(cacheDirectory, cacheDirectory / PathName(MIKTEX_PACKAGE_MANIFESTS_INI_FILENAME));
+            modified = DownloadIfModified(packageManager->GetWebSession(), MakeUrl(MIKTEX_PACKAGE_MANIFESTS_ARCHIVE_FILE_NAME), archivePath, validators, true);
         }
         else
         {
@@ -2207,8 +3301,35 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
             archivePath = PathName(repository) / PathName(MIKTEX_PACKAGE_MANIFESTS_ARCHIVE_FILE_NAME);
         }
 
-        // extract package-manifests.ini into cache directory
-        MiKTeX::Extractor::Extractor::CreateExtractor(DB_ARCHIVE_FILE_TYPE)->Extract(archivePath, cacheDirectory);
+        if (modified)
+        {
+            // prepare the cache directory for writing
+            if (Directory::Exists(cacheDirectory))
+            {
+                Directory::Delete(cacheDirectory, true);
+            }
+            Directory::Create(cacheDirectory);
+
+            // extract package-manifests.ini into cache directory
+            MiKTeX::Extractor::Extractor::CreateExtractor(DB_ARCHIVE_FILE_TYPE)->Extract(archivePath, cacheDirectory);
+        }
+    }
+
+    // nothing to do, if the archive file is the same and has already
+    // been merged into the existing package-manifests.ini
+    if (!modified
+        && !validators.stamp.empty()
+        && File::Exists(existingPackageManifestsIni)
+        && validators.stamp == GetFileStamp(existingPackageManifestsIni))
+    {
+        ReportLine(T_("package manifests are up to date"));
+        InstallRepositoryManifest(false);
+        repositoryManifest.Clear();
+        session->SetConfigValue(
+            MIKTEX_CONFIG_SECTION_MPM,
+            session->IsAdminMode() ? MIKTEX_CONFIG_VALUE_LAST_ADMIN_UPDATE_DB : MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE_DB,
+            ConfigValue(std::to_string(time(nullptr))));
+        return;
     }
 
     // load cached package-manifests.ini
@@ -2223,7 +3344,6 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
     // load existing package-manifests.ini
     unique_ptr<Cfg> existingManifests = Cfg::Create();
     packageDataStore->NeedPackageManifestsIni();
-    PathName existingPackageManifestsIni = session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANIFESTS_INI);
     if (File::Exists(existingPackageManifestsIni))
     {
         existingManifests->Read(existingPackageManifestsIni);
@@ -2233,7 +3353,7 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
 
     // update the package manifests
     ReportLine(fmt::format(T_("updating package manifests ({0})..."), Q_(existingPackageManifestsIni)));
-    size_t count = 0;
+    vector<string> toBeInstalled;
     for (auto key : *newManifests)
     {
         string packageId = key->GetName();
@@ -2255,19 +3375,33 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
             existingManifests->DeleteKey(packageId);
         }
 
+        toBeInstalled.push_back(packageId);
+    }
+
+    // parse the new manifests concurrently
+    vector<PackageInfo> packageManifests = PackageDataStore::GetPackageManifests(*newManifests, toBeInstalled);
+
+    Notify();
+
+    for (const PackageInfo& packageInfo : packageManifests)
+    {
         // install the new manifest
-        PackageInfo packageInfo = PackageManager::GetPackageManifest(*newManifests, packageId, TEXMF_PREFIX_DIRECTORY);
         PackageManager::PutPackageManifest(*existingManifests, packageInfo, packageInfo.timePackaged);
 
         // update the package table
         packageDataStore->DefinePackage(packageInfo);
-
-        ++count;
     }
+    size_t count = packageManifests.size();
 
     // write package-manifests.ini
     existingManifests->Write(existingPackageManifestsIni);
 
+    if (!options[UpdateDbOption::FromCache] && repositoryType == RepositoryType::Remote)
+    {
+        validators.stamp = GetFileStamp(existingPackageManifestsIni);
+        SaveHttpValidators(cacheDirectory, validators);
+    }
+
     ReportLine(fmt::format(T_("installed {0} package manifests"), count));
 
     // clean up the user database
@@ -2287,6 +3421,9 @@ void PackageInstallerImpl::UpdateDbNoLock(UpdateDbOptionSet options)
     // create the MPM file name database
     packageManager->CreateMpmFndbNoLock();
 
+    // create the documentation index
+    packageManager->CreateDocIndexNoLock();
+
     if (!options[UpdateDbOption::FromCache])
     {
         session->SetConfigValue(
@@ -2376,6 +3513,10 @@ void PackageInstallerImpl::Dispose()
     {
         workerThread.detach();
     }
+    if (repositoryManifestPrefetch.valid())
+    {
+        repositoryManifestPrefetch.wait();
+    }
     if (trace_mpm.get() != nullptr)
     {
         trace_mpm->Close();
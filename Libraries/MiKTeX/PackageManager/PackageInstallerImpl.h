@@ -13,13 +13,22 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <miktex/Core/Cfg>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/MD5>
 #include <miktex/Core/Session>
 #include <miktex/Core/TemporaryFile>
 #include <miktex/Extractor/Extractor>
@@ -27,6 +36,7 @@
 
 #include "PackageManagerImpl.h"
 #include "RepositoryManifest.h"
+#include "WebSession.h"
 
 #if defined(MIKTEX_WINDOWS)
 #include <miktex/Core/win/COMInitializer>
@@ -54,6 +64,8 @@ public:
     PackageInstallerImpl(std::shared_ptr<MiKTeX::Packages::D6AAD62216146D44B580E92711724B78::PackageManagerImpl> manager, const InitInfo& initInfo);
     MIKTEXTHISCALL ~PackageInstallerImpl() override;
 
+    void MIKTEXTHISCALL BeginTransaction() override;
+    void MIKTEXTHISCALL CommitTransaction() override;
     void MIKTEXTHISCALL Dispose() override;
     void MIKTEXTHISCALL Download() override;
     void MIKTEXTHISCALL DownloadAsync() override;
@@ -179,22 +191,52 @@ private:
     void CopyPackage(const MiKTeX::Util::PathName& pathSourceRoot, const std::string& packageId);
     void Download(const MiKTeX::Util::PathName& fileName, std::size_t expectedSize = 0);
     void Download(const std::string& url, const MiKTeX::Util::PathName& dest, std::size_t expectedSize = 0);
+    struct HttpValidators
+    {
+        std::string url;
+        std::string etag;
+        std::string lastModified;
+        std::string stamp;
+    };
+    bool DownloadIfModified(WebSession* webSession, const std::string& url, const MiKTeX::Util::PathName& dest, HttpValidators& validators, bool notify);
+    HttpValidators LoadHttpValidators(const MiKTeX::Util::PathName& cacheDirectory, const MiKTeX::Util::PathName& cachedFile);
+    void SaveHttpValidators(const MiKTeX::Util::PathName& cacheDirectory, const HttpValidators& validators);
+    void DownloadArchiveFile(const std::string& packageId, const std::string& url, const MiKTeX::Util::PathName& dest);
     void DownloadPackage(const std::string& packageId);
     void DownloadThread();
+    std::vector<std::string> FindMirrors();
+    unsigned GetMaxConcurrentDownloads();
+    MiKTeX::Util::PathName GetPartialDownloadDirectory();
+    void Receive(WebSession* webSession, const std::string& url, const MiKTeX::Util::PathName& dest, std::size_t expectedSize, bool notify);
+    void PutIntoArchiveCache(const MiKTeX::Util::PathName& path, std::size_t expectedSize, const MiKTeX::Core::MD5& expectedDigest);
+    void ReceiveArchiveFile(WebSession* webSession, const std::string& url, const MiKTeX::Util::PathName& dest, std::size_t expectedSize, const MiKTeX::Core::MD5& expectedDigest, bool notify);
+    void ScheduledDownloadThread(std::shared_ptr<WebSession> webSession);
+    std::size_t PickMirror(const std::vector<bool>& tried);
+    void StartDownloads(const std::vector<std::string>& packages, const MiKTeX::Util::PathName& directory);
+    void StopDownloads();
+    std::size_t Transfer(WebFile& webFile, const std::string& url, MiKTeX::Core::FileStream& destStream, bool notify, const std::function<void(std::size_t)>& checkpoint);
+    bool TryGetFromArchiveCache(WebSession* webSession, const MiKTeX::Util::PathName& dest, std::size_t expectedSize, const MiKTeX::Core::MD5& expectedDigest, bool notify);
+    MiKTeX::Util::PathName WaitForDownload(const std::string& packageId);
     void ExtractFiles(const MiKTeX::Util::PathName& archiveFileName, MiKTeX::Extractor::ArchiveFileType archiveFileType);
     std::string FatalError(ErrorCode error);
     void FindUpdatesNoLock();
+    std::string GetUpdateCheckKey();
     void FindUpdatesThread();
     void FindUpgradesNoLock(PackageLevel packageLevel);
     void FindUpgradesThread();
+    void FlushFndbUpdates();
     void InstallPackage(const std::string& packageId, MiKTeX::Core::Cfg& packageManifests);
     void HandleObsoletePackageManifests(MiKTeX::Core::Cfg& cfgExisting, const MiKTeX::Core::Cfg& cfgNew);
     void InstallRemoveThread();
+    void PostProcess(const std::vector<std::string>& installedPackages);
     void InstallRepositoryManifest(bool fromCache);
     void LoadRepositoryManifest(bool download);
+    void StartRepositoryManifestPrefetch();
+    bool TryTakeRepositoryManifestPrefetch(const std::string& url, std::unique_ptr<MiKTeX::Core::TemporaryFile>& archiveFile, HttpValidators& validators, bool& modified);
     std::string MakeUrl(const std::string& relPath);
     void MyCopyFile(const MiKTeX::Util::PathName& source, const MiKTeX::Util::PathName& dest, std::size_t& size);
     void NeedRepository();
+    void NoteChangedFontFile(const MiKTeX::Util::PathName& path);
     bool MIKTEXTHISCALL OnProgress(unsigned level, const MiKTeX::Util::PathName& directory) override;
     bool MIKTEXTHISCALL ReadDirectory(const MiKTeX::Util::PathName& path, std::vector<std::string>& subDirNames, std::vector<std::string>& fileNames, std::vector<std::string>& fileNameInfos) override;
     void RegisterComponents(bool doRegister, const std::vector<std::string>& packages);
@@ -218,6 +260,8 @@ private:
 
     bool AbortOrRetry(const std::string& message)
     {
+        // files are copied by several threads; ask one question at a time
+        std::lock_guard<std::mutex> lockGuard(retryMutex);
         return callback == nullptr || !callback->OnRetryableError(message);
     }
 
@@ -238,17 +282,67 @@ private:
     }
 
     MiKTeX::Packages::PackageInstallerCallback* callback = nullptr;
+    std::set<MiKTeX::Util::PathName> changedFontDirectories;
     Role currentRole;
     MiKTeX::Util::PathName downloadDirectory;
     bool enablePostProcessing = true;
+    std::unordered_map<MiKTeX::Util::PathName, std::string> fndbToBeAdded;
+    std::unordered_set<MiKTeX::Util::PathName> fndbToBeRemoved;
+    bool inTransaction = false;
     std::unordered_set<MiKTeX::Util::PathName> installedFiles;
+    std::mutex installedFilesMutex;
     PackageDataStore* packageDataStore = nullptr;
     std::shared_ptr<PackageManagerImpl> packageManager;
     std::mutex progressIndicatorMutex;
     ProgressInfo progressInfo;
     std::unordered_set<MiKTeX::Util::PathName> removedFiles;
+    std::set<std::string> transactionInstalled;
+    bool transactionPending = false;
+
+    struct ScheduledDownload
+    {
+        std::string fileName;
+        MiKTeX::Util::PathName path;
+        std::size_t expectedSize = 0;
+        MiKTeX::Core::MD5 digest;
+        bool done = false;
+        std::exception_ptr error;
+    };
+    std::vector<ScheduledDownload> scheduledDownloads;
+    std::unordered_map<std::string, std::size_t> scheduledDownloadIndex;
+    std::size_t nextScheduledDownload = 0;
+
+    struct Mirror
+    {
+        std::string url;
+        double bytesPerSecond = 0.0;
+        unsigned activeTransfers = 0;
+        unsigned failures = 0;
+        double bytesReceived = 0.0;
+        double secondsElapsed = 0.0;
+    };
+    std::vector<Mirror> mirrors;
+    unsigned maxTransfersPerMirror = 1;
+    std::vector<std::thread> downloadThreads;
+    std::mutex downloadMutex;
+    std::condition_variable downloadCondition;
+    std::atomic<bool> stopDownloads{ false };
+    std::mutex retryMutex;
     std::string repository;
     RepositoryManifest repositoryManifest;
+
+    // the repository manifest archive file is downloaded in the background,
+    // while the package manifests are being updated
+    struct RepositoryManifestPrefetch
+    {
+        std::string url;
+        time_t timeStarted = 0;
+        bool modified = true;
+        HttpValidators validators;
+        std::unique_ptr<MiKTeX::Core::TemporaryFile> archiveFile;
+    };
+    std::future<RepositoryManifestPrefetch> repositoryManifestPrefetch;
+
     MiKTeX::Packages::RepositoryReleaseState repositoryReleaseState = MiKTeX::Packages::RepositoryReleaseState::Unknown;
     MiKTeX::Packages::RepositoryType repositoryType = MiKTeX::Packages::RepositoryType::Unknown;
     std::shared_ptr<MiKTeX::Core::Session> session;
@@ -38,7 +38,7 @@ PackageIteratorImpl::PackageIteratorImpl(shared_ptr<PackageManagerImpl> packageM
   }
   else
   {
-    MPM_LOCK_BEGIN(this->packageManager)
+    MPM_SHARED_LOCK_BEGIN(this->packageManager)
     {
       Init();
     }
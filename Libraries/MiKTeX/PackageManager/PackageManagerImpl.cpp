@@ -14,9 +14,15 @@
 #include "config.h"
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 #include <fstream>
 #include <locale>
+#include <map>
+#include <mutex>
 #include <stack>
+#include <thread>
 #include <unordered_set>
 
 #include <fmt/format.h>
@@ -29,6 +35,7 @@
 #include <miktex/Core/TemporaryDirectory>
 #include <miktex/Core/Uri>
 #include <miktex/Core/Utils>
+#include <miktex/Trace/EventRecorder>
 #include <miktex/Trace/StopWatch>
 #include <miktex/Trace/Trace>
 #include <miktex/Util/PathNameParser>
@@ -39,6 +46,13 @@
 #include "PackageIteratorImpl.h"
 #include "TpmParser.h"
 
+#if defined(MIKTEX_WINDOWS)
+#include <winioctl.h>
+#elif defined(MIKTEX_LINUX)
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#endif
+
 using namespace std;
 
 using namespace MiKTeX::Configuration;
@@ -50,6 +64,9 @@ using namespace MiKTeX::Util;
 
 using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
 
+const char* const VERIFIED_PACKAGES_FILE_NAME = "verified-packages.txt";
+const char* const DOC_INDEX_FILE_NAME = "doc-index.txt";
+
 string PackageManagerImpl::proxyUser;
 string PackageManagerImpl::proxyPassword;
 
@@ -112,6 +129,22 @@ void PackageManagerImpl::Lock(chrono::milliseconds timeout)
     }
 }
 
+void PackageManagerImpl::LockShared(chrono::milliseconds timeout)
+{
+    if (lockFile == nullptr)
+    {
+        lockFile = LockFile::Create(session->GetSpecialPath(SpecialPath::InstallRoot) / PathName(MIKTEX_PATH_PACKAGE_MANAGER_LOCK));
+    }
+    if (!lockFile->TryLockShared(timeout))
+    {
+        MIKTEX_FATAL_ERROR_5(
+            T_("The package database is locked and cannot be accessed."),
+            T_("Another MiKTeX program has exclusevily locked the package database."),
+            T_("Close running MiKTeX programs and try again."),
+            "package-database-locked");
+    }
+}
+
 void PackageManagerImpl::Unlock()
 {
     lockFile->Unlock();
@@ -172,6 +205,8 @@ void PackageManagerImpl::LoadDatabase(const PathName& path, bool isArchive)
 void PackageManagerImpl::ClearAll()
 {
     packageDataStore.Clear();
+    docIndex.Clear();
+    haveDocIndex = false;
 }
 
 void PackageManagerImpl::UnloadDatabase()
@@ -183,7 +218,7 @@ bool PackageManagerImpl::TryGetPackageInfo(const string& packageId, PackageInfo&
 {
     if (!packageDataStore.LoadedAllPackageManifests())
     {
-        MPM_LOCK_BEGIN(this)
+        MPM_SHARED_LOCK_BEGIN(this)
         {
             packageDataStore.Load();
         }
@@ -198,7 +233,7 @@ PackageInfo PackageManagerImpl::GetPackageInfo(const string& packageId)
 {
     if (!packageDataStore.LoadedAllPackageManifests())
     {
-        MPM_LOCK_BEGIN(this)
+        MPM_SHARED_LOCK_BEGIN(this)
         {
             packageDataStore.Load();
         }
@@ -525,6 +560,55 @@ void PackageManagerImpl::CreateMpmFndbNoLock()
     directoryInfoTable.clear();
 }
 
+PathName PackageManagerImpl::GetDocIndexFileName()
+{
+    return session->GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_MIKTEX_PACKAGE_CACHE_DIR) / PathName(DOC_INDEX_FILE_NAME);
+}
+
+void PackageManagerImpl::CreateDocIndexNoLock()
+{
+    docIndex.Clear();
+    for (const PackageInfo& pi : packageDataStore)
+    {
+        docIndex.Add(pi);
+    }
+    docIndex.Write(GetDocIndexFileName(), packageDataStore.GetManifestFiles());
+    haveDocIndex = true;
+}
+
+void PackageManagerImpl::NeedDocIndex()
+{
+    if (haveDocIndex)
+    {
+        return;
+    }
+    if (docIndex.Read(GetDocIndexFileName(), packageDataStore.GetManifestFiles()))
+    {
+        haveDocIndex = true;
+        return;
+    }
+    // the index is missing or out of date: make it from the package
+    // manifests
+    MPM_SHARED_LOCK_BEGIN(this)
+    {
+        packageDataStore.Load();
+        CreateDocIndexNoLock();
+    }
+    MPM_LOCK_END();
+}
+
+vector<DocumentationFile> PackageManagerImpl::FindDocumentationByPackage(const string& packageId)
+{
+    NeedDocIndex();
+    return docIndex.FindByPackage(packageId);
+}
+
+vector<DocumentationFile> PackageManagerImpl::FindDocumentationByName(const string& name)
+{
+    NeedDocIndex();
+    return docIndex.FindByName(name);
+}
+
 bool PackageManager::IsLocalPackageRepository(const PathName& path)
 {
     if (!Directory::Exists(path))
@@ -1085,96 +1169,387 @@ void PackageManagerImpl::OnProgress()
 {
 }
 
-bool PackageManagerImpl::TryGetFileDigest(const PathName& prefix, const string& fileName, bool& haveDigest, MD5& digest)
+bool PackageManagerImpl::TryVerifyInstalledPackageNoLock(const string& packageId)
 {
-    string unprefixed;
-    if (!StripTeXMFPrefix(fileName, unprefixed))
+    return VerifyInstalledPackagesNoLock({ packageId }, VerifyOptions(), nullptr).empty();
+}
+
+// tells whether the disk which holds the path has a seek penalty
+static bool IsRotatingDisk(const PathName& path)
+{
+#if defined(MIKTEX_WINDOWS)
+    wchar_t volumePath[MAX_PATH];
+    if (!GetVolumePathNameW(path.ToWideCharString().c_str(), volumePath, MAX_PATH))
     {
-        return true;
+        return false;
     }
-    PathName path = prefix;
-    path /= unprefixed;
-    if (!File::Exists(path))
+    wstring device = L"\\\\.\\" + wstring(volumePath);
+    if (device.back() == L'\\')
+    {
+        device.pop_back();
+    }
+    HANDLE handle = CreateFileW(device.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
     {
-        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package verification failed: file {0} does not exist"), Q_(path)));
         return false;
     }
-    if (path.HasExtension(MIKTEX_PACKAGE_MANIFEST_FILE_SUFFIX))
+    STORAGE_PROPERTY_QUERY query = {};
+    query.PropertyId = StorageDeviceSeekPenaltyProperty;
+    query.QueryType = PropertyStandardQuery;
+    DEVICE_SEEK_PENALTY_DESCRIPTOR descriptor = {};
+    DWORD bytesReturned;
+    BOOL done = DeviceIoControl(handle, IOCTL_STORAGE_QUERY_PROPERTY, &query, sizeof(query), &descriptor, sizeof(descriptor), &bytesReturned, nullptr);
+    CloseHandle(handle);
+    return done && descriptor.IncursSeekPenalty;
+#elif defined(MIKTEX_LINUX)
+    struct stat statBuf;
+    if (stat(path.GetData(), &statBuf) != 0)
     {
-        haveDigest = false;
+        return false;
     }
-    else
+    // partitions inherit the queue attributes of their disk
+    for (const char* attribute : { "queue/rotational", "../queue/rotational" })
     {
-        digest = MD5::FromFile(path);
-        haveDigest = true;
+        ifstream stream(fmt::format("/sys/dev/block/{0}:{1}/{2}", major(statBuf.st_dev), minor(statBuf.st_dev), attribute));
+        char rotational;
+        if (stream >> rotational)
+        {
+            return rotational == '1';
+        }
     }
-    return true;
+    return false;
+#else
+    return false;
+#endif
 }
 
-bool PackageManagerImpl::TryCollectFileDigests(const PathName& prefix, const vector<string>& files, FileDigestTable& fileDigests)
+unsigned PackageManagerImpl::GetVerificationJobs()
 {
-    for (const string& fileName : files)
+    PathName installRoot = session->GetSpecialPath(SpecialPath::InstallRoot);
+    if (IsRotatingDisk(installRoot))
     {
-        bool haveDigest;
-        MD5 digest;
-        if (!TryGetFileDigest(prefix, fileName, haveDigest, digest))
+        // more readers would only make the disk heads jump
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("{0} is on a rotating disk"), Q_(installRoot)));
+        return 2;
+    }
+    return std::max(thread::hardware_concurrency(), 2u);
+}
+
+PathName PackageManagerImpl::GetVerificationCacheFileName()
+{
+    return session->GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_MIKTEX_PACKAGE_CACHE_DIR) / PathName(VERIFIED_PACKAGES_FILE_NAME);
+}
+
+map<string, MD5> PackageManagerImpl::ReadVerificationCache()
+{
+    map<string, MD5> stamps;
+    PathName path = GetVerificationCacheFileName();
+    if (!File::Exists(path))
+    {
+        return stamps;
+    }
+    try
+    {
+        ifstream stream = File::CreateInputStream(path);
+        string packageId;
+        string stamp;
+        while (stream >> packageId >> stamp)
         {
-            return false;
+            stamps[packageId] = MD5::Parse(stamp);
         }
-        if (haveDigest)
+    }
+    catch (const MiKTeXException& e)
+    {
+        // not fatal: all packages will be verified thoroughly
+        trace_error->WriteLine(TRACE_FACILITY, fmt::format(T_("{0} could not be read: {1}"), Q_(path), e.GetErrorMessage()));
+        stamps.clear();
+    }
+    return stamps;
+}
+
+void PackageManagerImpl::WriteVerificationCache(const map<string, MD5>& stamps)
+{
+    PathName path = GetVerificationCacheFileName();
+    try
+    {
+        Directory::Create(path.GetDirectoryName());
+        PathName tmpPath(path);
+        tmpPath.AppendExtension(".tmp");
+        ofstream stream = File::CreateOutputStream(tmpPath);
+        for (const auto& p : stamps)
         {
-            fileDigests[fileName] = digest;
+            stream << p.first << " " << p.second.ToString() << "\n";
         }
+        stream.close();
+        File::Move(tmpPath, path, { FileMoveOption::ReplaceExisting });
+    }
+    catch (const MiKTeXException& e)
+    {
+        // not fatal: the packages will be verified thoroughly next time
+        trace_error->WriteLine(TRACE_FACILITY, fmt::format(T_("{0} could not be written: {1}"), Q_(path), e.GetErrorMessage()));
     }
-    return true;
 }
 
-bool PackageManagerImpl::TryVerifyInstalledPackageNoLock(const string& packageId)
+vector<string> PackageManagerImpl::VerifyInstalledPackagesNoLock(const vector<string>& packageIds, const VerifyOptions& options, VerifyCallback* callback)
 {
-    PackageInfo packageInfo = packageDataStore.GetPackage(packageId);
+    EventSpan eventSpan("mpm: verify packages");
+    struct FileJob
+    {
+        size_t packageIdx;
+        string fileName;
+        PathName path;
+        MD5 digest;
+    };
 
-    PathName prefix;
+    struct PackageJob
+    {
+        PackageInfo packageInfo;
+        size_t firstFileJob = 0;
+        size_t numFileJobs = 0;
+        // digest of the file names, sizes and modification times
+        MD5 stamp;
+        bool done = false;
+        bool ok = false;
+    };
+
+    map<string, MD5> stamps = ReadVerificationCache();
+    bool stampsChanged = false;
 
-    if (!session->IsAdminMode() && packageInfo.IsInstalled(ConfigurationScope::User))
+    // collect the files of all packages, so that large packages are
+    // spread over the threads too
+    vector<PackageJob> packages(packageIds.size());
+    vector<FileJob> fileJobs;
+    for (size_t idx = 0; idx < packageIds.size(); ++idx)
     {
-        prefix = session->GetSpecialPath(SpecialPath::UserInstallRoot);
+        PackageJob& package = packages[idx];
+        package.packageInfo = packageDataStore.GetPackage(packageIds[idx]);
+        package.firstFileJob = fileJobs.size();
+        PathName prefix;
+        if (!session->IsAdminMode() && package.packageInfo.IsInstalled(ConfigurationScope::User))
+        {
+            prefix = session->GetSpecialPath(SpecialPath::UserInstallRoot);
+        }
+        if (prefix.Empty() && session->IsSharedSetup())
+        {
+            prefix = session->GetSpecialPath(SpecialPath::CommonInstallRoot);
+        }
+        MD5Builder stampBuilder;
+        stampBuilder.Update(package.packageInfo.digest.data(), package.packageInfo.digest.size());
+        bool filesMissing = false;
+        for (const vector<string>* files : { &package.packageInfo.runFiles, &package.packageInfo.docFiles, &package.packageInfo.sourceFiles })
+        {
+            for (const string& fileName : *files)
+            {
+                string unprefixed;
+                if (!StripTeXMFPrefix(fileName, unprefixed))
+                {
+                    continue;
+                }
+                PathName path = prefix;
+                path /= unprefixed;
+                if (!File::Exists(path))
+                {
+                    trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package verification failed: file {0} does not exist"), Q_(path)));
+                    filesMissing = true;
+                    break;
+                }
+                if (!path.HasExtension(MIKTEX_PACKAGE_MANIFEST_FILE_SUFFIX))
+                {
+                    fileJobs.push_back({ idx, fileName, path, MD5() });
+                    if (options.quick)
+                    {
+                        time_t creationTime;
+                        time_t lastAccessTime;
+                        time_t lastWriteTime;
+                        File::GetTimes(path, creationTime, lastAccessTime, lastWriteTime);
+                        string info = fmt::format("{0}:{1}:{2}", fileName, File::GetSize(path), lastWriteTime);
+                        stampBuilder.Update(info.c_str(), info.length() + 1);
+                    }
+                }
+            }
+            if (filesMissing)
+            {
+                break;
+            }
+        }
+        if (filesMissing)
+        {
+            fileJobs.resize(package.firstFileJob);
+            package.done = true;
+            continue;
+        }
+        package.numFileJobs = fileJobs.size() - package.firstFileJob;
+        if (options.quick)
+        {
+            package.stamp = stampBuilder.Final();
+            auto it = stamps.find(packageIds[idx]);
+            if (it != stamps.end() && it->second == package.stamp)
+            {
+                // sizes and times have not changed since the last verification
+                fileJobs.resize(package.firstFileJob);
+                package.numFileJobs = 0;
+                package.done = true;
+                package.ok = true;
+            }
+        }
     }
 
-    if (prefix.Empty() && session->IsSharedSetup())
+    unique_ptr<atomic<size_t>[]> pendingFileJobs(new atomic<size_t>[packages.size()]);
+    for (size_t idx = 0; idx < packages.size(); ++idx)
     {
-        prefix = session->GetSpecialPath(SpecialPath::CommonInstallRoot);
+        pendingFileJobs[idx] = packages[idx].numFileJobs;
     }
 
-    FileDigestTable fileDigests;
+    size_t numDone = 0;
+    auto report = [&](size_t idx)
+    {
+        PackageJob& package = packages[idx];
+        if (!package.done)
+        {
+            FileDigestTable fileDigests;
+            for (size_t i = package.firstFileJob; i < package.firstFileJob + package.numFileJobs; ++i)
+            {
+                fileDigests[fileJobs[i].fileName] = fileJobs[i].digest;
+            }
+            MD5Builder md5Builder;
+            for (const pair<string, MD5> p : fileDigests)
+            {
+                PathName path(p.first);
+                // we must dosify the path name for backward compatibility
+                path.ConvertToDos();
+                md5Builder.Update(path.GetData(), path.GetLength());
+                md5Builder.Update(p.second.data(), p.second.size());
+            }
+            package.ok = md5Builder.Final() == package.packageInfo.digest;
+            if (!package.ok)
+            {
+                trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package {0} verification failed: some files have been modified"), Q_(packageIds[idx])));
+                trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("expected digest: {0}"), package.packageInfo.digest.ToString()));
+                trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("computed digest: {0}"), md5Builder.GetMD5().ToString()));
+            }
+            else if (options.quick)
+            {
+                stamps[packageIds[idx]] = package.stamp;
+                stampsChanged = true;
+            }
+            package.done = true;
+        }
+        if (!package.ok && stamps.erase(packageIds[idx]) > 0)
+        {
+            stampsChanged = true;
+        }
+        numDone += 1;
+        if (callback != nullptr)
+        {
+            callback->OnPackageVerified(packageIds[idx], package.ok);
+        }
+    };
 
-    if (!TryCollectFileDigests(prefix, packageInfo.runFiles, fileDigests)
-        || !TryCollectFileDigests(prefix, packageInfo.docFiles, fileDigests)
-        || !TryCollectFileDigests(prefix, packageInfo.sourceFiles, fileDigests))
+    // calculate the file digests; workers hand over finished packages,
+    // which are reported on this thread
+    atomic<size_t> nextJob(0);
+    mutex queueMutex;
+    condition_variable queueChanged;
+    vector<size_t> finishedPackages;
+    size_t numThreads = std::min<size_t>(options.maxJobs == 0 ? GetVerificationJobs() : options.maxJobs, fileJobs.size());
+    size_t numActiveThreads = numThreads;
+    exception_ptr error;
+    auto worker = [&]()
+    {
+        try
+        {
+            for (size_t i = nextJob++; i < fileJobs.size(); i = nextJob++)
+            {
+                EventSpan eventSpan("mpm: hash file");
+                fileJobs[i].digest = MD5::FromFile(fileJobs[i].path);
+                size_t packageIdx = fileJobs[i].packageIdx;
+                if (--pendingFileJobs[packageIdx] == 0)
+                {
+                    lock_guard<mutex> lockGuard(queueMutex);
+                    finishedPackages.push_back(packageIdx);
+                    queueChanged.notify_one();
+                }
+            }
+        }
+        catch (const exception&)
+        {
+            lock_guard<mutex> lockGuard(queueMutex);
+            if (error == nullptr)
+            {
+                error = current_exception();
+            }
+            nextJob = fileJobs.size();
+        }
+        lock_guard<mutex> lockGuard(queueMutex);
+        numActiveThreads -= 1;
+        queueChanged.notify_one();
+    };
+    vector<thread> threads;
+    for (size_t i = 0; i < numThreads; ++i)
     {
-        return false;
+        threads.push_back(thread(worker));
     }
 
-    MD5Builder md5Builder;
-
-    for (const pair<string, MD5> p : fileDigests)
+    try
+    {
+        for (size_t idx = 0; idx < packages.size(); ++idx)
+        {
+            if (packages[idx].numFileJobs == 0)
+            {
+                report(idx);
+            }
+        }
+        while (true)
+        {
+            vector<size_t> finished;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                queueChanged.wait(lock, [&]() { return !finishedPackages.empty() || numActiveThreads == 0; });
+                if (finishedPackages.empty())
+                {
+                    break;
+                }
+                swap(finished, finishedPackages);
+            }
+            for (size_t idx : finished)
+            {
+                report(idx);
+            }
+        }
+    }
+    catch (const exception&)
     {
-        PathName path(p.first);
-        // we must dosify the path name for backward compatibility
-        path.ConvertToDos();
-        md5Builder.Update(path.GetData(), path.GetLength());
-        md5Builder.Update(p.second.data(), p.second.size());
+        nextJob = fileJobs.size();
+        for (thread& t : threads)
+        {
+            t.join();
+        }
+        throw;
     }
+    for (thread& t : threads)
+    {
+        t.join();
+    }
+    if (error != nullptr)
+    {
+        rethrow_exception(error);
+    }
+    MIKTEX_ASSERT(numDone == packages.size());
 
-    bool ok = md5Builder.Final() == packageInfo.digest;
-
-    if (!ok)
+    if (stampsChanged)
     {
-        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package {0} verification failed: some files have been modified"), Q_(packageId)));
-        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("expected digest: {0}"), packageInfo.digest.ToString()));
-        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("computed digest: {0}"), md5Builder.GetMD5().ToString()));
+        WriteVerificationCache(stamps);
     }
 
-    return ok;
+    vector<string> damaged;
+    for (size_t idx = 0; idx < packages.size(); ++idx)
+    {
+        if (!packages[idx].ok)
+        {
+            damaged.push_back(packageIds[idx]);
+        }
+    }
+    return damaged;
 }
 
 string PackageManagerImpl::GetContainerPathNoLock(const string& packageId, bool useDisplayNames)
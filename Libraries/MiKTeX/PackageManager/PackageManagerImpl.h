@@ -14,7 +14,9 @@
 #pragma once
 
 #include <map>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <miktex/Core/AutoResource>
 #include <miktex/Core/Fndb>
@@ -25,6 +27,7 @@
 
 #include "internal.h"
 
+#include "DocIndex.h"
 #include "PackageDataStore.h"
 #include "PackageRepositoryDataStore.h"
 #include "WebSession.h"
@@ -34,6 +37,11 @@
         packageManager->Lock(std::chrono::seconds(10));                     \
         MIKTEX_AUTO(packageManager->Unlock());
 
+#define MPM_SHARED_LOCK_BEGIN(packageManager)                               \
+    {                                                                       \
+        packageManager->LockShared(std::chrono::seconds(10));               \
+        MIKTEX_AUTO(packageManager->Unlock());
+
 #define MPM_LOCK_END()                                                      \
     }
 
@@ -60,7 +68,7 @@ public:
     {
         if (!packageDataStore.LoadedAllPackageManifests())
         {
-            MPM_LOCK_BEGIN(this)
+            MPM_SHARED_LOCK_BEGIN(this)
             {
                 packageDataStore.Load();
             }
@@ -70,6 +78,9 @@ public:
     }
 
     void MIKTEXTHISCALL CreateMpmFndbNoLock();
+    void CreateDocIndexNoLock();
+    std::vector<MiKTeX::Packages::DocumentationFile> MIKTEXTHISCALL FindDocumentationByPackage(const std::string& packageId) override;
+    std::vector<MiKTeX::Packages::DocumentationFile> MIKTEXTHISCALL FindDocumentationByName(const std::string& name) override;
     MiKTeX::Packages::PackageInfo MIKTEXTHISCALL GetPackageInfo(const std::string& packageId) override;
     void MIKTEXTHISCALL LoadDatabase(const MiKTeX::Util::PathName& path, bool isArchive) override;
     void MIKTEXTHISCALL UnloadDatabase() override;
@@ -125,11 +136,16 @@ public:
         return repositories.VerifyPackageRepository(url);
     }
 
+    void RecordDataTransferRate(const std::string& url, double bytesPerSecond)
+    {
+        repositories.RecordDataTransferRate(url, bytesPerSecond);
+    }
+
     bool MIKTEXTHISCALL TryVerifyInstalledPackage(const std::string& packageId) override
     {
         if (!packageDataStore.LoadedAllPackageManifests())
         {
-            MPM_LOCK_BEGIN(this)
+            MPM_SHARED_LOCK_BEGIN(this)
             {
                 packageDataStore.Load();
             }
@@ -140,11 +156,46 @@ public:
 
     bool MIKTEXTHISCALL TryVerifyInstalledPackageNoLock(const std::string& packageId);
 
+    std::vector<std::string> MIKTEXTHISCALL VerifyInstalledPackages(const std::vector<std::string>& packageIds, unsigned maxJobs) override
+    {
+        if (!packageDataStore.LoadedAllPackageManifests())
+        {
+            MPM_SHARED_LOCK_BEGIN(this)
+            {
+                packageDataStore.Load();
+            }
+            MPM_LOCK_END();
+        }
+        MiKTeX::Packages::VerifyOptions options;
+        options.maxJobs = maxJobs;
+        return VerifyInstalledPackages(packageIds, options, nullptr);
+    }
+
+    std::vector<std::string> MIKTEXTHISCALL VerifyInstalledPackages(const std::vector<std::string>& packageIds, const MiKTeX::Packages::VerifyOptions& options, MiKTeX::Packages::VerifyCallback* callback) override
+    {
+        if (!packageDataStore.LoadedAllPackageManifests())
+        {
+            MPM_SHARED_LOCK_BEGIN(this)
+            {
+                packageDataStore.Load();
+            }
+            MPM_LOCK_END();
+        }
+        return VerifyInstalledPackagesNoLock(packageIds, options, callback);
+    }
+
+    std::vector<std::string> VerifyInstalledPackagesNoLock(const std::vector<std::string>& packageIds, const MiKTeX::Packages::VerifyOptions& options, MiKTeX::Packages::VerifyCallback* callback);
+
+    unsigned GetVerificationJobs();
+    MiKTeX::Util::PathName GetVerificationCacheFileName();
+    std::map<std::string, MiKTeX::Core::MD5> ReadVerificationCache();
+    void WriteVerificationCache(const std::map<std::string, MiKTeX::Core::MD5>& stamps);
+
     std::string MIKTEXTHISCALL GetContainerPath(const std::string& packageId, bool useDisplayNames) override
     {
         if (!packageDataStore.LoadedAllPackageManifests())
         {
-            MPM_LOCK_BEGIN(this)
+            MPM_SHARED_LOCK_BEGIN(this)
             {
                 packageDataStore.Load();
             }
@@ -157,13 +208,12 @@ public:
     InstallationSummary MIKTEXTHISCALL GetInstallationSummary(bool userScope) override;
     PackageManagerImpl(const MiKTeX::Packages::PackageManager::InitInfo& initInfo);
     void Lock(std::chrono::milliseconds timeout);
+    void LockShared(std::chrono::milliseconds timeout);
     void Unlock();
     void ClearAll();
 
 private:
 
-    bool TryGetFileDigest(const MiKTeX::Util::PathName& prefix, const std::string& fileName, bool& haveDigest, MiKTeX::Core::MD5& digest);
-    bool TryCollectFileDigests(const MiKTeX::Util::PathName& prefix, const std::vector<std::string>& files, FileDigestTable& fileDigests);
     void Dispose();
 
     std::unique_ptr<MiKTeX::Core::LockFile> lockFile;
@@ -192,6 +242,43 @@ public:
         return &packageDataStore;
     }
 
+private:
+
+    MiKTeX::Util::PathName GetDocIndexFileName();
+    void NeedDocIndex();
+
+    DocIndex docIndex;
+    bool haveDocIndex = false;
+
+private:
+
+    std::mutex updateCheckMutex;
+    std::string updateCheckKey;
+    std::vector<MiKTeX::Packages::PackageInstaller::UpdateInfo> updateCheckResult;
+
+public:
+
+    // the result of the last update check is kept for the next check,
+    // which gets the same result if the key (describing the repository
+    // manifest and the package database) is the same
+    bool TryGetUpdateCheckResult(const std::string& key, std::vector<MiKTeX::Packages::PackageInstaller::UpdateInfo>& updates)
+    {
+        std::lock_guard<std::mutex> lockGuard(updateCheckMutex);
+        if (key.empty() || key != updateCheckKey)
+        {
+            return false;
+        }
+        updates = updateCheckResult;
+        return true;
+    }
+
+    void SetUpdateCheckResult(const std::string& key, const std::vector<MiKTeX::Packages::PackageInstaller::UpdateInfo>& updates)
+    {
+        std::lock_guard<std::mutex> lockGuard(updateCheckMutex);
+        updateCheckKey = key;
+        updateCheckResult = updates;
+    }
+
 private:
 
     PackageRepositoryDataStore repositories;
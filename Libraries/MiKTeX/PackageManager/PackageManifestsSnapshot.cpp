@@ -0,0 +1,338 @@
+/**
+ * @file PackageManifestsSnapshot.cpp
+ * @author Christian Schenk
+ * @brief Binary snapshots of the package manifests
+ *
+ * @copyright Copyright © 2022 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#include "config.h"
+
+#include <cstring>
+#include <ctime>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/MD5>
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Core/TemporaryFile>
+#include <miktex/Trace/Trace>
+#include <miktex/Trace/TraceStream>
+
+#include "internal.h"
+
+#include "PackageManifestsSnapshot.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+/*
+ * A snapshot starts with a header, followed by the list of the INI files
+ * (with size, modification time and, if the file was modified just before
+ * the snapshot was taken, its digest) and the package records:
+ *
+ *   signature version
+ *   #manifestFiles { path size lastWriteTime hasDigest [digest] }
+ *   #packages { id displayName ... licenseType }
+ *
+ * Numbers are stored as 32-bit words (64-bit for sizes and times), strings
+ * are prefixed by their length.
+ */
+
+const uint32_t SNAPSHOT_SIGNATURE = 0x534d504d; // 'MPMS' (the x86 way)
+const uint32_t SNAPSHOT_VERSION = 1;
+
+// a file modified within this many seconds before the snapshot was taken
+// could be modified again without changing its size and modification time
+const time_t TIMESTAMP_RESOLUTION_SECONDS = 2;
+
+namespace
+{
+    class SnapshotWriter
+    {
+    public:
+        void Put(uint32_t word)
+        {
+            buf.append(reinterpret_cast<const char*>(&word), sizeof(word));
+        }
+
+        void Put64(uint64_t word)
+        {
+            buf.append(reinterpret_cast<const char*>(&word), sizeof(word));
+        }
+
+        void Put(const string& str)
+        {
+            Put(static_cast<uint32_t>(str.length()));
+            buf.append(str);
+        }
+
+        void Put(const vector<string>& strings)
+        {
+            Put(static_cast<uint32_t>(strings.size()));
+            for (const string& str : strings)
+            {
+                Put(str);
+            }
+        }
+
+        void Put(const MD5& md5)
+        {
+            buf.append(reinterpret_cast<const char*>(md5.data()), md5.size());
+        }
+
+        const string& GetData() const
+        {
+            return buf;
+        }
+
+    private:
+        string buf;
+    };
+
+    class SnapshotReader
+    {
+    public:
+        SnapshotReader(const unsigned char* data, size_t size) :
+            data(data),
+            size(size)
+        {
+        }
+
+        uint32_t Get()
+        {
+            uint32_t word;
+            Read(&word, sizeof(word));
+            return word;
+        }
+
+        uint64_t Get64()
+        {
+            uint64_t word;
+            Read(&word, sizeof(word));
+            return word;
+        }
+
+        string GetString()
+        {
+            size_t length = Get();
+            if (length > size - pos)
+            {
+                MIKTEX_UNEXPECTED();
+            }
+            string result(reinterpret_cast<const char*>(data) + pos, length);
+            pos += length;
+            return result;
+        }
+
+        vector<string> GetStrings()
+        {
+            vector<string> result;
+            for (size_t count = Get(); count > 0; --count)
+            {
+                result.push_back(GetString());
+            }
+            return result;
+        }
+
+        MD5 GetMD5()
+        {
+            MD5 md5;
+            Read(md5.data(), md5.size());
+            return md5;
+        }
+
+        bool AtEnd() const
+        {
+            return pos == size;
+        }
+
+    private:
+        void Read(void* buf, size_t n)
+        {
+            if (n > size - pos)
+            {
+                MIKTEX_UNEXPECTED();
+            }
+            memcpy(buf, data + pos, n);
+            pos += n;
+        }
+
+        const unsigned char* data;
+        size_t size;
+        size_t pos = 0;
+    };
+}
+
+bool PackageManifestsSnapshot::Read(const PathName& snapshotPath, const vector<PathName>& manifestFiles, vector<PackageInfo>& packages, bool& needsRefresh)
+{
+    auto trace_mpm = TraceStream::Open(MIKTEX_TRACE_MPM);
+    needsRefresh = false;
+    if (!File::Exists(snapshotPath))
+    {
+        return false;
+    }
+    try
+    {
+        unique_ptr<MemoryMappedFile> mmap(MemoryMappedFile::Create());
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(mmap->Open(snapshotPath, false));
+        SnapshotReader reader(data, mmap->GetSize());
+        if (reader.Get() != SNAPSHOT_SIGNATURE || reader.Get() != SNAPSHOT_VERSION)
+        {
+            return false;
+        }
+        size_t numManifestFiles = reader.Get();
+        if (numManifestFiles != manifestFiles.size())
+        {
+            return false;
+        }
+        for (const PathName& path : manifestFiles)
+        {
+            if (reader.GetString() != path.ToString())
+            {
+                return false;
+            }
+            uint64_t size = reader.Get64();
+            uint64_t lastWriteTime = reader.Get64();
+            bool hasDigest = reader.Get() != 0;
+            if (!File::Exists(path) || File::GetSize(path) != size || static_cast<uint64_t>(File::GetLastWriteTime(path)) != lastWriteTime)
+            {
+                trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("package manifests snapshot {0} is out of date: {1} has changed"), Q_(snapshotPath), Q_(path)));
+                return false;
+            }
+            if (hasDigest)
+            {
+                if (reader.GetMD5() != MD5::FromFile(path))
+                {
+                    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("package manifests snapshot {0} is out of date: {1} has changed"), Q_(snapshotPath), Q_(path)));
+                    return false;
+                }
+                needsRefresh = true;
+            }
+        }
+        vector<PackageInfo> result;
+        for (size_t numPackages = reader.Get(); numPackages > 0; --numPackages)
+        {
+            PackageInfo packageInfo;
+            packageInfo.id = reader.GetString();
+            packageInfo.displayName = reader.GetString();
+            packageInfo.creator = reader.GetString();
+            packageInfo.title = reader.GetString();
+            packageInfo.version = reader.GetString();
+            packageInfo.targetSystem = reader.GetString();
+            packageInfo.minTargetSystemVersion = reader.GetString();
+            packageInfo.description = reader.GetString();
+            packageInfo.requiredPackages = reader.GetStrings();
+            packageInfo.sizeRunFiles = reader.Get64();
+            packageInfo.runFiles = reader.GetStrings();
+            packageInfo.sizeDocFiles = reader.Get64();
+            packageInfo.docFiles = reader.GetStrings();
+            packageInfo.sizeSourceFiles = reader.Get64();
+            packageInfo.sourceFiles = reader.GetStrings();
+            packageInfo.timePackaged = static_cast<time_t>(reader.Get64());
+            packageInfo.digest = reader.GetMD5();
+            packageInfo.ctanPath = reader.GetString();
+            packageInfo.copyrightOwner = reader.GetString();
+            packageInfo.copyrightYear = reader.GetString();
+            packageInfo.licenseType = reader.GetString();
+            result.push_back(std::move(packageInfo));
+        }
+        if (!reader.AtEnd())
+        {
+            MIKTEX_UNEXPECTED();
+        }
+        mmap->Close();
+        packages = std::move(result);
+    }
+    catch (const MiKTeXException& e)
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Error, fmt::format(T_("package manifests snapshot {0} could not be read: {1}"), Q_(snapshotPath), e.GetErrorMessage()));
+        return false;
+    }
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("using package manifests snapshot {0}"), Q_(snapshotPath)));
+    return true;
+}
+
+void PackageManifestsSnapshot::Write(const PathName& snapshotPath, const vector<PathName>& manifestFiles, const vector<PackageInfo>& packages)
+{
+    auto trace_mpm = TraceStream::Open(MIKTEX_TRACE_MPM);
+    try
+    {
+        SnapshotWriter writer;
+        writer.Put(SNAPSHOT_SIGNATURE);
+        writer.Put(SNAPSHOT_VERSION);
+        writer.Put(static_cast<uint32_t>(manifestFiles.size()));
+        time_t now = time(nullptr);
+        for (const PathName& path : manifestFiles)
+        {
+            time_t lastWriteTime = File::GetLastWriteTime(path);
+            writer.Put(path.ToString());
+            writer.Put64(static_cast<uint64_t>(File::GetSize(path)));
+            writer.Put64(static_cast<uint64_t>(lastWriteTime));
+            // the file has just been written (e.g., by UpdateDb()):
+            // remember its digest, so that the snapshot can be used
+            // nevertheless
+            bool hasDigest = lastWriteTime + TIMESTAMP_RESOLUTION_SECONDS >= now;
+            writer.Put(hasDigest ? 1 : 0);
+            if (hasDigest)
+            {
+                writer.Put(MD5::FromFile(path));
+            }
+        }
+        writer.Put(static_cast<uint32_t>(packages.size()));
+        for (const PackageInfo& packageInfo : packages)
+        {
+            writer.Put(packageInfo.id);
+            writer.Put(packageInfo.displayName);
+            writer.Put(packageInfo.creator);
+            writer.Put(packageInfo.title);
+            writer.Put(packageInfo.version);
+            writer.Put(packageInfo.targetSystem);
+            writer.Put(packageInfo.minTargetSystemVersion);
+            writer.Put(packageInfo.description);
+            writer.Put(packageInfo.requiredPackages);
+            writer.Put64(packageInfo.sizeRunFiles);
+            writer.Put(packageInfo.runFiles);
+            writer.Put64(packageInfo.sizeDocFiles);
+            writer.Put(packageInfo.docFiles);
+            writer.Put64(packageInfo.sizeSourceFiles);
+            writer.Put(packageInfo.sourceFiles);
+            writer.Put64(static_cast<uint64_t>(packageInfo.timePackaged));
+            writer.Put(packageInfo.digest);
+            writer.Put(packageInfo.ctanPath);
+            writer.Put(packageInfo.copyrightOwner);
+            writer.Put(packageInfo.copyrightYear);
+            writer.Put(packageInfo.licenseType);
+        }
+        Directory::Create(snapshotPath.GetDirectoryName());
+        PathName tmpSnapshotPath(snapshotPath);
+        tmpSnapshotPath.AppendExtension(".tmp");
+        unique_ptr<TemporaryFile> tmpSnapshotFile = TemporaryFile::Create(tmpSnapshotPath);
+        FileStream stream(File::Open(tmpSnapshotPath, FileMode::Create, FileAccess::Write, false));
+        stream.Write(writer.GetData().data(), writer.GetData().length());
+        stream.Close();
+        File::Move(tmpSnapshotPath, snapshotPath, { FileMoveOption::ReplaceExisting });
+        tmpSnapshotFile->Keep();
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("package manifests snapshot {0} has been written"), Q_(snapshotPath)));
+    }
+    catch (const MiKTeXException& e)
+    {
+        // not fatal: the package manifests will be parsed again
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Error, fmt::format(T_("package manifests snapshot {0} could not be written: {1}"), Q_(snapshotPath), e.GetErrorMessage()));
+    }
+}
@@ -0,0 +1,62 @@
+/**
+ * @file PackageManifestsSnapshot.h
+ * @author Christian Schenk
+ * @brief Binary snapshots of the package manifests
+ *
+ * @copyright Copyright © 2022 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <miktex/Util/PathName>
+
+#include <miktex/PackageManager/PackageManager>
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+/**
+ * @brief Binary snapshot of parsed package manifests.
+ *
+ * Parsing `package-manifests.ini` is the most expensive part of loading the
+ * package database. A snapshot holds the parsed records together with the
+ * size and modification time of the INI files it was made from; it is used
+ * as long as these files are unchanged.
+ */
+class PackageManifestsSnapshot
+{
+public:
+
+    /**
+     * @brief Reads a snapshot.
+     *
+     * @param snapshotPath Path to the snapshot file.
+     * @param manifestFiles The INI files (in load order) which the snapshot
+     * must have been made from.
+     * @param[out] packages The package manifests.
+     * @param[out] needsRefresh Indicates whether the snapshot should be
+     * written again (its validity could only be established by comparing
+     * digests).
+     * @return Returns `false`, if the snapshot does not exist or is out of
+     * date.
+     */
+    static bool Read(const MiKTeX::Util::PathName& snapshotPath, const std::vector<MiKTeX::Util::PathName>& manifestFiles, std::vector<MiKTeX::Packages::PackageInfo>& packages, bool& needsRefresh);
+
+    /**
+     * @brief Writes a snapshot.
+     *
+     * @param snapshotPath Path to the snapshot file.
+     * @param manifestFiles The INI files (in load order) the package manifests
+     * were read from.
+     * @param packages The package manifests.
+     */
+    static void Write(const MiKTeX::Util::PathName& snapshotPath, const std::vector<MiKTeX::Util::PathName>& manifestFiles, const std::vector<MiKTeX::Packages::PackageInfo>& packages);
+};
+
+MPM_INTERNAL_END_NAMESPACE;
@@ -237,6 +237,30 @@ string MakeKey(const string& url)
   return uri.GetScheme() + "://" + uri.GetHost();
 }
 
+void PackageRepositoryDataStore::RecordDataTransferRate(const string& url, double bytesPerSecond)
+{
+  RepositoryInfo repositoryInfo;
+  repositoryInfo.url = url;
+  LoadVarData(repositoryInfo);
+  // blend with the previous measurement: one slow or fast session
+  // should not turn the ranking upside down
+  if (repositoryInfo.dataTransferRate > 0)
+  {
+    bytesPerSecond = 0.5 * repositoryInfo.dataTransferRate + 0.5 * bytesPerSecond;
+  }
+  repositoryInfo.dataTransferRate = bytesPerSecond;
+  repositoryInfo.lastVisitTime = time(nullptr);
+  SaveVarData(repositoryInfo);
+  for (RepositoryInfo& r : repositories)
+  {
+    if (MakeKey(r.url) == MakeKey(url))
+    {
+      r.dataTransferRate = repositoryInfo.dataTransferRate;
+      r.lastVisitTime = repositoryInfo.lastVisitTime;
+    }
+  }
+}
+
 void PackageRepositoryDataStore::LoadVarData(RepositoryInfo& repositoryInfo)
 {
   string key = MakeKey(repositoryInfo.url);
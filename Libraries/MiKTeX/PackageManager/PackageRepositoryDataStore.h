@@ -57,6 +57,9 @@ public:
 public:
   MiKTeX::Packages::RepositoryInfo CheckPackageRepository(const std::string& url);
 
+public:
+  void RecordDataTransferRate(const std::string& url, double bytesPerSecond);
+
 public:
   bool TryGetRepositoryInfo(const std::string& url, RepositoryInfo& repositoryInfo);
 
@@ -23,9 +23,11 @@
 #define E1DE3BC21F3F417ABD371823C8CBEB1A
 
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include <miktex/Core/Cfg>
+#include <miktex/Core/File>
 #include <miktex/Core/MD5>
 #include <miktex/Util/PathName>
 #include <miktex/Core/Utils>
@@ -37,12 +39,34 @@ MPM_INTERNAL_BEGIN_NAMESPACE;
 class RepositoryManifest
 {
 private:
-  std::unique_ptr<MiKTeX::Core::Cfg> cfg;
+  // the parsed mpm.ini is shared by all installer instances of this
+  // process; it is not modified after it has been read
+  std::shared_ptr<MiKTeX::Core::Cfg> cfg;
+
+private:
+  MiKTeX::Core::MD5 digest;
+
+private:
+  struct SharedManifest
+  {
+    std::mutex mutex;
+    MiKTeX::Util::PathName path;
+    std::string stamp;
+    std::shared_ptr<MiKTeX::Core::Cfg> cfg;
+    MiKTeX::Core::MD5 digest;
+  };
+
+private:
+  static SharedManifest& GetSharedManifest()
+  {
+    static SharedManifest sharedManifest;
+    return sharedManifest;
+  }
 
 public:
-  RepositoryManifest() :
-    cfg(MiKTeX::Core::Cfg::Create())
+  RepositoryManifest()
   {
+    Clear();
   }
 
 public:
@@ -53,7 +77,7 @@ public:
 public:
   MiKTeX::Core::MD5 GetDigest()
   {
-    return cfg->GetDigest();
+    return digest;
   }
 
 public:
@@ -64,7 +88,22 @@ public:
 #else
     bool mustBeSigned = false;
 #endif
-    cfg->Read(path, mustBeSigned);
+    // parse the file only if it has changed since it was parsed last
+    // (by any instance); concurrent callers wait for the one parse
+    std::string stamp = std::to_string(MiKTeX::Core::File::GetLastWriteTime(path)) + ":" + std::to_string(MiKTeX::Core::File::GetSize(path));
+    SharedManifest& shared = GetSharedManifest();
+    std::lock_guard<std::mutex> lockGuard(shared.mutex);
+    if (shared.cfg == nullptr || shared.path != path || shared.stamp != stamp)
+    {
+      std::shared_ptr<MiKTeX::Core::Cfg> newCfg = MiKTeX::Core::Cfg::Create();
+      newCfg->Read(path, mustBeSigned);
+      shared.path = path;
+      shared.stamp = stamp;
+      shared.cfg = newCfg;
+      shared.digest = newCfg->GetDigest();
+    }
+    cfg = shared.cfg;
+    digest = shared.digest;
   }
 
 private:
@@ -89,6 +128,7 @@ public:
   void Clear()
   {
     cfg = MiKTeX::Core::Cfg::Create();
+    digest = cfg->GetDigest();
   }
 
 public:
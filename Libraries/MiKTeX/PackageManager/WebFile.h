@@ -22,6 +22,8 @@
 #if !defined(FDC3B537D4484567B7577B2803B60F36)
 #define FDC3B537D4484567B7577B2803B60F36
 
+#include <string>
+
 #include <miktex/Core/Session>
 
 MPM_INTERNAL_BEGIN_NAMESPACE;
@@ -34,6 +36,25 @@ public:
 public:
   virtual std::size_t Read(void* buffer, std::size_t n) = 0;
 
+  /// Gets the position of the first byte delivered by `Read()`.  This
+  /// is 0, unless a byte range was requested and the server accepted
+  /// it.
+public:
+  virtual std::size_t GetOffset() = 0;
+
+  /// Checks whether the server answered a conditional request with
+  /// "304 Not Modified".  In this case `Read()` delivers no data.
+public:
+  virtual bool IsNotModified() = 0;
+
+  /// Gets the value of the `ETag` response header, if any.
+public:
+  virtual std::string GetETag() = 0;
+
+  /// Gets the value of the `Last-Modified` response header, if any.
+public:
+  virtual std::string GetLastModified() = 0;
+
 public:
   virtual void Close() = 0;
 };
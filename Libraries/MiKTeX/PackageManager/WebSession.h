@@ -47,6 +47,18 @@ public:
 public:
   virtual std::unique_ptr<WebFile> OpenUrl(const std::string& url, const std::unordered_map<std::string, std::string>& formData) = 0;
 
+  /// Opens a remote file and asks the server to skip the first
+  /// `offset` bytes.  The server might ignore the request; see
+  /// `WebFile::GetOffset()`.
+public:
+  virtual std::unique_ptr<WebFile> OpenUrlRange(const std::string& url, std::size_t offset) = 0;
+
+  /// Opens a remote file and asks the server to send it only if it
+  /// has changed since it was received with the given `ETag` and
+  /// `Last-Modified` values; see `WebFile::IsNotModified()`.
+public:
+  virtual std::unique_ptr<WebFile> OpenUrlIfModified(const std::string& url, const std::string& etag, const std::string& lastModified) = 0;
+
 public:
   virtual void SetCustomHeaders(const std::unordered_map<std::string, std::string>& headers) = 0;
 
@@ -225,6 +225,24 @@ public:
 public:
   virtual void MIKTEXTHISCALL InstallRemove(Role role) = 0;
 
+  /// @brief Starts a transaction.
+  ///
+  /// Until the transaction is committed, InstallRemove() defers the update
+  /// of the file name database and the post-processing (component
+  /// registration, font map configuration, links).
+  /// @see CommitTransaction
+public:
+  virtual void MIKTEXTHISCALL BeginTransaction() = 0;
+
+  /// @brief Commits a transaction.
+  ///
+  /// Updates the file name database and performs the post-processing
+  /// once for all packages which have been installed/removed since the
+  /// transaction was started.
+  /// @see BeginTransaction
+public:
+  virtual void MIKTEXTHISCALL CommitTransaction() = 0;
+
   /// Installs/removes packages in a secondary thread.
   /// @param role The installation role.
   /// @see WaitForCompletion
@@ -72,6 +72,42 @@ struct InstallationSummary
   std::size_t packageCount = 0;
 };
 
+/// Package verification options.
+struct VerifyOptions
+{
+  /// The maximum number of files which are read at the same time. The
+  /// value 0 lets the package manager choose a number which suits the
+  /// disk (few threads for rotating disks, more for solid state disks).
+  unsigned maxJobs = 0;
+  /// Trust packages whose files have the same sizes and modification
+  /// times as on the last successful verification.
+  bool quick = false;
+};
+
+/// Documentation file, as recorded in the documentation index.
+struct DocumentationFile
+{
+  /// The package which contains the file.
+  std::string packageId;
+  /// The file name without directory and extension.
+  std::string name;
+  /// The file name extension (e.g., `.pdf`).
+  std::string type;
+  /// The path relative to the TEXMF root directory.
+  std::string path;
+};
+
+/// Package verification callback interface.
+class MIKTEXNOVTABLE VerifyCallback
+{
+  /// Reports the result for a package as soon as it is known. This
+  /// method is called on the thread which started the verification.
+  /// @param packageId Identifies the package.
+  /// @param ok Indicates whether the package is correctly installed.
+public:
+  virtual void MIKTEXTHISCALL OnPackageVerified(const std::string& packageId, bool ok) = 0;
+};
+
 /// The package manager interface.
 class MIKTEXNOVTABLE PackageManager
 {
@@ -175,6 +211,29 @@ public:
 public:
   virtual bool MIKTEXTHISCALL TryVerifyInstalledPackage(const std::string& packageId) = 0;
 
+  /// Tests whether packages are correctly installed.
+  ///
+  /// This method reads all files of the packages in order to verify
+  /// their integrity. Up to `maxJobs` files are read at the same time.
+  ///
+  /// @param packageIds Identifies the packages.
+  /// @param maxJobs The maximum number of threads.
+  /// @return Returns the IDs of the packages which are not correctly installed.
+public:
+  virtual std::vector<std::string> MIKTEXTHISCALL VerifyInstalledPackages(const std::vector<std::string>& packageIds, unsigned maxJobs) = 0;
+
+  /// Tests whether packages are correctly installed.
+  ///
+  /// Results are reported through the callback interface while the
+  /// remaining packages are still being verified.
+  ///
+  /// @param packageIds Identifies the packages.
+  /// @param options Verification options.
+  /// @param callback Pointer to a callback interface (can be `nullptr`).
+  /// @return Returns the IDs of the packages which are not correctly installed.
+public:
+  virtual std::vector<std::string> MIKTEXTHISCALL VerifyInstalledPackages(const std::vector<std::string>& packageIds, const VerifyOptions& options, VerifyCallback* callback) = 0;
+
   /// Builds the container path of a package.
   /// @param packageId Identifies the package.
   /// @param useDisplayNames Indicates whether to use user friendly names.
@@ -188,6 +247,19 @@ public:
 public:
   virtual InstallationSummary MIKTEXTHISCALL GetInstallationSummary(bool userScope) = 0;
 
+  /// Looks up the documentation files of a package in the documentation
+  /// index. The index is made when the package database is updated.
+  /// @param packageId Identifies the package.
+  /// @return Returns the documentation files (in manifest order).
+public:
+  virtual std::vector<DocumentationFile> MIKTEXTHISCALL FindDocumentationByPackage(const std::string& packageId) = 0;
+
+  /// Looks up documentation files by name in the documentation index.
+  /// @param name The file name without directory and extension.
+  /// @return Returns the documentation files.
+public:
+  virtual std::vector<DocumentationFile> MIKTEXTHISCALL FindDocumentationByName(const std::string& name) = 0;
+
 public:
   /// Initialization options.
   struct InitInfo
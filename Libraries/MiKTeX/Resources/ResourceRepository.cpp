@@ -32,7 +32,9 @@ using namespace MiKTeX::Resources;
 class ResourceRepository::impl
 {
 public:
-  map<string, Resource> resources;
+  // transparent comparator: look up resource IDs without creating a
+  // temporary string
+  map<string, Resource, less<>> resources;
 public:
   std::once_flag initFlag;
 };
@@ -162,7 +162,7 @@ unique_ptr<SetupService> SetupService::Create()
 
 unique_ptr<TemporaryDirectory> SetupService::CreateSandbox(StartupConfig& startupConfig)
 {
-    unique_ptr<TemporaryDirectory> sandbox = TemporaryDirectory::Create();
+    unique_ptr<TemporaryDirectory> sandbox = TemporaryDirectory::Create({ TemporaryDirectoryOption::InMemory });
     startupConfig.userInstallRoot = sandbox->GetPathName();
     startupConfig.userDataRoot = sandbox->GetPathName();
     startupConfig.userConfigRoot = sandbox->GetPathName();
@@ -352,7 +352,7 @@ unique_ptr<TemporaryDirectory> SetupService::ExtractFiles()
             memcmp(magic + 15, MAGIC3, 1) == 0)
         {
             unique_ptr<MiKTeX::Extractor::Extractor> extractor(MiKTeX::Extractor::Extractor::CreateExtractor(MiKTeX::Extractor::ArchiveFileType::Tar));
-            unique_ptr<TemporaryDirectory> sfxDir = TemporaryDirectory::Create();
+            unique_ptr<TemporaryDirectory> sfxDir = TemporaryDirectory::Create({ TemporaryDirectoryOption::InMemory });
             extractor->Extract(&myImage, sfxDir->GetPathName(), true);
             return sfxDir;
         }
@@ -1032,12 +1032,14 @@ void SetupServiceImpl::DoFinishUpdate()
     RunMpm({ "--register-components" });
 #endif
     RunOneMiKTeXUtility({ "fndb", "refresh" }, false);
+    vector<vector<string>> jobs;
     if (!session->IsSharedSetup() || session->IsAdminMode())
     {
-        RunOneMiKTeXUtility({ "links", "install", "--force" }, false);
+        jobs.push_back({ "links", "install", "--force" });
     }
-    RunOneMiKTeXUtility({ "fontmaps", "configure" }, false);
-    RunOneMiKTeXUtility({ "languages", "configure" }, false);
+    jobs.push_back({ "fontmaps", "configure" });
+    jobs.push_back({ "languages", "configure" });
+    RunOneMiKTeXUtilities(jobs);
     if (!options.IsPortable && (!session->IsSharedSetup() || session->IsAdminMode()))
     {
 #if defined(MIKTEX_WINDOWS)
@@ -1394,17 +1396,13 @@ void SetupServiceImpl::ConfigureMiKTeX()
             return;
         }
 
-        // create latex.exe, ...
-        RunOneMiKTeXUtility({ "links", "install", "--force" }, false);
-        if (cancelled)
-        {
-            return;
-        }
-
-        // create font map files and language.dat
-        RunOneMiKTeXUtility({ "fontmaps", "configure" }, false);
-        RunOneMiKTeXUtility({ "languages", "configure" }, false);
-
+        // create latex.exe, ..., font map files and language.dat; these
+        // only depend on the file name database
+        RunOneMiKTeXUtilities({
+            { "links", "install", "--force" },
+            { "fontmaps", "configure" },
+            { "languages", "configure" }
+        });
         if (cancelled)
         {
             return;
@@ -1519,12 +1517,8 @@ void SetupServiceImpl::RunIniTeXMF(const vector<string>& args, bool mustSucceed)
     }
 }
 
-void SetupServiceImpl::RunOneMiKTeXUtility(const vector<string>& args, bool mustSucceed)
+vector<string> SetupServiceImpl::MakeOneMiKTeXUtilityCommandLine(const PathName& exePath, const vector<string>& args)
 {
-    // make absolute exe path name
-    PathName exePath = GetBinDir() / PathName(MIKTEX_MIKTEX_EXE);
-
-    // make command line
     vector<string> allArgs{ exePath.GetFileNameWithoutExtension().ToString() };
     if (options.IsCommonSetup && session->IsAdminMode())
     {
@@ -1533,6 +1527,16 @@ void SetupServiceImpl::RunOneMiKTeXUtility(const vector<string>& args, bool must
     allArgs.push_back("--disable-installer");
     allArgs.push_back("--verbose");
     allArgs.insert(allArgs.end(), args.begin(), args.end());
+    return allArgs;
+}
+
+void SetupServiceImpl::RunOneMiKTeXUtility(const vector<string>& args, bool mustSucceed)
+{
+    // make absolute exe path name
+    PathName exePath = GetBinDir() / PathName(MIKTEX_MIKTEX_EXE);
+
+    // make command line
+    vector<string> allArgs = MakeOneMiKTeXUtilityCommandLine(exePath, args);
 
     // run One MiKTeX Utility
     if (!options.IsDryRun)
@@ -1556,6 +1560,63 @@ void SetupServiceImpl::RunOneMiKTeXUtility(const vector<string>& args, bool must
     }
 }
 
+void SetupServiceImpl::RunOneMiKTeXUtilities(const vector<vector<string>>& jobs)
+{
+    if (options.IsDryRun || jobs.empty())
+    {
+        return;
+    }
+
+    PathName exePath = GetBinDir() / PathName(MIKTEX_MIKTEX_EXE);
+
+    // the jobs don't depend on each other: run them side by side and
+    // collect their output, so that the log is not garbled
+    class Job :
+        public IRunProcessCallback
+    {
+    public:
+        bool OnProcessOutput(const void* output, size_t n) override
+        {
+            this->output.append(reinterpret_cast<const char*>(output), n);
+            return true;
+        }
+        vector<string> allArgs;
+        string output;
+        int exitCode = 0;
+        MiKTeXException miktexException;
+        bool succeeded = false;
+    };
+
+    session->UnloadFilenameDatabase();
+    vector<Job> runningJobs(jobs.size());
+    vector<future<void>> futures;
+    for (size_t idx = 0; idx < jobs.size(); ++idx)
+    {
+        Job& job = runningJobs[idx];
+        job.allArgs = MakeOneMiKTeXUtilityCommandLine(exePath, jobs[idx]);
+        futures.push_back(std::async(launch::async, [&job, &exePath]()
+        {
+            job.succeeded = Process::Run(exePath, job.allArgs, &job, &job.exitCode, &job.miktexException, nullptr) && job.exitCode == 0;
+        }));
+    }
+
+    // report in the order of the jobs
+    for (size_t idx = 0; idx < jobs.size(); ++idx)
+    {
+        futures[idx].get();
+        Job& job = runningJobs[idx];
+        Log(fmt::format("{}:\n", CommandLineBuilder(job.allArgs).ToString()));
+        if (!job.output.empty() && !cancelled)
+        {
+            OnProcessOutput(job.output.c_str(), job.output.length());
+        }
+        if (!job.succeeded)
+        {
+            Warning(job.miktexException);
+        }
+    }
+}
+
 void SetupServiceImpl::RunMpm(const vector<string>& args)
 {
     // make absolute exe path name
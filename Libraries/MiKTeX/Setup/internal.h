@@ -28,6 +28,7 @@
 #endif
 
 #include <fstream>
+#include <future>
 #include <mutex>
 #include <set>
 
@@ -262,7 +263,9 @@ protected:
     MiKTeX::Util::PathName GetBinDir() const;
     void ConfigureMiKTeX();
     void RunIniTeXMF(const std::vector<std::string>& args, bool mustSucceed);
+    std::vector<std::string> MakeOneMiKTeXUtilityCommandLine(const MiKTeX::Util::PathName& exePath, const std::vector<std::string>& args);
     void RunOneMiKTeXUtility(const std::vector<std::string>& args, bool mustSucceed);
+    void RunOneMiKTeXUtilities(const std::vector<std::vector<std::string>>& jobs);
     void RunMpm(const std::vector<std::string>& args);
     std::wstring& Expand(const std::string& source, std::wstring& dest);
     bool FindFile(const MiKTeX::Util::PathName& fileName, MiKTeX::Util::PathName& result);
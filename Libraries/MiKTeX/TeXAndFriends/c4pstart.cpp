@@ -77,8 +77,46 @@ public:
 #endif
     bool terminalIssue = false;
     Runtime runtime;
+public:
+    bool IsTerminal(FILE* file);
+private:
+    // terminal classification of stdout/stderr; determined once, because
+    // WriteChar() is called for each character TeX prints
+    bool haveTerminalInfo = false;
+    int fdStdOut = -1;
+    int fdStdErr = -1;
+    bool stdOutIsTerminal = false;
+    bool stdErrIsTerminal = false;
+#if defined(MIKTEX_WINDOWS)
+public:
+    bool consoleIsUtf8 = false;
+#endif
 };
 
+bool C4P::ProgramBase::impl::IsTerminal(FILE* file)
+{
+    int fd = fileno(file);
+    if (fd < 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR("fileno");
+    }
+    if (!haveTerminalInfo)
+    {
+        fdStdOut = (stdout != nullptr ? fileno(stdout) : -1);
+        fdStdErr = (stderr != nullptr ? fileno(stderr) : -1);
+#if defined(MIKTEX_WINDOWS)
+        stdOutIsTerminal = fdStdOut >= 0 && _isatty(fdStdOut);
+        stdErrIsTerminal = fdStdErr >= 0 && _isatty(fdStdErr);
+        consoleIsUtf8 = GetConsoleOutputCP() == 65001;
+#else
+        stdOutIsTerminal = fdStdOut >= 0 && isatty(fdStdOut);
+        stdErrIsTerminal = fdStdErr >= 0 && isatty(fdStdErr);
+#endif
+        haveTerminalInfo = true;
+    }
+    return (fd == fdStdOut && stdOutIsTerminal) || (fd == fdStdErr && stdErrIsTerminal);
+}
+
 C4P::ProgramBase::ProgramBase() :
     pimpl(make_unique<impl>())
 {
@@ -265,21 +303,9 @@ C4P::C4P_text* C4P::ProgramBase::GetStdFilePtr(unsigned idx)
 void C4P::ProgramBase::WriteChar(int ch, FILE* file)
 {
     constexpr char FAILCHAR = '?';
-    int fd = fileno(file);
-    if (fd < 0)
-    {
-        MIKTEX_FATAL_CRT_ERROR("fileno");
-    }
-    int fdStdOut = (stdout != nullptr ? fileno(stdout) : -1);
-    int fdStdErr = (stderr != nullptr ? fileno(stderr) : -1);
-    bool isTerminal = (fd == fdStdOut || fd == fdStdErr);
+    bool isTerminal = pimpl->IsTerminal(file);
 #if defined(MIKTEX_WINDOWS)
-    isTerminal = isTerminal && _isatty(fd);
-#else
-    isTerminal = isTerminal && isatty(fd);
-#endif
-#if defined(MIKTEX_WINDOWS)
-    if (static_cast<unsigned char>(ch) > 127 && isTerminal && GetConsoleOutputCP() != 65001)
+    if (static_cast<unsigned char>(ch) > 127 && isTerminal && !pimpl->consoleIsUtf8)
     {
         pimpl->utf8ConsoleIssue = true;
         ch = FAILCHAR;
@@ -303,3 +329,20 @@ void C4P::ProgramBase::WriteChar(int ch, FILE* file)
         }
     }
 }
+
+void C4P::ProgramBase::WriteChars(const char* s, size_t n, FILE* file)
+{
+    if (pimpl->IsTerminal(file))
+    {
+        // the terminal needs the special treatment of WriteChar()
+        for (size_t idx = 0; idx < n; ++idx)
+        {
+            WriteChar(static_cast<unsigned char>(s[idx]), file);
+        }
+        return;
+    }
+    if (fwrite(s, 1, n, file) != n)
+    {
+        MIKTEX_FATAL_CRT_ERROR("fwrite");
+    }
+}
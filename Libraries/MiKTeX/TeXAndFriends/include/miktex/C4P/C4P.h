@@ -15,6 +15,7 @@
 
 #include <miktex/C4P/config.h>
 
+#include <algorithm>
 #include <cctype>
 #include <climits>
 #include <cmath>
@@ -152,6 +153,39 @@ public:
         return (flags & Buffered) != 0;
     }
 
+    /// Reads the rest of the file into memory.  From now on, reading
+    /// elements doesn't go through stdio anymore.
+    void LoadIntoMemory()
+    {
+        AssertValid();
+        memory.clear();
+        ElementType chunk[4096];
+        std::size_t n;
+        while ((n = fread(chunk, sizeof(ElementType), sizeof(chunk) / sizeof(chunk[0]), file)) > 0)
+        {
+            memory.insert(memory.end(), chunk, chunk + n);
+        }
+        if (ferror(file) != 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR_2("fread", "path", path.ToString());
+        }
+        memoryPos = 0;
+        memoryEof = false;
+        flags |= InMemory;
+    }
+
+    bool IsInMemory() const
+    {
+        return (flags & InMemory) != 0;
+    }
+
+    void Close()
+    {
+        memory.clear();
+        memory.shrink_to_fit();
+        FileRoot::Close();
+    }
+
     const ElementType& bufref() const
     {
         MIKTEX_EXPECT(IsPascalFileIO());
@@ -176,6 +210,11 @@ public:
 
     bool Eof()
     {
+        if (IsInMemory())
+        {
+            return memoryEof || (!IsPascalFileIO() && memoryPos == memory.size());
+        }
+
         if (feof(file) != 0)
         {
             return true;
@@ -207,6 +246,19 @@ public:
 
     bool Eoln()
     {
+        if (IsInMemory())
+        {
+            if (memoryEof)
+            {
+                return true;
+            }
+            if (IsPascalFileIO())
+            {
+                return currentElement == '\r' || currentElement == '\n';
+            }
+            return memoryPos == memory.size() || memory[memoryPos] == '\r' || memory[memoryPos] == '\n';
+        }
+
         if (feof(file) != 0)
         {
             return true;
@@ -258,7 +310,15 @@ public:
     void Reset()
     {
         AssertValid();
-        rewind(*this);
+        if (IsInMemory())
+        {
+            memoryPos = 0;
+            memoryEof = false;
+        }
+        else
+        {
+            rewind(*this);
+        }
         Read();
     }
 
@@ -281,7 +341,18 @@ public:
     void Seek(long offset, int origin)
     {
         AssertValid();
-        if (fseek(*this, offset, origin) != 0)
+        if (IsInMemory())
+        {
+            long base = origin == SEEK_SET ? 0 : origin == SEEK_CUR ? static_cast<long>(memoryPos) : static_cast<long>(memory.size());
+            long newPos = base + offset / static_cast<long>(sizeof(ElementType));
+            if (newPos < 0)
+            {
+                MIKTEX_FATAL_ERROR_2(MIKTEXTEXT("Seek operation failed."), "path", path.ToString(), "offset", std::to_string(offset), "origin", std::to_string(origin));
+            }
+            memoryPos = static_cast<std::size_t>(newPos);
+            memoryEof = false;
+        }
+        else if (fseek(*this, offset, origin) != 0)
         {
             MIKTEX_FATAL_CRT_ERROR_2("fseek", "path", path.ToString(), "offset", std::to_string(offset), "origin", std::to_string(origin));
         }
@@ -291,16 +362,57 @@ public:
         }
     }
 
+    long Tell()
+    {
+        AssertValid();
+        if (IsInMemory())
+        {
+            return static_cast<long>(memoryPos * sizeof(ElementType));
+        }
+        long n = ftell(*this);
+        if (n < 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR_2("ftell", "path", path.ToString());
+        }
+        return n;
+    }
+
 protected:
 
-    enum { Buffered = 0x00010000 };
+    enum { Buffered = 0x00010000, InMemory = 0x00020000 };
 
     ElementType currentElement;
 
+    std::vector<ElementType> memory;
+    std::size_t memoryPos = 0;
+    bool memoryEof = false;
+
     std::size_t ReadInternal(ElementType* buf, std::size_t n)
     {
         AssertValid();
         MIKTEX_ASSERT_BUFFER(buf, n);
+        if (IsInMemory())
+        {
+            if (memoryEof)
+            {
+                MIKTEX_FATAL_ERROR_2(MIKTEXTEXT("Read operation failed: end of file reached"), "path", path.ToString(), "n", std::to_string(n));
+            }
+            std::size_t read = std::min(n, memory.size() - std::min(memoryPos, memory.size()));
+            if (n == 1 && read == 1)
+            {
+                *buf = memory[memoryPos++];
+            }
+            else if (read > 0)
+            {
+                std::copy(memory.begin() + memoryPos, memory.begin() + memoryPos + read, buf);
+                memoryPos += read;
+            }
+            if (read != n)
+            {
+                memoryEof = true;
+            }
+            return read;
+        }
         if (feof(*this) != 0)
         {
             MIKTEX_FATAL_ERROR_2(MIKTEXTEXT("Read operation failed: end of file reached"), "path", path.ToString(), "n", std::to_string(n));
@@ -396,6 +508,12 @@ protected:
         return c4p_write_c(v, f);
     }
 
+    template<class Ft> void c4p_write_chars(const char* s, std::size_t n, Ft& f)
+    {
+        f.AssertValid();
+        WriteChars(s, n, f);
+    }
+
     template<class Vt, class Ft> void c4p_write_i(Vt v, Ft& f)
     {
         f.AssertValid();
@@ -514,12 +632,13 @@ protected:
     template<class Ft> long c4pftell(Ft& f)
     {
         f.AssertValid();
-        long n = ftell(f);
-        if (n < 0)
-        {
-            MIKTEX_FATAL_CRT_ERROR("ftell");
-        }
-        return n;
+        return f.Tell();
+    }
+
+    template<class Ft> void c4ploadintomemory(Ft& f)
+    {
+        f.AssertValid();
+        f.LoadIntoMemory();
     }
 
     template<class Ft> void c4pbufwrite(Ft& f, const void* buf, std::size_t buf_size)
@@ -712,6 +831,7 @@ protected:
 private:
 
     C4PTHISAPI(void) WriteChar(int ch, FILE* file);
+    C4PTHISAPI(void) WriteChars(const char* s, std::size_t n, FILE* file);
 
     class impl;
     std::unique_ptr<impl> pimpl;
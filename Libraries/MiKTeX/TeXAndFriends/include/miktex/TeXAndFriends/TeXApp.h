@@ -131,6 +131,7 @@ inline void miktexallocatememory()
 
 template<class FileType> void miktexclosedvifile(FileType& f)
 {
+    TeXApp::GetTeXApp()->FlushOutputFile(static_cast<FILE*>(f));
     TeXApp::GetTeXApp()->CloseFile(f);
 }
 
@@ -144,6 +145,26 @@ inline void miktexfreememory()
     TeXApp::GetTeXApp()->FreeMemory();
 }
 
+inline void miktexgrowinputstack()
+{
+    TeXApp::GetTeXApp()->GetTeXMFMemoryHandler()->GrowArray("inputstack");
+}
+
+inline void miktexgrownest()
+{
+    TeXApp::GetTeXApp()->GetTeXMFMemoryHandler()->GrowArray("nest");
+}
+
+inline void miktexgrowparamstack()
+{
+    TeXApp::GetTeXApp()->GetTeXMFMemoryHandler()->GrowArray("paramstack");
+}
+
+inline void miktexgrowsavestack()
+{
+    TeXApp::GetTeXApp()->GetTeXMFMemoryHandler()->GrowArray("savestack");
+}
+
 inline bool miktexinsertsrcspecialauto()
 {
     return TeXApp::GetTeXApp()->IsSourceSpecialOn(SourceSpecial::Auto);
@@ -17,6 +17,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <cstddef>
 
@@ -61,6 +62,14 @@ public:
     virtual C4P::C4P_integer& interrupt() = 0;
 };
 
+/// The usage of a memory array at the end of the job.
+struct MemoryUsage
+{
+    std::string arrayName;
+    int used;
+    int size;
+};
+
 class ITeXMFMemoryHandler
 {
 public:
@@ -68,6 +77,8 @@ public:
     virtual void Free() = 0;
     virtual void Check() = 0;
     virtual void* ReallocateArray(const std::string& arrayName, void* ptr, std::size_t elemSize, std::size_t numElem, const MiKTeX::Core::SourceLocation& sourceLocation) = 0;
+    virtual bool GrowArray(const std::string& arrayName) = 0;
+    virtual std::vector<MemoryUsage> GetMemoryUsage() = 0;
 };
 
 class MIKTEXMFTYPEAPI(TeXMFApp) :
@@ -91,33 +102,50 @@ public:
     MIKTEXMFTHISAPI(MiKTeX::Util::PathName) GetDefaultMemoryDumpFileName() const;
     MIKTEXMFTHISAPI(MiKTeX::Util::PathName) GetTcxFileName() const;
     MIKTEXMFTHISAPI(UserParams&) GetUserParams() const;
+    MIKTEXMFTHISAPI(FILE*) OpenPreambleCheckpointFile();
     MIKTEXMFTHISAPI(bool) CStyleErrorMessagesP() const;
+    MIKTEXMFTHISAPI(bool) CreateMemoryArena(bool useExplicitHugePages);
     MIKTEXMFTHISAPI(bool) Enable8BitCharsP() const;
     MIKTEXMFTHISAPI(bool) HaltOnErrorP() const;
     MIKTEXMFTHISAPI(void) InitializeCharTables() const;
     MIKTEXMFTHISAPI(bool) IsFeatureEnabled(Feature f) const;
     MIKTEXMFTHISAPI(bool) IsInitProgram() const;
+    MIKTEXMFTHISAPI(bool) IsMemoryArenaPointer(const void* ptr) const;
+    MIKTEXMFTHISAPI(bool) IsPreambleCheckpointLine(int start, int last) const;
+    MIKTEXMFTHISAPI(bool) IsPreambleCheckpointWanted() const;
+    MIKTEXMFTHISAPI(bool) IsProfileSampleRequested() const;
     MIKTEXMFTHISAPI(bool) OpenFontFile(C4P::BufferedFile<unsigned char>* file, const std::string& fontName, MiKTeX::Core::FileType filetype, const char* generator);
     MIKTEXMFTHISAPI(bool) OpenMemoryDumpFile(const MiKTeX::Util::PathName& fileName, FILE** file, void* buf, std::size_t size, bool renew);
     MIKTEXMFTHISAPI(bool) ParseFirstLineP() const;
     MIKTEXMFTHISAPI(int) GetInteraction() const;
+    MIKTEXMFTHISAPI(int) GetPreambleCheckpointLine() const;
     MIKTEXMFTHISAPI(int) GetTeXStringLength(int stringNumber) const;
     MIKTEXMFTHISAPI(int) GetTeXStringStart(int stringNumber) const;
     MIKTEXMFTHISAPI(int) MakeTeXString(const char* lpsz) const;
     MIKTEXMFTHISAPI(std::string) GetTeXString(int stringStart, int stringLength) const;
+    MIKTEXMFTHISAPI(void*) ReallocateArenaMemory(void* ptr, std::size_t size);
     MIKTEXMFTHISAPI(void) AddOptions() override;
+    MIKTEXMFTHISAPI(void) AddProfileFrame(const std::string& frame);
+    MIKTEXMFTHISAPI(void) BeginProfileSample();
     MIKTEXMFTHISAPI(void) EnableFeature(Feature f);
+    MIKTEXMFTHISAPI(void) EndProfileSample();
     MIKTEXMFTHISAPI(void) Finalize() override;
+    MIKTEXMFTHISAPI(void) FinishPreambleCheckpoint(int lineNumber);
+    MIKTEXMFTHISAPI(void) FlushOutputFile(FILE* file);
     MIKTEXMFTHISAPI(void) Init(std::vector<char*>& args) override;
     MIKTEXMFTHISAPI(void) InitializeBuffer() const;
     MIKTEXMFTHISAPI(void) InvokeEditor(int editFileName, int editFileNameLength, int editLineNumber, int transcriptFileName, int transcriptFileNameLength) const;
     MIKTEXMFTHISAPI(void) ProcessCommandLineOptions() override;
+    MIKTEXMFTHISAPI(void) ReadMemoryDumpFile(FILE* file, void* data, std::size_t size);
     MIKTEXMFTHISAPI(void) SetErrorHandler(IErrorHandler* errorHandler);
+    MIKTEXMFTHISAPI(void) SetPreambleCheckpointRestored();
     MIKTEXMFTHISAPI(void) SetStringHandler(IStringHandler* stringHandler);
     MIKTEXMFTHISAPI(void) SetTcxFileName(const MiKTeX::Util::PathName& tcxFileName);
     MIKTEXMFTHISAPI(void) SetTeXMFMemoryHandler(ITeXMFMemoryHandler* memoryHandler);
     MIKTEXMFTHISAPI(void) TouchJobOutputFile(FILE* file) const override;
+    MIKTEXMFTHISAPI(void) WriteOutputFile(FILE* file, const void* data, std::size_t size);
     virtual MIKTEXMFTHISAPI(int) GetJobName(int fallbackJobName) const;
+    virtual MIKTEXMFTHISAPI(void) OnTeXMFCloseFiles();
     virtual MIKTEXMFTHISAPI(void) OnTeXMFFinishJob();
     virtual MIKTEXMFTHISAPI(void) OnTeXMFStartJob();
 
@@ -192,6 +220,11 @@ public:
         return true;
     }
 
+    template<class T> void OpenPreambleCheckpointFile(T& f)
+    {
+        f.Attach(OpenPreambleCheckpointFile(), true);
+    }
+
     template<typename FILE_, typename ELETYPE_> void Dump(FILE_& f, const ELETYPE_& e, std::size_t n)
     {
         if (fwrite(&e, sizeof(e), n, static_cast<FILE*>(f)) != n)
@@ -208,10 +241,7 @@ public:
     template<typename FILE_, typename ELETYPE_> void Undump(FILE_& f, ELETYPE_& e, std::size_t n)
     {
         f.PascalFileIO(false);
-        if (fread(&e, sizeof(e), n, static_cast<FILE*>(f)) != n)
-        {
-        MIKTEX_FATAL_CRT_ERROR("fread");
-        }
+        ReadMemoryDumpFile(static_cast<FILE*>(f), &e, sizeof(e) * n);
     }
 
     template<typename FILE_, typename ELETYPE_> void Undump(FILE_& f, ELETYPE_& e)
@@ -348,6 +378,11 @@ inline int miktexmakefullnamestring()
     return TeXMFApp::GetTeXMFApp()->MakeFullNameString();
 }
 
+inline void miktexontexmfclosefiles()
+{
+    TeXMFApp::GetTeXMFApp()->OnTeXMFCloseFiles();
+}
+
 inline void miktexontexmffinishjob()
 {
     TeXMFApp::GetTeXMFApp()->OnTeXMFFinishJob();
@@ -363,6 +398,71 @@ inline void miktexontexmfstartjob()
     TeXMFApp::GetTeXMFApp()->OnTeXMFStartJob();
 }
 
+inline bool miktexprofilesamplerequested()
+{
+    return TeXMFApp::GetTeXMFApp()->IsProfileSampleRequested();
+}
+
+inline void miktexprofilebeginsample()
+{
+    TeXMFApp::GetTeXMFApp()->BeginProfileSample();
+}
+
+inline void miktexprofileaddfile(int fileName)
+{
+    TeXMFApp::GetTeXMFApp()->AddProfileFrame(TeXMFApp::GetTeXMFApp()->GetTeXString(fileName));
+}
+
+inline void miktexprofileaddmacro(int csName)
+{
+    if (csName != 0)
+    {
+        TeXMFApp::GetTeXMFApp()->AddProfileFrame("\\" + TeXMFApp::GetTeXMFApp()->GetTeXString(csName));
+    }
+}
+
+inline void miktexprofileendsample(int csName)
+{
+    miktexprofileaddmacro(csName);
+    TeXMFApp::GetTeXMFApp()->EndProfileSample();
+}
+
+inline bool miktexpreamblecheckpointwanted()
+{
+    return TeXMFApp::GetTeXMFApp()->IsPreambleCheckpointWanted();
+}
+
+inline bool miktexispreamblecheckpointline(int start, int last)
+{
+    return TeXMFApp::GetTeXMFApp()->IsPreambleCheckpointLine(start, last);
+}
+
+template<class FILE_> inline void miktexopenpreamblecheckpointfile(FILE_& f)
+{
+    TeXMFApp::GetTeXMFApp()->OpenPreambleCheckpointFile(f);
+}
+
+inline void miktexfinishpreamblecheckpoint(int lineNumber)
+{
+    TeXMFApp::GetTeXMFApp()->FinishPreambleCheckpoint(lineNumber);
+}
+
+inline int miktexpreamblecheckpointline()
+{
+    return TeXMFApp::GetTeXMFApp()->GetPreambleCheckpointLine();
+}
+
+inline void miktexpreamblecheckpointrestored()
+{
+    TeXMFApp::GetTeXMFApp()->SetPreambleCheckpointRestored();
+}
+
+template<class FILE_> inline void miktexwritedvi(FILE_& f, const void* data, std::size_t size)
+{
+    f.AssertValid();
+    TeXMFApp::GetTeXMFApp()->WriteOutputFile(static_cast<FILE*>(f), data, size);
+}
+
 #define miktexreallocate(p, n) miktexreallocate_(#p, p, n, MIKTEX_SOURCE_LOCATION_DEBUG())
 
 template<typename T> T* miktexreallocate_(const std::string& arrayName, T* p, size_t n, const MiKTeX::Core::SourceLocation& sourceLocation)
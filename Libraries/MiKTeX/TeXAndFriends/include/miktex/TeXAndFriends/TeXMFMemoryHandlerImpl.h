@@ -43,6 +43,12 @@ public:
 
     void Allocate(const std::unordered_map<std::string, int>& userParams) override
     {
+        int hugePages = GetParameter("huge_pages", userParams, texmfapp::texmfapp::huge_pages());
+        useMemoryArena = hugePages > 0 && texmfapp.CreateMemoryArena(hugePages > 1);
+        if (hugePages > 0 && !useMemoryArena)
+        {
+            trace_mem->WriteLine("libtexmf", MiKTeX::Trace::TraceLevel::Warning, "huge pages are not available");
+        }
         program.bufsize = GetCheckedParameter("buf_size", program.infbufsize, program.supbufsize, userParams, texmfapp::texmfapp::buf_size());
         program.errorline = GetParameter("error_line", userParams, texmfapp::texmfapp::error_line());
 #if defined(HAVE_EXTRA_MEM_BOT)
@@ -184,10 +190,36 @@ public:
             amount = (numElem + 1) * elemSize;
         }
         trace_mem->WriteLine("libtexmf", "reallocate " + arrayName + ": ptr == " + std::string(ptr == nullptr ? "nullptr" : "...") + ", elementSize == " + std::to_string(elemSize) + ", nElements == " + std::to_string(numElem));
+        if (ptr != nullptr && texmfapp.IsMemoryArenaPointer(ptr))
+        {
+            return texmfapp.ReallocateArenaMemory(ptr, amount);
+        }
+        if (ptr == nullptr && amount > 0 && useMemoryArena && IsMainMemoryArray(arrayName))
+        {
+            return texmfapp.ReallocateArenaMemory(nullptr, amount);
+        }
         ptr = MiKTeX::Debug::Realloc(ptr, amount, sourceLocation);
         return ptr;
     }
 
+    bool GrowArray(const std::string& arrayName) override
+    {
+        return false;
+    }
+
+    std::vector<MemoryUsage> GetMemoryUsage() override
+    {
+        // the high-water marks, as in the statistics shown by TeX and
+        // Metafont
+        return {
+            { "buffer", program.maxbufstack + 1, program.bufsize },
+            { "inputstack", program.maxinstack, program.stacksize },
+            { "paramstack", program.maxparamstack, program.paramsize },
+            { "pool", program.poolptr - program.initpoolptr, program.poolsize - program.initpoolptr },
+            { "strings", program.strptr - program.initstrptr, program.maxstrings - program.initstrptr },
+        };
+    }
+
 protected:
 
     int GetConfigValue(const std::string& valueName, int defaultValue) const
@@ -248,12 +280,41 @@ protected:
         return result;
     }
 
+    // the large, randomly accessed arrays which are placed in the huge
+    // page arena
+    static bool IsMainMemoryArray(const std::string& arrayName)
+    {
+        for (const char* name : { "fontinfo", "mem", "strpool", "strstart", "yhash", "yzmem", "zeqtb" })
+        {
+            if (arrayName == name)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
     template<typename T> T* AllocateArray(const std::string& arrayName, T*& ptr, std::size_t n)
     {
         ptr = (T*)ReallocateArray(arrayName, nullptr, sizeof(*ptr), n, MIKTEX_SOURCE_LOCATION_DEBUG());
         return ptr;
     }
 
+    // doubles the capacity of an array (but not beyond supSize); the
+    // array holds size + extraElements elements
+    template<typename T, typename SizeType> bool ExtendArray(const std::string& arrayName, T*& ptr, SizeType& size, int supSize, int extraElements)
+    {
+        if (size >= supSize)
+        {
+            return false;
+        }
+        SizeType newSize = size > supSize / 2 ? supSize : 2 * size;
+        trace_mem->WriteLine("libtexmf", "grow " + arrayName + ": " + std::to_string(size) + " -> " + std::to_string(newSize));
+        ptr = (T*)ReallocateArray(arrayName, ptr, sizeof(*ptr), newSize + extraElements, MIKTEX_SOURCE_LOCATION_DEBUG());
+        size = newSize;
+        return true;
+    }
+
     template<typename T> void FreeArray(const std::string& arrayName, T*& ptr)
     {
         ReallocateArray(arrayName, ptr, sizeof(*ptr), 0, MIKTEX_SOURCE_LOCATION_DEBUG());
@@ -263,6 +324,7 @@ protected:
     PROGRAM_CLASS& program;
     TeXMFApp& texmfapp;
     std::unique_ptr<MiKTeX::Trace::TraceStream> trace_mem;
+    bool useMemoryArena = false;
 };
 
 MIKTEX_TEXMF_END_NAMESPACE;
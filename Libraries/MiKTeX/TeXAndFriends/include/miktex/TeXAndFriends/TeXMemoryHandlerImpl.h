@@ -170,6 +170,45 @@ public:
         this->FreeArray("widthbase", this->program.widthbase);
     }
 
+    bool GrowArray(const std::string& arrayName) override
+    {
+        if (arrayName == "inputstack")
+        {
+            return this->ExtendArray(arrayName, this->program.inputstack, this->program.stacksize, this->program.supstacksize, 0);
+        }
+        else if (arrayName == "nest")
+        {
+            return this->ExtendArray(arrayName, this->program.nest, this->program.nestsize, this->program.supnestsize, 1);
+        }
+        else if (arrayName == "paramstack")
+        {
+            return this->ExtendArray(arrayName, this->program.paramstack, this->program.paramsize, this->program.supparamsize, 0);
+        }
+        else if (arrayName == "savestack")
+        {
+            return this->ExtendArray(arrayName, this->program.savestack, this->program.savesize, this->program.supsavesize, 1);
+        }
+        return TeXMFMemoryHandlerImpl<PROGRAM_CLASS>::GrowArray(arrayName);
+    }
+
+    std::vector<MemoryUsage> GetMemoryUsage() override
+    {
+        std::vector<MemoryUsage> usage = TeXMFMemoryHandlerImpl<PROGRAM_CLASS>::GetMemoryUsage();
+        usage.push_back({ "fontinfo", this->program.fmemptr, this->program.fontmemsize });
+        usage.push_back({ "fonts", this->program.fontptr - this->program.constfontbase, this->program.fontmax - this->program.constfontbase });
+        // only the part of the hash table beyond the fixed hash_size can be configured
+        usage.push_back({ "hash_extra", this->program.hashhigh, this->program.hashextra });
+        usage.push_back({ "hyphenation", this->program.hyphcount, this->program.hyphsize });
+        usage.push_back({ "mem", this->program.lomemmax - this->program.memmin + this->program.memend - this->program.himemmin + 2, this->program.memend + 1 - this->program.memmin });
+        // the words in use at the end of the job, as counted by TeX's stat code
+        usage.push_back({ "mem_dyn", this->program.dynused, this->program.memend + 1 - this->program.himemmin });
+        usage.push_back({ "mem_var", this->program.varused, this->program.lomemmax + 1 - this->program.memmin });
+        usage.push_back({ "nest", this->program.maxneststack + 1, this->program.nestsize });
+        usage.push_back({ "savestack", this->program.maxsavestack + 6, this->program.savesize });
+        usage.push_back({ "trie", this->program.triemax, this->program.triesize });
+        return usage;
+    }
+
     void Check() override
     {
         TeXMFMemoryHandlerImpl<PROGRAM_CLASS>::Check();
@@ -131,6 +131,7 @@ protected:
     MIKTEXMFTHISAPI(bool) ProcessOption(int opt, const std::string& optArg) override;
     MIKTEXMFTHISAPI(void) AddOptions() override;
     MIKTEXMFTHISAPI(void) EnableShellCommands(MiKTeX::Core::ShellCommandMode mode);
+    MIKTEXMFTHISAPI(void) ForgetFileLookups() const;
     virtual MIKTEXMFTHISAPI(void) TouchJobOutputFile(FILE*) const;
 
 private:
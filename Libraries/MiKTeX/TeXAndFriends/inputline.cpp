@@ -114,6 +114,14 @@ struct OpenFileInfo
     PathName path;
 };
 
+// the result of an input file lookup
+struct FileLookup
+{
+    PathName fileName;
+    bool found;
+    PathName foundFile;
+};
+
 class WebAppInputLine::impl
 {
 public:
@@ -129,8 +137,30 @@ public:
     TriState allowInput = TriState::Undetermined;
     TriState allowOutput = TriState::Undetermined;
     unordered_map<const FILE*, OpenFileInfo> openFiles;
+    // input file lookups (by file name in internal encoding); packages probe
+    // the same files again and again
+    unordered_map<string, FileLookup> fileLookups;
+    void ForgetFileLookups(const PathName& path);
 };
 
+void WebAppInputLine::impl::ForgetFileLookups(const PathName& path)
+{
+    // the lookup might have been done with or without a file name
+    // extension
+    PathName name = path.GetFileNameWithoutExtension();
+    for (auto it = fileLookups.begin(); it != fileLookups.end(); )
+    {
+        if (it->second.fileName.GetFileNameWithoutExtension() == name)
+        {
+            it = fileLookups.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
 WebAppInputLine::WebAppInputLine() :
     pimpl(make_unique<impl>())
 {
@@ -151,6 +181,7 @@ void WebAppInputLine::Finalize()
     pimpl->foundFile.Clear();
     pimpl->foundFileFq.Clear();
     pimpl->lastInputFileName.Clear();
+    pimpl->fileLookups.clear();
     pimpl->outputDirectory.Clear();
     pimpl->auxDirectory.Clear();
     WebApp::Finalize();
@@ -276,6 +307,8 @@ bool WebAppInputLine::OpenOutputFile(C4P::FileRoot& f, const PathName& fileNameI
         }
         file = OpenFileInternal(PathName(toBeExecuted), FileMode::Command, FileAccess::Write);
         pimpl->openFiles[file] = OpenFileInfo{ FileAccess::Write, FileMode::Command, PathName(toBeExecuted) };
+        // the command might create files
+        ForgetFileLookups();
     }
     else
     {
@@ -296,6 +329,7 @@ bool WebAppInputLine::OpenOutputFile(C4P::FileRoot& f, const PathName& fileNameI
         {
             outPath = fileName;
             pimpl->openFiles[file] = OpenFileInfo{ FileAccess::Write,  FileMode::Create, outPath };
+            pimpl->ForgetFileLookups(outPath);
         }
     }
     if (file == nullptr)
@@ -322,7 +356,9 @@ MiKTeX::Util::PathName WebAppInputLine::DecodeFileName(const PathName& fileNameI
 
 bool WebAppInputLine::OpenInputFile(FILE** ppFile, const PathName& fileNameInternalEncoding)
 {
-    auto fileName = DecodeFileName(fileNameInternalEncoding);
+    auto lookup = pimpl->fileLookups.find(fileNameInternalEncoding.ToString());
+
+    auto fileName = lookup != pimpl->fileLookups.end() ? lookup->second.fileName : DecodeFileName(fileNameInternalEncoding);
 
     shared_ptr<Session> session = GetSession();
 
@@ -369,16 +405,28 @@ bool WebAppInputLine::OpenInputFile(FILE** ppFile, const PathName& fileNameInter
         LogInfo("executing input pipe: " + toBeExecuted);
         *ppFile = OpenFileInternal(PathName(toBeExecuted), FileMode::Command, FileAccess::Read);
         pimpl->openFiles[*ppFile] = OpenFileInfo{ FileAccess::Read,  FileMode::Command, PathName(toBeExecuted) };
+        // the command might create files
+        ForgetFileLookups();
+        lookup = pimpl->fileLookups.end();
         pimpl->foundFile.Clear();
         pimpl->foundFileFq.Clear();
     }
     else
     {
-        if (!session->FindFile(fileName.GetData(), GetInputFileType(), pimpl->foundFile))
+        if (lookup == pimpl->fileLookups.end())
+        {
+            FileLookup newLookup{ fileName, false, PathName() };
+            newLookup.found = session->FindFile(fileName.GetData(), GetInputFileType(), newLookup.foundFile);
+            lookup = pimpl->fileLookups.emplace(fileNameInternalEncoding.ToString(), newLookup).first;
+        }
+
+        if (!lookup->second.found)
         {
             return false;
         }
 
+        pimpl->foundFile = lookup->second.foundFile;
+
         pimpl->foundFileFq = pimpl->foundFile;
         pimpl->foundFileFq.MakeFullyQualified();
 
@@ -434,6 +482,11 @@ bool WebAppInputLine::OpenInputFile(FILE** ppFile, const PathName& fileNameInter
 
     if (*ppFile == nullptr)
     {
+        if (lookup != pimpl->fileLookups.end())
+        {
+            // the file has disappeared
+            pimpl->fileLookups.erase(lookup);
+        }
         return false;
     }
 
@@ -504,6 +557,11 @@ void WebAppInputLine::TouchJobOutputFile(FILE*) const
 {
 }
 
+void WebAppInputLine::ForgetFileLookups() const
+{
+    pimpl->fileLookups.clear();
+}
+
 void WebAppInputLine::SetOutputDirectory(const PathName& path)
 {
     if (pimpl->outputDirectory == path)
@@ -622,15 +680,19 @@ void WebAppInputLine::BufferSizeExceeded() const
 size_t WebAppInputLine::InputLineInternal(FILE* f, char* buffer, char* buffer2, size_t bufferSize, size_t bufferPosition, int& lastChar) const
 {
     MIKTEX_ASSERT(buffer2 == nullptr);
+    // take the stream lock once per line, not once per character
+    StreamLock streamLock(f);
+    char* bufferPtr = buffer + bufferPosition;
+    char* bufferEnd = buffer + bufferSize;
     do
     {
         errno = 0;
-        while (bufferPosition < bufferSize && (lastChar = GetC(f)) != EOF && lastChar != '\n' && lastChar != '\r')
+        while (bufferPtr < bufferEnd && (lastChar = GetCUnlocked(f)) != EOF && lastChar != '\n' && lastChar != '\r')
         {
-            buffer[bufferPosition++] = lastChar;
+            *bufferPtr++ = lastChar;
         }
     } while (lastChar == EOF && errno == EINTR);
-    return bufferPosition;
+    return bufferPtr - buffer;
 }
 
 /**
@@ -36,6 +36,22 @@ namespace MiKTeX {                                      \
     }                                           \
 }
 
+#include <cstddef>
+#include <cstdio>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/Util/PathName>
+
 #include "TeXMFResources.h"
 
 BEGIN_INTERNAL_NAMESPACE;
@@ -51,6 +67,207 @@ inline int GetC(FILE* file)
     return ch;
 }
 
+/// Holds the lock of a stream, so that a run of characters can be read
+/// with GetCUnlocked() without locking the stream for each character.
+class StreamLock
+{
+public:
+    StreamLock(FILE* file) :
+        file(file)
+    {
+#if defined(_MSC_VER)
+        _lock_file(file);
+#else
+        flockfile(file);
+#endif
+    }
+
+    StreamLock(const StreamLock& other) = delete;
+    StreamLock& operator=(const StreamLock& other) = delete;
+
+    ~StreamLock()
+    {
+#if defined(_MSC_VER)
+        _unlock_file(file);
+#else
+        funlockfile(file);
+#endif
+    }
+
+private:
+    FILE* file;
+};
+
+inline int GetCUnlocked(FILE* file)
+{
+    MIKTEX_ASSERT(file != nullptr);
+#if defined(_MSC_VER)
+    int ch = _getc_nolock(file);
+#else
+    int ch = getc_unlocked(file);
+#endif
+    if (ch == EOF && ferror(file) != 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR("getc");
+    }
+    return ch;
+}
+
+/// A memory arena made of huge pages. The arena is a single mapping, which
+/// is released as a whole.
+class MemoryArena
+{
+public:
+    MemoryArena() = default;
+    MemoryArena(const MemoryArena& other) = delete;
+    MemoryArena& operator=(const MemoryArena& other) = delete;
+    ~MemoryArena() noexcept;
+
+    /// Reserves the address space of the arena.
+    /// @param useExplicitHugePages Use pages from the huge page pool (instead
+    /// of asking for transparent huge pages).
+    /// @return Returns `false`, if the arena is not supported.
+    bool Create(bool useExplicitHugePages);
+
+    /// Releases the arena and all blocks.
+    void Release();
+
+    /// Allocates, resizes or frees a block.
+    void* Reallocate(void* ptr, std::size_t size);
+
+    bool Contains(const void* ptr) const
+    {
+        return base != nullptr && ptr >= base && ptr < base + usedSize;
+    }
+
+private:
+    void Commit(std::size_t size);
+
+    void* mapping = nullptr;
+    std::size_t mappingSize = 0;
+    unsigned char* base = nullptr;
+    std::size_t reservedSize = 0;
+    std::size_t committedSize = 0;
+    std::size_t usedSize = 0;
+    bool useExplicitHugePages = false;
+    std::unordered_map<void*, std::size_t> blocks;
+};
+
+/// A sampling profiler. A timer thread requests samples; the samples are
+/// taken by the program thread (see `check_interrupt`), so that the
+/// program state is consistent.
+class SamplingProfiler
+{
+public:
+    SamplingProfiler() = default;
+    SamplingProfiler(const SamplingProfiler& other) = delete;
+    SamplingProfiler& operator=(const SamplingProfiler& other) = delete;
+    ~SamplingProfiler() noexcept;
+
+    void Start(std::chrono::microseconds interval);
+    void Stop();
+
+    bool IsSampleRequested() const
+    {
+        return sampleRequested.load(std::memory_order_relaxed);
+    }
+
+    void BeginSample();
+
+    /// Adds a frame to the current sample, outermost frame first.
+    void AddFrame(const std::string& frame);
+
+    void EndSample();
+
+    /// Writes the samples as folded stacks.
+    void Write(const MiKTeX::Util::PathName& path) const;
+
+private:
+    std::atomic<bool> sampleRequested{ false };
+    std::thread timerThread;
+    std::mutex timerMutex;
+    std::condition_variable stopCondition;
+    bool stopRequested = false;
+    std::string stack;
+    std::map<std::string, std::size_t> samples;
+};
+
+/// Writes an output file on a background thread, so that the program can
+/// go on while the data is written (or consumed by the other end of a
+/// pipe).
+class OutputWriter
+{
+public:
+    OutputWriter() = default;
+    OutputWriter(const OutputWriter& other) = delete;
+    OutputWriter& operator=(const OutputWriter& other) = delete;
+    ~OutputWriter() noexcept;
+
+    void Start(FILE* file);
+
+    FILE* GetFile() const
+    {
+        return file;
+    }
+
+    /// Queues data. Waits, if too much data is pending.
+    void Write(const void* data, std::size_t size);
+
+    /// Waits until all data has been written and stops the writer thread.
+    void Finish();
+
+private:
+    void Run();
+
+    FILE* file = nullptr;
+    std::vector<unsigned char> chunk;
+    std::deque<std::vector<unsigned char>> queue;
+    std::thread writerThread;
+    std::mutex queueMutex;
+    std::condition_variable dataCondition;
+    std::condition_variable spaceCondition;
+    bool finishRequested = false;
+    // the errno value of the first failed write
+    int writeError = 0;
+};
+
+/// Measures the wall-clock time and the CPU time spent in the phases of a
+/// job.
+class JobStatistics
+{
+public:
+    struct Phase
+    {
+        std::string name;
+        std::chrono::steady_clock::duration wallTime;
+        std::chrono::nanoseconds cpuTime;
+    };
+
+    /// Ends the current phase and begins the next one. The times of a phase
+    /// which is entered more than once are added up. The name must be a
+    /// string literal: it is also recorded as an event span.
+    void BeginPhase(const char* name);
+
+    void EndPhase();
+
+    /// Gets the peak resident set size (in bytes) of the process.
+    static std::size_t GetPeakResidentSetSize();
+
+    /// Gets the phases in the order in which they were first entered.
+    const std::vector<Phase>& GetPhases() const
+    {
+        return phases;
+    }
+
+private:
+    std::vector<Phase> phases;
+    bool inPhase = false;
+    std::size_t currentPhase = 0;
+    const char* currentPhaseName = nullptr;
+    std::chrono::steady_clock::time_point phaseStart;
+    std::chrono::nanoseconds phaseStartCpuTime;
+};
+
 END_INTERNAL_NAMESPACE;
 
 
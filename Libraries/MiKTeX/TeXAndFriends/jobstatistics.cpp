@@ -0,0 +1,113 @@
+/**
+ * @file jobstatistics.cpp
+ * @author Christian Schenk
+ * @brief Job statistics
+ *
+ * @copyright Copyright © 2022 Christian Schenk
+ *
+ * This file is part of the MiKTeX TeXMF Framework.
+ *
+ * The MiKTeX TeXMF Framework is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#if defined(MIKTEX_WINDOWS)
+#   include <Windows.h>
+#   include <psapi.h>
+#else
+#   include <ctime>
+#   include <sys/resource.h>
+#endif
+
+#include <miktex/Core/Debug>
+#include <miktex/Core/Session>
+#include <miktex/Trace/EventRecorder>
+
+#include "internal.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+
+// the CPU time consumed by all threads of the process
+STATICFUNC(chrono::nanoseconds) GetProcessCpuTime()
+{
+#if defined(MIKTEX_WINDOWS)
+    FILETIME ftCreate, ftExit, ftKernel, ftUser;
+    if (!GetProcessTimes(GetCurrentProcess(), &ftCreate, &ftExit, &ftKernel, &ftUser))
+    {
+        return chrono::nanoseconds::zero();
+    }
+    ULARGE_INTEGER kernel;
+    kernel.LowPart = ftKernel.dwLowDateTime;
+    kernel.HighPart = ftKernel.dwHighDateTime;
+    ULARGE_INTEGER user;
+    user.LowPart = ftUser.dwLowDateTime;
+    user.HighPart = ftUser.dwHighDateTime;
+    // FILETIME: 100-nanosecond intervals
+    return chrono::nanoseconds((kernel.QuadPart + user.QuadPart) * 100);
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR("clock_gettime");
+    }
+    return chrono::seconds(ts.tv_sec) + chrono::nanoseconds(ts.tv_nsec);
+#endif
+}
+
+void JobStatistics::BeginPhase(const char* name)
+{
+    EndPhase();
+    for (currentPhase = 0; currentPhase < phases.size() && phases[currentPhase].name != name; ++currentPhase)
+    {
+    }
+    if (currentPhase == phases.size())
+    {
+        phases.push_back(Phase{ name, chrono::steady_clock::duration::zero(), chrono::nanoseconds::zero() });
+    }
+    inPhase = true;
+    currentPhaseName = name;
+    EventRecorder::Begin(name);
+    phaseStart = chrono::steady_clock::now();
+    phaseStartCpuTime = GetProcessCpuTime();
+}
+
+void JobStatistics::EndPhase()
+{
+    if (!inPhase)
+    {
+        return;
+    }
+    MIKTEX_ASSERT(currentPhase < phases.size());
+    phases[currentPhase].wallTime += chrono::steady_clock::now() - phaseStart;
+    phases[currentPhase].cpuTime += GetProcessCpuTime() - phaseStartCpuTime;
+    EventRecorder::End(currentPhaseName);
+    inPhase = false;
+}
+
+size_t JobStatistics::GetPeakResidentSetSize()
+{
+#if defined(MIKTEX_WINDOWS)
+    PROCESS_MEMORY_COUNTERS memoryCounters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters)))
+    {
+        return 0;
+    }
+    return memoryCounters.PeakWorkingSetSize;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#if defined(__APPLE__)
+    // bytes
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    // kilobytes
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
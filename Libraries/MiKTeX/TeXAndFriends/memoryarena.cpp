@@ -0,0 +1,189 @@
+/**
+ * @file memoryarena.cpp
+ * @author Christian Schenk
+ * @brief Huge page backed memory arena
+ *
+ * @copyright Copyright © 2022 Christian Schenk
+ *
+ * This file is part of the MiKTeX TeXMF Framework.
+ *
+ * The MiKTeX TeXMF Framework is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#include <cstring>
+
+#if defined(MIKTEX_UNIX)
+#   include <sys/mman.h>
+#endif
+
+#if defined(MIKTEX_UNIX) && (defined(__LP64__) || defined(_LP64))
+#   define HAVE_MEMORY_ARENA 1
+#endif
+
+#include <miktex/Core/Debug>
+#include <miktex/Core/Session>
+
+#include "internal.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+
+#if defined(HAVE_MEMORY_ARENA)
+// the address space reserved for the arena; pages are committed on demand
+const size_t ARENA_RESERVE_SIZE = size_t(16) * 1024 * 1024 * 1024;
+#endif
+
+// the arena is committed in units of huge pages
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// alignment of arena blocks (cache line size)
+const size_t BLOCK_ALIGNMENT = 64;
+
+inline size_t RoundUp(size_t n, size_t alignment)
+{
+    return (n + alignment - 1) & ~(alignment - 1);
+}
+
+MemoryArena::~MemoryArena() noexcept
+{
+    try
+    {
+        Release();
+    }
+    catch (const exception&)
+    {
+    }
+}
+
+bool MemoryArena::Create(bool useExplicitHugePages)
+{
+    MIKTEX_ASSERT(base == nullptr);
+#if defined(HAVE_MEMORY_ARENA)
+    void* p = mmap(nullptr, ARENA_RESERVE_SIZE + HUGE_PAGE_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED)
+    {
+        return false;
+    }
+    mapping = p;
+    mappingSize = ARENA_RESERVE_SIZE + HUGE_PAGE_SIZE;
+    // huge pages must be aligned on a huge page boundary
+    base = reinterpret_cast<unsigned char*>(RoundUp(reinterpret_cast<size_t>(p), HUGE_PAGE_SIZE));
+    reservedSize = ARENA_RESERVE_SIZE;
+    committedSize = 0;
+    usedSize = 0;
+    this->useExplicitHugePages = useExplicitHugePages;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MemoryArena::Release()
+{
+#if defined(HAVE_MEMORY_ARENA)
+    if (mapping != nullptr)
+    {
+        void* p = mapping;
+        mapping = nullptr;
+        base = nullptr;
+        blocks.clear();
+        if (munmap(p, mappingSize) != 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR("munmap");
+        }
+    }
+#endif
+}
+
+void* MemoryArena::Reallocate(void* ptr, size_t size)
+{
+    MIKTEX_ASSERT(base != nullptr);
+    if (size == 0)
+    {
+        // the space is not reused; it will be released together with the
+        // arena
+        if (ptr != nullptr)
+        {
+            blocks.erase(ptr);
+        }
+        return nullptr;
+    }
+    size = RoundUp(size, BLOCK_ALIGNMENT);
+    size_t oldSize = 0;
+    if (ptr != nullptr)
+    {
+        auto it = blocks.find(ptr);
+        if (it == blocks.end())
+        {
+            MIKTEX_UNEXPECTED();
+        }
+        oldSize = it->second;
+        if (static_cast<unsigned char*>(ptr) + oldSize == base + usedSize)
+        {
+            // the last block can be resized in place
+            Commit(usedSize - oldSize + size);
+            usedSize = usedSize - oldSize + size;
+            it->second = size;
+            return ptr;
+        }
+    }
+    Commit(usedSize + size);
+    void* result = base + usedSize;
+    usedSize += size;
+    blocks[result] = size;
+    if (ptr != nullptr)
+    {
+        memcpy(result, ptr, min(oldSize, size));
+        blocks.erase(ptr);
+    }
+    return result;
+}
+
+void MemoryArena::Commit(size_t size)
+{
+    if (size <= committedSize)
+    {
+        return;
+    }
+#if defined(HAVE_MEMORY_ARENA)
+    if (size > reservedSize)
+    {
+        MIKTEX_FATAL_ERROR_2("The memory arena is exhausted.", "size", std::to_string(size));
+    }
+    size_t newCommittedSize = RoundUp(size, HUGE_PAGE_SIZE);
+    unsigned char* start = base + committedSize;
+    size_t length = newCommittedSize - committedSize;
+    bool committed = false;
+#if defined(MAP_HUGETLB)
+    if (useExplicitHugePages)
+    {
+        // fails (instead of crashing later), if the huge page pool is too
+        // small: we don't pass MAP_NORESERVE
+        committed = mmap(start, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB, -1, 0) != MAP_FAILED;
+        if (!committed)
+        {
+            // don't try again
+            useExplicitHugePages = false;
+        }
+    }
+#endif
+    if (!committed)
+    {
+        // map the range again (instead of mprotect()): a failed MAP_FIXED
+        // mapping might have removed the reservation
+        if (mmap(start, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED)
+        {
+            MIKTEX_FATAL_CRT_ERROR("mmap");
+        }
+#if defined(MADV_HUGEPAGE)
+        // a hint: transparent huge pages might be disabled
+        madvise(start, length, MADV_HUGEPAGE);
+#endif
+    }
+    committedSize = newCommittedSize;
+#else
+    MIKTEX_UNEXPECTED();
+#endif
+}
@@ -0,0 +1,134 @@
+/**
+ * @file outputwriter.cpp
+ * @author Christian Schenk
+ * @brief Background output writer
+ *
+ * @copyright Copyright © 2022 Christian Schenk
+ *
+ * This file is part of the MiKTeX TeXMF Framework.
+ *
+ * The MiKTeX TeXMF Framework is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#include <cerrno>
+#include <cstdio>
+
+#include <miktex/Core/Debug>
+#include <miktex/Core/Session>
+
+#include "internal.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+
+// data is handed over to the writer thread in chunks of this size
+const size_t CHUNK_SIZE = 64 * 1024;
+
+// the program waits, if that many chunks are pending
+const size_t MAX_PENDING_CHUNKS = 64;
+
+OutputWriter::~OutputWriter() noexcept
+{
+    try
+    {
+        Finish();
+    }
+    catch (const exception&)
+    {
+    }
+}
+
+void OutputWriter::Start(FILE* file)
+{
+    MIKTEX_ASSERT(file != nullptr);
+    MIKTEX_ASSERT(!writerThread.joinable());
+    this->file = file;
+    chunk.reserve(CHUNK_SIZE);
+    finishRequested = false;
+    writeError = 0;
+    writerThread = thread([this]() { Run(); });
+}
+
+void OutputWriter::Write(const void* data, size_t size)
+{
+    MIKTEX_ASSERT(writerThread.joinable());
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    chunk.insert(chunk.end(), bytes, bytes + size);
+    if (chunk.size() >= CHUNK_SIZE)
+    {
+        unique_lock<mutex> lock(queueMutex);
+        spaceCondition.wait(lock, [this]() { return queue.size() < MAX_PENDING_CHUNKS || writeError != 0; });
+        if (writeError != 0)
+        {
+            errno = writeError;
+            MIKTEX_FATAL_CRT_ERROR("fwrite");
+        }
+        queue.push_back(std::move(chunk));
+        chunk = vector<unsigned char>();
+        chunk.reserve(CHUNK_SIZE);
+        dataCondition.notify_one();
+    }
+}
+
+void OutputWriter::Finish()
+{
+    if (!writerThread.joinable())
+    {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(queueMutex);
+        if (!chunk.empty())
+        {
+            queue.push_back(std::move(chunk));
+            chunk = vector<unsigned char>();
+        }
+        finishRequested = true;
+    }
+    dataCondition.notify_one();
+    writerThread.join();
+    if (writeError != 0)
+    {
+        errno = writeError;
+        MIKTEX_FATAL_CRT_ERROR("fwrite");
+    }
+    if (fflush(file) != 0)
+    {
+        MIKTEX_FATAL_CRT_ERROR("fflush");
+    }
+}
+
+void OutputWriter::Run()
+{
+    unique_lock<mutex> lock(queueMutex);
+    while (true)
+    {
+        dataCondition.wait(lock, [this]() { return !queue.empty() || finishRequested; });
+        if (queue.empty())
+        {
+            break;
+        }
+        vector<unsigned char> data = std::move(queue.front());
+        queue.pop_front();
+        if (writeError != 0)
+        {
+            // the program will be told on the next occasion
+            continue;
+        }
+        lock.unlock();
+        spaceCondition.notify_one();
+        int error = 0;
+        if (fwrite(data.data(), 1, data.size(), file) != data.size())
+        {
+            error = errno != 0 ? errno : EIO;
+        }
+        lock.lock();
+        if (error != 0)
+        {
+            writeError = error;
+            spaceCondition.notify_one();
+        }
+    }
+}
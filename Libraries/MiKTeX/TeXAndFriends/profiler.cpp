@@ -0,0 +1,104 @@
+/**
+ * @file profiler.cpp
+ * @author Christian Schenk
+ * @brief Sampling profiler
+ *
+ * @copyright Copyright © 2022 Christian Schenk
+ *
+ * This file is part of the MiKTeX TeXMF Framework.
+ *
+ * The MiKTeX TeXMF Framework is licensed under GNU General Public License
+ * version 2 or any later version.
+ */
+
+#include <fstream>
+
+#include <miktex/Core/Debug>
+#include <miktex/Core/File>
+#include <miktex/Core/Session>
+
+#include "internal.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+SamplingProfiler::~SamplingProfiler() noexcept
+{
+    try
+    {
+        Stop();
+    }
+    catch (const exception&)
+    {
+    }
+}
+
+void SamplingProfiler::Start(chrono::microseconds interval)
+{
+    MIKTEX_ASSERT(!timerThread.joinable());
+    stopRequested = false;
+    timerThread = thread([this, interval]()
+    {
+        unique_lock<mutex> lock(timerMutex);
+        while (!stopCondition.wait_for(lock, interval, [this]() { return stopRequested; }))
+        {
+            sampleRequested.store(true, memory_order_relaxed);
+        }
+    });
+}
+
+void SamplingProfiler::Stop()
+{
+    if (!timerThread.joinable())
+    {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(timerMutex);
+        stopRequested = true;
+    }
+    stopCondition.notify_one();
+    timerThread.join();
+    sampleRequested.store(false, memory_order_relaxed);
+}
+
+void SamplingProfiler::BeginSample()
+{
+    sampleRequested.store(false, memory_order_relaxed);
+    stack.clear();
+}
+
+void SamplingProfiler::AddFrame(const string& frame)
+{
+    if (!stack.empty())
+    {
+        stack += ';';
+    }
+    for (char ch : frame)
+    {
+        // ';' separates frames; a sample is one line
+        stack += (ch == ';' || ch == '\n' || ch == '\r' ? '_' : ch);
+    }
+}
+
+void SamplingProfiler::EndSample()
+{
+    if (!stack.empty())
+    {
+        samples[stack] += 1;
+    }
+}
+
+void SamplingProfiler::Write(const PathName& path) const
+{
+    // the "folded stacks" format understood by flamegraph.pl and speedscope:
+    // one line per distinct stack, followed by the number of samples
+    ofstream stream = File::CreateOutputStream(path);
+    for (const auto& s : samples)
+    {
+        stream << s.first << " " << s.second << "\n";
+    }
+    stream.close();
+}
@@ -402,6 +402,8 @@ TeXApp::Write18Result TeXApp::Write18(const string& command, int& exitCode) cons
     }
     Process::ExecuteSystemCommand(toBeExecuted, &exitCode);
     LogInfo(fmt::format("write18 exit code: {0}", exitCode));
+    // the command might have created files
+    ForgetFileLookups();
     return examineResult == Session::ExamineCommandLineResult::ProbablySafe ? Write18Result::ExecutedAllowed : Write18Result::Executed;
 }
 
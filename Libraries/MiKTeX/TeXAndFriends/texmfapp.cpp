@@ -11,17 +11,34 @@
  * version 2 or any later version.
  */
 
+#include <cstring>
+#include <ctime>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
 #include <sstream>
+#include <unordered_map>
+
+#include <zlib.h>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <nlohmann/json.hpp>
+
 #include <miktex/Configuration/ConfigNames>
 
 #include <miktex/Core/AutoResource>
 #include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
+#include <miktex/Core/MemoryMappedFile>
 #include <miktex/Core/Paths>
+#include <miktex/Core/Process>
 #include <miktex/Core/StreamReader>
+#include <miktex/Core/TemporaryFile>
 
 #include <miktex/Trace/Trace>
 
@@ -54,6 +71,13 @@ using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
 using namespace MiKTeX::Wrappers;
 
+// how often the profiler takes a sample
+const chrono::microseconds PROFILE_SAMPLE_INTERVAL(1000);
+
+// the preamble checkpoint is taken before reading the main input file line
+// which starts with this text
+const char* const PREAMBLE_CHECKPOINT_MARKER = "\\begin{document}";
+
 class TeXMFApp::impl
 {
 public:
@@ -78,6 +102,72 @@ public:
     IErrorHandler* errorHandler = nullptr;
     ITeXMFMemoryHandler* memoryHandler = nullptr;
     UserParams userParams;
+    // the memory dump file being undumped
+    FILE* memoryDumpFile = nullptr;
+    unique_ptr<MemoryMappedFile> memoryDumpMapping;
+    // the uncompressed contents of a compressed memory dump file
+    vector<unsigned char> memoryDumpBuffer;
+    // the mapped (or uncompressed) contents; nullptr, if the dump file is
+    // read with fread()
+    const unsigned char* memoryDumpData = nullptr;
+    size_t memoryDumpSize = 0;
+    size_t memoryDumpPosition = 0;
+    // the huge page arena holding the main memory arrays (if enabled)
+    unique_ptr<MemoryArena> memoryArena;
+    PathName profileFileName;
+    unique_ptr<SamplingProfiler> profiler;
+    // writes the DVI file on a background thread
+    unique_ptr<OutputWriter> outputWriter;
+    PathName statsFileName;
+    unique_ptr<JobStatistics> jobStatistics;
+    bool enablePreambleCheckpoint = false;
+    // the main input file and the files holding its preamble checkpoint
+    PathName checkpointInputFile;
+    PathName checkpointDumpFile;
+    PathName checkpointRecordFile;
+    unique_ptr<TemporaryFile> checkpointTmpDumpFile;
+    // the checkpoint has not been taken yet
+    bool checkpointWanted = false;
+    // > 0, if the checkpoint is being restored: the number of the line at
+    // which it was taken
+    int checkpointLine = 0;
+    // the strings made by MakeTeXString(); TeX may have flushed them since
+    unordered_map<string, int> texStrings;
+
+    bool PreparePreambleCheckpoint(shared_ptr<Session> session, const PathName& inputFile, const string& key, const string& dumpFileExtension);
+
+    void ReleaseMemoryDump()
+    {
+        memoryDumpFile = nullptr;
+        memoryDumpMapping = nullptr;
+        memoryDumpBuffer = vector<unsigned char>();
+        memoryDumpData = nullptr;
+        memoryDumpSize = 0;
+        memoryDumpPosition = 0;
+    }
+
+    void MemoryDumpRead(size_t size)
+    {
+        memoryDumpPosition += size;
+        if (memoryDumpPosition == memoryDumpSize)
+        {
+            // everything has been undumped
+            ReleaseMemoryDump();
+            if (jobStatistics != nullptr)
+            {
+                jobStatistics->BeginPhase("typesetting");
+            }
+        }
+    }
+
+    string GetUnquotedJobName() const
+    {
+        if (jobName.length() > 2 && jobName.front() == '"' && jobName.back() == '"')
+        {
+            return jobName.substr(1, jobName.length() - 2);
+        }
+        return jobName;
+    }
 };
 
 TeXMFApp::TeXMFApp() :
@@ -130,6 +220,11 @@ STATICFUNC(void) TraceExecutionTime(TraceStream* trace_time, clock_t clockStart)
 
 void TeXMFApp::Init(vector<char*>& args)
 {
+    // the statistics are written only if requested (--stats); but phase
+    // "session_init" starts here
+    pimpl->jobStatistics = make_unique<JobStatistics>();
+    pimpl->jobStatistics->BeginPhase("session_init");
+
     WebAppInputLine::Init(args);
 
     pimpl->trace_time = TraceStream::Open(MIKTEX_TRACE_TIME);
@@ -156,7 +251,19 @@ void TeXMFApp::Finalize()
         pimpl->trace_time->Close();
         pimpl->trace_time = nullptr;
     }
+    pimpl->outputWriter = nullptr;
+    pimpl->jobStatistics = nullptr;
+    pimpl->statsFileName = "";
+    pimpl->ReleaseMemoryDump();
+    // a single unmap releases all arena blocks
+    pimpl->memoryArena = nullptr;
     pimpl->memoryDumpFileName = "";
+    pimpl->profileFileName = "";
+    pimpl->profiler = nullptr;
+    pimpl->enablePreambleCheckpoint = false;
+    pimpl->checkpointWanted = false;
+    pimpl->checkpointLine = 0;
+    pimpl->checkpointTmpDumpFile = nullptr;
     pimpl->jobName = "";
     pimpl->features.Reset();
     pimpl->tcxFileName = "";
@@ -176,31 +283,196 @@ void TeXMFApp::OnTeXMFStartJob()
         }
     }
     session->PushBackAppName(appName);
+    // child processes are attributed to the job once its name is known
+    Process::SetAccountingJob(pimpl->jobName.empty() ? TheNameOfTheGame() : fmt::format("{0}:{1}", TheNameOfTheGame(), pimpl->GetUnquotedJobName()));
     pimpl->parseFirstLine = session->GetConfigValue(MIKTEX_CONFIG_SECTION_TEXANDFRIENDS, MIKTEX_CONFIG_VALUE_PARSE_FIRST_LINE, ConfigValue(AmI(TeXEngine))).GetBool();
     pimpl->showFileLineErrorMessages = session->GetConfigValue(MIKTEX_CONFIG_SECTION_TEXANDFRIENDS, MIKTEX_CONFIG_VALUE_CSTYLEERRORS).GetBool();
     pimpl->clockStart = clock();
+    if (!pimpl->profileFileName.Empty())
+    {
+        pimpl->profiler = make_unique<SamplingProfiler>();
+        pimpl->profiler->Start(PROFILE_SAMPLE_INTERVAL);
+    }
+    if (pimpl->jobStatistics != nullptr)
+    {
+        pimpl->jobStatistics->BeginPhase("typesetting");
+    }
 }
 
-void TeXMFApp::OnTeXMFFinishJob()
+void TeXMFApp::OnTeXMFCloseFiles()
 {
-    if (pimpl->recordFileNames)
+    if (pimpl->jobStatistics != nullptr)
+    {
+        pimpl->jobStatistics->BeginPhase("output_finish");
+    }
+}
+
+inline double ToSeconds(chrono::nanoseconds d)
+{
+    return chrono::duration_cast<chrono::duration<double>>(d).count();
+}
+
+STATICFUNC(void) WriteJobStatistics(const PathName& path, const string& programName, const string& jobName, const JobStatistics& jobStatistics, ITeXMFMemoryHandler* memoryHandler, shared_ptr<Session> session)
+{
+    nlohmann::json stats;
+    stats["program"] = programName;
+    stats["job"] = jobName;
+    nlohmann::json phases = nlohmann::json::array();
+    chrono::nanoseconds totalWallTime(0);
+    chrono::nanoseconds totalCpuTime(0);
+    for (const JobStatistics::Phase& phase : jobStatistics.GetPhases())
+    {
+        phases.push_back({ { "name", phase.name }, { "wall", ToSeconds(phase.wallTime) }, { "cpu", ToSeconds(phase.cpuTime) } });
+        totalWallTime += phase.wallTime;
+        totalCpuTime += phase.cpuTime;
+    }
+    stats["phases"] = phases;
+    stats["total"] = { { "wall", ToSeconds(totalWallTime) }, { "cpu", ToSeconds(totalCpuTime) } };
+    // the memory arrays have been freed, but the counters are still valid
+    for (const MemoryUsage& usage : memoryHandler->GetMemoryUsage())
     {
-        string fileName;
-        if (pimpl->jobName.length() > 2 && pimpl->jobName.front() == '"' && pimpl->jobName.back() == '"')
+        stats["memory"][usage.arrayName] = { { "used", usage.used }, { "size", usage.size } };
+    }
+    stats["memory"]["resident"] = { { "peak", JobStatistics::GetPeakResidentSetSize() } };
+    LocateStatistics locateStatistics = session->GetLocateStatistics();
+    stats["findFile"] = { { "calls", locateStatistics.count }, { "time", ToSeconds(locateStatistics.duration) } };
+    // the sizes of the files, as they are now
+    set<string> filesRead;
+    set<string> filesWritten;
+    for (const FileInfoRecord& record : session->GetFileInfoRecords())
+    {
+        if (record.access == FileAccess::Read || record.access == FileAccess::ReadWrite)
         {
-            fileName = pimpl->jobName.substr(1, pimpl->jobName.length() - 2);
+            filesRead.insert(record.fileName);
         }
-        else
+        if (record.access == FileAccess::Write || record.access == FileAccess::ReadWrite)
         {
-            fileName = pimpl->jobName;
+            filesWritten.insert(record.fileName);
         }
+    }
+    for (const auto& files : { make_pair("read", &filesRead), make_pair("written", &filesWritten) })
+    {
+        size_t bytes = 0;
+        for (const string& fileName : *files.second)
+        {
+            PathName fileNamePath(fileName);
+            if (File::Exists(fileNamePath))
+            {
+                bytes += File::GetSize(fileNamePath);
+            }
+        }
+        stats["files"][files.first] = { { "count", files.second->size() }, { "bytes", bytes } };
+    }
+    // where the time went when searching and opening files
+    struct SourceSummary
+    {
+        size_t count = 0;
+        chrono::steady_clock::duration lookupTime = chrono::steady_clock::duration::zero();
+    };
+    struct PackageSummary
+    {
+        size_t files = 0;
+        chrono::steady_clock::duration lookupTime = chrono::steady_clock::duration::zero();
+        chrono::steady_clock::duration openTime = chrono::steady_clock::duration::zero();
+    };
+    SourceSummary fndbSummary;
+    SourceSummary fileSystemSummary;
+    chrono::steady_clock::duration openTime = chrono::steady_clock::duration::zero();
+    size_t bytesRead = 0;
+    size_t bytesWritten = 0;
+    map<string, PackageSummary> packages;
+    vector<FileInfoRecord> records = session->GetFileInfoRecords();
+    for (const FileInfoRecord& record : records)
+    {
+        if (record.lookupSource == FileLookupSource::Fndb)
+        {
+            fndbSummary.count += 1;
+            fndbSummary.lookupTime += record.lookupTime;
+        }
+        else if (record.lookupSource == FileLookupSource::FileSystem)
+        {
+            fileSystemSummary.count += 1;
+            fileSystemSummary.lookupTime += record.lookupTime;
+        }
+        openTime += record.openTime;
+        bytesRead += record.bytesRead;
+        bytesWritten += record.bytesWritten;
+        if (!record.packageName.empty())
+        {
+            PackageSummary& package = packages[record.packageName];
+            package.files += 1;
+            package.lookupTime += record.lookupTime;
+            package.openTime += record.openTime;
+        }
+    }
+    stats["fileAccess"] = {
+        { "fndb", { { "count", fndbSummary.count }, { "time", ToSeconds(fndbSummary.lookupTime) } } },
+        { "fileSystem", { { "count", fileSystemSummary.count }, { "time", ToSeconds(fileSystemSummary.lookupTime) } } },
+        { "misses", { { "count", locateStatistics.misses }, { "time", ToSeconds(locateStatistics.missDuration) } } },
+        { "installations", { { "count", locateStatistics.installations }, { "time", ToSeconds(locateStatistics.installationDuration) } } },
+        { "open", ToSeconds(openTime) },
+        { "bytesRead", bytesRead },
+        { "bytesWritten", bytesWritten }
+    };
+    const size_t maxSlowest = 10;
+    sort(records.begin(), records.end(), [](const FileInfoRecord& a, const FileInfoRecord& b)
+    {
+        return a.lookupTime + a.openTime > b.lookupTime + b.openTime;
+    });
+    nlohmann::json slowest = nlohmann::json::array();
+    for (size_t idx = 0; idx < records.size() && idx < maxSlowest; ++idx)
+    {
+        const FileInfoRecord& record = records[idx];
+        slowest.push_back({ { "file", record.fileName }, { "package", record.packageName }, { "lookup", ToSeconds(record.lookupTime) }, { "open", ToSeconds(record.openTime) } });
+    }
+    stats["fileAccess"]["slowest"] = slowest;
+    // child processes (METAFONT, makepk, shell escape, ...)
+    nlohmann::json childProcesses = nlohmann::json::array();
+    chrono::nanoseconds childWallTime(0);
+    chrono::nanoseconds childCpuTime(0);
+    for (const ChildProcessRecord& record : Process::GetChildProcessRecords())
+    {
+        nlohmann::json child = { { "command", record.commandLine }, { "job", record.job }, { "pid", record.systemId }, { "wall", ToSeconds(record.wallTime) }, { "cpu", ToSeconds(record.cpuTime) } };
+        if (record.exitStatus == ProcessExitStatus::Exited)
+        {
+            child["exitCode"] = record.exitCode;
+        }
+        childProcesses.push_back(child);
+        childWallTime += record.wallTime;
+        childCpuTime += record.cpuTime;
+    }
+    stats["childProcesses"] = { { "count", childProcesses.size() }, { "wall", ToSeconds(childWallTime) }, { "cpu", ToSeconds(childCpuTime) }, { "processes", childProcesses } };
+    for (const auto& package : packages)
+    {
+        stats["packages"][package.first] = { { "files", package.second.files }, { "lookup", ToSeconds(package.second.lookupTime) }, { "open", ToSeconds(package.second.openTime) } };
+    }
+    ofstream stream = File::CreateOutputStream(path);
+    stream << stats.dump(2) << "\n";
+    stream.close();
+}
+
+void TeXMFApp::OnTeXMFFinishJob()
+{
+    if (pimpl->profiler != nullptr)
+    {
+        pimpl->profiler->Stop();
+        pimpl->profiler->Write(pimpl->profileFileName);
+        pimpl->profiler = nullptr;
+    }
+    if (pimpl->jobStatistics != nullptr && !pimpl->statsFileName.Empty())
+    {
+        pimpl->jobStatistics->EndPhase();
+        WriteJobStatistics(pimpl->statsFileName, TheNameOfTheGame(), pimpl->GetUnquotedJobName(), *pimpl->jobStatistics, GetTeXMFMemoryHandler(), GetSession());
+    }
+    if (pimpl->recordFileNames)
+    {
         shared_ptr<Session> session = GetSession();
         PathName recorderPath = GetAuxDirectory();
         if (recorderPath.Empty())
         {
             recorderPath = GetOutputDirectory();
         }
-        recorderPath /= fileName;
+        recorderPath /= pimpl->GetUnquotedJobName();
         recorderPath.AppendExtension(".fls");
         session->SetRecorderPath(recorderPath);
     }
@@ -235,9 +507,12 @@ enum {
     OPT_PARSE_FIRST_LINE,
     OPT_POOL_FREE,
     OPT_POOL_SIZE,
+    OPT_PREAMBLE_CHECKPOINT,
+    OPT_PROFILE,
     OPT_QUIET,
     OPT_RECORDER,
     OPT_STACK_SIZE,
+    OPT_STATS,
     OPT_STRICT,
     OPT_STRING_VACANCIES,
     OPT_TCX,
@@ -304,9 +579,16 @@ void TeXMFApp::AddOptions()
     }
 
     AddOption("pool-size", fmt::format(T_("Set {0} to N."), "pool_size"), FIRST_OPTION_VAL + pimpl->optBase + OPT_POOL_SIZE, POPT_ARG_STRING, "N");
+    if (AmI(TeXEngine))
+    {
+        AddOption("preamble-checkpoint", T_("Dump the state at the beginning of the document body and let subsequent runs continue from there."), FIRST_OPTION_VAL + pimpl->optBase + OPT_PREAMBLE_CHECKPOINT);
+        AddOption("profile", T_("Sample the input stack and write a flame graph profile (folded stacks) to FILE."), FIRST_OPTION_VAL + pimpl->optBase + OPT_PROFILE, POPT_ARG_STRING, "FILE");
+    }
+
     AddOption("quiet", T_("Suppress all output (except errors)."), FIRST_OPTION_VAL + pimpl->optBase + OPT_QUIET);
     AddOption("recorder", T_("Turn on the file name recorder to leave a trace of the files opened for input and output in a file with extension .fls."), FIRST_OPTION_VAL + pimpl->optBase + OPT_RECORDER);
     AddOption("stack-size", fmt::format(T_("Set {0} to N."), "stack_size"), FIRST_OPTION_VAL + pimpl->optBase + OPT_STACK_SIZE, POPT_ARG_STRING, "N");
+    AddOption("stats", T_("Write job statistics (time spent in each phase, memory usage, file searches, files read and written) as JSON to FILE."), FIRST_OPTION_VAL + pimpl->optBase + OPT_STATS, POPT_ARG_STRING, "FILE");
     AddOption("strict", T_("Disable MiKTeX extensions."), FIRST_OPTION_VAL + pimpl->optBase + OPT_STRICT, POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN);
 
     AddOption("string-vacancies", fmt::format(T_("Set {0} to N."), "string_vacancies"), FIRST_OPTION_VAL + pimpl->optBase + OPT_STRING_VACANCIES, POPT_ARG_STRING, "N");
@@ -540,6 +822,18 @@ bool TeXMFApp::ProcessOption(int opt, const string& optArg)
         pimpl->userParams["pool_size"] = std::stoi(optArg);
         break;
 
+    case OPT_PREAMBLE_CHECKPOINT:
+        pimpl->enablePreambleCheckpoint = true;
+        break;
+
+    case OPT_PROFILE:
+    {
+        PathName profileFileName(optArg);
+        profileFileName.MakeFullyQualified();
+        pimpl->profileFileName = profileFileName;
+    }
+    break;
+
     case OPT_QUIET:
         SetQuietFlag(true);
         break;
@@ -553,6 +847,17 @@ bool TeXMFApp::ProcessOption(int opt, const string& optArg)
         pimpl->userParams["stack_size"] = std::stoi(optArg);
         break;
 
+    case OPT_STATS:
+    {
+        PathName statsFileName(optArg);
+        statsFileName.MakeFullyQualified();
+        pimpl->statsFileName = statsFileName;
+        // the file access summary is taken from the file name recorder;
+        // package names are needed for the per-package breakdown
+        session->StartFileInfoRecorder(true);
+    }
+    break;
+
     case OPT_STRICT:
         pimpl->disableExtensions = true;
         session->EnableFontMaker(false);
@@ -658,6 +963,153 @@ void TeXMFApp::CheckFirstLine(const PathName& fileName)
     }
 }
 
+static bool IsGzipCompressed(const unsigned char* data, size_t size)
+{
+    return size >= 2 && data[0] == 0x1f && data[1] == 0x8b;
+}
+
+static vector<unsigned char> Uncompress(const unsigned char* data, size_t size)
+{
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    int ret = inflateInit2(&strm, 16 + MAX_WBITS);
+    if (ret != Z_OK)
+    {
+        MIKTEX_FATAL_ERROR_2("GZ decoder initialization did not succeed.", "ret", std::to_string(ret));
+    }
+    vector<unsigned char> result(size * 4);
+    strm.next_in = const_cast<unsigned char*>(data);
+    strm.avail_in = static_cast<uInt>(size);
+    do
+    {
+        if (strm.total_out == result.size())
+        {
+            result.resize(result.size() * 2);
+        }
+        strm.next_out = result.data() + strm.total_out;
+        strm.avail_out = static_cast<uInt>(result.size() - strm.total_out);
+        ret = inflate(&strm, Z_NO_FLUSH);
+    } while (ret == Z_OK);
+    size_t uncompressedSize = strm.total_out;
+    inflateEnd(&strm);
+    if (ret != Z_STREAM_END)
+    {
+        MIKTEX_FATAL_ERROR_2("GZ decoder did not succeed.", "ret", std::to_string(ret));
+    }
+    result.resize(uncompressedSize);
+    return result;
+}
+
+// checks a dependency line ("DIGEST PATH")
+static bool DependencyUnchanged(const string& line)
+{
+    size_t pos = line.find(' ');
+    if (pos == string::npos)
+    {
+        return false;
+    }
+    PathName path(line.substr(pos + 1));
+    return File::Exists(path) && MD5::FromFile(path) == MD5::Parse(line.substr(0, pos));
+}
+
+// checks whether the files recorded while making the dump file are
+// unchanged
+static bool DependenciesUnchanged(const PathName& dumpFile)
+{
+    PathName depsFile(dumpFile);
+    depsFile.AppendExtension(MIKTEX_DEPENDENCIES_FILE_SUFFIX);
+    if (!File::Exists(depsFile))
+    {
+        return false;
+    }
+    try
+    {
+        ifstream reader = File::CreateInputStream(depsFile);
+        bool haveDependencies = false;
+        for (string line; std::getline(reader, line); )
+        {
+            if (!DependencyUnchanged(line))
+            {
+                return false;
+            }
+            haveDependencies = true;
+        }
+        return haveDependencies;
+    }
+    catch (const MiKTeXException&)
+    {
+        return false;
+    }
+}
+
+// the digest of the lines before the checkpoint line
+static MD5 GetPreambleDigest(const PathName& inputFile, int checkpointLine)
+{
+    StreamReader reader(inputFile);
+    MD5Builder md5Builder;
+    string line;
+    for (int lineNumber = 1; lineNumber < checkpointLine && reader.ReadLine(line); ++lineNumber)
+    {
+        md5Builder.Update(line.c_str(), line.length());
+        md5Builder.Update("\n", 1);
+    }
+    reader.Close();
+    return md5Builder.Final();
+}
+
+/*
+ * The checkpoint record lists the number of the checkpoint line, the digest
+ * of the preamble and the files read before the checkpoint was taken:
+ *
+ *   LINENUMBER
+ *   DIGEST INPUTFILE
+ *   DIGEST PATH
+ *   ...
+ */
+
+// checks whether the preamble checkpoint can be restored
+static bool PreambleCheckpointUnchanged(const PathName& recordFile, const PathName& inputFile, int& checkpointLine)
+{
+    if (!File::Exists(recordFile))
+    {
+        return false;
+    }
+    try
+    {
+        ifstream reader = File::CreateInputStream(recordFile);
+        string line;
+        if (!std::getline(reader, line))
+        {
+            return false;
+        }
+        int lineNumber = std::stoi(line);
+        if (lineNumber <= 1 || !std::getline(reader, line))
+        {
+            return false;
+        }
+        size_t pos = line.find(' ');
+        if (pos == string::npos
+            || PathName(line.substr(pos + 1)) != inputFile
+            || GetPreambleDigest(inputFile, lineNumber) != MD5::Parse(line.substr(0, pos)))
+        {
+            return false;
+        }
+        while (std::getline(reader, line))
+        {
+            if (!DependencyUnchanged(line))
+            {
+                return false;
+            }
+        }
+        checkpointLine = lineNumber;
+        return true;
+    }
+    catch (const exception&)
+    {
+        return false;
+    }
+}
+
 bool TeXMFApp::OpenMemoryDumpFile(const PathName& fileName_, FILE** ppFile, void* pBuf, size_t size, bool renew)
 {
     MIKTEX_ASSERT(ppFile != nullptr);
@@ -678,11 +1130,24 @@ bool TeXMFApp::OpenMemoryDumpFile(const PathName& fileName_, FILE** ppFile, void
 
     PathName path;
 
+    if (pimpl->jobStatistics != nullptr)
+    {
+        pimpl->jobStatistics->BeginPhase("format_load");
+    }
+
     string dumpName = fileName.GetFileNameWithoutExtension().ToString();
 #if 0
     PathName::Convert(szDumpName, szDumpName, ConvertPathNameOption::MakeLower);
 #endif
 
+    bool isPreambleCheckpoint = pimpl->checkpointLine > 0;
+
+    if (isPreambleCheckpoint)
+    {
+        // undump the preamble checkpoint instead
+        path = pimpl->checkpointDumpFile;
+    }
+
     Session::FindFileOptionSet findFileOptions;
 
     findFileOptions += Session::FindFileOption::Create;
@@ -692,13 +1157,13 @@ bool TeXMFApp::OpenMemoryDumpFile(const PathName& fileName_, FILE** ppFile, void
         findFileOptions += Session::FindFileOption::Renew;
     }
 
-    if (!session->FindFile(fileName.ToString(), GetMemoryDumpFileType(), findFileOptions, path))
+    if (path.Empty() && !session->FindFile(fileName.ToString(), GetMemoryDumpFileType(), findFileOptions, path))
     {
         MIKTEX_FATAL_ERROR_2(T_("The memory dump file could not be found."), "fileName", fileName.ToString());
     }
 
 #if 1
-    if (!renew)
+    if (!renew && !isPreambleCheckpoint)
     {
         time_t modificationTime = File::GetLastWriteTime(path);
         time_t lastAdminMaintenance = session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_LAST_ADMIN_MAINTENANCE, ConfigValue("0")).GetTimeT();
@@ -708,6 +1173,24 @@ bool TeXMFApp::OpenMemoryDumpFile(const PathName& fileName_, FILE** ppFile, void
             time_t lastUserMaintenance = session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE, MIKTEX_CONFIG_VALUE_LAST_USER_MAINTENANCE, ConfigValue("0")).GetTimeT();
             renew = lastUserMaintenance > modificationTime;
         }
+        if (renew && DependenciesUnchanged(path))
+        {
+            // the maintenance didn't touch any of the input files
+            renew = false;
+            try
+            {
+                time_t creationTime;
+                time_t lastAccessTime;
+                time_t lastWriteTime;
+                File::GetTimes(path, creationTime, lastAccessTime, lastWriteTime);
+                time_t now = time(nullptr);
+                File::SetTimes(path, creationTime, now, now);
+            }
+            catch (const MiKTeXException&)
+            {
+                // the dependencies will be checked again next time
+            }
+        }
         if (renew)
         {
             // RECURSION
@@ -718,11 +1201,59 @@ bool TeXMFApp::OpenMemoryDumpFile(const PathName& fileName_, FILE** ppFile, void
 
     FileStream stream(session->OpenFile(path, FileMode::Open, FileAccess::Read, false));
 
+    // undump from a read-only mapping: pages are faulted in on demand and
+    // are shared with concurrent engine processes
+    pimpl->ReleaseMemoryDump();
+    try
+    {
+        unique_ptr<MemoryMappedFile> mapping(MemoryMappedFile::Create());
+        const unsigned char* data = static_cast<const unsigned char*>(mapping->Open(path, false));
+        size_t dataSize = mapping->GetSize();
+        // the dump file is read from start to end
+        mapping->Advise(MemoryMappedFileAccessPattern::Sequential);
+        mapping->Prefetch(0, dataSize);
+        if (IsGzipCompressed(data, dataSize))
+        {
+            pimpl->memoryDumpBuffer = Uncompress(data, dataSize);
+            mapping = nullptr;
+            data = pimpl->memoryDumpBuffer.data();
+            dataSize = pimpl->memoryDumpBuffer.size();
+        }
+        pimpl->memoryDumpMapping = std::move(mapping);
+        pimpl->memoryDumpData = data;
+        pimpl->memoryDumpSize = dataSize;
+        pimpl->memoryDumpFile = stream.GetFile();
+    }
+    catch (const MiKTeXException&)
+    {
+        // the dump file is undumped in small pieces: let the C runtime
+        // read it in large chunks
+        const size_t MAX_DUMP_FILE_BUFFER_SIZE = 16 * 1024 * 1024;
+        size_t fileSize = static_cast<size_t>(File::GetSize(path));
+        size_t bufferSize = std::min(fileSize, MAX_DUMP_FILE_BUFFER_SIZE);
+        if (bufferSize > BUFSIZ)
+        {
+            setvbuf(stream.GetFile(), nullptr, _IOFBF, bufferSize);
+        }
+        // count the bytes, in order to know when everything has been
+        // undumped
+        pimpl->memoryDumpSize = fileSize;
+        pimpl->memoryDumpFile = stream.GetFile();
+    }
+
     if (pBuf != nullptr)
     {
-        if (stream.Read(pBuf, size) != size)
+        if (pimpl->memoryDumpData != nullptr)
         {
-            MIKTEX_UNEXPECTED();
+            ReadMemoryDumpFile(stream.GetFile(), pBuf, size);
+        }
+        else
+        {
+            if (stream.Read(pBuf, size) != size)
+            {
+                MIKTEX_UNEXPECTED();
+            }
+            pimpl->MemoryDumpRead(size);
         }
     }
 
@@ -733,6 +1264,28 @@ bool TeXMFApp::OpenMemoryDumpFile(const PathName& fileName_, FILE** ppFile, void
     return true;
 }
 
+void TeXMFApp::ReadMemoryDumpFile(FILE* file, void* data, size_t size)
+{
+    if (pimpl->memoryDumpData == nullptr || file != pimpl->memoryDumpFile)
+    {
+        if (fread(data, 1, size, file) != size)
+        {
+            MIKTEX_FATAL_CRT_ERROR("fread");
+        }
+        if (file == pimpl->memoryDumpFile)
+        {
+            pimpl->MemoryDumpRead(size);
+        }
+        return;
+    }
+    if (size > pimpl->memoryDumpSize - pimpl->memoryDumpPosition)
+    {
+        MIKTEX_FATAL_ERROR(T_("Bad format file."));
+    }
+    memcpy(data, pimpl->memoryDumpData + pimpl->memoryDumpPosition, size);
+    pimpl->MemoryDumpRead(size);
+}
+
 void TeXMFApp::ProcessCommandLineOptions()
 {
     if (StringUtil::Contains(GetInitProgramName().c_str(), Utils::GetExeName().c_str()))
@@ -864,6 +1417,23 @@ void TeXMFApp::InitializeBuffer() const
         {
             fileNameArgIdx = 2;
         }
+        if (fileNameArgIdx >= 0 && pimpl->enablePreambleCheckpoint && !IsInitProgram() && strcmp(argv[argc - 1], "\\dump") != 0)
+        {
+            // the checkpoint depends on the engine, the format and the
+            // main input file
+            PathName inputFile(path);
+            inputFile.MakeFullyQualified();
+            string key = Utils::GetExeName() + "\n" + GetDefaultMemoryDumpFileName().ToString() + "\n" + inputFile.ToString();
+            for (int idx = 1; idx < argc; ++idx)
+            {
+                key += "\n";
+                key += argv[idx];
+            }
+            if (pimpl->PreparePreambleCheckpoint(session, inputFile, MD5::FromChars(key).ToString(), GetMemoryDumpFileExtension()))
+            {
+                LogInfo(fmt::format("restoring preamble checkpoint {0} (line {1})", Q_(pimpl->checkpointDumpFile), pimpl->checkpointLine));
+            }
+        }
         if (fileNameArgIdx >= 0)
         {
 #if defined(MIKTEX_WINDOWS)
@@ -984,20 +1554,47 @@ void TeXMFApp::SetTcxFileName(const PathName& tcxFileName)
     pimpl->tcxFileName = tcxFileName;
 }
 
-void TeXMFApp::InitializeCharTables() const
+/*
+ * A compiled TCX file holds, for each of the three character tables, the
+ * entries which are set by the TCX file:
+ *
+ *   signature version tcxPath size lastWriteTime
+ *   { isSet[256] value[256] } * 3
+ *
+ * Numbers are stored as 32-bit words (64-bit for sizes and times), strings
+ * are prefixed by their length.
+ */
+
+const uint32_t COMPILED_TCX_SIGNATURE = 0x5843544d; // 'MTCX' (the x86 way)
+const uint32_t COMPILED_TCX_VERSION = 1;
+
+// a file modified within this many seconds before it was compiled could be
+// modified again without changing its size and modification time
+const time_t TIMESTAMP_RESOLUTION_SECONDS = 2;
+
+namespace
 {
-    PathName tcxPath;
-    shared_ptr<Session> session = GetSession();
-    if (!session->FindFile(GetTcxFileName().ToString(), FileType::TCX, tcxPath))
+    enum { TCX_XORD, TCX_XCHR, TCX_XPRN, TCX_NUM_TABLES };
+
+    struct CompiledTcx
     {
-        return;
-    }
+        unsigned char isSet[TCX_NUM_TABLES][256] = {};
+        unsigned char value[TCX_NUM_TABLES][256] = {};
+
+        void Set(int table, long idx, long value)
+        {
+            isSet[table][idx] = 1;
+            this->value[table][idx] = static_cast<unsigned char>(value);
+        }
+    };
+}
+
+STATICFUNC(void) CompileTcx(const PathName& tcxPath, CompiledTcx& compiledTcx)
+{
     StreamReader reader(tcxPath);
     string line;
-    int lineNumber = 0;
     while (reader.ReadLine(line))
     {
-        ++lineNumber;
         const char* start;
         char* end;
         if (line.empty() || line[0] == '%')
@@ -1005,10 +1602,6 @@ void TeXMFApp::InitializeCharTables() const
             continue;
         }
         start = line.c_str();
-        if (start == nullptr)
-        {
-            MIKTEX_FATAL_ERROR_2("Invalid tcx file.", "tcxPath", tcxPath.ToString());
-        }
         long xordidx = strtol(start, &end, 0);
         if (start == end)
         {
@@ -1046,18 +1639,151 @@ void TeXMFApp::InitializeCharTables() const
         {
             printable = 1;
         }
-        GetCharacterConverter()->xord()[xordidx] = static_cast<unsigned char>(xchridx);
-        if (AmI(TeXjpEngine))
+        compiledTcx.Set(TCX_XORD, xordidx, xchridx);
+        compiledTcx.Set(TCX_XCHR, xchridx, xordidx);
+        compiledTcx.Set(TCX_XPRN, xchridx, printable);
+    }
+    reader.Close();
+}
+
+STATICFUNC(PathName) GetCompiledTcxPath(shared_ptr<Session> session, const PathName& tcxPath)
+{
+    return session->GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_MIKTEX_CACHE_DIR) / PathName("tcx") / PathName(MD5::FromChars(tcxPath.ToString()).ToString() + ".tcx.bin");
+}
+
+STATICFUNC(bool) ReadCompiledTcx(const PathName& compiledTcxPath, const PathName& tcxPath, CompiledTcx& compiledTcx)
+{
+    if (!File::Exists(compiledTcxPath))
+    {
+        return false;
+    }
+    try
+    {
+        vector<unsigned char> data = File::ReadAllBytes(compiledTcxPath);
+        size_t pos = 0;
+        auto read = [&data, &pos](void* buf, size_t n)
         {
-            GetCharacterConverter()->xchr16()[xchridx] = static_cast<unsigned short>(xordidx);
+            if (n > data.size() - pos)
+            {
+                MIKTEX_UNEXPECTED();
+            }
+            memcpy(buf, data.data() + pos, n);
+            pos += n;
+        };
+        uint32_t signature, version, length;
+        read(&signature, sizeof(signature));
+        read(&version, sizeof(version));
+        if (signature != COMPILED_TCX_SIGNATURE || version != COMPILED_TCX_VERSION)
+        {
+            return false;
         }
-        else
+        read(&length, sizeof(length));
+        string path(length, '\0');
+        read(&path[0], length);
+        uint64_t size, lastWriteTime;
+        read(&size, sizeof(size));
+        read(&lastWriteTime, sizeof(lastWriteTime));
+        if (path != tcxPath.ToString() || File::GetSize(tcxPath) != size || static_cast<uint64_t>(File::GetLastWriteTime(tcxPath)) != lastWriteTime)
+        {
+            return false;
+        }
+        read(compiledTcx.isSet, sizeof(compiledTcx.isSet));
+        read(compiledTcx.value, sizeof(compiledTcx.value));
+        if (pos != data.size())
         {
-            GetCharacterConverter()->xchr()[xchridx] = static_cast<unsigned char>(xordidx);
+            MIKTEX_UNEXPECTED();
+        }
+    }
+    catch (const MiKTeXException&)
+    {
+        // not fatal: the TCX file will be parsed again
+        return false;
+    }
+    return true;
+}
+
+STATICFUNC(void) WriteCompiledTcx(const PathName& compiledTcxPath, const PathName& tcxPath, const CompiledTcx& compiledTcx)
+{
+    try
+    {
+        time_t lastWriteTime = File::GetLastWriteTime(tcxPath);
+        if (lastWriteTime + TIMESTAMP_RESOLUTION_SECONDS >= time(nullptr))
+        {
+            // the TCX file might still be in the making
+            return;
+        }
+        string buf;
+        auto write = [&buf](const void* data, size_t n)
+        {
+            buf.append(reinterpret_cast<const char*>(data), n);
+        };
+        uint32_t word = COMPILED_TCX_SIGNATURE;
+        write(&word, sizeof(word));
+        word = COMPILED_TCX_VERSION;
+        write(&word, sizeof(word));
+        string path = tcxPath.ToString();
+        word = static_cast<uint32_t>(path.length());
+        write(&word, sizeof(word));
+        write(path.data(), path.length());
+        uint64_t word64 = static_cast<uint64_t>(File::GetSize(tcxPath));
+        write(&word64, sizeof(word64));
+        word64 = static_cast<uint64_t>(lastWriteTime);
+        write(&word64, sizeof(word64));
+        write(compiledTcx.isSet, sizeof(compiledTcx.isSet));
+        write(compiledTcx.value, sizeof(compiledTcx.value));
+        Directory::Create(compiledTcxPath.GetDirectoryName());
+        PathName tmpPath(compiledTcxPath);
+        tmpPath.AppendExtension(".tmp");
+        unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create(tmpPath);
+        File::WriteBytes(tmpPath, vector<unsigned char>(buf.begin(), buf.end()));
+        File::Move(tmpPath, compiledTcxPath, { FileMoveOption::ReplaceExisting });
+        tmpFile->Keep();
+    }
+    catch (const MiKTeXException&)
+    {
+        // not fatal: the TCX file will be parsed again
+    }
+}
+
+void TeXMFApp::InitializeCharTables() const
+{
+    PathName tcxPath;
+    shared_ptr<Session> session = GetSession();
+    if (!session->FindFile(GetTcxFileName().ToString(), FileType::TCX, tcxPath))
+    {
+        return;
+    }
+    CompiledTcx compiledTcx;
+    PathName compiledTcxPath = GetCompiledTcxPath(session, tcxPath);
+    if (!ReadCompiledTcx(compiledTcxPath, tcxPath, compiledTcx))
+    {
+        CompileTcx(tcxPath, compiledTcx);
+        WriteCompiledTcx(compiledTcxPath, tcxPath, compiledTcx);
+    }
+    ICharacterConverter* characterConverter = GetCharacterConverter();
+    bool isTeXjp = AmI(TeXjpEngine);
+    for (int idx = 0; idx < 256; ++idx)
+    {
+        if (compiledTcx.isSet[TCX_XORD][idx])
+        {
+            characterConverter->xord()[idx] = compiledTcx.value[TCX_XORD][idx];
+        }
+        if (compiledTcx.isSet[TCX_XCHR][idx])
+        {
+            if (isTeXjp)
+            {
+                characterConverter->xchr16()[idx] = compiledTcx.value[TCX_XCHR][idx];
+            }
+            else
+            {
+                characterConverter->xchr()[idx] = compiledTcx.value[TCX_XCHR][idx];
+            }
+        }
+        if (compiledTcx.isSet[TCX_XPRN][idx])
+        {
+            characterConverter->xprn()[idx] = compiledTcx.value[TCX_XPRN][idx];
         }
-        GetCharacterConverter()->xprn()[xchridx] = static_cast<unsigned char>(printable);
     }
-    reader.Close();
 }
 
 void TeXMFApp::SetStringHandler(IStringHandler* stringHandler)
@@ -1090,6 +1816,189 @@ ITeXMFMemoryHandler* TeXMFApp::GetTeXMFMemoryHandler() const
     return pimpl->memoryHandler;
 }
 
+bool TeXMFApp::IsProfileSampleRequested() const
+{
+    return pimpl->profiler != nullptr && pimpl->profiler->IsSampleRequested();
+}
+
+void TeXMFApp::BeginProfileSample()
+{
+    MIKTEX_ASSERT(pimpl->profiler != nullptr);
+    pimpl->profiler->BeginSample();
+}
+
+void TeXMFApp::AddProfileFrame(const string& frame)
+{
+    MIKTEX_ASSERT(pimpl->profiler != nullptr);
+    pimpl->profiler->AddFrame(frame);
+}
+
+void TeXMFApp::EndProfileSample()
+{
+    MIKTEX_ASSERT(pimpl->profiler != nullptr);
+    pimpl->profiler->EndSample();
+}
+
+bool TeXMFApp::impl::PreparePreambleCheckpoint(shared_ptr<Session> session, const PathName& inputFile, const string& key, const string& dumpFileExtension)
+{
+    PathName checkpointDir = session->GetSpecialPath(SpecialPath::DataRoot) / PathName(MIKTEX_PATH_MIKTEX_CACHE_DIR) / PathName("checkpoints");
+    checkpointInputFile = inputFile;
+    checkpointDumpFile = checkpointDir / PathName(key);
+    checkpointDumpFile.AppendExtension(dumpFileExtension);
+    checkpointRecordFile = checkpointDir / PathName(key);
+    checkpointRecordFile.AppendExtension(".checkpoint");
+    if (File::Exists(checkpointDumpFile) && PreambleCheckpointUnchanged(checkpointRecordFile, checkpointInputFile, checkpointLine))
+    {
+        return true;
+    }
+    // the files read before the checkpoint are taken from the file name
+    // recorder
+    session->StartFileInfoRecorder(false);
+    checkpointWanted = true;
+    return false;
+}
+
+bool TeXMFApp::IsPreambleCheckpointWanted() const
+{
+    return pimpl->checkpointWanted;
+}
+
+bool TeXMFApp::IsPreambleCheckpointLine(int start, int last) const
+{
+    IInputOutput* inputOutput = GetInputOutput();
+    size_t markerLength = strlen(PREAMBLE_CHECKPOINT_MARKER);
+    if (last - start < static_cast<int>(markerLength))
+    {
+        return false;
+    }
+    for (size_t idx = 0; idx < markerLength; ++idx)
+    {
+        char32_t ch = AmI("xetex") ? inputOutput->buffer32()[start + idx] : static_cast<unsigned char>(inputOutput->buffer()[start + idx]);
+        if (ch != static_cast<unsigned char>(PREAMBLE_CHECKPOINT_MARKER[idx]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+FILE* TeXMFApp::OpenPreambleCheckpointFile()
+{
+    MIKTEX_ASSERT(pimpl->checkpointWanted);
+    PathName path(pimpl->checkpointDumpFile);
+    path.AppendExtension(".tmp");
+    Directory::Create(path.GetDirectoryName());
+    pimpl->checkpointTmpDumpFile = TemporaryFile::Create(path);
+    FILE* file = GetSession()->OpenFile(path, FileMode::Create, FileAccess::Write, false);
+    SetNameOfFile(path);
+    return file;
+}
+
+void TeXMFApp::FinishPreambleCheckpoint(int lineNumber)
+{
+    MIKTEX_ASSERT(pimpl->checkpointWanted);
+    pimpl->checkpointWanted = false;
+    shared_ptr<Session> session = GetSession();
+    // the dump file has been closed by store_fmt_file
+    unique_ptr<TemporaryFile> tmpDump = std::move(pimpl->checkpointTmpDumpFile);
+    try
+    {
+        PathName tmpRecordFile(pimpl->checkpointRecordFile);
+        tmpRecordFile.AppendExtension(".tmp");
+        unique_ptr<TemporaryFile> tmpRecord = TemporaryFile::Create(tmpRecordFile);
+        ofstream writer = File::CreateOutputStream(tmpRecordFile);
+        writer << lineNumber << "\n";
+        writer << GetPreambleDigest(pimpl->checkpointInputFile, lineNumber).ToString() << " " << pimpl->checkpointInputFile.ToString() << "\n";
+        set<string> dependencies;
+        for (const FileInfoRecord& fir : session->GetFileInfoRecords())
+        {
+            if (fir.access != FileAccess::Read)
+            {
+                continue;
+            }
+            PathName path(fir.fileName);
+            path.MakeFullyQualified();
+            if (path == pimpl->checkpointInputFile || !File::Exists(path) || !dependencies.insert(path.ToString()).second)
+            {
+                continue;
+            }
+            writer << MD5::FromFile(path).ToString() << " " << path.ToString() << "\n";
+        }
+        writer.close();
+        File::Move(tmpDump->GetPathName(), pimpl->checkpointDumpFile, { FileMoveOption::ReplaceExisting });
+        tmpDump->Keep();
+        File::Move(tmpRecordFile, pimpl->checkpointRecordFile, { FileMoveOption::ReplaceExisting });
+        tmpRecord->Keep();
+        LogInfo(fmt::format("preamble checkpoint {0} has been written (line {1})", Q_(pimpl->checkpointDumpFile), lineNumber));
+    }
+    catch (const MiKTeXException& e)
+    {
+        // not fatal: the preamble will be processed again
+        LogError(fmt::format("preamble checkpoint {0} could not be written: {1}", Q_(pimpl->checkpointDumpFile), e.GetErrorMessage()));
+    }
+}
+
+int TeXMFApp::GetPreambleCheckpointLine() const
+{
+    return pimpl->checkpointLine;
+}
+
+void TeXMFApp::SetPreambleCheckpointRestored()
+{
+    pimpl->checkpointLine = 0;
+}
+
+void TeXMFApp::WriteOutputFile(FILE* file, const void* data, size_t size)
+{
+    if (pimpl->outputWriter != nullptr && pimpl->outputWriter->GetFile() != file)
+    {
+        FlushOutputFile(pimpl->outputWriter->GetFile());
+    }
+    if (pimpl->outputWriter == nullptr)
+    {
+        unique_ptr<OutputWriter> outputWriter = make_unique<OutputWriter>();
+        outputWriter->Start(file);
+        pimpl->outputWriter = std::move(outputWriter);
+    }
+    pimpl->outputWriter->Write(data, size);
+}
+
+void TeXMFApp::FlushOutputFile(FILE* file)
+{
+    if (pimpl->outputWriter == nullptr || pimpl->outputWriter->GetFile() != file)
+    {
+        return;
+    }
+    unique_ptr<OutputWriter> outputWriter = std::move(pimpl->outputWriter);
+    outputWriter->Finish();
+}
+
+bool TeXMFApp::CreateMemoryArena(bool useExplicitHugePages)
+{
+    if (pimpl->memoryArena != nullptr)
+    {
+        return true;
+    }
+    unique_ptr<MemoryArena> memoryArena = make_unique<MemoryArena>();
+    if (!memoryArena->Create(useExplicitHugePages))
+    {
+        return false;
+    }
+    pimpl->memoryArena = std::move(memoryArena);
+    return true;
+}
+
+bool TeXMFApp::IsMemoryArenaPointer(const void* ptr) const
+{
+    return pimpl->memoryArena != nullptr && pimpl->memoryArena->Contains(ptr);
+}
+
+void* TeXMFApp::ReallocateArenaMemory(void* ptr, size_t size)
+{
+    MIKTEX_ASSERT(pimpl->memoryArena != nullptr);
+    return pimpl->memoryArena->Reallocate(ptr, size);
+}
+
 TeXMFApp::UserParams& TeXMFApp::GetUserParams() const
 {
     return pimpl->userParams;
@@ -1127,6 +2036,21 @@ int TeXMFApp::MakeTeXString(const char* lpsz) const
 {
     MIKTEX_ASSERT_STRING(lpsz);
     IStringHandler* stringHandler = GetStringHandler();
+    // file names and job names are made over and over again: reuse the
+    // pool string, if it still holds the same text (METAFONT counts string
+    // references, thus its strings are not shared)
+    bool reuse = AmI(TeXEngine);
+    if (reuse)
+    {
+        auto it = pimpl->texStrings.find(lpsz);
+        if (it != pimpl->texStrings.end()
+            && it->second >= (AmI("xetex") ? 65536 : 0)
+            && it->second < stringHandler->strptr()
+            && GetTeXString(it->second) == lpsz)
+        {
+            return it->second;
+        }
+    }
     std::size_t len;
     if (AmI("xetex"))
     {
@@ -1151,7 +2075,12 @@ int TeXMFApp::MakeTeXString(const char* lpsz) const
         memcpy(stringHandler->strpool() + stringHandler->poolptr(), lpsz, len * sizeof(char));
     }
     stringHandler->poolptr() += static_cast<C4P::C4P_signed32>(len);
-    return stringHandler->makestring();
+    int stringNumber = stringHandler->makestring();
+    if (reuse)
+    {
+        pimpl->texStrings[lpsz] = stringNumber;
+    }
+    return stringNumber;
 }
 
 int TeXMFApp::GetJobName(int fallbackJobName) const
@@ -1162,6 +2091,7 @@ int TeXMFApp::GetJobName(int fallbackJobName) const
         {
             pimpl->jobName = GetTeXString(fallbackJobName);
             MIKTEX_EXPECT(pimpl->jobName.find(' ') == string::npos);
+            Process::SetAccountingJob(fmt::format("{0}:{1}", TheNameOfTheGame(), pimpl->GetUnquotedJobName()));
             return fallbackJobName;
         }
         PathName name = GetLastInputFileName().GetFileNameWithoutExtension();
@@ -1173,8 +2103,8 @@ int TeXMFApp::GetJobName(int fallbackJobName) const
         {
             pimpl->jobName = Quoter<char>(name).GetData();
         }
+        Process::SetAccountingJob(fmt::format("{0}:{1}", TheNameOfTheGame(), pimpl->GetUnquotedJobName()));
     }
-    // FIXME: conserve strpool space
     return MakeTeXString(pimpl->jobName.c_str());
 }
 
@@ -1249,6 +2179,8 @@ bool TeXMFApp::OpenFontFile(C4P::BufferedFile<unsigned char>* file, const string
         }
     }
     file->Attach(session->OpenFile(pathFont, FileMode::Open, FileAccess::Read, false), true);
+    // font files are small and are read element by element
+    file->LoadIntoMemory();
     file->Read();
     return true;
 }
@@ -0,0 +1,284 @@
+/* EventRecorder.cpp: binary event recording
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX Trace Library.
+
+   The MiKTeX Trace Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+   
+   The MiKTeX Trace Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Trace Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#if defined(MIKTEX_TRACE_SHARED)
+#  define MIKTEXTRACEEXPORT MIKTEXDLLEXPORT
+#else
+#  define MIKTEXTRACEEXPORT
+#endif
+
+#if defined(MIKTEX_WINDOWS)
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <cstdlib>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <miktex/Util/StringUtil>
+
+#define DE9EF9059C8744B48A68345CD5A8A2C8
+#include <miktex/Trace/EventRecorder.h>
+
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+using namespace std;
+
+namespace
+{
+  enum class EventType : uint8_t
+  {
+    Begin,
+    End,
+    Counter
+  };
+
+  struct Event
+  {
+    uint64_t ns;
+    const char* name;
+    int64_t value;
+    EventType type;
+  };
+
+  // events of one thread; only the owning thread writes, the oldest
+  // events are overwritten when the buffer is full
+  struct ThreadBuffer
+  {
+    ThreadBuffer(unsigned threadId) :
+      threadId(threadId),
+      events(capacity)
+    {
+    }
+    static constexpr size_t capacity = 32768;
+    unsigned threadId;
+    vector<Event> events;
+    atomic<uint64_t> count{ 0 };
+  };
+
+  class Recorder
+  {
+  public:
+    Recorder()
+    {
+#if defined(MIKTEX_WINDOWS)
+      const wchar_t* value = _wgetenv(StringUtil::UTF8ToWideChar(MIKTEX_ENV_TRACE_EVENTS).c_str());
+      if (value != nullptr)
+      {
+        fileName = StringUtil::WideCharToUTF8(value);
+      }
+#else
+      const char* value = getenv(MIKTEX_ENV_TRACE_EVENTS);
+      if (value != nullptr)
+      {
+        fileName = value;
+      }
+#endif
+      enabled = !fileName.empty();
+    }
+
+  public:
+    ~Recorder()
+    {
+      try
+      {
+        Flush();
+      }
+      catch (const exception&)
+      {
+      }
+    }
+
+  public:
+    void Record(EventType type, const char* name, int64_t value)
+    {
+      thread_local ThreadBuffer* threadBuffer = nullptr;
+      if (threadBuffer == nullptr)
+      {
+        threadBuffer = AddThreadBuffer();
+      }
+      uint64_t count = threadBuffer->count.load(memory_order_relaxed);
+      Event& event = threadBuffer->events[count % ThreadBuffer::capacity];
+      event.ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+      event.name = name;
+      event.value = value;
+      event.type = type;
+      threadBuffer->count.store(count + 1, memory_order_release);
+    }
+
+  public:
+    void Flush();
+
+  private:
+    ThreadBuffer* AddThreadBuffer()
+    {
+      lock_guard<mutex> lockGuard(threadBuffersMutex);
+      // the buffers outlive their threads
+      threadBuffers.push_back(make_unique<ThreadBuffer>(static_cast<unsigned>(threadBuffers.size() + 1)));
+      return threadBuffers.back().get();
+    }
+
+  public:
+    bool enabled = false;
+
+  private:
+    string fileName;
+
+  private:
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  private:
+    mutex threadBuffersMutex;
+
+  private:
+    vector<unique_ptr<ThreadBuffer>> threadBuffers;
+  };
+
+  Recorder& TheRecorder()
+  {
+    static Recorder recorder;
+    return recorder;
+  }
+
+  unsigned long GetProcessId()
+  {
+#if defined(MIKTEX_WINDOWS)
+    return GetCurrentProcessId();
+#else
+    return static_cast<unsigned long>(getpid());
+#endif
+  }
+
+  string JsonEscape(const char* s)
+  {
+    string result;
+    for (; *s != 0; ++s)
+    {
+      if (*s == '"' || *s == '\\')
+      {
+        result += '\\';
+      }
+      result += *s;
+    }
+    return result;
+  }
+}
+
+void Recorder::Flush()
+{
+  if (!enabled)
+  {
+    return;
+  }
+  unsigned long pid = GetProcessId();
+  string path = fileName;
+  for (size_t pos = path.find("%p"); pos != string::npos; pos = path.find("%p", pos))
+  {
+    string pidString = std::to_string(pid);
+    path.replace(pos, 2, pidString);
+    pos += pidString.length();
+  }
+#if defined(MIKTEX_WINDOWS)
+  ofstream stream(StringUtil::UTF8ToWideChar(path), ios_base::binary);
+#else
+  ofstream stream(path, ios_base::binary);
+#endif
+  if (!stream.is_open())
+  {
+    return;
+  }
+  // Chrome trace event format: timestamps are in microseconds
+  stream << "{\"traceEvents\":[\n";
+  const char* separator = "";
+  lock_guard<mutex> lockGuard(threadBuffersMutex);
+  for (const unique_ptr<ThreadBuffer>& threadBuffer : threadBuffers)
+  {
+    uint64_t count = threadBuffer->count.load(memory_order_acquire);
+    uint64_t first = count > ThreadBuffer::capacity ? count - ThreadBuffer::capacity : 0;
+    for (uint64_t idx = first; idx < count; ++idx)
+    {
+      const Event& event = threadBuffer->events[idx % ThreadBuffer::capacity];
+      string ts = fmt::format("{:.3f}", event.ns / 1000.0);
+      switch (event.type)
+      {
+      case EventType::Begin:
+        stream << separator << fmt::format(R"({{"name":"{}","ph":"B","ts":{},"pid":{},"tid":{}}})", JsonEscape(event.name), ts, pid, threadBuffer->threadId);
+        break;
+      case EventType::End:
+        stream << separator << fmt::format(R"({{"name":"{}","ph":"E","ts":{},"pid":{},"tid":{}}})", JsonEscape(event.name), ts, pid, threadBuffer->threadId);
+        break;
+      case EventType::Counter:
+        stream << separator << fmt::format(R"({{"name":"{}","ph":"C","ts":{},"pid":{},"tid":{},"args":{{"value":{}}}}})", JsonEscape(event.name), ts, pid, threadBuffer->threadId, event.value);
+        break;
+      }
+      separator = ",\n";
+    }
+  }
+  stream << "\n]}\n";
+  stream.close();
+}
+
+bool EventRecorder::IsEnabled()
+{
+  return TheRecorder().enabled;
+}
+
+void EventRecorder::Begin(const char* name)
+{
+  Recorder& recorder = TheRecorder();
+  if (recorder.enabled)
+  {
+    recorder.Record(EventType::Begin, name, 0);
+  }
+}
+
+void EventRecorder::End(const char* name)
+{
+  Recorder& recorder = TheRecorder();
+  if (recorder.enabled)
+  {
+    recorder.Record(EventType::End, name, 0);
+  }
+}
+
+void EventRecorder::Counter(const char* name, int64_t value)
+{
+  Recorder& recorder = TheRecorder();
+  if (recorder.enabled)
+  {
+    recorder.Record(EventType::Counter, name, value);
+  }
+}
+
+void EventRecorder::Flush()
+{
+  TheRecorder().Flush();
+}
@@ -111,5 +111,10 @@ unique_ptr<StopWatch> StopWatch::Start()
 
 unique_ptr<StopWatch> StopWatch::Start(TraceStream* traceStream, const string& facility, const string& message)
 {
+  if (traceStream == nullptr || !traceStream->IsEnabled(facility, TraceLevel::Trace))
+  {
+    // just measure the time
+    return make_unique<StopWatchImpl>(nullptr, "", "");
+  }
   return make_unique<StopWatchImpl>(traceStream, facility, message);
 }
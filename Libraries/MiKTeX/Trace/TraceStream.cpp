@@ -41,7 +41,9 @@
 #include <ctime>
 
 #include <algorithm>
+#include <atomic>
 #include <codecvt>
+#include <cstdint>
 #include <exception>
 #include <memory>
 #include <mutex>
@@ -110,12 +112,40 @@ TraceStream::~TraceStream() noexcept
 {
 }
 
+// facility names are interned, so that the enabled facilities of a
+// stream can be kept in a bit mask
+struct Facility
+{
+  string name;
+  uint64_t bit;
+};
+
+mutex facilitiesMutex;
+
+// entries are never removed
+unordered_map<string, unique_ptr<Facility>> facilities;
+
+const Facility* InternFacility(const string& name)
+{
+  lock_guard<mutex> lockGuard(facilitiesMutex);
+  unique_ptr<Facility>& facility = facilities[name];
+  if (facility == nullptr)
+  {
+    // facilities beyond the 64th share the last bit
+    size_t id = std::min<size_t>(facilities.size() - 1, 63);
+    facility = make_unique<Facility>(Facility{ name, static_cast<uint64_t>(1) << id });
+  }
+  return facility.get();
+}
+
 struct TraceStreamInfo
 {
   string name;
-  vector<string> enabledFor;
-  TraceLevel level;
+  // 0: all facilities are enabled
+  atomic<uint64_t> enabledFacilities{ 0 };
+  atomic<TraceLevel> level{ defaultLevel };
   vector<TraceCallback*> callbacks;
+  atomic<size_t> numCallbacks{ 0 };
 };
 
 class TraceStreamImpl :
@@ -141,6 +171,7 @@ public:
     if (callback != nullptr)
     {
       info->callbacks.push_back(callback);
+      info->numCallbacks = info->callbacks.size();
     }
   }
 
@@ -162,6 +193,10 @@ private:
 private:
   TraceCallback* callback;
 
+private:
+  // the facility of the previous IsEnabled() call
+  atomic<const Facility*> lastFacility{ nullptr };
+
 private:
   void Logger(const string& facility, TraceLevel level, const string& message);
 
@@ -223,10 +258,11 @@ void TraceStream::SetOptions(const vector<string>& options)
     TraceStreamImpl::options = options;
   }
 
+  // collect the new settings first: readers do not lock
+  unordered_map<string, pair<TraceLevel, uint64_t>> settings;
   for (auto& kv : TraceStreamImpl::traceStreams)
   {
-    kv.second->level = defaultLevel;
-    kv.second->enabledFor.clear();
+    settings[kv.first] = make_pair(defaultLevel, 0);
   }
 
   for (const string& opt : TraceStreamImpl::options)
@@ -235,30 +271,37 @@ void TraceStream::SetOptions(const vector<string>& options)
     string optFacility;
     TraceLevel optLevel;
     std::tie(optStreamName, optFacility, optLevel) = ParseOption(opt);
+    auto apply = [&optFacility, optLevel](pair<TraceLevel, uint64_t>& setting)
+    {
+      setting.first = optLevel;
+      if (!optFacility.empty())
+      {
+        setting.second |= InternFacility(optFacility)->bit;
+      }
+    };
     if (optStreamName.empty())
     {
-      for (auto& kv : TraceStreamImpl::traceStreams)
+      for (auto& kv : settings)
       {
-        kv.second->level = optLevel;
-        if (!optFacility.empty())
-        {
-          kv.second->enabledFor.push_back(optFacility);
-        }
+        apply(kv.second);
       }
     }
     else
     {
-      TraceStreamImpl::TraceStreamTable::iterator it = TraceStreamImpl::traceStreams.equal_range(optStreamName).first;
-      if (it != TraceStreamImpl::traceStreams.end() && it->second != nullptr)
+      auto it = settings.find(optStreamName);
+      if (it != settings.end())
       {
-        it->second->level = optLevel;
-        if (!optFacility.empty())
-        {
-          it->second->enabledFor.push_back(optFacility);
-        }
+        apply(it->second);
       }
     }
   }
+
+  for (auto& kv : TraceStreamImpl::traceStreams)
+  {
+    const pair<TraceLevel, uint64_t>& setting = settings[kv.first];
+    kv.second->level = setting.first;
+    kv.second->enabledFacilities = setting.second;
+  }
 }
 
 void TraceStreamImpl::WriteLine(const string& facility, TraceLevel level, const string& text)
@@ -279,7 +322,8 @@ unique_ptr<TraceStream> TraceStream::Open(const string& name, TraceLevel level,
   {
     traceStreamInfo = make_shared<TraceStreamInfo>();
     traceStreamInfo->name = name;
-    traceStreamInfo->level = level;
+    TraceLevel effectiveLevel = level;
+    uint64_t enabledFacilities = 0;
     for (const string& opt : TraceStreamImpl::options)
     {
       string optName;
@@ -290,14 +334,16 @@ unique_ptr<TraceStream> TraceStream::Open(const string& name, TraceLevel level,
       {
         if (!optFacility.empty())
         {
-          traceStreamInfo->enabledFor.push_back(optFacility);
+          enabledFacilities |= InternFacility(optFacility)->bit;
         }
-        if (optLevel > level)
+        if (optLevel > effectiveLevel)
         {
-          traceStreamInfo->level = optLevel;
+          effectiveLevel = optLevel;
         }
       }
     }
+    traceStreamInfo->level = effectiveLevel;
+    traceStreamInfo->enabledFacilities = enabledFacilities;
     TraceStreamImpl::traceStreams[name] = traceStreamInfo;
   }
   return make_unique<TraceStreamImpl>(traceStreamInfo, callback);
@@ -312,10 +358,12 @@ void TraceStreamImpl::Close()
 {
   if (callback != nullptr)
   {
+    lock_guard<mutex> lockGuard(traceStreamsMutex);
     vector<TraceCallback*>::const_iterator it = find(info->callbacks.begin(), info->callbacks.end(), callback);
     if (it != info->callbacks.end())
     {
       info->callbacks.erase(it);
+      info->numCallbacks = info->callbacks.size();
     }
     callback = nullptr;
   }
@@ -323,8 +371,24 @@ void TraceStreamImpl::Close()
 
 bool TraceStreamImpl::IsEnabled(const string& facility, TraceLevel level)
 {
-  return (this->info->enabledFor.empty() || find(this->info->enabledFor.begin(), this->info->enabledFor.end(), facility) != this->info->enabledFor.end())
-    && level <= this->info->level;
+  // cheap tests first: this is called for every message
+  if (level > this->info->level.load(memory_order_relaxed) || this->info->numCallbacks.load(memory_order_relaxed) == 0)
+  {
+    // nobody would see the message
+    return false;
+  }
+  uint64_t enabledFacilities = this->info->enabledFacilities.load(memory_order_relaxed);
+  if (enabledFacilities == 0)
+  {
+    return true;
+  }
+  const Facility* lastFacility = this->lastFacility.load(memory_order_acquire);
+  if (lastFacility == nullptr || lastFacility->name != facility)
+  {
+    lastFacility = InternFacility(facility);
+    this->lastFacility.store(lastFacility, memory_order_release);
+  }
+  return (enabledFacilities & lastFacility->bit) != 0;
 }
 
 string TraceCallback::TraceMessage::ToString() const
@@ -0,0 +1,100 @@
+/* miktex/Trace/EventRecorder.h:                        -*- C++ -*-
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX Trace Library.
+
+   The MiKTeX Trace Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Trace Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Trace Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(B1F0C8A2D77E4E0C9E6A3C54F2B7D9E1)
+#define B1F0C8A2D77E4E0C9E6A3C54F2B7D9E1
+
+#include "config.h"
+
+#include <cstdint>
+
+/// Environment variable which turns on event recording. The value is
+/// the name of the trace file; `%p` is replaced by the process ID.
+#define MIKTEX_ENV_TRACE_EVENTS "MIKTEX_TRACE_EVENTS"
+
+MIKTEX_TRACE_BEGIN_NAMESPACE;
+
+/// Records timed events in per-thread ring buffers.
+///
+/// Recording is off unless the environment variable
+/// `MIKTEX_TRACE_EVENTS` is set.  The events are written to the trace
+/// file (Chrome trace JSON, which can be loaded into Perfetto) when
+/// the process exits.
+///
+/// Event names must be string literals: only the pointers are
+/// recorded.
+class EventRecorder
+{
+public:
+  EventRecorder() = delete;
+
+  /// Tests whether events are being recorded.
+public:
+  static MIKTEXTRACECEEAPI(bool) IsEnabled();
+
+  /// Records the beginning of a span.
+public:
+  static MIKTEXTRACECEEAPI(void) Begin(const char* name);
+
+  /// Records the end of a span.
+public:
+  static MIKTEXTRACECEEAPI(void) End(const char* name);
+
+  /// Records the value of a counter.
+public:
+  static MIKTEXTRACECEEAPI(void) Counter(const char* name, std::int64_t value);
+
+  /// Writes the trace file now (instead of at process exit).
+public:
+  static MIKTEXTRACECEEAPI(void) Flush();
+};
+
+/// Records a span which lasts as long as the object exists.
+class EventSpan
+{
+public:
+  EventSpan(const char* name) :
+    name(name)
+  {
+    EventRecorder::Begin(name);
+  }
+
+public:
+  EventSpan(const EventSpan& other) = delete;
+
+public:
+  EventSpan& operator=(const EventSpan& other) = delete;
+
+public:
+  ~EventSpan()
+  {
+    EventRecorder::End(name);
+  }
+
+private:
+  const char* name;
+};
+
+MIKTEX_TRACE_END_NAMESPACE;
+
+#endif
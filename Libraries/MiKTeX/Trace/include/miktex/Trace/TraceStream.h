@@ -78,4 +78,16 @@ public:
 
 MIKTEX_TRACE_END_NAMESPACE;
 
+/// Writes a message to a trace stream. The message expression (and so
+/// any formatting and quoting of arguments) is only evaluated if the
+/// stream is enabled for the facility and level.
+#define MIKTEX_TRACE_WRITE_LINE(stream, facility, level, message) \
+  do                                                              \
+  {                                                               \
+    if ((stream)->IsEnabled(facility, level))                     \
+    {                                                             \
+      (stream)->WriteLine(facility, level, message);              \
+    }                                                             \
+  } while (false)
+
 #endif
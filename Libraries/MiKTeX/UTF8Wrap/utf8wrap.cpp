@@ -55,35 +55,135 @@ private:
     char errorMessage[2048];
 };
 
-MIKTEXSTATICFUNC(unique_ptr<wchar_t[]>) UTF8ToLengthExtendedPath(const char* utf8String, const char* function)
+/*
+ * A converted string lives on the stack, if it is short; only long
+ * strings go to the heap.
+ */
+class WideCharBuffer
+{
+public:
+
+    const wchar_t* Get() const
+    {
+        return heapString.empty() ? stackBuffer : heapString.c_str();
+    }
+
+    wchar_t stackBuffer[MAX_PATH];
+
+    wstring heapString;
+};
+
+// converts a short UTF-8 string into the stack buffer; pure ASCII strings
+// are simply widened
+MIKTEXSTATICFUNC(bool) TryUTF8ToWideChar(const char* utf8String, WideCharBuffer& buf, size_t& length)
+{
+    size_t idx;
+    for (idx = 0; idx < MAX_PATH - 1 && utf8String[idx] != 0 && (utf8String[idx] & 0x80) == 0; ++idx)
+    {
+        buf.stackBuffer[idx] = utf8String[idx];
+    }
+    if (utf8String[idx] == 0)
+    {
+        buf.stackBuffer[idx] = 0;
+        length = idx;
+        return true;
+    }
+    int len = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, utf8String, -1, buf.stackBuffer, MAX_PATH);
+    if (len <= 0)
+    {
+        return false;
+    }
+    length = len - 1;
+    return true;
+}
+
+MIKTEXSTATICFUNC(bool) IsAbsolutePath(const char* path)
+{
+    return (PathNameUtil::IsDosDriveLetter(path[0]) && PathNameUtil::IsDosVolumeDelimiter(path[1]) && PathNameUtil::IsDirectoryDelimiter(path[2]))
+        || (PathNameUtil::IsDirectoryDelimiter(path[0]) && PathNameUtil::IsDirectoryDelimiter(path[1]));
+}
+
+/*
+ * Converted length-extended paths of recent calls.  Only absolute paths
+ * are cached, because the conversion of a relative path depends on the
+ * current directory.
+ */
+struct ExtendedPathCacheEntry
 {
+    string utf8Path;
+    wstring extendedPath;
+};
+
+constexpr size_t EXTENDED_PATH_CACHE_SIZE = 8;
+thread_local ExtendedPathCacheEntry extendedPathCache[EXTENDED_PATH_CACHE_SIZE];
+thread_local size_t nextExtendedPathCacheEntry = 0;
+
+MIKTEXSTATICFUNC(WideCharBuffer) UTF8ToLengthExtendedPath(const char* utf8String, const char* function)
+{
+    WideCharBuffer buf;
+    size_t length;
+    if (TryUTF8ToWideChar(utf8String, buf, length))
+    {
+        // the \\?\ prefix is only needed for paths which exceed MAX_PATH
+        // (less the room CreateDirectory needs for a file name)
+        bool isDriveRelative = PathNameUtil::IsDosDriveLetter(utf8String[0]) && PathNameUtil::IsDosVolumeDelimiter(utf8String[1]) && !PathNameUtil::IsDirectoryDelimiter(utf8String[2]);
+        size_t fullLength = length;
+        if (!isDriveRelative && !IsAbsolutePath(utf8String))
+        {
+            fullLength += GetCurrentDirectoryW(0, nullptr) + 1;
+        }
+        if (!isDriveRelative && fullLength < MAX_PATH - 12)
+        {
+            return buf;
+        }
+    }
+    bool isAbsolute = IsAbsolutePath(utf8String);
+    if (isAbsolute)
+    {
+        for (const ExtendedPathCacheEntry& entry : extendedPathCache)
+        {
+            if (entry.utf8Path == utf8String)
+            {
+                buf.heapString = entry.extendedPath;
+                return buf;
+            }
+        }
+    }
     try
     {
-        wstring wch = PathNameUtil::ToLengthExtendedPathName(utf8String);
-        unique_ptr<wchar_t[]> buf(new wchar_t[wch.length() + 1]);
-        StringUtil::CopyString(buf.get(), wch.length() + 1, wch.c_str());
-        return buf;
+        buf.heapString = PathNameUtil::ToLengthExtendedPathName(utf8String);
     }
     catch (const exception&)
     {
         throw utf8wraperror(function, utf8String);
     }
+    if (isAbsolute)
+    {
+        ExtendedPathCacheEntry& entry = extendedPathCache[nextExtendedPathCacheEntry];
+        entry.utf8Path = utf8String;
+        entry.extendedPath = buf.heapString;
+        nextExtendedPathCacheEntry = (nextExtendedPathCacheEntry + 1) % EXTENDED_PATH_CACHE_SIZE;
+    }
+    return buf;
 }
 
-
-MIKTEXSTATICFUNC(unique_ptr<wchar_t[]>) UTF8ToWideChar(const char* utf8String, const char* function)
+MIKTEXSTATICFUNC(WideCharBuffer) UTF8ToWideChar(const char* utf8String, const char* function)
 {
-    try
+    WideCharBuffer buf;
+    size_t length;
+    if (TryUTF8ToWideChar(utf8String, buf, length))
     {
-        wstring wch = StringUtil::UTF8ToWideChar(utf8String);
-        unique_ptr<wchar_t[]> buf(new wchar_t[wch.length() + 1]);
-        StringUtil::CopyString(buf.get(), wch.length() + 1, wch.c_str());
         return buf;
     }
+    try
+    {
+        buf.heapString = StringUtil::UTF8ToWideChar(utf8String);
+    }
     catch (const exception&)
     {
         throw utf8wraperror(function, utf8String);
     }
+    return buf;
 }
 
 MIKTEXSTATICFUNC(unique_ptr<char[]>) WideCharToUTF8(const wchar_t* wideCharString, const char* function)
@@ -101,8 +201,8 @@ MIKTEXSTATICFUNC(unique_ptr<char[]>) WideCharToUTF8(const wchar_t* wideCharStrin
     }
 };
 
-#define EXPATH_(x) UTF8ToLengthExtendedPath(x, __func__).get()
-#define UW_(x) UTF8ToWideChar(x, __func__).get()
+#define EXPATH_(x) UTF8ToLengthExtendedPath(x, __func__).Get()
+#define UW_(x) UTF8ToWideChar(x, __func__).Get()
 #define WU_(x) WideCharToUTF8(x, __func__).get()
 
 MIKTEXUTF8WRAPCEEAPI(FILE*) miktex_utf8_fopen(const char* path, const char* mode)
@@ -47,21 +47,20 @@ using namespace std;
 
 using namespace MiKTeX::Util;
 
-int PathName::Compare(const char* lpszPath1, const char* lpszPath2)
-{
 #if defined(MIKTEX_WINDOWS)
-  PathName path1(lpszPath1);
-  path1.TransformForComparison();
-  lpszPath1 = path1.GetData();
-  PathName path2(lpszPath2);
-  path2.TransformForComparison();
-  lpszPath2 = path2.GetData();
+// the comparison form of an ASCII character (see TransformForComparison())
+inline char ToComparableAscii(char ch)
+{
+  return Helpers::ToLowerAscii(PathNameUtil::ToUnix(ch));
+}
 #endif
 
+template<typename Transform> int ComparePaths(const char* lpszPath1, const char* lpszPath2, Transform transform)
+{
   int ret;
   int cmp;
 
-  while ((cmp = *lpszPath1 - *lpszPath2) == 0 && *lpszPath1 != 0)
+  while ((cmp = transform(*lpszPath1) - transform(*lpszPath2)) == 0 && *lpszPath1 != 0)
   {
     ++lpszPath1;
     ++lpszPath2;
@@ -93,31 +92,56 @@ int PathName::Compare(const char* lpszPath1, const char* lpszPath2)
   return ret;
 }
 
-int PathName::Compare(const char* lpszPath1, const char* lpszPath2, size_t count)
+template<typename Transform> int ComparePaths(const char* lpszPath1, const char* lpszPath2, size_t count, Transform transform)
 {
-  if (count == 0)
+  for (size_t i = 0; i < count; ++i, ++lpszPath1, ++lpszPath2)
   {
-    return 0;
+    if (*lpszPath1 == 0 || transform(*lpszPath1) != transform(*lpszPath2))
+    {
+      return static_cast<unsigned char>(transform(*lpszPath1)) - static_cast<unsigned char>(transform(*lpszPath2));
+    }
   }
+  return 0;
+}
 
+int PathName::Compare(const char* lpszPath1, const char* lpszPath2)
+{
 #if defined(MIKTEX_WINDOWS)
+  // ASCII path names can be compared without transformed copies
+  if (Helpers::IsPureAscii(lpszPath1) && Helpers::IsPureAscii(lpszPath2))
+  {
+    return ComparePaths(lpszPath1, lpszPath2, ToComparableAscii);
+  }
   PathName path1(lpszPath1);
   path1.TransformForComparison();
-  lpszPath1 = path1.GetData();
   PathName path2(lpszPath2);
   path2.TransformForComparison();
-  lpszPath2 = path2.GetData();
+  return ComparePaths(path1.GetData(), path2.GetData(), [](char ch) { return ch; });
+#else
+  return ComparePaths(lpszPath1, lpszPath2, [](char ch) { return ch; });
 #endif
+}
 
-  for (size_t i = 0; i < count; ++i, ++lpszPath1, ++lpszPath2)
+int PathName::Compare(const char* lpszPath1, const char* lpszPath2, size_t count)
+{
+  if (count == 0)
   {
-    if (*lpszPath1 == 0 || *lpszPath1 != *lpszPath2)
-    {
-      return *reinterpret_cast<const unsigned char*>(lpszPath1) - *reinterpret_cast<const unsigned char*>(lpszPath2);
-    }
+    return 0;
   }
 
-  return 0;
+#if defined(MIKTEX_WINDOWS)
+  if (Helpers::IsPureAscii(lpszPath1) && Helpers::IsPureAscii(lpszPath2))
+  {
+    return ComparePaths(lpszPath1, lpszPath2, count, ToComparableAscii);
+  }
+  PathName path1(lpszPath1);
+  path1.TransformForComparison();
+  PathName path2(lpszPath2);
+  path2.TransformForComparison();
+  return ComparePaths(path1.GetData(), path2.GetData(), count, [](char ch) { return ch; });
+#else
+  return ComparePaths(lpszPath1, lpszPath2, count, [](char ch) { return ch; });
+#endif
 }
 
 PathName GetFullyQualifiedPath(const char* lpszPath)
@@ -201,16 +225,20 @@ PathName& PathName::Convert(ConvertPathNameOptions options)
     Helpers::CanonicalizePathName(*this);
   }
 
+  // in place: no temporary string
   if (toUnix)
   {
-    string s = this->ToString();
-    PathNameUtil::ConvertToUnix(s);
-    *this = s;
-  } else if (toDos)
+    for (char* lpsz = GetData(); *lpsz != 0; ++lpsz)
+    {
+      *lpsz = PathNameUtil::ToUnix(*lpsz);
+    }
+  }
+  else if (toDos)
   {
-    string s = this->ToString();
-    PathNameUtil::ConvertToDos(s);
-    *this = s;
+    for (char* lpsz = GetData(); *lpsz != 0; ++lpsz)
+    {
+      *lpsz = PathNameUtil::ToDos(*lpsz);
+    }
   }
 
   if (toUpper || toLower)
@@ -260,7 +288,12 @@ static bool InternalMatch(const char* lpszPattern, const char* lpszPath)
 
 bool PathName::Match(const char* lpszPattern, const char* lpszPath)
 {
+#if defined(MIKTEX_WINDOWS)
   return InternalMatch(PathName(lpszPattern).TransformForComparison().GetData(), PathName(lpszPath).TransformForComparison().GetData());
+#else
+  // TransformForComparison() is the identity
+  return InternalMatch(lpszPattern, lpszPath);
+#endif
 }
 
 vector<string> PathName::Split(const PathName& path)
@@ -0,0 +1,113 @@
+/* StartupProfile.cpp:
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX Util Library.
+
+   The MiKTeX Util Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Util Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Util Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#define A7C88F5FBE5C45EB970B3796F331CD89
+#include "miktex/Util/config.h"
+
+#include "internal.h"
+
+#include "miktex/Util/StartupProfile.h"
+
+using namespace std;
+
+using namespace MiKTeX::Util;
+
+namespace {
+  struct Section
+  {
+    string name;
+    size_t depth;
+    chrono::steady_clock::time_point start;
+    chrono::steady_clock::duration duration;
+  };
+
+  mutex sectionsMutex;
+  vector<Section> sections;
+  // indices of the open sections
+  vector<size_t> openSections;
+  bool reportRegistered = false;
+}
+
+static void WriteReport()
+{
+  lock_guard<mutex> lockGuard(sectionsMutex);
+  if (sections.empty())
+  {
+    return;
+  }
+  chrono::steady_clock::time_point origin = sections.front().start;
+  fmt::print(stderr, "startup profile:\n");
+  fmt::print(stderr, "{:>10} {:>10}  {}\n", "at/ms", "took/ms", "section");
+  for (const Section& section : sections)
+  {
+    fmt::print(stderr, "{:>10.3f} {:>10.3f}  {}{}\n",
+      chrono::duration<double, milli>(section.start - origin).count(),
+      chrono::duration<double, milli>(section.duration).count(),
+      string(2 * section.depth, ' '),
+      section.name);
+  }
+}
+
+bool StartupProfile::IsEnabled()
+{
+  static const bool enabled = []()
+  {
+    string value;
+    return Helpers::GetEnvironmentString("MIKTEX_STARTUP_PROFILE", value) && value == "1";
+  }();
+  return enabled;
+}
+
+void StartupProfile::Begin(const string& name)
+{
+  lock_guard<mutex> lockGuard(sectionsMutex);
+  if (!reportRegistered)
+  {
+    reportRegistered = true;
+    atexit(WriteReport);
+  }
+  openSections.push_back(sections.size());
+  sections.push_back({ name, openSections.size() - 1, chrono::steady_clock::now(), chrono::steady_clock::duration::zero() });
+}
+
+void StartupProfile::End()
+{
+  chrono::steady_clock::time_point now = chrono::steady_clock::now();
+  lock_guard<mutex> lockGuard(sectionsMutex);
+  if (openSections.empty())
+  {
+    return;
+  }
+  Section& section = sections[openSections.back()];
+  section.duration = now - section.start;
+  openSections.pop_back();
+}
@@ -60,6 +60,15 @@ Tokenizer::Tokenizer(const string& s, const string& delims) :
   this->operator++();
 }
 
+Tokenizer::Tokenizer(string_view s, const string& delims) :
+  pimpl(new impl{})
+{
+  pimpl->buf.Append(s.data(), s.length());
+  pimpl->next = pimpl->buf.GetData();
+  SetDelimiters(delims);
+  this->operator++();
+}
+
 void Tokenizer::SetDelimiters(const string& delims)
 {
   pimpl->delims.reset();
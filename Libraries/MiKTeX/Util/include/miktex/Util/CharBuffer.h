@@ -156,8 +156,11 @@ public:
   {
     if (this != &other)
     {
-      Reserve(other.capacity);
-      memcpy(this->buffer, other.buffer, other.capacity * sizeof(CharType));
+      // copy the characters in use, not the whole buffer
+      std::size_t length = other.GetLength();
+      Reserve(length + 1);
+      memcpy(this->buffer, other.buffer, length * sizeof(CharType));
+      this->buffer[length] = 0;
     }
   }
 
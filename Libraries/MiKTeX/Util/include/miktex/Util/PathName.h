@@ -32,6 +32,7 @@
 
 #include <miktex/Util/CharBuffer>
 #include <miktex/Util/PathNameUtil>
+#include <miktex/Util/PathNameView>
 
 #include "OptionSet.h"
 
@@ -124,6 +125,14 @@ public:
   {
   }
 
+  /// Copies a path name view into a new PathName object.
+  /// @param path The path name view.
+public:
+  explicit PathName(const PathNameView& path)
+  {
+    Base::Append(path.GetData(), path.GetLength());
+  }
+
 public:
   PathName(size_t n) = delete;
 
@@ -177,6 +186,14 @@ public:
     return *this;
   }
 
+  /// Gets a non-owning view of this path name.
+  /// @return Returns the view. It is invalidated by modifications of this object.
+public:
+  PathNameView View() const
+  {
+    return PathNameView(GetData());
+  }
+
   /// Calculates the hash value of this PathName object.
   /// @return Returns the hash value.
 public:
@@ -534,6 +551,20 @@ public:
     return AppendComponent(component.c_str());
   }
 
+  /// Appends a path name component to this path name.
+  /// @param component The component to be appended.
+  /// @return Returns a reference to this object.
+public:
+  PathName& operator/=(const PathNameView& component)
+  {
+    if (!Empty() && (component.Empty() || !MiKTeX::Util::PathNameUtil::IsDirectoryDelimiter(component.GetData()[0])))
+    {
+      AppendDirectoryDelimiter();
+    }
+    Base::Append(component.GetData(), component.GetLength());
+    return *this;
+  }
+
   /// Cuts off the last component from the path name.
   /// @return Returns a reference to this object.
 public:
@@ -0,0 +1,165 @@
+/* miktex/Util/PathNameView.h:
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX Util Library.
+
+   The MiKTeX Util Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Util Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Util Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(F2B6C0D84E3A4F1B9A7D5C8E1B0A6F34)
+#define F2B6C0D84E3A4F1B9A7D5C8E1B0A6F34
+
+#include <miktex/Util/config.h>
+
+#include <cstddef>
+
+#include <string>
+#include <string_view>
+
+#include "PathNameUtil.h"
+
+MIKTEX_UTIL_BEGIN_NAMESPACE;
+
+/// Non-owning reference to a path name or to a part of a path name.
+///
+/// The referenced characters must outlive the view. A view is not
+/// necessarily null-terminated.
+class PathNameView
+{
+public:
+  PathNameView() = default;
+
+public:
+  PathNameView(const char* path) :
+    view(path)
+  {
+  }
+
+public:
+  PathNameView(const char* path, std::size_t length) :
+    view(path, length)
+  {
+  }
+
+public:
+  PathNameView(const std::string& path) :
+    view(path)
+  {
+  }
+
+public:
+  PathNameView(std::string_view path) :
+    view(path)
+  {
+  }
+
+public:
+  const char* GetData() const
+  {
+    return view.data();
+  }
+
+public:
+  std::size_t GetLength() const
+  {
+    return view.length();
+  }
+
+public:
+  bool Empty() const
+  {
+    return view.empty();
+  }
+
+public:
+  std::string ToString() const
+  {
+    return std::string(view);
+  }
+
+public:
+  std::string_view ToStringView() const
+  {
+    return view;
+  }
+
+  /// Gets the directory part, including the trailing directory delimiter.
+  /// @return Returns the directory part. Empty, if there is none.
+public:
+  PathNameView GetDirectoryName() const
+  {
+    return PathNameView(view.substr(0, FileNameOffset()));
+  }
+
+  /// Gets the file name part.
+  /// @return Returns the file name part.
+public:
+  PathNameView GetFileName() const
+  {
+    return PathNameView(view.substr(FileNameOffset()));
+  }
+
+  /// Gets the file name extension (including the dot).
+  /// @return Returns the extension. Empty, if there is none.
+public:
+  PathNameView GetExtension() const
+  {
+    std::string_view fileName = view.substr(FileNameOffset());
+    std::size_t dot = fileName.rfind('.');
+    return dot == std::string_view::npos ? PathNameView() : PathNameView(fileName.substr(dot));
+  }
+
+public:
+  bool EndsWithDirectoryDelimiter() const
+  {
+    return !view.empty() && PathNameUtil::IsDirectoryDelimiter(view.back());
+  }
+
+  /// Removes trailing directory delimiters.
+  /// @return Returns the shortened view.
+public:
+  PathNameView WithoutTrailingDirectoryDelimiter() const
+  {
+    std::string_view result = view;
+    while (!result.empty() && PathNameUtil::IsDirectoryDelimiter(result.back()))
+    {
+      result.remove_suffix(1);
+    }
+    return PathNameView(result);
+  }
+
+private:
+  std::size_t FileNameOffset() const
+  {
+    for (std::size_t idx = view.length(); idx > 0; --idx)
+    {
+      if (PathNameUtil::IsDirectoryDelimiter(view[idx - 1]))
+      {
+        return idx;
+      }
+    }
+    return 0;
+  }
+
+private:
+  std::string_view view;
+};
+
+MIKTEX_UTIL_END_NAMESPACE;
+
+#endif
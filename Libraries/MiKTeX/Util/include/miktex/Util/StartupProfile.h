@@ -0,0 +1,108 @@
+/* miktex/Util/StartupProfile.h:
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is part of the MiKTeX Util Library.
+
+   The MiKTeX Util Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Util Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Util Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(D3A1F6C2B9E84E5F8C0A7B4E2D1C9F60)
+#define D3A1F6C2B9E84E5F8C0A7B4E2D1C9F60
+
+#include <miktex/Util/config.h>
+
+#include <string>
+
+MIKTEX_UTIL_BEGIN_NAMESPACE;
+
+/// Opt-in startup profile.
+///
+/// If the environment variable `MIKTEX_STARTUP_PROFILE` is set to `1`,
+/// the sections of the startup sequence (session creation,
+/// configuration, root directories, logging, translations) are timed.
+/// The breakdown is written to `stderr` when the process exits.
+class MIKTEXNOVTABLE StartupProfile
+{
+public:
+  StartupProfile() = delete;
+
+public:
+  StartupProfile(const StartupProfile& other) = delete;
+
+public:
+  StartupProfile& operator=(const StartupProfile& other) = delete;
+
+public:
+  StartupProfile(StartupProfile&& other) = delete;
+
+public:
+  StartupProfile& operator=(StartupProfile&& other) = delete;
+
+public:
+  ~StartupProfile() = delete;
+
+  /// Tests whether the startup profile is enabled.
+  /// @return Returns `true`, if `MIKTEX_STARTUP_PROFILE=1`.
+public:
+  static MIKTEXUTILCEEAPI(bool) IsEnabled();
+
+  /// Begins a section.
+  /// @param name The name of the section.
+public:
+  static MIKTEXUTILCEEAPI(void) Begin(const std::string& name);
+
+  /// Ends the innermost section.
+public:
+  static MIKTEXUTILCEEAPI(void) End();
+};
+
+/// Times a startup profile section: from construction until destruction.
+class StartupProfileSection
+{
+public:
+  StartupProfileSection(const std::string& name) :
+    enabled(StartupProfile::IsEnabled())
+  {
+    if (enabled)
+    {
+      StartupProfile::Begin(name);
+    }
+  }
+
+public:
+  StartupProfileSection(const StartupProfileSection& other) = delete;
+
+public:
+  StartupProfileSection& operator=(const StartupProfileSection& other) = delete;
+
+public:
+  ~StartupProfileSection()
+  {
+    if (enabled)
+    {
+      StartupProfile::End();
+    }
+  }
+
+private:
+  bool enabled;
+};
+
+MIKTEX_UTIL_END_NAMESPACE;
+
+#endif
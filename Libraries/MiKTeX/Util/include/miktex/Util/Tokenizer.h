@@ -28,6 +28,7 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 
 MIKTEX_UTIL_BEGIN_NAMESPACE;
 
@@ -54,6 +55,15 @@ public:
 public:
   MIKTEXUTILEXPORT MIKTEXTHISCALL Tokenizer(const std::string& s, const std::string& delims);
 
+public:
+  MIKTEXUTILEXPORT MIKTEXTHISCALL Tokenizer(std::string_view s, const std::string& delims);
+
+public:
+  Tokenizer(const char* s, const std::string& delims) :
+    Tokenizer(std::string_view(s), delims)
+  {
+  }
+
 public:
   MIKTEXUTILTHISAPI(void) SetDelimiters(const std::string& delims);
 
@@ -2104,6 +2104,12 @@ BEGIN
     BEGIN
       PRINT2 ("Database file #%ld: ", (long) bib_ptr + 1);
       print_bib_name ();
+#if defined(MIKTEX)
+      if ( ! all_entries)
+      BEGIN
+        reduce_bib_file ();
+      END
+#endif
       bib_line_num = 0;
       buf_ptr2 = last;
       while ( ! feof (CUR_BIB_FILE))
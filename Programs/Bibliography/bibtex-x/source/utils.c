@@ -30,6 +30,7 @@
 **          mymalloc
 **          myrealloc
 **          parse_cmd_line
+**          reduce_bib_file (MiKTeX only)
 **          report_bibtex_capacity
 **          report_search_paths
 **          set_array_sizes
@@ -1191,6 +1192,53 @@ void parse_cmd_line (int argc, char **argv)
 
 
 
+#if defined(MIKTEX)
+/*-
+**============================================================================
+** reduce_bib_file()
+**
+**  Replace the current database file by a temporary file which holds only
+**  the entries needed for the cite keys seen so far (and all @STRING and
+**  @PREAMBLE commands).  Dropped entries are replaced by their line breaks,
+**  so that line numbers in messages are not affected.  The database file
+**  is read as it is, if it cannot be reduced.
+**============================================================================
+*/
+void reduce_bib_file (void)
+{
+    const char        **cite_keys;
+    char               *key_chars;
+    unsigned long       key_chars_size;
+    CiteNumber_T        cite_xptr;
+    StrNumber_T         cite_str;
+    FILE               *reduced_file;
+
+    key_chars_size = 0;
+    for (cite_xptr = 0; cite_xptr < cite_ptr; cite_xptr++)
+        key_chars_size += LENGTH (cite_list[cite_xptr]) + 1;
+    cite_keys = (const char **) mymalloc (cite_ptr * sizeof (const char *), "cite_keys");
+    key_chars = (char *) mymalloc (key_chars_size, "key_chars");
+    key_chars_size = 0;
+    for (cite_xptr = 0; cite_xptr < cite_ptr; cite_xptr++) {
+        cite_str = cite_list[cite_xptr];
+        cite_keys[cite_xptr] = key_chars + key_chars_size;
+        memcpy (key_chars + key_chars_size, &str_pool[str_start[cite_str]], LENGTH (cite_str));
+        key_chars_size += LENGTH (cite_str);
+        key_chars[key_chars_size++] = '\0';
+    }
+    reduced_file = miktex_kpsemu_reduce_bib_database (CUR_BIB_FILE, cite_keys, cite_ptr);
+    free (key_chars);
+    free (cite_keys);
+    if (reduced_file != NULL) {
+        debug_msg (DBG_IO, "reading a reduced copy of the database file");
+        a_close (CUR_BIB_FILE);
+        CUR_BIB_FILE = reduced_file;
+    }
+}                               /* reduce_bib_file() */
+#endif
+
+
+
 /*-
 **============================================================================
 ** report_bibtex_capacity()
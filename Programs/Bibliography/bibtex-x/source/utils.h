@@ -116,6 +116,9 @@ void                   *mymalloc (const unsigned long bytes_required,
 void                   *myrealloc (void *old_ptr, const unsigned long bytes_required,
 				const char *var_name);
 void                    parse_cmd_line (int argc, char **argv);
+#if defined(MIKTEX)
+void                    reduce_bib_file (void);
+#endif
 void                    report_bibtex_capacity (void);
 void                    report_search_paths (void);
 void		        set_array_sizes (void);
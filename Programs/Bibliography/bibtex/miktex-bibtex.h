@@ -24,11 +24,13 @@
 #include "miktex-bibtex-version.h"
 
 #include <miktex/Configuration/ConfigNames>
+#include <miktex/Core/File>
 #include <miktex/Core/FileType>
 #include <miktex/TeXAndFriends/CharacterConverterImpl>
 #include <miktex/TeXAndFriends/InitFinalizeImpl>
 #include <miktex/TeXAndFriends/InputOutputImpl>
 #include <miktex/TeXAndFriends/WebAppInputLine>
+#include <miktex/Util/StringUtil>
 #include <miktex/W2C/Emulation>
 
 #if !defined(MIKTEXHELP_BIBTEX)
@@ -108,15 +110,7 @@ public:
     BIBTEXPROG.globstrsize = session->GetConfigValue(MIKTEX_CONFIG_SECTION_BIBTEX, "glob_str_size", MiKTeX::Configuration::ConfigValue(bibtex::bibtex::glob_str_size())).GetInt();
     BIBTEXPROG.maxstrings = session->GetConfigValue(MIKTEX_CONFIG_SECTION_BIBTEX, "max_strings", MiKTeX::Configuration::ConfigValue(bibtex::bibtex::max_strings())).GetInt();
     BIBTEXPROG.mincrossrefs = session->GetConfigValue(MIKTEX_CONFIG_SECTION_BIBTEX, "min_crossrefs", MiKTeX::Configuration::ConfigValue(bibtex::bibtex::min_crossrefs())).GetInt();
-    BIBTEXPROG.hashsize = BIBTEXPROG.maxstrings;
-    const int HASH_SIZE_MIN = 5000;
-    if (BIBTEXPROG.hashsize < HASH_SIZE_MIN)
-    {
-      BIBTEXPROG.hashsize = HASH_SIZE_MIN;
-    }
-    BIBTEXPROG.hashmax = BIBTEXPROG.hashsize + BIBTEXPROG.hashbase - 1;
-    BIBTEXPROG.endofdef = BIBTEXPROG.hashmax + 1;
-    BIBTEXPROG.undefined = BIBTEXPROG.hashmax + 1;
+    SetHashSize();
     BIBTEXPROG.bufsize = BIBTEXPROG.bufsizedef;
     BIBTEXPROG.litstksize = BIBTEXPROG.litstksizedef;
     BIBTEXPROG.maxbibfiles = BIBTEXPROG.maxbibfilesdef;
@@ -159,6 +153,90 @@ public:
     PascalAllocate(BIBTEXPROG.wizfunctions, BIBTEXPROG.wizfnspace);
     BIBTEXPROG.computehashprime();
   }
+
+private:
+  void SetHashSize()
+  {
+    BIBTEXPROG.hashsize = BIBTEXPROG.maxstrings;
+    const int HASH_SIZE_MIN = 5000;
+    if (BIBTEXPROG.hashsize < HASH_SIZE_MIN)
+    {
+      BIBTEXPROG.hashsize = HASH_SIZE_MIN;
+    }
+    BIBTEXPROG.hashmax = BIBTEXPROG.hashsize + BIBTEXPROG.hashbase - 1;
+    BIBTEXPROG.endofdef = BIBTEXPROG.hashmax + 1;
+    BIBTEXPROG.undefined = BIBTEXPROG.hashmax + 1;
+  }
+
+  // field values and keys are strings: a .bib file yields about one
+  // string per 40 bytes
+private:
+  static constexpr std::size_t BIB_BYTES_PER_STRING = 40;
+
+  // Sizes the hash table for the databases named by \bibdata in the .aux
+  // file.  Called before the first string is entered, i.e., before the
+  // hash function depends on |hash_prime|.
+public:
+  void SizeHashTable()
+  {
+    if (C4P::GetArgC() != 2)
+    {
+      return;
+    }
+    MiKTeX::Util::PathName auxFile(C4P::GetArgV()[1]);
+    if (!auxFile.HasExtension(".aux"))
+    {
+      auxFile.AppendExtension(".aux");
+    }
+    std::size_t bibSize = 0;
+    try
+    {
+      std::vector<unsigned char> bytes = MiKTeX::Core::File::ReadAllBytes(auxFile);
+      std::string aux(bytes.begin(), bytes.end());
+      const std::string bibdata = "\\bibdata{";
+      for (std::size_t pos = aux.find(bibdata); pos != std::string::npos; pos = aux.find(bibdata, pos))
+      {
+        pos += bibdata.length();
+        std::size_t end = aux.find('}', pos);
+        if (end == std::string::npos)
+        {
+          break;
+        }
+        for (const std::string& name : MiKTeX::Util::StringUtil::Split(aux.substr(pos, end - pos), ','))
+        {
+          MiKTeX::Util::PathName bibFile(name);
+          if (!bibFile.HasExtension(".bib"))
+          {
+            bibFile.AppendExtension(".bib");
+          }
+          MiKTeX::Util::PathName path;
+          if (session->FindFile(bibFile.ToString(), MiKTeX::Core::FileType::BIB, path))
+          {
+            bibSize += MiKTeX::Core::File::GetSize(path);
+          }
+        }
+      }
+    }
+    catch (const MiKTeX::Core::MiKTeXException&)
+    {
+      // BibTeX reports the problem when it reads the .aux file
+      return;
+    }
+    std::size_t wanted = BIBTEXPROG.maxstrings + bibSize / BIB_BYTES_PER_STRING;
+    if (wanted <= static_cast<std::size_t>(BIBTEXPROG.hashsize) || wanted > static_cast<std::size_t>(BIBTEXPROG.maxstringsmax))
+    {
+      return;
+    }
+    BIBTEXPROG.maxstrings = static_cast<int>(wanted);
+    SetHashSize();
+    PascalReallocate(BIBTEXPROG.fntype, BIBTEXPROG.hashmax);
+    PascalReallocate(BIBTEXPROG.hashilk, BIBTEXPROG.hashmax);
+    PascalReallocate(BIBTEXPROG.hashnext, BIBTEXPROG.hashmax);
+    PascalReallocate(BIBTEXPROG.hashtext, BIBTEXPROG.hashmax);
+    PascalReallocate(BIBTEXPROG.ilkinfo, BIBTEXPROG.hashmax);
+    PascalReallocate(BIBTEXPROG.strstart, BIBTEXPROG.maxstrings);
+    BIBTEXPROG.computehashprime();
+  }
   
 public:
   void Finalize() override
@@ -288,6 +366,52 @@ public:
 #endif
     return true;
   }
+
+public:
+  template<class T> void ReduceBibFile(T& f)
+  {
+    // the cite keys of the .aux file(s) plus the crossref keys of the
+    // entries read so far
+    std::vector<std::string> citeKeys;
+    for (int idx = 0; idx < BIBTEXPROG.citeptr; ++idx)
+    {
+      int s = BIBTEXPROG.citelist[idx];
+      citeKeys.push_back(std::string(reinterpret_cast<const char*>(&BIBTEXPROG.strpool[BIBTEXPROG.strstart[s]]), BIBTEXPROG.strstart[s + 1] - BIBTEXPROG.strstart[s]));
+    }
+    FILE* file = f;
+    std::string database;
+    char buf[8192];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+    {
+      database.append(buf, n);
+    }
+    std::string reduced;
+    bool isReduced = false;
+    try
+    {
+      isReduced = session->ReduceBibDatabase(database, citeKeys, reduced);
+    }
+    catch (const MiKTeX::Core::MiKTeXException&)
+    {
+    }
+    FILE* reducedFile = isReduced ? tmpfile() : nullptr;
+    if (reducedFile == nullptr || fwrite(reduced.data(), 1, reduced.length(), reducedFile) != reduced.length())
+    {
+      if (reducedFile != nullptr)
+      {
+        fclose(reducedFile);
+      }
+      rewind(file);
+      return;
+    }
+    rewind(reducedFile);
+    CloseFile(f);
+    f.Attach(reducedFile, true);
+#ifdef PASCAL_TEXT_IO
+    get(f);
+#endif
+  }
 };
 
 extern BIBTEXAPPCLASS BIBTEXAPP;
@@ -317,6 +441,16 @@ template<class T> inline bool miktexopenbstfile(T& f)
   return BIBTEXAPP.OpenBstFile(f);
 }
 
+inline void miktexsizehashtable()
+{
+  BIBTEXAPP.SizeHashTable();
+}
+
+template<class T> inline void miktexreducebibfile(T& f)
+{
+  BIBTEXAPP.ReduceBibFile(f);
+}
+
 inline bool miktexhasextension(const char* fileName, const char* extension)
 {
   return MiKTeX::Util::PathName(fileName).HasExtension(extension);
@@ -45,6 +45,15 @@ static const char *copyright =
 #include "gabc/gabc.h"
 #include "vowel/vowel.h"
 
+#if defined(MIKTEX)
+#include <miktex/Core/c/api.h>
+/* read the score and write the output in big chunks */
+#  undef fopen
+#  define fopen miktex_fopen_stream
+#  undef fclose
+#  define fclose miktex_fclose_stream
+#endif
+
 #ifndef MODULE_PATH_ENV
 #define MODULE_PATH_ENV        "MODULE_PATH"
 #endif
@@ -0,0 +1,362 @@
+/* miktex/t4ht.h:
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA.  */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Process>
+#include <miktex/Core/Session>
+#include <miktex/Util/PathName>
+
+/* With -j, the commands converting a picture (the dvigif, move and
+   chmod scripts) are not run right away, but collected as one job per
+   picture.  The jobs run concurrently when all pictures have been
+   seen.  A job stops at the first failing command, just like the
+   scripts do.
+
+   Converted pictures are cached by the digest of their DVI page (plus
+   the font definitions and the conversion script), so that unchanged
+   pictures are not converted again in the next run.  A picture
+   restored from the cache is moved and chmod'ed like a converted
+   one. */
+
+namespace
+{
+  struct MiKTeXPictureJob
+  {
+    std::vector<std::string> commands;
+    // number of commands which convert the picture
+    std::size_t conversionCommands = 0;
+    MiKTeX::Util::PathName destination;
+    MiKTeX::Util::PathName cacheFile;
+    std::string output;
+  };
+
+  struct MiKTeXIdvPage
+  {
+    std::int32_t number;
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  struct MiKTeXPictureJobs
+  {
+    int maxJobs = 0;
+    std::vector<MiKTeXPictureJob> jobs;
+    MiKTeXPictureJob current;
+    bool inPicture = false;
+    MiKTeX::Core::MD5Builder keyBuilder;
+    std::string jobName;
+    std::string idvFileName;
+    std::vector<unsigned char> idv;
+    std::vector<MiKTeXIdvPage> idvPages;
+    MiKTeX::Core::MD5 idvFontsDigest;
+  };
+
+  MiKTeXPictureJobs miktexPictureJobs;
+
+  class MiKTeXPictureOutput :
+    public MiKTeX::Core::IRunProcessCallback
+  {
+  public:
+    MiKTeXPictureOutput(std::string& output) :
+      output(output)
+    {
+    }
+  public:
+    bool MIKTEXTHISCALL OnProcessOutput(const void* bytes, std::size_t n) override
+    {
+      output.append(reinterpret_cast<const char*>(bytes), n);
+      return true;
+    }
+  private:
+    std::string& output;
+  };
+}
+
+static void miktex_set_picture_jobs(int n)
+{
+  miktexPictureJobs.maxJobs = n < 1 ? 1 : n;
+}
+
+static std::uint32_t miktex_idv_get4(const std::vector<unsigned char>& idv, std::size_t pos)
+{
+  return (static_cast<std::uint32_t>(idv[pos]) << 24) | (static_cast<std::uint32_t>(idv[pos + 1]) << 16) | (static_cast<std::uint32_t>(idv[pos + 2]) << 8) | idv[pos + 3];
+}
+
+/* Locate the pages and the font definitions of the IDV (DVI) file. */
+static bool miktex_load_idv(const char* fileName)
+{
+  const int BOP = 139;
+  const int POST = 248;
+  const int POST_POST = 249;
+  const int PADDING = 223;
+  if (miktexPictureJobs.idvFileName == fileName)
+  {
+    return !miktexPictureJobs.idvPages.empty();
+  }
+  miktexPictureJobs.idvFileName = fileName;
+  miktexPictureJobs.idvPages.clear();
+  std::vector<unsigned char>& idv = miktexPictureJobs.idv;
+  try
+  {
+    idv = MiKTeX::Core::File::ReadAllBytes(MiKTeX::Util::PathName(fileName));
+  }
+  catch (const MiKTeX::Core::MiKTeXException&)
+  {
+    idv.clear();
+    return false;
+  }
+  std::size_t end = idv.size();
+  while (end > 0 && idv[end - 1] == PADDING)
+  {
+    --end;
+  }
+  if (end < 6 || idv[end - 6] != POST_POST)
+  {
+    return false;
+  }
+  std::size_t post = miktex_idv_get4(idv, end - 5);
+  if (post + 29 > end - 6 || idv[post] != POST)
+  {
+    return false;
+  }
+  MiKTeX::Core::MD5Builder fonts;
+  // num, den, mag
+  fonts.Update(&idv[post + 5], 12);
+  // fnt_defs
+  fonts.Update(&idv[post + 29], end - 6 - (post + 29));
+  miktexPictureJobs.idvFontsDigest = fonts.Final();
+  std::vector<MiKTeXIdvPage> pages;
+  std::size_t next = post;
+  for (std::uint32_t bop = miktex_idv_get4(idv, post + 1); bop < next && bop + 45 <= idv.size() && idv[bop] == BOP; bop = miktex_idv_get4(idv, bop + 41))
+  {
+    pages.push_back({ static_cast<std::int32_t>(miktex_idv_get4(idv, bop + 1)), bop, next });
+    next = bop;
+  }
+  miktexPictureJobs.idvPages.assign(pages.rbegin(), pages.rend());
+  return !pages.empty();
+}
+
+static MiKTeX::Util::PathName miktex_picture_cache_directory()
+{
+  std::shared_ptr<MiKTeX::Core::Session> session = MIKTEX_SESSION();
+  return session->GetSpecialPath(session->IsAdminMode() ? MiKTeX::Configuration::SpecialPath::CommonDataRoot : MiKTeX::Configuration::SpecialPath::UserDataRoot)
+    / MiKTeX::Util::PathName(MIKTEX_PATH_MIKTEX_CACHE_DIR) / MiKTeX::Util::PathName("t4ht");
+}
+
+/* Contribute a conversion script command to the cache key of the
+   next picture. */
+static void miktex_picture_key(const char* command)
+{
+  if (miktexPictureJobs.maxJobs > 0)
+  {
+    miktexPictureJobs.keyBuilder.Update(command, strlen(command) + 1);
+  }
+}
+
+/* Job names (%%4) for the dvigif scripts.  They name temporary files:
+   concurrent jobs need names of their own. */
+static const char* miktex_picture_job_name(const char* jobName)
+{
+  if (miktexPictureJobs.maxJobs <= 1)
+  {
+    return jobName;
+  }
+  miktexPictureJobs.jobName = std::string(jobName) + "-" + std::to_string(miktexPictureJobs.jobs.size());
+  return miktexPictureJobs.jobName.c_str();
+}
+
+/* Start collecting the commands for a picture. Returns true, if the
+   picture has been restored from the cache: it needs not be
+   converted. */
+static bool miktex_begin_picture(const char* idvFileName, long pageNumber, const char* destination)
+{
+  if (miktexPictureJobs.maxJobs == 0)
+  {
+    return false;
+  }
+  miktexPictureJobs.inPicture = true;
+  miktexPictureJobs.current = MiKTeXPictureJob();
+  miktexPictureJobs.current.destination = destination;
+  MiKTeX::Core::MD5Builder& keyBuilder = miktexPictureJobs.keyBuilder;
+  if (!miktex_load_idv(idvFileName))
+  {
+    return false;
+  }
+  for (const MiKTeXIdvPage& page : miktexPictureJobs.idvPages)
+  {
+    if (page.number != pageNumber)
+    {
+      continue;
+    }
+    // the page, without the bop parameters
+    keyBuilder.Update(&miktexPictureJobs.idv[page.begin + 45], page.end - page.begin - 45);
+    keyBuilder.Update(miktexPictureJobs.idvFontsDigest.data(), miktexPictureJobs.idvFontsDigest.size());
+    std::string extension = miktexPictureJobs.current.destination.GetExtension();
+    miktexPictureJobs.current.cacheFile = miktex_picture_cache_directory() / MiKTeX::Util::PathName(keyBuilder.Final().ToString() + extension);
+    break;
+  }
+  if (miktexPictureJobs.current.cacheFile.Empty() || !MiKTeX::Core::File::Exists(miktexPictureJobs.current.cacheFile))
+  {
+    return false;
+  }
+  try
+  {
+    MiKTeX::Core::File::Copy(miktexPictureJobs.current.cacheFile, miktexPictureJobs.current.destination);
+  }
+  catch (const MiKTeX::Core::MiKTeXException&)
+  {
+    return false;
+  }
+  miktexPictureJobs.current.output = miktexPictureJobs.current.destination.ToString() + " restored from the picture cache\n";
+  miktexPictureJobs.current.cacheFile = MiKTeX::Util::PathName();
+  return true;
+}
+
+/* Collect a command of the current picture.  Returns false, if there is
+   no current picture: the command must be run right away. */
+static bool miktex_queue_picture_command(const char* command)
+{
+  if (!miktexPictureJobs.inPicture)
+  {
+    return false;
+  }
+  miktexPictureJobs.current.commands.push_back(command);
+  return true;
+}
+
+/* The commands collected so far convert the picture: it can be cached
+   when they have succeeded. */
+static void miktex_picture_converted()
+{
+  if (miktexPictureJobs.inPicture)
+  {
+    miktexPictureJobs.current.conversionCommands = miktexPictureJobs.current.commands.size();
+  }
+}
+
+static void miktex_end_picture()
+{
+  if (!miktexPictureJobs.inPicture)
+  {
+    return;
+  }
+  miktexPictureJobs.jobs.push_back(std::move(miktexPictureJobs.current));
+  miktexPictureJobs.inPicture = false;
+  miktexPictureJobs.keyBuilder.Init();
+}
+
+static void miktex_store_picture(const MiKTeXPictureJob& job, std::size_t idx)
+{
+  if (job.cacheFile.Empty() || !MiKTeX::Core::File::Exists(job.destination))
+  {
+    return;
+  }
+  try
+  {
+    // another t4ht may store the same picture at the same time
+    MiKTeX::Util::PathName tmpFile = job.cacheFile;
+    tmpFile.AppendExtension(".tmp" + std::to_string(MiKTeX::Core::Process::GetCurrentProcess()->GetSystemId()) + "-" + std::to_string(idx));
+    MiKTeX::Core::Directory::Create(job.cacheFile.GetDirectoryName());
+    MiKTeX::Core::File::Copy(job.destination, tmpFile);
+    MiKTeX::Core::File::Move(tmpFile, job.cacheFile, { MiKTeX::Core::FileMoveOption::ReplaceExisting });
+  }
+  catch (const MiKTeX::Core::MiKTeXException&)
+  {
+  }
+}
+
+static void miktex_run_picture_job(MiKTeXPictureJob& job, std::size_t idx, bool alwaysCallSys)
+{
+  bool failed = false;
+  for (std::size_t cmd = 0; cmd < job.commands.size() && !failed; ++cmd)
+  {
+    const std::string& command = job.commands[cmd];
+    job.output += "System call: " + command + "\n";
+    int ret;
+    try
+    {
+      MiKTeXPictureOutput callback(job.output);
+      int exitCode;
+      ret = MiKTeX::Core::Process::ExecuteSystemCommand(command, &exitCode, &callback, nullptr) ? exitCode : -1;
+    }
+    catch (const std::exception& e)
+    {
+      job.output += std::string(e.what()) + "\n";
+      ret = -1;
+    }
+    job.output += std::string(ret != 0 ? "--- Warning --- " : "") + "System return: " + std::to_string(ret) + "\n";
+    failed = ret != 0 && !alwaysCallSys;
+    if (ret == 0 && cmd + 1 == job.conversionCommands)
+    {
+      miktex_store_picture(job, idx);
+    }
+  }
+}
+
+/* Run the collected picture jobs, at most -j at a time.  The output of
+   the jobs is printed in picture order. */
+static void miktex_run_picture_jobs(bool alwaysCallSys)
+{
+  std::vector<MiKTeXPictureJob>& jobs = miktexPictureJobs.jobs;
+  if (jobs.empty())
+  {
+    return;
+  }
+  std::atomic<std::size_t> nextJob(0);
+  auto worker = [&]()
+  {
+    for (std::size_t idx = nextJob++; idx < jobs.size(); idx = nextJob++)
+    {
+      miktex_run_picture_job(jobs[idx], idx, alwaysCallSys);
+    }
+  };
+  std::size_t numThreads = std::min<std::size_t>(jobs.size(), miktexPictureJobs.maxJobs);
+  std::vector<std::thread> threads;
+  for (std::size_t idx = 1; idx < numThreads; ++idx)
+  {
+    threads.push_back(std::thread(worker));
+  }
+  worker();
+  for (std::thread& t : threads)
+  {
+    t.join();
+  }
+  for (const MiKTeXPictureJob& job : jobs)
+  {
+    fputs(job.output.c_str(), stdout);
+  }
+  jobs.clear();
+}
@@ -112,6 +112,10 @@
 #endif
 #if defined(MIKTEX)
 # include <miktex/tex4ht.h>
+# include <miktex/t4ht.h>
+# define PICTURE_JOB_NAME miktex_picture_job_name(job_name)
+#else
+# define PICTURE_JOB_NAME job_name
 #endif
 
 #ifdef KPATHSEA
@@ -459,6 +463,9 @@ static const C_CHAR *warn_err_mssg[]={
 "  -d...  directory for output files       (default:  current)\n"
 "  -e...  location of tex4ht.env\n"
 "  -i     debugging info\n"
+#if defined(MIKTEX)
+"  -j...  convert ... pictures at a time, cache converted pictures\n"
+#endif
 "  -g     ignore errors in system calls\n"
 "  -m...  chmod ... of new output files (reused bitmaps excluded)\n"
 "  -p     don't convert pictures           (default:  convert)\n"
@@ -648,6 +655,23 @@ static char *  abs_addr
 
 
 
+#if defined(MIKTEX)
+static BOOL begin_picture(
+                    struct script_struct* script,
+                    const Q_CHAR * idv,
+                    long int page,
+                    const Q_CHAR * picture
+)
+{
+   while( script ){
+      miktex_picture_key(script->command);
+      script = script->next;
+   }
+   return miktex_begin_picture(idv, page, picture);
+}
+#endif
+
+
 static void execute_script
 #ifdef ANSI
 #define SEP ,
@@ -1188,6 +1212,11 @@ static void call_sys
 #endif
 {
    if( *command ){
+#if defined(MIKTEX)
+      if( system_yes && miktex_queue_picture_command(command) ){
+         system_return = 0;  return;
+      }
+#endif
       (IGNORED) printf("System call: %s\n", command);
 #if defined(MIKTEX)
       system_return = system_yes ? miktex_system(command) : -1;
@@ -1668,6 +1697,9 @@ lg_name++;
 
  break; }
   case 'i':{ debug = q-1;  break;}
+#if defined(MIKTEX)
+  case 'j':{ miktex_set_picture_jobs(atoi(q));  break;}
+#endif
   case 'g':{ always_call_sys = TRUE;  break;}
   case 'm':{ ch_mod = q;  break; }
   case 'p':{ nopict = q-1;  break;}
@@ -2631,8 +2663,16 @@ if( !file || noreuse ){
 filtered_dvigif_script = dvigif_glyp_script?
    filterGifScript(dvigif_glyp_script, match[3]):
    filterGifScript(dvigif_script, match[3]);
+#if defined(MIKTEX)
+if( begin_picture(filtered_dvigif_script, match[1], gif_i, match[3]) ){
+   system_return = 0;
+} else
+#endif
 (void) execute_script(
-    filtered_dvigif_script,match[1],match[2],match[3],job_name);
+    filtered_dvigif_script,match[1],match[2],match[3],PICTURE_JOB_NAME);
+#if defined(MIKTEX)
+miktex_picture_converted();
+#endif
 (void) free_script( filtered_dvigif_script );
 if( dir && !bitmaps_no_dm && !system_return ){
   (void) execute_script(move_script,match[3],dir,".","");
@@ -2643,6 +2683,9 @@ if( ch_mod && !bitmaps_no_dm && !system_return ){
 
 
 }
+#if defined(MIKTEX)
+miktex_end_picture();
+#endif
 
 
 } else {
@@ -2680,8 +2723,16 @@ empty_pic = empty_pic->next;
 if( !nopict && !skip ){
    
 filtered_dvigif_script = filterGifScript(dvigif_script, match[3]);
+#if defined(MIKTEX)
+if( begin_picture(filtered_dvigif_script, match[1], gif_i, match[3]) ){
+   system_return = 0;
+} else
+#endif
 (void) execute_script(
-  filtered_dvigif_script,match[1],match[2],match[3],job_name);
+  filtered_dvigif_script,match[1],match[2],match[3],PICTURE_JOB_NAME);
+#if defined(MIKTEX)
+miktex_picture_converted();
+#endif
 (void) free_script( filtered_dvigif_script );
 if( dir && !bitmaps_no_dm && !system_return ){
   (void) execute_script(move_script,match[3],dir,".","");
@@ -2689,6 +2740,9 @@ if( dir && !bitmaps_no_dm && !system_return ){
 if( ch_mod && !bitmaps_no_dm && !system_return ){
   (void) execute_script(chmod_script, ch_mod, dir?dir:"",match[3], "");
 }
+#if defined(MIKTEX)
+miktex_end_picture();
+#endif
 
 
 }
@@ -2719,7 +2773,11 @@ if( status ){
  }
       }
       if ( eoln_ch == EOF ){ break; }
-}  }
+}
+#if defined(MIKTEX)
+   miktex_run_picture_jobs(always_call_sys);
+#endif
+}
 
 
    
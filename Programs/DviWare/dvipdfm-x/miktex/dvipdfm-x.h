@@ -21,8 +21,10 @@
 
 #if defined(__cplusplus)
 #include <cstdarg>
+#include <cstddef>
 #else
 #include <stdarg.h>
+#include <stddef.h>
 #endif
 
 #if defined(__cplusplus)
@@ -33,6 +35,8 @@ void miktex_log_error_va(const char* format, va_list args);
 void miktex_log_info_va(const char* format, va_list args);
 void miktex_log_warn_va(const char* format, va_list args);
 void miktex_read_config_files();
+int miktex_get_cache_directory(const char* name, char* buf, size_t bufSize);
+void miktex_parallel_for(int count, void (*work)(void* data, int idx), void* data);
 
 #if defined(__cplusplus)
 }
@@ -21,16 +21,22 @@
 
 #include <miktex/App/Application>
 #include <miktex/Util/PathName>
+#include <miktex/Core/Directory>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Session>
 #include <miktex/Util/StringUtil>
 
 using namespace MiKTeX::App;
+using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
 using namespace MiKTeX::Util;
 using namespace std;
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <thread>
+#include <vector>
 
 extern "C"
 {
@@ -108,3 +114,59 @@ extern "C" void miktex_read_config_files()
     }
   }
 }
+
+extern "C" int miktex_get_cache_directory(const char* name, char* buf, size_t bufSize)
+{
+  try
+  {
+    shared_ptr<Session> session = MIKTEX_SESSION();
+    PathName cacheDir = session->GetSpecialPath(session->IsAdminMode() ? SpecialPath::CommonDataRoot : SpecialPath::UserDataRoot) / PathName(MIKTEX_PATH_MIKTEX_CACHE_DIR) / PathName(name);
+    Directory::Create(cacheDir);
+    string path = cacheDir.ConvertToUnix().ToString();
+    if (path.length() >= bufSize)
+    {
+      return 0;
+    }
+    StringUtil::CopyString(buf, bufSize, path.c_str());
+    return 1;
+  }
+  catch (const MiKTeXException&)
+  {
+    // not fatal: nothing will be cached
+    return 0;
+  }
+}
+
+// calls work(data, idx) for idx = 0..count-1 on as many threads as
+// there are processors; work must not touch global state
+extern "C" void miktex_parallel_for(int count, void (*work)(void* data, int idx), void* data)
+{
+  int numThreads = std::min<int>(std::max<unsigned>(thread::hardware_concurrency(), 1), count);
+  if (numThreads <= 1)
+  {
+    for (int idx = 0; idx < count; ++idx)
+    {
+      work(data, idx);
+    }
+    return;
+  }
+  atomic<int> next(0);
+  auto worker = [&next, count, work, data]()
+  {
+    int idx;
+    while ((idx = next++) < count)
+    {
+      work(data, idx);
+    }
+  };
+  vector<thread> threads;
+  for (int n = 1; n < numThreads; ++n)
+  {
+    threads.push_back(thread(worker));
+  }
+  worker();
+  for (thread& t : threads)
+  {
+    t.join();
+  }
+}
@@ -170,7 +170,7 @@ bmp_include_image (pdf_ximage *ximage, FILE *fp)
   }
 
   /* Start reading raster data */
-  stream      = pdf_new_stream(STREAM_COMPRESS);
+  stream      = pdf_new_stream(STREAM_COMPRESS | STREAM_CACHE_ENCODED);
   stream_dict = pdf_stream_dict(stream);
 
   /* Color space: Indexed or DeviceRGB */
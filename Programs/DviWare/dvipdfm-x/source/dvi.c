@@ -2335,6 +2335,10 @@ dvi_init (char *dvi_filename, double mag)
     int ch;
 #ifdef WIN32
         setmode(fileno(stdin), _O_BINARY);
+#endif
+#if defined(MIKTEX)
+    /* read the pipe in large chunks */
+    setvbuf(stdin, NULL, _IOFBF, 1024 * 1024);
 #endif
     dvi_file = stdin;
     linear = 1;
@@ -56,6 +56,7 @@
 
 #include "fontmap.h"
 #include "pdffont.h"
+#include "type1.h"
 #include "pdfximage.h"
 #include "cid.h"
 
@@ -101,6 +102,8 @@ static double annot_grow_y      = 0.0;
 static int    bookmark_open     = 0;
 static double mag               = 1.0;
 static int    enable_thumbnail  = 0;
+/* Write pages as soon as they are finished */
+static int    flush_pages       = 0;
 
 static int    font_dpi          = 600;
 
@@ -215,6 +218,7 @@ show_usage (void)
   printf ("  --dvipdfm\tEnable DVIPDFM emulation mode\n");
   printf ("  -d number\tSet PDF decimal digits (0-5) [3]\n");
   printf ("  -f filename\tLoad additional font map filename[.map]\n");
+  printf ("  --flush-pages\tWrite each page as soon as it is finished\n");
   printf ("  -g dimension\tAnnotation \"grow\" amount [0.0in]\n");
   printf ("  -h | --help \tShow this help message and exit\n");
   printf ("  -i cfgfile\tRead additional configuration file\t\n");
@@ -445,6 +449,7 @@ static struct option long_options[] = {
   {"mvorigin", 0, 0, 1000},
   {"kpathsea-debug", 1, 0, 133},
   {"pdfm-str-utf8", 0, 0, 134},
+  {"flush-pages", 0, 0, 135},
   {0, 0, 0, 0}
 };
 
@@ -483,6 +488,10 @@ do_args_first_pass (int argc, char *argv[], const char *source, int unsafe)
       dpx_conf.pdfm_str_utf8 = 1;
       break;
 
+    case 135: /* --flush-pages */
+      flush_pages = 1;
+      break;
+
     case 1000: /* --mvorigin */
       translate_origin = 1;
       break;
@@ -548,7 +557,7 @@ do_args_second_pass (int argc, char *argv[], const char *source, int unsafe)
   optind = 1;
   while ((c = getopt_long(argc, argv, optstrig, long_options, NULL)) != -1) {
     switch(c) {
-    case 'h': case 130: case 131: case 132: case 133: case 134: case 1000: case 'q': case 'v': case 'M': /* already done */
+    case 'h': case 130: case 131: case 132: case 133: case 134: case 135: case 1000: case 'q': case 'v': case 'M': /* already done */
       break;
 
     /* 'm' option handled in first_pass */
@@ -1209,6 +1218,18 @@ main (int argc, char *argv[])
   /* moved to here because image caching was not effective */
   dpx_delete_old_cache(image_cache_life);
 
+#if defined(MIKTEX)
+  /* encoded image streams and converted Type 1 glyphs are kept across runs */
+  {
+    char cache_dir[PATH_MAX + 1];
+
+    if (miktex_get_cache_directory("dvipdfmx", cache_dir, sizeof(cache_dir))) {
+      pdf_set_stream_cache_dir(cache_dir);
+      pdf_font_set_type1_cache_dir(cache_dir);
+    }
+  }
+#endif
+
   MESG("%s -> %s\n", dvi_filename ? dvi_filename : "stdin",
                      pdf_filename ? pdf_filename : "stdout");
 
@@ -1272,6 +1293,7 @@ main (int argc, char *argv[])
   settings.outline_open_depth  = bookmark_open;
   settings.check_gotos         = !(opt_flags & OPT_PDFDOC_NO_DEST_REMOVE);
   settings.enable_manual_thumb = enable_thumbnail;
+  settings.enable_page_flush   = flush_pages;
 
   /* PDF page output settings */
   settings.device.dvi2pts     = dvi2pts;
@@ -643,6 +643,28 @@ fontmap_parse_mapdef_dps (fontmap_rec *mrec,
 
 static struct ht_table *fontmap = NULL;
 
+#if defined(MIKTEX)
+/* Font map files with an up-to-date index (written by MiKTeX's font map
+ * configuration) are not parsed when they are loaded. The records of a
+ * font are read from the indexes when the font is first looked up or
+ * changed, in the order in which the font map files were loaded.
+ */
+struct indexed_fontmap
+{
+  char *filename;
+  int   mode;
+};
+
+static struct indexed_fontmap *indexed_fontmaps = NULL;
+static int    num_indexed_fontmaps = 0, max_indexed_fontmaps = 0;
+
+/* Font names whose records have been read from the indexes */
+static struct ht_table *indexed_keys = NULL;
+static int    indexed_key_seen = 1;
+
+static void load_indexed_records (const char *kp);
+#endif
+
 #define fontmap_invalid(m) (!(m) || !(m)->map_name || !(m)->font_name)
 static char *
 chop_sfd_name (const char *tex_name, char **sfd_name)
@@ -729,6 +751,10 @@ pdf_append_fontmap_record (const char *kp, const fontmap_rec *vp)
   if (dpx_conf.verbose_level > 3)
     MESG("fontmap>> append key=\"%s\"...", kp);
 
+#if defined(MIKTEX)
+  load_indexed_records(kp);
+#endif
+
   fnt_name = chop_sfd_name(kp, &sfd_name);
   if (fnt_name && sfd_name) {
     char  *tfm_name;
@@ -741,6 +767,9 @@ pdf_append_fontmap_record (const char *kp, const fontmap_rec *vp)
       tfm_name = make_subfont_name(kp, sfd_name, subfont_ids[n]);
       if (!tfm_name)
         continue;
+#if defined(MIKTEX)
+      load_indexed_records(tfm_name);
+#endif
       mrec = ht_lookup_table(fontmap, tfm_name, strlen(tfm_name));
       if (!mrec) {
         mrec = NEW(1, fontmap_rec);
@@ -783,6 +812,10 @@ pdf_remove_fontmap_record (const char *kp)
   if (dpx_conf.verbose_level > 3)
     MESG("fontmap>> remove key=\"%s\"...", kp);
 
+#if defined(MIKTEX)
+  load_indexed_records(kp);
+#endif
+
   fnt_name = chop_sfd_name(kp, &sfd_name);
   if (fnt_name && sfd_name) {
     char  *tfm_name;
@@ -797,6 +830,9 @@ pdf_remove_fontmap_record (const char *kp)
       tfm_name = make_subfont_name(kp, sfd_name, subfont_ids[n]);
       if (!tfm_name)
         continue;
+#if defined(MIKTEX)
+      load_indexed_records(tfm_name);
+#endif
       if (dpx_conf.verbose_level > 3)
         MESG(" %s", tfm_name);
       ht_remove_table(fontmap, tfm_name, strlen(tfm_name));
@@ -828,6 +864,10 @@ pdf_insert_fontmap_record (const char *kp, const fontmap_rec *vp)
   if (dpx_conf.verbose_level > 3)
     MESG("fontmap>> insert key=\"%s\"...", kp);
 
+#if defined(MIKTEX)
+  load_indexed_records(kp);
+#endif
+
   fnt_name = chop_sfd_name(kp, &sfd_name);
   if (fnt_name && sfd_name) {
     char  *tfm_name;
@@ -846,6 +886,9 @@ pdf_insert_fontmap_record (const char *kp, const fontmap_rec *vp)
       tfm_name = make_subfont_name(kp, sfd_name, subfont_ids[n]);
       if (!tfm_name)
         continue;
+#if defined(MIKTEX)
+      load_indexed_records(tfm_name);
+#endif
       if (dpx_conf.verbose_level > 3)
         MESG(" %s", tfm_name);
       mrec = NEW(1, fontmap_rec);
@@ -957,6 +1000,87 @@ is_pdfm_mapline (const char *mline) /* NULL terminated. */
   return (n == 2 ? 0 : 1);
 }
 
+#if defined(MIKTEX)
+static void
+load_indexed_records (const char *kp)
+{
+  int i;
+
+  if (num_indexed_fontmaps == 0 ||
+      ht_lookup_table(indexed_keys, kp, strlen(kp)))
+    return;
+  ht_insert_table(indexed_keys, kp, strlen(kp), &indexed_key_seen);
+
+  for (i = 0; i < num_indexed_fontmaps; i++) {
+    char *lines = NULL, *p, *next;
+
+    if (miktex_kpsemu_lookup_font_map(indexed_fontmaps[i].filename,
+                                      kp, &lines) != 1)
+      continue;
+    for (p = lines; p; p = next) {
+      fontmap_rec *mrec;
+      int          llen;
+
+      next = strchr(p, '\n');
+      if (next)
+        *next++ = '\0';
+      llen = strlen(p);
+
+      mrec = NEW(1, fontmap_rec);
+      pdf_init_fontmap_record(mrec);
+      /* The format is decided per line here, not per file */
+      if (pdf_read_fontmap_line(mrec, p, llen, is_pdfm_mapline(p))) {
+        WARN("Invalid map record for \"%s\" in %s.",
+             kp, indexed_fontmaps[i].filename);
+        WARN("-- Ignore the current input buffer: %s", p);
+      } else {
+        switch (indexed_fontmaps[i].mode) {
+        case FONTMAP_RMODE_REPLACE:
+          pdf_insert_fontmap_record(mrec->map_name, mrec);
+          break;
+        case FONTMAP_RMODE_APPEND:
+          pdf_append_fontmap_record(mrec->map_name, mrec);
+          break;
+        case FONTMAP_RMODE_REMOVE:
+          pdf_remove_fontmap_record(mrec->map_name);
+          break;
+        }
+      }
+      pdf_clear_fontmap_record(mrec);
+      RELEASE(mrec);
+    }
+    free(lines);
+  }
+}
+
+static int
+add_indexed_fontmap (const char *filename, int mode)
+{
+  char *lines = NULL;
+
+  /* Any lookup tells whether there is an up-to-date index */
+  if (miktex_kpsemu_lookup_font_map(filename, "", &lines) < 0)
+    return 0;
+  if (lines)
+    free(lines);
+
+  if (num_indexed_fontmaps >= max_indexed_fontmaps) {
+    max_indexed_fontmaps += 4;
+    indexed_fontmaps = RENEW(indexed_fontmaps, max_indexed_fontmaps,
+                             struct indexed_fontmap);
+  }
+  indexed_fontmaps[num_indexed_fontmaps].filename = mstrdup(filename);
+  indexed_fontmaps[num_indexed_fontmaps].mode     = mode;
+  num_indexed_fontmaps++;
+  if (!indexed_keys) {
+    indexed_keys = NEW(1, struct ht_table);
+    ht_init_table(indexed_keys, NULL);
+  }
+
+  return 1;
+}
+#endif
+
 int
 pdf_load_fontmap_file (const char *filename, int mode)
 {
@@ -971,6 +1095,13 @@ pdf_load_fontmap_file (const char *filename, int mode)
 
   if (dpx_conf.verbose_level > 0)
     MESG("<FONTMAP:");
+#if defined(MIKTEX)
+  if (add_indexed_fontmap(filename, mode)) {
+    if (dpx_conf.verbose_level > 0)
+      MESG("%s (indexed)>", filename);
+    return  0;
+  }
+#endif
   fp = DPXFOPEN(filename, DPX_RES_TYPE_FONTMAP); /* outputs path if verbose */
   if (!fp) {
     WARN("Couldn't open font map file \"%s\".", filename);
@@ -1138,6 +1269,10 @@ pdf_lookup_fontmap_record (const char *tfm_name)
 {
   fontmap_rec *mrec = NULL;
 
+#if defined(MIKTEX)
+  if (fontmap && tfm_name)
+    load_indexed_records(tfm_name);
+#endif
   if (fontmap && tfm_name)
     mrec = ht_lookup_table(fontmap, tfm_name, strlen(tfm_name));
 
@@ -1160,6 +1295,19 @@ pdf_close_fontmaps (void)
     RELEASE(fontmap);
   }
   fontmap = NULL;
+#if defined(MIKTEX)
+  while (num_indexed_fontmaps > 0)
+    RELEASE(indexed_fontmaps[--num_indexed_fontmaps].filename);
+  if (indexed_fontmaps)
+    RELEASE(indexed_fontmaps);
+  indexed_fontmaps = NULL;
+  max_indexed_fontmaps = 0;
+  if (indexed_keys) {
+    ht_clear_table(indexed_keys);
+    RELEASE(indexed_keys);
+  }
+  indexed_keys = NULL;
+#endif
 
   release_sfd_record();
 }
@@ -199,6 +199,13 @@ typedef struct pdf_doc
     int       num_entries; /* This is not actually total number of pages. */
     int       max_entries;
     pdf_page *entries;
+
+    /* Pages are written as soon as they are finished. They are collected
+     * in page tree nodes below the root node instead of a balanced tree.
+     */
+    int       flush;
+    pdf_obj  *leaf, *leaf_ref;
+    pdf_obj  *leaves;
   } pages;
 
   struct {
@@ -716,6 +723,54 @@ build_page_tree (pdf_doc  *p,
   return self;
 }
 
+/* Number of pages per page tree node when pages are written early */
+#define PAGE_LEAF_SIZE 64
+static void
+doc_close_page_leaf (pdf_doc *p)
+{
+  pdf_obj *kids;
+
+  if (!p->pages.leaf)
+    return;
+
+  kids = pdf_lookup_dict(p->pages.leaf, "Kids");
+  pdf_add_dict(p->pages.leaf, pdf_new_name("Count"),
+               pdf_new_number((double) pdf_array_length(kids)));
+  pdf_release_obj(p->pages.leaf);
+  pdf_release_obj(p->pages.leaf_ref);
+  p->pages.leaf     = NULL;
+  p->pages.leaf_ref = NULL;
+}
+
+static void
+doc_write_page (pdf_doc *p, pdf_page *page)
+{
+  pdf_obj *kids, *page_ref;
+
+  if (!p->pages.leaf) {
+    p->pages.leaf     = pdf_new_dict();
+    p->pages.leaf_ref = pdf_ref_obj(p->pages.leaf);
+    pdf_add_dict(p->pages.leaf, pdf_new_name("Type"), pdf_new_name("Pages"));
+    pdf_add_dict(p->pages.leaf,
+                 pdf_new_name("Parent"), pdf_ref_obj(p->root.pages));
+    pdf_add_dict(p->pages.leaf, pdf_new_name("Kids"), pdf_new_array());
+    pdf_add_array(p->pages.leaves, pdf_link_obj(p->pages.leaf_ref));
+  }
+
+  if (!page->page_ref)
+    page->page_ref = pdf_ref_obj(page->page_obj);
+  kids = pdf_lookup_dict(p->pages.leaf, "Kids");
+  pdf_add_array(kids, pdf_link_obj(page->page_ref));
+
+  /* Keep the reference for links to this page. */
+  page_ref = pdf_link_obj(page->page_ref);
+  doc_flush_page(p, page, pdf_link_obj(p->pages.leaf_ref));
+  page->page_ref = page_ref;
+
+  if (pdf_array_length(kids) >= PAGE_LEAF_SIZE)
+    doc_close_page_leaf(p);
+}
+
 static void
 pdf_doc_init_page_tree (pdf_doc *p, double media_width, double media_height)
 {
@@ -733,6 +788,10 @@ pdf_doc_init_page_tree (pdf_doc *p, double media_width, double media_height)
   p->pages.bop = NULL;
   p->pages.eop = NULL;
 
+  p->pages.leaf     = NULL;
+  p->pages.leaf_ref = NULL;
+  p->pages.leaves   = p->pages.flush ? pdf_new_array() : NULL;
+
   p->pages.mediabox.llx = 0.0;
   p->pages.mediabox.lly = 0.0;
   p->pages.mediabox.urx = media_width;
@@ -784,9 +843,32 @@ pdf_doc_close_page_tree (pdf_doc *p)
   /*
    * Connect page tree to root node.
    */
-  page_tree_root = build_page_tree(p, FIRSTPAGE(p), PAGECOUNT(p), NULL);
-  pdf_merge_dict (p->root.pages, page_tree_root);
-  pdf_release_obj(page_tree_root);
+  if (p->pages.flush) {
+    doc_close_page_leaf(p);
+    pdf_add_dict(p->root.pages, pdf_new_name("Type"), pdf_new_name("Pages"));
+    pdf_add_dict(p->root.pages,
+                 pdf_new_name("Count"), pdf_new_number((double) PAGECOUNT(p)));
+    pdf_add_dict(p->root.pages, pdf_new_name("Kids"), p->pages.leaves);
+    p->pages.leaves = NULL;
+    for (page_no = 1; page_no <= PAGECOUNT(p); page_no++) {
+      pdf_page *page;
+
+      page = doc_get_page_entry(p, page_no);
+      if (page->beads) {
+        /* /B is optional; the beads themselves are intact. */
+        pdf_release_obj(page->beads);
+        page->beads = NULL;
+      }
+      if (page->page_ref) {
+        pdf_release_obj(page->page_ref);
+        page->page_ref = NULL;
+      }
+    }
+  } else {
+    page_tree_root = build_page_tree(p, FIRSTPAGE(p), PAGECOUNT(p), NULL);
+    pdf_merge_dict (p->root.pages, page_tree_root);
+    pdf_release_obj(page_tree_root);
+  }
 
   /* They must be after build_page_tree() */
   if (p->pages.bop) {
@@ -1788,6 +1870,11 @@ pdf_doc_add_annot (unsigned page_no, const pdf_rect *rect,
   pdf_page *page;
   pdf_obj  *rect_array;
 
+  if (p->pages.flush && page_no <= PAGECOUNT(p)) {
+    WARN("Annotation attached to page #%u, which has been written already.", page_no);
+    return;
+  }
+
   page = doc_get_page_entry(p, page_no);
   if (!page->annots)
     page->annots = pdf_new_array();
@@ -2230,7 +2317,8 @@ pdf_doc_ref_page (unsigned page_no)
   pdf_page *page;
 
   page = doc_get_page_entry(p, page_no);
-  if (!page->page_obj) {
+  /* The page object may have been written already. */
+  if (!page->page_ref) {
     page->page_obj = pdf_new_dict();
     page->page_ref = pdf_ref_obj(page->page_obj);
   }
@@ -2392,6 +2480,9 @@ pdf_doc_finish_page (pdf_doc *p)
       pdf_add_dict(currentpage->page_obj, pdf_new_name("Thumb"), thumb_ref);
   }
 
+  if (p->pages.flush)
+    doc_write_page(p, currentpage);
+
   p->pages.num_entries++;
 
   return;
@@ -2513,6 +2604,8 @@ pdf_open_document (const char *filename,
                         1, 1);
   }
 
+  p->pages.flush = settings.enable_page_flush;
+
   p->options.annot_grow.x = settings.annot_grow_amount.x;
   p->options.annot_grow.y = settings.annot_grow_amount.y;
   p->options.outline_open_depth = settings.outline_open_depth;
@@ -68,6 +68,7 @@ struct pdf_setting
     int    outline_open_depth;
     int    check_gotos;
     int    enable_manual_thumb;
+    int    enable_page_flush;
     int    enable_encrypt;
     struct pdf_enc_setting encrypt;
     struct pdf_dev_setting device;
@@ -486,6 +486,9 @@ pdf_close_fonts (void)
 {
   int  font_id;
 
+  /* Font programs are compressed together when the fonts are done. */
+  pdf_defer_output();
+
   for (font_id = 0; font_id < font_cache.count; font_id++) {
     pdf_font  *font;
 
@@ -637,6 +640,8 @@ pdf_close_fonts (void)
     pdf_clean_font_struct(font);
   }
 
+  pdf_complete_deferred_output();
+
   RELEASE(font_cache.fonts);
   font_cache.fonts    = NULL;
   font_cache.count    = 0;
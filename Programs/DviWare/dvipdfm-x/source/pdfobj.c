@@ -38,6 +38,7 @@
 
 #include "pdflimits.h"
 #include "pdfencrypt.h"
+#include "dpxcrypt.h"
 #include "pdfparse.h"
 
 #ifdef HAVE_ZLIB
@@ -47,6 +48,10 @@
 #include "pdfobj.h"
 #include "pdfdev.h"
 
+#if defined(MIKTEX)
+#include <miktex/dvipdfm-x.h>
+#endif
+
 #define STREAM_ALLOC_SIZE      4096u
 #define ARRAY_ALLOC_SIZE       256
 #define IND_OBJECTS_ALLOC_SIZE 512
@@ -142,6 +147,9 @@ struct pdf_stream
   size_t              max_length;
   int32_t             _flags;
   struct decode_parms decodeparms;
+  unsigned char      *deflated;       /* compressed in advance, see
+                                       * pdf_complete_deferred_output() */
+  size_t              deflated_length;
 };
 
 struct pdf_indirect
@@ -237,6 +245,15 @@ struct pdf_out {
    * Appendix C, "Implementation Limits". 
    */
   char         *free_list;
+
+  /* Labeled objects released while output is deferred. They are
+   * written in this order by pdf_complete_deferred_output(). */
+  struct {
+    int         active;
+    pdf_obj   **objects;
+    size_t      count;
+    size_t      max_count;
+  } deferred;
 };
 
 #if defined(LIBDPX)
@@ -293,6 +310,11 @@ init_pdf_out_struct (pdf_out *p)
 
   p->free_list = NEW((PDF_NUM_INDIRECT_MAX+1)/8, char);
   memset(p->free_list, 0, (PDF_NUM_INDIRECT_MAX+1)/8);
+
+  p->deferred.active    = 0;
+  p->deferred.objects   = NULL;
+  p->deferred.count     = 0;
+  p->deferred.max_count = 0;
 }
 
 static void
@@ -300,6 +322,8 @@ clean_pdf_out_struct (pdf_out *p)
 {
   if (p->free_list)
     RELEASE(p->free_list);
+  if (p->deferred.objects)
+    RELEASE(p->deferred.objects);
   memset(p, 0, sizeof(pdf_out));
 }
 
@@ -308,6 +332,7 @@ clean_pdf_out_struct (pdf_out *p)
 static int      check_for_pdf_version (FILE *file);
 
 static void     pdf_flush_obj (pdf_out *p, pdf_obj *object);
+static void     release_obj_data (pdf_obj *object);
 static void     pdf_label_obj (pdf_out *p, pdf_obj *object);
 static void     pdf_write_obj (pdf_out *p, pdf_obj *object);
 
@@ -1878,6 +1903,8 @@ pdf_new_stream (int flags)
   data->stream_length = 0;
   data->max_length    = 0;
   data->objstm_data = NULL;
+  data->deflated = NULL;
+  data->deflated_length = 0;
 
   data->decodeparms.predictor = 2;
   data->decodeparms.columns   = 0;
@@ -2179,6 +2206,140 @@ filter_create_predictor_dict (int predictor, int32_t columns,
   return  parms;
 }
 
+/* Cache of compressed streams
+ *
+ * Streams flagged STREAM_CACHE_ENCODED (decoded image data) are looked up
+ * in the cache directory before they are compressed, so that a figure
+ * included again in a later run is not encoded again. The file name is
+ * the MD5 digest of the uncompressed data and of the encoding parameters.
+ * A cache file holds a signature, the length of the compressed data, a
+ * flag telling whether the predictor was applied, and the data.
+ */
+static char *stream_cache_dir = NULL;
+
+#define STREAM_CACHE_SIGNATURE "dpxz0001"
+
+void
+pdf_set_stream_cache_dir (const char *dirname)
+{
+  if (stream_cache_dir)
+    RELEASE(stream_cache_dir);
+  stream_cache_dir = NULL;
+  if (dirname) {
+    stream_cache_dir = NEW(strlen(dirname)+1, char);
+    strcpy(stream_cache_dir, dirname);
+  }
+}
+
+static char *
+stream_cache_file (pdf_out *p, pdf_stream *stream, int use_predictor)
+{
+  MD5_CONTEXT    md5;
+  unsigned char  digest[16];
+  char           params[256], *filename, *s;
+  size_t         pos;
+  int            i;
+
+#ifdef HAVE_ZLIB
+  sprintf(params, "zlib %s level %d",
+          zlibVersion(), p->options.compression.level);
+#else
+  sprintf(params, "level %d", p->options.compression.level);
+#endif
+  if (use_predictor)
+    sprintf(params + strlen(params), " predictor %d %d %d %d",
+            stream->decodeparms.predictor, stream->decodeparms.columns,
+            stream->decodeparms.bits_per_component,
+            stream->decodeparms.colors);
+
+  MD5_init(&md5);
+  MD5_write(&md5, (const unsigned char *) params, strlen(params));
+  for (pos = 0; pos < stream->stream_length; pos += 0x10000000) {
+    size_t n = stream->stream_length - pos;
+    MD5_write(&md5, stream->stream + pos, n < 0x10000000 ? n : 0x10000000);
+  }
+  MD5_final(digest, &md5);
+
+  filename = NEW(strlen(stream_cache_dir) + 1 + 32 + strlen(".dpxz") + 1, char);
+  sprintf(filename, "%s/", stream_cache_dir);
+  s = filename + strlen(filename);
+  for (i = 0; i < 16; i++) {
+    sprintf(s, "%02x", digest[i]);
+    s += 2;
+  }
+  strcpy(s, ".dpxz");
+
+  return filename;
+}
+
+static unsigned char *
+read_stream_cache (const char *filename, size_t *length, int *predicted)
+{
+  FILE          *fp;
+  char           sig[8];
+  unsigned char  header[5];
+  unsigned char *data = NULL;
+  uint32_t       len;
+
+  fp = MFOPEN(filename, FOPEN_RBIN_MODE);
+  if (!fp)
+    return NULL;
+  if (fread(sig, 1, 8, fp) == 8 && !memcmp(sig, STREAM_CACHE_SIGNATURE, 8) &&
+      fread(header, 1, 5, fp) == 5) {
+    len = ((uint32_t) header[0] << 24) | ((uint32_t) header[1] << 16) |
+          ((uint32_t) header[2] << 8)  |  (uint32_t) header[3];
+    data = NEW(len + 1, unsigned char);
+    /* A truncated file is ignored. */
+    if (fread(data, 1, len, fp) != len || fgetc(fp) != EOF) {
+      RELEASE(data);
+      data = NULL;
+    } else {
+      *length    = len;
+      *predicted = header[4];
+    }
+  }
+  MFCLOSE(fp);
+
+  if (data && dpx_conf.verbose_level > 1)
+    MESG("\npdf_obj>> using cached stream \"%s\"\n", filename);
+
+  return data;
+}
+
+static void
+write_stream_cache (const char *filename,
+                    const unsigned char *data, size_t length, int predicted)
+{
+  FILE          *fp;
+  char          *tmp;
+  unsigned char  header[5];
+  int            ok;
+
+  if (length > 0xffffffffUL)
+    return;
+
+  /* Other processes may read the cache at the same time. */
+  tmp = NEW(strlen(filename) + strlen(".tmp") + 1, char);
+  sprintf(tmp, "%s.tmp", filename);
+  fp = MFOPEN(tmp, FOPEN_WBIN_MODE);
+  if (!fp) {
+    RELEASE(tmp);
+    return;
+  }
+  header[0] = (length >> 24) & 0xff;
+  header[1] = (length >> 16) & 0xff;
+  header[2] = (length >> 8)  & 0xff;
+  header[3] =  length        & 0xff;
+  header[4] = predicted ? 1 : 0;
+  ok = fwrite(STREAM_CACHE_SIGNATURE, 1, 8, fp) == 8 &&
+       fwrite(header, 1, 5, fp) == 5 &&
+       fwrite(data, 1, length, fp) == length;
+  ok = (MFCLOSE(fp) == 0) && ok;
+  if (!ok || rename(tmp, filename) != 0)
+    remove(tmp);
+  RELEASE(tmp);
+}
+
 static void
 write_stream (pdf_out *p, pdf_stream *stream)
 {
@@ -2218,12 +2379,31 @@ write_stream (pdf_out *p, pdf_stream *stream)
   if (stream->stream_length > 0 &&
       (stream->_flags & STREAM_COMPRESS) &&
       p->options.compression.level > 0) {
-    pdf_obj *filters;
+    pdf_obj       *filters;
+    int            use_predictor, predicted = 0;
+    char          *cache_file = NULL;
+    unsigned char *cached = NULL;
+    size_t         cached_length = 0;
+
+    use_predictor = p->options.compression.use_predictor &&
+                    (stream->_flags & STREAM_USE_PREDICTOR) &&
+                    !pdf_lookup_dict(stream->dict, "DecodeParms");
+
+    if (!stream->deflated &&
+        (stream->_flags & STREAM_CACHE_ENCODED) && stream_cache_dir) {
+      cache_file = stream_cache_file(p, stream, use_predictor);
+      cached = read_stream_cache(cache_file, &cached_length, &predicted);
+    }
 
-    /* First apply predictor filter if requested. */
-    if ( p->options.compression.use_predictor &&
-        (stream->_flags & STREAM_USE_PREDICTOR) &&
-        !pdf_lookup_dict(stream->dict, "DecodeParms")) {
+    if (cached) {
+      if (predicted)
+        pdf_add_dict(stream->dict, pdf_new_name("DecodeParms"),
+                     filter_create_predictor_dict(stream->decodeparms.predictor,
+                                                  stream->decodeparms.columns,
+                                                  stream->decodeparms.bits_per_component,
+                                                  stream->decodeparms.colors));
+    } else if (use_predictor) {
+      /* First apply predictor filter if requested. */
       int      bits_per_pixel  = stream->decodeparms.colors *
                                    stream->decodeparms.bits_per_component;
       int32_t  len  = (stream->decodeparms.columns * bits_per_pixel + 7) / 8;
@@ -2262,13 +2442,12 @@ write_stream (pdf_out *p, pdf_stream *stream)
         filtered = filtered2;
         filtered_length = length2;
         pdf_add_dict(stream->dict, pdf_new_name("DecodeParms"), parms);
+        predicted = 1;
       }
     }
 
     filters = pdf_lookup_dict(stream->dict, "Filter");
 
-    buffer_length = filtered_length + filtered_length/1000 + 14;
-    buffer = NEW(buffer_length, unsigned char);
     {
       pdf_obj *filter_name = pdf_new_name("FlateDecode");
 
@@ -2285,17 +2464,33 @@ write_stream (pdf_out *p, pdf_stream *stream)
          */
         pdf_add_dict(stream->dict, pdf_new_name("Filter"), filter_name);
     }
+    if (stream->deflated) {
+      /* Already compressed by pdf_complete_deferred_output(). */
+      buffer        = stream->deflated;
+      buffer_length = stream->deflated_length;
+      stream->deflated = NULL;
+    } else if (cached) {
+      buffer        = cached;
+      buffer_length = cached_length;
+    } else {
+      buffer_length = filtered_length + filtered_length/1000 + 14;
+      buffer = NEW(buffer_length, unsigned char);
 #ifdef HAVE_ZLIB_COMPRESS2    
-    if (compress2(buffer, &buffer_length, filtered,
-        filtered_length, p->options.compression.level)) {
-      ERROR("Zlib error");
-    }
+      if (compress2(buffer, &buffer_length, filtered,
+          filtered_length, p->options.compression.level)) {
+        ERROR("Zlib error");
+      }
 #else 
-    if (compress(buffer, &buffer_length, filtered,
-        filtered_length)) {
-      ERROR ("Zlib error");
-    }
+      if (compress(buffer, &buffer_length, filtered,
+          filtered_length)) {
+        ERROR ("Zlib error");
+      }
 #endif /* HAVE_ZLIB_COMPRESS2 */
+      if (cache_file)
+        write_stream_cache(cache_file, buffer, buffer_length, predicted);
+    }
+    if (cache_file)
+      RELEASE(cache_file);
     RELEASE(filtered);
     p->output.compression_saved +=
       filtered_length - buffer_length
@@ -2367,6 +2562,11 @@ release_stream (pdf_stream *stream)
     stream->objstm_data = NULL;
   }
 
+  if (stream->deflated) {
+    RELEASE(stream->deflated);
+    stream->deflated = NULL;
+  }
+
   RELEASE(stream);
 }
 
@@ -3243,6 +3443,16 @@ pdf_release_obj (pdf_obj *object)
         if (!p->options.use_objstm || object->flags & OBJ_NO_OBJSTM ||
             (p->options.enable_encrypt && (object->flags & OBJ_NO_ENCRYPT)) ||
             object->generation) {
+          if (p->deferred.active) {
+            /* Written (and released) by pdf_complete_deferred_output(). */
+            if (p->deferred.count == p->deferred.max_count) {
+              p->deferred.max_count += 256;
+              p->deferred.objects = RENEW(p->deferred.objects,
+                                          p->deferred.max_count, pdf_obj *);
+            }
+            p->deferred.objects[p->deferred.count++] = object;
+            return;
+          }
           pdf_flush_obj(p, object);
         } else {
           if (!p->current_objstm) {
@@ -3259,39 +3469,160 @@ pdf_release_obj (pdf_obj *object)
         }
       }
     }
-    switch (object->type) {
-    case PDF_BOOLEAN:
-      release_boolean(object->data);
-      break;
-    case PDF_NULL:
-      break;
-    case PDF_NUMBER:
-      release_number(object->data);
-      break;
-    case PDF_STRING:
-      release_string(object->data);
-      break;
-    case PDF_NAME:
-      release_name(object->data);
-      break;
-    case PDF_ARRAY:
-      release_array(object->data);
-      break;
-    case PDF_DICT:
-      release_dict(object->data);
-      break;
-    case PDF_STREAM:
-      release_stream(object->data);
-      break;
-    case PDF_INDIRECT:
-      release_indirect(object->data);
-      break;
+    release_obj_data(object);
+  }
+}
+
+static void
+release_obj_data (pdf_obj *object)
+{
+  switch (object->type) {
+  case PDF_BOOLEAN:
+    release_boolean(object->data);
+    break;
+  case PDF_NULL:
+    break;
+  case PDF_NUMBER:
+    release_number(object->data);
+    break;
+  case PDF_STRING:
+    release_string(object->data);
+    break;
+  case PDF_NAME:
+    release_name(object->data);
+    break;
+  case PDF_ARRAY:
+    release_array(object->data);
+    break;
+  case PDF_DICT:
+    release_dict(object->data);
+    break;
+  case PDF_STREAM:
+    release_stream(object->data);
+    break;
+  case PDF_INDIRECT:
+    release_indirect(object->data);
+    break;
+  }
+  /* This might help detect freeing already freed objects */
+  object->type = -1;
+  object->data = NULL;
+  RELEASE(object);
+}
+
+/* Deferred output
+ *
+ * Between pdf_defer_output() and pdf_complete_deferred_output() labeled
+ * objects are not written when they are released but queued. Streams in
+ * the queue are then compressed all at once, on several threads where
+ * available, before the objects are written in the order in which they
+ * were released. The output is the same as without deferring.
+ */
+void
+pdf_defer_output (void)
+{
+  pdf_out *p = current_output();
+
+  p->deferred.active = 1;
+}
+
+/* Same conditions as in write_stream(), without the predictor filter. */
+static int
+can_deflate_in_advance (pdf_out *p, pdf_obj *object)
+{
+#if defined(HAVE_ZLIB) && defined(HAVE_ZLIB_COMPRESS2)
+  pdf_stream *stream;
+  pdf_obj    *type;
+
+  if (object->type != PDF_STREAM)
+    return 0;
+  stream = object->data;
+  if (stream->stream_length == 0 ||
+      !(stream->_flags & STREAM_COMPRESS) ||
+      p->options.compression.level <= 0)
+    return 0;
+  type = pdf_lookup_dict(stream->dict, "Type");
+  if (type && !strcmp("Metadata", pdf_name_value(type)))
+    return 0;
+  if (p->options.compression.use_predictor &&
+      (stream->_flags & STREAM_USE_PREDICTOR) &&
+      !pdf_lookup_dict(stream->dict, "DecodeParms"))
+    return 0;
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+#if defined(HAVE_ZLIB) && defined(HAVE_ZLIB_COMPRESS2)
+struct deflate_jobs
+{
+  pdf_stream **streams;
+  int          level;
+};
+
+/* Runs on a worker thread: must not touch anything but the stream. */
+static void
+deflate_stream (void *data, int idx)
+{
+  struct deflate_jobs *jobs   = data;
+  pdf_stream          *stream = jobs->streams[idx];
+  uLong                length;
+  unsigned char       *buffer;
+
+  length = stream->stream_length + stream->stream_length/1000 + 14;
+  buffer = NEW(length, unsigned char);
+  if (compress2(buffer, &length, stream->stream,
+                stream->stream_length, jobs->level)) {
+    /* write_stream() will try again and report the error. */
+    RELEASE(buffer);
+    return;
+  }
+  stream->deflated        = buffer;
+  stream->deflated_length = length;
+}
+#endif
+
+void
+pdf_complete_deferred_output (void)
+{
+  pdf_out *p = current_output();
+  size_t   i;
+
+  if (!p->deferred.active)
+    return;
+  p->deferred.active = 0;
+
+#if defined(HAVE_ZLIB) && defined(HAVE_ZLIB_COMPRESS2)
+  {
+    struct deflate_jobs jobs;
+    int                 count = 0;
+
+    jobs.streams = NEW(p->deferred.count + 1, pdf_stream *);
+    jobs.level   = p->options.compression.level;
+    for (i = 0; i < p->deferred.count; i++) {
+      if (can_deflate_in_advance(p, p->deferred.objects[i]))
+        jobs.streams[count++] = p->deferred.objects[i]->data;
     }
-    /* This might help detect freeing already freed objects */
-    object->type = -1;
-    object->data = NULL;
-    RELEASE(object);
+#if defined(MIKTEX)
+    miktex_parallel_for(count, deflate_stream, &jobs);
+#else
+    {
+      int j;
+
+      for (j = 0; j < count; j++)
+        deflate_stream(&jobs, j);
+    }
+#endif
+    RELEASE(jobs.streams);
+  }
+#endif
+
+  for (i = 0; i < p->deferred.count; i++) {
+    pdf_flush_obj(p, p->deferred.objects[i]);
+    release_obj_data(p->deferred.objects[i]);
   }
+  p->deferred.count = 0;
 }
 
 /* Reading external PDF files
@@ -44,6 +44,9 @@ typedef struct pdf_out pdf_out;
 
 #define STREAM_COMPRESS (1 << 0)
 #define STREAM_USE_PREDICTOR   (1 << 1)
+/* The compressed stream data may be kept across runs, see
+ * pdf_set_stream_cache_dir(). */
+#define STREAM_CACHE_ENCODED   (1 << 2)
 
 /* A deeper object hierarchy will be considered as (illegal) loop. */
 #define PDF_OBJ_MAX_DEPTH  30
@@ -67,6 +70,11 @@ extern void     pdf_out_set_encrypt (int keybits, int32_t permission,
                                      int use_aes, int encrypt_metadata);
 extern void     pdf_out_flush     (void);
 
+extern void     pdf_set_stream_cache_dir (const char *dirname);
+
+extern void     pdf_defer_output  (void);
+extern void     pdf_complete_deferred_output (void);
+
 extern int      pdf_get_version       (void);
 extern int      pdf_get_version_major (void);
 extern int      pdf_get_version_minor (void);
@@ -232,7 +232,7 @@ png_include_image (pdf_ximage *ximage, FILE *png_file)
       info.ydensity = 72.0 / 0.0254 / yppm;
   }
 
-  stream      = pdf_new_stream (STREAM_COMPRESS);
+  stream      = pdf_new_stream (STREAM_COMPRESS | STREAM_CACHE_ENCODED);
   stream_dict = pdf_stream_dict(stream);
 
   stream_data_ptr = (png_bytep) NEW(rowbytes*height, png_byte);
@@ -975,7 +975,7 @@ create_soft_mask (png_structp png_ptr, png_infop info_ptr,
   mask  = 0xff >> (8 - bpc);
   shift = 8 - bpc;
 
-  smask = pdf_new_stream(STREAM_COMPRESS);
+  smask = pdf_new_stream(STREAM_COMPRESS | STREAM_CACHE_ENCODED);
   dict  = pdf_stream_dict(smask);
   smask_data_ptr = (png_bytep) NEW(width*height, png_byte);
   pdf_add_dict(dict, pdf_new_name("Type"),    pdf_new_name("XObject"));
@@ -1023,7 +1023,7 @@ strip_soft_mask (png_structp png_ptr, png_infop info_ptr,
     }
   }
 
-  smask = pdf_new_stream(STREAM_COMPRESS);
+  smask = pdf_new_stream(STREAM_COMPRESS | STREAM_CACHE_ENCODED);
   dict  = pdf_stream_dict(smask);
   pdf_add_dict(dict, pdf_new_name("Type"),    pdf_new_name("XObject"));
   pdf_add_dict(dict, pdf_new_name("Subtype"), pdf_new_name("Image"));
@@ -54,6 +54,8 @@
 #include "t1_load.h"
 #include "t1_char.h"
 
+#include "dpxcrypt.h"
+
 #include "type1.h"
 
 #define FONT_FLAG_FIXEDPITCH (1 << 0)  /* Fixed-width font */
@@ -66,6 +68,191 @@
 #define FONT_FLAG_SMALLCAP   (1 << 17) /* Small-cap font */
 #define FONT_FLAG_FORCEBOLD  (1 << 18) /* Force bold at small text sizes */
 
+/* Cache of converted glyphs
+ *
+ * Converting Type 1 charstrings to Type 2 charstrings is the bulk of the
+ * work of embedding a Type 1 font. The converted glyphs and their metrics
+ * are kept in the cache directory, in one file per font file; the file name
+ * is the MD5 digest of the font file. Glyphs converted in a later run are
+ * added to the file. A cache file holds a signature and the size of
+ * t1_ginfo, then for each glyph the GID, the length of the charstring, the
+ * t1_ginfo and the charstring. Numbers are stored big-endian, t1_ginfo as
+ * it is in memory.
+ */
+static char *glyph_cache_dir = NULL;
+
+#define GLYPH_CACHE_SIGNATURE "dpxg0001"
+
+struct glyph_cache
+{
+  char      *filename;
+  int        count;     /* number of glyphs in the font */
+  card8    **cstrings;  /* NULL if not cached */
+  int       *lengths;
+  t1_ginfo  *ginfo;
+  int        modified;
+};
+
+void
+pdf_font_set_type1_cache_dir (const char *dirname)
+{
+  if (glyph_cache_dir)
+    RELEASE(glyph_cache_dir);
+  glyph_cache_dir = NULL;
+  if (dirname) {
+    glyph_cache_dir = NEW(strlen(dirname)+1, char);
+    strcpy(glyph_cache_dir, dirname);
+  }
+}
+
+static uint32_t
+cache_get_quad (const unsigned char *p)
+{
+  return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+         ((uint32_t) p[2] << 8)  |  (uint32_t) p[3];
+}
+
+static void
+cache_put_quad (unsigned char *p, uint32_t value)
+{
+  p[0] = (value >> 24) & 0xff;
+  p[1] = (value >> 16) & 0xff;
+  p[2] = (value >> 8)  & 0xff;
+  p[3] =  value        & 0xff;
+}
+
+static struct glyph_cache *
+glyph_cache_open (FILE *fp, int count)
+{
+  struct glyph_cache *cache;
+  MD5_CONTEXT    md5;
+  unsigned char  digest[16], buf[8192];
+  char          *s;
+  size_t         n;
+  int            i;
+  FILE          *cfp;
+
+  MD5_init(&md5);
+  rewind(fp);
+  while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+    MD5_write(&md5, buf, n);
+  MD5_final(digest, &md5);
+  rewind(fp);
+
+  cache = NEW(1, struct glyph_cache);
+  cache->filename = NEW(strlen(glyph_cache_dir) + 1 + 32 + strlen(".dpxg") + 1, char);
+  sprintf(cache->filename, "%s/", glyph_cache_dir);
+  s = cache->filename + strlen(cache->filename);
+  for (i = 0; i < 16; i++) {
+    sprintf(s, "%02x", digest[i]);
+    s += 2;
+  }
+  strcpy(s, ".dpxg");
+  cache->count    = count;
+  cache->cstrings = NEW(count, card8 *);
+  cache->lengths  = NEW(count, int);
+  cache->ginfo    = NEW(count, t1_ginfo);
+  cache->modified = 0;
+  for (i = 0; i < count; i++) {
+    cache->cstrings[i] = NULL;
+    cache->lengths[i]  = 0;
+  }
+
+  cfp = MFOPEN(cache->filename, FOPEN_RBIN_MODE);
+  if (!cfp)
+    return cache;
+  if (fread(buf, 1, 12, cfp) == 12 &&
+      !memcmp(buf, GLYPH_CACHE_SIGNATURE, 8) &&
+      cache_get_quad(buf + 8) == sizeof(t1_ginfo)) {
+    /* A truncated or otherwise broken record ends the file. */
+    while (fread(buf, 1, 8, cfp) == 8) {
+      uint32_t  gid = cache_get_quad(buf);
+      uint32_t  len = cache_get_quad(buf + 4);
+      t1_ginfo  gm;
+      card8    *cstring;
+
+      if (gid >= (uint32_t) count || len > CS_STR_LEN_MAX ||
+          cache->cstrings[gid] ||
+          fread(&gm, sizeof(t1_ginfo), 1, cfp) != 1)
+        break;
+      cstring = NEW(len + 1, card8);
+      if (fread(cstring, 1, len, cfp) != len) {
+        RELEASE(cstring);
+        break;
+      }
+      cache->cstrings[gid] = cstring;
+      cache->lengths[gid]  = len;
+      cache->ginfo[gid]    = gm;
+    }
+  }
+  MFCLOSE(cfp);
+
+  if (dpx_conf.verbose_level > 1)
+    MESG("\nType1>> using glyph cache \"%s\"\n", cache->filename);
+
+  return cache;
+}
+
+static void
+glyph_cache_add (struct glyph_cache *cache, int gid,
+                 const card8 *cstring, int len, const t1_ginfo *gm)
+{
+  if (gid < 0 || gid >= cache->count || cache->cstrings[gid])
+    return;
+  cache->cstrings[gid] = NEW(len + 1, card8);
+  memcpy(cache->cstrings[gid], cstring, len);
+  cache->lengths[gid] = len;
+  cache->ginfo[gid]   = *gm;
+  cache->modified = 1;
+}
+
+static void
+glyph_cache_close (struct glyph_cache *cache)
+{
+  int   i;
+
+  if (cache->modified) {
+    FILE          *fp;
+    char          *tmp;
+    unsigned char  buf[12];
+    int            ok;
+
+    /* Other processes may read the cache at the same time. */
+    tmp = NEW(strlen(cache->filename) + strlen(".tmp") + 1, char);
+    sprintf(tmp, "%s.tmp", cache->filename);
+    fp = MFOPEN(tmp, FOPEN_WBIN_MODE);
+    if (fp) {
+      memcpy(buf, GLYPH_CACHE_SIGNATURE, 8);
+      cache_put_quad(buf + 8, sizeof(t1_ginfo));
+      ok = fwrite(buf, 1, 12, fp) == 12;
+      for (i = 0; ok && i < cache->count; i++) {
+        if (!cache->cstrings[i])
+          continue;
+        cache_put_quad(buf, i);
+        cache_put_quad(buf + 4, cache->lengths[i]);
+        ok = fwrite(buf, 1, 8, fp) == 8 &&
+             fwrite(&cache->ginfo[i], sizeof(t1_ginfo), 1, fp) == 1 &&
+             fwrite(cache->cstrings[i], 1, cache->lengths[i], fp) ==
+               (size_t) cache->lengths[i];
+      }
+      ok = (MFCLOSE(fp) == 0) && ok;
+      if (!ok || rename(tmp, cache->filename) != 0)
+        remove(tmp);
+    }
+    RELEASE(tmp);
+  }
+
+  for (i = 0; i < cache->count; i++) {
+    if (cache->cstrings[i])
+      RELEASE(cache->cstrings[i]);
+  }
+  RELEASE(cache->cstrings);
+  RELEASE(cache->lengths);
+  RELEASE(cache->ginfo);
+  RELEASE(cache->filename);
+  RELEASE(cache);
+}
+
 static int
 is_basefont (const char *name)
 {
@@ -508,6 +695,7 @@ pdf_font_load_type1 (pdf_font *font)
   FILE         *fp;
   int           offset;
   int           code;
+  struct glyph_cache *gcache = NULL;
 
   ASSERT(font);
 
@@ -546,6 +734,8 @@ pdf_font_load_type1 (pdf_font *font)
   if (!cffont) {
     ERROR("Could not load Type 1 font: %s", ident);
   }
+  if (glyph_cache_dir)
+    gcache = glyph_cache_open(fp, cffont->cstrings->count);
   DPXFCLOSE(fp);
 
   fullname = NEW(strlen(fontname) + 8, char);
@@ -720,9 +910,18 @@ pdf_font_load_type1 (pdf_font *font)
       srcptr   = cffont->cstrings->data + cffont->cstrings->offset[gid_orig] - 1;
       srclen   = cffont->cstrings->offset[gid_orig + 1] - cffont->cstrings->offset[gid_orig];
 
-      offset  += t1char_convert_charstring(dstptr, CS_STR_LEN_MAX,
-                                           srcptr, srclen,
-                                           cffont->subrs[0], defaultwidth, nominalwidth, &gm);
+      if (gcache && gcache->cstrings[gid_orig]) {
+        memcpy(dstptr, gcache->cstrings[gid_orig], gcache->lengths[gid_orig]);
+        offset += gcache->lengths[gid_orig];
+        gm      = gcache->ginfo[gid_orig];
+      } else {
+        int len = t1char_convert_charstring(dstptr, CS_STR_LEN_MAX,
+                                            srcptr, srclen,
+                                            cffont->subrs[0], defaultwidth, nominalwidth, &gm);
+        if (gcache)
+          glyph_cache_add(gcache, gid_orig, dstptr, len, &gm);
+        offset += len;
+      }
       cstring->offset[gid + 1] = offset + 1;
       if (gm.use_seac) {
         int  bchar_gid, achar_gid, i;
@@ -791,6 +990,9 @@ pdf_font_load_type1 (pdf_font *font)
     }
     cstring->count = num_glyphs;
 
+    if (gcache)
+      glyph_cache_close(gcache);
+
     cff_release_index(cffont->subrs[0]);
     cffont->subrs[0] = NULL;
     RELEASE(cffont->subrs);
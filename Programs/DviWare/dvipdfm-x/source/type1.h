@@ -28,4 +28,6 @@
 extern int  pdf_font_open_type1 (pdf_font *font, const char *ident, int index, int encoding_id, int embedding);
 extern int  pdf_font_load_type1 (pdf_font *font);
 
+extern void pdf_font_set_type1_cache_dir (const char *dirname);
+
 #endif /* _TYPE1_H_ */
@@ -0,0 +1,127 @@
+/* dvipng/miktex/encoders.cpp: encode page images in the background
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA.  */
+
+#include "dvipng.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// The pages are drawn one after another, because the DVI interpreter
+// keeps its state in global variables. Compressing a finished page
+// image is independent of that state: worker threads do it while the
+// next page is drawn.
+class Encoders
+{
+public:
+  ~Encoders()
+  {
+    Wait();
+    {
+      lock_guard<mutex> lock(mtx);
+      done = true;
+    }
+    workAvailable.notify_all();
+    for (thread& worker : workers)
+    {
+      worker.join();
+    }
+  }
+
+public:
+  void Add(int numThreads, void (*encode)(void*), void* data)
+  {
+    unique_lock<mutex> lock(mtx);
+    while (workers.size() < static_cast<size_t>(numThreads))
+    {
+      workers.push_back(thread(&Encoders::Work, this));
+    }
+    // each queued image takes memory: don't draw too far ahead
+    workDone.wait(lock, [this]() { return queue.size() < 2 * workers.size(); });
+    queue.push_back(make_pair(encode, data));
+    pending += 1;
+    workAvailable.notify_one();
+  }
+
+public:
+  void Wait()
+  {
+    unique_lock<mutex> lock(mtx);
+    workDone.wait(lock, [this]() { return pending == 0; });
+  }
+
+private:
+  void Work()
+  {
+    unique_lock<mutex> lock(mtx);
+    while (true)
+    {
+      workAvailable.wait(lock, [this]() { return done || !queue.empty(); });
+      if (queue.empty())
+      {
+        return;
+      }
+      pair<void (*)(void*), void*> job = queue.front();
+      queue.pop_front();
+      lock.unlock();
+      job.first(job.second);
+      lock.lock();
+      pending -= 1;
+      workDone.notify_all();
+    }
+  }
+
+private:
+  vector<thread> workers;
+
+private:
+  deque<pair<void (*)(void*), void*>> queue;
+
+private:
+  size_t pending = 0;
+
+private:
+  bool done = false;
+
+private:
+  mutex mtx;
+
+private:
+  condition_variable workAvailable;
+
+private:
+  condition_variable workDone;
+};
+
+static Encoders encoders;
+
+extern "C" void miktex_encode_async(int numThreads, void (*encode)(void* data), void* data)
+{
+  encoders.Add(numThreads, encode, data);
+}
+
+extern "C" void miktex_wait_for_encoders()
+{
+  encoders.Wait();
+}
@@ -387,6 +387,11 @@ void DrawPages(void)
       page_flags = 0;
       dvi_pos=NextPPage(dvi,dvi_pos);
     }
+#if defined(MIKTEX)
+    /* All images are written when the next DVI file is requested */
+    if (encoder_threads > 0)
+      miktex_wait_for_encoders();
+#endif
     Message(BE_NONQUIET,"\n");
     ClearPpList();
   }
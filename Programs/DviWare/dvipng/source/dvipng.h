@@ -31,6 +31,9 @@
 #  include <miktex/unxemu.h>
 #  include <Windows.h>
 #endif
+#if defined(MIKTEX)
+#  include <miktex/dvipng.h>
+#endif
 
 #define  STRSIZE         255     /* stringsize for file specifications  */
 
@@ -477,6 +480,10 @@ EXTERN int    dpi                  INIT(100);
 #ifdef HAVE_GDIMAGEPNGEX
 EXTERN int   compression INIT(1);
 #endif
+#if defined(MIKTEX)
+/* number of threads encoding page images, 0: encode in DrawPages */
+EXTERN int   encoder_threads INIT(0);
+#endif
 #undef min
 #undef max
 # define  max(x,y)       if ((y)>(x)) x = y
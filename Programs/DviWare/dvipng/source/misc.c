@@ -203,6 +203,19 @@ bool DecodeArgs(int argc, char ** argv)
 	}
 	break ;
       case 't':       /* specify paper format, only for cropmarks */
+#if defined(MIKTEX)
+	/* Encoder threads */
+	if (strncmp(p,"hreads",6)==0) {
+	  p+=6;
+	  if (*p == 0 && argv[i+1])
+	    p = argv[++i];
+	  encoder_threads = atoi(p);
+	  if (encoder_threads < 0)
+	    encoder_threads = 0;
+	  Message(PARSE_STDIN,"Encoder threads: %d\n",encoder_threads);
+	  break;
+	}
+#endif
 #ifdef HAVE_GDIMAGECREATETRUECOLOR
 	/* Truecolor */
 	if (strncmp(p,"ruecolor",8)==0) {
@@ -635,6 +648,9 @@ or <http://www.gnu.org/licenses/>.");
     fprintf(stdout,"  --png        Output PNG images (dvipng default)\n");
 #endif
     fprintf(stdout,"  --strict     When a warning occurs, exit\n");
+#if defined(MIKTEX)
+    fprintf(stdout,"  --threads #  Encode images on # background threads\n");
+#endif
 #ifdef HAVE_GDIMAGECREATETRUECOLOR
     fprintf(stdout,"  --truecolor* Truecolor output\n");
 #endif
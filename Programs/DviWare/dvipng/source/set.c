@@ -96,6 +96,30 @@ static void ChangeColor(gdImagePtr imagep,int x1,int y1,
   }
 }
 
+#if defined(MIKTEX)
+struct encoder_job {
+  gdImagePtr imagep;
+  FILE* outfp;
+  int gif;
+};
+
+/* Runs on an encoder thread: must not touch the DVI state */
+static void EncodeImage(void *data)
+{
+  struct encoder_job *job = data;
+
+#ifdef HAVE_GDIMAGEGIF
+  if (job->gif)
+    gdImageGif(job->imagep,job->outfp);
+  else
+#endif
+    gdImagePngEx(job->imagep,job->outfp,compression);
+  fclose(job->outfp);
+  gdImageDestroy(job->imagep);
+  free(job);
+}
+#endif
+
 void WriteImage(char *pngname, int pagenum)
 {
   char* pos, *freeme=NULL;
@@ -163,6 +187,23 @@ void WriteImage(char *pngname, int pagenum)
 #endif
   if ((outfp = fopen(pngname,"wb")) == NULL)
       Fatal("cannot open output file %s",pngname);
+#if defined(MIKTEX)
+  if (encoder_threads > 0) {
+    struct encoder_job *job = malloc(sizeof(struct encoder_job));
+    if (job == NULL)
+      Fatal("cannot allocate memory for image encoder");
+    job->imagep = page_imagep;
+    job->outfp = outfp;
+    job->gif = (option_flags & GIF_OUTPUT) != 0;
+    /* The encoder owns the image now, the next page gets a new one */
+    page_imagep = NULL;
+    miktex_encode_async(encoder_threads, EncodeImage, job);
+    DEBUG_PRINT(DEBUG_DVI,("\n  QUEUED:  \t%s\n",pngname));
+    if (freeme)
+      free(freeme);
+    return;
+  }
+#endif
 #ifdef HAVE_GDIMAGEGIF
   if (option_flags & GIF_OUTPUT)
     gdImageGif(page_imagep,outfp);
@@ -0,0 +1,138 @@
+/* dvips/miktex/readahead.cpp: read font files ahead of time
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA.  */
+
+#include "dvips.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/Session>
+#include <miktex/Util/PathName>
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+using namespace std;
+
+// The Type 1 fonts are downloaded when the pages are written, long after
+// the prescan has found them. A background thread reads the font files
+// meanwhile, so that they are in the file system cache when they are
+// needed. Nothing else is shared with the thread.
+class ReadAhead
+{
+public:
+  ~ReadAhead()
+  {
+    if (!worker.joinable())
+    {
+      return;
+    }
+    {
+      lock_guard<mutex> lockGuard(queueMutex);
+      stop = true;
+    }
+    queueCondition.notify_one();
+    worker.join();
+  }
+
+public:
+  void Add(const PathName& path)
+  {
+    {
+      lock_guard<mutex> lockGuard(queueMutex);
+      if (!seen.insert(path.ToString()).second)
+      {
+        return;
+      }
+      queue.push_back(path);
+    }
+    if (!worker.joinable())
+    {
+      worker = thread(&ReadAhead::Run, this);
+    }
+    queueCondition.notify_one();
+  }
+
+private:
+  void Run()
+  {
+    unique_lock<mutex> lock(queueMutex);
+    while (true)
+    {
+      queueCondition.wait(lock, [this] { return stop || !queue.empty(); });
+      if (stop)
+      {
+        return;
+      }
+      PathName path = queue.front();
+      queue.pop_front();
+      lock.unlock();
+      try
+      {
+        FileStream stream(File::Open(path, FileMode::Open, FileAccess::Read, false));
+        char buf[65536];
+        while (stream.Read(buf, sizeof(buf)) > 0)
+        {
+        }
+        stream.Close();
+      }
+      catch (const MiKTeXException&)
+      {
+        // not fatal: the font will be read when it is downloaded
+      }
+      lock.lock();
+    }
+  }
+
+private:
+  thread worker;
+
+private:
+  mutex queueMutex;
+
+private:
+  condition_variable queueCondition;
+
+private:
+  deque<PathName> queue;
+
+private:
+  set<string> seen;
+
+private:
+  bool stop = false;
+};
+
+static ReadAhead readAhead;
+
+extern "C" void miktex_read_ahead_type1_font(const char* fontFile)
+{
+  shared_ptr<Session> session = Session::TryGet();
+  PathName path;
+  // the file is searched on the main thread
+  if (session != nullptr && session->FindFile(fontFile, FileType::TYPE1, path))
+  {
+    readAhead.Add(path);
+  }
+}
@@ -20,6 +20,7 @@
 #endif
 #if defined(MIKTEX)
 #include <miktex/Core/c/api.h>
+#include <miktex/dvips.h>
 #endif
 /*
  *   This is the structure definition for resident fonts.  We use
@@ -212,6 +213,14 @@ residentfont(register fontdesctype *curfnt)
    if (i < 0)
       i = 1;
    usesPSfonts = 1;
+#if defined(MIKTEX)
+/*
+ *   The font file is downloaded with the pages; read it while the
+ *   prescan goes on.
+ */
+   if (p->Fontfile)
+      miktex_read_ahead_type1_font(p->Fontfile);
+#endif
    return(i);
 }
 #define INLINE_SIZE (2000)
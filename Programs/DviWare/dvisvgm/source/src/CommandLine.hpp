@@ -45,6 +45,7 @@ class CommandLine : public CL::CommandLine {
 		TypedOption<int, Option::ArgMode::REQUIRED> gradSegmentsOpt {"grad-segments", '\0', "number", 20, "number of color gradient segments per row"};
 		TypedOption<double, Option::ArgMode::REQUIRED> gradSimplifyOpt {"grad-simplify", '\0', "delta", 0.05, "reduce level of detail for small segments"};
 		TypedOption<int, Option::ArgMode::OPTIONAL> helpOpt {"help", 'h', "mode", 0, "print this summary of options and exit"};
+		TypedOption<int, Option::ArgMode::REQUIRED> jobsOpt {"jobs", '\0', "number", 1, "convert pages in parallel processes"};
 		Option keepOpt {"keep", '\0', "keep temporary files"};
 		TypedOption<std::string, Option::ArgMode::REQUIRED> libgsOpt {"libgs", '\0', "filename", "set name of Ghostscript shared library"};
 		TypedOption<std::string, Option::ArgMode::REQUIRED> linkmarkOpt {"linkmark", 'L', "style", "box", "select how to mark hyperlinked areas"};
@@ -142,6 +143,7 @@ class CommandLine : public CL::CommandLine {
 			{&debugGlyphsOpt, 3},
 #endif
 			{&exactBboxOpt, 3},
+			{&jobsOpt, 3},
 			{&keepOpt, 3},
 #if !defined(HAVE_LIBGS) && !defined(DISABLE_GS)
 			{&libgsOpt, 3},
@@ -23,6 +23,8 @@
 #endif
 #include <algorithm>
 #include <cstdlib>
+#include <fstream>
+#include <map>
 #include <set>
 #include <sstream>
 #include "CMap.hpp"
@@ -35,7 +37,12 @@
 #include "SignalHandler.hpp"
 #include "Subfont.hpp"
 #include "Unicode.hpp"
+#include "XXHashFunction.hpp"
 #include "utility.hpp"
+#if defined(MIKTEX_WINDOWS)
+#include <miktex/Util/PathNameUtil>
+#define EXPATH_(x) MiKTeX::Util::PathNameUtil::ToLengthExtendedPathName(x)
+#endif
 
 
 using namespace std;
@@ -163,6 +170,7 @@ bool TFMFont::verifyChecksums () const {
 bool PhysicalFont::EXACT_BBOX = false;
 bool PhysicalFont::KEEP_TEMP_FILES = false;
 string PhysicalFont::CACHE_PATH;
+string PhysicalFont::SHARED_CACHE_PATH;
 double PhysicalFont::METAFONT_MAG = 4;
 FontCache PhysicalFont::_cache;
 
@@ -337,50 +345,102 @@ int PhysicalFont::charIndexByName(const string &charname) const {
  *  @param[in]  callback optional callback object for tracer class
  *  @return true if outline could be computed */
 bool PhysicalFont::getGlyph (int c, GraphicsPath<int32_t> &glyph, GFGlyphTracer::Callback *callback) const {
+	const Glyph *cached_glyph=nullptr;
+	if (!CACHE_PATH.empty()) {
+		_cache.write(CACHE_PATH);
+		readCache(glyphCacheKey());
+		cached_glyph = _cache.getGlyph(c);
+	}
+	if (cached_glyph) {
+		glyph = *cached_glyph;
+		return true;
+	}
 	if (type() == Type::MF) {
-		const Glyph *cached_glyph=nullptr;
-		if (!CACHE_PATH.empty()) {
-			_cache.write(CACHE_PATH);
-			_cache.read(name(), CACHE_PATH);
-			cached_glyph = _cache.getGlyph(c);
-		}
-		if (cached_glyph) {
-			glyph = *cached_glyph;
-			return true;
-		}
-		else {
-			string gfname;
-			if (createGF(gfname)) {
-				try {
-					double ds = getMetrics() ? getMetrics()->getDesignSize() : 1;
-					GFGlyphTracer tracer(gfname, unitsPerEm()/ds, callback);
-					tracer.setGlyph(glyph);
-					tracer.executeChar(c);
-					glyph.closeOpenSubPaths();
-					if (!CACHE_PATH.empty())
-						_cache.setGlyph(c, glyph);
-					return true;
-				}
-				catch (GFException &e) {
-					// @@ print error message
-				}
+		string gfname;
+		if (createGF(gfname)) {
+			try {
+				double ds = getMetrics() ? getMetrics()->getDesignSize() : 1;
+				GFGlyphTracer tracer(gfname, unitsPerEm()/ds, callback);
+				tracer.setGlyph(glyph);
+				tracer.executeChar(c);
+				glyph.closeOpenSubPaths();
+				if (!CACHE_PATH.empty())
+					_cache.setGlyph(c, glyph);
+				return true;
+			}
+			catch (GFException &e) {
+				// @@ print error message
 			}
 		}
 	}
 	else { // vector fonts (OTF, PFB, TTF, TTC)
 		bool ok=true;
 		FontEngine::instance().setFont(*this);
+		int code = c;
 		if (const FontMap::Entry *entry = fontMapEntry())
 			if (Subfont *sf = entry->subfont)
-				c = sf->decode(c);
-		ok = FontEngine::instance().traceOutline(decodeChar(c), glyph, false);
+				code = sf->decode(c);
+		ok = FontEngine::instance().traceOutline(decodeChar(code), glyph, false);
 		glyph.closeOpenSubPaths();
+		if (ok && !CACHE_PATH.empty())
+			_cache.setGlyph(c, glyph);  // keyed by the original character code (see glyphCacheKey())
 		return ok;
 	}
 	return false;
 }
 
 
+/** Reads the cached glyphs of a font into the glyph cache. If the user's cache
+ *  directory doesn't provide them, the shared cache directory is tried.
+ *  @param[in] key name of the cache file without suffix (see glyphCacheKey()) */
+void PhysicalFont::readCache (const string &key) {
+	if (!_cache.read(key, CACHE_PATH) && !SHARED_CACHE_PATH.empty()) {
+		_cache.clear();
+		_cache.read(key, SHARED_CACHE_PATH);
+	}
+}
+
+
+/** Returns the key that identifies the cached glyphs of this font. Metafont glyphs
+ *  are identified by the font name. The outlines of vector fonts also depend on the
+ *  font file and on the parameters assigned by the font map, so a digest of these
+ *  is appended to the font name. This way, the cache stays valid if the same font
+ *  file is used by several TeX fonts and it's invalidated if the font file changes. */
+string PhysicalFont::glyphCacheKey () const {
+	if (type() == Type::MF)
+		return name();
+	static map<string,string> keys;  // font name -> cache key
+	auto it = keys.find(name());
+	if (it != keys.end())
+		return it->second;
+	XXH64HashFunction hashfunc;
+	if (const char *fontpath = path()) {
+#if defined(MIKTEX_WINDOWS)
+		ifstream ifs(EXPATH_(fontpath), ios::binary);
+#else
+		ifstream ifs(fontpath, ios::binary);
+#endif
+		hashfunc.update(ifs);
+	}
+	ostringstream oss;
+	oss << fontIndex() << ':' << int(getCharMapID().platform_id) << ':' << int(getCharMapID().encoding_id);
+	if (const FontMap::Entry *entry = fontMapEntry()) {
+		oss << ':' << entry->encname;
+		if (entry->subfont)
+			oss << ':' << entry->subfont->id();
+	}
+	if (const FontStyle *fontstyle = style()) {
+		oss << ':' << fontstyle->extend << ':' << fontstyle->slant << ':' << fontstyle->bold;
+		if (fontstyle->bold != 0)  // the stroke width depends on the font size
+			oss << ':' << scaledSize();
+	}
+	hashfunc.update(oss.str());
+	string key = name() + "-" + hashfunc.digestString();
+	keys.emplace(name(), key);
+	return key;
+}
+
+
 /** Creates a GF file for this font object.
  *  @param[out] gfname name of the generated GF font file
  *  @return true on success */
@@ -414,7 +474,7 @@ int PhysicalFont::traceAllGlyphs (bool includeCached, GFGlyphTracer::Callback *c
 			string gfname;
 			Glyph glyph;
 			if (createGF(gfname)) {
-				_cache.read(name(), CACHE_PATH);
+				readCache(name());
 				double ds = getMetrics() ? getMetrics()->getDesignSize() : 1;
 				GFGlyphTracer tracer(gfname, unitsPerEm()/ds, cb);
 				tracer.setGlyph(glyph);
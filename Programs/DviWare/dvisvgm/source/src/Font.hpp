@@ -146,11 +146,14 @@ class PhysicalFont : public virtual Font {
 
 	protected:
 		bool createGF (std::string &gfname) const;
+		std::string glyphCacheKey () const;
+		static void readCache (const std::string &key);
 
 	public:
 		static bool EXACT_BBOX;
 		static bool KEEP_TEMP_FILES;
-		static std::string CACHE_PATH; ///< path to cache directory ("" if caching is disabled)
+		static std::string CACHE_PATH;        ///< path to cache directory ("" if caching is disabled)
+		static std::string SHARED_CACHE_PATH; ///< path to read-only cache directory shared by all users ("" if none)
 		static double METAFONT_MAG;    ///< magnification factor for Metafont calls
 
 	protected:
@@ -80,6 +80,8 @@ void PSInterpreter::init () {
 		// initializing PS code. This cannot be done in the constructor because we
 		// need the completely initialized PSInterpreter object here.
 		execute(PSDEFS);
+		// snapshot of the initial VM state, left on the operand stack (see reset())
+		execute("\n:save ");
 	}
 }
 
@@ -165,13 +167,61 @@ bool PSInterpreter::execute (const char *str, size_t len, bool flush) {
 			checkStatus(status);
 	}
 	if (flush) {
-		// force writing contents of output buffer
-		_gs.run_string_continue("\nflush ", 7, 0, &status);
+		if (_batchLevel > 0)
+			_flushPending = true;
+		else {
+			// force writing contents of output buffer
+			_gs.run_string_continue("\nflush ", 7, 0, &status);
+		}
 	}
 	return complete;
 }
 
 
+/** Forces Ghostscript to write the contents of its output buffer, i.e. all pending
+ *  PS actions are performed when this method returns. */
+void PSInterpreter::flush () {
+	_flushPending = false;
+	if (_mode == PS_RUNNING) {
+		int status=0;
+		_gs.run_string_continue("\nflush ", 7, 0, &status);
+	}
+}
+
+
+void PSInterpreter::endBatch () {
+	if (--_batchLevel == 0 && _flushPending)
+		flush();
+}
+
+
+/** Restores the state present right after the initialization so that the interpreter
+ *  can be reused to process another document. The VM snapshot taken by init() is
+ *  expected at the bottom of the operand stack.
+ *  @return true on success, false if the interpreter can't be reused */
+bool PSInterpreter::reset () {
+	if (!_initialized || _mode == PS_QUIT)
+		return false;
+	PSActions *actions = setActions(nullptr);  // the restore must not trigger any actions
+	_filter = nullptr;
+	_bytesToRead = 0;
+	_batchLevel = 0;
+	_flushPending = false;
+	_linebuf.clear();
+	_rawData.clear();
+	_errorMessage.clear();
+	_inError = false;
+	try {
+		execute("\ncleardictstack count 1 sub{pop}repeat :restore :save ");
+	}
+	catch (PSException &e) {
+		_mode = PS_QUIT;
+	}
+	setActions(actions);
+	return _mode != PS_QUIT;
+}
+
+
 /** Executes a chunk of PostScript code read from a stream. The method returns on EOF.
  *  @param[in] is the input stream
  *  @param[in] flush If true, a final 'flush' is sent which forces the output buffer to be written immediately.
@@ -193,10 +243,52 @@ bool PSInterpreter::executeRaw (const string &str, int n) {
 	ostringstream oss;
 	oss << str << ' ' << n << " (raw) prcmd\n";
 	execute(oss.str());
+	flush();  // the data is needed right now, even inside a batch
 	return !_rawData.empty();
 }
 
 
+bool PSInterpreterPool::_destroyed = false;
+
+
+PSInterpreterPool::~PSInterpreterPool () {
+	_destroyed = true;
+}
+
+
+PSInterpreterPool& PSInterpreterPool::instance () {
+	static PSInterpreterPool pool;
+	return pool;
+}
+
+
+/** Returns an interpreter that performs the given actions. If available, an idle
+ *  interpreter is reused, otherwise a new one is created.
+ *  @param[in] actions template methods to be executed by the interpreter */
+unique_ptr<PSInterpreter> PSInterpreterPool::acquire (PSActions *actions) {
+	unique_ptr<PSInterpreter> psi = std::move(_idle);
+	if (psi)
+		psi->setActions(actions);
+	else
+		psi = util::make_unique<PSInterpreter>(actions);
+	return psi;
+}
+
+
+/** Hands an interpreter back to the pool. It's dropped if its state can't be reset.
+ *  @param[in] psi the interpreter previously returned by acquire() */
+void PSInterpreterPool::release (unique_ptr<PSInterpreter> psi) {
+	if (_destroyed || !psi)
+		return;
+	psi->setActions(nullptr);
+	// keep the interpreter only if it's initialized and Ghostscript still accepts code
+	if (psi->reset()) {
+		_idle.reset();  // Ghostscript may not be able to run two instances at once
+		_idle = std::move(psi);
+	}
+}
+
+
 /** This callback function handles input from stdin to Ghostscript. Currently not needed.
  *  @param[in] inst pointer to calling instance of PSInterpreter
  *  @param[in] buf takes the read characters
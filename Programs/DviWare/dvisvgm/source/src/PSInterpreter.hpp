@@ -23,6 +23,7 @@
 
 #include <cstring>
 #include <istream>
+#include <memory>
 #include <string>
 #include <vector>
 #include "BoundingBox.hpp"
@@ -98,6 +99,19 @@ struct PSDeviceInfo {
 class PSInterpreter {
 	enum Mode {PS_NONE, PS_RUNNING, PS_QUIT};
 
+	public:
+		/** Defers the flushes requested by execute() until the outermost batch ends,
+		 *  so that a sequence of PS snippets only needs a single round trip. */
+		class Batch {
+			public:
+				explicit Batch (PSInterpreter &psi) : _psi(psi) {_psi._batchLevel++;}
+				Batch (const Batch &batch) =delete;
+				~Batch () {_psi.endBatch();}
+
+			private:
+				PSInterpreter &_psi;
+		};
+
 	public:
 		explicit PSInterpreter (PSActions *actions=nullptr);
 		PSInterpreter (const PSInterpreter &psi) =delete;
@@ -106,6 +120,8 @@ class PSInterpreter {
 		bool execute (const std::string &str, bool flush=true) {return execute(str.c_str(), flush);}
 		bool execute (std::istream &is, bool flush=true);
 		bool executeRaw (const std::string &str, int n);
+		void flush ();
+		bool reset ();
 		bool active () const                   {return _mode != PS_QUIT;}
 		void limit (size_t max_bytes)          {_bytesToRead = max_bytes;}
 		PSFilter* setFilter (PSFilter *filter);
@@ -129,6 +145,7 @@ class PSInterpreter {
 
 		void checkStatus (int status);
 		void callActions (InputReader &cib);
+		void endBatch ();
 
 	private:
 		Ghostscript _gs;
@@ -140,8 +157,30 @@ class PSInterpreter {
 		std::string _errorMessage;         ///< text of error message
 		bool _inError=false;               ///< true if scanning error message
 		bool _initialized=false;           ///< true if PSInterpreter has been completely initialized
+		int _batchLevel=0;                 ///< number of nested batches (see class Batch)
+		bool _flushPending=false;          ///< true if a flush has been deferred by a batch
 		std::vector<std::string> _rawData; ///< raw data received
 		static const char *PSDEFS;         ///< initial PostScript definitions
 };
 
+
+/** Keeps an initialized PSInterpreter for reuse, so that starting Ghostscript and
+ *  evaluating the PostScript definitions is necessary only once per process even
+ *  if several documents are converted. As Ghostscript usually doesn't support
+ *  multiple instances per process, at most one idle interpreter is kept. */
+class PSInterpreterPool {
+	public:
+		~PSInterpreterPool ();
+		static PSInterpreterPool& instance ();
+		std::unique_ptr<PSInterpreter> acquire (PSActions *actions);
+		void release (std::unique_ptr<PSInterpreter> psi);
+
+	protected:
+		PSInterpreterPool () =default;
+
+	private:
+		std::unique_ptr<PSInterpreter> _idle;
+		static bool _destroyed;  ///< true if the pool has already been destroyed at program exit
+};
+
 #endif
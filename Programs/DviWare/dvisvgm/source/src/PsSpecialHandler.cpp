@@ -54,7 +54,8 @@ string PsSpecialHandler::BITMAP_FORMAT;
 bool PsSpecialHandler::EMBED_BITMAP_DATA = false;
 
 
-PsSpecialHandler::PsSpecialHandler () : _psi(this), _previewFilter(_psi)
+PsSpecialHandler::PsSpecialHandler ()
+	: _psiPtr(PSInterpreterPool::instance().acquire(this)), _psi(*_psiPtr), _previewFilter(_psi)
 {
 	_psi.setImageDevice(BITMAP_FORMAT);
 }
@@ -62,6 +63,7 @@ PsSpecialHandler::PsSpecialHandler () : _psi(this), _previewFilter(_psi)
 
 PsSpecialHandler::~PsSpecialHandler () {
 	_psi.setActions(nullptr);     // ensure no further PS actions are performed
+	PSInterpreterPool::instance().release(std::move(_psiPtr));
 }
 
 
@@ -174,6 +176,7 @@ void PsSpecialHandler::executeAndSync (istream &is, bool updatePos) {
 	if (updatePos) {
 		// retrieve current PS position (stored in _currentpoint)
 		_psi.execute("\nquerypos ");
+		_psi.flush();
 		if (_actions) {
 			_actions->setX(_currentpoint.x());
 			_actions->setY(_currentpoint.y());
@@ -222,6 +225,7 @@ bool PsSpecialHandler::process (const string &prefix, istream &is, SpecialAction
 
 	if (prefix == "\"" || prefix == "pst:") {
 		// read and execute literal PostScript code (isolated by a wrapping save/restore pair)
+		PSInterpreter::Batch batch(_psi);  // flush the output of all snippets at once
 		moveToDVIPos();
 		_psi.execute("\n@beginspecial @setspecial ");
 		executeAndSync(is, false);
@@ -251,6 +255,7 @@ bool PsSpecialHandler::process (const string &prefix, istream &is, SpecialAction
 		}
 	}
 	else if (prefix == "ps::") {
+		PSInterpreter::Batch batch(_psi);
 		if (_actions)
 			_actions->finishLine();  // reset DVI position on next DVI command
 		if (is.peek() == '[') {
@@ -278,6 +283,7 @@ bool PsSpecialHandler::process (const string &prefix, istream &is, SpecialAction
 		}
 	}
 	else { // ps: ... or PST: ...
+		PSInterpreter::Batch batch(_psi);
 		if (_actions)
 			_actions->finishLine();
 		moveToDVIPos();
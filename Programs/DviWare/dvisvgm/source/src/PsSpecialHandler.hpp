@@ -176,7 +176,8 @@ class PsSpecialHandler : public SpecialHandler, protected PSActions {
 		void executed () override;
 
 	private:
-		PSInterpreter _psi;
+		std::unique_ptr<PSInterpreter> _psiPtr; ///< interpreter obtained from the PSInterpreterPool
+		PSInterpreter &_psi;
 		PDFHandler _pdfHandler;
 		SpecialActions *_actions=nullptr;
 		PSPreviewFilter _previewFilter;    ///< filter to extract information generated by the preview package
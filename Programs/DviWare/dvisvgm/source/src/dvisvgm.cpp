@@ -21,10 +21,13 @@
 #include <config.h>
 #include <algorithm>
 #include <clipper.hpp>
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <potracelib.h>
 #include <sstream>
+#include <thread>
 #include <vector>
 #include <zlib.h>
 #include "CommandLine.hpp"
@@ -39,9 +42,11 @@
 #include "HashFunction.hpp"
 #include "HyperlinkManager.hpp"
 #include "Message.hpp"
+#include "PageRanges.hpp"
 #include "PageSize.hpp"
 #include "PDFHandler.hpp"
 #include "PDFToSVG.hpp"
+#include "Process.hpp"
 #include "PSInterpreter.hpp"
 #include "PsSpecialHandler.hpp"
 #include "SignalHandler.hpp"
@@ -62,6 +67,9 @@
 #endif
 #if defined(MIKTEX)
 #  include <miktex/Definitions>
+#  include <miktex/Core/Directory>
+#  include <miktex/Core/Paths>
+#  include <miktex/Core/Session>
 #endif
 
 using namespace std;
@@ -111,6 +119,33 @@ static void set_libgs (CommandLine &args) {
 }
 
 
+#if defined(MIKTEX)
+/** Sets the cache directories managed by MiKTeX. The glyphs cached by the
+ *  administrator are shared with all users.
+ *  @return false if there's no MiKTeX session */
+static bool set_miktex_cache_dir () {
+	using namespace MiKTeX::Configuration;
+	using namespace MiKTeX::Core;
+	using MiKTeX::Util::PathName;
+	shared_ptr<Session> session = Session::TryGet();
+	if (!session)
+		return false;
+	PathName cacheDir = PathName(MIKTEX_PATH_MIKTEX_CACHE_DIR) / PathName("dvisvgm");
+	PathName commonCacheDir = session->GetSpecialPath(SpecialPath::CommonDataRoot) / cacheDir;
+	if (session->IsAdminMode())
+		PhysicalFont::CACHE_PATH = commonCacheDir.ToString();
+	else {
+		PathName userCacheDir = session->GetSpecialPath(SpecialPath::UserDataRoot) / cacheDir;
+		PhysicalFont::CACHE_PATH = userCacheDir.ToString();
+		if (session->IsSharedSetup() && userCacheDir != commonCacheDir)
+			PhysicalFont::SHARED_CACHE_PATH = commonCacheDir.ToString();
+	}
+	Directory::Create(PathName(PhysicalFont::CACHE_PATH));
+	return true;
+}
+#endif
+
+
 static bool set_cache_dir (const CommandLine &args) {
 	if (args.cacheOpt.given() && !args.cacheOpt.value().empty()) {
 		if (args.cacheOpt.value() == "none")
@@ -120,6 +155,10 @@ static bool set_cache_dir (const CommandLine &args) {
 		else
 			Message::wstream(true) << "cache directory '" << args.cacheOpt.value() << "' does not exist (caching disabled)\n";
 	}
+#if defined(MIKTEX)
+	else if (set_miktex_cache_dir())
+		;  // cache directories managed by MiKTeX
+#endif
 	else {
 		string &cachepath = PhysicalFont::CACHE_PATH;
 		const char *cachehome = getenv("XDG_CACHE_HOME");
@@ -142,6 +181,8 @@ static bool set_cache_dir (const CommandLine &args) {
 	}
 	if (args.cacheOpt.given() && args.cacheOpt.value().empty()) {
 		cout << "cache directory: " << (PhysicalFont::CACHE_PATH.empty() ? "(none)" : PhysicalFont::CACHE_PATH) << '\n';
+		if (!PhysicalFont::CACHE_PATH.empty() && !PhysicalFont::SHARED_CACHE_PATH.empty())
+			cout << "shared cache directory: " << PhysicalFont::SHARED_CACHE_PATH << '\n';
 		try {
 			if (!PhysicalFont::CACHE_PATH.empty())
 				FontCache::fontinfo(PhysicalFont::CACHE_PATH, cout, true);
@@ -414,7 +455,105 @@ static void timer_message (double start_time, const pair<int,int> *pageinfo) {
 }
 
 
-static void convert_file (size_t fnameIndex, const CommandLine &cmdline) {
+/** Returns the number of worker processes requested with option --jobs.
+ *  A value of 0 selects the number of available processor cores. */
+static unsigned number_of_jobs (const CommandLine &cmdline) {
+	if (cmdline.jobsOpt.value() > 0)
+		return unsigned(cmdline.jobsOpt.value());
+	return max(1u, thread::hardware_concurrency());
+}
+
+
+/** Converts the selected pages of a DVI file by several dvisvgm processes running
+ *  in parallel. The pages are split into contiguous chunks, one per process. Each
+ *  process gets the original command-line arguments together with the page range
+ *  of its chunk, so all of them use the same fonts, specials, and output settings.
+ *  Separate processes are used because the font and special handling of dvisvgm
+ *  relies on global state that can't be shared by concurrent threads.
+ *  @param[in] cmdline the parsed command-line
+ *  @param[in] args the original command-line arguments, starting with the program name
+ *  @param[in] numPages total number of pages of the DVI file
+ *  @param[out] pageinfo (number of converted pages, number of total pages)
+ *  @return false if there's nothing to parallelize, i.e. the pages must be converted by this process */
+static bool convert_pages_in_parallel (const CommandLine &cmdline, const vector<string> &args, int numPages, pair<int,int> &pageinfo) {
+	PageRanges ranges;
+	if (!ranges.parse(cmdline.pageOpt.value(), numPages))
+		throw MessageException("invalid page range format");
+	vector<int> pages;
+	for (const auto &range : ranges) {
+		for (int page=range.first; page <= min(range.second, numPages); page++)
+			pages.push_back(page);
+	}
+	size_t numJobs = min(size_t(number_of_jobs(cmdline)), pages.size());
+	if (numJobs < 2)
+		return false;
+
+	// options added in front of a trailing "--" which turns all following arguments into filenames
+	string params;
+	auto it = find(args.begin()+1, args.end(), "--");
+	for (auto argit=args.begin()+1; argit != args.end(); ++argit) {
+		if (argit == it)
+			params += "--jobs=1 --page=%s ";
+		if (argit->find_first_of(" \t") == string::npos)
+			params += *argit + " ";
+		else
+			params += "\"" + *argit + "\" ";
+	}
+	if (it == args.end())
+		params += "--jobs=1 --page=%s";
+
+	vector<string> chunkRanges;
+	for (size_t i=0; i < numJobs; i++) {
+		PageRanges chunk;
+		for (size_t j=i*pages.size()/numJobs; j < (i+1)*pages.size()/numJobs; j++)
+			chunk.addRange(pages[j]);
+		string rangestr;
+		for (const auto &range : chunk) {
+			if (!rangestr.empty())
+				rangestr += ",";
+			rangestr += to_string(range.first);
+			if (range.second > range.first)
+				rangestr += "-" + to_string(range.second);
+		}
+		chunkRanges.push_back(rangestr);
+	}
+	Message::mstream(false, Message::MC_PAGE_NUMBER) << "converting " << pages.size() << " pages in " << numJobs << " processes\n";
+
+	mutex outputMutex;
+	vector<string> failedRanges;
+	exception_ptr exception;  // e.g. SignalException thrown if CTRL-C was pressed
+	vector<thread> workers;
+	for (const string &rangestr : chunkRanges) {
+		workers.emplace_back([&, rangestr]() {
+			string jobParams = params;
+			jobParams.replace(jobParams.find("%s"), 2, rangestr);
+			string output;
+			try {
+				bool success = Process(args[0], jobParams).run(&output, Process::PF_STDERR);
+				lock_guard<mutex> lock(outputMutex);
+				cerr << output;  // messages of the worker, already filtered by its verbosity level
+				if (!success)
+					failedRanges.push_back(rangestr);
+			}
+			catch (...) {
+				lock_guard<mutex> lock(outputMutex);
+				exception = current_exception();
+			}
+		});
+	}
+	for (thread &worker : workers)
+		worker.join();
+	if (exception)
+		rethrow_exception(exception);
+	if (!failedRanges.empty())
+		throw MessageException("conversion of page(s) " + failedRanges.front() + " failed");
+	pageinfo.first = int(pages.size());
+	pageinfo.second = numPages;
+	return true;
+}
+
+
+static void convert_file (size_t fnameIndex, const CommandLine &cmdline, const vector<string> &args) {
 	const char *suffix = cmdline.epsOpt.given() ? "eps" : cmdline.pdfOpt.given() ? "pdf" : "dvi";
 	string inputfile = ensure_suffix(cmdline.filenames()[fnameIndex], suffix);
 	SourceInput srcin(inputfile);
@@ -447,7 +586,10 @@ static void convert_file (size_t fnameIndex, const CommandLine &cmdline) {
 			dvi2svg.setProcessSpecials(ignore_specials, true);
 			dvi2svg.setPageTransformation(get_transformation_string(cmdline));
 			dvi2svg.setPageSize(cmdline.bboxOpt.value());
-			dvi2svg.convert(cmdline.pageOpt.value(), &pageinfo);
+			bool parallel = cmdline.jobsOpt.value() != 1 && !cmdline.stdoutOpt.given() && !inputfile.empty()
+				&& convert_pages_in_parallel(cmdline, args, dvi2svg.numberOfPages(), pageinfo);
+			if (!parallel)
+				dvi2svg.convert(cmdline.pageOpt.value(), &pageinfo);
 			timer_message(start_time, &pageinfo);
 		}
 	}
@@ -494,8 +636,9 @@ int main (int argc, char *argv[]) {
 
 		SignalHandler::instance().start();
 		size_t numFiles = cmdline.epsOpt.given() ? cmdline.filenames().size() : 1;
+		vector<string> args(argv, argv+argc);
 		for (size_t i=0; i < numFiles; i++)
-			convert_file(i, cmdline);
+			convert_file(i, cmdline, args);
 	}
 	catch (DVIException &e) {
 		Message::estream() << "\nDVI error: " << e.what() << '\n';
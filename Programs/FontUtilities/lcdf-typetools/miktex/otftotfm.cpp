@@ -0,0 +1,134 @@
+/* lcdf-typetools/miktex/otftotfm.cpp: MiKTeX specials for otftotfm
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA.  */
+
+#include "otftotfm.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Session>
+#include <miktex/Util/PathName>
+
+using namespace std;
+
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+// installed files are registered in the file name database in one go,
+// when the font (or the variant) has been installed
+static vector<PathName> newFiles;
+
+void miktex_otftotfm_add_to_fndb(const char* path)
+{
+  PathName file(path);
+  file.MakeFullyQualified();
+  if (std::find(newFiles.begin(), newFiles.end(), file) == newFiles.end())
+  {
+    newFiles.push_back(file);
+  }
+}
+
+void miktex_otftotfm_update_fndb()
+{
+  vector<Fndb::Record> records;
+  for (const PathName& file : newFiles)
+  {
+    if (!Fndb::FileExists(file))
+    {
+      records.push_back({ file });
+    }
+  }
+  newFiles.clear();
+  if (!records.empty())
+  {
+    Fndb::Add(records);
+  }
+}
+
+// The metrics digest is the digest of the (V)PL file (without the
+// first comment line, which records the command line and the time)
+// followed by the digests of the TFM and VF files made from it.  If
+// the digest is unchanged, pltotf/vptovf need not run.
+
+static PathName MetricsDigestFile(const char* tfmFileName, const char* vfFileName)
+{
+  PathName tfmFile(tfmFileName);
+  tfmFile.MakeFullyQualified();
+  string key = tfmFile.ToString();
+  if (vfFileName != nullptr)
+  {
+    PathName vfFile(vfFileName);
+    vfFile.MakeFullyQualified();
+    key += "\n" + vfFile.ToString();
+  }
+  shared_ptr<Session> session = MIKTEX_SESSION();
+  return session->GetSpecialPath(session->IsAdminMode() ? SpecialPath::CommonDataRoot : SpecialPath::UserDataRoot)
+    / PathName(MIKTEX_PATH_MIKTEX_CACHE_DIR) / PathName("otftotfm") / PathName(MD5::FromChars(key).ToString());
+}
+
+static string MetricsDigest(const char* plFileName, const char* tfmFileName, const char* vfFileName)
+{
+  if (!File::Exists(PathName(tfmFileName)) || (vfFileName != nullptr && !File::Exists(PathName(vfFileName))))
+  {
+    return "";
+  }
+  vector<unsigned char> pl = File::ReadAllBytes(PathName(plFileName));
+  vector<unsigned char>::iterator body = std::find(pl.begin(), pl.end(), '\n');
+  MD5Builder md5Builder;
+  md5Builder.Update(body == pl.end() ? pl.data() : &*body, pl.end() - body);
+  string digest = md5Builder.Final().ToString();
+  digest += "\n" + MD5::FromFile(PathName(tfmFileName)).ToString();
+  if (vfFileName != nullptr)
+  {
+    digest += "\n" + MD5::FromFile(PathName(vfFileName)).ToString();
+  }
+  return digest + "\n";
+}
+
+bool miktex_otftotfm_metrics_unchanged(const char* plFileName, const char* tfmFileName, const char* vfFileName)
+{
+  PathName digestFile = MetricsDigestFile(tfmFileName, vfFileName);
+  if (!File::Exists(digestFile))
+  {
+    return false;
+  }
+  string digest = MetricsDigest(plFileName, tfmFileName, vfFileName);
+  vector<unsigned char> storedDigest = File::ReadAllBytes(digestFile);
+  return !digest.empty() && string(storedDigest.begin(), storedDigest.end()) == digest;
+}
+
+void miktex_otftotfm_remember_metrics(const char* plFileName, const char* tfmFileName, const char* vfFileName)
+{
+  string digest = MetricsDigest(plFileName, tfmFileName, vfFileName);
+  if (digest.empty())
+  {
+    return;
+  }
+  PathName digestFile = MetricsDigestFile(tfmFileName, vfFileName);
+  Directory::Create(digestFile.GetDirectoryName());
+  File::WriteBytes(digestFile, vector<unsigned char>(digest.begin(), digest.end()));
+}
@@ -0,0 +1,28 @@
+/* lcdf-typetools/miktex/otftotfm.h:
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA.  */
+
+#pragma once
+
+void miktex_otftotfm_add_to_fndb(const char* path);
+
+void miktex_otftotfm_update_fndb();
+
+bool miktex_otftotfm_metrics_unchanged(const char* plFileName, const char* tfmFileName, const char* vfFileName);
+
+void miktex_otftotfm_remember_metrics(const char* plFileName, const char* tfmFileName, const char* vfFileName);
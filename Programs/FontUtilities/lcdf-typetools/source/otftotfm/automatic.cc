@@ -39,6 +39,7 @@
 #include <algorithm>
 #if defined(MIKTEX)
 #include <miktex/Core/c/api.h>
+#include <miktex/otftotfm.h>
 #endif
 
 #ifdef WIN32
@@ -67,6 +68,9 @@ static String odir[NUMODIR];
 static String typeface;
 static String vendor;
 static String map_file;
+#if defined(MIKTEX)
+static String updmap_map_file;
+#endif
 #define DEFAULT_VENDOR "lcdftools"
 #define DEFAULT_TYPEFACE "unknown"
 
@@ -255,6 +259,20 @@ setodir(int o, const String &value)
     odir[o] = value;
 }
 
+#if defined(MIKTEX)
+void
+reset_automatic()
+{
+    for (int o = 0; o < NUMODIR; o++) {
+        odir[o] = String();
+#if HAVE_KPATHSEA
+        odir_kpathsea[o] = String();
+#endif
+    }
+    typeface = vendor = map_file = String();
+}
+#endif
+
 const char *
 odirname(int o)
 {
@@ -311,6 +329,13 @@ update_odir(int o, String file, ErrorHandler *errh)
     } else if (verbose)
         errh->message("updating %sls-R for %s/%s", writable_texdir.c_str(), directory.c_str(), file.c_str());
 
+#if defined(MIKTEX)
+    // no ls-R: the file name database is updated in one go, when the
+    // font has been installed
+    miktex_otftotfm_add_to_fndb((writable_texdir + (directory ? directory + "/" : String()) + file).c_str());
+    return;
+#endif
+
     // try to update ls-R ourselves, rather than running mktexupd --
     // mktexupd's runtime is painful: a half second to update a file
     String ls_r = writable_texdir + "ls-R";
@@ -581,6 +606,97 @@ installed_type42(const String &ttf_filename, const String &ps_fontname, bool all
     return String();
 }
 
+#if HAVE_KPATHSEA && !WIN32
+static void
+run_updmap(const String &map_filename, ErrorHandler *errh)
+{
+    // run 'updmap' if present
+    String updmap_prog = output_flags & G_UPDMAP_USER ? "updmap-user" : "updmap-sys";
+    String updmap_dir, updmap_file;
+    if (automatic && (output_flags & G_UPDMAP))
+        updmap_dir = getodir(O_MAP_PARENT, errh);
+    if (updmap_dir
+        && (updmap_file = updmap_dir + "/" + updmap_prog)
+        && access(updmap_file.c_str(), X_OK) >= 0) {
+        // want to run `updmap` from its directory, can't use system()
+        if (verbose)
+            errh->message("running %s", updmap_file.c_str());
+
+        pid_t child = fork();
+        if (child < 0)
+            errh->fatal("%s during fork", strerror(errno));
+        else if (child == 0) {
+            // change to updmap directory, run it
+            if (chdir(updmap_dir.c_str()) < 0)
+                errh->fatal("%s: %s during chdir", updmap_dir.c_str(), strerror(errno));
+            if (execl(output_flags & G_UPDMAP_USER ? "./updmap-user" : "./updmap-sys",
+                      updmap_file.c_str(),
+                      (const char*) 0) < 0)
+                errh->fatal("%s: %s during exec", updmap_file.c_str(), strerror(errno));
+            exit(1);        // should never get here
+        }
+
+# if HAVE_WAITPID
+        // wait for updmap to finish
+        int status;
+        while (1) {
+            pid_t answer = waitpid(child, &status, 0);
+            if (answer >= 0)
+                break;
+            else if (errno != EINTR)
+                errh->fatal("%s during wait", strerror(errno));
+        }
+        if (!WIFEXITED(status))
+            errh->warning("%s exited abnormally", updmap_file.c_str());
+        else if (WEXITSTATUS(status) != 0)
+            errh->warning("%s exited with status %d", updmap_file.c_str(), WEXITSTATUS(status));
+# else
+#  error "need waitpid() support: report this bug to the maintainer"
+# endif
+        return;
+    }
+
+# if HAVE_AUTO_UPDMAP
+    // run system updmap
+    if (output_flags & G_UPDMAP) {
+        String filename = map_filename;
+        int slash = filename.find_right('/');
+        if (slash >= 0)
+            filename = filename.substring(slash + 1);
+        String redirect = verbose ? " 1>&2" : " >" DEV_NULL " 2>&1";
+        String command = updmap_prog + " --nomkmap --enable Map " + shell_quote(filename) + redirect
+            + CMD_SEP " " + updmap_prog + redirect;
+        int retval = mysystem(command.c_str(), errh);
+        if (retval == 127)
+            errh->warning("could not run %<%s%>", command.c_str());
+        else if (retval < 0)
+            errh->warning("could not run %<%s%>: %s", command.c_str(), strerror(errno));
+        else if (retval != 0)
+            errh->warning("%<%s%> exited with status %d;\nrun it manually to check for errors", command.c_str(), WEXITSTATUS(retval));
+        return;
+    }
+# endif
+
+    if (verbose)
+        errh->message("not running updmap");
+}
+#endif
+
+#if defined(MIKTEX)
+void
+run_pending_updmap(ErrorHandler *errh)
+{
+#if HAVE_KPATHSEA && !WIN32
+    if (updmap_map_file) {
+        run_updmap(updmap_map_file, errh);
+        updmap_map_file = String();
+    }
+#else
+    (void) errh;
+#endif
+}
+#endif
+
 int
 update_autofont_map(const String &fontname, String mapline, ErrorHandler *errh)
 {
@@ -699,77 +815,12 @@ update_autofont_map(const String &fontname, String mapline, ErrorHandler *errh)
             update_odir(O_MAP, map_file, errh);
 
 #if HAVE_KPATHSEA && !WIN32
-        // run 'updmap' if present
-        String updmap_prog = output_flags & G_UPDMAP_USER ? "updmap-user" : "updmap-sys";
-        String updmap_dir, updmap_file;
-        if (automatic && (output_flags & G_UPDMAP))
-            updmap_dir = getodir(O_MAP_PARENT, errh);
-        if (updmap_dir
-            && (updmap_file = updmap_dir + "/" + updmap_prog)
-            && access(updmap_file.c_str(), X_OK) >= 0) {
-            // want to run `updmap` from its directory, can't use system()
-            if (verbose)
-                errh->message("running %s", updmap_file.c_str());
-
-            pid_t child = fork();
-            if (child < 0)
-                errh->fatal("%s during fork", strerror(errno));
-            else if (child == 0) {
-                // change to updmap directory, run it
-                if (chdir(updmap_dir.c_str()) < 0)
-                    errh->fatal("%s: %s during chdir", updmap_dir.c_str(), strerror(errno));
-                if (execl(output_flags & G_UPDMAP_USER ? "./updmap-user" : "./updmap-sys",
-                          updmap_file.c_str(),
-                          (const char*) 0) < 0)
-                    errh->fatal("%s: %s during exec", updmap_file.c_str(), strerror(errno));
-                exit(1);        // should never get here
-            }
-
-# if HAVE_WAITPID
-            // wait for updmap to finish
-            int status;
-            while (1) {
-                pid_t answer = waitpid(child, &status, 0);
-                if (answer >= 0)
-                    break;
-                else if (errno != EINTR)
-                    errh->fatal("%s during wait", strerror(errno));
-            }
-            if (!WIFEXITED(status))
-                errh->warning("%s exited abnormally", updmap_file.c_str());
-            else if (WEXITSTATUS(status) != 0)
-                errh->warning("%s exited with status %d", updmap_file.c_str(), WEXITSTATUS(status));
+# if defined(MIKTEX)
+        // updmap runs once, when all fonts have been installed
+        updmap_map_file = map_file;
 # else
-#  error "need waitpid() support: report this bug to the maintainer"
+        run_updmap(map_file, errh);
 # endif
-            goto ran_updmap;
-        }
-
-# if HAVE_AUTO_UPDMAP
-        // run system updmap
-        if (output_flags & G_UPDMAP) {
-            String filename = map_file;
-            int slash = filename.find_right('/');
-            if (slash >= 0)
-                filename = filename.substring(slash + 1);
-            String redirect = verbose ? " 1>&2" : " >" DEV_NULL " 2>&1";
-            String command = updmap_prog + " --nomkmap --enable Map " + shell_quote(filename) + redirect
-                + CMD_SEP " " + updmap_prog + redirect;
-            int retval = mysystem(command.c_str(), errh);
-            if (retval == 127)
-                errh->warning("could not run %<%s%>", command.c_str());
-            else if (retval < 0)
-                errh->warning("could not run %<%s%>: %s", command.c_str(), strerror(errno));
-            else if (retval != 0)
-                errh->warning("%<%s%> exited with status %d;\nrun it manually to check for errors", command.c_str(), WEXITSTATUS(retval));
-            goto ran_updmap;
-        }
-# endif
-
-        if (verbose)
-            errh->message("not running updmap");
-
-      ran_updmap: ;
 #endif
     }
 
@@ -23,5 +23,9 @@ String installed_truetype(const String &ttf_filename, bool allow_generate, Error
 String installed_type42(const String &ttf_filename, const String &ps_fontname, bool allow_generate, ErrorHandler *errh);
 int update_autofont_map(const String &fontname, String mapline, ErrorHandler *);
 String locate_encoding(String encfile, ErrorHandler *, bool literal = false);
+#if defined(MIKTEX)
+void reset_automatic();
+void run_pending_updmap(ErrorHandler *);
+#endif
 
 #endif
@@ -16,6 +16,7 @@
 #endif
 #if defined(MIKTEX)
 #include <miktex/Core/c/api.h>
+#include <miktex/otftotfm.h>
 #endif
 #ifdef WIN32
 # define _USE_MATH_DEFINES
@@ -304,6 +305,10 @@ bool quiet = false;
 bool force = false;
 
 static String otf_data;
+#if defined(MIKTEX)
+static String otf_data_file;
+static Vector<String> read_glyphlist_files;
+#endif
 
 
 void
@@ -390,8 +395,12 @@ Output options:\n\
       --no-virtual             Do not generate VFs or VPLs.\n\
       --no-encoding            Do not generate an encoding file.\n\
       --no-map                 Do not generate a psfonts.map line.\n\
-      --output-encoding[=FILE] Only generate an encoding file.\n\
-\n");
+      --output-encoding[=FILE] Only generate an encoding file.\n"
+#if defined(MIKTEX)
+"      --variants=FILE          Generate a font for each line of FILE, which\n\
+                               holds the options for that font.\n"
+#endif
+"\n");
     uerrh.message("\
 File location options:\n\
       --tfm-directory=DIR      Put TFM files in DIR [.|automatic].\n\
@@ -1180,6 +1189,17 @@ output_tfm(Metrics &metrics, const String &ps_name, int boundary_char,
         }
     }
 
+#if defined(MIKTEX)
+    if (!no_create && !force
+        && miktex_otftotfm_metrics_unchanged(pl_filename.c_str(), tfm_filename.c_str(), vpl ? vf_filename.c_str() : 0)) {
+        if (verbose)
+            errh->message("%s unchanged", tfm_filename.c_str());
+        if (!had_pl_filename)
+            unlink(pl_filename.c_str());
+        return;
+    }
+#endif
+
     StringAccum command;
     if (vpl)
         command << "vptovf " << shell_quote(pl_filename) << ' ' << shell_quote(vf_filename) << ' ' << shell_quote(tfm_filename) << " 2>&1";
@@ -1229,6 +1249,11 @@ output_tfm(Metrics &metrics, const String &ps_name, int boundary_char,
     } else
         status = -1;
 
+#if defined(MIKTEX)
+    if (!no_create && status == 0)
+        miktex_otftotfm_remember_metrics(pl_filename.c_str(), tfm_filename.c_str(), vpl ? vf_filename.c_str() : 0);
+#endif
+
     if (!no_create && !had_pl_filename)
         unlink(pl_filename.c_str());
 
@@ -1848,10 +1873,11 @@ parse_base_encodings(const String &filename, ErrorHandler *errh)
     }
 }
 
-int
 #if defined(MIKTEX)
-Main(int argc, char** argv)
+static int
+otftotfm(int argc, char** argv)
 #else
+int
 main(int argc, char *argv[])
 #endif
 {
@@ -2352,7 +2378,15 @@ particular purpose.\n");
 
     try {
         // read font
+#if defined(MIKTEX)
+        // with --variants, the font is read once
+        if (input_file != otf_data_file) {
+            otf_data = read_file(input_file, errh);
+            otf_data_file = (errh->nerrors() ? String() : String(input_file));
+        }
+#else
         otf_data = read_file(input_file, errh);
+#endif
         if (errh->nerrors())
             exit(1);
 
@@ -2391,9 +2425,15 @@ particular purpose.\n");
         }
 
         // read glyphlist
-        for (String *g = glyphlist_files.begin(); g < glyphlist_files.end(); g++)
+        for (String *g = glyphlist_files.begin(); g < glyphlist_files.end(); g++) {
+#if defined(MIKTEX)
+            if (std::find(read_glyphlist_files.begin(), read_glyphlist_files.end(), *g) != read_glyphlist_files.end())
+                continue;
+            read_glyphlist_files.push_back(*g);
+#endif
             if (String s = read_file(*g, errh, true))
                 DvipsEncoding::add_glyphlist(s);
+        }
 
         // read base encodings
         for (String *s = base_encoding_files.begin(); s < base_encoding_files.end(); s++)
@@ -2458,3 +2498,118 @@ particular purpose.\n");
     Clp_DeleteParser(clp);
     return (errh->nerrors() == 0 ? 0 : 1);
 }
+
+#if defined(MIKTEX)
+static void
+reset_options()
+{
+    interesting_scripts.clear();
+    interesting_features.clear();
+    altselector_features.clear();
+    feature_filters.clear();
+    altselector_feature_filters.clear();
+    font_name = encoding_file = String();
+    for (BaseEncoding **be = base_encodings.begin(); be != base_encodings.end(); be++)
+        delete *be;
+    base_encodings.clear();
+    extend = slant = 0;
+    letterspace = 0;
+    design_size = 0;
+    minimum_kern = 2.0;
+    space_factor = 1.0;
+    math_spacing = false;
+    skew_char = -1;
+    override_is_fixed_pitch = override_italic_angle = false;
+    override_x_height = FontInfo::x_height_auto;
+    out_encoding_file = out_encoding_name = String();
+    output_flags = G_ENCODING | G_METRICS | G_VMETRICS | G_PSFONTSMAP | G_TYPE1 | G_DOTLESSJ | G_UPDMAP | G_TRUETYPE;
+    automatic = verbose = no_create = quiet = force = false;
+    invocation.clear();
+    reset_automatic();
+}
+
+static Vector<String>
+split_variant(const String &line)
+{
+    Vector<String> words;
+    const char *s = line.begin(), *end = line.end();
+    while (1) {
+        while (s != end && isspace((unsigned char) *s))
+            ++s;
+        if (s == end)
+            return words;
+        StringAccum sa;
+        while (s != end && !isspace((unsigned char) *s))
+            if (*s == '\"' || *s == '\'') {
+                char quote = *s++;
+                while (s != end && *s != quote)
+                    sa << *s++;
+                if (s != end)
+                    ++s;
+            } else
+                sa << *s++;
+        words.push_back(sa.take_string());
+    }
+}
+
+// --variants=FILE: each line of FILE holds the options of one font to
+// be generated (encoding, features, font name, ...), which are added
+// to the other options.  The OpenType font is read once for all of
+// them, and updmap runs once, when all fonts have been generated.
+int
+Main(int argc, char** argv)
+{
+    Vector<const char*> args;
+    String variants_file;
+    for (int i = 0; i < argc; i++)
+        if (strncmp(argv[i], "--variants=", 11) == 0)
+            variants_file = argv[i] + 11;
+        else if (strcmp(argv[i], "--variants") == 0 && i + 1 < argc)
+            variants_file = argv[++i];
+        else
+            args.push_back(argv[i]);
+
+    int status = 0;
+    if (!variants_file) {
+        try {
+            status = otftotfm(argc, argv);
+        } catch (int exit_code) {
+            status = exit_code;
+        }
+        miktex_otftotfm_update_fndb();
+        run_pending_updmap(ErrorHandler::default_handler());
+        return status;
+    }
+
+    ErrorHandler *errh = ErrorHandler::static_initialize(new FileErrorHandler(stderr, "otftotfm: "));
+    String text = read_file(variants_file, errh);
+    if (errh->nerrors())
+        return 1;
+    int pos = 0;
+    while (pos < text.length()) {
+        int nl = text.find_left('\n', pos);
+        if (nl < 0)
+            nl = text.length();
+        Vector<String> words = split_variant(text.substring(pos, nl - pos));
+        pos = nl + 1;
+        if (!words.size() || words[0][0] == '%')
+            continue;
+        Vector<const char*> variant_args(args);
+        for (int i = 0; i < words.size(); i++)
+            variant_args.push_back(words[i].c_str());
+        variant_args.push_back(0);
+        reset_options();
+        try {
+            if (otftotfm(variant_args.size() - 1, (char**) variant_args.begin()) != 0)
+                status = 1;
+        } catch (int exit_code) {
+            if (exit_code != 0)
+                status = 1;
+        }
+        // the next font may refer to files installed for this one
+        miktex_otftotfm_update_fndb();
+    }
+    run_pending_updmap(errh);
+    return status;
+}
+#endif
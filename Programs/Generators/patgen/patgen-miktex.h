@@ -23,6 +23,14 @@
 
 #include "patgen-version.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include <miktex/TeXAndFriends/WebApp>
 
 #if !defined(MIKTEXHELP_PATGEN)
@@ -36,12 +44,294 @@ extern PATGENPROGCLASS PATGENPROG;
 class PATGENAPPCLASS :
   public MiKTeX::TeXAndFriends::WebApp
 {
+#define OPT_THREADS 1000
+
+public:
+  void AddOptions() override
+  {
+    WebApp::AddOptions();
+    AddOption(MIKTEXTEXT("threads\0Use N threads when collecting pattern counts."), OPT_THREADS, POPT_ARG_STRING, "N");
+  }
+
 public:
   std::string GetUsage() const override
   {
     return MIKTEXTEXT("[OPTION...] DICTIONARY PATTERNS OUTPUT TRANSLATE");
   }
 
+public:
+  bool ProcessOption(int opt, const std::string& optArg) override
+  {
+    bool done = true;
+    switch (opt)
+      {
+      case OPT_THREADS:
+        threads = std::atoi(optArg.c_str());
+        if (threads < 1)
+        {
+          FatalError(MIKTEXTEXT("Invalid number of threads."));
+        }
+        break;
+      default:
+        done = WebApp::ProcessOption(opt, optArg);
+        break;
+      }
+    return done;
+  }
+
+  // A counting pass (|procesp|) is a reduction over the words of the
+  // dictionary: the words are read as usual, then hyphenated and counted
+  // by several threads, each one working on a contiguous range of words
+  // and collecting the counts in a table of its own.  The tables are
+  // merged into the count trie in word order, so the patterns are
+  // inserted in the same order as in a sequential pass and the count trie
+  // (and everything printed) is the same for any number of threads.
+
+public:
+  void AddWord()
+  {
+    int wlen = PATGENPROG.wlen;
+    wordStart.push_back(wordChars.size());
+    for (int pos = 0; pos <= wlen; ++pos)
+    {
+      wordChars.push_back(PATGENPROG.word[pos]);
+      wordDots.push_back(PATGENPROG.dots[pos]);
+      wordDotw.push_back(PATGENPROG.dotw[pos]);
+    }
+  }
+
+public:
+  void CountWords(int maxVal)
+  {
+    std::size_t nWords = wordStart.size();
+    wordStart.push_back(wordChars.size());
+    int nThreads = threads > 0 ? threads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    if (static_cast<std::size_t>(nThreads) > nWords)
+    {
+      nThreads = std::max<int>(1, nWords);
+    }
+    counts.clear();
+    counts.resize(nThreads);
+    std::vector<std::thread> workers;
+    for (int n = 1; n < nThreads; ++n)
+    {
+      workers.emplace_back(&PATGENAPPCLASS::CountRange, this, maxVal, std::ref(counts[n]), nWords * n / nThreads, nWords * (n + 1) / nThreads);
+    }
+    CountRange(maxVal, counts[0], 0, nWords / nThreads);
+    for (std::thread& t : workers)
+    {
+      t.join();
+    }
+    for (const Counts& c : counts)
+    {
+      PATGENPROG.goodcount += c.goodCount;
+      PATGENPROG.badcount += c.badCount;
+      PATGENPROG.misscount += c.missCount;
+    }
+    wordStart.clear();
+    wordChars.clear();
+    wordDots.clear();
+    wordDotw.clear();
+    nextCounts = 0;
+    nextPattern = 0;
+  }
+
+public:
+  bool NextPattern()
+  {
+    while (nextCounts < counts.size() && nextPattern == counts[nextCounts].patterns.size())
+    {
+      ++nextCounts;
+      nextPattern = 0;
+    }
+    if (nextCounts == counts.size())
+    {
+      counts.clear();
+      return false;
+    }
+    const Counts& c = counts[nextCounts];
+    const std::string& pat = c.patterns[nextPattern];
+    for (std::size_t i = 0; i < pat.length(); ++i)
+    {
+      PATGENPROG.word[i + 1] = static_cast<unsigned char>(pat[i]);
+    }
+    goodWeight = c.good[nextPattern];
+    badWeight = c.bad[nextPattern];
+    ++nextPattern;
+    return true;
+  }
+
+public:
+  int GoodWeight() const
+  {
+    return goodWeight;
+  }
+
+public:
+  int BadWeight() const
+  {
+    return badWeight;
+  }
+
+private:
+  struct Counts
+  {
+    int goodCount = 0;
+    int badCount = 0;
+    int missCount = 0;
+    // patterns in the order of their first occurrence
+    std::vector<std::string> patterns;
+    std::vector<int> good;
+    std::vector<int> bad;
+    std::unordered_map<std::string, std::size_t> index;
+  };
+
+  // same as |hyphenate|, |change_dots| and |do_word|, but with the
+  // current word and the counts kept local to the thread
+private:
+  void CountRange(int maxVal, Counts& c, std::size_t first, std::size_t last)
+  {
+    const int trieRoot = 1;
+    const int isHyf = 2;
+    const int errHyf = 1;
+    const int foundHyf = 3;
+    const int hyphLevel = PATGENPROG.hyphlevel;
+    const int patLen = PATGENPROG.patlen;
+    const int patDot = PATGENPROG.patdot;
+    const int hyfMin = PATGENPROG.hyfmin;
+    const int hyfMax = PATGENPROG.hyfmax;
+    const int dotMin = PATGENPROG.dotmin;
+    const int dotMax = PATGENPROG.dotmax;
+    const int dotLen = PATGENPROG.dotlen;
+    const int goodDot = PATGENPROG.gooddot;
+    const int badDot = PATGENPROG.baddot;
+    std::vector<int> dots;
+    std::vector<int> hval;
+    std::vector<bool> noMore;
+    std::string pat;
+    for (std::size_t w = first; w < last; ++w)
+    {
+      const int* word = &wordChars[wordStart[w]];
+      const int* dotw = &wordDotw[wordStart[w]];
+      int wlen = static_cast<int>(wordStart[w + 1] - wordStart[w]) - 1;
+      dots.assign(wordDots.begin() + wordStart[w], wordDots.begin() + wordStart[w + 1]);
+      hval.assign(wlen + 1, 0);
+      noMore.assign(wlen + 1, false);
+      for (int spos = wlen - hyfMax; spos >= 0; --spos)
+      {
+        int fpos = spos + 1;
+        int t = trieRoot + word[fpos];
+        do
+        {
+          for (int h = PATGENPROG.trier[t]; h > 0; h = PATGENPROG.ops[h].op)
+          {
+            int dpos = spos + PATGENPROG.ops[h].dot;
+            int v = PATGENPROG.ops[h].val;
+            if (v < maxVal && hval[dpos] < v)
+            {
+              hval[dpos] = v;
+            }
+            if (v >= hyphLevel && fpos - patLen <= dpos - patDot && dpos - patDot <= spos)
+            {
+              noMore[dpos] = true;
+            }
+          }
+          t = PATGENPROG.triel[t];
+          if (t == 0)
+          {
+            break;
+          }
+          ++fpos;
+          t += word[fpos];
+        } while (PATGENPROG.triec[t] == word[fpos]);
+      }
+      for (int dpos = wlen - hyfMax; dpos >= hyfMin; --dpos)
+      {
+        if (hval[dpos] % 2 == 1)
+        {
+          ++dots[dpos];
+        }
+        if (dots[dpos] == foundHyf)
+        {
+          c.goodCount += dotw[dpos];
+        }
+        else if (dots[dpos] == errHyf)
+        {
+          c.badCount += dotw[dpos];
+        }
+        else if (dots[dpos] == isHyf)
+        {
+          c.missCount += dotw[dpos];
+        }
+      }
+      if (wlen < dotLen)
+      {
+        continue;
+      }
+      for (int dpos = wlen - dotMax; dpos >= dotMin; --dpos)
+      {
+        if (noMore[dpos] || (dots[dpos] != goodDot && dots[dpos] != badDot))
+        {
+          continue;
+        }
+        int spos = dpos - patDot;
+        pat.assign(word + spos + 1, word + spos + patLen + 1);
+        auto it = c.index.find(pat);
+        std::size_t idx;
+        if (it == c.index.end())
+        {
+          idx = c.patterns.size();
+          c.index[pat] = idx;
+          c.patterns.push_back(pat);
+          c.good.push_back(0);
+          c.bad.push_back(0);
+        }
+        else
+        {
+          idx = it->second;
+        }
+        if (dots[dpos] == goodDot)
+        {
+          c.good[idx] += dotw[dpos];
+        }
+        else
+        {
+          c.bad[idx] += dotw[dpos];
+        }
+      }
+    }
+  }
+
+private:
+  int threads = 0;
+
+private:
+  std::vector<std::size_t> wordStart;
+
+private:
+  std::vector<int> wordChars;
+
+private:
+  std::vector<int> wordDots;
+
+private:
+  std::vector<int> wordDotw;
+
+private:
+  std::vector<Counts> counts;
+
+private:
+  std::size_t nextCounts = 0;
+
+private:
+  std::size_t nextPattern = 0;
+
+private:
+  int goodWeight = 0;
+
+private:
+  int badWeight = 0;
+
 // TODO
 #if 0
 public:
@@ -53,3 +343,28 @@ public:
 };
 
 extern PATGENAPPCLASS PATGENAPP;
+
+inline void miktexaddword()
+{
+  PATGENAPP.AddWord();
+}
+
+inline void miktexcountwords(int maxVal)
+{
+  PATGENAPP.CountWords(maxVal);
+}
+
+inline bool miktexnextpattern()
+{
+  return PATGENAPP.NextPattern();
+}
+
+inline int miktexgoodweight()
+{
+  return PATGENAPP.GoodWeight();
+}
+
+inline int miktexbadweight()
+{
+  return PATGENAPP.BadWeight();
+}
@@ -1,6 +1,6 @@
 /* miktex.cpp
 
-   Copyright (C) 2015-2018 Christian Schenk
+   Copyright (C) 2015-2023 Christian Schenk
 
    This file is free software; you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published
@@ -18,9 +18,18 @@
    USA.  */
 
 #include <cstdio>
+
+#if defined(MIKTEX_WINDOWS)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include <miktex/Core/File>
 #include <miktex/Core/Session>
+#include <miktex/Util/PathName>
 
 using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
 
 MIKTEX_BEGIN_EXTERN_C_BLOCK;
 
@@ -57,4 +66,32 @@ void set_program_name(const char* argv0)
   session->PushAppName("psutils");
 }
 
+// creates a temporary file (in the MiKTeX temporary directory) which is
+// removed when it is closed
+FILE* miktex_psutils_tmpfile()
+{
+  try
+  {
+    PathName path;
+    path.SetToTempFile();
+#if defined(MIKTEX_WINDOWS)
+    int fd = _wopen(path.ToWideCharString().c_str(), _O_RDWR | _O_BINARY | _O_TEMPORARY | _O_SHORT_LIVED);
+    if (fd < 0)
+    {
+      File::Delete(path);
+      return nullptr;
+    }
+    return _fdopen(fd, "w+b");
+#else
+    FILE* file = fopen(path.GetData(), "w+b");
+    File::Delete(path);
+    return file;
+#endif
+  }
+  catch (const MiKTeXException&)
+  {
+    return nullptr;
+  }
+}
+
 MIKTEX_END_EXTERN_C_BLOCK;
@@ -97,23 +97,44 @@ int paper_size(const char *paper_name, double *width, double *height)
 }
 #endif /* not used for TeXLive */
 
+#if defined(MIKTEX)
+/* The input is read sequentially (copied to the temporary file, scanned
+   for pages) in large blocks. */
+#define SPOOL_BUFSIZ (1024 * 1024)
+#endif
+
 /* Make a file seekable, using temporary files if necessary */
 FILE *seekable(FILE *fp)
 {
   FILE *ft;
   long r, w ;
   char *p;
+#if defined(MIKTEX)
+  static char buffer[SPOOL_BUFSIZ] ;
+#else
   char buffer[BUFSIZ] ;
+#endif
   off_t fpos;
 
+#if defined(MIKTEX)
+  setvbuf(fp, NULL, _IOFBF, SPOOL_BUFSIZ);
+#endif
+
   if ((fpos = ftello(fp)) >= 0)
     if (!fseeko(fp, (off_t) 0, SEEK_END) && !fseeko(fp, fpos, SEEK_SET))
       return (fp);
 
+#if defined(MIKTEX)
+  /* tmpfile() creates the file in the root directory on Windows */
+  if ((ft = miktex_psutils_tmpfile()) == NULL)
+    return (NULL);
+  setvbuf(ft, NULL, _IOFBF, SPOOL_BUFSIZ);
+#else
   if ((ft = tmpfile()) == NULL)
     return (NULL);
+#endif
 
-  while ((r = fread(p = buffer, sizeof(char), BUFSIZ, fp)) > 0) {
+  while ((r = fread(p = buffer, sizeof(char), sizeof(buffer), fp)) > 0) {
     do {
       if ((w = fwrite(p, sizeof(char), r, ft)) == 0)
 	return (NULL) ;
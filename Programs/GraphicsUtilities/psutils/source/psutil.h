@@ -14,6 +14,11 @@
 #include <sys/types.h>
 #include <getopt.h>
 #include <fcntl.h>
+#if defined(_WIN32)
+/* off_t is 32 bits wide on Windows; page offsets in multi-GB files need
+   64 bits (see ftello/fseeko in config.h) */
+#define off_t long long
+#endif
 #endif
 
 /* Definitions for functions found in psutil.c */
@@ -22,6 +27,9 @@ extern void die(const char *format, ...);
 extern void argerror(void);
 extern int paper_size(const char *paper_name, double *width, double *height);
 extern FILE *seekable(FILE *fp);
+#if defined(MIKTEX)
+extern FILE *miktex_psutils_tmpfile(void);
+#endif
 extern void writepage(int p);
 extern void seekpage(int p);
 extern void writepageheader(const char *label, int p);
@@ -32,7 +32,14 @@
 #include <locale.h>
 #endif
 
+#if defined(MIKTEX)
+#include <atomic>
+static	std::atomic<long>	idx_gc;
+/* TRUE while entries are compared by several threads */
+static	int	in_parallel_sort = FALSE;
+#else
 static	long	idx_gc;
+#endif
 
 static int check_mixsym (const char *x, const char *y);
 static int compare (const void *va, const void *vb);
@@ -48,6 +55,10 @@ sort_idx(void)
 #ifdef HAVE_SETLOCALE
     char *prev_locale;
 #endif
+#if defined(MIKTEX)
+    int     first;
+    int     i;
+#endif
 
     MESSAGE("Sorting entries...");
 #ifdef HAVE_SETLOCALE
@@ -56,11 +67,27 @@ sort_idx(void)
 #endif
     idx_dc = 0;
     idx_gc = 0L;
+#if defined(MIKTEX)
+    in_parallel_sort = TRUE;
+    miktex_parallel_sort(idx_key, (size_t)idx_gt, sizeof(FIELD_PTR), compare);
+    in_parallel_sort = FALSE;
+    /* equal entries are adjacent now: mark the duplicates of the first
+       entry of each run */
+    for (first = 0, i = 1; i < idx_gt; i++) {
+	if (compare(&idx_key[first], &idx_key[i]) != 0)
+	    first = i;
+    }
+#else
     qqsort(idx_key, (size_t)idx_gt, sizeof(FIELD_PTR), compare);
+#endif
 #ifdef HAVE_SETLOCALE
     setlocale(LC_COLLATE, prev_locale);
 #endif
+#if defined(MIKTEX)
+    MESSAGE1("done (%ld comparisons).\n", idx_gc.load());
+#else
     MESSAGE1("done (%ld comparisons).\n", idx_gc);
+#endif
 }
 
 static int
@@ -77,6 +104,9 @@ compare(const void *va, const void *vb)
     int     dif;
 
     idx_gc++;
+#if defined(MIKTEX)
+    if (!in_parallel_sort)
+#endif
     IDX_DOT(CMP_MAX);
 
     for (i = 0; i < FIELD_MAX; i++) {
@@ -269,8 +299,14 @@ compare_page(const FIELD_PTR *a, const FIELD_PTR *b)
 	    {
 		/* If neither are yet marked duplicate, mark the second
 		of them to be ignored. */
+#if defined(MIKTEX)
+		if (!in_parallel_sort &&
+		    ((*a)->type != DUPLICATE) &&
+		    ((*b)->type != DUPLICATE))
+#else
 		if (((*a)->type != DUPLICATE) &&
 		    ((*b)->type != DUPLICATE))
+#endif
 		    (*b)->type = DUPLICATE;
 		/* leave m == 0 to show equality */
 	    }
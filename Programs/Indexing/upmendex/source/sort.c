@@ -24,6 +24,10 @@
 int sym,nmbr,ltn,kana,hngl,hnz,cyr,grk,dvng,thai,arab,hbrw;
 
 static int wcomp(const void *p, const void *q);
+#if defined(MIKTEX)
+static void keysort(struct index *ind, int num);
+static int kcomp(const void *p, const void *q);
+#endif
 static int pcomp(const void *p, const void *q);
 static int ordering(UChar *c);
 static int get_charset_juncture(UChar *str);
@@ -167,9 +171,122 @@ BREAK:
 	if (arab==0) arab=order++;
 	if (hbrw==0) hbrw=order++;
 
+#if defined(MIKTEX)
+	if (priority==0) {
+		keysort(ind,num);
+		return;
+	}
+#endif
 	qsort(ind,num,sizeof(struct index),wcomp);
 }
 
+#if defined(MIKTEX)
+/*   entry with its precomputed sort key   */
+struct keyed_index {
+	struct index *entry;
+	uint8_t *key;
+	int32_t len, size;
+};
+
+static void append_bytes(struct keyed_index *k, const uint8_t *bytes, int32_t n)
+{
+	if (k->len+n>k->size) {
+		k->size=(k->len+n)*2;
+		k->key=xrealloc(k->key,k->size);
+	}
+	memcpy(&k->key[k->len],bytes,n);
+	k->len+=n;
+}
+
+static void append_byte(struct keyed_index *k, uint8_t b)
+{
+	append_bytes(k,&b,1);
+}
+
+/*   ICU sort key, including its terminating zero byte   */
+static void append_collation_key(struct keyed_index *k, const UChar *str)
+{
+	int32_t n;
+
+	n=ucol_getSortKey(icu_collator,str,-1,NULL,0);
+	if (k->len+n>k->size) {
+		k->size=(k->len+n)*2;
+		k->key=xrealloc(k->key,k->size);
+	}
+	ucol_getSortKey(icu_collator,str,-1,&k->key[k->len],n);
+	k->len+=n;
+}
+
+/*   build a key whose byte order is the order of wcomp() (priority 0)   */
+static void make_key(struct keyed_index *k)
+{
+	const struct index *index1=k->entry;
+	const UChar *str;
+	int j;
+
+	for (j=0;j<3;j++) {
+/*   level   */
+		append_byte(k,(*index1).words==j ? 0 : 1);
+
+/*   group and collation of the reading   */
+		if ((*index1).dic[j][0]==L'\0')
+			append_byte(k,0);
+		else {
+			append_byte(k,1);
+			append_byte(k,(uint8_t)ordering((*index1).dic[j]));
+			append_collation_key(k,(*index1).dic[j]);
+		}
+
+/*   collation of the index, then its code units   */
+		append_collation_key(k,(*index1).idx[j]);
+		for (str=(*index1).idx[j];;str++) {
+			uint8_t unit[2];
+			unit[0]=(uint8_t)(*str>>8);
+			unit[1]=(uint8_t)(*str&0xFF);
+			append_bytes(k,unit,2);
+			if (*str==L'\0') break;
+		}
+	}
+}
+
+/*   sort by precomputed keys: comparisons are byte compares, which
+     lets miktex_parallel_sort() share the work between threads   */
+static void keysort(struct index *ind, int num)
+{
+	struct keyed_index *keys;
+	struct index *sorted;
+	int i;
+
+	if (num<=0) return;
+	keys=xmalloc(sizeof(struct keyed_index)*num);
+	for (i=0;i<num;i++) {
+		keys[i].entry=&ind[i];
+		keys[i].key=NULL;
+		keys[i].len=keys[i].size=0;
+		make_key(&keys[i]);
+	}
+	miktex_parallel_sort(keys,num,sizeof(struct keyed_index),kcomp);
+	sorted=xmalloc(sizeof(struct index)*num);
+	for (i=0;i<num;i++) {
+		sorted[i]=*keys[i].entry;
+		free(keys[i].key);
+	}
+	memcpy(ind,sorted,sizeof(struct index)*num);
+	free(sorted);
+	free(keys);
+}
+
+static int kcomp(const void *p, const void *q)
+{
+	const struct keyed_index *k1 = p, *k2 = q;
+	int cmp;
+
+	cmp=memcmp(k1->key,k2->key,k1->len<k2->len ? k1->len : k2->len);
+	if (cmp!=0) return cmp;
+	return k1->len<k2->len ? -1 : k1->len>k2->len ? 1 : 0;
+}
+#endif
+
 /*   compare for sorting index   */
 static int wcomp(const void *p, const void *q)
 {
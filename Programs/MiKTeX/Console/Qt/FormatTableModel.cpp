@@ -21,6 +21,8 @@
 
 #include <memory>
 
+#include <QThread>
+
 #include <miktex/Core/AutoResource>
 #include <miktex/Util/StringUtil>
 
@@ -94,11 +96,59 @@ QVariant FormatTableModel::headerData(int section, Qt::Orientation orientation,
   return QAbstractTableModel::headerData(section, orientation, role);
 }
 
+void FormatLoader::Process()
+{
+  try
+  {
+    formats = session->GetFormats();
+    result = true;
+  }
+  catch (const MiKTeXException& e)
+  {
+    this->e = e;
+  }
+  catch (const exception& e)
+  {
+    this->e = MiKTeXException(e.what());
+  }
+  emit OnFinish();
+}
+
 void FormatTableModel::Reload()
 {
-  beginResetModel();
-  MIKTEX_AUTO(endResetModel());
-  formats = session->GetFormats();
+  if (loading)
+  {
+    reloadPending = true;
+    return;
+  }
+  loading = true;
+  QThread* thread = new QThread;
+  FormatLoader* loader = new FormatLoader;
+  loader->moveToThread(thread);
+  (void)connect(thread, SIGNAL(started()), loader, SLOT(Process()));
+  (void)connect(loader, &FormatLoader::OnFinish, this, [this, loader]() {
+    if (loader->result)
+    {
+      beginResetModel();
+      formats = std::move(loader->formats);
+      endResetModel();
+    }
+    else
+    {
+      loadException = loader->e;
+    }
+    loading = false;
+    loader->deleteLater();
+    emit Loaded(loader->result);
+    if (reloadPending)
+    {
+      reloadPending = false;
+      Reload();
+    }
+  });
+  (void)connect(loader, SIGNAL(OnFinish()), thread, SLOT(quit()));
+  (void)connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+  thread->start();
 }
 
 FormatInfo FormatTableModel::GetFormatInfo(const QModelIndex& index)
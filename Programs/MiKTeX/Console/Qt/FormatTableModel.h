@@ -29,8 +29,34 @@
 #include <memory>
 #include <vector>
 
+#include <miktex/Core/Exceptions>
 #include <miktex/Core/Session>
 
+class FormatLoader :
+  public QObject
+{
+private:
+  Q_OBJECT;
+
+public slots:
+  void Process();
+
+signals:
+  void OnFinish();
+
+private:
+  std::shared_ptr<MiKTeX::Core::Session> session = MIKTEX_SESSION();
+
+public:
+  bool result = false;
+
+public:
+  MiKTeX::Core::MiKTeXException e;
+
+public:
+  std::vector<MiKTeX::Core::FormatInfo> formats;
+};
+
 class FormatTableModel :
   public QAbstractTableModel
 {
@@ -55,6 +81,21 @@ public:
 public:
   void Reload();
 
+public:
+  bool IsLoading() const
+  {
+    return loading;
+  }
+
+public:
+  MiKTeX::Core::MiKTeXException GetLoadException() const
+  {
+    return loadException;
+  }
+
+signals:
+  void Loaded(bool success);
+
 public:
   MiKTeX::Core::FormatInfo GetFormatInfo(const QModelIndex& index);
 
@@ -69,6 +110,15 @@ private:
 
 private:
   std::vector<MiKTeX::Core::FormatInfo> formats;
+
+private:
+  bool loading = false;
+
+private:
+  bool reloadPending = false;
+
+private:
+  MiKTeX::Core::MiKTeXException loadException;
 };
 
 #endif
@@ -50,32 +50,7 @@ bool PackageProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourc
   }
   PackageTableModel* packageTableModel = dynamic_cast<PackageTableModel*>(sourceModel());
   MIKTEX_ASSERT(packageTableModel != nullptr);
-  PackageInfo packageInfo;
-  if (!packageTableModel->TryGetPackageInfo(sourceModel()->index(sourceRow, 0, sourceParent), packageInfo))
-  {
-    return false;
-  }
-  bool accept = false;
-  if (!accept)
-  {
-    accept = packageInfo.id.find(filterText) != string::npos;
-  }
-  if (!accept)
-  {
-    accept = packageInfo.title.find(filterText) != string::npos;
-  }
-  if (!accept)
-  {
-    for (const string& f : packageInfo.runFiles)
-    {
-      accept = PathName::Match(filterText.c_str(), PathName(f).RemoveDirectorySpec());
-      if (accept)
-      {
-        break;
-      }
-    }
-  }
-  return accept;
+  return packageTableModel->Matches(sourceRow, filterText);
 }
 
 bool PackageProxyModel::lessThan(const QModelIndex& left, const QModelIndex& right) const
@@ -83,15 +58,14 @@ bool PackageProxyModel::lessThan(const QModelIndex& left, const QModelIndex& rig
   MIKTEX_ASSERT(left.column() == right.column());
   PackageTableModel* packageTableModel = dynamic_cast<PackageTableModel*>(sourceModel());
   MIKTEX_ASSERT(packageTableModel != nullptr);
-  PackageInfo packageInfoLeft;
-  PackageInfo packageInfoRight;
-  if (packageTableModel->TryGetPackageInfo(sourceModel()->index(left.row(), 0, left.parent()), packageInfoLeft)
-    && packageTableModel->TryGetPackageInfo(sourceModel()->index(right.row(), 0, right.parent()), packageInfoRight))
+  const PackageInfo* packageInfoLeft = packageTableModel->GetPackageInfo(left.row());
+  const PackageInfo* packageInfoRight = packageTableModel->GetPackageInfo(right.row());
+  if (packageInfoLeft != nullptr && packageInfoRight != nullptr)
   {
     switch (left.column())
     {
     case 2:
-      return packageInfoLeft.GetSize() < packageInfoRight.GetSize();
+      return packageInfoLeft->GetSize() < packageInfoRight->GetSize();
     default:
       break;
     }
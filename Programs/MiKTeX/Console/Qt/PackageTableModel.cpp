@@ -1,6 +1,6 @@
 /* PackageTableModel.cpp:
 
-   Copyright (C) 2018-2021 Christian Schenk
+   Copyright (C) 2018-2023 Christian Schenk
 
    This file is part of MiKTeX Console.
 
@@ -24,6 +24,7 @@
 #include <QColor>
 #include <QDateTime>
 #include <QLocale>
+#include <QThread>
 
 #include <miktex/Core/AutoResource>
 
@@ -53,65 +54,61 @@ int PackageTableModel::columnCount(const QModelIndex& parent) const
 
 QVariant PackageTableModel::data(const QModelIndex& index, int role) const
 {
-  if (!(index.isValid() && index.row() >= 0 && index.row() < packages.size()))
+  const PackageInfo* packageInfo = index.isValid() ? GetPackageInfo(index.row()) : nullptr;
+  if (packageInfo == nullptr)
   {
     return QVariant();
   }
 
   if (role == Qt::DisplayRole)
   {
-    PackageInfo packageInfo;
-    if (TryGetPackageInfo(index, packageInfo))
+    switch (index.column())
     {
-      switch (index.column())
-      {
-      case 0:
-        return QString::fromUtf8(packageInfo.id.c_str());
-      case 1:
-        return QString::fromUtf8(packageManager->GetContainerPath(packageInfo.id, true).c_str());
-      case 2:
+    case 0:
+      return QString::fromUtf8(packageInfo->id.c_str());
+    case 1:
+      return categories[index.row()];
+    case 2:
 #if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-        return QLocale::system().formattedDataSize(packageInfo.GetSize());
+      return QLocale::system().formattedDataSize(packageInfo->GetSize());
 #else
-        return static_cast<qlonglong>(packageInfo.GetSize());
+      return static_cast<qlonglong>(packageInfo->GetSize());
 #endif
-      case 3:
-        return QDateTime::fromTime_t(packageInfo.timePackaged).date();
-      case 4:
-        if (packageInfo.IsInstalled())
-        {
-          return QDateTime::fromTime_t(packageInfo.GetTimeInstalled()).date();
-        }
-        break;
-      case 5:
-        if (packageInfo.IsInstalled(ConfigurationScope::Common) && packageInfo.IsInstalled(ConfigurationScope::User))
-        {
-          return tr("Admin") + ", " + tr("User");
-        }
-        else if (packageInfo.IsInstalled(ConfigurationScope::Common))
-        {
-          return session->IsSharedSetup() ? tr("Admin") : tr("User");
-        }
-        else if (packageInfo.IsInstalled(ConfigurationScope::User))
-        {
-          return tr("User");
-        }
-        break;
-      case 6:
-        return QString::fromUtf8(packageInfo.title.c_str());
-      case 7:
-        if (!packageInfo.runFiles.empty())
-        {
-          return QString("%1 +%2").arg(QString::fromUtf8(PathName(packageInfo.runFiles[0]).GetFileName().GetData())).arg(packageInfo.runFiles.size());
-        }
-        break;
+    case 3:
+      return QDateTime::fromTime_t(packageInfo->timePackaged).date();
+    case 4:
+      if (packageInfo->IsInstalled())
+      {
+        return QDateTime::fromTime_t(packageInfo->GetTimeInstalled()).date();
+      }
+      break;
+    case 5:
+      if (packageInfo->IsInstalled(ConfigurationScope::Common) && packageInfo->IsInstalled(ConfigurationScope::User))
+      {
+        return tr("Admin") + ", " + tr("User");
+      }
+      else if (packageInfo->IsInstalled(ConfigurationScope::Common))
+      {
+        return session->IsSharedSetup() ? tr("Admin") : tr("User");
+      }
+      else if (packageInfo->IsInstalled(ConfigurationScope::User))
+      {
+        return tr("User");
       }
+      break;
+    case 6:
+      return QString::fromUtf8(packageInfo->title.c_str());
+    case 7:
+      if (!packageInfo->runFiles.empty())
+      {
+        return QString("%1 +%2").arg(QString::fromUtf8(PathName(packageInfo->runFiles[0]).GetFileName().GetData())).arg(packageInfo->runFiles.size());
+      }
+      break;
     }
   }
   else if (role == Qt::ForegroundRole)
   {
-    PackageInfo packageInfo;
-    if (TryGetPackageInfo(index, packageInfo) && packageInfo.IsInstalled(ConfigurationScope::Common) && packageInfo.IsInstalled(ConfigurationScope::User))
+    if (packageInfo->IsInstalled(ConfigurationScope::Common) && packageInfo->IsInstalled(ConfigurationScope::User))
     {
       return QColor("red");
     }
@@ -147,36 +144,120 @@ QVariant PackageTableModel::headerData(int section, Qt::Orientation orientation,
   return QAbstractTableModel::headerData(section, orientation, role);
 }
 
-void PackageTableModel::Reload()
+// the package database is read by a background thread; the model is
+// reset when the rows (with their category and search index entry) are
+// complete
+void PackageLoader::Process()
 {
-  beginResetModel();
-  MIKTEX_AUTO(endResetModel());
-  packages.clear();  
-  packageManager->UnloadDatabase();
-  unique_ptr<PackageIterator> iter(packageManager->CreateIterator());
-  PackageInfo packageInfo;
-  int row = 0;
-  while (iter->GetNext(packageInfo))
+  try
   {
-    if (!packageInfo.IsPureContainer())
+    packageManager->UnloadDatabase();
+    unique_ptr<PackageIterator> iter(packageManager->CreateIterator());
+    PackageInfo packageInfo;
+    while (iter->GetNext(packageInfo))
     {
-      packages[row] = packageInfo;
-      ++row;
+      if (!packageInfo.IsPureContainer())
+      {
+        packages.push_back(packageInfo);
+      }
     }
+    iter->Dispose();
+    categories.reserve(packages.size());
+    searchIndex.reserve(packages.size());
+    for (const PackageInfo& p : packages)
+    {
+      categories.push_back(QString::fromUtf8(packageManager->GetContainerPath(p.id, true).c_str()));
+      PackageSearchEntry entry{ p.id, p.title };
+      entry.runFileNames.reserve(p.runFiles.size());
+      for (const string& f : p.runFiles)
+      {
+        entry.runFileNames.push_back(PathName(f).RemoveDirectorySpec().ToString());
+      }
+      searchIndex.push_back(std::move(entry));
+    }
+    result = true;
   }
-  iter->Dispose();
+  catch (const MiKTeXException& e)
+  {
+    this->e = e;
+  }
+  catch (const exception& e)
+  {
+    this->e = MiKTeXException(e.what());
+  }
+  emit OnFinish();
+}
+
+void PackageTableModel::Reload()
+{
+  if (loading)
+  {
+    reloadPending = true;
+    return;
+  }
+  loading = true;
+  QThread* thread = new QThread;
+  PackageLoader* loader = new PackageLoader(packageManager);
+  loader->moveToThread(thread);
+  (void)connect(thread, SIGNAL(started()), loader, SLOT(Process()));
+  (void)connect(loader, &PackageLoader::OnFinish, this, [this, loader]() {
+    if (loader->result)
+    {
+      beginResetModel();
+      packages = std::move(loader->packages);
+      categories = std::move(loader->categories);
+      searchIndex = std::move(loader->searchIndex);
+      endResetModel();
+    }
+    else
+    {
+      loadException = loader->e;
+    }
+    loading = false;
+    loader->deleteLater();
+    emit Loaded(loader->result);
+    if (reloadPending)
+    {
+      reloadPending = false;
+      Reload();
+    }
+  });
+  (void)connect(loader, SIGNAL(OnFinish()), thread, SLOT(quit()));
+  (void)connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+  thread->start();
 }
 
 bool PackageTableModel::TryGetPackageInfo(const QModelIndex& index, PackageInfo& packageInfo) const
 {
-  map<int, PackageInfo>::const_iterator it = packages.find(index.row());
-  if (it == packages.end())
+  const PackageInfo* p = GetPackageInfo(index.row());
+  if (p == nullptr)
   {
     return false;
   }
   else
   {
-    packageInfo = it->second;
+    packageInfo = *p;
+    return true;
+  }
+}
+
+bool PackageTableModel::Matches(int row, const string& filter) const
+{
+  if (row < 0 || row >= searchIndex.size())
+  {
+    return false;
+  }
+  const PackageSearchEntry& entry = searchIndex[row];
+  if (entry.id.find(filter) != string::npos || entry.title.find(filter) != string::npos)
+  {
     return true;
   }
+  for (const string& fileName : entry.runFileNames)
+  {
+    if (PathName::Match(filter.c_str(), fileName.c_str()))
+    {
+      return true;
+    }
+  }
+  return false;
 }
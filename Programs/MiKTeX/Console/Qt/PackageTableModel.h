@@ -26,9 +26,57 @@
 
 #include <QAbstractTableModel>
 
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Exceptions>
 #include <miktex/PackageManager/PackageManager>
 #include <miktex/Core/Session>
 
+struct PackageSearchEntry
+{
+  std::string id;
+  std::string title;
+  std::vector<std::string> runFileNames;
+};
+
+class PackageLoader :
+  public QObject
+{
+private:
+  Q_OBJECT;
+
+public:
+  PackageLoader(std::shared_ptr<MiKTeX::Packages::PackageManager> packageManager) :
+    packageManager(packageManager)
+  {
+  }
+
+public slots:
+  void Process();
+
+signals:
+  void OnFinish();
+
+private:
+  std::shared_ptr<MiKTeX::Packages::PackageManager> packageManager;
+
+public:
+  bool result = false;
+
+public:
+  MiKTeX::Core::MiKTeXException e;
+
+public:
+  std::vector<MiKTeX::Packages::PackageInfo> packages;
+
+public:
+  std::vector<QString> categories;
+
+public:
+  std::vector<PackageSearchEntry> searchIndex;
+};
+
 class PackageTableModel :
   public QAbstractTableModel
 {
@@ -53,20 +101,53 @@ public:
 public:
   void Reload();
 
+public:
+  bool IsLoading() const
+  {
+    return loading;
+  }
+
+public:
+  MiKTeX::Core::MiKTeXException GetLoadException() const
+  {
+    return loadException;
+  }
+
+signals:
+  void Loaded(bool success);
+
 public:
   bool TryGetPackageInfo(const QModelIndex& index, MiKTeX::Packages::PackageInfo& packageInfo) const;
 
+public:
+  const MiKTeX::Packages::PackageInfo* GetPackageInfo(int row) const
+  {
+    return row >= 0 && row < packages.size() ? &packages[row] : nullptr;
+  }
+
+public:
+  bool Matches(int row, const std::string& filter) const;
+
 private:
   std::shared_ptr<MiKTeX::Packages::PackageManager> packageManager;
 
 private:
-  std::map<int, MiKTeX::Packages::PackageInfo> packages;
+  std::vector<MiKTeX::Packages::PackageInfo> packages;
 
-public:
-  const std::map<int, MiKTeX::Packages::PackageInfo>& GetData() const
-  {
-    return packages;
-  }
+private:
+  std::vector<QString> categories;
+
+private:
+  std::vector<PackageSearchEntry> searchIndex;
+
+private:
+  bool loading = false;
+
+private:
+  bool reloadPending = false;
+
+private:
+  MiKTeX::Core::MiKTeXException loadException;
 
 private:
   std::shared_ptr<MiKTeX::Core::Session> session = MIKTEX_SESSION();
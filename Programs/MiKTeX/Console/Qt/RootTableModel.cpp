@@ -22,6 +22,7 @@
 #include <memory>
 
 #include <QDateTime>
+#include <QThread>
 
 #include <miktex/Core/AutoResource>
 #include <miktex/Util/StringUtil>
@@ -128,11 +129,59 @@ QVariant RootTableModel::headerData(int section, Qt::Orientation orientation, in
   return QAbstractTableModel::headerData(section, orientation, role);
 }
 
+void RootLoader::Process()
+{
+  try
+  {
+    roots = session->GetRootDirectories();
+    result = true;
+  }
+  catch (const MiKTeXException& e)
+  {
+    this->e = e;
+  }
+  catch (const exception& e)
+  {
+    this->e = MiKTeXException(e.what());
+  }
+  emit OnFinish();
+}
+
 void RootTableModel::Reload()
 {
-  beginResetModel();
-  MIKTEX_AUTO(endResetModel());
-  roots = session->GetRootDirectories();
+  if (loading)
+  {
+    reloadPending = true;
+    return;
+  }
+  loading = true;
+  QThread* thread = new QThread;
+  RootLoader* loader = new RootLoader;
+  loader->moveToThread(thread);
+  (void)connect(thread, SIGNAL(started()), loader, SLOT(Process()));
+  (void)connect(loader, &RootLoader::OnFinish, this, [this, loader]() {
+    if (loader->result)
+    {
+      beginResetModel();
+      roots = std::move(loader->roots);
+      endResetModel();
+    }
+    else
+    {
+      loadException = loader->e;
+    }
+    loading = false;
+    loader->deleteLater();
+    emit Loaded(loader->result);
+    if (reloadPending)
+    {
+      reloadPending = false;
+      Reload();
+    }
+  });
+  (void)connect(loader, SIGNAL(OnFinish()), thread, SLOT(quit()));
+  (void)connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+  thread->start();
 }
 
 bool RootTableModel::CanMoveUp(const QModelIndex& index)
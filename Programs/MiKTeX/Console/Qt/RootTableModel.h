@@ -29,9 +29,35 @@
 #include <memory>
 #include <vector>
 
+#include <miktex/Core/Exceptions>
 #include <miktex/Core/RootDirectoryInfo>
 #include <miktex/Core/Session>
 
+class RootLoader :
+  public QObject
+{
+private:
+  Q_OBJECT;
+
+public slots:
+  void Process();
+
+signals:
+  void OnFinish();
+
+private:
+  std::shared_ptr<MiKTeX::Core::Session> session = MIKTEX_SESSION();
+
+public:
+  bool result = false;
+
+public:
+  MiKTeX::Core::MiKTeXException e;
+
+public:
+  std::vector<MiKTeX::Core::RootDirectoryInfo> roots;
+};
+
 class RootTableModel :
   public QAbstractTableModel
 {
@@ -56,6 +82,21 @@ public:
 public:
   void Reload();
 
+public:
+  bool IsLoading() const
+  {
+    return loading;
+  }
+
+public:
+  MiKTeX::Core::MiKTeXException GetLoadException() const
+  {
+    return loadException;
+  }
+
+signals:
+  void Loaded(bool success);
+
 public:
   bool CanMoveUp(const QModelIndex& index);
 
@@ -79,6 +120,15 @@ private:
 
 private:
   std::vector<MiKTeX::Core::RootDirectoryInfo> roots;
+
+private:
+  bool loading = false;
+
+private:
+  bool reloadPending = false;
+
+private:
+  MiKTeX::Core::MiKTeXException loadException;
 };
 
 #endif
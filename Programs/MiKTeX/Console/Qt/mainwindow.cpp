@@ -525,7 +525,7 @@ void MainWindow::SetCurrentPage(MainWindow::Pages p)
     break;
   case Pages::Packages:
     ui->buttonPackages->setChecked(true);
-    if (packageModel->rowCount() == 0)
+    if (packageModel->rowCount() == 0 && !packageModel->IsLoading())
     {
       try
       {
@@ -1628,6 +1628,14 @@ void MainWindow::on_comboPaper_activated(int idx)
 void MainWindow::SetupUiDirectories()
 {
   rootDirectoryModel = new RootTableModel(this);
+  (void)connect(rootDirectoryModel, &RootTableModel::Loaded, this, [this](bool success) {
+    if (!success)
+    {
+      CriticalError(rootDirectoryModel->GetLoadException());
+    }
+    ui->treeViewRootDirectories->resizeColumnToContents(0);
+    UpdateActionsDirectories();
+  });
   toolBarRootDirectories = new QToolBar(this);
   toolBarRootDirectories->setIconSize(QSize(16, 16));
   toolBarRootDirectories->addAction(ui->actionAddRootDirectory);
@@ -1666,7 +1674,6 @@ void MainWindow::UpdateUiDirectories()
   if (!IsBackgroundWorkerActive())
   {
     rootDirectoryModel->Reload();
-    ui->treeViewRootDirectories->resizeColumnToContents(0);
     ui->lineEditBinDir->setText(QString::fromUtf8(session->GetSpecialPath(SpecialPath::LinkTargetDirectory).ToDisplayString().c_str()));
     ui->lineEditLogDir->setText(QString::fromUtf8(session->GetSpecialPath(SpecialPath::LogDirectory).ToDisplayString().c_str()));
   }
@@ -1927,6 +1934,14 @@ void MainWindow::ChangeLinkTargetDirectory()
 void MainWindow::SetupUiFormats()
 {
   formatModel = new FormatTableModel(this);
+  (void)connect(formatModel, &FormatTableModel::Loaded, this, [this](bool success) {
+    if (!success)
+    {
+      CriticalError(formatModel->GetLoadException());
+    }
+    ui->treeViewFormats->resizeColumnToContents(0);
+    UpdateActionsFormats();
+  });
   formatProxyModel = new FormatProxyModel(this);
   formatProxyModel->setSourceModel(formatModel);
   formatProxyModel->setSortCaseSensitivity(Qt::CaseInsensitive);
@@ -1967,7 +1982,6 @@ void MainWindow::UpdateUiFormats()
   if (!IsBackgroundWorkerActive())
   {
     formatModel->Reload();
-    ui->treeViewFormats->resizeColumnToContents(0);
   }
 }
 
@@ -2175,9 +2189,21 @@ void MainWindow::SetupUiPackages()
   toolBarPackages->addWidget(lineEditPackageFilter);
   toolBarPackages->addAction(ui->actionFilterPackages);
   (void)connect(lineEditPackageFilter, SIGNAL(returnPressed()), this, SLOT(FilterPackages()));
+  packageFilterTimer = new QTimer(this);
+  packageFilterTimer->setSingleShot(true);
+  packageFilterTimer->setInterval(300);
+  (void)connect(lineEditPackageFilter, SIGNAL(textChanged(const QString&)), packageFilterTimer, SLOT(start()));
+  (void)connect(packageFilterTimer, SIGNAL(timeout()), this, SLOT(FilterPackages()));
   ui->hboxPackageToolBar->addWidget(toolBarPackages);
   ui->hboxPackageToolBar->addStretch();
   packageModel = new PackageTableModel(packageManager, this);
+  (void)connect(packageModel, &PackageTableModel::Loaded, this, [this](bool success) {
+    if (!success)
+    {
+      CriticalError(packageModel->GetLoadException());
+    }
+    UpdateActionsPackages();
+  });
   packageProxyModel = new PackageProxyModel(this);
   packageProxyModel->setSourceModel(packageModel);
   packageProxyModel->setSortCaseSensitivity(Qt::CaseInsensitive);
@@ -2351,6 +2377,7 @@ void MainWindow::UninstallPackage()
 
 void MainWindow::FilterPackages()
 {
+  packageFilterTimer->stop();
   packageProxyModel->SetFilter(lineEditPackageFilter->text().toUtf8().constData());
 }
 
@@ -39,6 +39,7 @@
 #include "common.h"
 
 class QLineEdit;
+class QTimer;
 
 class FormatProxyModel;
 class FormatTableModel;
@@ -533,6 +534,9 @@ private:
 private:
   QLineEdit* lineEditPackageFilter = nullptr;
 
+private:
+  QTimer* packageFilterTimer = nullptr;
+
 private:
   void SetupUiPackages();
 
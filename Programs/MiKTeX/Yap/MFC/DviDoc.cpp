@@ -210,6 +210,11 @@ int DviDoc::GetPrinterResolution() const
 void DviDoc::Shrink(int d)
 {
   displayShrinkFactor += d;
+  // let the page loaders rasterize at the new zoom level
+  if (pDvi != nullptr && !isPrintContext)
+  {
+    pDvi->SetPreferredShrinkFactor(displayShrinkFactor);
+  }
 }
 
 void DviDoc::Unshrink()
@@ -77,6 +77,9 @@ public:
 public:
   PageStatus GetPageStatus(int pageIdx);
 
+public:
+  bool IsPagePending(int pageIdx);
+
 public:
   bool IsPrintContext() const;
 
@@ -328,6 +331,12 @@ inline PageStatus DviDoc::GetPageStatus(int pageIdx)
   return pDvi->GetPageStatus(pageIdx);
 }
 
+inline bool DviDoc::IsPagePending(int pageIdx)
+{
+  MIKTEX_ASSERT(pDvi != nullptr);
+  return pDvi->IsPagePending(pageIdx, GetShrinkFactor());
+}
+
 inline int DviDoc::GetMagnification() const
 {
   MIKTEX_ASSERT(pDvi != nullptr);
@@ -103,6 +103,7 @@ DviDraw::~DviDraw()
         YapError(T_("DeleteObject() failed for some reason"));
       }
     }
+    ClearBitmapCache();
   }
   catch (const exception&)
   {
@@ -242,7 +243,18 @@ void DviDraw::DrawDviBitmaps(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
 #endif
 
 #if USE_BITBLT
-    HBITMAP hBitmap = CreateDIBitmap(pDC->GetSafeHdc(), &pBitmapInfo->bmiHeader, CBM_INIT, reinterpret_cast<const void*>(dvibm.pixels), pBitmapInfo, pDoc->GetShrinkFactor() == 1 ? DIB_RGB_COLORS : DIB_PAL_COLORS);
+    // the conversion to a device-dependent bitmap is done only once for
+    // the display
+    bool cached = !pDoc->IsPrintContext();
+    HBITMAP hBitmap;
+    if (cached)
+    {
+      hBitmap = GetCachedBitmap(pDC, pDoc, dvibm, pBitmapInfo, fb);
+    }
+    else
+    {
+      hBitmap = CreateDIBitmap(pDC->GetSafeHdc(), &pBitmapInfo->bmiHeader, CBM_INIT, reinterpret_cast<const void*>(dvibm.pixels), pBitmapInfo, pDoc->GetShrinkFactor() == 1 ? DIB_RGB_COLORS : DIB_PAL_COLORS);
+    }
     if (hBitmap == nullptr)
     {
       MIKTEX_UNEXPECTED();
@@ -262,7 +274,7 @@ void DviDraw::DrawDviBitmaps(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
     {
       YapError(T_("SelectObject() failed for some reason"));
     }
-    if (!DeleteObject(hBitmap))
+    if (!cached && !DeleteObject(hBitmap))
     {
       YapError(T_("DeleteObject() failed for some reason"));
     }
@@ -278,6 +290,79 @@ void DviDraw::DrawDviBitmaps(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
 #endif
 }
 
+// an estimate: 32 bits per pixel
+const size_t maxBitmapCacheSize = 64 * 1024 * 1024;
+
+static size_t Checksum(const void* data, size_t size)
+{
+  // FNV-1a
+  const BYTE* bytes = reinterpret_cast<const BYTE*>(data);
+  unsigned long long hash = 14695981039346656037ULL;
+  for (size_t idx = 0; idx < size; ++idx)
+  {
+    hash ^= bytes[idx];
+    hash *= 1099511628211ULL;
+  }
+  return static_cast<size_t>(hash);
+}
+
+HBITMAP DviDraw::GetCachedBitmap(CDC* pDC, DviDoc* pDoc, const DviBitmap& dvibm, const BITMAPINFO* pBitmapInfo, const foreback& fb)
+{
+  // the pixels might belong to another bitmap by now: the checksum
+  // tells
+  BitmapCacheKey key;
+  key.pixels = dvibm.pixels;
+  key.width = dvibm.width;
+  key.height = dvibm.height;
+  key.fb = fb;
+  key.checksum = Checksum(dvibm.pixels, static_cast<size_t>(dvibm.bytesPerLine) * dvibm.height);
+  map<BitmapCacheKey, list<CachedBitmap>::iterator>::iterator it = bitmapCache.find(key);
+  if (it != bitmapCache.end())
+  {
+    cachedBitmaps.splice(cachedBitmaps.begin(), cachedBitmaps, it->second);
+    return it->second->hBitmap;
+  }
+  HBITMAP hBitmap = CreateDIBitmap(pDC->GetSafeHdc(), &pBitmapInfo->bmiHeader, CBM_INIT, reinterpret_cast<const void*>(dvibm.pixels), pBitmapInfo, pDoc->GetShrinkFactor() == 1 ? DIB_RGB_COLORS : DIB_PAL_COLORS);
+  if (hBitmap == nullptr)
+  {
+    return nullptr;
+  }
+  CachedBitmap cachedBitmap;
+  cachedBitmap.key = key;
+  cachedBitmap.hBitmap = hBitmap;
+  cachedBitmap.size = static_cast<size_t>(dvibm.width) * dvibm.height * 4;
+  cachedBitmaps.push_front(cachedBitmap);
+  bitmapCache[key] = cachedBitmaps.begin();
+  bitmapCacheSize += cachedBitmap.size;
+  // keep the bitmap just made
+  while (bitmapCacheSize > maxBitmapCacheSize && cachedBitmaps.size() > 1)
+  {
+    const CachedBitmap& lru = cachedBitmaps.back();
+    if (!DeleteObject(lru.hBitmap))
+    {
+      YapError(T_("DeleteObject() failed for some reason"));
+    }
+    bitmapCacheSize -= lru.size;
+    bitmapCache.erase(lru.key);
+    cachedBitmaps.pop_back();
+  }
+  return hBitmap;
+}
+
+void DviDraw::ClearBitmapCache()
+{
+  for (const CachedBitmap& cachedBitmap : cachedBitmaps)
+  {
+    if (!DeleteObject(cachedBitmap.hBitmap))
+    {
+      YapError(T_("DeleteObject() failed for some reason"));
+    }
+  }
+  cachedBitmaps.clear();
+  bitmapCache.clear();
+  bitmapCacheSize = 0;
+}
+
 void DviDraw::DrawDibChunks(CDC* pDC, DviDoc* pDoc, DviPage* pPage)
 {
   ASSERT_VALID(pDC);
@@ -389,6 +474,9 @@ LPBITMAPINFO DviDraw::MakeBitmapInfo(size_t width, size_t height, size_t dpi, si
 
 void DviDraw::InitializeDviBitmapPalettes()
 {
+  // the cached bitmaps have been made with the old palettes
+  ClearBitmapCache();
+
   map<foreback, HPALETTE>::iterator it;
   for (it = foregroundPalettes.begin(); it != foregroundPalettes.end(); ++it)
   {
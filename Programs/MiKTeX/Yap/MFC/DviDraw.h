@@ -42,6 +42,21 @@ inline bool operator< (const foreback& fb1, const foreback& fb2)
           : fb1.back < fb2.back)));
 }
 
+struct BitmapCacheKey
+{
+  const void* pixels;
+  int width;
+  int height;
+  foreback fb;
+  size_t checksum;
+};
+
+inline bool operator< (const BitmapCacheKey& key1, const BitmapCacheKey& key2)
+{
+  return std::tie(key1.pixels, key1.width, key1.height, key1.fb, key1.checksum)
+    < std::tie(key2.pixels, key2.width, key2.height, key2.fb, key2.checksum);
+}
+
 class DviDraw
 {
 protected:
@@ -68,6 +83,12 @@ private:
 private:
   BITMAPINFO* MakeBitmapInfo(size_t width, size_t height, size_t dpi, size_t bytesPerLine, DviDoc* pDoc);
 
+private:
+  HBITMAP GetCachedBitmap(CDC* pDC, DviDoc* pDoc, const DviBitmap& dvibm, const BITMAPINFO* pBitmapInfo, const foreback& fb);
+
+protected:
+  void ClearBitmapCache();
+
 protected:
   map<foreback, HPALETTE> foregroundPalettes;
 
@@ -82,4 +103,23 @@ protected:
 
 private:
   LPBITMAPINFO bitmapInfoTable[2];
+
+private:
+  struct CachedBitmap
+  {
+    BitmapCacheKey key;
+    HBITMAP hBitmap;
+    size_t size;
+  };
+
+  // device-dependent bitmaps made from DVI bitmaps, most recently used
+  // first
+private:
+  list<CachedBitmap> cachedBitmaps;
+
+private:
+  map<BitmapCacheKey, list<CachedBitmap>::iterator> bitmapCache;
+
+private:
+  size_t bitmapCacheSize = 0;
 };
@@ -257,6 +257,9 @@ protected:
 protected:
   afx_msg void OnUpdateZoomOut(CCmdUI* pCmdUI);
 
+protected:
+  afx_msg void OnTimer(UINT_PTR id);
+
 protected:
   afx_msg void OnUpdateToolsSourcespecials(CCmdUI* pCmdUI);
 
@@ -522,6 +525,11 @@ private:
 private:
   double tpicConv;
 
+  // visible pages which are drawn as blank paper until they have been
+  // rasterized in the background
+private:
+  set<int> pendingPages;
+
 private:
   static vector<double> gammaTable;
 
@@ -55,8 +55,11 @@
 #include <cmath>
 
 #include <algorithm>
+#include <list>
 #include <stack>
 #include <map>
+#include <set>
+#include <tuple>
 #include <memory>
 #include <vector>
 #include <string>
@@ -26,6 +26,10 @@
 #include "ErrorDialog.h"
 #include "MainFrame.h"
 
+// polls for pages rasterized in the background
+const UINT_PTR pendingPagesTimerId = 1;
+const UINT pendingPagesPollInterval = 50; // milliseconds
+
 void DviView::OnDraw(CDC* pDC)
 {
   try
@@ -177,6 +181,20 @@ void DviView::DrawPage(CDC* pDC, int pageIdx)
     YapInfo(T_("DVI document has been changed"));
   }
 
+  // a page at a new zoom level is rasterized by the page loaders: show
+  // blank paper meanwhile, OnTimer() repaints when the page is ready
+  if (!pDoc->IsPrintContext() && pageStatus != PageStatus::Changed && pDoc->IsPagePending(pageIdx))
+  {
+    DrawRulers(pDC);
+    DrawPaper(pDC);
+    if (pendingPages.empty())
+    {
+      SetTimer(pendingPagesTimerId, pendingPagesPollInterval, nullptr);
+    }
+    pendingPages.insert(pageIdx);
+    return;
+  }
+
   bool pageLoaded = (pageStatus == PageStatus::Loaded);
 
   CWaitCursor* pWaitCursor = nullptr;
@@ -237,6 +255,47 @@ void DviView::DrawPage(CDC* pDC, int pageIdx)
   }
 }
 
+void DviView::OnTimer(UINT_PTR id)
+{
+  if (id != pendingPagesTimerId)
+  {
+    CScrollView::OnTimer(id);
+    return;
+  }
+  try
+  {
+    DviDoc* pDoc = GetDocument();
+    ASSERT_VALID(pDoc);
+    bool repaint = pendingPages.empty() || pDoc->GetDviFileStatus() != DviDoc::DVIFILE_LOADED;
+    for (int pageIdx : pendingPages)
+    {
+      if (repaint)
+      {
+        break;
+      }
+      repaint = pageIdx >= pDoc->GetPageCount() || !pDoc->IsPagePending(pageIdx);
+    }
+    if (repaint)
+    {
+      KillTimer(pendingPagesTimerId);
+      pendingPages.clear();
+      Invalidate(FALSE);
+    }
+  }
+  catch (const MiKTeXException& e)
+  {
+    KillTimer(pendingPagesTimerId);
+    pendingPages.clear();
+    ShowError(this, e);
+  }
+  catch (const exception& e)
+  {
+    KillTimer(pendingPagesTimerId);
+    pendingPages.clear();
+    ShowError(this, e);
+  }
+}
+
 void
 DviView::DrawSpecials(CDC* pDC, int iteration, DviPage* pPage, int pageIdx)
 {
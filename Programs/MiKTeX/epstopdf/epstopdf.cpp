@@ -42,11 +42,15 @@
 #include <miktex/App/Application>
 #include <miktex/Core/BufferSizes>
 #include <miktex/Core/CommandLineBuilder>
+#include <miktex/Core/Directory>
 #include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
 #include <miktex/Core/FileStream>
+#include <miktex/Core/MD5>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Process>
 #include <miktex/Core/Quoter>
+#include <miktex/Core/TemporaryFile>
 #include <miktex/Trace/Trace>
 #include <miktex/Trace/TraceStream>
 #include <miktex/Util/StringUtil>
@@ -57,6 +61,7 @@
 #endif
 
 using namespace MiKTeX::App;
+using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
 using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
@@ -145,6 +150,12 @@ private:
 private:
   bool IsSafeGhostscriptOption(const string& o);
 
+private:
+  PathName GetCachedPdfFile(const PathName& inputFile, unsigned long gsVersion, const vector<string>& gsOptions);
+
+private:
+  void PutIntoCache(const PathName& outFile, const PathName& cachedPdfFile);
+
 private:
   unique_ptr<Process> gsProcess;
 
@@ -175,6 +186,9 @@ private:
 private:
   bool boundingBoxCorrected = false;
 
+private:
+  bool haveWarnings = false;
+
 private:
   map<string, string> fontMap;
 
@@ -558,6 +572,7 @@ void EpsToPdfApp::PrintOnly(const string& line)
 
 void EpsToPdfApp::Warning(const string& line)
 {
+  haveWarnings = true;
   cerr << T_("warning") << ": " << line << endl;
 }
 
@@ -891,6 +906,49 @@ void EpsToPdfApp::PrepareOutput(bool runAsFilter, bool runGhostscript, const Pat
   }
 }
 
+// The cache key covers everything the PDF file depends on: the EPS
+// file, the Ghostscript version and the options.
+PathName EpsToPdfApp::GetCachedPdfFile(const PathName& inputFile, unsigned long gsVersion, const vector<string>& gsOptions)
+{
+  try
+  {
+    string key = MD5::FromFile(inputFile).ToString();
+    key += fmt::format("\n{0}\n{1}.{2}.{3}\n{4}\n{5}", gsVersion, MIKTEX_COMP_MAJOR_VERSION, MIKTEX_COMP_MINOR_VERSION, MIKTEX_COMP_PATCH_VERSION, boundingBoxName, pdfVersion);
+    for (const string& o : gsOptions)
+    {
+      key += "\n" + o;
+    }
+    return session->GetSpecialPath(session->IsAdminMode() ? SpecialPath::CommonDataRoot : SpecialPath::UserDataRoot)
+      / PathName(MIKTEX_PATH_MIKTEX_CACHE_DIR) / PathName("epstopdf") / PathName(MD5::FromChars(key).ToString() + ".pdf");
+  }
+  catch (const MiKTeXException& e)
+  {
+    // not fatal: nothing will be cached
+    MyTrace(fmt::format(T_("no cache for {0}: {1}"), Q_(inputFile), e.GetErrorMessage()));
+    return PathName();
+  }
+}
+
+void EpsToPdfApp::PutIntoCache(const PathName& outFile, const PathName& cachedPdfFile)
+{
+  try
+  {
+    Directory::Create(cachedPdfFile.GetDirectoryName());
+    PathName tmpPath = cachedPdfFile;
+    tmpPath.AppendExtension(".tmp");
+    unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create(tmpPath);
+    File::Copy(outFile, tmpPath);
+    File::Move(tmpPath, cachedPdfFile, { FileMoveOption::ReplaceExisting });
+    tmpFile->Keep();
+    MyTrace(fmt::format(T_("cached {0} as {1}"), Q_(outFile), Q_(cachedPdfFile)));
+  }
+  catch (const MiKTeXException& e)
+  {
+    // not fatal: the file will be made again next time
+    MyTrace(fmt::format(T_("{0} could not be cached: {1}"), Q_(outFile), e.GetErrorMessage()));
+  }
+}
+
 bool EpsToPdfApp::IsSafeGhostscriptOption(const string& o)
 {
   smatch m;
@@ -1155,10 +1213,24 @@ void EpsToPdfApp::Run(int argc, const char** argv)
   }
 
   PathName gsExe;
+  PathName cachedPdfFile;
 
   if (runGhostscript)
   {
-    gsExe = session->GetGhostscript(nullptr);
+    unsigned long gsVersion = 0;
+    gsExe = session->GetGhostscript(&gsVersion);
+    if (!runAsFilter && !printOnly)
+    {
+      cachedPdfFile = GetCachedPdfFile(inputFile, gsVersion, gsOptions);
+    }
+  }
+
+  if (!cachedPdfFile.Empty() && File::Exists(cachedPdfFile))
+  {
+    MyTrace(fmt::format(T_("using cached {0}"), Q_(cachedPdfFile)));
+    File::Copy(cachedPdfFile, outFile);
+    Finalize2(0);
+    return;
   }
 
   PrepareInput(runAsFilter, inputFile);
@@ -1205,6 +1277,12 @@ void EpsToPdfApp::Run(int argc, const char** argv)
     }
   }
 
+  // a PDF file made with warnings (e.g., missing fonts) is not cached
+  if (!cachedPdfFile.Empty() && !haveWarnings)
+  {
+    PutIntoCache(outFile, cachedPdfFile);
+  }
+
   Finalize2(0);
 }
 
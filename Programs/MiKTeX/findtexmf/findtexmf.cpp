@@ -77,6 +77,12 @@ private:
 private:
   void PrintSearchPath(const char* lpszSearchPath);
 
+private:
+  FileType GetFileType(const string& fileName);
+
+private:
+  void AnswerQueries();
+
 public:
   int Run(int argc, const char** argv);
 
@@ -86,6 +92,9 @@ private:
 private:
   bool start = false;
 
+private:
+  bool readStdin = false;
+
 private:
   FileType fileType = FileType::None;
 
@@ -107,6 +116,7 @@ enum Option
   OPT_MUST_EXIST,
   OPT_SHOW_PATH,
   OPT_START,
+  OPT_STDIN,
   OPT_THE_NAME_OF_THE_GAME,
   OPT_VERSION,
 };
@@ -169,6 +179,14 @@ const struct poptOption FindTeXMF::aoption[] =
     nullptr
   },
 
+  {
+    "stdin", 0,
+    POPT_ARG_NONE | POPT_ARGFLAG_ONEDASH, nullptr,
+    OPT_STDIN,
+    T_("Read queries from standard input, one per line (FILENAME or FILETYPE<TAB>FILENAME)."),
+    nullptr
+  },
+
   {
     "the-name-of-the-game", 0,
     POPT_ARG_STRING | POPT_ARGFLAG_ONEDASH, nullptr,
@@ -238,6 +256,74 @@ void FindTeXMF::PrintSearchPath(const char* lpszSearchPath)
   cout << endl;
 }
 
+FileType FindTeXMF::GetFileType(const string& fileName)
+{
+  FileType filetype = fileType;
+  if (filetype == FileType::None)
+  {
+    filetype = session->DeriveFileType(PathName(fileName));
+    if (filetype == FileType::None)
+    {
+      filetype = FileType::TEX;
+    }
+  }
+  return filetype;
+}
+
+/*
+ * Answers queries until the end of the input is reached.  A query is
+ * a file name, optionally preceded by a file type and a tab character.
+ * Each query gets one line of output (written immediately):
+ *
+ *   found<TAB>FILENAME<TAB>PATH
+ *   not-found<TAB>FILENAME
+ *   error<TAB>FILENAME<TAB>MESSAGE
+ *
+ * The session (and the file name databases) stay loaded between
+ * queries.
+ */
+void FindTeXMF::AnswerQueries()
+{
+  string line;
+  while (getline(cin, line))
+  {
+    if (!line.empty() && line.back() == '\r')
+    {
+      line.pop_back();
+    }
+    if (line.empty())
+    {
+      continue;
+    }
+    string fileName = line;
+    FileType filetype;
+    size_t tab = line.find('\t');
+    if (tab != string::npos)
+    {
+      fileName = line.substr(tab + 1);
+      filetype = session->DeriveFileType(PathName(line.substr(0, tab)));
+      if (filetype == FileType::None)
+      {
+        cout << "error\t" << fileName << "\t" << fmt::format(T_("Unknown file type: {0}."), line.substr(0, tab)) << endl;
+        continue;
+      }
+    }
+    else
+    {
+      filetype = GetFileType(fileName);
+    }
+    PathName path;
+    if (session->FindFile(fileName, filetype, path))
+    {
+      cout << "found\t" << fileName << "\t" << path.ToString() << endl;
+    }
+    else
+    {
+      cout << "not-found\t" << fileName << endl;
+    }
+  }
+}
+
 int FindTeXMF::Run(int argc, const char** argv)
 {
   session = GetSession();
@@ -312,6 +398,11 @@ int FindTeXMF::Run(int argc, const char** argv)
       start = true;
       break;
 
+    case OPT_STDIN:
+
+      readStdin = true;
+      break;
+
     case OPT_THE_NAME_OF_THE_GAME:
 
       session->SetTheNameOfTheGame(optArg);
@@ -336,6 +427,16 @@ int FindTeXMF::Run(int argc, const char** argv)
 
   vector<string> leftovers = popt.GetLeftovers();
 
+  if (readStdin)
+  {
+    if (!leftovers.empty() || start)
+    {
+      FatalError(T_("-stdin cannot be combined with file name arguments or -start."));
+    }
+    AnswerQueries();
+    return EXIT_SUCCESS;
+  }
+
   if (leftovers.empty())
   {
     if (!needArg)
@@ -353,16 +454,7 @@ int FindTeXMF::Run(int argc, const char** argv)
   for (const string& fileName : leftovers)
   {
     PathName path;
-    FileType filetype = fileType;
-    if (filetype == FileType::None)
-    {
-      filetype = session->DeriveFileType(PathName(fileName));
-      if (filetype == FileType::None)
-      {
-        filetype = FileType::TEX;
-      }
-    }
-    bool found = session->FindFile(fileName, filetype, path);
+    bool found = session->FindFile(fileName, GetFileType(fileName), path);
     if (found)
     {
       cout << path << endl;
@@ -30,6 +30,7 @@
 
 #include <cstdarg>
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <memory>
@@ -179,10 +180,48 @@ private:
   void WritePkFile(const char* pkFile);
 
 private:
-  Process* StartGhostscript(const char* fontFile, const char* encFile, const char* fontName, const char* specInfo, const char* dpiString, FILE** ppGsOut, FILE** ppGsErr);
+  Process* StartGhostscript(const char* fontFile, const char* encFile, const char* fontName, const char* specInfo, const char* dpiString, const string& charList, FILE** ppGsOut, FILE** ppGsErr);
 
 private:
-  void StderrReader();
+  static void StderrReader(FILE* pFile, string* text);
+
+  // a Ghostscript process rendering a contiguous range of characters
+private:
+  struct GhostscriptJob
+  {
+    ~GhostscriptJob()
+    {
+      if (stdoutSpooler.joinable())
+      {
+        stdoutSpooler.join();
+      }
+      if (stderrReader.joinable())
+      {
+        stderrReader.join();
+      }
+    }
+    int lastChar = -1;
+    unique_ptr<Process> process;
+    AutoFILE pFileOut;
+    AutoFILE pFileErr;
+    AutoFILE pFileSpool;
+    bool spoolFailed = false;
+    string stdErr;
+    thread stdoutSpooler;
+    thread stderrReader;
+  };
+
+private:
+  static void Spool(GhostscriptJob* job);
+
+private:
+  void StartGhostscriptJobs(const char* fontFile, const char* encFile, const char* fontName, const char* specInfo, const char* dpiString);
+
+private:
+  void ContinueWithGhostscriptJob(GhostscriptJob& job);
+
+private:
+  void FinishGhostscriptJobs();
 
 private:
   void Convert(const char* texFontName, const char* fontName, const char* specInfo, const char* encFile, const char* fontFile, const char* dpiString, const char* pkFile);
@@ -203,10 +242,13 @@ private:
   AutoFILE pFileGsf;
 
 private:
-  AutoFILE pFileGsErr;
+  string gsStdErr;
 
 private:
-  string gsStdErr;
+  vector<unique_ptr<GhostscriptJob>> ghostscriptJobs;
+
+private:
+  int maxJobs = 0;
 
 private:
   vector<int> lengths;
@@ -218,7 +260,7 @@ private:
   vector<int> widthIndex;
 
 private:
-  string chars;
+  vector<int> charCodes;
 
 private:
   int checkSum;
@@ -319,11 +361,15 @@ private:
 
 enum Option
 {
-  OPT_AAA = 1, OPT_QUIET, OPT_VERBOSE, OPT_VERSION,
+  OPT_AAA = 1, OPT_JOBS, OPT_QUIET, OPT_VERBOSE, OPT_VERSION,
 };
 
 const struct poptOption Converter::aoption[] = {
 
+  {
+    "jobs", 0, POPT_ARG_STRING, nullptr, OPT_JOBS, T_("Run at most N Ghostscript processes at once."), "N"
+  },
+
   {
     "quiet", 0, POPT_ARG_NONE, nullptr, OPT_QUIET, T_("Suppress all output (except errors)."), nullptr
   },
@@ -530,7 +576,7 @@ void Converter::ReadTFMFile(const char* texFontName)
   lengths.resize(12, 0);
   widths.resize(256, 0);
   widthIndex.resize(256, 0);
-  chars.reserve(1000);
+  charCodes.reserve(256);
 
   PathName pathTFMFile;
 
@@ -562,17 +608,12 @@ void Converter::ReadTFMFile(const char* texFontName)
     widthIndex[cc] = GetByte(pFile.Get());
     if (widthIndex[cc] != 0)
     {
-      if (chars.length() > 0)
-      {
-        chars += ' ';
-      }
-      chars += std::to_string(cc);
+      charCodes.push_back(cc);
     }
     GetByte(pFile.Get());
     GetByte(pFile.Get());
     GetByte(pFile.Get());
   }
-  chars += T_('\n');
 
   for (int i = 0; i < nw(); ++i)
   {
@@ -582,7 +623,7 @@ void Converter::ReadTFMFile(const char* texFontName)
   pFile.Reset();
 }
 
-Process* Converter::StartGhostscript(const char* fontFile, const char* encFile, const char* fontName, const char* specInfo, const char* dpiString, FILE** ppGsOut, FILE** ppGsErr)
+Process* Converter::StartGhostscript(const char* fontFile, const char* encFile, const char* fontName, const char* specInfo, const char* dpiString, const string& charList, FILE** ppGsOut, FILE** ppGsErr)
 {
   PathName pathGs = session->GetGhostscript(nullptr);
 
@@ -687,7 +728,7 @@ Process* Converter::StartGhostscript(const char* fontFile, const char* encFile,
   // write the design size and character list to Gs stdin
   size_t n;
   if (((n = fwrite(designSizeString.c_str(), 1, designSizeString.length(), pFileGsIn.Get())) != designSizeString.length())
-    || ((n = fwrite(chars.c_str(), 1, chars.length(), pFileGsIn.Get())) != chars.length()))
+    || ((n = fwrite(charList.c_str(), 1, charList.length(), pFileGsIn.Get())) != charList.length()))
   {
     Error(T_("Ghostscript communication failure."));
   }
@@ -702,19 +743,19 @@ Process* Converter::StartGhostscript(const char* fontFile, const char* encFile,
   return pProcess.release();
 }
 
-void Converter::StderrReader()
+void Converter::StderrReader(FILE* pFile, string* text)
 {
   try
   {
 #define CHUNK_SIZE 64
     char buf[CHUNK_SIZE];
     size_t n;
-    gsStdErr = "";
-    while ((n = fread(buf, 1, CHUNK_SIZE, pFileGsErr.Get())) > 0)
+    *text = "";
+    while ((n = fread(buf, 1, CHUNK_SIZE, pFile)) > 0)
     {
       for (size_t i = 0; i < n; ++i)
       {
-        gsStdErr += buf[i];
+        *text += buf[i];
       }
     }
   }
@@ -723,6 +764,124 @@ void Converter::StderrReader()
   }
 }
 
+void Converter::Spool(GhostscriptJob* job)
+{
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), job->pFileOut.Get())) > 0)
+  {
+    if (!job->spoolFailed && fwrite(buf, 1, n, job->pFileSpool.Get()) != n)
+    {
+      // keep reading: Ghostscript must not block on a full pipe
+      job->spoolFailed = true;
+    }
+  }
+}
+
+/* _________________________________________________________________________
+
+   Converter::StartGhostscriptJobs
+
+   Split the characters into contiguous ranges, one Ghostscript
+   process per range. The output of the first process is converted
+   as it comes in; the output of the others is spooled to temporary
+   files in the meantime.
+   _________________________________________________________________________ */
+
+void Converter::StartGhostscriptJobs(const char* fontFile, const char* encFile, const char* fontName, const char* specInfo, const char* dpiString)
+{
+  // a Ghostscript start costs about as much as rendering a few dozen characters
+  const size_t MIN_CHARS_PER_JOB = 32;
+  size_t numJobs = maxJobs > 0 ? static_cast<size_t>(maxJobs) : std::max<size_t>(1, thread::hardware_concurrency());
+  numJobs = std::max<size_t>(1, std::min(numJobs, charCodes.size() / MIN_CHARS_PER_JOB));
+  for (size_t j = 0; j < numJobs; ++j)
+  {
+    size_t begin = j * charCodes.size() / numJobs;
+    size_t end = (j + 1) * charCodes.size() / numJobs;
+    string charList;
+    for (size_t k = begin; k < end; ++k)
+    {
+      if (k > begin)
+      {
+        charList += ' ';
+      }
+      charList += std::to_string(charCodes[k]);
+    }
+    charList += '\n';
+    unique_ptr<GhostscriptJob> job = make_unique<GhostscriptJob>();
+    job->lastChar = end > begin ? charCodes[end - 1] : -1;
+    FILE* pGsOut;
+    FILE* pGsErr;
+    job->process.reset(StartGhostscript(fontFile, encFile, fontName, specInfo, dpiString, charList, &pGsOut, &pGsErr));
+    job->pFileErr.Reset(pGsErr);
+    job->stderrReader = thread(&Converter::StderrReader, job->pFileErr.Get(), &job->stdErr);
+    if (j == 0)
+    {
+      pFileGsf.Reset(pGsOut);
+    }
+    else
+    {
+      job->pFileOut.Reset(pGsOut);
+      job->pFileSpool.Reset(tmpfile());
+      if (job->pFileSpool.Get() == nullptr)
+      {
+        MIKTEX_FATAL_CRT_ERROR("tmpfile");
+      }
+      job->stdoutSpooler = thread(&Converter::Spool, job.get());
+    }
+    ghostscriptJobs.push_back(std::move(job));
+  }
+  if (numJobs > 1)
+  {
+    Verbose(fmt::format(T_("Rendering with {0} Ghostscript processes..."), numJobs));
+  }
+}
+
+void Converter::ContinueWithGhostscriptJob(GhostscriptJob& job)
+{
+  job.stdoutSpooler.join();
+  if (job.spoolFailed || fflush(job.pFileSpool.Get()) != 0)
+  {
+    Error(T_("Ghostscript communication failure."));
+  }
+  rewind(job.pFileSpool.Get());
+  pFileGsf.Reset(job.pFileSpool.Detach());
+  haveFirstLine = false;
+}
+
+void Converter::FinishGhostscriptJobs()
+{
+  pFileGsf.Reset();
+  bool failed = false;
+  bool timedOut = false;
+  for (unique_ptr<GhostscriptJob>& job : ghostscriptJobs)
+  {
+    if (!job->process->WaitForExit(10000))
+    {
+      timedOut = true;
+    }
+    else if (job->process->get_ExitCode() != 0)
+    {
+      failed = true;
+    }
+  }
+  if (timedOut)
+  {
+    Error(T_("Ghostscript didn't complete."));
+  }
+  gsStdErr = "";
+  for (unique_ptr<GhostscriptJob>& job : ghostscriptJobs)
+  {
+    job->stderrReader.join();
+    gsStdErr += job->stdErr;
+  }
+  if (failed)
+  {
+    Error(T_("Ghostscript failed."));
+  }
+  ghostscriptJobs.clear();
+}
+
 /* _________________________________________________________________________
 
    Converter::tallyup
@@ -1349,10 +1508,16 @@ void Converter::WritePkFile(const char* pkFile)
   PutDword(ppp);               // vppp
 
   // write bitmaps
+  size_t job = 0;
   for (int cc = bc(); cc <= ec(); ++cc)
   {
     if (widthIndex[cc] != 0)
     {
+      while (cc > ghostscriptJobs[job]->lastChar)
+      {
+        ++job;
+        ContinueWithGhostscriptJob(*ghostscriptJobs[job]);
+      }
       PutGlyph(cc);
     }
   }
@@ -1382,32 +1547,19 @@ void Converter::Convert(const char* texFontName, const char* fontName, const cha
 
   try
   {
-    unique_ptr<Process> pGhostscript(StartGhostscript(fontFile, encFile, fontName, specInfo, dpiString, &pFileGsf, &pFileGsErr));
-
-    thread stderrReader(&Converter::StderrReader, this);
+    StartGhostscriptJobs(fontFile, encFile, fontName, specInfo, dpiString);
 
     WritePkFile(pkFile);
 
-    pFileGsf.Reset();
-
-    if (!pGhostscript->WaitForExit(10000))
-    {
-      Error(T_("Ghostscript didn't complete."));
-    }
-
-    if (pGhostscript->get_ExitCode() != 0)
-    {
-      Error(T_("Ghostscript failed."));
-    }
-
-    pFileGsErr.Reset();
-    stderrReader.join();
-    pGhostscript.reset();
+    FinishGhostscriptJobs();
   }
 
-  catch (const exception&)
+  catch (...)
   {
+    // closing the pipe lets a Ghostscript process which is still
+    // writing terminate, so that the reader threads can be joined
     pFileGsf.Reset();
+    ghostscriptJobs.clear();
     throw;
   }
 
@@ -1427,6 +1579,9 @@ void Converter::Main(int argc, const char** argv)
   {
     switch (option)
     {
+    case OPT_JOBS:
+      maxJobs = std::stoi(popt.GetOptArg());
+      break;
     case OPT_QUIET:
       if (verbose)
       {
@@ -13,7 +13,9 @@
 
 #pragma once
 
+#include <fstream>
 #include <iostream>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -29,6 +31,7 @@
 #include <miktex/Core/CommandLineBuilder>
 #include <miktex/Core/Directory>
 #include <miktex/Core/File>
+#include <miktex/Core/MD5>
 #include <miktex/Util/PathName>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Process>
@@ -275,6 +278,85 @@ protected:
         }
     }
 
+    // checks whether the input files listed by InstallDependencies() are
+    // unchanged
+    bool DependenciesUnchanged(const MiKTeX::Util::PathName& dest)
+    {
+        MiKTeX::Util::PathName depsFile(dest);
+        depsFile.AppendExtension(MIKTEX_DEPENDENCIES_FILE_SUFFIX);
+        if (!MiKTeX::Core::File::Exists(depsFile))
+        {
+            return false;
+        }
+        std::ifstream reader = MiKTeX::Core::File::CreateInputStream(depsFile);
+        bool haveDependencies = false;
+        for (std::string line; std::getline(reader, line); )
+        {
+            size_t pos = line.find(' ');
+            if (pos == std::string::npos)
+            {
+                return false;
+            }
+            MiKTeX::Util::PathName path(line.substr(pos + 1));
+            if (!MiKTeX::Core::File::Exists(path) || MiKTeX::Core::MD5::FromFile(path) != MiKTeX::Core::MD5::Parse(line.substr(0, pos)))
+            {
+                return false;
+            }
+            haveDependencies = true;
+        }
+        return haveDependencies;
+    }
+
+    // writes the list of input files (with their MD5) which have been
+    // recorded while making the dump file
+    void InstallDependencies(const MiKTeX::Util::PathName& recorderFile, const MiKTeX::Util::PathName& dest)
+    {
+        MiKTeX::Util::PathName depsFile(dest);
+        depsFile.AppendExtension(MIKTEX_DEPENDENCIES_FILE_SUFFIX);
+        if (printOnly)
+        {
+            return;
+        }
+        if (MiKTeX::Core::File::Exists(depsFile))
+        {
+            MiKTeX::Core::File::Delete(depsFile);
+        }
+        if (!MiKTeX::Core::File::Exists(recorderFile) || !MiKTeX::Core::File::Exists(dest))
+        {
+            return;
+        }
+        std::vector<MiKTeX::Util::PathName> inputFiles;
+        std::set<std::string> seen;
+        std::ifstream reader = MiKTeX::Core::File::CreateInputStream(recorderFile);
+        const std::string input = "INPUT ";
+        for (std::string line; std::getline(reader, line); )
+        {
+            if (line.compare(0, input.length(), input) != 0)
+            {
+                continue;
+            }
+            MiKTeX::Util::PathName path(line.substr(input.length()));
+            // relative paths refer to the working directory
+            if (!path.IsAbsolute() || !MiKTeX::Core::File::Exists(path) || !seen.insert(path.ToString()).second)
+            {
+                continue;
+            }
+            inputFiles.push_back(path);
+        }
+        reader.close();
+        if (inputFiles.empty())
+        {
+            return;
+        }
+        Verbose(fmt::format(T_("Installing {0}..."), Q_(depsFile)));
+        std::ofstream writer = MiKTeX::Core::File::CreateOutputStream(depsFile);
+        for (const MiKTeX::Util::PathName& path : inputFiles)
+        {
+            writer << MiKTeX::Core::MD5::FromFile(path) << " " << path.ToString() << "\n";
+        }
+        writer.close();
+    }
+
     MiKTeX::Util::PathName CreateDirectoryFromTemplate(const std::string& templ)
     {
         MiKTeX::Util::PathName path;
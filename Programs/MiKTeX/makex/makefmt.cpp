@@ -15,7 +15,10 @@
 
 #include "makefmt-version.h"
 
+#include <zlib.h>
+
 #include <miktex/Configuration/ConfigNames>
+#include <miktex/Core/FileStream>
 #include <miktex/Core/TemporaryDirectory>
 #include <miktex/Util/Tokenizer>
 
@@ -33,10 +36,12 @@ log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("makefmt"));
 enum
 {
     OPT_AAA = 1,
+    OPT_COMPRESS,
     OPT_DESTNAME,
     OPT_ENGINE,
     OPT_ENGINE_OPTION,
     OPT_JOB_TIME,
+    OPT_KEEP_IF_UNCHANGED,
     OPT_NO_DUMP,
     OPT_PRELOAD,
 };
@@ -124,6 +129,7 @@ public:
 
 private:
 
+    void CompressFormatFile(const PathName& source, const PathName& dest) const;
     PdfConfigValues ParsePdfConfigFiles() const;
     void CreateDestinationDirectory() override;
     void FindInputFile(const PathName& inputName, PathName& inputFile);
@@ -217,16 +223,20 @@ private:
     }
 
     BEGIN_OPTION_MAP(MakeFmt)
+        OPTION_ENTRY_TRUE(OPT_COMPRESS, compress)
         OPTION_ENTRY(OPT_ENGINE, SetEngine(optArg))
         OPTION_ENTRY(OPT_ENGINE_OPTION, AppendEngineOption(optArg))
         OPTION_ENTRY_SET(OPT_DESTNAME, destinationName)
         OPTION_ENTRY_SET(OPT_JOB_TIME, jobTime)
+        OPTION_ENTRY_TRUE(OPT_KEEP_IF_UNCHANGED, keepIfUnchanged)
         OPTION_ENTRY_SET(OPT_PRELOAD, preloadedFormat)
         OPTION_ENTRY_TRUE(OPT_NO_DUMP, noDumpPrimitive)
     END_OPTION_MAP();
 
+    bool compress = false;
     Engine engine = Engine::TeX;
     PathName destinationName;
+    bool keepIfUnchanged = false;
     bool noDumpPrimitive = false;
     string jobTime;
     string preloadedFormat;
@@ -243,6 +253,7 @@ void MakeFmt::Usage()
         << T_("NAME is the name of the format, such as 'tex'.") << "\n"
         << "\n"
         << T_("Options:") << "\n"
+        << "--compress " << T_("Compress the format file.") << "\n"
         << "--debug, -d " << T_("Print debugging information.") << "\n"
         << "--dest-name NAME " << T_("Destination file name.") << "\n"
         << "--disable-installer " << T_("Disable the package installer.") << "\n"
@@ -251,6 +262,7 @@ void MakeFmt::Usage()
         << "--engine-option=OPTION " << T_("Add an engine option.") << "\n"
         << "--help, -h " << T_("Print this help screen and exit.") << "\n"
         << "--job-time=FILE " << T_("Job time is file's modification time.") << "\n"
+        << "--keep-if-unchanged " << T_("Keep the format file if its input files are unchanged.") << "\n"
         << "--no-dump " << T_("Don't issue the \\dump command.") << "\n"
         << "--preload FORMAT " << T_("Format to be preloaded.") << "\n"
         << "--print-only, -n " << T_("Print what commands would be executed.") << "\n"
@@ -263,10 +275,12 @@ namespace
     const struct option aLongOptions[] =
     {
         COMMON_OPTIONS,
+        { "compress",           no_argument,            nullptr,        OPT_COMPRESS },
         { "dest-name",          required_argument,      nullptr,        OPT_DESTNAME },
         { "engine",             required_argument,      nullptr,        OPT_ENGINE },
         { "engine-option",      required_argument,      nullptr,        OPT_ENGINE_OPTION },
         { "job-time",           required_argument,      nullptr,        OPT_JOB_TIME },
+        { "keep-if-unchanged",  no_argument,            nullptr,        OPT_KEEP_IF_UNCHANGED },
         { "no-dump",            no_argument,            nullptr,        OPT_NO_DUMP },
         { "preload",            required_argument,      nullptr,        OPT_PRELOAD },
         { nullptr,              no_argument,            nullptr,        0 },
@@ -372,6 +386,35 @@ void MakeFmt::ParsePdfConfigFile(const PathName& cfgFile, PdfConfigValues& value
     }
 }
 
+void MakeFmt::CompressFormatFile(const PathName& source, const PathName& dest) const
+{
+    LOG4CXX_INFO(logger, "compressing " << source << " => " << dest);
+    vector<unsigned char> data = File::ReadAllBytes(source);
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    // fastest compression level: decompression speed matters most
+    int ret = deflateInit2(&strm, Z_BEST_SPEED, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    if (ret != Z_OK)
+    {
+        MIKTEX_FATAL_ERROR_2(T_("GZ encoder initialization did not succeed."), "ret", std::to_string(ret));
+    }
+    vector<unsigned char> compressed(deflateBound(&strm, static_cast<uLong>(data.size())));
+    strm.next_in = data.data();
+    strm.avail_in = static_cast<uInt>(data.size());
+    strm.next_out = compressed.data();
+    strm.avail_out = static_cast<uInt>(compressed.size());
+    ret = deflate(&strm, Z_FINISH);
+    size_t compressedSize = compressed.size() - strm.avail_out;
+    deflateEnd(&strm);
+    if (ret != Z_STREAM_END)
+    {
+        MIKTEX_FATAL_ERROR_2(T_("GZ encoder did not succeed."), "ret", std::to_string(ret));
+    }
+    FileStream stream(File::Open(dest, FileMode::Create, FileAccess::Write, false));
+    stream.Write(compressed.data(), compressedSize);
+    stream.Close();
+}
+
 void MakeFmt::InstallPdftexConfigTeX() const
 {
     PdfConfigValues pdfConfigValues = ParsePdfConfigFiles();
@@ -417,6 +460,14 @@ void MakeFmt::Run(int argc, const char** argv)
     PathName pathDest(destinationDirectory, destinationName);
     pathDest.AppendExtension(MIKTEX_FORMAT_FILE_SUFFIX);
 
+    // a format file which has just been made (e.g., as the preloaded
+    // format of another format) can be used as is
+    if (keepIfUnchanged && File::Exists(pathDest) && DependenciesUnchanged(pathDest))
+    {
+        Verbose(fmt::format(T_("The {0} format file is up to date."), Q_(destinationName)));
+        return;
+    }
+
     // make the log file name
     PathName logFile(destinationName);
     logFile.AppendExtension(".log");
@@ -450,6 +501,7 @@ void MakeFmt::Run(int argc, const char** argv)
             arguments.push_back("--alias=" + destinationName.ToString());
         }
         arguments.push_back("--job-name=" + destinationName.ToString());
+        arguments.push_back("--recorder");
         if (!jobTime.empty())
         {
             arguments.push_back("--job-time=" + jobTime);
@@ -499,7 +551,25 @@ void MakeFmt::Run(int argc, const char** argv)
     }
 
     // install format file
-    Install(wrkDir->GetPathName() / formatFile, pathDest);
+    if (compress || session->GetConfigValue(MIKTEX_CONFIG_SECTION_MAKEFMT, MIKTEX_CONFIG_VALUE_COMPRESS, ConfigValue(false)).GetBool())
+    {
+        PathName compressedFormatFile(formatFile);
+        compressedFormatFile.AppendExtension(".gz");
+        if (!printOnly)
+        {
+            CompressFormatFile(wrkDir->GetPathName() / formatFile, wrkDir->GetPathName() / compressedFormatFile);
+        }
+        Install(wrkDir->GetPathName() / compressedFormatFile, pathDest);
+    }
+    else
+    {
+        Install(wrkDir->GetPathName() / formatFile, pathDest);
+    }
+
+    // install the list of files the format has been made of
+    PathName recorderFile(destinationName);
+    recorderFile.AppendExtension(".fls");
+    InstallDependencies(wrkDir->GetPathName() / recorderFile, pathDest);
 }
 
 #if defined(_UNICODE)
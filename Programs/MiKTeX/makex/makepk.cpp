@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief MiKTeX MakePK
  *
- * @copyright Copyright © 1998-2022 Christian Schenk
+ * @copyright Copyright © 1998-2023 Christian Schenk
  *
  * This file is part of the MiKTeX Make Utility Collection.
  *
@@ -15,6 +15,10 @@
 
 #include "makepk-version.h"
 
+#include <algorithm>
+#include <deque>
+#include <thread>
+
 #include <miktex/Configuration/ConfigNames>
 #include <miktex/Core/TemporaryDirectory>
 #include <miktex/Util/Tokenizer>
@@ -31,6 +35,8 @@ log4cxx::LoggerPtr logger(log4cxx::Logger::getLogger("makepk"));
 
 #define OPT_MAP_FILE 1
 #define OPT_FORCE 2
+#define OPT_BATCH 3
+#define OPT_JOBS 4
 
 class MakePk :
     public MakeUtility
@@ -42,6 +48,15 @@ public:
 
 private:
 
+    struct BatchJob
+    {
+        string name;
+        string dpi;
+        string bdpi;
+        string magnification;
+        string mode;
+    };
+
     bool FindFontMapping(const char* texFontName, const char* mapFileName, DvipsFontMapEntry& mapEntry);
     bool IsHbf(const char* name);
     bool SearchPostScriptFont(const char* texFontName, DvipsFontMapEntry& mapEntry);
@@ -53,12 +68,19 @@ private:
     void RunGSF2PK(const DvipsFontMapEntry& mapEntry, const char* pkName, int dpi, const PathName& workingDirectory);
     void RunPS2PK(const DvipsFontMapEntry& mapEntry, const char* pkName, int dpi, const PathName& workingDirectory);
     void Usage() override;
+    vector<BatchJob> ReadBatchFile(const string& fileName);
+    unique_ptr<Process> StartBatchJob(const PathName& exe, const BatchJob& job, int jobsPerFont);
+    void RunBatch(const string& fileName);
 
     BEGIN_OPTION_MAP(MakePk)
         OPTION_ENTRY(OPT_MAP_FILE, mapFiles.push_back(optArg))
         OPTION_ENTRY_TRUE(OPT_FORCE, overwriteExisting)
+        OPTION_ENTRY_SET(OPT_BATCH, batchFile)
+        OPTION_ENTRY(OPT_JOBS, maxJobs = atoi(optArg))
     END_OPTION_MAP();
 
+    string batchFile;
+    int maxJobs = 0;
     bool overwriteExisting = false;
     bool modeless;
     int dpi;
@@ -72,6 +94,7 @@ void MakePk::Usage()
 {
     OUT__
         << T_("Usage:") << " " << Utils::GetExeName() << " " << T_("[OPTION]... name dpi bdpi magnification [MODE]") << "\n"
+        << "      " << " " << Utils::GetExeName() << " " << T_("[OPTION]... --batch=FILE") << "\n"
         << "\n"
         << T_("This program makes a PK font.") << "\n"
         << "\n"
@@ -84,12 +107,21 @@ void MakePk::Usage()
         << T_("You can specify 0 as BDPI. In that case, BDPI is calculated from") << "\n"
         << T_("the MODE.") << "\n"
         << "\n"
+        << T_("In batch mode, FILE (- for standard input) contains one font per") << "\n"
+        << T_("line (name dpi bdpi magnification [MODE]).  The fonts are made") << "\n"
+        << T_("by concurrently running jobs.") << "\n"
+        << "\n"
+        << T_("Outside of batch mode, N limits the number of Ghostscript processes") << "\n"
+        << T_("rendering the characters of a PostScript font.") << "\n"
+        << "\n"
         << T_("Options:") << "\n"
+        << "--batch=FILE " << T_("Make the fonts listed in FILE.") << "\n"
         << "--debug, -d " << T_("Print debugging information.") << "\n"
         << "--disable-installer " << T_("Disable the package installer.") << "\n"
         << "--enable-installer " << T_("Enable the package installer.") << "\n"
         << "--force " << T_("Make PK font, even if it exists already.") << "\n"
         << "--help, -h " << T_("Print this help screen and exit.") << "\n"
+        << "--jobs=N " << T_("Run at most N jobs at once (batch mode).") << "\n"
         << "--map-file=FILE " << T_("Consult additional map file.") << "\n"
         << "--print-only, -n " << T_("Print what commands would be executed.") << "\n"
         << "--verbose, -v " << T_("Print information on what is being done.") << "\n"
@@ -100,7 +132,9 @@ namespace {
     const struct option aLongOptions[] =
     {
       COMMON_OPTIONS,
+      {"batch",                required_argument,      nullptr,      OPT_BATCH},
       {"force",                no_argument,            nullptr,      OPT_FORCE},
+      {"jobs",                 required_argument,      nullptr,      OPT_JOBS},
       {"map-file",             required_argument,      nullptr,      OPT_MAP_FILE},
       {nullptr,                no_argument,            nullptr,      0}
     };
@@ -259,6 +293,10 @@ void MakePk::ExtraPS2PKOptions(const DvipsFontMapEntry& mapEntry, vector<string>
 void MakePk::RunGSF2PK(const DvipsFontMapEntry& mapEntry, const char* pkName, int dpi, const PathName& workingDirectory)
 {
     vector<string> arguments;
+    if (maxJobs > 0)
+    {
+        arguments.push_back("--jobs=" + std::to_string(maxJobs));
+    }
     arguments.push_back(mapEntry.texName);
     arguments.push_back(mapEntry.psName);
     arguments.push_back(mapEntry.specialInstructions);
@@ -394,11 +432,188 @@ bool MakePk::IsHbf(const char* name)
     return session->FindFile(hbfcfg.ToString(), "%R/HBF2GF//", path);
 }
 
+vector<MakePk::BatchJob> MakePk::ReadBatchFile(const string& fileName)
+{
+    ifstream fileStream;
+    if (fileName != "-")
+    {
+        fileStream = File::CreateInputStream(PathName(fileName));
+    }
+    istream& stream = fileName == "-" ? cin : fileStream;
+    vector<BatchJob> jobs;
+    set<string> seen;
+    string line;
+    while (std::getline(stream, line))
+    {
+        vector<string> fields;
+        for (Tokenizer tok(line, " \t\r"); tok; ++tok)
+        {
+            fields.push_back(*tok);
+        }
+        if (fields.empty() || fields[0][0] == '%' || fields[0][0] == '#')
+        {
+            continue;
+        }
+        if (fields.size() < 4 || fields.size() > 5)
+        {
+            FatalError(fmt::format(T_("Invalid batch file line: {0}"), Q_(line)));
+        }
+        BatchJob job{ fields[0], fields[1], fields[2], fields[3], fields.size() > 4 ? fields[4] : "" };
+        // a document usually asks for the same font more than once
+        if (seen.insert(job.name + " " + job.dpi + " " + job.mode).second)
+        {
+            jobs.push_back(job);
+        }
+    }
+    return jobs;
+}
+
+unique_ptr<Process> MakePk::StartBatchJob(const PathName& exe, const BatchJob& job, int jobsPerFont)
+{
+    ProcessStartInfo startInfo(exe);
+    startInfo.Arguments.push_back(MIKTEX_MAKEPK_EXE);
+    if (session->IsAdminMode())
+    {
+        startInfo.Arguments.push_back("--miktex-admin");
+    }
+    switch (GetEnableInstaller())
+    {
+    case MiKTeX::Configuration::TriState::False:
+        startInfo.Arguments.push_back("--miktex-disable-installer");
+        break;
+    case MiKTeX::Configuration::TriState::True:
+        startInfo.Arguments.push_back("--miktex-enable-installer");
+        break;
+    default:
+        break;
+    }
+    startInfo.Arguments.push_back("--miktex-disable-maintenance");
+    startInfo.Arguments.push_back("--miktex-disable-diagnose");
+    if (debug)
+    {
+        startInfo.Arguments.push_back("--debug");
+    }
+    if (verbose)
+    {
+        startInfo.Arguments.push_back("--verbose");
+    }
+    if (quiet)
+    {
+        startInfo.Arguments.push_back("--quiet");
+    }
+    if (overwriteExisting)
+    {
+        startInfo.Arguments.push_back("--force");
+    }
+    for (const string& mapFile : mapFiles)
+    {
+        startInfo.Arguments.push_back("--map-file=" + mapFile);
+    }
+    startInfo.Arguments.push_back("--jobs=" + std::to_string(jobsPerFont));
+    startInfo.Arguments.push_back(job.name);
+    startInfo.Arguments.push_back(job.dpi);
+    startInfo.Arguments.push_back(job.bdpi);
+    startInfo.Arguments.push_back(job.magnification);
+    if (!job.mode.empty())
+    {
+        startInfo.Arguments.push_back(job.mode);
+    }
+    LOG4CXX_INFO(logger, "starting: " << CommandLineBuilder(startInfo.Arguments).ToString());
+    return Process::Start(startInfo);
+}
+
+void MakePk::RunBatch(const string& fileName)
+{
+    deque<BatchJob> pending;
+    for (const BatchJob& job : ReadBatchFile(fileName))
+    {
+        pending.push_back(job);
+    }
+    PathName exe;
+    if (!session->FindFile(MIKTEX_MAKEPK_EXE, FileType::EXE, exe))
+    {
+        FatalError(fmt::format(T_("The application file {0} could not be found."), Q_(MIKTEX_MAKEPK_EXE)));
+    }
+    int jobs = maxJobs > 0 ? maxJobs : std::max(1, static_cast<int>(thread::hardware_concurrency()));
+    if (printOnly)
+    {
+        // keep the printed commands in order
+        jobs = 1;
+    }
+    // share the processors between the fonts being made at once
+    int jobsPerFont = std::max(1, static_cast<int>(thread::hardware_concurrency()) / jobs);
+    struct RunningJob
+    {
+        BatchJob job;
+        unique_ptr<Process> process;
+    };
+    vector<RunningJob> running;
+    size_t failed = 0;
+    while (!pending.empty() || !running.empty())
+    {
+        // start jobs; jobs for the same font run one after the other, because
+        // they share the METAFONT source and the destination directory
+        for (auto it = pending.begin(); it != pending.end() && running.size() < static_cast<size_t>(jobs); )
+        {
+            const string& name = it->name;
+            if (any_of(running.begin(), running.end(), [&name](const RunningJob& r) { return r.job.name == name; }))
+            {
+                ++it;
+                continue;
+            }
+            if (printOnly)
+            {
+                PrintOnly(fmt::format("makepk {} {} {} {} {}", it->name, it->dpi, it->bdpi, it->magnification, it->mode));
+                it = pending.erase(it);
+                continue;
+            }
+            running.push_back(RunningJob{ *it, StartBatchJob(exe, *it, jobsPerFont) });
+            it = pending.erase(it);
+        }
+        // reap finished jobs
+        bool reaped = false;
+        while (!reaped && !running.empty())
+        {
+            for (auto it = running.begin(); it != running.end(); )
+            {
+                if (it->process->WaitForExit(50))
+                {
+                    if (it->process->get_ExitStatus() != ProcessExitStatus::Exited || it->process->get_ExitCode() != 0)
+                    {
+                        failed += 1;
+                        Message(fmt::format(T_("PK font {0} at {1} DPI could not be created."), Q_(it->job.name), it->job.dpi));
+                    }
+                    it->process->Close();
+                    it = running.erase(it);
+                    reaped = true;
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+    }
+    if (failed > 0)
+    {
+        FatalError(fmt::format(T_("{0} PK font(s) could not be created."), failed));
+    }
+}
+
 void MakePk::Run(int argc, const char** argv)
 {
     // get command line options and arguments
     int optionIndex = 0;
     GetOptions(argc, argv, aLongOptions, optionIndex);
+    if (!batchFile.empty())
+    {
+        if (argc != optionIndex)
+        {
+            FatalError(T_("Invalid command-line."));
+        }
+        RunBatch(batchFile);
+        return;
+    }
     if (argc - optionIndex < 4 || argc - optionIndex > 5)
     {
         FatalError(T_("Invalid command-line."));
@@ -22,15 +22,25 @@
 
 #include <config.h>
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <iostream>
 #include <map>
 #include <set>
+#include <thread>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#if !defined(USE_SYSTEM_FONTCONFIG)
+#include <fontconfig/fontconfig.h>
+#endif
+
+#include <miktex/Core/AutoResource>
 #include <miktex/Core/CommandLineBuilder>
 #include <miktex/Core/Directory>
+#include <miktex/Core/File>
 #include <miktex/Core/Fndb>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Process>
@@ -231,7 +241,7 @@ MIKTEXNORETURN void FontMapManager::CfgError(const string& message)
     this->ctx->ui->FatalError(fmt::format(T_("{0}:{1}: {2}"), Q_(cfgContext.path), cfgContext.line, message));
 }
 
-MIKTEXNORETURN void FontMapManager::MapError(const string& message)
+MIKTEXNORETURN void FontMapManager::MapError(const FileContext& mapContext, const string& message)
 {
     this->ctx->ui->FatalError(fmt::format(T_("{0}:{1}: {2}"), Q_(mapContext.path), mapContext.line, message));
 }
@@ -270,6 +280,12 @@ void FontMapManager::SetOption(const std::string& optionName, const std::string&
     this->WriteConfigFile(configFile, partialConfiguration);
 }
 
+void FontMapManager::SetChangedFontDirectories(const vector<PathName>& directories)
+{
+    this->changedFontDirectories = directories;
+    this->haveChangedFontDirectories = true;
+}
+
 bool FontMapManager::ToBool(const string& value)
 {
     if (Utils::EqualsIgnoreCase(value, BOOLSTR(false)))
@@ -529,7 +545,6 @@ PathName FontMapManager::FontMapDirectory(const string& relPath)
 
 void FontMapManager::WriteDvipsFontMapFile(const PathName& path, const set<DvipsFontMapEntry>& fontMapEntries1, const set<DvipsFontMapEntry>& fontMapEntries2, const set<DvipsFontMapEntry>& fontMapEntries3, const set<DvipsFontMapEntry>& fontMapEntries4)
 {
-    Verbose(fmt::format(T_("Writing {0}..."), Q_(path)));
     // TODO: backup old file
     ofstream writer = File::CreateOutputStream(path, ios_base::binary);
     WriteHeader(writer, path);
@@ -539,31 +554,29 @@ void FontMapManager::WriteDvipsFontMapFile(const PathName& path, const set<Dvips
     fontMapEntries.insert(fontMapEntries4.begin(), fontMapEntries4.end());
     WriteDvipsFontMap(writer, fontMapEntries);
     writer.close();
-    if (!Fndb::FileExists(path))
-    {
-        Fndb::Add({ {path} });
-    }
 }
 
 void FontMapManager::WriteDvipdfmxFontMapFile(const PathName& path, const set<DvipdfmxFontMapEntry>& fontMapEntries)
 {
-    Verbose(fmt::format(T_("Writing {0}..."), Q_(path)));
     // TODO: backup old file
     ofstream writer = File::CreateOutputStream(path, ios_base::binary);
     WriteHeader(writer, path);
     WriteDvipdfmxFontMap(writer, fontMapEntries);
     writer.close();
+}
+
+void FontMapManager::RegisterFontMapFile(const PathName& path)
+{
+    this->ctx->session->WriteFontMapIndex(path);
     if (!Fndb::FileExists(path))
     {
         Fndb::Add({ {path} });
     }
 }
 
-void FontMapManager::ParseDvipsFontMapFile(const PathName& path, set<DvipsFontMapEntry>& fontMapEntries)
+void FontMapManager::ParseDvipsFontMapFile(const PathName& path, set<DvipsFontMapEntry>& fontMapEntries, FileContext& mapContext)
 {
-    Verbose(2, fmt::format(T_("Parsing Dvips font map file {0}..."), Q_(path)));
-
-    StreamReader reader(path);
+    StreamReader reader(path, true);
 
     string line;
 
@@ -574,27 +587,18 @@ void FontMapManager::ParseDvipsFontMapFile(const PathName& path, set<DvipsFontMa
     {
         ++mapContext.line;
         DvipsFontMapEntry fontMapEntry;
-        try
+        if (Utils::ParseDvipsFontMapLine(line, fontMapEntry))
         {
-            if (Utils::ParseDvipsFontMapLine(line, fontMapEntry))
-            {
-                fontMapEntries.insert(fontMapEntry);
-            }
-        }
-        catch (const MiKTeXException& e)
-        {
-            MapError(e.GetErrorMessage());
+            fontMapEntries.insert(fontMapEntry);
         }
     }
 
     reader.Close();
 }
 
-void FontMapManager::ParseDvipdfmxFontMapFile(const PathName& path, set<DvipdfmxFontMapEntry>& fontMapEntries)
+void FontMapManager::ParseDvipdfmxFontMapFile(const PathName& path, set<DvipdfmxFontMapEntry>& fontMapEntries, FileContext& mapContext)
 {
-    Verbose(2, fmt::format(T_("Parsing Dvipdfmx font map file {0}..."), Q_(path)));
-
-    StreamReader reader(path);
+    StreamReader reader(path, true);
 
     string line;
 
@@ -605,16 +609,9 @@ void FontMapManager::ParseDvipdfmxFontMapFile(const PathName& path, set<Dvipdfmx
     {
         ++mapContext.line;
         DvipdfmxFontMapEntry fontMapEntry;
-        try
-        {
-            if (ParseDvipdfmxFontMapLine(line, fontMapEntry))
-            {
-                fontMapEntries.insert(fontMapEntry);
-            }
-        }
-        catch (const MiKTeXException& e)
+        if (ParseDvipdfmxFontMapLine(line, fontMapEntry))
         {
-            MapError(e.GetErrorMessage());
+            fontMapEntries.insert(fontMapEntry);
         }
     }
 
@@ -754,44 +751,90 @@ bool MIKTEXTHISCALL FontMapManager::OnProcessOutput(const void* output, size_t n
     return true;
 }
 
-void FontMapManager::ReadDvipsFontMapFile(const string& fileName, set<DvipsFontMapEntry>& result, bool mustExist)
+vector<PathName> FontMapManager::LocateFontMapFiles(const set<string>& fileNames)
 {
-    PathName path;
-    if (!LocateFontMapFile(fileName, path, mustExist))
-    {
-        return;
-    }
-    ParseDvipsFontMapFile(path, result);
-}
-
-set<DvipsFontMapEntry> FontMapManager::CatDvipsFontMaps(const set<string>& fileNames)
-{
-    set<DvipsFontMapEntry> result;
+    vector<PathName> result;
     for (const string& fn : fileNames)
     {
-        ReadDvipsFontMapFile(fn, result, false);
+        PathName path;
+        if (LocateFontMapFile(fn, path, false))
+        {
+            result.push_back(path);
+        }
     }
     return result;
 }
 
-void FontMapManager::ReadDvipdfmxFontMapFile(const string& fileName, set<DvipdfmxFontMapEntry>& result, bool mustExist)
+/**
+ * @brief Calculate a digest of everything the generated font map files depend on.
+ * 
+ * @param mapFiles The font map files to be read.
+ * @return MD5 
+ */
+MD5 FontMapManager::GetInputDigest(const vector<PathName>& mapFiles)
 {
-    PathName path;
-    if (!LocateFontMapFile(fileName, path, mustExist))
+    MD5Builder md5Builder;
+    auto update = [&md5Builder](const string& s)
     {
-        return;
+        md5Builder.Update(s.c_str(), s.length() + 1);
+    };
+    for (const auto& kv : optionDefaults)
+    {
+        update(kv.first);
+        update(this->Option(kv.first));
+    }
+    for (const PathName& path : mapFiles)
+    {
+        update(path.ToString());
+        update(MD5::FromFile(path).ToString());
     }
-    ParseDvipdfmxFontMapFile(path, result);
+    return md5Builder.Final();
 }
 
-set<DvipdfmxFontMapEntry> FontMapManager::CatDvipdfmxFontMaps(const set<string>& fileNames)
+/**
+ * @brief Run independent tasks, at most one per processor.
+ * 
+ * The tasks must not use the user interface. The first exception thrown
+ * by a task is thrown again when all tasks have finished.
+ * 
+ * @param tasks The tasks to be run.
+ */
+void FontMapManager::RunInParallel(const vector<function<void()>>& tasks)
 {
-    set<DvipdfmxFontMapEntry> result;
-    for (const string& fn : fileNames)
+    atomic<size_t> nextTask(0);
+    vector<exception_ptr> errors(tasks.size());
+    auto worker = [&]()
     {
-        ReadDvipdfmxFontMapFile(fn, result, false);
+        for (size_t idx = nextTask++; idx < tasks.size(); idx = nextTask++)
+        {
+            try
+            {
+                tasks[idx]();
+            }
+            catch (...)
+            {
+                errors[idx] = current_exception();
+            }
+        }
+    };
+    size_t numWorkers = std::min(static_cast<size_t>(std::max(thread::hardware_concurrency(), 1u)), tasks.size());
+    vector<thread> workers;
+    for (size_t idx = 1; idx < numWorkers; ++idx)
+    {
+        workers.push_back(thread(worker));
+    }
+    worker();
+    for (thread& t : workers)
+    {
+        t.join();
+    }
+    for (const exception_ptr& error : errors)
+    {
+        if (error != nullptr)
+        {
+            rethrow_exception(error);
+        }
     }
-    return result;
 }
 
 void FontMapManager::TransformFontFileName(const map<string, string>& transMap, DvipsFontMapEntry& fontMapEntry)
@@ -967,10 +1010,7 @@ void FontMapManager::CopyFile(const PathName& pathSrc, const PathName& pathDest)
     Verbose(fmt::format(T_("Copying {0}"), Q_(pathSrc)));
     Verbose(fmt::format(T_("     to {0}..."), Q_(pathDest)));
     File::Copy(pathSrc, pathDest);
-    if (!Fndb::FileExists(pathDest))
-    {
-        Fndb::Add({ {pathDest} });
-    }
+    RegisterFontMapFile(pathDest);
 }
 
 void FontMapManager::SymlinkOrCopyFiles()
@@ -1003,7 +1043,13 @@ void FontMapManager::BuildFontconfigCache(bool force)
 #if !defined(USE_SYSTEM_FONTCONFIG)
     this->ctx->session->ConfigureFile(PathName(MIKTEX_PATH_FONTCONFIG_CONFIG_FILE));
 #endif
-    CreateFontconfigLocalfontsConf();
+    bool configChanged = CreateFontconfigLocalfontsConf();
+#if !defined(USE_SYSTEM_FONTCONFIG)
+    if (!force && !configChanged && this->haveChangedFontDirectories && UpdateFontconfigCache())
+    {
+        return;
+    }
+#endif
     PathName fcCacheExe;
 #if !defined(USE_SYSTEM_FONTCONFIG)
     if (!this->ctx->session->FindFile(MIKTEX_FC_CACHE_EXE, FileType::EXE, fcCacheExe))
@@ -1041,10 +1087,124 @@ void FontMapManager::BuildFontconfigCache(bool force)
     Process::Run(fcCacheExe, arguments, this);
 }
 
-void FontMapManager::CreateFontconfigLocalfontsConf()
+#if !defined(USE_SYSTEM_FONTCONFIG)
+/**
+ * @brief Refreshes the fontconfig caches of the changed font directories.
+ *
+ * The caches of the ancestors of the changed directories are refreshed first
+ * (they list the sub-directories), then the caches of the changed
+ * directories, in parallel.
+ *
+ * @return Returns `false`, if the caches must be built from scratch.
+ */
+bool FontMapManager::UpdateFontconfigCache()
+{
+    if (this->changedFontDirectories.empty())
+    {
+        Verbose(T_("Fontconfig cache is up to date."));
+        return true;
+    }
+    set<PathName> changed(this->changedFontDirectories.begin(), this->changedFontDirectories.end());
+    set<PathName> ancestors;
+    for (const PathName& dir : changed)
+    {
+        PathName parent = dir.GetDirectoryName();
+        while (!parent.Empty() && ancestors.insert(parent).second)
+        {
+            PathName next = parent.GetDirectoryName();
+            if (next == parent)
+            {
+                break;
+            }
+            parent = next;
+        }
+    }
+    FcConfig* fcConfig = FcInitLoadConfig();
+    if (fcConfig == nullptr)
+    {
+        return false;
+    }
+    MIKTEX_AUTO(FcConfigDestroy(fcConfig));
+    // directory names are taken from fontconfig, so that they are spelled
+    // as in the cache files
+    vector<string> toBeScanned;
+    function<bool(const string&)> walk = [&](const string& dir)
+    {
+        PathName path(dir);
+        if (ancestors.find(path) == ancestors.end())
+        {
+            if (changed.find(path) != changed.end())
+            {
+                toBeScanned.push_back(dir);
+            }
+            return true;
+        }
+        const FcChar8* fcDir = reinterpret_cast<const FcChar8*>(dir.c_str());
+        FcCache* oldCache = FcDirCacheLoad(fcDir, fcConfig, nullptr);
+        if (oldCache == nullptr)
+        {
+            return false;
+        }
+        for (int idx = 0; idx < FcCacheNumSubdir(oldCache); ++idx)
+        {
+            const FcChar8* subdir = FcCacheSubdir(oldCache, idx);
+            if (!Directory::Exists(PathName(reinterpret_cast<const char*>(subdir))))
+            {
+                FcDirCacheUnlink(subdir, fcConfig);
+            }
+        }
+        FcDirCacheUnload(oldCache);
+        Verbose(fmt::format(T_("Refreshing fontconfig cache of {0}..."), Q_(dir)));
+        FcCache* cache = FcDirCacheRead(fcDir, FcTrue, fcConfig);
+        if (cache == nullptr)
+        {
+            return false;
+        }
+        vector<string> subdirs;
+        for (int idx = 0; idx < FcCacheNumSubdir(cache); ++idx)
+        {
+            subdirs.push_back(reinterpret_cast<const char*>(FcCacheSubdir(cache, idx)));
+        }
+        FcDirCacheUnload(cache);
+        return all_of(subdirs.begin(), subdirs.end(), walk);
+    };
+    FcStrList* fontDirs = FcConfigGetFontDirs(fcConfig);
+    MIKTEX_AUTO(FcStrListDone(fontDirs));
+    for (const FcChar8* dir; (dir = FcStrListNext(fontDirs)) != nullptr; )
+    {
+        if (!walk(reinterpret_cast<const char*>(dir)))
+        {
+            return false;
+        }
+    }
+    vector<function<void()>> tasks;
+    for (const string& dir : toBeScanned)
+    {
+        tasks.push_back([this, fcConfig, dir]()
+        {
+            FcCache* cache = FcDirCacheRead(reinterpret_cast<const FcChar8*>(dir.c_str()), FcTrue, fcConfig);
+            if (cache == nullptr)
+            {
+                MIKTEX_FATAL_ERROR_2(T_("The fontconfig cache could not be refreshed."), "directory", dir);
+            }
+            FcDirCacheUnload(cache);
+        });
+        Verbose(fmt::format(T_("Refreshing fontconfig cache of {0}..."), Q_(dir)));
+    }
+    RunInParallel(tasks);
+    return true;
+}
+#endif
+
+bool FontMapManager::CreateFontconfigLocalfontsConf()
 {
     PathName configFile(this->ctx->session->GetSpecialPath(SpecialPath::ConfigRoot));
     configFile /= MIKTEX_PATH_FONTCONFIG_LOCALFONTS_FILE;
+    vector<unsigned char> oldContents;
+    if (File::Exists(configFile))
+    {
+        oldContents = File::ReadAllBytes(configFile);
+    }
     StreamWriter writer(configFile);
     writer.WriteLine("<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
     writer.WriteLine();
@@ -1085,6 +1245,7 @@ void FontMapManager::CreateFontconfigLocalfontsConf()
     }
     writer.WriteLine("</fontconfig>");
     writer.Close();
+    bool changed = oldContents != File::ReadAllBytes(configFile);
 #if defined(USE_SYSTEM_FONTCONFIG)
     if (this->ctx->session->IsAdminMode())
     {
@@ -1109,6 +1270,7 @@ void FontMapManager::CreateFontconfigLocalfontsConf()
         writer.Close();
     }
 #endif
+    return changed;
 }
 
 bool HasPaintType(const DvipsFontMapEntry& fontMapEntry)
@@ -1148,39 +1310,163 @@ void FontMapManager::WriteMapFiles(bool force, const string& outputDirectory)
 {
     this->outputDirectory = outputDirectory;
 
-    set<DvipsFontMapEntry> dvips35;
-    ReadDvipsFontMapFile("dvips35.map", dvips35, true);
+    // locating a font map file might install a package: this is done
+    // before the font map files are read in parallel
+    PathName dvips35Path;
+    LocateFontMapFile("dvips35.map", dvips35Path, true);
+    PathName pdftex35Path;
+    LocateFontMapFile("pdftex35.map", pdftex35Path, true);
+    PathName ps2pk35Path;
+    LocateFontMapFile("ps2pk35.map", ps2pk35Path, true);
+    vector<PathName> mixedMapPaths = LocateFontMapFiles(this->config.mixedMapFiles);
+    vector<PathName> mapPaths = LocateFontMapFiles(this->config.mapFiles);
+    vector<PathName> kanjiMapPaths = LocateFontMapFiles(this->config.kanjiMapFiles);
+
+    PathName dvipsDir = FontMapDirectory("dvips");
+    PathName pdftexDir = FontMapDirectory("pdftex");
+    PathName dvipdfmxDir = FontMapDirectory("dvipdfmx");
+
+    vector<PathName> outputFiles = {
+        dvipdfmxDir / PathName("kanjix.map"),
+        dvipsDir / PathName("builtin35.map"),
+        dvipsDir / PathName("download35.map"),
+        dvipsDir / PathName("ps2pk.map"),
+        dvipsDir / PathName("psfonts_pk.map"),
+        dvipsDir / PathName("psfonts_t1.map"),
+        pdftexDir / PathName("pdftex_dl14.map"),
+        pdftexDir / PathName("pdftex_ndl14.map"),
+    };
+
+    vector<PathName> inputFiles = { dvips35Path, pdftex35Path, ps2pk35Path };
+    inputFiles.insert(inputFiles.end(), mixedMapPaths.begin(), mixedMapPaths.end());
+    inputFiles.insert(inputFiles.end(), mapPaths.begin(), mapPaths.end());
+    inputFiles.insert(inputFiles.end(), kanjiMapPaths.begin(), kanjiMapPaths.end());
+
+    // the font map files need not be generated again if neither the
+    // options nor the input files have changed
+    string digest = GetInputDigest(inputFiles).ToString();
+    PathName digestFile = dvipsDir / PathName("fontmaps.md5");
+    bool upToDate = false;
+    if (!force
+        && File::Exists(digestFile)
+        && all_of(outputFiles.begin(), outputFiles.end(), [](const PathName& path) { return File::Exists(path); }))
+    {
+        StreamReader reader(digestFile);
+        string line;
+        upToDate = reader.ReadLine(line) && line == digest;
+        reader.Close();
+    }
+
+    if (upToDate)
+    {
+        Verbose(T_("Font map files are up to date."));
+    }
+    else
+    {
+        // each font map file is parsed into a set of its own; the sets
+        // are merged in the original order, so that the first entry for
+        // a TeX font name wins, as before
+        vector<set<DvipsFontMapEntry>> dvipsParts(inputFiles.size() - kanjiMapPaths.size());
+        vector<set<DvipdfmxFontMapEntry>> kanjiParts(kanjiMapPaths.size());
+        vector<FileContext> mapContexts(inputFiles.size());
+        vector<string> mapErrors(inputFiles.size());
+        vector<function<void()>> tasks;
+        for (size_t idx = 0; idx < inputFiles.size(); ++idx)
+        {
+            bool isKanji = idx >= dvipsParts.size();
+            if (isKanji)
+            {
+                Verbose(2, fmt::format(T_("Parsing Dvipdfmx font map file {0}..."), Q_(inputFiles[idx])));
+            }
+            else
+            {
+                Verbose(2, fmt::format(T_("Parsing Dvips font map file {0}..."), Q_(inputFiles[idx])));
+            }
+            tasks.push_back([this, idx, isKanji, &inputFiles, &dvipsParts, &kanjiParts, &mapContexts, &mapErrors]()
+            {
+                try
+                {
+                    if (isKanji)
+                    {
+                        ParseDvipdfmxFontMapFile(inputFiles[idx], kanjiParts[idx - dvipsParts.size()], mapContexts[idx]);
+                    }
+                    else
+                    {
+                        ParseDvipsFontMapFile(inputFiles[idx], dvipsParts[idx], mapContexts[idx]);
+                    }
+                }
+                catch (const MiKTeXException& e)
+                {
+                    mapErrors[idx] = e.GetErrorMessage();
+                }
+            });
+        }
+        RunInParallel(tasks);
+        for (size_t idx = 0; idx < inputFiles.size(); ++idx)
+        {
+            if (!mapErrors[idx].empty())
+            {
+                MapError(mapContexts[idx], mapErrors[idx]);
+            }
+        }
+
+        const set<DvipsFontMapEntry>& dvips35 = dvipsParts[0];
+        const set<DvipsFontMapEntry>& pdftex35 = dvipsParts[1];
+        const set<DvipsFontMapEntry>& ps2pk35 = dvipsParts[2];
 
-    set<DvipsFontMapEntry> pdftex35;
-    ReadDvipsFontMapFile("pdftex35.map", pdftex35, true);
+        set<DvipsFontMapEntry> mixedMaps;
+        for (size_t idx = 0; idx < mixedMapPaths.size(); ++idx)
+        {
+            mixedMaps.insert(dvipsParts[3 + idx].begin(), dvipsParts[3 + idx].end());
+        }
+        set<DvipsFontMapEntry> nonMixedMaps;
+        for (size_t idx = 0; idx < mapPaths.size(); ++idx)
+        {
+            nonMixedMaps.insert(dvipsParts[3 + mixedMapPaths.size() + idx].begin(), dvipsParts[3 + mixedMapPaths.size() + idx].end());
+        }
+        set<DvipdfmxFontMapEntry> kanjiMaps;
+        for (const set<DvipdfmxFontMapEntry>& part : kanjiParts)
+        {
+            kanjiMaps.insert(part.begin(), part.end());
+        }
 
-    set<DvipsFontMapEntry> ps2pk35;
-    ReadDvipsFontMapFile("ps2pk35.map", ps2pk35, true);
+        set<DvipsFontMapEntry> transLW35_dvips35(TransformLW35(dvips35));
+        set<DvipsFontMapEntry> transLW35_pdftex35(TransformLW35(pdftex35));
+        set<DvipsFontMapEntry> transLW35_ps2pk35(TransformLW35(ps2pk35));
 
-    set<DvipsFontMapEntry> transLW35_dvips35(TransformLW35(dvips35));
-    set<DvipsFontMapEntry> transLW35_pdftex35(TransformLW35(pdftex35));
-    set<DvipsFontMapEntry> transLW35_ps2pk35(TransformLW35(ps2pk35));
+        set<DvipsFontMapEntry> transLW35_dftdvips(TransformLW35(this->ToBool(this->Option("dvipsDownloadBase35")) ? ps2pk35 : dvips35));
 
-    set<DvipsFontMapEntry> mixedMaps(CatDvipsFontMaps(this->config.mixedMapFiles));
-    set<DvipsFontMapEntry> nonMixedMaps(CatDvipsFontMaps(this->config.mapFiles));
-    set<DvipdfmxFontMapEntry> kanjiMaps(CatDvipdfmxFontMaps(this->config.kanjiMapFiles));
+        set<DvipsFontMapEntry> fromKanji(DvipdfmxToDvips(kanjiMaps));
 
-    set<DvipsFontMapEntry> transLW35_dftdvips(TransformLW35(this->ToBool(this->Option("dvipsDownloadBase35")) ? ps2pk35 : dvips35));
+        set<DvipsFontMapEntry> empty;
 
-    set<DvipsFontMapEntry> fromKanji(DvipdfmxToDvips(kanjiMaps));
+        for (const PathName& path : outputFiles)
+        {
+            Verbose(fmt::format(T_("Writing {0}..."), Q_(path)));
+        }
 
-    set<DvipsFontMapEntry> empty;
+        RunInParallel({
+            [&]() { WriteDvipdfmxFontMapFile(outputFiles[0], kanjiMaps); },
+            [&]() { WriteDvipsFontMapFile(outputFiles[1], transLW35_dvips35, empty, empty, empty); },
+            [&]() { WriteDvipsFontMapFile(outputFiles[2], transLW35_ps2pk35, empty, empty, empty); },
+            [&]() { WriteDvipsFontMapFile(outputFiles[3], transLW35_ps2pk35, mixedMaps, nonMixedMaps, empty); },
+            [&]() { WriteDvipsFontMapFile(outputFiles[4], transLW35_dftdvips, empty, nonMixedMaps, fromKanji); },
+            [&]() { WriteDvipsFontMapFile(outputFiles[5], transLW35_dftdvips, mixedMaps, nonMixedMaps, fromKanji); },
+            [&]() { WriteDvipsFontMapFile(outputFiles[6], GeneratePdfTeXFontMap(transLW35_ps2pk35, mixedMaps, nonMixedMaps), empty, empty, empty); },
+            [&]() { WriteDvipsFontMapFile(outputFiles[7], GeneratePdfTeXFontMap(transLW35_pdftex35, mixedMaps, nonMixedMaps), empty, empty, empty); },
+        });
+
+        for (const PathName& path : outputFiles)
+        {
+            RegisterFontMapFile(path);
+        }
 
-    WriteDvipdfmxFontMapFile(FontMapDirectory("dvipdfmx") / PathName("kanjix.map"), kanjiMaps);
-    WriteDvipsFontMapFile(FontMapDirectory("dvips") / PathName("builtin35.map"), transLW35_dvips35, empty, empty, empty);
-    WriteDvipsFontMapFile(FontMapDirectory("dvips") / PathName("download35.map"), transLW35_ps2pk35, empty, empty, empty);
-    WriteDvipsFontMapFile(FontMapDirectory("dvips") / PathName("ps2pk.map"), transLW35_ps2pk35, mixedMaps, nonMixedMaps, empty);
-    WriteDvipsFontMapFile(FontMapDirectory("dvips") / PathName("psfonts_pk.map"), transLW35_dftdvips, empty, nonMixedMaps, fromKanji);
-    WriteDvipsFontMapFile(FontMapDirectory("dvips") / PathName("psfonts_t1.map"), transLW35_dftdvips, mixedMaps, nonMixedMaps, fromKanji);
-    WriteDvipsFontMapFile(FontMapDirectory("pdftex") / PathName("pdftex_dl14.map"), GeneratePdfTeXFontMap(transLW35_ps2pk35, mixedMaps, nonMixedMaps), empty, empty, empty);
-    WriteDvipsFontMapFile(FontMapDirectory("pdftex") / PathName("pdftex_ndl14.map"), GeneratePdfTeXFontMap(transLW35_pdftex35, mixedMaps, nonMixedMaps), empty, empty, empty);
+        SymlinkOrCopyFiles();
 
-    SymlinkOrCopyFiles();
+        StreamWriter writer(digestFile);
+        writer.WriteLine(digest);
+        writer.Close();
+    }
 
     BuildFontconfigCache(force);
 }
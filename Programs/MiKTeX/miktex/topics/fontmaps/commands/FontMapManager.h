@@ -20,10 +20,13 @@
  * @endcode
  */
 
+#include <functional>
 #include <iostream>
 #include <map>
 #include <set>
+#include <vector>
 
+#include <miktex/Core/MD5>
 #include <miktex/Core/Utils>
 
 #include <miktex/Util/PathName>
@@ -75,6 +78,7 @@ public:
     void Init(OneMiKTeXUtility::ApplicationContext& ctx);
     std::string Option(const std::string& optionName);
     void SetOption(const std::string& optionName, const std::string& value);
+    void SetChangedFontDirectories(const std::vector<MiKTeX::Util::PathName>& directories);
     void WriteMapFiles(bool force, const std::string& outputDirectory);
 
 private:
@@ -91,9 +95,11 @@ private:
 
     bool LocateFontMapFile(const std::string& fileName, MiKTeX::Util::PathName& path, bool mustExist);
 
-    void ReadDvipsFontMapFile(const std::string& fileName, std::set<MiKTeX::Core::DvipsFontMapEntry>& fontMapEntries, bool mustExist);
+    std::vector<MiKTeX::Util::PathName> LocateFontMapFiles(const std::set<std::string>& fileNames);
 
-    void ReadDvipdfmxFontMapFile(const std::string& fileName, std::set<DvipdfmxFontMapEntry>& fontMapEntries, bool mustExist);
+    MiKTeX::Core::MD5 GetInputDigest(const std::vector<MiKTeX::Util::PathName>& mapFiles);
+
+    void RunInParallel(const std::vector<std::function<void()>>& tasks);
 
     void WriteHeader(std::ostream& writer, const MiKTeX::Util::PathName& fileName);
 
@@ -107,10 +113,6 @@ private:
 
     void WriteDvipdfmxFontMapFile(const MiKTeX::Util::PathName& path, const std::set<DvipdfmxFontMapEntry>& fontMapEntries);
 
-    std::set<MiKTeX::Core::DvipsFontMapEntry> CatDvipsFontMaps(const std::set<std::string>& fileNames);
-
-    std::set<DvipdfmxFontMapEntry> CatDvipdfmxFontMaps(const std::set<std::string>& fileNames);
-
     std::set<MiKTeX::Core::DvipsFontMapEntry> TransformLW35(const std::set<MiKTeX::Core::DvipsFontMapEntry>& fontMapEntries);
 
     std::set<MiKTeX::Core::DvipsFontMapEntry> DvipdfmxToDvips(const std::set<DvipdfmxFontMapEntry>& dvipdfmxFontMapEntries);
@@ -119,13 +121,19 @@ private:
 
     void TransformPSName(const  std::map< std::string,  std::string>& files, MiKTeX::Core::DvipsFontMapEntry& fontMapEntry);
 
+    void RegisterFontMapFile(const MiKTeX::Util::PathName& path);
+
     void CopyFile(const MiKTeX::Util::PathName& pathSrc, const MiKTeX::Util::PathName& pathDest);
 
     void SymlinkOrCopyFiles();
 
     void BuildFontconfigCache(bool force);
 
-    void CreateFontconfigLocalfontsConf();
+#if !defined(USE_SYSTEM_FONTCONFIG)
+    bool UpdateFontconfigCache();
+#endif
+
+    bool CreateFontconfigLocalfontsConf();
 
     void Verbose(int level, const std::string& s)
     {
@@ -139,11 +147,11 @@ private:
 
     MIKTEXNORETURN void CfgError(const  std::string& s);
 
-    MIKTEXNORETURN void MapError(const  std::string& s);
+    MIKTEXNORETURN void MapError(const FileContext& mapContext, const  std::string& s);
 
-    void ParseDvipsFontMapFile(const MiKTeX::Util::PathName& mapFile,  std::set<MiKTeX::Core::DvipsFontMapEntry>& fontMapEntries);
+    void ParseDvipsFontMapFile(const MiKTeX::Util::PathName& mapFile,  std::set<MiKTeX::Core::DvipsFontMapEntry>& fontMapEntries, FileContext& mapContext);
 
-    void ParseDvipdfmxFontMapFile(const MiKTeX::Util::PathName& mapFile,  std::set<DvipdfmxFontMapEntry>& fontMapEntries);
+    void ParseDvipdfmxFontMapFile(const MiKTeX::Util::PathName& mapFile,  std::set<DvipdfmxFontMapEntry>& fontMapEntries, FileContext& mapContext);
 
     bool ParseDvipdfmxFontMapLine(const std::string& line,  DvipdfmxFontMapEntry& fontMapEntry);
 
@@ -189,9 +197,16 @@ private:
 
     std::string outputDirectory;
 
-    FileContext cfgContext;
+    /**
+     * @brief Font directories in which files have been installed/removed.
+     *
+     * Only valid if `haveChangedFontDirectories` is `true`.
+     */
+    std::vector<MiKTeX::Util::PathName> changedFontDirectories;
 
-    FileContext mapContext;
+    bool haveChangedFontDirectories = false;
+
+    FileContext cfgContext;
 
     bool OnProcessOutput(const void* output, size_t n) override;
 
@@ -20,6 +20,10 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <miktex/Core/StreamReader>
+
+#include <miktex/Util/PathName>
+
 #include <miktex/Wrappers/PoptWrapper>
 
 #include "internal.h"
@@ -47,13 +51,15 @@ namespace
 
         std::string Synopsis() override
         {
-            return "configure [--force] [--output-directory <directory>]";
+            return "configure [--changed-font-directories <file>] [--force] [--output-directory <directory>]";
         }
     };
 }
 
 using namespace std;
 
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
 using namespace MiKTeX::Wrappers;
 
 using namespace OneMiKTeXUtility;
@@ -68,12 +74,20 @@ unique_ptr<Command> Commands::Configure()
 enum Option
 {
     OPT_AAA = 1,
+    OPT_CHANGED_FONT_DIRECTORIES,
     OPT_FORCE,
     OPT_OUTPUT_DIRECTORY,
 };
 
 static const struct poptOption options[] =
 {
+    {
+        "changed-font-directories", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_CHANGED_FONT_DIRECTORIES,
+        T_("Only refresh the fontconfig caches of the font directories listed in FILE (one per line)."),
+        "FILE"
+    },
     {
         "force", 0,
         POPT_ARG_NONE, nullptr,
@@ -99,10 +113,14 @@ int ConfigureCommand::Execute(ApplicationContext& ctx, const vector<string>& arg
     int option;
     bool force = false;
     string outputDirectory;
+    string changedFontDirectoriesFile;
     while ((option = popt.GetNextOpt()) >= 0)
     {
         switch (option)
         {
+        case OPT_CHANGED_FONT_DIRECTORIES:
+            changedFontDirectoriesFile = popt.GetOptArg();
+            break;
         case OPT_FORCE:
             force = true;
             break;
@@ -121,6 +139,21 @@ int ConfigureCommand::Execute(ApplicationContext& ctx, const vector<string>& arg
     }
     FontMapManager mgr;
     mgr.Init(ctx);
+    if (!changedFontDirectoriesFile.empty())
+    {
+        vector<PathName> changedFontDirectories;
+        StreamReader reader{ PathName(changedFontDirectoriesFile) };
+        string line;
+        while (reader.ReadLine(line))
+        {
+            if (!line.empty())
+            {
+                changedFontDirectories.push_back(PathName(line));
+            }
+        }
+        reader.Close();
+        mgr.SetChangedFontDirectories(changedFontDirectories);
+    }
     mgr.WriteMapFiles(force, outputDirectory);
     return 0;
 }
@@ -13,7 +13,13 @@
 
 #include <config.h>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <fmt/format.h>
@@ -43,14 +49,126 @@ void FormatsManager::Init(ApplicationContext& ctx)
 
 void FormatsManager::Build(const string& formatKey)
 {
-    if (find(this->formatsMade.begin(), this->formatsMade.end(), formatKey) != this->formatsMade.end())
+    this->Build(vector<string>{ formatKey }, 1);
+}
+
+void FormatsManager::Build(const vector<string>& formatKeys, unsigned maxJobs)
+{
+    // resolve all formats (including the preloaded ones) up front; jobs
+    // come after the jobs building their preloaded formats
+    vector<BuildJob> jobs;
+    this->formatsRequested = formatKeys;
+    for (const string& formatKey : formatKeys)
+    {
+        vector<string> visiting;
+        this->AddBuildJob(formatKey, jobs, visiting);
+    }
+
+    if (jobs.empty())
     {
         return;
     }
 
-    auto formatInfo = this->Format(formatKey);
+    enum class JobState { Pending, Running, Done };
+    vector<JobState> jobStates(jobs.size(), JobState::Pending);
+    mutex mtx;
+    condition_variable jobFinished;
+    exception_ptr error;
+
+    auto worker = [&]()
+    {
+        unique_lock<mutex> lock(mtx);
+        while (error == nullptr && !this->ctx->program->Canceled())
+        {
+            bool havePendingJobs = false;
+            size_t next = jobs.size();
+            for (size_t idx = 0; idx < jobs.size() && next == jobs.size(); ++idx)
+            {
+                if (jobStates[idx] != JobState::Pending)
+                {
+                    continue;
+                }
+                havePendingJobs = true;
+                if (jobs[idx].preloaded.empty() || this->IsMade(jobs[idx].preloaded))
+                {
+                    next = idx;
+                }
+            }
+            if (!havePendingJobs)
+            {
+                break;
+            }
+            if (next == jobs.size())
+            {
+                // wait for a preloaded format
+                jobFinished.wait(lock);
+                continue;
+            }
+            const BuildJob& job = jobs[next];
+            jobStates[next] = JobState::Running;
+            this->ctx->ui->Verbose(0, fmt::format(T_("Building format '{0}' with engine '{1}'..."), job.key, job.engine));
+            lock.unlock();
+            try
+            {
+                auto start = chrono::steady_clock::now();
+                this->ctx->processRunner->RunProcess(job.exe, job.arguments);
+                auto duration = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+                lock.lock();
+                this->formatsMade.push_back(job.key);
+                this->ctx->ui->Verbose(0, fmt::format(T_("Format '{0}' done ({1:.1f}s)."), job.key, duration.count() / 1000.0));
+            }
+            catch (...)
+            {
+                lock.lock();
+                if (error == nullptr)
+                {
+                    error = current_exception();
+                }
+            }
+            jobStates[next] = JobState::Done;
+            jobFinished.notify_all();
+        }
+        jobFinished.notify_all();
+    };
 
-    this->ctx->ui->Verbose(0, fmt::format(T_("Building format '{0}' with engine '{1}'..."), formatInfo.key, formatInfo.compiler));
+    size_t numWorkers = std::min(static_cast<size_t>(std::max(maxJobs, 1u)), jobs.size());
+    if (numWorkers == 1)
+    {
+        worker();
+    }
+    else
+    {
+        vector<thread> workers;
+        for (size_t idx = 0; idx < numWorkers; ++idx)
+        {
+            workers.push_back(thread(worker));
+        }
+        for (thread& t : workers)
+        {
+            t.join();
+        }
+    }
+
+    if (error != nullptr)
+    {
+        rethrow_exception(error);
+    }
+}
+
+void FormatsManager::AddBuildJob(const string& formatKey, vector<BuildJob>& jobs, vector<string>& visiting)
+{
+    if (this->IsMade(formatKey)
+        || find_if(jobs.begin(), jobs.end(), [&formatKey](const BuildJob& job) { return job.key == formatKey; }) != jobs.end())
+    {
+        return;
+    }
+
+    if (find_if(visiting.begin(), visiting.end(), [&formatKey](const string& key) { return PathName::Compare(key, formatKey) == 0; }) != visiting.end())
+    {
+        this->ctx->ui->FatalError(fmt::format(T_("{0}: rule recursion"), formatKey));
+    }
+
+    auto formatInfo = this->Format(formatKey);
 
     string maker;
 
@@ -70,15 +188,20 @@ void FormatsManager::Build(const string& formatKey)
 
     if (!formatInfo.preloaded.empty())
     {
-        if (PathName::Compare(formatInfo.preloaded, formatKey) == 0)
-        {
-            this->ctx->ui->FatalError(fmt::format(T_("{0}: rule recursion"), formatKey));
-        }
+        visiting.push_back(formatKey);
         // RECURSION
-        this->Build(formatInfo.preloaded);
+        this->AddBuildJob(formatInfo.preloaded, jobs, visiting);
+        visiting.pop_back();
         arguments.push_back("--preload="s + formatInfo.preloaded);
     }
 
+    // a format which is only built because it is preloaded by a
+    // requested format is kept if its input files are unchanged
+    if (find(this->formatsRequested.begin(), this->formatsRequested.end(), formatKey) == this->formatsRequested.end())
+    {
+        arguments.push_back("--keep-if-unchanged");
+    }
+
     if (PathName(formatInfo.inputFile).HasExtension(".ini"))
     {
         arguments.push_back("--no-dump");
@@ -91,16 +214,24 @@ void FormatsManager::Build(const string& formatKey)
         arguments.push_back("--engine-option="s + a);
     }
 
-    this->RunMakeTeX(maker, arguments);
+    BuildJob job = this->MakeTeXJob(formatKey, maker, arguments);
+    job.engine = formatInfo.compiler;
+    job.preloaded = formatInfo.preloaded;
+    jobs.push_back(job);
+}
 
-    this->formatsMade.push_back(formatKey);
+bool FormatsManager::IsMade(const string& formatKey) const
+{
+    return find(this->formatsMade.begin(), this->formatsMade.end(), formatKey) != this->formatsMade.end();
 }
 
-void FormatsManager::RunMakeTeX(const string& makeProg, const vector<string>& arguments)
+FormatsManager::BuildJob FormatsManager::MakeTeXJob(const string& formatKey, const string& makeProg, const vector<string>& arguments)
 {
-    PathName exe;
+    BuildJob job;
 
-    if (!this->ctx->session->FindFile(makeProg, FileType::EXE, exe))
+    job.key = formatKey;
+
+    if (!this->ctx->session->FindFile(makeProg, FileType::EXE, job.exe))
     {
         this->ctx->ui->FatalError(fmt::format(T_("{0}: not found"), Q_(makeProg)));
     }
@@ -136,7 +267,9 @@ void FormatsManager::RunMakeTeX(const string& makeProg, const vector<string>& ar
     xArguments.push_back("--miktex-disable-maintenance");
     xArguments.push_back("--miktex-disable-diagnose");
 
-    this->ctx->processRunner->RunProcess(exe, xArguments);
+    job.arguments = xArguments;
+
+    return job;
 }
 
 vector<FormatInfo> FormatsManager::Formats()
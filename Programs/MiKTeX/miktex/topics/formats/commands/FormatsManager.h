@@ -15,6 +15,7 @@
 #include <vector>
 
 #include <miktex/Core/Session>
+#include <miktex/Util/PathName>
 
 #include "internal.h"
 
@@ -25,12 +26,25 @@ public:
     MiKTeX::Core::FormatInfo Format(const std::string& formatKey);
     std::vector<MiKTeX::Core::FormatInfo> Formats();
     void Build(const std::string& formatKey);
+    void Build(const std::vector<std::string>& formatKeys, unsigned maxJobs);
     void Init(OneMiKTeXUtility::ApplicationContext& ctx);
 
 private:
 
-    void RunMakeTeX(const std::string& makeProg, const std::vector<std::string>& arguments);
+    struct BuildJob
+    {
+        std::string key;
+        std::string engine;
+        std::string preloaded;
+        MiKTeX::Util::PathName exe;
+        std::vector<std::string> arguments;
+    };
+
+    void AddBuildJob(const std::string& formatKey, std::vector<BuildJob>& jobs, std::vector<std::string>& visiting);
+    BuildJob MakeTeXJob(const std::string& formatKey, const std::string& makeProg, const std::vector<std::string>& arguments);
+    bool IsMade(const std::string& formatKey) const;
 
     OneMiKTeXUtility::ApplicationContext* ctx;
     std::vector<std::string> formatsMade;
+    std::vector<std::string> formatsRequested;
 };
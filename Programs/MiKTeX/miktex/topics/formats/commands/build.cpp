@@ -47,7 +47,7 @@ namespace
 
         std::string Synopsis() override
         {
-            return "build [--engine <engine>] [<key>]";
+            return "build [--engine <engine>] [--jobs <n>] [<key>]";
         }
     };
 }
@@ -69,6 +69,7 @@ enum Option
 {
     OPT_AAA = 1,
     OPT_ENGINE,
+    OPT_JOBS,
 };
 
 static const struct poptOption options[] =
@@ -80,6 +81,13 @@ static const struct poptOption options[] =
         T_("Engine to be used."),
         T_("ENGINE")
     },
+    {
+        "jobs", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_JOBS,
+        T_("Build up to N formats at the same time."),
+        T_("N")
+    },
     POPT_AUTOHELP
     POPT_TABLEEND
 };
@@ -90,6 +98,7 @@ int BuildCommand::Execute(ApplicationContext& ctx, const vector<string>& argumen
     PoptWrapper popt(static_cast<int>(argv.size() - 1), &argv[0], options);
     int option;
     string engine;
+    unsigned maxJobs = 1;
     while ((option = popt.GetNextOpt()) >= 0)
     {
         switch (option)
@@ -97,6 +106,16 @@ int BuildCommand::Execute(ApplicationContext& ctx, const vector<string>& argumen
         case OPT_ENGINE:
             engine = popt.GetOptArg();
             break;
+        case OPT_JOBS:
+        {
+            string jobs = popt.GetOptArg();
+            if (jobs.empty() || jobs.find_first_not_of("0123456789") != string::npos || std::stoul(jobs) == 0)
+            {
+                ctx.ui->IncorrectUsage(fmt::format(T_("{0}: invalid number of jobs"), jobs));
+            }
+            maxJobs = static_cast<unsigned>(std::stoul(jobs));
+            break;
+        }
         }
     }
     if (option != -1)
@@ -112,14 +131,16 @@ int BuildCommand::Execute(ApplicationContext& ctx, const vector<string>& argumen
     mgr.Init(ctx);
     if (leftOvers.empty())
     {
+        vector<string> formatKeys;
         for (auto& f : mgr.Formats())
         {
             if (!engine.empty() && engine != f.compiler)
             {
                 continue;
             }
-            mgr.Build(f.key);
+            formatKeys.push_back(f.key);
         }
+        mgr.Build(formatKeys, maxJobs);
     }
     else
     {
@@ -132,7 +153,7 @@ int BuildCommand::Execute(ApplicationContext& ctx, const vector<string>& argumen
                 ctx.ui->FatalError(fmt::format(T_("{0}: cannot be built by {1}"), key, engine));
             }
         }
-        mgr.Build(key);
+        mgr.Build(vector<string>{ key }, maxJobs);
     }
     return 0;
 }
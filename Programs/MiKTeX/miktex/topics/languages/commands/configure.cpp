@@ -13,7 +13,10 @@
 
 #include <config.h>
 
+#include <ctime>
+
 #include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -21,6 +24,7 @@
 #include <fmt/ostream.h>
 
 #include <miktex/Configuration/ConfigurationProvider>
+#include <miktex/Core/File>
 #include <miktex/Core/Fndb>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Session>
@@ -82,6 +86,54 @@ static const struct poptOption options[] =
     POPT_TABLEEND
 };
 
+/**
+ * @brief Write a language file, unless it already has the contents.
+ *
+ * An unchanged file keeps its contents (and so its digest): format files
+ * which depend on it need not be rebuilt.  The time stamp is updated
+ * anyway, because it tells when the file was last checked.
+ *
+ * @param path The path to the language file.
+ * @param contents The contents of the language file.
+ */
+static void UpdateLanguageFile(const PathName& path, const string& contents)
+{
+    bool unchanged = false;
+    if (File::Exists(path))
+    {
+        vector<unsigned char> bytes = File::ReadAllBytes(path);
+        string oldContents;
+        for (unsigned char ch : bytes)
+        {
+            // text mode writes CR/LF line endings on Windows
+            if (ch != '\r')
+            {
+                oldContents += static_cast<char>(ch);
+            }
+        }
+        unchanged = oldContents == contents;
+    }
+    if (unchanged)
+    {
+        time_t creationTime;
+        time_t lastAccessTime;
+        time_t lastWriteTime;
+        File::GetTimes(path, creationTime, lastAccessTime, lastWriteTime);
+        time_t now = time(nullptr);
+        File::SetTimes(path, creationTime, now, now);
+    }
+    else
+    {
+        ofstream stream = File::CreateOutputStream(path);
+        stream << contents;
+        stream.close();
+    }
+    if (!Fndb::FileExists(path))
+    {
+        Fndb::Add({ {path} });
+    }
+}
+
 int ConfigureCommand::Execute(ApplicationContext& ctx, const vector<string>& arguments)
 {
     auto argv = MakeArgv(arguments);
@@ -102,13 +154,13 @@ int ConfigureCommand::Execute(ApplicationContext& ctx, const vector<string>& arg
     ctx.ui->Verbose(1, T_("Creating language.dat, language.dat.lua and language.def..."));
 
     PathName languageDatPath = ctx.session->GetSpecialPath(SpecialPath::ConfigRoot) / PathName(MIKTEX_PATH_LANGUAGE_DAT);
-    ofstream languageDat = File::CreateOutputStream(languageDatPath);
+    ostringstream languageDat;
 
     PathName languageDatLuaPath = ctx.session->GetSpecialPath(SpecialPath::ConfigRoot) / PathName(MIKTEX_PATH_LANGUAGE_DAT_LUA);
-    ofstream languageDatLua = File::CreateOutputStream(languageDatLuaPath);
+    ostringstream languageDatLua;
 
     PathName languageDefPath = ctx.session->GetSpecialPath(SpecialPath::ConfigRoot) / PathName(MIKTEX_PATH_LANGUAGE_DEF);
-    ofstream languageDef = File::CreateOutputStream(languageDefPath);
+    ostringstream languageDef;
 
     languageDatLua << "return {" << "\n";
     languageDef << "%% e-TeX V2.2" << "\n";
@@ -160,14 +212,9 @@ int ConfigureCommand::Execute(ApplicationContext& ctx, const vector<string>& arg
 
     languageDatLua << "}" << "\n";
 
-    languageDatLua.close();
-    Fndb::Add({ {languageDatLuaPath} });
-
-    languageDef.close();
-    Fndb::Add({ {languageDefPath} });
-
-    languageDat.close();
-    Fndb::Add({ {languageDatPath} });
+    UpdateLanguageFile(languageDatLuaPath, languageDatLua.str());
+    UpdateLanguageFile(languageDefPath, languageDef.str());
+    UpdateLanguageFile(languageDatPath, languageDat.str());
     
     return 0;
 }
@@ -13,7 +13,12 @@
 
 #include <config.h>
 
+#include <algorithm>
+#include <future>
+#include <map>
+#include <set>
 #include <string>
+#include <thread>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -22,6 +27,8 @@
 #include <miktex/Core/AutoResource>
 #include <miktex/Core/Cfg>
 #include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/Fndb>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Utils>
 #include <miktex/Util/PathName>
@@ -71,6 +78,41 @@ vector<FileLink> LinksManager::Links()
   return CollectLinks(linkCategories);
 }
 
+// Run f for each item; the items are distributed over a few
+// concurrent batches.  Exceptions are rethrown after all batches
+// have finished.
+template<typename T, typename F> static void ForEachInBatches(const vector<T>& items, F f)
+{
+  size_t numBatches = std::min<size_t>(items.size(), std::max(thread::hardware_concurrency(), 1u));
+  if (numBatches <= 1)
+  {
+    for (const T& item : items)
+    {
+      f(item);
+    }
+    return;
+  }
+  vector<future<void>> futures;
+  for (size_t batch = 0; batch < numBatches; ++batch)
+  {
+    futures.push_back(std::async(launch::async, [&items, &f, batch, numBatches]()
+    {
+      for (size_t idx = batch; idx < items.size(); idx += numBatches)
+      {
+        f(items[idx]);
+      }
+    }));
+  }
+  for (future<void>& fut : futures)
+  {
+    fut.wait();
+  }
+  for (future<void>& fut : futures)
+  {
+    fut.get();
+  }
+}
+
 void LinksManager::ManageLinks(LinkCategoryOptions linkCategories, bool uninstall, bool force)
 {
   PathName pathBinDir = this->ctx->session->GetSpecialPath(SpecialPath::BinDirectory);
@@ -85,9 +127,123 @@ void LinksManager::ManageLinks(LinkCategoryOptions linkCategories, bool uninstal
     Directory::Create(pathBinDir);
   }
 
-  for (const FileLink& fileLink : CollectLinks(linkCategories))
+  vector<FileLink> fileLinks = CollectLinks(linkCategories);
+
+  // list each link directory once instead of probing every link
+  set<PathName> linkDirectories;
+  for (const FileLink& fileLink : fileLinks)
+  {
+    for (const string& linkName : fileLink.linkNames)
+    {
+      linkDirectories.insert(PathName(linkName).GetDirectoryName());
+    }
+  }
+  set<PathName> existingFiles;
+  for (const PathName& dir : linkDirectories)
+  {
+    if (!Directory::Exists(dir))
+    {
+      continue;
+    }
+    for (const DirectoryEntry& entry : DirectoryLister::ReadDirectory(dir, nullptr, (int)DirectoryLister::Options::None))
+    {
+      if (!entry.isDirectory)
+      {
+        existingFiles.insert(dir / PathName(entry.name));
+      }
+    }
+  }
+
+  vector<PathName> toBeRemoved;
+  vector<LinkAction> toBeCreated;
+  for (const FileLink& fileLink : fileLinks)
   {
-    ManageLink(fileLink, supportsHardLinks, uninstall, force);
+    PlanLink(fileLink, supportsHardLinks, uninstall, force, existingFiles, toBeRemoved, toBeCreated);
+  }
+
+  if (!toBeRemoved.empty())
+  {
+    UpdateFndb(toBeRemoved, true);
+    ForEachInBatches(toBeRemoved, [](const PathName& path)
+    {
+      File::Delete(path, { FileDeleteOption::TryHard });
+    });
+  }
+
+  if (toBeCreated.empty())
+  {
+    return;
+  }
+
+  set<PathName> sourceDirectories;
+  for (const LinkAction& action : toBeCreated)
+  {
+    sourceDirectories.insert(action.linkPath.GetDirectoryName());
+  }
+  for (const PathName& dir : sourceDirectories)
+  {
+    if (!Directory::Exists(dir))
+    {
+      Directory::Create(dir);
+    }
+  }
+
+  ForEachInBatches(toBeCreated, [](const LinkAction& action)
+  {
+    switch (action.linkType)
+    {
+    case LinkType::Symbolic:
+      File::CreateLink(action.target, action.linkPath, { CreateLinkOption::Symbolic });
+      break;
+    case LinkType::Hard:
+      File::CreateLink(action.target, action.linkPath, {});
+      break;
+    case LinkType::Copy:
+      File::Copy(action.target, action.linkPath, { FileCopyOption::PreserveMode });
+      break;
+    default:
+      MIKTEX_UNEXPECTED();
+    }
+  });
+
+  vector<PathName> created;
+  created.reserve(toBeCreated.size());
+  for (const LinkAction& action : toBeCreated)
+  {
+    created.push_back(action.linkPath);
+  }
+  UpdateFndb(created, false);
+}
+
+// Batched equivalent of the UpdateFndb file operation options: paths
+// outside of the TEXMF root directories are ignored.
+void LinksManager::UpdateFndb(const vector<PathName>& paths, bool remove)
+{
+  map<unsigned, vector<PathName>> pathsByRoot;
+  for (const PathName& path : paths)
+  {
+    unsigned root = this->ctx->session->TryDeriveTEXMFRoot(path);
+    if (root != INVALID_ROOT_INDEX && Fndb::FileExists(path) == remove)
+    {
+      pathsByRoot[root].push_back(path);
+    }
+  }
+  for (const auto& [root, rootPaths] : pathsByRoot)
+  {
+    if (remove)
+    {
+      Fndb::Remove(rootPaths);
+    }
+    else
+    {
+      vector<Fndb::Record> records;
+      records.reserve(rootPaths.size());
+      for (const PathName& path : rootPaths)
+      {
+        records.push_back({ path });
+      }
+      Fndb::Add(records);
+    }
   }
 }
 
@@ -130,7 +286,7 @@ void LinksManager::MakeFilesExecutable()
 }
 #endif
 
-void LinksManager::ManageLink(const FileLink& fileLink, bool supportsHardLinks, bool isRemoveRequested, bool allowOverwrite)
+void LinksManager::PlanLink(const FileLink& fileLink, bool supportsHardLinks, bool isRemoveRequested, bool allowOverwrite, const set<PathName>& existingFiles, vector<PathName>& toBeRemoved, vector<LinkAction>& toBeCreated)
 {
     LinkType linkType = fileLink.linkType;
     if (linkType == LinkType::Hard && !supportsHardLinks)
@@ -139,20 +295,17 @@ void LinksManager::ManageLink(const FileLink& fileLink, bool supportsHardLinks,
     }
     for (const string& linkName : fileLink.linkNames)
     {
-        FileExistsOptionSet fileExistsOptions;
-#if defined(MIKTEX_UNIX)
-        fileExistsOptions += FileExistsOption::SymbolicLink;
-#endif
-        if (File::Exists(PathName(linkName), fileExistsOptions))
+        PathName linkPath(linkName);
+        if (existingFiles.find(linkPath) != existingFiles.end())
         {
-            if (!isRemoveRequested && (!allowOverwrite || (linkType == LinkType::Copy && File::Equals(PathName(fileLink.target), PathName(linkName)))))
+            if (!isRemoveRequested && (!allowOverwrite || (linkType == LinkType::Copy && File::Equals(PathName(fileLink.target), linkPath))))
             {
                 continue;
             }
 #if defined(MIKTEX_UNIX)
-            if (File::IsSymbolicLink(PathName(linkName)))
+            if (File::IsSymbolicLink(linkPath))
             {
-                PathName linkTarget = File::ReadSymbolicLink(PathName(linkName));
+                PathName linkTarget = File::ReadSymbolicLink(linkPath);
                 string linkTargetFileName = linkTarget.GetFileName().ToString();
                 bool isMiKTeXSymlinked = linkTargetFileName.find(MIKTEX_PREFIX) == 0 || PathName(linkTargetFileName) == PathName(fileLink.target).GetFileName();
                 if (!isMiKTeXSymlinked)
@@ -169,39 +322,34 @@ void LinksManager::ManageLink(const FileLink& fileLink, bool supportsHardLinks,
                 }
             }
 #endif
-            this->ctx->ui->Verbose(2, fmt::format(T_("Removing {0}..."), PathName(linkName).ToDisplayString()));
-            File::Delete(PathName(linkName), { FileDeleteOption::TryHard, FileDeleteOption::UpdateFndb });
+            this->ctx->ui->Verbose(2, fmt::format(T_("Removing {0}..."), linkPath.ToDisplayString()));
+            toBeRemoved.push_back(linkPath);
         }
         if (isRemoveRequested)
         {
             continue;
         }
-        PathName sourceDirectory(linkName);
-        sourceDirectory.RemoveFileSpec();
-        if (!Directory::Exists(sourceDirectory))
-        {
-            Directory::Create(sourceDirectory);
-        }
         switch (linkType)
         {
         case LinkType::Symbolic:
         {
+            PathName sourceDirectory = linkPath.GetDirectoryName();
             const char* target = Utils::GetRelativizedPath(fileLink.target.c_str(), sourceDirectory.GetData());
             if (target == nullptr)
             {
                 target = fileLink.target.c_str();
             }
-            this->ctx->ui->Verbose(2, fmt::format(T_("Creating symbolic link: {0} -> {1}..."), Q_(PathName(linkName).ToDisplayString()), Q_(PathName(fileLink.target).ToDisplayString())));
-            File::CreateLink(PathName(target), PathName(linkName), { CreateLinkOption::UpdateFndb, CreateLinkOption::Symbolic });
+            this->ctx->ui->Verbose(2, fmt::format(T_("Creating symbolic link: {0} -> {1}..."), Q_(linkPath.ToDisplayString()), Q_(PathName(fileLink.target).ToDisplayString())));
+            toBeCreated.push_back({ linkPath, PathName(target), linkType });
             break;
         }
         case LinkType::Hard:
-            this->ctx->ui->Verbose(2, fmt::format(T_("Creating hard link: {0} -> {1}..."), Q_(PathName(linkName).ToDisplayString()), Q_(PathName(fileLink.target).ToDisplayString())));
-            File::CreateLink(PathName(fileLink.target), PathName(linkName), { CreateLinkOption::UpdateFndb });
+            this->ctx->ui->Verbose(2, fmt::format(T_("Creating hard link: {0} -> {1}..."), Q_(linkPath.ToDisplayString()), Q_(PathName(fileLink.target).ToDisplayString())));
+            toBeCreated.push_back({ linkPath, PathName(fileLink.target), linkType });
             break;
         case LinkType::Copy:
-            this->ctx->ui->Verbose(2, fmt::format(T_("Copying: {0} -> {1}..."), Q_(PathName(linkName).ToDisplayString()), Q_(PathName(fileLink.target).ToDisplayString())));
-            File::Copy(PathName(fileLink.target), PathName(linkName), { FileCopyOption::PreserveMode, FileCopyOption::UpdateFndb });
+            this->ctx->ui->Verbose(2, fmt::format(T_("Copying: {0} -> {1}..."), Q_(linkPath.ToDisplayString()), Q_(PathName(fileLink.target).ToDisplayString())));
+            toBeCreated.push_back({ linkPath, PathName(fileLink.target), linkType });
             break;
         default:
             MIKTEX_UNEXPECTED();
@@ -12,10 +12,12 @@
  */
 
 #include <ostream>
+#include <set>
 #include <string>
 #include <vector>
 
 #include <miktex/Util/OptionSet>
+#include <miktex/Util/PathName>
 
 #include "internal.h"
 
@@ -73,6 +75,13 @@ enum class LinkCategory
 
 typedef MiKTeX::Util::OptionSet<LinkCategory> LinkCategoryOptions;
 
+struct LinkAction
+{
+  MiKTeX::Util::PathName linkPath;
+  MiKTeX::Util::PathName target;
+  LinkType linkType;
+};
+
 class LinksManager
 {
 public:
@@ -88,7 +97,9 @@ private:
 
     void ManageLinks(LinkCategoryOptions linkCategories, bool uninstall, bool force);
 
-    void ManageLink(const FileLink& fileLink, bool supportsHardLinks, bool isRemoveRequested, bool allowOverwrite);
+    void PlanLink(const FileLink& fileLink, bool supportsHardLinks, bool isRemoveRequested, bool allowOverwrite, const std::set<MiKTeX::Util::PathName>& existingFiles, std::vector<MiKTeX::Util::PathName>& toBeRemoved, std::vector<LinkAction>& toBeCreated);
+
+    void UpdateFndb(const std::vector<MiKTeX::Util::PathName>& paths, bool remove);
 
 #if defined(MIKTEX_UNIX)
     void MakeFilesExecutable();
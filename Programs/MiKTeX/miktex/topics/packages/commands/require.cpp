@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief packages require
  *
- * @copyright Copyright © 2022 Christian Schenk
+ * @copyright Copyright © 2022-2023 Christian Schenk
  *
  * This file is part of One MiKTeX Utility.
  *
@@ -13,7 +13,9 @@
 
 #include <config.h>
 
+#include <algorithm>
 #include <memory>
+#include <regex>
 #include <set>
 #include <string>
 #include <vector>
@@ -21,9 +23,12 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <miktex/Core/File>
 #include <miktex/Core/Session>
+#include <miktex/Core/StreamReader>
 #include <miktex/PackageManager/PackageManager>
 #include <miktex/Util/PathName>
+#include <miktex/Util/StringUtil>
 #include <miktex/Wrappers/PoptWrapper>
 
 #include "internal.h"
@@ -51,10 +56,12 @@ namespace
 
         std::string Synopsis() override
         {
-            return "require [--package-id-file <file>] [--repository <repository>] <package-id>...";
+            return "require [--package-id-file <file>] [--repository <repository>] [--scan-document <file>] <package-id>...";
         }
 
         void Require(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<std::string>& requiredPackages, const std::string& repository);
+
+        void ScanDocuments(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<MiKTeX::Util::PathName>& documents, std::vector<std::string>& requiredPackages);
     };
 }
 
@@ -79,6 +86,7 @@ enum Option
     OPT_AAA = 1,
     OPT_PACKAGE_ID_FILE,
     OPT_REPOSITORY,
+    OPT_SCAN_DOCUMENT,
 };
 
 static const struct poptOption options[] =
@@ -97,6 +105,13 @@ static const struct poptOption options[] =
         T_("Use the specified location as the package repository.  The location can be either a fully qualified path name (a local package repository) or an URL (a remote package repository)."),
         T_("LOCATION")
     },
+    {
+        "scan-document", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_SCAN_DOCUMENT,
+        T_("Scan the LaTeX document for the classes and packages it loads, and require the MiKTeX packages which contain them."),
+        "FILE"
+    },
     POPT_AUTOHELP
     POPT_TABLEEND
 };
@@ -108,6 +123,7 @@ int RequireCommand::Execute(ApplicationContext& ctx, const vector<string>& argum
     int option;
     string repository;
     vector<string> requiredPackages;
+    vector<PathName> documents;
     while ((option = popt.GetNextOpt()) >= 0)
     {
         switch (option)
@@ -117,6 +133,10 @@ int RequireCommand::Execute(ApplicationContext& ctx, const vector<string>& argum
             break;
         case OPT_REPOSITORY:
             repository = popt.GetOptArg();
+            break;
+        case OPT_SCAN_DOCUMENT:
+            documents.push_back(PathName(popt.GetOptArg()));
+            break;
         }
     }
     if (option != -1)
@@ -125,14 +145,147 @@ int RequireCommand::Execute(ApplicationContext& ctx, const vector<string>& argum
     }
     auto leftOvers = popt.GetLeftovers();
     requiredPackages.insert(requiredPackages.end(), leftOvers.begin(), leftOvers.end());
-    if (requiredPackages.empty())
+    if (requiredPackages.empty() && documents.empty())
     {
         ctx.ui->FatalError(T_("missing package ID"));
     }
+    if (!documents.empty())
+    {
+        ScanDocuments(ctx, documents, requiredPackages);
+    }
     Require(ctx, requiredPackages, repository);
     return 0;
 }
 
+static void ScanDocument(ApplicationContext& ctx, const PathName& path, set<string>& fileNames, set<PathName>& visited)
+{
+    static const regex loadCommand(R"(\\(documentclass|LoadClass|usepackage|RequirePackage|RequirePackageWithOptions)\s*(?:\[[^\]]*\]\s*)?\{([^}]*)\})");
+    static const regex inputCommand(R"(\\(?:input|include)\s*\{([^}]*)\})");
+    if (!visited.insert(path).second)
+    {
+        return;
+    }
+    ctx.ui->Verbose(1, fmt::format(T_("scanning {0}"), Q_(path)));
+    // read the document without comments; commands may span lines
+    string text;
+    StreamReader reader(path);
+    string line;
+    while (reader.ReadLine(line))
+    {
+        for (size_t idx = 0; idx < line.length(); ++idx)
+        {
+            if (line[idx] == '\\')
+            {
+                ++idx;
+            }
+            else if (line[idx] == '%')
+            {
+                line.erase(idx);
+                break;
+            }
+        }
+        text += line;
+        text += '\n';
+    }
+    reader.Close();
+    for (sregex_iterator it(text.begin(), text.end(), loadCommand); it != sregex_iterator(); ++it)
+    {
+        string command = (*it)[1];
+        string extension = command == "documentclass" || command == "LoadClass" ? ".cls" : ".sty";
+        for (const string& name : StringUtil::Split((*it)[2], ','))
+        {
+            size_t start = name.find_first_not_of(" \t\n");
+            if (start == string::npos)
+            {
+                continue;
+            }
+            size_t end = name.find_last_not_of(" \t\n");
+            fileNames.insert(name.substr(start, end - start + 1) + extension);
+        }
+    }
+    // follow \input and \include into the files of the document
+    for (sregex_iterator it(text.begin(), text.end(), inputCommand); it != sregex_iterator(); ++it)
+    {
+        PathName input((*it)[1].str());
+        if (!input.HasExtension())
+        {
+            input.AppendExtension(".tex");
+        }
+        if (!input.IsAbsolute())
+        {
+            input = path.GetDirectoryName() / input;
+        }
+        if (File::Exists(input))
+        {
+            ScanDocument(ctx, input, fileNames, visited);
+        }
+    }
+}
+
+void RequireCommand::ScanDocuments(ApplicationContext& ctx, const vector<PathName>& documents, vector<string>& requiredPackages)
+{
+    set<string> fileNames;
+    set<PathName> visited;
+    for (const PathName& document : documents)
+    {
+        if (!File::Exists(document))
+        {
+            ctx.ui->FatalError(fmt::format(T_("{0} does not exist"), Q_(document)));
+        }
+        ScanDocument(ctx, document, fileNames, visited);
+    }
+    // files which can be found need no package; the installer is
+    // disabled meanwhile, so that the lookups do not install packages
+    // one at a time
+    set<string> missingFiles;
+    bool installerWasDisabled = ctx.installer->IsInstallerDisabled();
+    ctx.installer->EnableInstaller(false);
+    try
+    {
+        for (const string& fileName : fileNames)
+        {
+            PathName path;
+            if (!ctx.session->FindFile(fileName, FileType::TEX, path))
+            {
+                missingFiles.insert(fileName);
+            }
+        }
+    }
+    catch (const exception&)
+    {
+        ctx.installer->EnableInstaller(!installerWasDisabled);
+        throw;
+    }
+    ctx.installer->EnableInstaller(!installerWasDisabled);
+    if (missingFiles.empty())
+    {
+        return;
+    }
+    // look up the missing files in the package database; required
+    // packages are resolved by the installer
+    auto packageIterator = ctx.packageManager->CreateIterator();
+    PackageInfo packageInfo;
+    while (!missingFiles.empty() && packageIterator->GetNext(packageInfo))
+    {
+        for (const string& runFile : packageInfo.runFiles)
+        {
+            string fileName = PathName(runFile).GetFileName().ToString();
+            if (missingFiles.erase(fileName) > 0)
+            {
+                ctx.ui->Verbose(1, fmt::format(T_("{0} is contained in package {1}"), fileName, packageInfo.id));
+                if (std::find(requiredPackages.begin(), requiredPackages.end(), packageInfo.id) == requiredPackages.end())
+                {
+                    requiredPackages.push_back(packageInfo.id);
+                }
+            }
+        }
+    }
+    for (const string& fileName : missingFiles)
+    {
+        ctx.ui->Verbose(1, fmt::format(T_("{0} is not contained in any package"), fileName));
+    }
+}
+
 void RequireCommand::Require(ApplicationContext& ctx, const vector<string>& requiredPackages, const string& repository)
 {
     vector<string> toBeInstalled;
@@ -144,6 +297,10 @@ void RequireCommand::Require(ApplicationContext& ctx, const vector<string>& requ
             toBeInstalled.push_back(packageID);
         }
     }
+    if (toBeInstalled.empty())
+    {
+        return;
+    }
     MyPackageInstallerCallback cb;
     auto packageInstaller = ctx.packageManager->CreateInstaller({ &cb, true, true });
     if (!repository.empty())
@@ -51,10 +51,28 @@ namespace
 
         std::string Synopsis() override
         {
-            return "verify [--package-id-file=FILE] [<package-id>...]";
+            return "verify [--jobs <n>] [--package-id-file=FILE] [--quick] [<package-id>...]";
         }
 
-        void Verify(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<std::string>& toBeVerified);
+        void Verify(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<std::string>& toBeVerified, const MiKTeX::Packages::VerifyOptions& options);
+    };
+
+    class VerifyProgress :
+        public MiKTeX::Packages::VerifyCallback
+    {
+    public:
+        VerifyProgress(OneMiKTeXUtility::ApplicationContext& ctx, std::size_t total) :
+            ctx(ctx),
+            total(total)
+        {
+        }
+
+        void MIKTEXTHISCALL OnPackageVerified(const std::string& packageId, bool ok) override;
+
+    private:
+        OneMiKTeXUtility::ApplicationContext& ctx;
+        std::size_t count = 0;
+        std::size_t total;
     };
 }
 
@@ -77,11 +95,20 @@ unique_ptr<Command> Commands::Verify()
 enum Option
 {
     OPT_AAA = 1,
+    OPT_JOBS,
     OPT_PACKAGE_ID_FILE,
+    OPT_QUICK,
 };
 
 static const struct poptOption options[] =
 {
+    {
+        "jobs", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_JOBS,
+        T_("Read up to N files at the same time (default: depends on the disk)."),
+        T_("N")
+    },
     {
         "package-id-file", 0,
         POPT_ARG_STRING, nullptr,
@@ -89,6 +116,13 @@ static const struct poptOption options[] =
         T_("Read package IDs from file."),
         "FILE"
     },
+    {
+        "quick", 0,
+        POPT_ARG_NONE, nullptr,
+        OPT_QUICK,
+        T_("Skip packages whose files have the same sizes and modification times as on the last successful verification."),
+        nullptr
+    },
     POPT_AUTOHELP
     POPT_TABLEEND
 };
@@ -100,13 +134,27 @@ int VerifyCommand::Execute(ApplicationContext& ctx, const vector<string>& argume
     int option;
     string repository;
     vector<string> toBeVerified;
+    VerifyOptions verifyOptions;
     while ((option = popt.GetNextOpt()) >= 0)
     {
         switch (option)
         {
+        case OPT_JOBS:
+        {
+            string jobs = popt.GetOptArg();
+            if (jobs.empty() || jobs.find_first_not_of("0123456789") != string::npos || std::stoul(jobs) == 0)
+            {
+                ctx.ui->IncorrectUsage(fmt::format(T_("{0}: invalid number of jobs"), jobs));
+            }
+            verifyOptions.maxJobs = static_cast<unsigned>(std::stoul(jobs));
+            break;
+        }
         case OPT_PACKAGE_ID_FILE:
             ReadNames(PathName(popt.GetOptArg()), toBeVerified);
             break;
+        case OPT_QUICK:
+            verifyOptions.quick = true;
+            break;
         }
     }
     if (option != -1)
@@ -115,11 +163,24 @@ int VerifyCommand::Execute(ApplicationContext& ctx, const vector<string>& argume
     }
     auto leftOvers = popt.GetLeftovers();
     toBeVerified.insert(toBeVerified.end(), leftOvers.begin(), leftOvers.end());
-    Verify(ctx, toBeVerified);
+    Verify(ctx, toBeVerified, verifyOptions);
     return 0;
 }
 
-void VerifyCommand::Verify(ApplicationContext& ctx, const vector<string>& toBeVerifiedArg)
+void VerifyProgress::OnPackageVerified(const string& packageId, bool ok)
+{
+    count += 1;
+    if (ok)
+    {
+        ctx.ui->Verbose(1, fmt::format(T_("[{0}/{1}] {2}: OK"), count, total, packageId));
+    }
+    else
+    {
+        ctx.ui->Verbose(0, fmt::format(T_("[{0}/{1}] {2}: this package needs to be reinstalled."), count, total, packageId));
+    }
+}
+
+void VerifyCommand::Verify(ApplicationContext& ctx, const vector<string>& toBeVerifiedArg, const VerifyOptions& options)
 {
     vector<string> toBeVerified = toBeVerifiedArg;
     bool verifyAll = toBeVerified.empty();
@@ -135,15 +196,9 @@ void VerifyCommand::Verify(ApplicationContext& ctx, const vector<string>& toBeVe
             }
         }
     }
-    bool ok = true;
-    for (const string& packageID : toBeVerified)
-    {
-        if (!ctx.packageManager->TryVerifyInstalledPackage(packageID))
-        {
-            ctx.ui->Verbose(0, fmt::format(T_("{0}: this package needs to be reinstalled."), packageID));
-            ok = false;
-        }
-    }
+    VerifyProgress progress(ctx, toBeVerified.size());
+    vector<string> damaged = ctx.packageManager->VerifyInstalledPackages(toBeVerified, options, &progress);
+    bool ok = damaged.empty();
     if (ok)
     {
         if (verifyAll)
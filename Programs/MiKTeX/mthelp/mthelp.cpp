@@ -84,12 +84,6 @@ private:
 private:
   void Warning(const string& msg);
 
-private:
-  bool SkipPrefix(const string& str, const char* lpszPrefix, string& result);
-
-private:
-  bool SkipTeXMFPrefix(const string& str, string& result);
-
 private:
   void FindDocFilesByPackage(const string& packageName, map<string, vector<string>>& filesByExtension);
 
@@ -193,45 +187,21 @@ void MiKTeXHelp::Warning(const string& msg)
   cerr << msg << endl;
 }
 
-bool MiKTeXHelp::SkipPrefix(const string& str, const char* lpszPrefix, string& result)
-{
-  size_t n = StrLen(lpszPrefix);
-  if (str.compare(0, n, lpszPrefix) != 0)
-  {
-    return false;
-  }
-  result = str.c_str() + n;
-  return true;
-}
-
-bool MiKTeXHelp::SkipTeXMFPrefix(const string& str, string& result)
-{
-  return SkipPrefix(str, "texmf/", result)
-    || SkipPrefix(str, "texmf\\", result)
-    || SkipPrefix(str, "./texmf/", result)
-    || SkipPrefix(str, ".\\texmf\\", result);
-}
-
 void MiKTeXHelp::FindDocFilesByPackage(const string& packageName, map<string, vector<string>>& filesByExtension)
 {
-  PackageInfo pi;
   string searchPath = MIKTEX_PATH_TEXMF_PLACEHOLDER;
-  if (!pManager->TryGetPackageInfo(packageName + "__doc", pi))
+  vector<DocumentationFile> docFiles = pManager->FindDocumentationByPackage(packageName + "__doc");
+  if (docFiles.empty())
   {
-    if (!pManager->TryGetPackageInfo(packageName, pi))
-    {
-      return;
-    }
+    docFiles = pManager->FindDocumentationByPackage(packageName);
     searchPath = MIKTEX_PATH_TEXMF_PLACEHOLDER_NO_MPM;
   }
-  for (const string& fileName : pi.docFiles)
+  for (const DocumentationFile& docFile : docFiles)
   {
-    string extension = PathName(fileName).GetExtension();
-    string file;
     PathName path;
-    if (SkipTeXMFPrefix(fileName, file) && session->FindFile(file, searchPath, path))
+    if (session->FindFile(docFile.path, searchPath, path))
     {
-      vector<string>& files = filesByExtension[extension];
+      vector<string>& files = filesByExtension[docFile.type];
       files.push_back(path.ToString());
     }
   }
@@ -270,6 +240,24 @@ void MiKTeXHelp::FindDocFilesByPackage(const string& packageName, vector<string>
 void MiKTeXHelp::FindDocFilesByName(const string& name, vector<string>& files)
 {
   vector<string> extensions = session->GetConfigValue(MIKTEX_CONFIG_SECTION_CORE_FILETYPES + ".TeX system documentation"s, MIKTEX_CONFIG_VALUE_EXTENSIONS).GetStringArray();
+  vector<DocumentationFile> docFiles = pManager->FindDocumentationByName(name);
+  for (const string& ext : extensions)
+  {
+    for (const DocumentationFile& docFile : docFiles)
+    {
+      PathName path;
+      if (PathName::Compare(PathName(docFile.type), PathName(ext)) == 0 && session->FindFile(docFile.path, MIKTEX_PATH_TEXMF_PLACEHOLDER, path))
+      {
+        files.push_back(path.ToString());
+        break;
+      }
+    }
+  }
+  if (!files.empty())
+  {
+    return;
+  }
+  // not a packaged documentation file: search the doc directories
   string searchSpec = MIKTEX_PATH_TEXMF_PLACEHOLDER;
   searchSpec += MIKTEX_PATH_DIRECTORY_DELIMITER_STRING;
   searchSpec += MIKTEX_PATH_DOC_DIR;
@@ -69,26 +69,24 @@ void BitmapPrinter::PrintChunk(const DibChunk & chunk)
   }
 }
 
+// bands of up to 4 MB: a page takes a few StretchDIBits() calls, not
+// one per scan line, and the memory needed does not grow with the
+// resolution
+const size_t BAND_SIZE = 4 * 1024 * 1024;
+
+// how many bands Ghostscript may be ahead of the printer driver
+const size_t MAX_QUEUED_BANDS = 4;
+
 void BitmapPrinter::OnNewChunk(shared_ptr<DibChunk> pChunk)
 {
-  if (!JobStarted())
+  unique_lock<mutex> lock(bandsMutex);
+  bandsCondition.wait(lock, [this]() { return aborted || bands.size() < MAX_QUEUED_BANDS; });
+  if (aborted)
   {
-    StartJob();
-    int rasterCaps = ::GetDeviceCaps(GetDC(), RASTERCAPS);
-    if ((rasterCaps & RC_STRETCHDIB) == 0)
-    {
-      MIKTEX_UNEXPECTED();
-    }
-    offsetX = ::GetDeviceCaps(GetDC(), PHYSICALOFFSETX);
-    offsetY = ::GetDeviceCaps(GetDC(), PHYSICALOFFSETY);
-    trace_mtprint->WriteLine(T_("mtprint"), fmt::format(T_("PHYSICALOFFSETX: {0}"), offsetX));
-    trace_mtprint->WriteLine(T_("mtprint"), fmt::format(T_("PHYSICALOFFSETY: {0}"), offsetY));
+    throw OperationCancelledException();
   }
-  if (!PageStarted())
-  {
-    StartPage();
-  }
-  PrintChunk(*pChunk);
+  bands.push_back(pChunk);
+  bandsCondition.notify_all();
 }
 
 size_t BitmapPrinter::Read(void * pBuf, size_t size)
@@ -96,34 +94,99 @@ size_t BitmapPrinter::Read(void * pBuf, size_t size)
   return stream.Read(pBuf, size);
 }
 
+void BitmapPrinter::ChunkerThread()
+{
+  exception_ptr e;
+  try
+  {
+    unique_ptr<DibChunker> pChunker(DibChunker::Create());
+    while (pChunker->Process(DibChunker::Default, BAND_SIZE, this))
+    {
+      // end of page
+      OnNewChunk(nullptr);
+    }
+  }
+  catch (const exception &)
+  {
+    e = current_exception();
+  }
+  lock_guard<mutex> lock(bandsMutex);
+  chunkerException = e;
+  chunkerDone = true;
+  bandsCondition.notify_all();
+}
+
 void BitmapPrinter::Print(FILE * pfileDibStream)
 {
   stream.Attach(pfileDibStream);
+  // Ghostscript output is read on a thread of its own: Ghostscript
+  // renders the next bands while the printer driver spools
+  thread chunkerThread(&BitmapPrinter::ChunkerThread, this);
   try
   {
-    unique_ptr<DibChunker> pChunker(DibChunker::Create());
-    const size_t CHUNK_SIZE = 1024 * 64;
-    try
+    while (true)
     {
-      do
+      shared_ptr<DibChunk> band;
+      {
+        unique_lock<mutex> lock(bandsMutex);
+        bandsCondition.wait(lock, [this]() { return chunkerDone || !bands.empty(); });
+        if (bands.empty())
+        {
+          break;
+        }
+        band = bands.front();
+        bands.pop_front();
+        bandsCondition.notify_all();
+      }
+      if (band == nullptr)
       {
         if (PageStarted())
         {
           EndPage();
         }
-      } while (pChunker->Process(DibChunker::Default, CHUNK_SIZE, this));
+        continue;
+      }
+      if (!JobStarted())
+      {
+        StartJob();
+        int rasterCaps = ::GetDeviceCaps(GetDC(), RASTERCAPS);
+        if ((rasterCaps & RC_STRETCHDIB) == 0)
+        {
+          MIKTEX_UNEXPECTED();
+        }
+        offsetX = ::GetDeviceCaps(GetDC(), PHYSICALOFFSETX);
+        offsetY = ::GetDeviceCaps(GetDC(), PHYSICALOFFSETY);
+        trace_mtprint->WriteLine(T_("mtprint"), fmt::format(T_("PHYSICALOFFSETX: {0}"), offsetX));
+        trace_mtprint->WriteLine(T_("mtprint"), fmt::format(T_("PHYSICALOFFSETY: {0}"), offsetY));
+      }
+      if (!PageStarted())
+      {
+        StartPage();
+      }
+      PrintChunk(*band);
     }
-    catch (const exception &)
+    chunkerThread.join();
+    if (chunkerException)
     {
-      Finalize();
-      throw;
+      rethrow_exception(chunkerException);
     }
-    Finalize();
   }
   catch (const exception &)
   {
+    {
+      lock_guard<mutex> lock(bandsMutex);
+      aborted = true;
+      bands.clear();
+      bandsCondition.notify_all();
+    }
+    if (chunkerThread.joinable())
+    {
+      chunkerThread.join();
+    }
+    Finalize();
     stream.Detach();
     throw;
   }
+  Finalize();
   stream.Detach();
 }
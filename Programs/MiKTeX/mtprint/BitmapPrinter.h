@@ -41,6 +41,9 @@ public:
 private:
   void PrintChunk(const DibChunk & chunk);
 
+private:
+  void ChunkerThread();
+
 private:
   int offsetX;
 
@@ -49,4 +52,24 @@ private:
 
 private:
   FileStream stream;
+
+  // bands read from Ghostscript, waiting to be spooled; an empty
+  // pointer ends a page
+private:
+  deque<shared_ptr<DibChunk>> bands;
+
+private:
+  mutex bandsMutex;
+
+private:
+  condition_variable bandsCondition;
+
+private:
+  bool chunkerDone = false;
+
+private:
+  bool aborted = false;
+
+private:
+  exception_ptr chunkerException;
 };
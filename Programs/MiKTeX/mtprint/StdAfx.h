@@ -48,9 +48,14 @@
 #include <miktex/Core/win/ConsoleCodePageSwitcher>
 #endif
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 using namespace MiKTeX::App;
@@ -21,7 +21,10 @@
 #  include <config.h>
 #endif
 
+#include <algorithm>
+#include <future>
 #include <iostream>
+#include <thread>
 #include <unordered_set>
 
 #include <fmt/format.h>
@@ -30,8 +33,10 @@
 #include <miktex/Core/CommandLineBuilder>
 #include <miktex/Core/Directory>
 #include <miktex/Core/DirectoryLister>
+#include <miktex/Core/Fndb>
 #include <miktex/Core/Process>
 #include <miktex/Core/Quoter>
+#include <miktex/Core/StreamReader>
 #include <miktex/Core/StreamWriter>
 #include <miktex/Core/TemporaryDirectory>
 #include <miktex/Core/TemporaryFile>
@@ -197,6 +202,7 @@ void Recipe::Execute(bool printOnly)
   InstallFiles("script", standardScriptPatterns, tds.GetScriptDir());
   Finalize();
   CleanupWorkingDirectory();
+  UpdateFndb();
 }
 
 void Recipe::SetupWorkingDirectory()
@@ -438,13 +444,13 @@ void Recipe::RunInsEngine(const string& engine, const vector<string>& options, c
   CommandLineBuilder cmd;
   cmd.AppendArgument(engine);
   cmd.AppendOption("-enable-installer");
+  cmd.AppendOption("-recorder");
   cmd.AppendOption("-output-directory=", outDir);
   cmd.AppendOption("-aux-directory=", workDir);
   cmd.AppendArguments(options);
   cmd.AppendArgument(insFile);
   cmd.AppendStdinRedirection(alwaysYes->GetPathName());
   ProcessOutputTrash trash;
-  Verbose("running .ins engine on '" + insFile.GetFileName().ToString() + "'");
   int exitCode = 0;
   if (!Process::ExecuteSystemCommand(cmd.ToString(), &exitCode, &trash, workDir.GetData()) || exitCode != 0)
   {
@@ -452,6 +458,45 @@ void Recipe::RunInsEngine(const string& engine, const vector<string>& options, c
   }
 }
 
+bool Recipe::ReadInsEngineRecording(const PathName& insFile, unordered_set<PathName>& inputs, unordered_set<PathName>& outputs)
+{
+  PathName flsFile = workDir / insFile.GetFileNameWithoutExtension();
+  flsFile.AppendExtension(".fls");
+  if (!File::Exists(flsFile))
+  {
+    return false;
+  }
+  StreamReader reader(flsFile);
+  string line;
+  while (reader.ReadLine(line))
+  {
+    PathName path;
+    bool isOutput;
+    if (line.compare(0, 6, "INPUT ") == 0)
+    {
+      path = line.substr(6);
+      isOutput = false;
+    }
+    else if (line.compare(0, 7, "OUTPUT ") == 0)
+    {
+      path = line.substr(7);
+      isOutput = true;
+    }
+    else
+    {
+      continue;
+    }
+    if (!path.IsAbsolute())
+    {
+      path = workDir / path;
+    }
+    (isOutput ? outputs : inputs).insert(path);
+  }
+  reader.Close();
+  File::Delete(flsFile);
+  return true;
+}
+
 void Recipe::RunDtxUnpacker()
 {
   string engine;
@@ -499,8 +544,67 @@ void Recipe::RunDtxUnpacker()
   packageInsFile /= package + ".ins";
   bool packageInsFileExists = File::Exists(packageInsFile);
   unique_ptr<TemporaryDirectory> outDir = TemporaryDirectory::Create();
+  // the .ins files are first run concurrently; the recorder files tell
+  // whether the runs are independent of each other, i.e., no run
+  // reads or writes a file written by another run; if they are not,
+  // the files are run again one after another
+  bool independent = insFiles.size() > 1;
+  unordered_set<PathName> jobNames;
+  for (const PathName& insFile : insFiles)
+  {
+    independent = independent && jobNames.insert(insFile.GetFileNameWithoutExtension()).second;
+  }
+  if (independent)
+  {
+    size_t maxJobs = std::max(thread::hardware_concurrency(), 1u);
+    vector<unordered_set<PathName>> inputs(insFiles.size());
+    vector<unordered_set<PathName>> outputs(insFiles.size());
+    for (size_t start = 0; start < insFiles.size(); start += maxJobs)
+    {
+      size_t end = std::min(start + maxJobs, insFiles.size());
+      vector<future<void>> jobs;
+      for (size_t idx = start; idx < end; ++idx)
+      {
+        Verbose("running .ins engine on '" + insFiles[idx].GetFileName().ToString() + "'");
+        jobs.push_back(async(launch::async, [this, &engine, &options, &insFiles, &outDir, idx]() { RunInsEngine(engine, options, insFiles[idx], outDir->GetPathName()); }));
+      }
+      for (future<void>& job : jobs)
+      {
+        job.get();
+      }
+    }
+    for (size_t idx = 0; independent && idx < insFiles.size(); ++idx)
+    {
+      independent = ReadInsEngineRecording(insFiles[idx], inputs[idx], outputs[idx]);
+    }
+    for (size_t idx = 0; independent && idx < insFiles.size(); ++idx)
+    {
+      for (const PathName& path : outputs[idx])
+      {
+        for (size_t other = 0; independent && other < insFiles.size(); ++other)
+        {
+          independent = other == idx || (inputs[other].find(path) == inputs[other].end() && outputs[other].find(path) == outputs[other].end());
+        }
+        if (!independent)
+        {
+          Verbose("'" + insFiles[idx].GetFileName().ToString() + "' depends on other .ins files; running them one after another");
+          break;
+        }
+      }
+    }
+  }
+  if (independent)
+  {
+    if (!packageInsFileExists && File::Exists(packageInsFile))
+    {
+      Verbose("re-running .ins engine because '" + package + ".ins' has been unpacked");
+      RunInsEngine(engine, options, packageInsFile, outDir->GetPathName());
+    }
+    return;
+  }
   for (const PathName& insFile : insFiles)
   {
+    Verbose("running .ins engine on '" + insFile.GetFileName().ToString() + "'");
     RunInsEngine(engine, options, insFile, outDir->GetPathName());
     if (!packageInsFileExists)
     {
@@ -579,7 +683,32 @@ void Recipe::Install(const vector<string>& patterns, const PathName& tdsDir)
       else
       {
         File::Move(file, toPath);
+        installedFiles.push_back(toPath);
       }
     }
   }
 }
+
+void Recipe::UpdateFndb()
+{
+  // nothing to do, if the destination directory is not below a TEXMF
+  // root directory; otherwise all installed files are registered in
+  // one go
+  if (printOnly || session->TryDeriveTEXMFRoot(destDir) == INVALID_ROOT_INDEX)
+  {
+    return;
+  }
+  vector<Fndb::Record> records;
+  for (const PathName& file : installedFiles)
+  {
+    if (File::Exists(file) && !Fndb::FileExists(file))
+    {
+      records.push_back({ file });
+    }
+  }
+  if (!records.empty())
+  {
+    Verbose("adding " + std::to_string(records.size()) + " file(s) to the file name database");
+    Fndb::Add(records);
+  }
+}
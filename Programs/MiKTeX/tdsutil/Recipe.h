@@ -92,6 +92,9 @@ private:
 private:
   void RunInsEngine(const std::string& engine, const std::vector<std::string>& options, const MiKTeX::Util::PathName& insFile, const MiKTeX::Util::PathName& outDir );
 
+private:
+  bool ReadInsEngineRecording(const MiKTeX::Util::PathName& insFile, std::unordered_set<MiKTeX::Util::PathName>& inputs, std::unordered_set<MiKTeX::Util::PathName>& outputs);
+
 private:
   void RunDtxUnpacker();
 
@@ -113,6 +116,9 @@ private:
 private:
   void Install(const std::vector<std::string>& patterns, const MiKTeX::Util::PathName& tdsDir);
 
+private:
+  void UpdateFndb();
+
 private:
   bool MIKTEXTHISCALL TryGetValue(const std::string& valueName, std::string& value) override
   {
@@ -176,6 +182,9 @@ private:
 private:
   std::unordered_set<MiKTeX::Util::PathName> initialWorkDirSnapshot;
 
+private:
+  std::vector<MiKTeX::Util::PathName> installedFiles;
+
 private:
   std::shared_ptr<MiKTeX::Core::Session> session = MIKTEX_SESSION();
 
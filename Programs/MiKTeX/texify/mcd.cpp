@@ -36,8 +36,16 @@
 #include <cstdlib>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <vector>
 
 #include "mcd-version.h"
@@ -51,7 +59,9 @@
 #include <miktex/Core/Exceptions>
 #include <miktex/Core/File>
 #include <miktex/Core/FileStream>
+#include <miktex/Core/FileSystemWatcher>
 #include <miktex/Core/FileType>
+#include <miktex/Core/MD5>
 #include <miktex/Core/MemoryMappedFile>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Process>
@@ -59,6 +69,7 @@
 #include <miktex/Core/StreamReader>
 #include <miktex/Core/StreamWriter>
 #include <miktex/Core/TemporaryDirectory>
+#include <miktex/Core/TemporaryFile>
 #include <miktex/Trace/Trace>
 #include <miktex/Trace/TraceStream>
 #include <miktex/Util/StringUtil>
@@ -78,6 +89,7 @@ using namespace std;
 using namespace std::string_literals;
 
 using namespace MiKTeX::App;
+using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
 using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
@@ -154,13 +166,16 @@ private:
   string output;
 };
 
-void CopyFiles(const vector<string>& fileNames, const PathName& destDir)
+// a BibTeX, index generator or Asymptote run which does not depend on
+// other runs
+struct ExternalJob
 {
-  for (const string& fileName : fileNames)
-  {
-    File::Copy(PathName(fileName), PathName(destDir, PathName(fileName)));
-  }
-}
+  PathName exe;
+  vector<string> args;
+  PathName workingDirectory;
+  string failureMessage;
+  function<void()> onSuccess;
+};
 
 vector<char> ReadFile(const PathName& fileName)
 {
@@ -309,6 +324,9 @@ public:
 public:
   bool runViewer = false;
 
+public:
+  bool watch = false;
+
 #if defined(SUPPORT_OPT_SRC_SPECIALS)
 public:
   bool sourceSpecials = false;
@@ -320,6 +338,15 @@ public:
 public:
   int maxIterations = 5;
 
+  // directory which holds the results of earlier builds (empty, if
+  // results are not cached)
+public:
+  PathName resultCacheDirectory;
+
+  // install the packages required by the document before running TeX
+public:
+  bool prescan = false;
+
 public:
   vector<string> includeDirectories;
 
@@ -337,6 +364,9 @@ public:
 public:
   string sourceSpecialsWhere;
 
+public:
+  string asyProgram;
+
 public:
   string bibtexProgram;
 
@@ -508,6 +538,7 @@ Options::Options()
   startDirectory.SetToCurrentDirectory();
   startDirectory.ConvertToUnix();
 
+  asyProgram = SetProgramName("ASY", MIKTEX_ASY_EXE);
   bibtexProgram = SetProgramName("BIBTEX", MIKTEX_BIBTEX_EXE);
   latexProgram = SetProgramName("LATEX", "latex");
   makeindexProgram = SetProgramName("MAKEINDEX", MIKTEX_MAKEINDEX_EXE);
@@ -568,6 +599,12 @@ public:
 private:
   void Version();
 
+private:
+  void Watch(const string& fileName);
+
+private:
+  int RunBatch(const vector<string>& fileNames, const vector<string>& childArgs, int numJobs);
+
 private:
   unique_ptr<TraceStream> traceStream;
 
@@ -614,6 +651,9 @@ public:
 public:
   void Run();
 
+public:
+  vector<PathName> GetWatchedFiles() const;
+
 private:
   void FatalUtilityError(const string& name)
   {
@@ -646,7 +686,7 @@ private:
   bool RunMakeinfo(const PathName& pathFrom, const PathName& pathTo);
 
 private:
-  void RunBibTeX();
+  void ScheduleBibTeX(vector<ExternalJob>& jobs);
 
 private:
   PathName GetTeXEnginePath(string& exeName);
@@ -655,7 +695,13 @@ private:
   void RunTeX();
 
 private:
-  void RunIndexGenerator(const vector<string>& idxFiles);
+  void ScheduleIndexGenerator(const vector<string>& idxFiles, vector<ExternalJob>& jobs);
+
+private:
+  void ScheduleAsymptote(vector<ExternalJob>& jobs);
+
+private:
+  void RunJobs(const vector<ExternalJob>& jobs);
 
 private:
   void RunViewer();
@@ -663,6 +709,30 @@ private:
 private:
   bool Ready();
 
+private:
+  void ReadRecorderFile();
+
+private:
+  map<string, MD5> GetDigests(const vector<string>& fileNames);
+
+private:
+  bool InputsUnchanged();
+
+private:
+  MD5 GetBibTeXInputDigest(const PathName& auxName);
+
+private:
+  vector<string> GetResultFileNames();
+
+private:
+  string GetResultCacheKey();
+
+private:
+  bool TryRestoreResults(const string& key);
+
+private:
+  void StoreResults(const string& key);
+
 #if defined(WITH_TEXINFO)
 private:
   bool Check_texinfo_tex();
@@ -680,6 +750,9 @@ private:
 private:
   void InstallProgram(const char* program);
 
+private:
+  void RequirePackages();
+
   // the macro language
 private:
   MacroLanguage macroLanguage = MacroLanguage::None;
@@ -721,10 +794,6 @@ private:
   PathName extraDirectory;
 #endif
 
-  // the aux directory: contains backed up auxiliary files
-private:
-  PathName auxDirectory;
-
   // fully qualified path to the input file
 private:
   PathName pathInputFile;
@@ -733,6 +802,55 @@ private:
 private:
   vector<string> previousAuxFiles;
 
+  // digests of the auxiliary files, taken before the last run
+private:
+  map<string, MD5> previousAuxDigests;
+
+  // the files TeX read in the last run (from the recorder file); files
+  // in TEXMF root directories are not tracked
+private:
+  vector<string> recordedInputs;
+
+  // digests of the files TeX was about to read, taken before the last run
+private:
+  map<string, MD5> inputDigests;
+
+  // all files TeX read in any run (including the files in TEXMF root
+  // directories) and all files TeX wrote
+private:
+  set<string> allRecordedInputs;
+
+private:
+  set<string> recordedOutputs;
+
+  // the bibliography databases and styles BibTeX reads
+private:
+  set<string> bibtexInputs;
+
+  // files written after this time are products of the build
+private:
+  time_t buildStartTime = 0;
+
+  // digest of the citations and bibliography inputs the last time BibTeX
+  // was run
+private:
+  MD5 bibtexInputDigest;
+
+private:
+  bool bibtexHasRun = false;
+
+  // digests of the index files the last time the index generator was run
+private:
+  map<string, MD5> idxDigests;
+
+  // digests of the Asymptote files the last time asy was run on them
+private:
+  map<string, MD5> asyDigests;
+
+  // asy has made figures which TeX has not read yet
+private:
+  bool haveNewFigures = false;
+
 private:
   McdApp* app = nullptr;
 
@@ -791,8 +909,9 @@ void Driver::Initialize(McdApp* app, Options* options, const char* fileName)
   inputName = givenFileName;
   inputName.RemoveDirectorySpec();
 
-  // create a super-temp directory
-  tempDirectory = TemporaryDirectory::Create();
+  // create a super-temp directory; in clean mode, all intermediate files
+  // are written there, so a memory-backed file system is preferred
+  tempDirectory = options->clean ? TemporaryDirectory::Create({ TemporaryDirectoryOption::InMemory }) : TemporaryDirectory::Create();
 
   // create scratch directory
   workingDirectory = tempDirectory->GetPathName() / PathName("_src");
@@ -808,12 +927,6 @@ void Driver::Initialize(McdApp* app, Options* options, const char* fileName)
   app->MyTrace(fmt::format(T_("extra directory: {}"), Q_(extraDirectory)));
 #endif
 
-  // create aux directory
-  auxDirectory = tempDirectory->GetPathName() / PathName("_aux");
-  Directory::Create(auxDirectory);
-  auxDirectory.ConvertToUnix();
-  app->MyTrace(fmt::format(T_("aux directory: {}"), Q_(auxDirectory)));
-
   // If the user explicitly specified the language, use that.
   // Otherwise, if the first line is \input texinfo, assume it's
   // texinfo.  Otherwise, guess from the file extension.
@@ -887,7 +1000,7 @@ MacroLanguage Driver::GuessMacroLanguage(const PathName& fileName)
 
 void Driver::TexinfoPreprocess(const PathName& pathFrom, const PathName& pathTo)
 {
-  StreamReader reader(pathFrom);
+  StreamReader reader(pathFrom, true);
   StreamWriter writer(pathTo);
   bool at_tex = false;
   bool at_iftex = false;
@@ -986,7 +1099,7 @@ void Driver::TexinfoPreprocess(const PathName& pathFrom, const PathName& pathTo)
 
 void Driver::TexinfoUncomment(const PathName& pathFrom, const PathName& pathTo)
 {
-  StreamReader reader(pathFrom);
+  StreamReader reader(pathFrom, true);
   StreamWriter writer(pathTo);
   string line;
   while (reader.ReadLine(line))
@@ -1219,7 +1332,7 @@ void Driver::InsertCommands()
   PathName path(extraDirectory, inputName);
   StreamWriter writer(path);
   bool inserted = false;
-  StreamReader reader(pathInputFile);
+  StreamReader reader(pathInputFile, true);
   string line;
   while (reader.ReadLine(line))
   {
@@ -1239,9 +1352,9 @@ void Driver::InsertCommands()
 
 /* _________________________________________________________________________
 
-   Driver::RunBibTeX
+   Driver::ScheduleBibTeX
 
-   Run bibtex on current file:
+   Schedule bibtex runs on current file:
    - If its input (AUX) exists.
    - If AUX contains both '\bibdata' and '\bibstyle'.
    - If some citations are missing (LOG contains 'Citation') or the
@@ -1258,7 +1371,7 @@ void Driver::InsertCommands()
    match false messages.
    _________________________________________________________________________ */
 
-void Driver::RunBibTeX()
+void Driver::ScheduleBibTeX(vector<ExternalJob>& jobs)
 {
   PathName pathExe;
 
@@ -1272,7 +1385,19 @@ void Driver::RunBibTeX()
   PathName auxName(jobName);
   auxName.AppendExtension(".aux");
 
-  int exitCode;
+  MD5 digest{};
+  if (File::Exists(auxName))
+  {
+    digest = GetBibTeXInputDigest(auxName);
+    PathName bblName(jobName);
+    bblName.AppendExtension(".bbl");
+    // BibTeX would produce the same .bbl file again
+    if (bibtexHasRun && digest == bibtexInputDigest && File::Exists(bblName))
+    {
+      app->Verbose(T_("citations and bibliography files are unchanged: not running BibTeX"));
+      return;
+    }
+  }
 
 #if defined(SF464378__CHAPTERBIB)
   if ((File::Exists(auxName)
@@ -1323,17 +1448,11 @@ void Driver::RunBibTeX()
 
       args.push_back(subAuxNameNoExt.ToString());
 
-      app->Verbose(fmt::format(T_("running {}..."), CommandLineBuilder(args).ToString()));
-
-      exitCode = 0;
-
-      ProcessOutputTrash trash;
-
-      Process::Run(pathExe, args, (options->quiet ? &trash : nullptr), &exitCode, subDir.Empty() ? nullptr : subDir.GetData());
-      if (exitCode != 0)
-      {
-        MIKTEX_FATAL_ERROR(T_("BibTeX failed for some reason."));
-      }
+      // the sub-bibliographies are independent of each other
+      jobs.push_back({ pathExe, args, subDir, T_("BibTeX failed for some reason."), [this, digest]() {
+        bibtexHasRun = true;
+        bibtexInputDigest = digest;
+      } });
     }
   }
 #endif  // SF464378__CHAPTERBIB
@@ -1352,30 +1471,32 @@ void Driver::RunBibTeX()
 
   args.push_back(jobName.ToString());
 
-  app->Verbose(fmt::format(T_("running {}..."), CommandLineBuilder(args).ToString()));
-
-  ProcessOutputTrash trash;
-
-  Process::Run(pathExe, args, (options->quiet ? &trash : nullptr), &exitCode, nullptr);
-
-  if (exitCode != 0)
-  {
-    MIKTEX_FATAL_ERROR(T_("BibTeX failed for some reason."));
-  }
+  jobs.push_back({ pathExe, args, PathName(), T_("BibTeX failed for some reason."), [this, digest]() {
+    bibtexHasRun = true;
+    bibtexInputDigest = digest;
+  } });
 }
 
 /* _________________________________________________________________________
 
-   Driver::RunIndexGenerator
+   Driver::ScheduleIndexGenerator
 
-   Run texindex (or makeindex) on current index files.  If they
+   Schedule texindex (or makeindex) runs on current index files.  If they
    already exist, and after running TeX a first time the index files
    don't change, then there's no reason to run TeX again.  But we
    won't know that if the index files are out of date or nonexistent.
    _________________________________________________________________________ */
 
-void Driver::RunIndexGenerator(const vector<string>& idxFiles)
+void Driver::ScheduleIndexGenerator(const vector<string>& idxFiles, vector<ExternalJob>& jobs)
 {
+  // the index generator would produce the same output files again
+  map<string, MD5> digests = GetDigests(idxFiles);
+  if (!idxDigests.empty() && digests == idxDigests)
+  {
+    app->Verbose(T_("index files are unchanged: not running the index generator"));
+    return;
+  }
+
 #if defined(WITH_TEXINFO)
   const string indexGenerator = macroLanguage == MacroLanguage::Texinfo
     ? options->texindexProgram
@@ -1394,19 +1515,204 @@ void Driver::RunIndexGenerator(const vector<string>& idxFiles)
   vector<string> args{ indexGenerator };
 
   args.insert(args.end(), options->makeindexOptions.begin(), options->makeindexOptions.end());
+
+  auto onSuccess = [this, digests]() {
+    idxDigests = digests;
+  };
+
+#if defined(WITH_TEXINFO)
+  // texindex sorts each index file on its own: the index files can be
+  // sorted in parallel
+  if (macroLanguage == MacroLanguage::Texinfo)
+  {
+    for (const string& idxFile : idxFiles)
+    {
+      vector<string> idxArgs(args);
+      idxArgs.push_back(idxFile);
+      jobs.push_back({ pathExe, idxArgs, PathName(), T_("MakeIndex failed for some reason."), onSuccess });
+    }
+    return;
+  }
+#endif
+
+  // makeindex merges the index files
   args.insert(args.end(), idxFiles.begin(), idxFiles.end());
 
-  ProcessOutputTrash trash;
+  jobs.push_back({ pathExe, args, PathName(), T_("MakeIndex failed for some reason."), onSuccess });
+}
 
-  int exitCode = 0;
+/* _________________________________________________________________________
 
-  app->Verbose(fmt::format(T_("running {}..."), CommandLineBuilder(args).ToString()));
+   Driver::ScheduleAsymptote
 
-  Process::Run(pathExe, args, (options->quiet ? &trash : nullptr), &exitCode, nullptr);
+   Schedule asy runs on the figures written by the asymptote package
+   (JOBNAME-N.asy).  Only new or changed figures are compiled.  asy
+   compiles all files given on its command-line after one start, which
+   is the expensive part (plain.asy), so the figures are split into one
+   batch per processor instead of running asy once per figure.
+   _________________________________________________________________________ */
 
-  if (exitCode != 0)
+void Driver::ScheduleAsymptote(vector<ExternalJob>& jobs)
+{
+  PathName curDir;
+  curDir.SetToCurrentDirectory();
+  string pattern = jobName.ToString() + "-*.asy";
+  vector<string> asyFiles;
+  unique_ptr<DirectoryLister> lister = DirectoryLister::Open(curDir, pattern.c_str());
+  DirectoryEntry entry;
+  while (lister->GetNext(entry))
+  {
+    if (!entry.isDirectory)
+    {
+      asyFiles.push_back(entry.name);
+    }
+  }
+  lister->Close();
+  if (asyFiles.empty())
+  {
+    return;
+  }
+  sort(asyFiles.begin(), asyFiles.end());
+
+  map<string, MD5> digests = GetDigests(asyFiles);
+  vector<string> changed;
+  for (const auto& kv : digests)
+  {
+    auto it = asyDigests.find(kv.first);
+    if (it == asyDigests.end() || it->second != kv.second)
+    {
+      changed.push_back(kv.first);
+    }
+  }
+  if (changed.empty())
+  {
+    app->Verbose(T_("Asymptote files are unchanged: not running Asymptote"));
+    return;
+  }
+
+  PathName pathExe;
+  if (!session->FindFile(options->asyProgram, FileType::EXE, pathExe))
+  {
+    FatalUtilityError(options->asyProgram);
+  }
+
+  size_t numBatches = std::min<size_t>(changed.size(), std::max(thread::hardware_concurrency(), 1u));
+  for (size_t batch = 0; batch < numBatches; ++batch)
+  {
+    vector<string> args{ options->asyProgram };
+    map<string, MD5> batchDigests;
+    for (size_t idx = batch * changed.size() / numBatches; idx < (batch + 1) * changed.size() / numBatches; ++idx)
+    {
+      args.push_back(changed[idx]);
+      batchDigests[changed[idx]] = digests[changed[idx]];
+    }
+    jobs.push_back({ pathExe, args, PathName(), T_("Asymptote failed for some reason."), [this, batchDigests]() {
+      for (const auto& kv : batchDigests)
+      {
+        asyDigests[kv.first] = kv.second;
+      }
+      haveNewFigures = true;
+    } });
+  }
+}
+
+/* _________________________________________________________________________
+
+   Driver::RunJobs
+
+   Run independent BibTeX, index generator and Asymptote jobs in parallel, at most
+   one job per processor.  The output of the jobs is collected and
+   written when all jobs have finished, so that it does not get mixed
+   up.  A single job writes to the console directly.
+   _________________________________________________________________________ */
+
+void Driver::RunJobs(const vector<ExternalJob>& jobs)
+{
+  if (jobs.empty())
+  {
+    return;
+  }
+  for (const ExternalJob& job : jobs)
+  {
+    app->Verbose(fmt::format(T_("running {}..."), CommandLineBuilder(job.args).ToString()));
+  }
+  bool collectOutput = jobs.size() > 1;
+  vector<ProcessOutputSaver> outputs(jobs.size());
+  vector<int> exitCodes(jobs.size(), 0);
+  vector<exception_ptr> exceptions(jobs.size());
+  atomic<size_t> nextJob(0);
+  auto worker = [&]()
+  {
+    for (size_t idx = nextJob++; idx < jobs.size(); idx = nextJob++)
+    {
+      const ExternalJob& job = jobs[idx];
+      try
+      {
+        ProcessOutputTrash trash;
+        IRunProcessCallback* callback = options->quiet ? static_cast<IRunProcessCallback*>(&trash) : collectOutput ? &outputs[idx] : nullptr;
+        Process::Run(job.exe, job.args, callback, &exitCodes[idx], job.workingDirectory.Empty() ? nullptr : job.workingDirectory.GetData());
+      }
+      catch (const exception&)
+      {
+        exceptions[idx] = current_exception();
+      }
+    }
+  };
+  size_t numThreads = std::min<size_t>(jobs.size(), std::max(thread::hardware_concurrency(), 1u));
+  vector<thread> threads;
+  for (size_t idx = 1; idx < numThreads; ++idx)
   {
-    MIKTEX_FATAL_ERROR(T_("MakeIndex failed for some reason."));
+    threads.push_back(thread(worker));
+  }
+  worker();
+  for (thread& t : threads)
+  {
+    t.join();
+  }
+  for (size_t idx = 0; idx < jobs.size(); ++idx)
+  {
+    cout << outputs[idx].GetOutput();
+    if (exceptions[idx] != nullptr)
+    {
+      rethrow_exception(exceptions[idx]);
+    }
+    if (exitCodes[idx] != 0)
+    {
+      MIKTEX_FATAL_ERROR(jobs[idx].failureMessage);
+    }
+  }
+  for (const ExternalJob& job : jobs)
+  {
+    job.onSuccess();
+  }
+}
+
+void Driver::RequirePackages()
+{
+  // the packages are installed in one transaction; otherwise the TeX
+  // engine would install them one at a time, each time it stumbles
+  // over a missing file
+  PathName pathExe;
+  if (!session->FindFile("miktex", FileType::EXE, pathExe))
+  {
+    FatalUtilityError("miktex");
+  }
+  vector<string> arguments{ "miktex" };
+  if (session->IsAdminMode())
+  {
+    arguments.push_back("--admin");
+  }
+  arguments.push_back("packages");
+  arguments.push_back("require");
+  arguments.push_back("--scan-document");
+  arguments.push_back(originalInputFile.ToString());
+  app->Verbose(fmt::format(T_("installing the packages required by {}..."), Q_(givenFileName)));
+  ProcessOutputTrash trash;
+  int exitCode = 0;
+  if (!Process::Run(pathExe, arguments, (options->quiet ? &trash : nullptr), &exitCode, nullptr) || exitCode != 0)
+  {
+    // not fatal: the TeX engine installs missing packages on-the-fly
+    app->Verbose(T_("the required packages could not be installed"));
   }
 }
 
@@ -1529,6 +1835,8 @@ void Driver::RunTeX()
   {
     args.push_back("--quiet");
   }
+  // the recorder file tells which files TeX reads
+  args.push_back("--recorder");
   if (options->batch && !options->quiet)
   {
     args.push_back("--interaction="s + "scrollmode");
@@ -1603,12 +1911,12 @@ bool Driver::Ready()
   // a difference.
   for (const string& aux : auxFiles)
   {
-    PathName auxFile(auxDirectory, PathName(aux));
     app->Verbose(fmt::format(T_("comparing xref file {}..."), Q_(aux)));
     // We only need to keep comparing until we find one that
     // differs, because we'll have to run texindex & tex again no
     // matter how many more there might be.
-    if (!File::Equals(PathName(aux), auxFile))
+    auto it = previousAuxDigests.find(aux);
+    if (it == previousAuxDigests.end() || MD5::FromFile(PathName(aux)) != it->second)
     {
       app->Verbose(fmt::format(T_("xref file {} differed..."), Q_(aux)));
       return false;
@@ -1618,67 +1926,242 @@ bool Driver::Ready()
   return true;
 }
 
-void Driver::InstallOutputFile()
-{
-  const char* ext = options->outputType == OutputType::PDF ? ".pdf" : ".dvi";
-  app->Verbose(fmt::format(T_("copying {} file from {} to {}..."), ext, Q_(workingDirectory), Q_(options->startDirectory)));
-  PathName pathSource(workingDirectory, jobName);
-  pathSource.AppendExtension(ext);
-  PathName pathDest(options->startDirectory, jobName);
-  pathDest.AppendExtension(ext);
-  File::Copy(pathSource, pathDest);
-  if (options->synctex != SyncTeXOption::Disabled)
-  {
-    const char* synctexExt = options->synctex == SyncTeXOption::Compressed ? ".synctex.gz" : ".synctex";
-    PathName pathSyncTeXSource(workingDirectory, jobName);
-    pathSyncTeXSource.AppendExtension(synctexExt);
-    PathName pathSyncTeXDest(options->startDirectory, jobName);
-    pathSyncTeXDest.AppendExtension(synctexExt);
-    File::Copy(pathSyncTeXSource, pathSyncTeXDest);
-  }
-}
-
-void Driver::GetAuxFiles(const PathName& baseName, const char* extension, vector<string>& vec)
-{
-  PathName pattern(baseName);
-  pattern.AppendExtension(extension);
-
-  PathName curDir;
-  curDir.SetToCurrentDirectory();
-
-  app->MyTrace(fmt::format(T_("collecting {} in {}..."), Q_(pattern), Q_(curDir)));
+/* _________________________________________________________________________
 
-  unique_ptr<DirectoryLister> pLister = DirectoryLister::Open(curDir, pattern.GetData());
+   Driver::ReadRecorderFile
 
-  DirectoryEntry2 entry;
+   Get the list of files TeX has read from the recorder file (.fls).
+   Files in TEXMF root directories do not change while we are running.
+   _________________________________________________________________________ */
 
-  while (pLister->GetNext(entry))
+void Driver::ReadRecorderFile()
+{
+  recordedInputs.clear();
+  PathName flsName(jobName);
+  flsName.AppendExtension(".fls");
+  if (!File::Exists(flsName))
   {
-    // If file is empty, skip it.
-    if (entry.isDirectory || entry.size == 0)
+    return;
+  }
+  PathName pwd;
+  pwd.SetToCurrentDirectory();
+  set<string> seen;
+  StreamReader reader(flsName);
+  string line;
+  while (reader.ReadLine(line))
+  {
+    if (IsPrefixOf("PWD ", line))
+    {
+      pwd = line.substr(4);
+      continue;
+    }
+    if (IsPrefixOf("OUTPUT ", line))
+    {
+      PathName path(line.substr(7));
+      if (!path.IsAbsolute())
+      {
+        path = pwd / path;
+      }
+      recordedOutputs.insert(path.ToString());
+      continue;
+    }
+    if (!IsPrefixOf("INPUT ", line))
+    {
+      continue;
+    }
+    PathName path(line.substr(6));
+    if (!path.IsAbsolute())
+    {
+      path = pwd / path;
+    }
+    allRecordedInputs.insert(path.ToString());
+    if (session->TryDeriveTEXMFRoot(path) != INVALID_ROOT_INDEX || !seen.insert(path.ToString()).second)
     {
       continue;
     }
+    recordedInputs.push_back(path.ToString());
+  }
+  reader.Close();
+  app->MyTrace(fmt::format(T_("TeX has read {} local files"), recordedInputs.size()));
+}
 
-    // If the file is not suitable to be an index or xref
-    // file, don't process it.  The file can't be if its
-    // first character is not a backslash or single quote.
-    FileStream stream(File::Open(PathName(entry.name), FileMode::Open, FileAccess::Read));
-    char buf[1];
-    if (stream.Read(buf, 1) == 1 && (buf[0] == '\\' || buf[0] == '\''))
+map<string, MD5> Driver::GetDigests(const vector<string>& fileNames)
+{
+  map<string, MD5> result;
+  for (const string& fileName : fileNames)
+  {
+    // a missing file has no digest: it compares unequal to an existing one
+    if (File::Exists(PathName(fileName)))
     {
-      vec.push_back(entry.name);
+      result[fileName] = MD5::FromFile(PathName(fileName));
     }
-    stream.Close();
   }
+  return result;
 }
 
 /* _________________________________________________________________________
 
-   Driver::GetAuxFiles
+   Driver::InputsUnchanged
 
-   Get list of xref files (indexes, tables and lists).  Find all files
-   having root filename with a two-letter extension, saves the ones
+   Decide if another TeX run would read the same files as the last run.
+   New files (not read by the last run) cannot show up, unless one of
+   the files read has changed.
+   _________________________________________________________________________ */
+
+bool Driver::InputsUnchanged()
+{
+  if (recordedInputs.empty())
+  {
+    return false;
+  }
+  for (const string& fileName : recordedInputs)
+  {
+    auto it = inputDigests.find(fileName);
+    if (it == inputDigests.end() || !File::Exists(PathName(fileName)) || MD5::FromFile(PathName(fileName)) != it->second)
+    {
+      app->Verbose(fmt::format(T_("input file {} has changed..."), Q_(fileName)));
+      return false;
+    }
+  }
+  return true;
+}
+
+/* _________________________________________________________________________
+
+   Driver::GetBibTeXInputDigest
+
+   Calculate a digest of what BibTeX reads: the \citation, \bibdata and
+   \bibstyle lines of the aux file (and of the aux files it includes)
+   and the bibliography database and style files.
+   _________________________________________________________________________ */
+
+MD5 Driver::GetBibTeXInputDigest(const PathName& auxName)
+{
+  MD5Builder md5Builder;
+  vector<PathName> auxFiles{ auxName };
+  for (size_t idx = 0; idx < auxFiles.size(); ++idx)
+  {
+    if (!File::Exists(auxFiles[idx]))
+    {
+      continue;
+    }
+    StreamReader reader(auxFiles[idx]);
+    string line;
+    while (reader.ReadLine(line))
+    {
+      if (IsPrefixOf("\\@input{", line) && line.back() == '}' && idx == 0)
+      {
+        auxFiles.push_back(PathName(line.substr(8, line.length() - 9)));
+        continue;
+      }
+      bool isBibData = IsPrefixOf("\\bibdata{", line);
+      bool isBibStyle = IsPrefixOf("\\bibstyle{", line);
+      if (!(isBibData || isBibStyle || IsPrefixOf("\\citation{", line)))
+      {
+        continue;
+      }
+      md5Builder.Update(line.c_str(), line.length() + 1);
+      if (!(isBibData || isBibStyle) || line.back() != '}')
+      {
+        continue;
+      }
+      string names = line.substr(line.find('{') + 1);
+      names.pop_back();
+      for (const string& name : StringUtil::Split(names, ','))
+      {
+        PathName path;
+        if (session->FindFile(name, isBibData ? FileType::BIB : FileType::BST, path))
+        {
+          bibtexInputs.insert(path.ToString());
+          MD5 digest = MD5::FromFile(path);
+          md5Builder.Update(digest.data(), digest.size());
+        }
+      }
+    }
+    reader.Close();
+  }
+  return md5Builder.Final();
+}
+
+/* _________________________________________________________________________
+
+   Driver::GetWatchedFiles
+
+   Get the files which, when changed, require another build: the input
+   file and the files TeX has read in the last run.
+   _________________________________________________________________________ */
+
+vector<PathName> Driver::GetWatchedFiles() const
+{
+  vector<PathName> result{ pathInputFile };
+  for (const string& fileName : recordedInputs)
+  {
+    result.push_back(PathName(fileName));
+  }
+  return result;
+}
+
+void Driver::InstallOutputFile()
+{
+  const char* ext = options->outputType == OutputType::PDF ? ".pdf" : ".dvi";
+  app->Verbose(fmt::format(T_("copying {} file from {} to {}..."), ext, Q_(workingDirectory), Q_(options->startDirectory)));
+  PathName pathSource(workingDirectory, jobName);
+  pathSource.AppendExtension(ext);
+  PathName pathDest(options->startDirectory, jobName);
+  pathDest.AppendExtension(ext);
+  File::Copy(pathSource, pathDest);
+  if (options->synctex != SyncTeXOption::Disabled)
+  {
+    const char* synctexExt = options->synctex == SyncTeXOption::Compressed ? ".synctex.gz" : ".synctex";
+    PathName pathSyncTeXSource(workingDirectory, jobName);
+    pathSyncTeXSource.AppendExtension(synctexExt);
+    PathName pathSyncTeXDest(options->startDirectory, jobName);
+    pathSyncTeXDest.AppendExtension(synctexExt);
+    File::Copy(pathSyncTeXSource, pathSyncTeXDest);
+  }
+}
+
+void Driver::GetAuxFiles(const PathName& baseName, const char* extension, vector<string>& vec)
+{
+  PathName pattern(baseName);
+  pattern.AppendExtension(extension);
+
+  PathName curDir;
+  curDir.SetToCurrentDirectory();
+
+  app->MyTrace(fmt::format(T_("collecting {} in {}..."), Q_(pattern), Q_(curDir)));
+
+  unique_ptr<DirectoryLister> pLister = DirectoryLister::Open(curDir, pattern.GetData());
+
+  DirectoryEntry2 entry;
+
+  while (pLister->GetNext(entry))
+  {
+    // If file is empty, skip it.
+    if (entry.isDirectory || entry.size == 0)
+    {
+      continue;
+    }
+
+    // If the file is not suitable to be an index or xref
+    // file, don't process it.  The file can't be if its
+    // first character is not a backslash or single quote.
+    FileStream stream(File::Open(PathName(entry.name), FileMode::Open, FileAccess::Read));
+    char buf[1];
+    if (stream.Read(buf, 1) == 1 && (buf[0] == '\\' || buf[0] == '\''))
+    {
+      vec.push_back(entry.name);
+    }
+    stream.Close();
+  }
+}
+
+/* _________________________________________________________________________
+
+   Driver::GetAuxFiles
+
+   Get list of xref files (indexes, tables and lists).  Find all files
+   having root filename with a two-letter extension, saves the ones
    that are really Texinfo-related files.  .?o? catches LaTeX tables
    and lists.
    _________________________________________________________________________ */
@@ -1720,6 +2203,394 @@ void Driver::GetAuxFiles(vector<string>& auxFiles, vector<string>* idxFiles)
   sort(auxFiles.begin(), auxFiles.end());
 }
 
+/* _________________________________________________________________________
+
+   The result cache
+
+   With --result-cache=DIR, the results of a build (DVI/PDF file,
+   SyncTeX file and, if not in clean mode, the .aux and .log files) are
+   kept in DIR and restored by the next build with the same key, if
+   none of the inputs has changed:
+
+     DIR/entries/KEY       inputs and results of the build
+     DIR/objects/DIGEST    the contents of a result file
+
+   The key covers the TeX engine, the format, the package database and
+   the texify options.  An entry lists the digests of all files TeX and
+   BibTeX have read and of the names in the local input directories (a
+   new file might be found instead of an old one):
+
+     INPUT DIGEST PATH
+     DIRECTORY DIGEST PATH
+     OUTPUT DIGEST FILENAME
+
+   Paths below the start directory are relative, so that the cache can
+   be shared by several checkouts of a document.  The entry is written
+   last, so that it never refers to a missing object.
+   _________________________________________________________________________ */
+
+static MD5 GetDirectoryDigest(const PathName& directory, time_t writtenSince, const vector<string>& ignoredNames)
+{
+  vector<string> names;
+  for (const DirectoryEntry& entry : DirectoryLister::ReadDirectory(directory, nullptr, (int)DirectoryLister::Options::None))
+  {
+    if (std::find(ignoredNames.begin(), ignoredNames.end(), entry.name) != ignoredNames.end())
+    {
+      continue;
+    }
+    // files written by the build did not exist when the build started
+    if (writtenSince != 0 && !entry.isDirectory && File::GetLastWriteTime(directory / PathName(entry.name)) >= writtenSince)
+    {
+      continue;
+    }
+    names.push_back(entry.name);
+  }
+  sort(names.begin(), names.end());
+  MD5Builder md5Builder;
+  for (const string& name : names)
+  {
+    md5Builder.Update(name.c_str(), name.length() + 1);
+  }
+  return md5Builder.Final();
+}
+
+vector<string> Driver::GetResultFileNames()
+{
+  vector<string> result;
+  result.push_back(jobName.ToString() + (options->outputType == OutputType::PDF ? ".pdf" : ".dvi"));
+  if (options->synctex != SyncTeXOption::Disabled)
+  {
+    result.push_back(jobName.ToString() + (options->synctex == SyncTeXOption::Compressed ? ".synctex.gz" : ".synctex"));
+  }
+  // in clean mode, only the DVI/PDF and SyncTeX files are installed
+  if (!options->clean)
+  {
+    result.push_back(jobName.ToString() + ".aux");
+    result.push_back(jobName.ToString() + ".log");
+  }
+  return result;
+}
+
+/* _________________________________________________________________________
+
+   Driver::GetResultCacheKey
+
+   Calculate the key of the result cache entry.  Returns an empty
+   string, if the results of this build cannot be cached.
+   _________________________________________________________________________ */
+
+string Driver::GetResultCacheKey()
+{
+  if (options->expand)
+  {
+    app->Verbose(T_("makeinfo reads files which are not recorded: not using the result cache"));
+    return "";
+  }
+
+  // the results of a build depend on the auxiliary files of the last
+  // build; only builds from scratch are cached
+  PathName auxName(jobName);
+  auxName.AppendExtension(".aux");
+  if (!options->clean && File::Exists(auxName))
+  {
+    app->Verbose(fmt::format(T_("{} exists: not using the result cache"), Q_(auxName)));
+    return "";
+  }
+
+  MD5Builder md5Builder;
+  auto add = [&md5Builder](const string& s) { md5Builder.Update(s.c_str(), s.length() + 1); };
+
+  add(MIKTEX_COMPONENT_VERSION_STR);
+
+  string exeName;
+  PathName pathExe = GetTeXEnginePath(exeName);
+  add(exeName);
+  add(MD5::FromFile(pathExe).ToString());
+
+  // the format will be made by the first run, if it does not exist
+  FormatInfo formatInfo;
+  string formatDigest;
+  if (session->TryGetFormatInfo(exeName, formatInfo))
+  {
+    for (SpecialPath root : { SpecialPath::UserDataRoot, SpecialPath::CommonDataRoot })
+    {
+      PathName formatFile = session->GetSpecialPath(root) / PathName(MIKTEX_PATH_FMT_DIR) / PathName(formatInfo.compiler) / PathName(formatInfo.key);
+      formatFile.AppendExtension(".fmt");
+      if (File::Exists(formatFile))
+      {
+        formatDigest = MD5::FromFile(formatFile).ToString();
+        break;
+      }
+    }
+  }
+  add(formatDigest);
+
+  // installed packages can provide files which the document looks for
+  for (SpecialPath root : { SpecialPath::CommonInstallRoot, SpecialPath::UserInstallRoot })
+  {
+    PathName packagesIni = session->GetSpecialPath(root) / PathName(MIKTEX_PATH_PACKAGES_INI);
+    add(File::Exists(packagesIni) ? MD5::FromFile(packagesIni).ToString() : "");
+  }
+
+  for (const string& program : { options->bibtexProgram, options->makeindexProgram })
+  {
+    PathName path;
+    add(session->FindFile(program, FileType::EXE, path) ? MD5::FromFile(path).ToString() : "");
+  }
+
+  add(givenFileName.ToString());
+  add(jobName.ToString());
+  add(std::to_string(static_cast<int>(macroLanguage)));
+  add(std::to_string(static_cast<int>(options->outputType)));
+  add(std::to_string(static_cast<int>(options->synctex)));
+  add(std::to_string(options->maxIterations));
+  add(options->clean ? "clean" : "");
+  add(options->batch ? "batch" : "");
+#if defined(SUPPORT_OPT_SRC_SPECIALS)
+  add(options->sourceSpecials ? "src-specials=" + options->sourceSpecialsWhere : "");
+#endif
+  for (const string& dir : options->includeDirectories)
+  {
+    add("include=" + dir);
+  }
+  for (const string& opt : options->texOptions)
+  {
+    add("tex-option=" + opt);
+  }
+  for (const string& opt : options->makeindexOptions)
+  {
+    add("mkidx-option=" + opt);
+  }
+#if defined(WITH_TEXINFO)
+  for (const string& cmd : options->texinfoCommands)
+  {
+    add("texinfo=" + cmd);
+  }
+#endif
+
+  return md5Builder.Final().ToString();
+}
+
+/* _________________________________________________________________________
+
+   Driver::TryRestoreResults
+
+   Restore the results of an earlier build, if all its inputs are
+   unchanged.
+   _________________________________________________________________________ */
+
+bool Driver::TryRestoreResults(const string& key)
+{
+  PathName entryFile = options->resultCacheDirectory / PathName("entries") / PathName(key);
+  if (!File::Exists(entryFile))
+  {
+    app->Verbose(T_("no results in the result cache"));
+    return false;
+  }
+  try
+  {
+    vector<pair<string, MD5>> outputs;
+    StreamReader reader(entryFile);
+    string line;
+    while (reader.ReadLine(line))
+    {
+      size_t pos1 = line.find(' ');
+      size_t pos2 = pos1 == string::npos ? string::npos : line.find(' ', pos1 + 1);
+      if (pos2 == string::npos)
+      {
+        app->Verbose(fmt::format(T_("ignoring bad result cache entry {}"), Q_(entryFile)));
+        return false;
+      }
+      string kind = line.substr(0, pos1);
+      MD5 digest = MD5::Parse(line.substr(pos1 + 1, pos2 - pos1 - 1));
+      PathName path(line.substr(pos2 + 1));
+      if (kind == "OUTPUT")
+      {
+        outputs.push_back({ path.ToString(), digest });
+        continue;
+      }
+      if (!path.IsAbsolute())
+      {
+        path = options->startDirectory / path;
+      }
+      if (kind == "INPUT")
+      {
+        if (!File::Exists(path) || MD5::FromFile(path) != digest)
+        {
+          app->Verbose(fmt::format(T_("input file {} has changed: not using cached results"), Q_(path)));
+          return false;
+        }
+      }
+      else if (kind == "DIRECTORY")
+      {
+        if (!Directory::Exists(path) || GetDirectoryDigest(path, 0, GetResultFileNames()) != digest)
+        {
+          app->Verbose(fmt::format(T_("directory {} has changed: not using cached results"), Q_(path)));
+          return false;
+        }
+      }
+      else
+      {
+        app->Verbose(fmt::format(T_("ignoring bad result cache entry {}"), Q_(entryFile)));
+        return false;
+      }
+    }
+    reader.Close();
+    if (outputs.empty())
+    {
+      return false;
+    }
+    // all objects are checked before a result file is touched
+    PathName objectsDirectory = options->resultCacheDirectory / PathName("objects");
+    for (const auto& output : outputs)
+    {
+      PathName objectFile = objectsDirectory / PathName(output.second.ToString());
+      if (!File::Exists(objectFile) || MD5::FromFile(objectFile) != output.second)
+      {
+        app->Verbose(fmt::format(T_("cached result {} is missing or damaged"), Q_(objectFile)));
+        return false;
+      }
+    }
+    for (const auto& output : outputs)
+    {
+      PathName dest = options->startDirectory / PathName(output.first);
+      app->Verbose(fmt::format(T_("restoring {} from the result cache..."), Q_(dest)));
+      File::Copy(objectsDirectory / PathName(output.second.ToString()), dest);
+    }
+    return true;
+  }
+  catch (const MiKTeXException& e)
+  {
+    // not fatal: the document will be compiled
+    app->Verbose(fmt::format(T_("cached results could not be restored: {}"), e.GetErrorMessage()));
+    return false;
+  }
+}
+
+/* _________________________________________________________________________
+
+   Driver::StoreResults
+
+   Put the results of this build into the result cache.
+   _________________________________________________________________________ */
+
+void Driver::StoreResults(const string& key)
+{
+  if (!asyDigests.empty())
+  {
+    app->Verbose(T_("Asymptote reads files which are not recorded: the results are not cached"));
+    return;
+  }
+
+  PathName curDir;
+  curDir.SetToCurrentDirectory();
+
+  // relative paths for files below the start directory
+  auto relativize = [this](const PathName& path) {
+    const char* relPath = Utils::GetRelativizedPath(path.GetData(), options->startDirectory.GetData());
+    return relPath != nullptr && *relPath != 0 ? string(relPath) : path.ToString();
+  };
+
+  set<string> inputs(allRecordedInputs);
+  inputs.insert(bibtexInputs.begin(), bibtexInputs.end());
+  for (const string& opt : options->makeindexOptions)
+  {
+    PathName path;
+    if (session->FindFile(opt, FileType::IST, path))
+    {
+      inputs.insert(path.ToString());
+    }
+  }
+
+  vector<string> lines;
+  set<string> directories{ options->startDirectory.ToString(), originalInputDirectory.ToString() };
+  directories.insert(options->includeDirectories.begin(), options->includeDirectories.end());
+
+  try
+  {
+    for (const string& fileName : inputs)
+    {
+      PathName path(fileName);
+      PathName dir(path);
+      dir.RemoveFileSpec();
+      // auxiliary files are written by TeX (recorded) or by BibTeX and the
+      // index generator (JOBNAME.*)
+      bool isGenerated = recordedOutputs.find(fileName) != recordedOutputs.end()
+        || (dir == curDir && IsPrefixOf((jobName.ToString() + ".").c_str(), path.GetFileName().ToString()));
+      if (!File::Exists(path) || File::GetLastWriteTime(path) >= buildStartTime)
+      {
+        if (isGenerated)
+        {
+          continue;
+        }
+        app->Verbose(fmt::format(T_("input file {} has changed during the build: the results are not cached"), Q_(path)));
+        return;
+      }
+      lines.push_back("INPUT " + MD5::FromFile(path).ToString() + " " + relativize(path));
+      if (session->TryDeriveTEXMFRoot(path) == INVALID_ROOT_INDEX)
+      {
+        directories.insert(dir.ToString());
+      }
+    }
+
+    for (const string& dir : directories)
+    {
+      PathName path(dir);
+      if (!path.IsAbsolute())
+      {
+        path = options->startDirectory / path;
+      }
+      if (Directory::Exists(path))
+      {
+        lines.push_back("DIRECTORY " + GetDirectoryDigest(path, buildStartTime, GetResultFileNames()).ToString() + " " + relativize(path));
+      }
+    }
+
+    PathName objectsDirectory = options->resultCacheDirectory / PathName("objects");
+    for (const string& fileName : GetResultFileNames())
+    {
+      PathName path(fileName);
+      if (!File::Exists(path))
+      {
+        continue;
+      }
+      MD5 digest = MD5::FromFile(path);
+      PathName objectFile = objectsDirectory / PathName(digest.ToString());
+      if (!File::Exists(objectFile))
+      {
+        Directory::Create(objectsDirectory);
+        PathName tmpPath = objectFile;
+        tmpPath.AppendExtension(".tmp");
+        unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create(tmpPath);
+        File::Copy(path, tmpPath);
+        File::Move(tmpPath, objectFile, { FileMoveOption::ReplaceExisting });
+        tmpFile->Keep();
+      }
+      lines.push_back("OUTPUT " + digest.ToString() + " " + fileName);
+    }
+
+    PathName entryFile = options->resultCacheDirectory / PathName("entries") / PathName(key);
+    Directory::Create(entryFile.GetDirectoryName());
+    PathName tmpPath = entryFile;
+    tmpPath.AppendExtension(".tmp");
+    unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create(tmpPath);
+    StreamWriter writer(tmpPath);
+    for (const string& line : lines)
+    {
+      writer.WriteLine(line);
+    }
+    writer.Close();
+    File::Move(tmpPath, entryFile, { FileMoveOption::ReplaceExisting });
+    tmpFile->Keep();
+    app->Verbose(fmt::format(T_("the results have been put into the result cache ({} inputs)"), inputs.size()));
+  }
+  catch (const MiKTeXException& e)
+  {
+    // not fatal: the cache directory may be read-only
+    app->Verbose(fmt::format(T_("the results could not be cached: {}"), e.GetErrorMessage()));
+  }
+}
+
 void Driver::RunViewer()
 {
   const char* ext = options->outputType == OutputType::PDF ? ".pdf" : ".dvi";
@@ -1776,6 +2647,28 @@ void Driver::Run()
     Directory::SetCurrent(workingDirectory);
   }
 
+  buildStartTime = time(nullptr);
+
+  string resultCacheKey;
+  if (!options->resultCacheDirectory.Empty())
+  {
+    resultCacheKey = GetResultCacheKey();
+    if (!resultCacheKey.empty() && TryRestoreResults(resultCacheKey))
+    {
+      app->Verbose(T_("the results have been taken from the result cache"));
+      if (options->runViewer)
+      {
+        RunViewer();
+      }
+      return;
+    }
+  }
+
+  if (options->prescan && macroLanguage == MacroLanguage::LaTeX)
+  {
+    RequirePackages();
+  }
+
   for (int i = 0; i < options->maxIterations; ++i)
   {
     app->CheckCancel();
@@ -1783,23 +2676,39 @@ void Driver::Run()
     GetAuxFiles(previousAuxFiles, &idxFiles);
     if (!previousAuxFiles.empty())
     {
-      app->Verbose(fmt::format(T_("backing up xref files: {}"), FlattenStringVector(previousAuxFiles, ' ')));
-      CopyFiles(previousAuxFiles, auxDirectory);
+      app->Verbose(fmt::format(T_("remembering xref files: {}"), FlattenStringVector(previousAuxFiles, ' ')));
     }
-    RunBibTeX();
+    previousAuxDigests = GetDigests(previousAuxFiles);
+    vector<ExternalJob> jobs;
+    ScheduleBibTeX(jobs);
     if (idxFiles.size() > 0)
     {
-      app->CheckCancel();
-      RunIndexGenerator(idxFiles);
+      ScheduleIndexGenerator(idxFiles, jobs);
     }
+    ScheduleAsymptote(jobs);
+    RunJobs(jobs);
     app->CheckCancel();
+    // TeX has not read the new figures yet: they are not recorded inputs
+    if (!haveNewFigures && InputsUnchanged())
+    {
+      app->Verbose(T_("TeX would read the same files again: not running TeX"));
+      break;
+    }
+    inputDigests = GetDigests(recordedInputs);
+    haveNewFigures = false;
     RunTeX();
+    ReadRecorderFile();
     if (Ready())
     {
       break;
     }
   }
 
+  if (!resultCacheKey.empty())
+  {
+    StoreResults(resultCacheKey);
+  }
+
   // If we were in clean mode, compilation was in a tmp directory.
   // Copy the DVI (or PDF) file into the directory where the
   // compilation has been done.  (The temp dir is about to get removed
@@ -1827,13 +2736,17 @@ enum CommandLineOptions {
   OPT_DEBUG,
   OPT_ENGINE,
   OPT_EXPAND,
+  OPT_FILE_LIST,
   OPT_INCLUDE,
   OPT_JOB_NAME,
+  OPT_JOBS,
   OPT_LANGUAGE,
   OPT_MAX_ITER,
   OPT_MKIDX_OPTION,
   OPT_PDF,
+  OPT_PRESCAN,
   OPT_QUIET,
+  OPT_RESULT_CACHE,
   OPT_RUN_VIEWER,
 #if defined(SUPPORT_OPT_SRC_SPECIALS)
   OPT_SRC,
@@ -1848,6 +2761,7 @@ enum CommandLineOptions {
   OPT_VERBOSE,
   OPT_VERSION,
   OPT_VIEWER_OPTION,
+  OPT_WATCH,
 };
 
 const struct poptOption optionTable[] = {
@@ -1938,6 +2852,14 @@ const struct poptOption optionTable[] = {
     nullptr,
   },
 
+  {
+    "prescan", 0,
+    POPT_ARG_NONE, nullptr,
+    OPT_PRESCAN,
+    T_("Install the packages required by FILE in one go, before running the TeX engine."),
+    nullptr,
+  },
+
   {
     "quiet", 'q',
     POPT_ARG_NONE, nullptr,
@@ -1983,6 +2905,22 @@ const struct poptOption optionTable[] = {
 
   // --- now the MiKTeX extensions
 
+  {
+    "file-list", 0,
+    POPT_ARG_STRING, nullptr,
+    OPT_FILE_LIST,
+    T_("Compile the documents listed in FILE (one file name per line) and print a summary."),
+    T_("FILE"),
+  },
+
+  {
+    "jobs", 0,
+    POPT_ARG_STRING, nullptr,
+    OPT_JOBS,
+    T_("Compile up to N documents at a time."),
+    "N",
+  },
+
   {
     "max-iterations", 0,
     POPT_ARG_STRING, nullptr,
@@ -2017,6 +2955,14 @@ const struct poptOption optionTable[] = {
   },
 #endif
 
+  {
+    "result-cache", 0,
+    POPT_ARG_STRING, nullptr,
+    OPT_RESULT_CACHE,
+    T_("Keep the results in DIR and take them from there, if no input file has changed."),
+    T_("DIR"),
+  },
+
   {
     "synctex", 0,
     POPT_ARG_STRING | POPT_ARGFLAG_OPTIONAL, nullptr,
@@ -2057,10 +3003,214 @@ const struct poptOption optionTable[] = {
     T_("OPTION"),
   },
 
+  {
+    "watch", 0,
+    POPT_ARG_NONE, nullptr,
+    OPT_WATCH,
+    T_("Build again whenever an input file changes."),
+    nullptr,
+  },
+
   POPT_AUTOHELP
   POPT_TABLEEND
 };
 
+/* _________________________________________________________________________
+
+   McdApp::RunBatch
+
+   Compile many documents.  Documents are compiled one after another
+   in this process, sharing the session.  If more than one job is
+   requested, each document is compiled by a texify child process,
+   because a driver changes the current directory and the input
+   directories of the session.  A tab-separated summary line (status,
+   exit code, milliseconds, file name) is printed for each document.
+   _________________________________________________________________________ */
+
+struct BatchResult
+{
+  int exitCode = 0;
+  chrono::steady_clock::duration time = chrono::steady_clock::duration::zero();
+};
+
+/* _________________________________________________________________________
+
+   McdApp::Watch
+
+   Build a document, then wait for changes of the files TeX has read
+   and build again.  The driver is kept, so that the next build only
+   runs what is needed (see Driver::InputsUnchanged()).
+   _________________________________________________________________________ */
+
+class WatchCallback :
+  public FileSystemWatcherCallback
+{
+public:
+  WatchCallback(const vector<PathName>& files) :
+    files(files)
+  {
+  }
+
+public:
+  void MIKTEXTHISCALL OnChange(const FileSystemChangeEvent& ev) override
+  {
+    if (ev.action != FileSystemChangeAction::Removed && find(files.begin(), files.end(), ev.fileName) != files.end())
+    {
+      changedFile = ev.fileName.ToString();
+      changed = true;
+    }
+  }
+
+public:
+  atomic<bool> changed{ false };
+
+public:
+  string changedFile;
+
+private:
+  vector<PathName> files;
+};
+
+void McdApp::Watch(const string& fileName)
+{
+  if (!File::Exists(PathName(fileName)))
+  {
+    FatalError(T_("The input file could not be found."));
+  }
+  Driver driver;
+  driver.Initialize(this, &options, fileName.c_str());
+  while (true)
+  {
+    try
+    {
+      driver.Run();
+    }
+    catch (const MiKTeXException& ex)
+    {
+      Sorry(THE_NAME_OF_THE_GAME, ex);
+    }
+    catch (int)
+    {
+    }
+    // a running viewer reloads the output file
+    options.runViewer = false;
+    vector<PathName> files = driver.GetWatchedFiles();
+    vector<PathName> directories;
+    for (const PathName& file : files)
+    {
+      PathName dir = file.GetDirectoryName();
+      if (find(directories.begin(), directories.end(), dir) == directories.end())
+      {
+        directories.push_back(dir);
+      }
+    }
+    WatchCallback callback(files);
+    unique_ptr<FileSystemWatcher> fsWatcher = FileSystemWatcher::Create();
+    fsWatcher->AddDirectories(directories);
+    fsWatcher->Subscribe(&callback);
+    fsWatcher->Start();
+    Verbose(fmt::format(T_("watching {} files..."), files.size()));
+    while (!callback.changed)
+    {
+      CheckCancel();
+      this_thread::sleep_for(chrono::milliseconds(200));
+    }
+    // an editor might save several files
+    this_thread::sleep_for(chrono::milliseconds(200));
+    fsWatcher->Stop();
+    fsWatcher->Unsubscribe(&callback);
+    Verbose(fmt::format(T_("{} has changed..."), Q_(callback.changedFile)));
+  }
+}
+
+int McdApp::RunBatch(const vector<string>& fileNames, const vector<string>& childArgs, int numJobs)
+{
+  vector<BatchResult> results(fileNames.size());
+  if (numJobs <= 1)
+  {
+    for (size_t idx = 0; idx < fileNames.size(); ++idx)
+    {
+      auto start = chrono::steady_clock::now();
+      Verbose(fmt::format(T_("processing {}..."), Q_(fileNames[idx])));
+      try
+      {
+        if (!File::Exists(PathName(fileNames[idx])))
+        {
+          FatalError(T_("The input file could not be found."));
+        }
+        Driver driver;
+        driver.Initialize(this, &options, fileNames[idx].c_str());
+        driver.Run();
+      }
+      catch (const MiKTeXException& ex)
+      {
+        Sorry(THE_NAME_OF_THE_GAME, ex);
+        results[idx].exitCode = 1;
+      }
+      catch (int exitCode)
+      {
+        results[idx].exitCode = exitCode == 0 ? 1 : exitCode;
+      }
+      results[idx].time = chrono::steady_clock::now() - start;
+    }
+  }
+  else
+  {
+    PathName myExe = GetSession()->GetMyProgramFile(true);
+    atomic<size_t> nextFile(0);
+    mutex outputMutex;
+    auto worker = [&]()
+    {
+      for (size_t idx = nextFile++; idx < fileNames.size(); idx = nextFile++)
+      {
+        vector<string> args{ PROGRAM_NAME };
+        args.insert(args.end(), childArgs.begin(), childArgs.end());
+        // nobody could answer the questions of several TeX runs
+        args.push_back("--batch");
+        args.push_back(fileNames[idx]);
+        auto start = chrono::steady_clock::now();
+        ProcessOutputSaver output;
+        int exitCode = 0;
+        try
+        {
+          if (!Process::Run(myExe, args, &output, &exitCode, nullptr))
+          {
+            exitCode = 1;
+          }
+        }
+        catch (const exception&)
+        {
+          exitCode = 1;
+        }
+        results[idx].exitCode = exitCode;
+        results[idx].time = chrono::steady_clock::now() - start;
+        lock_guard<mutex> lockGuard(outputMutex);
+        cout << output.GetOutput() << flush;
+      }
+    };
+    vector<thread> threads;
+    for (int idx = 1; idx < std::min<int>(numJobs, static_cast<int>(fileNames.size())); ++idx)
+    {
+      threads.push_back(thread(worker));
+    }
+    worker();
+    for (thread& t : threads)
+    {
+      t.join();
+    }
+  }
+  int failed = 0;
+  for (size_t idx = 0; idx < fileNames.size(); ++idx)
+  {
+    cout << fmt::format("{}\t{}\t{}\t{}", results[idx].exitCode == 0 ? "ok" : "failed", results[idx].exitCode, chrono::duration_cast<chrono::milliseconds>(results[idx].time).count(), fileNames[idx]) << "\n";
+    if (results[idx].exitCode != 0)
+    {
+      ++failed;
+    }
+  }
+  return failed == 0 ? 0 : 1;
+}
+
 void McdApp::Run(int argc, const char** argv)
 {
 #if defined(MIKTEX_WINDOWS)
@@ -2077,9 +3227,26 @@ void McdApp::Run(int argc, const char** argv)
 
   bool optVersion = false;
 
+  string fileList;
+  int numJobs = 1;
+
+  // the options for texify child processes (see RunBatch())
+  vector<string> childArgs;
+
   while ((option = popt.GetNextOpt()) >= 0)
   {
     string optArg = popt.GetOptArg();
+    if (option != OPT_FILE_LIST && option != OPT_JOBS)
+    {
+      for (const poptOption* opt = optionTable; opt->longName != nullptr; ++opt)
+      {
+        if (opt->val == option)
+        {
+          childArgs.push_back(optArg.empty() ? "--"s + opt->longName : "--"s + opt->longName + "=" + optArg);
+          break;
+        }
+      }
+    }
     switch (option)
     {
 #if defined(WITH_TEXINFO)
@@ -2141,6 +3308,9 @@ void McdApp::Run(int argc, const char** argv)
     case OPT_PDF:
       options.outputType = OutputType::PDF;
       break;
+    case OPT_PRESCAN:
+      options.prescan = true;
+      break;
     case OPT_QUIET:
       options.quiet = true;
       options.batch = true;
@@ -2209,6 +3379,19 @@ void McdApp::Run(int argc, const char** argv)
     case OPT_MAX_ITER:
       options.maxIterations = std::stoi(optArg);
       break;
+    case OPT_WATCH:
+      options.watch = true;
+      break;
+    case OPT_RESULT_CACHE:
+      options.resultCacheDirectory = optArg;
+      options.resultCacheDirectory.MakeFullyQualified();
+      break;
+    case OPT_FILE_LIST:
+      fileList = optArg;
+      break;
+    case OPT_JOBS:
+      numJobs = std::stoi(optArg);
+      break;
     case OPT_TRACE:
       if (optArg.empty())
       {
@@ -2232,7 +3415,7 @@ void McdApp::Run(int argc, const char** argv)
 
   vector<string> leftovers = popt.GetLeftovers();
 
-  if (leftovers.empty() && !optVersion)
+  if (leftovers.empty() && fileList.empty() && !optVersion)
   {
     FatalError(T_("Missing file argument."));
   }
@@ -2250,6 +3433,38 @@ void McdApp::Run(int argc, const char** argv)
     return;
   }
 
+  if (options.watch)
+  {
+    if (leftovers.size() != 1 || !fileList.empty())
+    {
+      FatalError(T_("--watch needs exactly one file argument."));
+    }
+    Watch(leftovers[0]);
+    return;
+  }
+
+  if (!fileList.empty())
+  {
+    vector<string> fileNames(leftovers);
+    StreamReader reader{ PathName(fileList) };
+    string line;
+    while (reader.ReadLine(line))
+    {
+      if (!line.empty())
+      {
+        fileNames.push_back(line);
+      }
+    }
+    reader.Close();
+    int exitCode = RunBatch(fileNames, childArgs, numJobs);
+    Finalize2(exitCode);
+    if (exitCode != 0)
+    {
+      throw exitCode;
+    }
+    return;
+  }
+
   for (const string& fileName : leftovers)
   {
     Verbose(fmt::format(T_("processing {}..."), Q_(fileName)));
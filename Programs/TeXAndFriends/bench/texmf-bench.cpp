@@ -0,0 +1,502 @@
+/* texmf-bench.cpp: runs the TeX engines and DVI drivers over a corpus
+
+   Copyright (C) 2023 Christian Schenk
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.  */
+
+#include <cstdlib>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#  include <Windows.h>
+#  include <psapi.h>
+#else
+#  include <fcntl.h>
+#  include <sys/resource.h>
+#  include <sys/types.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <nlohmann/json.hpp>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/File>
+#include <miktex/Core/Session>
+#include <miktex/Core/Utils>
+#include <miktex/Util/PathName>
+#include <miktex/Util/PathNameUtil>
+#include <miktex/Util/StringUtil>
+#include <miktex/Wrappers/PoptWrapper>
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+using namespace MiKTeX::Wrappers;
+using namespace std;
+
+/*
+ * texmf-bench runs a fixed set of jobs over the documents of the corpus
+ * and writes a JSON report.  For every step of a job (an engine or a
+ * driver run), it records the wall-clock time, the CPU time and the
+ * peak resident set size of the process; for the TeX engines, the job
+ * statistics written by --stats (time spent in each phase, file
+ * searches, memory arrays) are included as well.
+ *
+ * The programs are found in the PATH, or in the directory given with
+ * --bin-dir.  The packages needed by the corpus (beamer, pgf, biblatex,
+ * xecjk, luatexja, ...) must be installed, or the on-the-fly installer
+ * must be enabled; by default, each job is run once before measuring,
+ * so that package and format installation is not measured.
+ */
+
+enum {
+  OPT_AAA = 1234,
+  OPT_BIN_DIR,
+  OPT_CORPUS_DIR,
+  OPT_FILTER,
+  OPT_NO_WARM_UP,
+  OPT_OUTPUT,
+  OPT_REPETITIONS,
+  OPT_WORK_DIR,
+};
+
+static const struct poptOption long_options[] = {
+  {
+    "bin-dir", 0, POPT_ARG_STRING, nullptr, OPT_BIN_DIR, "Runs the programs in DIR.", "DIR"
+  },
+  {
+    "corpus-dir", 0, POPT_ARG_STRING, nullptr, OPT_CORPUS_DIR, "Takes the documents from DIR.", "DIR"
+  },
+  {
+    "filter", 0, POPT_ARG_STRING, nullptr, OPT_FILTER, "Runs only the jobs whose name starts with PREFIX.", "PREFIX"
+  },
+  {
+    "no-warm-up", 0, POPT_ARG_NONE, nullptr, OPT_NO_WARM_UP, "Measures the first run of each job.", nullptr
+  },
+  {
+    "output", 0, POPT_ARG_STRING, nullptr, OPT_OUTPUT, "Writes the report to FILE.", "FILE"
+  },
+  {
+    "repetitions", 0, POPT_ARG_STRING, nullptr, OPT_REPETITIONS, "Runs each job N times.", "N"
+  },
+  {
+    "work-dir", 0, POPT_ARG_STRING, nullptr, OPT_WORK_DIR, "Runs the jobs in DIR.", "DIR"
+  },
+  POPT_AUTOHELP
+  POPT_TABLEEND
+};
+
+struct Step
+{
+  string program;
+  vector<string> arguments;
+  // the program understands --stats (TeXMFApp)
+  bool withStats;
+};
+
+struct Job
+{
+  string name;
+  vector<Step> steps;
+};
+
+static Step LaTeX(const string& engine, const string& document, bool withStats = true)
+{
+  return Step{ engine, { "--interaction=batchmode", "--halt-on-error", document + ".tex" }, withStats };
+}
+
+static vector<Job> MakeJobs()
+{
+  vector<Job> jobs;
+  for (const string document : { "article", "book" })
+  {
+    jobs.push_back({ document + "/pdftex"s, { LaTeX("pdflatex", document) } });
+    jobs.push_back({ document + "/xetex"s, { LaTeX("xelatex", document) } });
+    // LuaTeX is not a TeXMFApp: no --stats
+    jobs.push_back({ document + "/luatex"s, { LaTeX("lualatex", document, false) } });
+    jobs.push_back({ document + "/dvips"s, { LaTeX("latex", document), { "dvips", { "-q", "-o", document + ".ps", document + ".dvi" }, false } } });
+    jobs.push_back({ document + "/dvipdfmx"s, { LaTeX("latex", document), { "dvipdfmx", { "-q", document + ".dvi" }, false } } });
+  }
+  jobs.push_back({ "article/dvisvgm", { LaTeX("latex", "article"), { "dvisvgm", { "--page=1-", "--no-fonts", "article.dvi" }, false } } });
+  jobs.push_back({ "slides/pdftex", { LaTeX("pdflatex", "slides") } });
+  jobs.push_back({ "slides/xetex", { LaTeX("xelatex", "slides") } });
+  jobs.push_back({ "slides/luatex", { LaTeX("lualatex", "slides", false) } });
+  jobs.push_back({ "cjk/xetex", { LaTeX("xelatex", "cjk") } });
+  jobs.push_back({ "cjk/luatex", { LaTeX("lualatex", "cjk", false) } });
+  jobs.push_back({ "thesis/pdftex", { LaTeX("pdflatex", "thesis"), { "biber", { "--quiet", "thesis" }, false }, LaTeX("pdflatex", "thesis"), LaTeX("pdflatex", "thesis") } });
+  return jobs;
+}
+
+// deterministic: the report of two runs can be compared
+static void WriteBibliography(const PathName& path, int numEntries)
+{
+  ofstream stream = File::CreateOutputStream(path);
+  for (int idx = 1; idx <= numEntries; ++idx)
+  {
+    stream << fmt::format("@article{{ref{0},\n", idx)
+      << fmt::format("  author = {{Author{0}, Alice and Coauthor{1}, Bob}},\n", idx, idx % 37)
+      << fmt::format("  title = {{On the Typesetting of Document Number {0}}},\n", idx)
+      << fmt::format("  journal = {{Journal of Benchmarks {0}}},\n", idx % 11)
+      << fmt::format("  volume = {{{0}}},\n", idx % 50 + 1)
+      << fmt::format("  pages = {{{0}--{1}}},\n", idx * 3, idx * 3 + 17)
+      << fmt::format("  year = {{{0}}},\n", 1950 + idx % 70)
+      << "}\n\n";
+  }
+}
+
+struct Measurement
+{
+  int exitCode = -1;
+  chrono::nanoseconds wallTime{ 0 };
+  chrono::nanoseconds cpuTime{ 0 };
+  size_t peakResidentSetSize = 0;
+};
+
+#if defined(_WIN32)
+static string Quote(const string& argument)
+{
+  if (!argument.empty() && argument.find_first_of(" \t\"") == string::npos)
+  {
+    return argument;
+  }
+  string result = "\"";
+  for (char ch : argument)
+  {
+    if (ch == '"')
+    {
+      result += '\\';
+    }
+    result += ch;
+  }
+  result += '"';
+  return result;
+}
+#endif
+
+static Measurement RunProcess(const string& program, const vector<string>& arguments, const PathName& workingDirectory, const PathName& logFile)
+{
+  Measurement result;
+  auto start = chrono::steady_clock::now();
+#if defined(_WIN32)
+  string commandLine = Quote(program);
+  for (const string& argument : arguments)
+  {
+    commandLine += " ";
+    commandLine += Quote(argument);
+  }
+  SECURITY_ATTRIBUTES securityAttributes = { sizeof(securityAttributes), nullptr, TRUE };
+  HANDLE log = CreateFileW(logFile.ToWideCharString().c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, &securityAttributes, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (log == INVALID_HANDLE_VALUE)
+  {
+    throw runtime_error(fmt::format("{0}: cannot be opened", logFile.ToString()));
+  }
+  STARTUPINFOW startupInfo = { sizeof(startupInfo) };
+  startupInfo.dwFlags = STARTF_USESTDHANDLES;
+  startupInfo.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+  startupInfo.hStdOutput = log;
+  startupInfo.hStdError = log;
+  PROCESS_INFORMATION processInformation;
+  wstring wideCommandLine = StringUtil::UTF8ToWideChar(commandLine);
+  if (!CreateProcessW(nullptr, &wideCommandLine[0], nullptr, nullptr, TRUE, 0, nullptr, workingDirectory.ToWideCharString().c_str(), &startupInfo, &processInformation))
+  {
+    CloseHandle(log);
+    throw runtime_error(fmt::format("{0}: cannot be started", program));
+  }
+  CloseHandle(log);
+  WaitForSingleObject(processInformation.hProcess, INFINITE);
+  result.wallTime = chrono::steady_clock::now() - start;
+  DWORD exitCode;
+  GetExitCodeProcess(processInformation.hProcess, &exitCode);
+  result.exitCode = static_cast<int>(exitCode);
+  FILETIME creationTime, exitTime, kernelTime, userTime;
+  if (GetProcessTimes(processInformation.hProcess, &creationTime, &exitTime, &kernelTime, &userTime))
+  {
+    auto ticks = [](const FILETIME& ft) { return (static_cast<unsigned long long>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime; };
+    // FILETIME: 100-nanosecond intervals
+    result.cpuTime = chrono::nanoseconds((ticks(kernelTime) + ticks(userTime)) * 100);
+  }
+  PROCESS_MEMORY_COUNTERS memoryCounters;
+  if (GetProcessMemoryInfo(processInformation.hProcess, &memoryCounters, sizeof(memoryCounters)))
+  {
+    result.peakResidentSetSize = memoryCounters.PeakWorkingSetSize;
+  }
+  CloseHandle(processInformation.hThread);
+  CloseHandle(processInformation.hProcess);
+#else
+  pid_t pid = fork();
+  if (pid < 0)
+  {
+    throw runtime_error("fork() failed");
+  }
+  if (pid == 0)
+  {
+    int log = open(logFile.GetData(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (log < 0 || chdir(workingDirectory.GetData()) != 0)
+    {
+      _exit(127);
+    }
+    dup2(log, STDOUT_FILENO);
+    dup2(log, STDERR_FILENO);
+    close(log);
+    vector<char*> argv;
+    argv.push_back(const_cast<char*>(program.c_str()));
+    for (const string& argument : arguments)
+    {
+      argv.push_back(const_cast<char*>(argument.c_str()));
+    }
+    argv.push_back(nullptr);
+    execvp(program.c_str(), argv.data());
+    _exit(127);
+  }
+  int status;
+  rusage usage;
+  if (wait4(pid, &status, 0, &usage) < 0)
+  {
+    throw runtime_error("wait4() failed");
+  }
+  result.wallTime = chrono::steady_clock::now() - start;
+  result.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  auto toNanoseconds = [](const timeval& tv) { return chrono::seconds(tv.tv_sec) + chrono::microseconds(tv.tv_usec); };
+  result.cpuTime = toNanoseconds(usage.ru_utime) + toNanoseconds(usage.ru_stime);
+#if defined(__APPLE__)
+  // bytes
+  result.peakResidentSetSize = usage.ru_maxrss;
+#else
+  // kilobytes
+  result.peakResidentSetSize = static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+  return result;
+}
+
+inline double ToSeconds(chrono::nanoseconds d)
+{
+  return chrono::duration_cast<chrono::duration<double>>(d).count();
+}
+
+class TeXMFBench
+{
+public:
+  void Run(int argc, const char** argv);
+
+private:
+  nlohmann::json RunJob(const Job& job, bool measure);
+
+private:
+  PathName corpusDirectory{ CORPUS_DIR };
+
+private:
+  PathName workDirectory{ "texmf-bench" };
+
+private:
+  string filter;
+
+private:
+  int repetitions = 1;
+
+private:
+  bool warmUp = true;
+};
+
+nlohmann::json TeXMFBench::RunJob(const Job& job, bool measure)
+{
+  PathName jobDirectory = workDirectory / PathName(job.name);
+  if (Directory::Exists(jobDirectory))
+  {
+    Directory::Delete(jobDirectory, true);
+  }
+  Directory::Create(jobDirectory);
+  unique_ptr<DirectoryLister> lister = DirectoryLister::Open(corpusDirectory, "*", static_cast<int>(DirectoryLister::Options::FilesOnly));
+  DirectoryEntry entry;
+  while (lister->GetNext(entry))
+  {
+    File::Copy(corpusDirectory / PathName(entry.name), jobDirectory / PathName(entry.name));
+  }
+  lister->Close();
+  WriteBibliography(jobDirectory / PathName("thesis.bib"), 400);
+  PathName logFile = jobDirectory / PathName("texmf-bench.log");
+  nlohmann::json steps = nlohmann::json::array();
+  chrono::nanoseconds totalWallTime(0);
+  chrono::nanoseconds totalCpuTime(0);
+  size_t peakResidentSetSize = 0;
+  bool failed = false;
+  for (size_t idx = 0; idx < job.steps.size() && !failed; ++idx)
+  {
+    const Step& step = job.steps[idx];
+    vector<string> arguments;
+    PathName statsFile = jobDirectory / PathName(fmt::format("stats-{0}.json", idx + 1));
+    if (step.withStats && measure)
+    {
+      arguments.push_back("--stats=" + statsFile.ToString());
+    }
+    arguments.insert(arguments.end(), step.arguments.begin(), step.arguments.end());
+    Measurement measurement = RunProcess(step.program, arguments, jobDirectory, logFile);
+    failed = measurement.exitCode != 0;
+    if (failed)
+    {
+      cerr << fmt::format("{0}: {1} failed (exit code {2}); see {3}", job.name, step.program, measurement.exitCode, logFile.ToString()) << endl;
+    }
+    nlohmann::json result = {
+      { "program", step.program },
+      { "exitCode", measurement.exitCode },
+      { "wall", ToSeconds(measurement.wallTime) },
+      { "cpu", ToSeconds(measurement.cpuTime) },
+      { "peakRss", measurement.peakResidentSetSize },
+    };
+    if (step.withStats && measure && File::Exists(statsFile))
+    {
+      ifstream stream = File::CreateInputStream(statsFile);
+      result["stats"] = nlohmann::json::parse(stream);
+    }
+    steps.push_back(result);
+    totalWallTime += measurement.wallTime;
+    totalCpuTime += measurement.cpuTime;
+    peakResidentSetSize = max(peakResidentSetSize, measurement.peakResidentSetSize);
+  }
+  return {
+    { "job", job.name },
+    { "ok", !failed },
+    { "wall", ToSeconds(totalWallTime) },
+    { "cpu", ToSeconds(totalCpuTime) },
+    { "peakRss", peakResidentSetSize },
+    { "steps", steps },
+  };
+}
+
+void TeXMFBench::Run(int argc, const char** argv)
+{
+  PoptWrapper popt(argc, argv, long_options);
+
+  int option;
+
+  PathName binDirectory;
+  string outputFile;
+
+  while ((option = popt.GetNextOpt()) >= 0)
+  {
+    string optArg = popt.GetOptArg();
+    switch (option)
+    {
+    case OPT_BIN_DIR:
+      binDirectory = optArg;
+      binDirectory.MakeFullyQualified();
+      break;
+    case OPT_CORPUS_DIR:
+      corpusDirectory = optArg;
+      break;
+    case OPT_FILTER:
+      filter = optArg;
+      break;
+    case OPT_NO_WARM_UP:
+      warmUp = false;
+      break;
+    case OPT_OUTPUT:
+      outputFile = optArg;
+      break;
+    case OPT_REPETITIONS:
+      repetitions = std::stoi(optArg);
+      break;
+    case OPT_WORK_DIR:
+      workDirectory = optArg;
+      break;
+    }
+  }
+
+  if (option < -1)
+  {
+    cerr << popt.BadOption(POPT_BADOPTION_NOALIAS) << ": " << popt.Strerror(option) << endl;
+    throw 1;
+  }
+
+  shared_ptr<Session> session = Session::Create(Session::InitInfo(argv[0]));
+
+  if (!binDirectory.Empty())
+  {
+    // the child processes inherit the environment
+    string path;
+    Utils::GetEnvironmentString("PATH", path);
+    Utils::SetEnvironmentString("PATH", binDirectory.ToString() + PathNameUtil::PathNameDelimiter + path);
+  }
+
+  workDirectory.MakeFullyQualified();
+
+  nlohmann::json runs = nlohmann::json::array();
+  for (const Job& job : MakeJobs())
+  {
+    if (job.name.compare(0, filter.length(), filter) != 0)
+    {
+      continue;
+    }
+    if (warmUp)
+    {
+      cerr << fmt::format("{0}: warming up", job.name) << endl;
+      RunJob(job, false);
+    }
+    for (int repetition = 1; repetition <= repetitions; ++repetition)
+    {
+      cerr << fmt::format("{0}: run {1}/{2}", job.name, repetition, repetitions) << endl;
+      nlohmann::json run = RunJob(job, true);
+      run["repetition"] = repetition;
+      runs.push_back(run);
+    }
+  }
+
+  nlohmann::json report = { { "runs", runs } };
+  if (outputFile.empty())
+  {
+    cout << report.dump(2) << endl;
+  }
+  else
+  {
+    ofstream stream = File::CreateOutputStream(PathName(outputFile));
+    stream << report.dump(2) << "\n";
+    stream.close();
+  }
+
+  session->Close();
+}
+
+int main(int argc, const char** argv)
+{
+  try
+  {
+    TeXMFBench app;
+    app.Run(argc, argv);
+    return 0;
+  }
+  catch (const MiKTeXException& e)
+  {
+    Utils::PrintException(e);
+    return 1;
+  }
+  catch (const exception& e)
+  {
+    Utils::PrintException(e);
+    return 1;
+  }
+  catch (int retCode)
+  {
+    return retCode;
+  }
+}
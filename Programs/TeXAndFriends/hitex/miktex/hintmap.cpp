@@ -0,0 +1,57 @@
+/**
+ * @file miktex/hintmap.cpp
+ * @author Christian Schenk
+ * @brief Mapping HINT files into memory
+ *
+ * @copyright Copyright © 2023 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#include <memory>
+
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Core/MemoryMappedFile>
+
+#include "hintmap.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+namespace
+{
+    unique_ptr<MemoryMappedFile> mapping;
+}
+
+uint8_t* miktex_hint_map(const char* path, uint64_t* size, uint64_t* time)
+{
+    try
+    {
+        PathName fileName(path);
+        if (!File::Exists(fileName) || File::GetSize(fileName) == 0)
+        {
+            return nullptr;
+        }
+        mapping.reset(MemoryMappedFile::Create());
+        uint8_t* data = static_cast<uint8_t*>(mapping->Open(fileName, false));
+        mapping->Advise(MemoryMappedFileAccessPattern::Sequential);
+        *size = mapping->GetSize();
+        *time = static_cast<uint64_t>(File::GetLastWriteTime(fileName));
+        return data;
+    }
+    catch (const MiKTeXException&)
+    {
+        mapping = nullptr;
+        return nullptr;
+    }
+}
+
+void miktex_hint_unmap()
+{
+    mapping = nullptr;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file miktex/hintmap.h
+ * @author Christian Schenk
+ * @brief Mapping HINT files into memory
+ *
+ * @copyright Copyright © 2023 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*
+ * Maps a short format file read-only into memory instead of reading it.
+ * Pages are brought in as they are accessed and, because the file is read
+ * from start to end, the operating system can drop pages which have been
+ * processed: the memory needed does not grow with the size of the file.
+ * Returns NULL, if the file cannot be mapped.
+ */
+uint8_t* miktex_hint_map(const char* path, uint64_t* size, uint64_t* time);
+
+void miktex_hint_unmap(void);
+
+#if defined(__cplusplus)
+}
+#endif
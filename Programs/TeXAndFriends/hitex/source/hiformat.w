@@ -6921,7 +6921,23 @@ uint64_t hin_time=0;
 @
 
 @<map functions@>=
-#ifndef USE_MMAP
+#if defined(MIKTEX)
+#include "miktex/hintmap.h"
+
+void hget_unmap(void)
+{@+ miktex_hint_unmap();
+  hin_addr=NULL;
+  hin_size=0;
+}
+
+bool hget_map(void)
+{ if (hin_addr!=NULL) hget_unmap();
+  hin_addr=miktex_hint_map(hin_name,&hin_size,&hin_time);
+  if (hin_addr==NULL)
+  { MESSAGE("Unable to map file %s\n",hin_name);@+ return false;@+ }
+  return true;
+}
+#elif !defined(USE_MMAP)
 void hget_unmap(void)
 {@+ if (hin_addr!=NULL) free(hin_addr);
   hin_addr=NULL;
@@ -7420,6 +7436,13 @@ void hwrite_aux_files(void)
       s=fwrite(hstart,1,dir[i].size,f);
       if (s!=dir[i].size) QUIT("writing file %s",aux_name);
       fclose(f);
+#if defined(MIKTEX)
+      /* release the decompressed section: it is not needed anymore */
+      if (dir[i].xsize>0 && dir[i].buffer!=NULL)
+      { free(dir[i].buffer);
+        dir[i].buffer=NULL;
+      }
+#endif
     }
     free(aux_name);
   }
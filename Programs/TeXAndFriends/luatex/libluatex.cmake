@@ -242,6 +242,8 @@ list(APPEND luatex_common_engine_sources
     ${CMAKE_SOURCE_DIR}/${MIKTEX_REL_SYNCTEX_SOURCE_DIR}/synctex-luatex.h
     ${CMAKE_SOURCE_DIR}/${MIKTEX_REL_SYNCTEX_SOURCE_DIR}/synctex.c
     ${CMAKE_SOURCE_DIR}/${MIKTEX_REL_SYNCTEX_SOURCE_DIR}/synctex.h
+    ${CMAKE_SOURCE_DIR}/${MIKTEX_REL_SYNCTEX_CLI_DIR}/miktex/gzwriter.cpp
+    ${CMAKE_SOURCE_DIR}/${MIKTEX_REL_SYNCTEX_CLI_DIR}/miktex/gzwriter.h
 )
 
 add_library(luatex-common-engine-objects OBJECT ${luatex_common_engine_sources})
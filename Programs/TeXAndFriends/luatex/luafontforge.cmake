@@ -105,7 +105,6 @@ target_link_libraries(luatex-luafontforge-objects
     PUBLIC
         ${core_dll_name}
         ${kpsemu_dll_name}
-        ${lua53_target_name}
         ${w2cemu_dll_name}
         luatex-unilib-objects
 )
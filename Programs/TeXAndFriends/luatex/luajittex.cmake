@@ -0,0 +1,150 @@
+## luajittex.cmake
+##
+## Copyright (C) 2023 Christian Schenk
+##
+## This file is free software; the copyright holder gives
+## unlimited permission to copy and/or distribute it, with or
+## without modifications, as long as this notice is preserved.
+
+## The LuaJIT variants of the object libraries which use the Lua API.
+## The sources are shared with the Lua 5.3 variants; LuaJIT brings its
+## own ffi library.
+
+###############################################################################
+## luajittex-common-engine-objects
+###############################################################################
+
+set(luajittex_common_engine_sources ${luatex_common_engine_sources})
+
+list(REMOVE_ITEM luajittex_common_engine_sources source/lua/texluac.c)
+
+list(APPEND luajittex_common_engine_sources source/lua/texluajitc.c)
+
+add_library(luajittex-common-engine-objects OBJECT ${luajittex_common_engine_sources})
+
+set_property(TARGET luajittex-common-engine-objects PROPERTY FOLDER ${MIKTEX_CURRENT_FOLDER})
+
+target_compile_definitions(luajittex-common-engine-objects
+    PUBLIC
+        -DLuajitTeX
+)
+
+target_include_directories(luajittex-common-engine-objects
+    PRIVATE
+        source/luafontloader/fontforge/fontforge
+        source/luafontloader/fontforge/inc
+        source/utils
+)
+
+if(USE_SYSTEM_PNG)
+    target_link_libraries(luajittex-common-engine-objects PUBLIC MiKTeX::Imported::PNG)
+else()
+    target_link_libraries(luajittex-common-engine-objects PUBLIC ${png_dll_name})
+endif()
+
+if(USE_SYSTEM_ZLIB)
+    target_link_libraries(luajittex-common-engine-objects PUBLIC MiKTeX::Imported::ZLIB)
+else()
+    target_link_libraries(luajittex-common-engine-objects PUBLIC ${zlib_dll_name})
+endif()
+
+target_link_libraries(luajittex-common-engine-objects
+    PUBLIC
+        ${core_dll_name}
+        ${kpsemu_dll_name}
+        ${luajit_dll_name}
+        ${metapost_dll_name}
+        ${pplib_lib_name}
+        ${w2cemu_dll_name}
+        luajittex-luamisc-objects
+        luatex-luafontforge-objects
+)
+
+if(MIKTEX_NATIVE_WINDOWS)
+    target_link_libraries(luajittex-common-engine-objects
+        PUBLIC
+            ${utf8wrap_dll_name}
+    )
+endif()
+
+###############################################################################
+## luajittex-engine-objects
+###############################################################################
+
+add_library(luajittex-engine-objects OBJECT ${luatex_engine_sources})
+
+set_property(TARGET luajittex-engine-objects PROPERTY FOLDER ${MIKTEX_CURRENT_FOLDER})
+
+target_include_directories(luajittex-engine-objects
+    PRIVATE
+        source/luafontloader/fontforge/fontforge
+        source/luafontloader/fontforge/inc
+        source/utils
+)
+
+target_link_libraries(luajittex-engine-objects
+    PUBLIC
+        luajittex-common-engine-objects
+)
+
+###############################################################################
+## luajittex-luamisc-objects
+###############################################################################
+
+add_library(luajittex-luamisc-objects OBJECT ${luamisc_sources})
+
+set_property(TARGET luajittex-luamisc-objects PROPERTY FOLDER ${MIKTEX_CURRENT_FOLDER})
+
+target_compile_definitions(luajittex-luamisc-objects
+    PRIVATE
+        -DLUAZIP_API=
+        -DLuajitTeX
+)
+
+if(USE_SYSTEM_ZLIB)
+    target_link_libraries(luajittex-luamisc-objects PUBLIC MiKTeX::Imported::ZLIB)
+else()
+    target_link_libraries(luajittex-luamisc-objects PUBLIC ${zlib_dll_name})
+endif()
+
+if(USE_SYSTEM_ZZIP)
+    target_link_libraries(luajittex-luamisc-objects PUBLIC MiKTeX::Imported::ZZIP)
+else()
+    target_link_libraries(luajittex-luamisc-objects PUBLIC ${zzip_dll_name})
+endif()
+
+target_link_libraries(luajittex-luamisc-objects
+    PUBLIC
+        ${core_dll_name}
+        ${luajit_dll_name}
+        ${pplib_lib_name}
+)
+
+if(MIKTEX_NATIVE_WINDOWS)
+    target_link_libraries(luajittex-luamisc-objects
+        PUBLIC
+        ${unxemu_dll_name}
+        ${utf8wrap_dll_name}
+    )
+endif()
+
+###############################################################################
+## luajittex-luasocket-objects
+###############################################################################
+
+add_library(luajittex-luasocket-objects OBJECT ${luasocket_sources})
+
+set_property(TARGET luajittex-luasocket-objects PROPERTY FOLDER ${MIKTEX_CURRENT_FOLDER})
+
+add_dependencies(luajittex-luasocket-objects gen-luasocket-sources)
+
+target_compile_definitions(luajittex-luasocket-objects
+    PRIVATE
+        -DLUASOCKET_DEBUG
+        -DLuajitTeX
+)
+
+target_link_libraries(luajittex-luasocket-objects
+    PUBLIC
+        ${luajit_dll_name}
+)
@@ -7,6 +7,7 @@
 ## without modifications, as long as this notice is preserved.
 
 set(miktex_sources
+    miktex/filecache.cpp
     miktex/luatex.h
     miktex/miktex.cpp
 )
@@ -0,0 +1,276 @@
+/**
+ * @file luatex/miktex/filecache.cpp
+ * @author Christian Schenk
+ * @brief MiKTeX LuaTeX font and script caches
+ *
+ * @copyright Copyright © 2023 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#include <cstring>
+#include <ctime>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/App/Application>
+#include <miktex/Core/Debug>
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/MD5>
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Core/Paths>
+#include <miktex/Core/TemporaryFile>
+
+#include "luatex.h"
+
+using namespace MiKTeX::App;
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+using namespace std;
+
+/*
+ * A cache file holds the data stored for a source file: the serialized
+ * result of the font loader for a font file, the precompiled chunk for a
+ * Lua script:
+ *
+ *   signature version digest tag size data
+ *
+ * The file name is derived from the digest of the source file and from
+ * the tag, which identifies the producer of the data (and its version), so
+ * that the cache file is found for every copy of the source file.  Numbers
+ * are stored as 32-bit words (64-bit for the size), the tag is prefixed by
+ * its length.
+ */
+
+const uint32_t CACHE_FILE_SIGNATURE = 0x43464c4d; // 'MLFC' (the x86 way)
+const uint32_t CACHE_FILE_VERSION = 1;
+
+const char* const FONT_CACHE_NAME = "luatex-fonts";
+const char* const SCRIPT_CACHE_NAME = "texlua-bytecode";
+
+namespace
+{
+    struct FileDigest
+    {
+        size_t size;
+        time_t lastWriteTime;
+        MD5 digest;
+    };
+
+    // digests of the source files looked up so far
+    unordered_map<string, FileDigest> fileDigests;
+
+    // the cache files handed out by CacheLoad()
+    unordered_map<const void*, unique_ptr<MemoryMappedFile>> mappings;
+}
+
+static MD5 GetFileDigest(const PathName& file)
+{
+    size_t size = File::GetSize(file);
+    time_t lastWriteTime = File::GetLastWriteTime(file);
+    auto it = fileDigests.find(file.ToString());
+    if (it != fileDigests.end() && it->second.size == size && it->second.lastWriteTime == lastWriteTime)
+    {
+        return it->second.digest;
+    }
+    MD5 digest = MD5::FromFile(file);
+    fileDigests[file.ToString()] = FileDigest{ size, lastWriteTime, digest };
+    return digest;
+}
+
+// the directories holding cache files, in search order: the first one is
+// written to
+static vector<PathName> GetCacheDirectories(const char* cacheName)
+{
+    shared_ptr<Session> session = Application::GetApplication()->GetSession();
+    vector<PathName> result;
+    PathName cacheDir = PathName(MIKTEX_PATH_MIKTEX_CACHE_DIR) / PathName(cacheName);
+    if (!session->IsAdminMode())
+    {
+        result.push_back(session->GetSpecialPath(SpecialPath::UserDataRoot) / cacheDir);
+    }
+    if (session->IsSharedSetup() || session->IsAdminMode())
+    {
+        // the cache files written by the administrator are shared with all
+        // users
+        PathName commonCacheDir = session->GetSpecialPath(SpecialPath::CommonDataRoot) / cacheDir;
+        if (result.empty() || result[0] != commonCacheDir)
+        {
+            result.push_back(commonCacheDir);
+        }
+    }
+    return result;
+}
+
+static PathName GetCacheFileName(const MD5& digest, const string& tag)
+{
+    return PathName(MD5::FromChars(digest.ToString() + "/" + tag).ToString() + ".bin");
+}
+
+static const void* ReadCacheFile(const PathName& path, const MD5& digest, const string& tag, size_t& size)
+{
+    unique_ptr<MemoryMappedFile> mapping(MemoryMappedFile::Create());
+    const unsigned char* data = static_cast<const unsigned char*>(mapping->Open(path, false));
+    size_t dataSize = mapping->GetSize();
+    size_t pos = 0;
+    auto read = [data, dataSize, &pos](void* buf, size_t n)
+    {
+        if (n > dataSize - pos)
+        {
+            MIKTEX_UNEXPECTED();
+        }
+        memcpy(buf, data + pos, n);
+        pos += n;
+    };
+    uint32_t signature, version, length;
+    read(&signature, sizeof(signature));
+    read(&version, sizeof(version));
+    if (signature != CACHE_FILE_SIGNATURE || version != CACHE_FILE_VERSION)
+    {
+        return nullptr;
+    }
+    MD5 cachedDigest;
+    read(cachedDigest.data(), cachedDigest.size());
+    read(&length, sizeof(length));
+    string cachedTag(length, '\0');
+    read(&cachedTag[0], length);
+    uint64_t payloadSize;
+    read(&payloadSize, sizeof(payloadSize));
+    if (cachedDigest != digest || cachedTag != tag || payloadSize != dataSize - pos)
+    {
+        return nullptr;
+    }
+    // the data is handed out without copying it
+    const void* payload = data + pos;
+    size = static_cast<size_t>(payloadSize);
+    mappings[payload] = std::move(mapping);
+    return payload;
+}
+
+static const void* CacheLoad(const char* cacheName, const char* fileArg, const char* tag, size_t* sizeRet)
+{
+    MIKTEX_ASSERT_STRING(fileArg);
+    MIKTEX_ASSERT_STRING(tag);
+    MIKTEX_ASSERT(sizeRet != nullptr);
+    try
+    {
+        PathName file(fileArg);
+        if (!File::Exists(file))
+        {
+            return nullptr;
+        }
+        MD5 digest = GetFileDigest(file);
+        PathName fileName = GetCacheFileName(digest, tag);
+        for (const PathName& dir : GetCacheDirectories(cacheName))
+        {
+            PathName path = dir / fileName;
+            if (!File::Exists(path))
+            {
+                continue;
+            }
+            const void* data = ReadCacheFile(path, digest, tag, *sizeRet);
+            if (data != nullptr)
+            {
+                return data;
+            }
+        }
+    }
+    catch (const MiKTeXException&)
+    {
+        // not fatal: the source file will be loaded again
+    }
+    return nullptr;
+}
+
+static void CacheFree(const void* data)
+{
+    mappings.erase(data);
+}
+
+static int CacheStore(const char* cacheName, const char* fileArg, const char* tag, const void* data, size_t size)
+{
+    MIKTEX_ASSERT_STRING(fileArg);
+    MIKTEX_ASSERT_STRING(tag);
+    MIKTEX_ASSERT(data != nullptr || size == 0);
+    try
+    {
+        PathName file(fileArg);
+        MD5 digest = GetFileDigest(file);
+        vector<PathName> dirs = GetCacheDirectories(cacheName);
+        if (dirs.empty())
+        {
+            return 0;
+        }
+        string header;
+        auto write = [&header](const void* buf, size_t n)
+        {
+            header.append(reinterpret_cast<const char*>(buf), n);
+        };
+        uint32_t word = CACHE_FILE_SIGNATURE;
+        write(&word, sizeof(word));
+        word = CACHE_FILE_VERSION;
+        write(&word, sizeof(word));
+        write(digest.data(), digest.size());
+        word = static_cast<uint32_t>(strlen(tag));
+        write(&word, sizeof(word));
+        write(tag, word);
+        uint64_t word64 = static_cast<uint64_t>(size);
+        write(&word64, sizeof(word64));
+        PathName path = dirs[0] / GetCacheFileName(digest, tag);
+        Directory::Create(path.GetDirectoryName());
+        // other processes might read the cache file at the same time
+        PathName tmpPath(path);
+        tmpPath.AppendExtension(".tmp");
+        unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create(tmpPath);
+        FileStream stream(File::Open(tmpPath, FileMode::Create, FileAccess::Write, false));
+        stream.Write(header.data(), header.length());
+        stream.Write(data, size);
+        stream.Close();
+        File::Move(tmpPath, path, { FileMoveOption::ReplaceExisting });
+        tmpFile->Keep();
+    }
+    catch (const MiKTeXException&)
+    {
+        // not fatal: the source file will be loaded again next time
+        return 0;
+    }
+    return 1;
+}
+
+const void* miktex_font_cache_load(const char* fontFile, const char* tag, size_t* sizeRet)
+{
+    return CacheLoad(FONT_CACHE_NAME, fontFile, tag, sizeRet);
+}
+
+void miktex_font_cache_free(const void* data)
+{
+    CacheFree(data);
+}
+
+int miktex_font_cache_store(const char* fontFile, const char* tag, const void* data, size_t size)
+{
+    return CacheStore(FONT_CACHE_NAME, fontFile, tag, data, size);
+}
+
+const void* miktex_script_cache_load(const char* scriptFile, const char* tag, size_t* sizeRet)
+{
+    return CacheLoad(SCRIPT_CACHE_NAME, scriptFile, tag, sizeRet);
+}
+
+void miktex_script_cache_free(const void* data)
+{
+    CacheFree(data);
+}
+
+int miktex_script_cache_store(const char* scriptFile, const char* tag, const void* data, size_t size)
+{
+    return CacheStore(SCRIPT_CACHE_NAME, scriptFile, tag, data, size);
+}
@@ -30,6 +30,9 @@ FILE* miktex_emulate__runpopen(const char* commandLine, const char* mode);
 int miktex_emulate__shell_cmd_is_allowed(const char* commandLine, char** safeCommandLineRet, char** examinedCommandRet);
 int miktex_emulate__spawn_command(const char* fileName, char* const* argv, char* const* env);
 void miktex_enable_installer(int onOff);
+void miktex_font_cache_free(const void* data);
+const void* miktex_font_cache_load(const char* fontFile, const char* tag, size_t* sizeRet);
+int miktex_font_cache_store(const char* fontFile, const char* tag, const void* data, size_t size);
 const char* miktex_get_aux_directory();
 void miktex_invoke_editor(const char* filename, int lineno);
 int miktex_is_fully_qualified_path(const char* path);
@@ -38,6 +41,9 @@ int miktex_is_pipe(FILE* file);
 int miktex_open_format_file(const char* fileName, FILE** ppFile, int renew);
 FILE* miktex_open_output_file(const char* fileName);
 void miktex_print_banner(FILE* file, const char* name, const char* version);
+void miktex_script_cache_free(const void* data);
+const void* miktex_script_cache_load(const char* scriptFile, const char* tag, size_t* sizeRet);
+int miktex_script_cache_store(const char* scriptFile, const char* tag, const void* data, size_t size);
 void miktex_set_aux_directory(const char* path);
 void miktex_show_library_versions();
 #if defined(MIKTEX_WINDOWS)
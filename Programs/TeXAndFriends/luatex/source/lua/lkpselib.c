@@ -944,6 +944,44 @@ static int lua_record_output_file(lua_State * L)
     return 0;
 }
 
+#if defined(MIKTEX)
+/*tex
+
+    The \MIKTEX\ font cache holds data derived from font files (for instance
+    the serialized output of the font loader), so that a font file need not
+    be parsed again in later runs: |kpse.font_cache_load(fontfile,tag)|
+    returns the data stored by |kpse.font_cache_store(fontfile,tag,data)|, or
+    |nil|. The cache is keyed by the digest of the font file and by the tag,
+    which should identify the producer of the data (and its version).
+
+*/
+
+static int lua_font_cache_load(lua_State * L)
+{
+    const char *fontfile = luaL_checkstring(L, 1);
+    const char *tag = luaL_checkstring(L, 2);
+    size_t size = 0;
+    const void *data = miktex_font_cache_load(fontfile, tag, &size);
+    if (data == NULL) {
+        lua_pushnil(L);
+    } else {
+        lua_pushlstring(L, (const char *) data, size);
+        miktex_font_cache_free(data);
+    }
+    return 1;
+}
+
+static int lua_font_cache_store(lua_State * L)
+{
+    const char *fontfile = luaL_checkstring(L, 1);
+    const char *tag = luaL_checkstring(L, 2);
+    size_t size = 0;
+    const char *data = luaL_checklstring(L, 3, &size);
+    lua_pushboolean(L, miktex_font_cache_store(fontfile, tag, data, size));
+    return 1;
+}
+#endif
+
 /*tex moved here */
 
 static int lua_check_permissions(lua_State *L)
@@ -1033,6 +1071,10 @@ static const struct luaL_Reg kpselib_l[] = {
     {"default_texmfcnf", show_texmfcnf},
     {"record_input_file", lua_record_input_file},
     {"record_output_file", lua_record_output_file},
+#if defined(MIKTEX)
+    {"font_cache_load", lua_font_cache_load},
+    {"font_cache_store", lua_font_cache_store},
+#endif
     /* extra */
     {"check_permission", lua_check_permissions},
     /* sentinel */
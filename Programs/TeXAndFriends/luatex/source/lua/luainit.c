@@ -818,6 +818,82 @@ static const char *luatex_kpse_find_aux(lua_State *L, const char *name,
 
 static int lua_loader_function = 0;
 
+#if defined(MIKTEX)
+#if defined(LuajitTeX)
+#define MIKTEX_SCRIPT_CACHE_TAG "texluajit/" LUAJIT_VERSION
+#else
+#define MIKTEX_SCRIPT_CACHE_TAG "texlua/" LUA_RELEASE
+#endif
+
+struct miktex_chunk_buffer {
+    char *data;
+    size_t size;
+    size_t capacity;
+};
+
+static int miktex_chunk_writer(lua_State * L, const void *p, size_t sz, void *ud)
+{
+    struct miktex_chunk_buffer *buf = (struct miktex_chunk_buffer *) ud;
+    (void) L;
+    if (buf->size + sz > buf->capacity) {
+        buf->capacity = 2 * (buf->size + sz);
+        buf->data = xrealloc(buf->data, buf->capacity);
+    }
+    memcpy(buf->data + buf->size, p, sz);
+    buf->size += sz;
+    return 0;
+}
+
+/*tex
+
+    Load a Lua file like |luaL_loadfile| does, but take the precompiled chunk
+    from the script cache if there is one, and put it there otherwise. The
+    cache tag holds the Lua version and the file name: the chunk keeps its
+    debug information, so error messages and |debug.getinfo| report the same
+    source as before.
+
+*/
+
+static int miktex_load_lua_file(lua_State * L, const char *filename)
+{
+    size_t size = 0;
+    const void *data;
+    char *tag = xmalloc(strlen(MIKTEX_SCRIPT_CACHE_TAG) + strlen(filename) + 2);
+    sprintf(tag, "%s:%s", MIKTEX_SCRIPT_CACHE_TAG, filename);
+    data = miktex_script_cache_load(filename, tag, &size);
+    if (data != NULL) {
+        int status;
+        lua_pushfstring(L, "@%s", filename);
+        status = luaL_loadbuffer(L, (const char *) data, size, lua_tostring(L, -1));
+        miktex_script_cache_free(data);
+        lua_remove(L, -2);
+        if (status == 0) {
+            free(tag);
+            return 0;
+        }
+        /*tex a damaged chunk: compile the source */
+        lua_pop(L, 1);
+    }
+    if (luaL_loadfile(L, filename) != 0) {
+        free(tag);
+        return 1;
+    } else {
+        struct miktex_chunk_buffer buf = { NULL, 0, 0 };
+#if defined(LuajitTeX)
+        int status = lua_dump(L, miktex_chunk_writer, &buf);
+#else
+        int status = lua_dump(L, miktex_chunk_writer, &buf, 0);
+#endif
+        if (status == 0 && buf.size > 0) {
+            miktex_script_cache_store(filename, tag, buf.data, buf.size);
+        }
+        free(buf.data);
+    }
+    free(tag);
+    return 0;
+}
+#endif
+
 static int luatex_kpse_lua_find(lua_State * L)
 {
     const char *filename;
@@ -835,7 +911,11 @@ static int luatex_kpse_lua_find(lua_State * L)
         return 1;
     }
     recorder_record_input(filename);
+#if defined(MIKTEX)
+    if (miktex_load_lua_file(L, filename) != 0) {
+#else
     if (luaL_loadfile(L, filename) != 0) {
+#endif
         luaL_error(L, "error loading module %s from file %s:\n\t%s",
             lua_tostring(L, 1), filename, lua_tostring(L, -1));
     }
@@ -1250,7 +1330,11 @@ void lua_initialize(int ac, char **av)
             if (load_luatex_core_lua(Luas)) {
                 fprintf(stderr, "Error in execution of luatex-core.lua .\n");
             }
+#if defined(MIKTEX)
+            if (miktex_load_lua_file(Luas, startup_filename)) {
+#else
             if (luaL_loadfile(Luas, startup_filename)) {
+#endif
                 fprintf(stdout, "%s\n", lua_tostring(Luas, -1));
                 exit(1);
             }
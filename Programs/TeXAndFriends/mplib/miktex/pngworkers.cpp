@@ -0,0 +1,155 @@
+/* mplib/miktex/pngworkers.cpp:
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA.  */
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pngworkers.h"
+
+using namespace std;
+
+namespace
+{
+  struct Job
+  {
+    string path;
+    void (*function)(void*);
+    void* data;
+  };
+
+  class WorkerPool
+  {
+  public:
+    ~WorkerPool()
+    {
+      {
+        lock_guard<mutex> lock(mtx);
+        stopRequested = true;
+      }
+      jobAvailable.notify_all();
+      for (thread& t : threads)
+      {
+        t.join();
+      }
+    }
+
+  public:
+    void Submit(Job&& job)
+    {
+      unique_lock<mutex> lock(mtx);
+      if (threads.empty())
+      {
+        // keep one core for the interpreter
+        unsigned n = max(thread::hardware_concurrency(), 2u) - 1;
+        for (unsigned idx = 0; idx < n; ++idx)
+        {
+          threads.emplace_back(&WorkerPool::Work, this);
+        }
+      }
+      // each pending job holds a bitmap
+      jobDone.wait(lock, [this]() { return jobs.size() < 2 * threads.size(); });
+      pendingPaths.insert(job.path);
+      jobs.push_back(std::move(job));
+      jobAvailable.notify_one();
+    }
+
+  public:
+    void WaitFor(const string& path)
+    {
+      unique_lock<mutex> lock(mtx);
+      jobDone.wait(lock, [this, &path]() { return pendingPaths.find(path) == pendingPaths.end(); });
+    }
+
+  public:
+    void WaitAll()
+    {
+      unique_lock<mutex> lock(mtx);
+      jobDone.wait(lock, [this]() { return pendingPaths.empty(); });
+    }
+
+  private:
+    void Work()
+    {
+      while (true)
+      {
+        Job job;
+        {
+          unique_lock<mutex> lock(mtx);
+          jobAvailable.wait(lock, [this]() { return stopRequested || !jobs.empty(); });
+          if (jobs.empty())
+          {
+            return;
+          }
+          job = std::move(jobs.front());
+          jobs.pop_front();
+        }
+        job.function(job.data);
+        {
+          lock_guard<mutex> lock(mtx);
+          pendingPaths.erase(pendingPaths.find(job.path));
+        }
+        jobDone.notify_all();
+      }
+    }
+
+  private:
+    mutex mtx;
+    condition_variable jobAvailable;
+    condition_variable jobDone;
+    deque<Job> jobs;
+    multiset<string> pendingPaths;
+    vector<thread> threads;
+    bool stopRequested = false;
+  };
+
+  bool enabled = false;
+
+  WorkerPool workerPool;
+}
+
+void miktex_mp_png_enable_workers(int enable)
+{
+  enabled = enable != 0;
+}
+
+int miktex_mp_png_workers_enabled(void)
+{
+  return enabled ? 1 : 0;
+}
+
+void miktex_mp_png_wait_for(const char* path)
+{
+  workerPool.WaitFor(path);
+}
+
+void miktex_mp_png_submit(const char* path, void (*job)(void*), void* data)
+{
+  workerPool.Submit(Job{ path, job, data });
+}
+
+void miktex_mp_png_wait(void)
+{
+  workerPool.WaitAll();
+}
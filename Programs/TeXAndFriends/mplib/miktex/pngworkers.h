@@ -0,0 +1,45 @@
+/* mplib/miktex/pngworkers.h:
+
+   Copyright (C) 2023 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA.  */
+
+#pragma once
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* Worker threads which write PNG files while MetaPost carries on with the
+   next figure.  The workers are disabled unless the front end enables
+   them, because the job functions call back into the MP instance. */
+
+void miktex_mp_png_enable_workers(int enable);
+int miktex_mp_png_workers_enabled(void);
+
+/* Wait until the jobs writing the file |path| have finished. */
+void miktex_mp_png_wait_for(const char* path);
+
+/* Run |job(data)| on a worker thread; |path| identifies the file written
+   by the job. */
+void miktex_mp_png_submit(const char* path, void (*job)(void*), void* data);
+
+/* Wait until all jobs have finished. */
+void miktex_mp_png_wait(void);
+
+#if defined(__cplusplus)
+}
+#endif
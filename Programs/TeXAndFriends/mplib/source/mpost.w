@@ -44,6 +44,7 @@ have our customary command-line interface.
 #    include <miktex/utf8wrap.h>
 #  endif
 #  include <miktex/mpost.h>
+#  include <miktex/pngworkers.h>
 #  include <miktex/Core/c/api.h>
 #endif
 #include <w2c/config.h>
@@ -1605,7 +1606,13 @@ main (int argc, char **argv)
   if (set_list!=NULL) {
     run_set_list(mp);
   }
+#if defined(MIKTEX)
+  miktex_mp_png_enable_workers(1);
+#endif
   history = mp_run(mp);
+#if defined(MIKTEX)
+  miktex_mp_png_wait();
+#endif
   (void)mp_finish(mp);
   if (history!=0 && history!=mp_warning_issued)
 	exit(history);
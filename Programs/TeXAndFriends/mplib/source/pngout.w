@@ -67,6 +67,9 @@
 #include "mppsout.h" /* internal header */
 #include "mppngout.h" /* internal header */
 #include "mpmath.h" /* internal header */
+#if defined(MIKTEX)
+#include <miktex/pngworkers.h>
+#endif
 @h
 @<Types in the outer block@>
 @<Declarations@>
@@ -627,10 +630,18 @@ success, non-zero on error.  The original of this function was
 borrowed from an internet post, and extended as needed.
 
 @<Declarations@>=
+#if defined(MIKTEX)
+int mp_png_save_to_file (MP mp, const bitmap_t * bitmap, const char *path, int colormodel, void *fp);
+#else
 int mp_png_save_to_file (MP mp, const bitmap_t * bitmap, const char *path, int colormodel);
+#endif
 
 @ @c
+#if defined(MIKTEX)
+int mp_png_save_to_file (MP mp, const bitmap_t * bitmap, const char *path, int colormodel, void *fp)
+#else
 int mp_png_save_to_file (MP mp, const bitmap_t * bitmap, const char *path, int colormodel)
+#endif
 {
     mp_png_io io;
     png_structp png_ptr = NULL;
@@ -644,7 +655,12 @@ int mp_png_save_to_file (MP mp, const bitmap_t * bitmap, const char *path, int c
     int ppm_y; /* pixels per metre */
     
     io.mp = mp;
+#if defined(MIKTEX)
+    /* the file might have been opened by the interpreter thread */
+    io.fp = fp != NULL ? fp : (mp->open_file)(mp, path, "wb", mp_filetype_bitmap);
+#else
     io.fp = (mp->open_file)(mp, path, "wb", mp_filetype_bitmap);
+#endif
     if (!io.fp) {
         goto fopen_failed;
     }
@@ -891,15 +907,76 @@ int mp_png_gr_ship_out (mp_edge_object *hh, const char *options, int standalone)
   ss = xstrdup(mp->name_of_file);
   cairo_surface_flush (mp->png->surface);
   cairo_destroy (mp->png->cr);
+#if defined(MIKTEX)
+  if (miktex_mp_png_workers_enabled()) {
+    @<Hand the bitmap over to a worker thread@>;
+    return 1;
+  }
+#endif
   bitmap.data = cairo_image_surface_get_data (mp->png->surface);
   bitmap.width = cairo_image_surface_get_width (mp->png->surface);
   bitmap.height = cairo_image_surface_get_height (mp->png->surface);
+#if defined(MIKTEX)
+  mp_png_save_to_file (mp, &bitmap, ss, colormodel, NULL);
+#else
   mp_png_save_to_file (mp, &bitmap, ss, colormodel);
+#endif
   cairo_surface_destroy (mp->png->surface);
   free(ss);
   return 1;
 }
 
+@ Encoding and compressing the bitmap takes most of the time, and it
+does not depend on the state of the interpreter: a worker thread can do
+it while the next figure is being interpreted.  The file is opened
+here, because the |open_file| callback is not necessarily thread-safe;
+the worker writes and closes it.  A figure that is shipped out again
+must wait for the previous job writing the same file.
+
+@<Types...@>=
+#if defined(MIKTEX)
+typedef struct {
+   MP mp;
+   cairo_surface_t *surface;
+   char *path;
+   int colormodel;
+   void *fp;
+} mp_png_job;
+#endif
+
+@ @<Hand the bitmap over to a worker thread@>=
+{
+  mp_png_job *job = mp_xmalloc (mp, 1, sizeof (mp_png_job));
+  miktex_mp_png_wait_for (ss);
+  job->mp = mp;
+  job->surface = mp->png->surface;
+  job->path = ss;
+  job->colormodel = colormodel;
+  job->fp = (mp->open_file)(mp, ss, "wb", mp_filetype_bitmap);
+  miktex_mp_png_submit (ss, mp_png_run_job, job);
+}
+
+@ @<Declarations@>=
+#if defined(MIKTEX)
+static void mp_png_run_job (void *data);
+#endif
+
+@ @c
+#if defined(MIKTEX)
+static void mp_png_run_job (void *data) {
+  mp_png_job *job = (mp_png_job *)data;
+  bitmap_t bitmap;
+  bitmap.data = cairo_image_surface_get_data (job->surface);
+  bitmap.width = cairo_image_surface_get_width (job->surface);
+  bitmap.height = cairo_image_surface_get_height (job->surface);
+  if (job->fp != NULL)
+    mp_png_save_to_file (job->mp, &bitmap, job->path, job->colormodel, job->fp);
+  cairo_surface_destroy (job->surface);
+  free (job->path);
+  free (job);
+}
+#endif
+
 @ @(mplibpng.h@>=
 #ifndef MPLIBPNG_H
 #define MPLIBPNG_H 1
@@ -0,0 +1,283 @@
+/**
+ * @file miktex-deflate.cpp
+ * @author Christian Schenk
+ * @brief Parallel deflate compression
+ *
+ * @copyright Copyright © 2022 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#include <algorithm>
+#include <string>
+
+#include <miktex/Core/Debug>
+#include <miktex/Core/Session>
+
+#include "miktex-deflate.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+
+// the size of the blocks which are compressed independently; shorter
+// streams are compressed on the calling thread
+const size_t BLOCK_SIZE = 128 * 1024;
+
+// the size of the deflate window
+const size_t DICTIONARY_SIZE = 32 * 1024;
+
+const unsigned MAX_WORKER_THREADS = 8;
+
+#define CHECK_ZLIB_ERROR(err, fn) \
+    if ((err) != Z_OK) \
+    { \
+        MIKTEX_FATAL_ERROR_2("zlib: compression failed.", "function", fn, "errorCode", std::to_string(err)); \
+    }
+
+ParallelDeflate::ParallelDeflate(OutputFunc output) :
+    output(output)
+{
+}
+
+ParallelDeflate::~ParallelDeflate() noexcept
+{
+    {
+        lock_guard<mutex> lock(jobMutex);
+        stopRequested = true;
+    }
+    jobCondition.notify_all();
+    for (thread& t : workers)
+    {
+        t.join();
+    }
+    if (haveSerialStream)
+    {
+        deflateEnd(&serialStream);
+    }
+}
+
+bool ParallelDeflate::IsSupported()
+{
+    return thread::hardware_concurrency() > 1;
+}
+
+void ParallelDeflate::Begin(int level)
+{
+    MIKTEX_ASSERT(pendingJobs.empty());
+    this->level = level;
+    input.clear();
+    dictionary.clear();
+    submittedBlocks = false;
+    adler = adler32(0, Z_NULL, 0);
+    length = 0;
+}
+
+void ParallelDeflate::Write(const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    input.insert(input.end(), bytes, bytes + size);
+    if (input.size() >= BLOCK_SIZE)
+    {
+        Submit(false);
+        // don't let the output get too far behind
+        Collect(pendingJobs.size() > 2 * workers.size());
+    }
+}
+
+size_t ParallelDeflate::Finish()
+{
+    if (!submittedBlocks)
+    {
+        CompressSerially();
+    }
+    else
+    {
+        Submit(true);
+        while (!pendingJobs.empty())
+        {
+            Collect(true);
+        }
+        unsigned char trailer[4] = {
+            static_cast<unsigned char>(adler >> 24),
+            static_cast<unsigned char>(adler >> 16),
+            static_cast<unsigned char>(adler >> 8),
+            static_cast<unsigned char>(adler)
+        };
+        Put(trailer, sizeof(trailer));
+    }
+    input.clear();
+    dictionary.clear();
+    return length;
+}
+
+void ParallelDeflate::Submit(bool last)
+{
+    if (!submittedBlocks)
+    {
+        // the zlib header: 32K window, deflate, compression level
+        unsigned cmf = 0x78;
+        unsigned flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+        unsigned flg = flevel << 6;
+        flg += 31 - ((cmf << 8) + flg) % 31;
+        unsigned char header[2] = { static_cast<unsigned char>(cmf), static_cast<unsigned char>(flg) };
+        Put(header, sizeof(header));
+        submittedBlocks = true;
+        if (workers.empty())
+        {
+            unsigned numThreads = std::min(thread::hardware_concurrency(), MAX_WORKER_THREADS);
+            for (unsigned i = 0; i < numThreads; ++i)
+            {
+                workers.push_back(thread([this]() { Run(); }));
+            }
+        }
+    }
+    shared_ptr<Job> job = make_shared<Job>();
+    job->input.reserve(dictionary.size() + input.size());
+    job->input.insert(job->input.end(), dictionary.begin(), dictionary.end());
+    job->input.insert(job->input.end(), input.begin(), input.end());
+    job->dictionarySize = dictionary.size();
+    job->level = level;
+    job->last = last;
+    size_t n = std::min(DICTIONARY_SIZE, job->input.size());
+    dictionary.assign(job->input.end() - n, job->input.end());
+    input.clear();
+    pendingJobs.push_back(job);
+    {
+        lock_guard<mutex> lock(jobMutex);
+        jobQueue.push_back(job);
+    }
+    jobCondition.notify_one();
+}
+
+void ParallelDeflate::Collect(bool wait)
+{
+    while (!pendingJobs.empty())
+    {
+        shared_ptr<Job> job = pendingJobs.front();
+        {
+            unique_lock<mutex> lock(jobMutex);
+            if (wait)
+            {
+                doneCondition.wait(lock, [&job]() { return job->done; });
+            }
+            else if (!job->done)
+            {
+                return;
+            }
+        }
+        pendingJobs.pop_front();
+        CHECK_ZLIB_ERROR(job->error, "deflate");
+        size_t blockSize = job->input.size() - job->dictionarySize;
+        adler = adler32_combine(adler, job->adler, static_cast<z_off_t>(blockSize));
+        Put(job->output.data(), job->output.size());
+        wait = false;
+    }
+}
+
+void ParallelDeflate::CompressSerially()
+{
+    if (!haveSerialStream || level != serialStreamLevel)
+    {
+        if (haveSerialStream)
+        {
+            deflateEnd(&serialStream);
+            haveSerialStream = false;
+        }
+        serialStream.zalloc = Z_NULL;
+        serialStream.zfree = Z_NULL;
+        serialStream.opaque = Z_NULL;
+        CHECK_ZLIB_ERROR(deflateInit(&serialStream, level), "deflateInit");
+        haveSerialStream = true;
+        serialStreamLevel = level;
+    }
+    else
+    {
+        CHECK_ZLIB_ERROR(deflateReset(&serialStream), "deflateReset");
+    }
+    vector<unsigned char> buf(deflateBound(&serialStream, static_cast<uLong>(input.size())));
+    serialStream.next_in = input.data();
+    serialStream.avail_in = static_cast<uInt>(input.size());
+    serialStream.next_out = buf.data();
+    serialStream.avail_out = static_cast<uInt>(buf.size());
+    int err = deflate(&serialStream, Z_FINISH);
+    if (err != Z_STREAM_END)
+    {
+        CHECK_ZLIB_ERROR(err == Z_OK ? Z_BUF_ERROR : err, "deflate");
+    }
+    Put(buf.data(), buf.size() - serialStream.avail_out);
+}
+
+void ParallelDeflate::Put(const unsigned char* data, size_t size)
+{
+    if (size > 0)
+    {
+        output(data, size);
+        length += size;
+    }
+}
+
+void ParallelDeflate::Run()
+{
+    while (true)
+    {
+        shared_ptr<Job> job;
+        {
+            unique_lock<mutex> lock(jobMutex);
+            jobCondition.wait(lock, [this]() { return !jobQueue.empty() || stopRequested; });
+            if (stopRequested)
+            {
+                break;
+            }
+            job = jobQueue.front();
+            jobQueue.pop_front();
+        }
+        Compress(*job);
+        {
+            lock_guard<mutex> lock(jobMutex);
+            job->done = true;
+        }
+        doneCondition.notify_all();
+    }
+}
+
+void ParallelDeflate::Compress(Job& job)
+{
+    const unsigned char* block = job.input.data() + job.dictionarySize;
+    uInt blockSize = static_cast<uInt>(job.input.size() - job.dictionarySize);
+    job.adler = adler32(adler32(0, Z_NULL, 0), block, blockSize);
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    // a raw deflate stream: the zlib header and trailer are written by
+    // the main thread
+    job.error = deflateInit2(&stream, job.level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+    if (job.error != Z_OK)
+    {
+        return;
+    }
+    if (job.dictionarySize > 0)
+    {
+        job.error = deflateSetDictionary(&stream, job.input.data(), static_cast<uInt>(job.dictionarySize));
+    }
+    if (job.error == Z_OK)
+    {
+        // a sync flush ends the block on a byte boundary, so that the next
+        // block can be appended
+        job.output.resize(deflateBound(&stream, blockSize) + 16);
+        stream.next_in = const_cast<unsigned char*>(block);
+        stream.avail_in = blockSize;
+        stream.next_out = job.output.data();
+        stream.avail_out = static_cast<uInt>(job.output.size());
+        int err = deflate(&stream, job.last ? Z_FINISH : Z_SYNC_FLUSH);
+        if (job.last ? err != Z_STREAM_END : (err != Z_OK || stream.avail_in != 0))
+        {
+            job.error = err == Z_OK || err == Z_STREAM_END ? Z_BUF_ERROR : err;
+        }
+        job.output.resize(job.output.size() - stream.avail_out);
+    }
+    deflateEnd(&stream);
+}
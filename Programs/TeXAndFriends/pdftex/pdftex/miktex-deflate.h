@@ -0,0 +1,111 @@
+/**
+ * @file miktex-deflate.h
+ * @author Christian Schenk
+ * @brief Parallel deflate compression
+ *
+ * @copyright Copyright © 2022 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+/**
+ * @brief Compresses a stream on worker threads.
+ *
+ * The input is split into blocks which are compressed independently (with
+ * the tail of the preceding block as the dictionary) and concatenated to a
+ * single zlib stream.
+ *
+ * Short streams are compressed on the calling thread.
+ */
+class ParallelDeflate
+{
+public:
+    typedef std::function<void(const unsigned char* data, std::size_t size)> OutputFunc;
+
+    ParallelDeflate(OutputFunc output);
+    ParallelDeflate(const ParallelDeflate& other) = delete;
+    ParallelDeflate& operator=(const ParallelDeflate& other) = delete;
+    ~ParallelDeflate() noexcept;
+
+    /**
+     * @brief Checks whether there are enough processors.
+     */
+    static bool IsSupported();
+
+    /**
+     * @brief Starts a new stream.
+     * @param level The compression level.
+     */
+    void Begin(int level);
+
+    /**
+     * @brief Adds data to the current stream.
+     *
+     * Compressed data is delivered to the output function as soon as it is
+     * available.
+     */
+    void Write(const void* data, std::size_t size);
+
+    /**
+     * @brief Finishes the current stream.
+     * @return Returns the length of the compressed stream.
+     */
+    std::size_t Finish();
+
+private:
+    struct Job
+    {
+        // the dictionary, followed by the block
+        std::vector<unsigned char> input;
+        std::size_t dictionarySize = 0;
+        int level = 0;
+        bool last = false;
+        std::vector<unsigned char> output;
+        uLong adler = 0;
+        int error = Z_OK;
+        bool done = false;
+    };
+
+    void Submit(bool last);
+    void Collect(bool wait);
+    void CompressSerially();
+    void Put(const unsigned char* data, std::size_t size);
+    void Run();
+    static void Compress(Job& job);
+
+    OutputFunc output;
+    int level = 0;
+    // the uncompressed data which has not yet been submitted
+    std::vector<unsigned char> input;
+    std::vector<unsigned char> dictionary;
+    bool submittedBlocks = false;
+    uLong adler = 0;
+    std::size_t length = 0;
+    // the submitted jobs (in stream order)
+    std::deque<std::shared_ptr<Job>> pendingJobs;
+    z_stream serialStream;
+    bool haveSerialStream = false;
+    int serialStreamLevel = 0;
+    std::vector<std::thread> workers;
+    std::deque<std::shared_ptr<Job>> jobQueue;
+    std::mutex jobMutex;
+    std::condition_variable jobCondition;
+    std::condition_variable doneCondition;
+    bool stopRequested = false;
+};
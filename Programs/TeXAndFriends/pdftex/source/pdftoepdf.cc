@@ -163,11 +163,23 @@ struct PdfDocument {
     InObj *inObjList;
     int occurences;             // number of references to the document; the doc can be
     // deleted when this is negative
+#if defined(MIKTEX)
+    unsigned long lastUse;      // for evicting the least recently used document
+#endif
     PdfDocument *next;
 };
 
 static PdfDocument *pdfDocuments = 0;
 
+#if defined(MIKTEX)
+// Documents which are not referenced anymore are kept open, so that
+// including more pages of the same file (e.g., \includepdf) neither
+// parses the file again nor writes the shared resources (fonts, images)
+// again.  At most MAX_UNUSED_DOCUMENTS such documents are kept.
+#define MAX_UNUSED_DOCUMENTS 4
+static unsigned long useCounter = 0;
+#endif
+
 static XRef *xref = 0;
 
 // Returns pointer to PdfDocument record for PDF file.
@@ -182,12 +194,18 @@ static PdfDocument *find_add_document(char *file_name)
     if (p) {
         xref = p->xref;
         (p->occurences)++;
+#if defined(MIKTEX)
+        p->lastUse = ++useCounter;
+#endif
         return p;
     }
     p = new PdfDocument;
     p->file_name = xstrdup(file_name);
     p->xref = xref = 0;
     p->occurences = 0;
+#if defined(MIKTEX)
+    p->lastUse = ++useCounter;
+#endif
     GString *docName = new GString(p->file_name);
     p->doc = new PDFDoc(docName);       // takes ownership of docName
     if (!p->doc->isOk() || !p->doc->okToPrint()) {
@@ -1074,9 +1092,33 @@ void epdf_delete()
 {
     PdfDocument *pdf_doc = (PdfDocument *) epdf_doc;
     xref = pdf_doc->xref;
+#if defined(MIKTEX)
+    // keep the document; evict the least recently used documents which
+    // are not referenced anymore
+    GBool evicted = gFalse;
+    for (;;) {
+        PdfDocument *p, *lru = 0;
+        int unused = 0;
+        for (p = pdfDocuments; p; p = p->next) {
+            if (p->occurences < 0) {
+                unused++;
+                if (lru == 0 || p->lastUse < lru->lastUse)
+                    lru = p;
+            }
+        }
+        if (unused <= MAX_UNUSED_DOCUMENTS)
+            break;
+        if (lru == pdf_doc)
+            evicted = gTrue;
+        delete_document(lru);
+    }
+    if (!evicted)
+        xref = pdf_doc->xref;
+#else
     if (pdf_doc->occurences < 0) {
         delete_document(pdf_doc);
     }
+#endif
 }
 
 // Called when PDF embedding system is finalized.
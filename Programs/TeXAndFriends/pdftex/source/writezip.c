@@ -21,6 +21,8 @@ with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "zlib.h"
 #if defined(MIKTEX)
 #define assert MIKTEX_ASSERT
+#include <memory>
+#include "miktex-deflate.h"
 #else
 #include <assert.h>
 #endif
@@ -34,6 +36,17 @@ with this program.  If not, see <http://www.gnu.org/licenses/>.
 static char *zipbuf = NULL;
 static z_stream c_stream;       /* compression stream */
 
+#if defined(MIKTEX)
+static std::unique_ptr<ParallelDeflate> parallel_deflate;
+static boolean parallel_deflate_active = false;
+
+static void write_zip_output(const unsigned char *data, size_t size)
+{
+    pdfgone += xfwrite(const_cast<unsigned char *>(data), 1, size, pdffile);
+    pdflastbyte = data[size - 1];
+}
+#endif
+
 void writezip(boolean finish)
 {
     int err;
@@ -41,6 +54,23 @@ void writezip(boolean finish)
     int level = getpdfcompresslevel();
     assert(level > 0);
     cur_file_name = NULL;
+#if defined(MIKTEX)
+    if (ParallelDeflate::IsSupported()) {
+        if (!parallel_deflate_active) {
+            if (parallel_deflate == nullptr)
+                parallel_deflate = std::make_unique<ParallelDeflate>(write_zip_output);
+            parallel_deflate->Begin(level);
+            parallel_deflate_active = true;
+        }
+        parallel_deflate->Write(pdfbuf, pdfptr);
+        if (finish) {
+            pdfstreamlength = parallel_deflate->Finish();
+            parallel_deflate_active = false;
+            xfflush(pdffile);
+        }
+        return;
+    }
+#endif
     if (pdfstreamlength == 0) {
         if (zipbuf == NULL) {
             zipbuf = xtalloc(ZIP_BUF_SIZE, char);
@@ -92,6 +122,10 @@ void writezip(boolean finish)
 
 void zip_free(void)
 {
+#if defined(MIKTEX)
+    parallel_deflate = nullptr;
+    parallel_deflate_active = false;
+#endif
     if (zipbuf != NULL) {
         check_err(deflateEnd(&c_stream), "deflateEnd");
         free(zipbuf);
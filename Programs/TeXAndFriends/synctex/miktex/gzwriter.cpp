@@ -0,0 +1,238 @@
+/**
+ * @file miktex/gzwriter.cpp
+ * @author Christian Schenk
+ * @brief Buffered gzip writer for SyncTeX
+ *
+ * @copyright Copyright © 2023 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#include <cstdarg>
+#include <cstdio>
+
+#include <chrono>
+#include <deque>
+#include <future>
+#include <string>
+#include <thread>
+
+#include <zlib.h>
+
+#include <miktex/Core/Debug>
+#include <miktex/Core/File>
+#include <miktex/Core/Session>
+#include <miktex/Util/PathName>
+
+#include "gzwriter.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+// the size of the blocks which are compressed independently
+const size_t BLOCK_SIZE = 1024 * 1024;
+
+// the number of blocks which are compressed at the same time
+const size_t MAX_PENDING_BLOCKS = 4;
+
+namespace
+{
+    class GzWriter
+    {
+    public:
+        GzWriter(FILE* file, int level) :
+            file(file),
+            level(level),
+            async(thread::hardware_concurrency() > 1)
+        {
+            buffer.reserve(BLOCK_SIZE + 1024);
+        }
+
+        GzWriter(const GzWriter& other) = delete;
+        GzWriter& operator=(const GzWriter& other) = delete;
+
+        ~GzWriter() noexcept
+        {
+            for (future<string>& f : pending)
+            {
+                f.wait();
+            }
+            if (file != nullptr)
+            {
+                fclose(file);
+            }
+        }
+
+        int Printf(const char* format, va_list args)
+        {
+            char buf[1024];
+            va_list args2;
+            va_copy(args2, args);
+            int n = vsnprintf(buf, sizeof(buf), format, args);
+            if (n < 0)
+            {
+                va_end(args2);
+                return 0;
+            }
+            if (static_cast<size_t>(n) < sizeof(buf))
+            {
+                buffer.append(buf, n);
+            }
+            else
+            {
+                size_t oldSize = buffer.size();
+                buffer.resize(oldSize + n + 1);
+                vsnprintf(&buffer[oldSize], n + 1, format, args2);
+                buffer.resize(oldSize + n);
+            }
+            va_end(args2);
+            if (buffer.size() >= BLOCK_SIZE)
+            {
+                Submit();
+            }
+            return failed ? 0 : n;
+        }
+
+        int Close()
+        {
+            if (!buffer.empty() || !haveOutput)
+            {
+                Submit();
+            }
+            while (!pending.empty())
+            {
+                Collect();
+            }
+            int ret = failed ? Z_ERRNO : Z_OK;
+            if (fclose(file) != 0)
+            {
+                ret = Z_ERRNO;
+            }
+            file = nullptr;
+            return ret;
+        }
+
+    private:
+        void Submit()
+        {
+            haveOutput = true;
+            string block;
+            block.swap(buffer);
+            buffer.reserve(BLOCK_SIZE + 1024);
+            if (!async)
+            {
+                Write(Compress(block, level));
+                return;
+            }
+            // collect finished blocks in order, to keep the memory footprint
+            // small
+            while (!pending.empty() && (pending.size() >= MAX_PENDING_BLOCKS || pending.front().wait_for(chrono::seconds(0)) == future_status::ready))
+            {
+                Collect();
+            }
+            pending.push_back(std::async(launch::async, &GzWriter::Compress, std::move(block), level));
+        }
+
+        void Collect()
+        {
+            try
+            {
+                Write(pending.front().get());
+            }
+            catch (const exception&)
+            {
+                failed = true;
+            }
+            pending.pop_front();
+        }
+
+        void Write(const string& data)
+        {
+            if (!failed && fwrite(data.data(), 1, data.size(), file) != data.size())
+            {
+                failed = true;
+            }
+        }
+
+        // compresses a block into a gzip member
+        static string Compress(string block, int level)
+        {
+            z_stream stream = {};
+            if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                MIKTEX_UNEXPECTED();
+            }
+            string result(deflateBound(&stream, static_cast<uLong>(block.size())), '\0');
+            stream.next_in = reinterpret_cast<Bytef*>(&block[0]);
+            stream.avail_in = static_cast<uInt>(block.size());
+            stream.next_out = reinterpret_cast<Bytef*>(&result[0]);
+            stream.avail_out = static_cast<uInt>(result.size());
+            int err = deflate(&stream, Z_FINISH);
+            result.resize(result.size() - stream.avail_out);
+            deflateEnd(&stream);
+            if (err != Z_STREAM_END)
+            {
+                MIKTEX_UNEXPECTED();
+            }
+            return result;
+        }
+
+        FILE* file;
+        int level;
+        bool async;
+        bool failed = false;
+        bool haveOutput = false;
+        string buffer;
+        deque<future<string>> pending;
+    };
+}
+
+void* miktex_synctex_gzopen(const char* path, const char* mode)
+{
+    MIKTEX_ASSERT_STRING(path);
+    MIKTEX_ASSERT_STRING(mode);
+    int level = Z_DEFAULT_COMPRESSION;
+    for (const char* m = mode; *m != 0; ++m)
+    {
+        if (*m >= '0' && *m <= '9')
+        {
+            level = *m - '0';
+        }
+    }
+    FILE* file;
+    try
+    {
+        file = File::Open(PathName(path), FileMode::Create, FileAccess::Write, false);
+    }
+    catch (const exception&)
+    {
+        return nullptr;
+    }
+    return new GzWriter(file, level);
+}
+
+int miktex_synctex_gzprintf(void* file, const char* format, ...)
+{
+    MIKTEX_ASSERT(file != nullptr);
+    va_list args;
+    va_start(args, format);
+    int n = static_cast<GzWriter*>(file)->Printf(format, args);
+    va_end(args);
+    return n;
+}
+
+int miktex_synctex_gzclose(void* file)
+{
+    if (file == nullptr)
+    {
+        return Z_STREAM_ERROR;
+    }
+    GzWriter* writer = static_cast<GzWriter*>(file);
+    int ret = writer->Close();
+    delete writer;
+    return ret;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file miktex/gzwriter.h
+ * @author Christian Schenk
+ * @brief Buffered gzip writer for SyncTeX
+ *
+ * @copyright Copyright © 2023 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#pragma once
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*
+ * Drop-in replacements for gzopen(), gzprintf() and gzclose().  Records are
+ * collected in large blocks; each block is compressed on a background thread
+ * into a gzip member of its own.  zlib's gzread() (and thus the SyncTeX
+ * parser) reads the concatenated members as one stream.
+ */
+
+void* miktex_synctex_gzopen(const char* path, const char* mode);
+
+int miktex_synctex_gzprintf(void* file, const char* format, ...);
+
+int miktex_synctex_gzclose(void* file);
+
+#if defined(__cplusplus)
+}
+#endif
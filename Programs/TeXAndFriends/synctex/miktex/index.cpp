@@ -0,0 +1,516 @@
+/**
+ * @file miktex/index.cpp
+ * @author Christian Schenk
+ * @brief SyncTeX index
+ *
+ * @copyright Copyright © 2023 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Session>
+#include <miktex/Core/TemporaryFile>
+#include <miktex/Util/PathName>
+
+#include "index.h"
+
+using namespace std;
+
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+/*
+ * An index file holds:
+ *
+ *   signature version size time forms preamble inputs postamble
+ *   sheets lines
+ *
+ * size and time identify the state of the synctex file.  preamble is the
+ * text up to (and including) the "Content:" line, inputs are the "Input:"
+ * lines found in the content, postamble is the text starting with the
+ * "Postamble:" line.  sheets is the list of (page, offset, length) triples,
+ * lines the sorted list of (tag, line, page) triples.  Numbers are stored
+ * as 32-bit words (64-bit for sizes and offsets), strings are prefixed by
+ * their length.
+ */
+
+const uint32_t INDEX_SIGNATURE = 0x58495453; // 'STIX' (the x86 way)
+const uint32_t INDEX_VERSION = 1;
+
+// smaller synctex files are parsed as a whole
+const size_t MIN_INDEXED_FILE_SIZE = 256 * 1024;
+
+// the distance of the lines which are considered for a forward search
+const int32_t LINE_WINDOW = 100;
+
+namespace
+{
+    struct Sheet
+    {
+        int32_t page;
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    struct TagLinePage
+    {
+        int32_t tag;
+        int32_t line;
+        int32_t page;
+
+        bool operator<(const TagLinePage& other) const
+        {
+            return tag < other.tag
+                || (tag == other.tag && (line < other.line || (line == other.line && page < other.page)));
+        }
+
+        bool operator==(const TagLinePage& other) const
+        {
+            return tag == other.tag && line == other.line && page == other.page;
+        }
+    };
+
+    struct SyncTeXIndex
+    {
+        uint64_t size = 0;
+        int64_t time = 0;
+        // forms are not indexed: they are referenced by the sheets
+        bool hasForms = false;
+        string preamble;
+        string inputs;
+        string postamble;
+        vector<Sheet> sheets;
+        vector<TagLinePage> lines;
+    };
+}
+
+static unique_ptr<SyncTeXIndex> BuildIndex(const PathName& synctexFile)
+{
+    unique_ptr<SyncTeXIndex> index(new SyncTeXIndex);
+    gzFile file = gzopen(synctexFile.GetData(), "rb");
+    if (file == nullptr)
+    {
+        return nullptr;
+    }
+    enum { Preamble, Content, Postamble } section = Preamble;
+    Sheet sheet = { 0, 0, 0 };
+    string line;
+    uint64_t offset = 0;
+    auto onLine = [&]()
+    {
+        // the line includes the newline character
+        const char* text = line.c_str();
+        switch (section)
+        {
+        case Preamble:
+            index->preamble += line;
+            if (strncmp(text, "Content:", 8) == 0)
+            {
+                section = Content;
+            }
+            break;
+        case Content:
+            if (strncmp(text, "Postamble:", 10) == 0)
+            {
+                section = Postamble;
+                index->postamble += line;
+            }
+            else if (text[0] == '{')
+            {
+                sheet.page = atoi(text + 1);
+                sheet.offset = offset;
+            }
+            else if (text[0] == '}' && sheet.page > 0)
+            {
+                sheet.length = offset + line.length() - sheet.offset;
+                index->sheets.push_back(sheet);
+                sheet.page = 0;
+            }
+            else if (strncmp(text, "Input:", 6) == 0)
+            {
+                index->inputs += line;
+            }
+            else if (text[0] == '<')
+            {
+                index->hasForms = true;
+            }
+            else if (sheet.page > 0 && text[0] != 0 && strchr("[(vhkgr$x", text[0]) != nullptr)
+            {
+                // <type><tag>,<line>[,<column>]:...
+                char* end;
+                long tag = strtol(text + 1, &end, 10);
+                if (*end == ',')
+                {
+                    TagLinePage entry{ static_cast<int32_t>(tag), static_cast<int32_t>(strtol(end + 1, nullptr, 10)), sheet.page };
+                    if (index->lines.empty() || !(index->lines.back() == entry))
+                    {
+                        index->lines.push_back(entry);
+                    }
+                }
+            }
+            break;
+        case Postamble:
+            index->postamble += line;
+            break;
+        }
+        offset += line.length();
+        line.clear();
+    };
+    vector<char> buf(1024 * 1024);
+    int n;
+    while ((n = gzread(file, &buf[0], static_cast<unsigned>(buf.size()))) > 0)
+    {
+        const char* start = &buf[0];
+        const char* end = start + n;
+        while (start < end)
+        {
+            const char* nl = static_cast<const char*>(memchr(start, '\n', end - start));
+            if (nl == nullptr)
+            {
+                line.append(start, end);
+                break;
+            }
+            line.append(start, nl + 1);
+            onLine();
+            start = nl + 1;
+        }
+    }
+    gzclose(file);
+    if (n < 0 || section != Postamble)
+    {
+        return nullptr;
+    }
+    if (!line.empty())
+    {
+        onLine();
+    }
+    sort(index->lines.begin(), index->lines.end());
+    index->lines.erase(unique(index->lines.begin(), index->lines.end()), index->lines.end());
+    return index;
+}
+
+static void WriteIndex(const PathName& path, const SyncTeXIndex& index)
+{
+    string data;
+    auto write = [&data](const void* buf, size_t n)
+    {
+        data.append(reinterpret_cast<const char*>(buf), n);
+    };
+    auto writeWord = [&write](uint32_t word)
+    {
+        write(&word, sizeof(word));
+    };
+    auto writeWord64 = [&write](uint64_t word64)
+    {
+        write(&word64, sizeof(word64));
+    };
+    auto writeString = [&write, &writeWord64](const string& s)
+    {
+        writeWord64(s.length());
+        write(s.data(), s.length());
+    };
+    writeWord(INDEX_SIGNATURE);
+    writeWord(INDEX_VERSION);
+    writeWord64(index.size);
+    writeWord64(static_cast<uint64_t>(index.time));
+    writeWord(index.hasForms ? 1 : 0);
+    writeString(index.preamble);
+    writeString(index.inputs);
+    writeString(index.postamble);
+    writeWord64(index.sheets.size());
+    for (const Sheet& sheet : index.sheets)
+    {
+        writeWord(static_cast<uint32_t>(sheet.page));
+        writeWord64(sheet.offset);
+        writeWord64(sheet.length);
+    }
+    writeWord64(index.lines.size());
+    for (const TagLinePage& entry : index.lines)
+    {
+        writeWord(static_cast<uint32_t>(entry.tag));
+        writeWord(static_cast<uint32_t>(entry.line));
+        writeWord(static_cast<uint32_t>(entry.page));
+    }
+    Directory::Create(path.GetDirectoryName());
+    // another process might read the index file at the same time
+    PathName tmpPath(path);
+    tmpPath.AppendExtension(".tmp");
+    unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create(tmpPath);
+    FileStream stream(File::Open(tmpPath, FileMode::Create, FileAccess::Write, false));
+    stream.Write(data.data(), data.length());
+    stream.Close();
+    File::Move(tmpPath, path, { FileMoveOption::ReplaceExisting });
+    tmpFile->Keep();
+}
+
+static unique_ptr<SyncTeXIndex> ReadIndex(const PathName& path, uint64_t size, int64_t time)
+{
+    FileStream stream(File::Open(path, FileMode::Open, FileAccess::Read, false));
+    auto read = [&stream](void* buf, size_t n)
+    {
+        if (stream.Read(buf, n) != n)
+        {
+            MIKTEX_UNEXPECTED();
+        }
+    };
+    auto readWord = [&read]()
+    {
+        uint32_t word;
+        read(&word, sizeof(word));
+        return word;
+    };
+    auto readWord64 = [&read]()
+    {
+        uint64_t word64;
+        read(&word64, sizeof(word64));
+        return word64;
+    };
+    auto readString = [&read, &readWord64](string& s)
+    {
+        s.resize(readWord64());
+        if (!s.empty())
+        {
+            read(&s[0], s.length());
+        }
+    };
+    if (readWord() != INDEX_SIGNATURE || readWord() != INDEX_VERSION)
+    {
+        return nullptr;
+    }
+    unique_ptr<SyncTeXIndex> index(new SyncTeXIndex);
+    index->size = readWord64();
+    index->time = static_cast<int64_t>(readWord64());
+    if (index->size != size || index->time != time)
+    {
+        return nullptr;
+    }
+    index->hasForms = readWord() != 0;
+    readString(index->preamble);
+    readString(index->inputs);
+    readString(index->postamble);
+    index->sheets.resize(readWord64());
+    for (Sheet& sheet : index->sheets)
+    {
+        sheet.page = static_cast<int32_t>(readWord());
+        sheet.offset = readWord64();
+        sheet.length = readWord64();
+    }
+    index->lines.resize(readWord64());
+    for (TagLinePage& entry : index->lines)
+    {
+        entry.tag = static_cast<int32_t>(readWord());
+        entry.line = static_cast<int32_t>(readWord());
+        entry.page = static_cast<int32_t>(readWord());
+    }
+    stream.Close();
+    return index;
+}
+
+static unique_ptr<SyncTeXIndex> GetIndex(const PathName& synctexFile)
+{
+    shared_ptr<Session> session = Session::TryGet();
+    if (session == nullptr)
+    {
+        return nullptr;
+    }
+    uint64_t size = File::GetSize(synctexFile);
+    if (size < MIN_INDEXED_FILE_SIZE)
+    {
+        return nullptr;
+    }
+    int64_t time = static_cast<int64_t>(File::GetLastWriteTime(synctexFile));
+    PathName absPath(synctexFile);
+    absPath.MakeFullyQualified();
+    PathName indexFile = session->GetSpecialPath(SpecialPath::UserDataRoot)
+        / PathName(MIKTEX_PATH_MIKTEX_CACHE_DIR)
+        / PathName("synctex")
+        / PathName(MD5::FromChars(absPath.ToString()).ToString() + ".idx");
+    unique_ptr<SyncTeXIndex> index;
+    if (File::Exists(indexFile))
+    {
+        index = ReadIndex(indexFile, size, time);
+    }
+    if (index == nullptr)
+    {
+        index = BuildIndex(synctexFile);
+        if (index == nullptr)
+        {
+            return nullptr;
+        }
+        index->size = size;
+        index->time = time;
+        WriteIndex(indexFile, *index);
+    }
+    return index;
+}
+
+// finds the synctex file the way the parser does
+static bool FindSyncTeXFile(const char* output, const char* buildDirectory, PathName& synctexFile)
+{
+    synctex_scanner_p scanner = synctex_scanner_new_with_output_file(output, buildDirectory, 0);
+    if (scanner == nullptr)
+    {
+        return false;
+    }
+    synctexFile = synctex_scanner_get_synctex(scanner);
+    synctex_scanner_free(scanner);
+    return !synctexFile.Empty();
+}
+
+// writes an excerpt of the synctex file, which contains the given sheets,
+// and parses it
+static synctex_scanner_p NewScanner(const char* output, const PathName& synctexFile, const SyncTeXIndex& index, vector<Sheet> sheets)
+{
+    unique_ptr<TemporaryFile> tmpFile = TemporaryFile::Create();
+    FileStream stream(File::Open(tmpFile->GetPathName(), FileMode::Create, FileAccess::Write, false));
+    stream.Write(index.preamble.data(), index.preamble.length());
+    stream.Write(index.inputs.data(), index.inputs.length());
+    if (!sheets.empty())
+    {
+        sort(sheets.begin(), sheets.end(), [](const Sheet& a, const Sheet& b) { return a.offset < b.offset; });
+        gzFile file = gzopen(synctexFile.GetData(), "rb");
+        if (file == nullptr)
+        {
+            return nullptr;
+        }
+        vector<char> buf;
+        for (const Sheet& sheet : sheets)
+        {
+            buf.resize(sheet.length);
+            if (gzseek(file, static_cast<z_off_t>(sheet.offset), SEEK_SET) != static_cast<z_off_t>(sheet.offset)
+                || gzread(file, &buf[0], static_cast<unsigned>(buf.size())) != static_cast<int>(buf.size()))
+            {
+                gzclose(file);
+                return nullptr;
+            }
+            stream.Write(&buf[0], buf.size());
+        }
+        gzclose(file);
+    }
+    stream.Write(index.postamble.data(), index.postamble.length());
+    stream.Close();
+    // the excerpt is not needed anymore when the scanner has parsed it
+    return miktex_synctex_scanner_new_with_synctex_file(output, tmpFile->GetPathName().GetData());
+}
+
+synctex_scanner_p miktex_synctex_index_new_view_scanner(const char* output, const char* buildDirectory, const char* input, int line)
+{
+    try
+    {
+        PathName synctexFile;
+        if (!FindSyncTeXFile(output, buildDirectory, synctexFile))
+        {
+            return nullptr;
+        }
+        unique_ptr<SyncTeXIndex> index = GetIndex(synctexFile);
+        if (index == nullptr || index->hasForms)
+        {
+            return nullptr;
+        }
+        // let the parser resolve the input file name
+        synctex_scanner_p scanner = NewScanner(output, synctexFile, *index, {});
+        if (scanner == nullptr)
+        {
+            return nullptr;
+        }
+        int tag = synctex_scanner_get_tag(scanner, input);
+        synctex_scanner_free(scanner);
+        if (tag == 0)
+        {
+            return nullptr;
+        }
+        // the parser looks for the nearest line which has records (trying
+        // up to 100 lines), but not beyond the last line of the input
+        // file: use the pages with records of nearby lines and the pages
+        // with records of the last line
+        auto begin = lower_bound(index->lines.begin(), index->lines.end(), TagLinePage{ tag, INT32_MIN, INT32_MIN });
+        auto end = upper_bound(begin, index->lines.end(), TagLinePage{ tag, INT32_MAX, INT32_MAX });
+        if (begin == end)
+        {
+            return nullptr;
+        }
+        set<int32_t> pages;
+        for (auto it = lower_bound(begin, end, TagLinePage{ tag, line - LINE_WINDOW, INT32_MIN }); it != end && it->line <= line + LINE_WINDOW; ++it)
+        {
+            pages.insert(it->page);
+        }
+        int32_t maxLine = (end - 1)->line;
+        for (auto it = end; it != begin && (it - 1)->line == maxLine; --it)
+        {
+            pages.insert((it - 1)->page);
+        }
+        vector<Sheet> sheets;
+        for (const Sheet& sheet : index->sheets)
+        {
+            if (pages.find(sheet.page) != pages.end())
+            {
+                sheets.push_back(sheet);
+            }
+        }
+        if (sheets.empty())
+        {
+            return nullptr;
+        }
+        return NewScanner(output, synctexFile, *index, sheets);
+    }
+    catch (const exception&)
+    {
+        return nullptr;
+    }
+}
+
+synctex_scanner_p miktex_synctex_index_new_edit_scanner(const char* output, const char* buildDirectory, int page)
+{
+    try
+    {
+        PathName synctexFile;
+        if (!FindSyncTeXFile(output, buildDirectory, synctexFile))
+        {
+            return nullptr;
+        }
+        unique_ptr<SyncTeXIndex> index = GetIndex(synctexFile);
+        if (index == nullptr || index->hasForms)
+        {
+            return nullptr;
+        }
+        vector<Sheet> sheets;
+        for (const Sheet& sheet : index->sheets)
+        {
+            if (sheet.page == page)
+            {
+                sheets.push_back(sheet);
+            }
+        }
+        if (sheets.empty())
+        {
+            return nullptr;
+        }
+        return NewScanner(output, synctexFile, *index, sheets);
+    }
+    catch (const exception&)
+    {
+        return nullptr;
+    }
+}
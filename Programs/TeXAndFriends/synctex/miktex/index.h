@@ -0,0 +1,38 @@
+/**
+ * @file miktex/index.h
+ * @author Christian Schenk
+ * @brief SyncTeX index
+ *
+ * @copyright Copyright © 2023 Christian Schenk
+ *
+ * This file is free software; the copyright holder gives unlimited permission
+ * to copy and/or distribute it, with or without modifications, as long as this
+ * notice is preserved.
+ */
+
+#pragma once
+
+#include "../source/synctex_parser.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*
+ * The index of a synctex file records where the sheets are and which input
+ * lines contributed to which sheets.  It is built when the synctex file is
+ * queried for the first time and kept in the cache directory until the
+ * synctex file changes.
+ *
+ * These functions return a scanner which has parsed only the sheets which
+ * are relevant for the query.  They return NULL, if the caller should
+ * parse the whole synctex file.
+ */
+
+synctex_scanner_p miktex_synctex_index_new_view_scanner(const char* output, const char* build_directory, const char* input, int line);
+
+synctex_scanner_p miktex_synctex_index_new_edit_scanner(const char* output, const char* build_directory, int page);
+
+#if defined(__cplusplus)
+}
+#endif
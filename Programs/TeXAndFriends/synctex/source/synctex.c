@@ -451,6 +451,14 @@ char *SYNCTEX_GET_LOG_NAME()
 
 #if defined(MIKTEX)
 #include <miktex/W2C/Emulation.h> /* output_directory */
+/* compress on a background thread */
+#include "../miktex/gzwriter.h"
+#undef gzopen
+#undef gzprintf
+#undef gzclose
+#define gzopen miktex_synctex_gzopen
+#define gzprintf miktex_synctex_gzprintf
+#define gzclose miktex_synctex_gzclose
 #endif
 typedef void (*synctex_recorder_t) (halfword);  /* recorders know how to record a node */
 typedef int (*synctex_fprintf_t) (void *, const char *, ...);   /* print formatted to either FILE * or gzFile */
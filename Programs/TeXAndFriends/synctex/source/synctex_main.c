@@ -66,6 +66,7 @@
 #endif
 #if defined(MIKTEX)
 #include <miktex/Core/c/api.h>
+#include "../miktex/index.h"
 #endif
 #   ifdef __linux__
 #       define _ISOC99_SOURCE /* to get the fmax() prototype */
@@ -414,6 +415,15 @@ int synctex_view_proceed(synctex_view_params_t * Ps) {
         synctex_help_view("Viewer command is too long");
         return -1;
     }
+#if defined(MIKTEX)
+    /* only the relevant pages are parsed if the synctex file is indexed */
+    scanner = miktex_synctex_index_new_view_scanner(Ps->output,Ps->directory,Ps->input,Ps->line);
+    if(scanner && synctex_display_query(scanner,Ps->input,Ps->line,Ps->column,Ps->page) <= 0) {
+        synctex_scanner_free(scanner);
+        scanner = NULL;
+    }
+    if(NULL == scanner)
+#endif
     scanner = synctex_scanner_new_with_output_file(Ps->output,Ps->directory,1);
     if(scanner && synctex_display_query(scanner,Ps->input,Ps->line,Ps->column,Ps->page)) {
         synctex_node_p node = NULL;
@@ -701,6 +711,15 @@ int synctex_edit_proceed(synctex_edit_params_t * Ps) {
     printf("offset:%u\n",Ps->offset);
     printf("context:%s\n",Ps->context);
     printf("cwd:%s\n",getcwd(NULL,0));
+#endif
+#if defined(MIKTEX)
+    /* only the given page is parsed if the synctex file is indexed */
+    scanner = miktex_synctex_index_new_edit_scanner(Ps->output,Ps->directory,Ps->page);
+    if(scanner && synctex_edit_query(scanner,Ps->page,Ps->x,Ps->y) <= 0) {
+        synctex_scanner_free(scanner);
+        scanner = NULL;
+    }
+    if(NULL == scanner)
 #endif
     scanner = synctex_scanner_new_with_output_file(Ps->output,Ps->directory,1);
     if(NULL == scanner) {
@@ -6076,6 +6076,38 @@ synctex_scanner_p synctex_scanner_new_with_output_file(const char * output, cons
     return NULL;
 }
 
+#if defined(MIKTEX)
+/*  Where a scanner is created for a synctex file which does not follow
+ *  the naming convention, e.g., an excerpt of the real one.  The names of
+ *  the input files are resolved relative to output, as usual. */
+synctex_scanner_p miktex_synctex_scanner_new_with_synctex_file(const char * output, const char * synctex) {
+    synctex_scanner_p scanner = synctex_scanner_new();
+    synctex_reader_p reader;
+    if (NULL == scanner) {
+        _synctex_error("malloc problem");
+        return NULL;
+    }
+    reader = scanner->reader;
+    reader->output = (char *)_synctex_malloc(strlen(output)+1);
+    reader->synctex = (char *)_synctex_malloc(strlen(synctex)+1);
+    reader->min_size = SYNCTEX_BUFFER_MIN_SIZE;
+    reader->size = SYNCTEX_BUFFER_SIZE;
+    reader->start = reader->current = (char *)_synctex_malloc(reader->size+1);
+    if (NULL == reader->output || NULL == reader->synctex || NULL == reader->start
+        || NULL == (reader->file = gzopen(synctex, "rb"))) {
+        synctex_scanner_free(scanner);
+        return NULL;
+    }
+    strcpy(reader->output, output);
+    strcpy(reader->synctex, synctex);
+    reader->end = reader->start+reader->size;
+#   if defined(SYNCTEX_USE_CHARINDEX)
+    reader->charindex_offset = -reader->size;
+#   endif
+    return synctex_scanner_parse(scanner);
+}
+#endif
+
 /*  The scanner destructor
  */
 int synctex_scanner_free(synctex_scanner_p scanner) {
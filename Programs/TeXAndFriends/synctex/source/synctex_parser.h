@@ -109,6 +109,14 @@ extern "C" {
      *      of an error or non existent file.
      */
     synctex_scanner_p synctex_scanner_new_with_output_file(const char * output, const char * build_directory, int parse);
+
+#if defined(MIKTEX)
+    /**
+     *  Creates a scanner which parses the given synctex file instead of
+     *  the one which belongs to output.
+     */
+    synctex_scanner_p miktex_synctex_scanner_new_with_synctex_file(const char * output, const char * synctex);
+#endif
     
     /**
      *  Designated method to delete a synctex scanner object,
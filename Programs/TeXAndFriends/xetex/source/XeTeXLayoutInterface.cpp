@@ -104,6 +104,118 @@ cacheGlyphBBox(uint16_t fontID, uint16_t glyphID, const GlyphBBox* bbox)
 }
 /*******************************************************************/
 
+#if defined(MIKTEX)
+/*******************************************************************/
+/* Shaping cache to avoid reshaping the same runs over and over    */
+/*******************************************************************/
+#include <cstring>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// maximum number of shaped runs to remember
+const size_t SHAPING_CACHE_SIZE = 16384;
+
+struct ShapingResult
+{
+    XeTeXLayoutEngine engine;
+    std::vector<hb_glyph_info_t> infos;
+    std::vector<hb_glyph_position_t> positions;
+    hb_segment_properties_t props;
+    std::string shaper;
+};
+
+typedef std::list<std::pair<std::string, ShapingResult>> ShapingResultList;
+
+// most recently used first
+static ShapingResultList sShapingResults;
+static std::unordered_map<std::string, ShapingResultList::iterator> sShapingCache;
+
+// the layout engine stands for the font instance, the features, the
+// script and the language; the shaping context is the whole text
+static std::string
+makeShapingCacheKey(XeTeXLayoutEngine engine, const uint16_t chars[], int32_t offset, int32_t count, int32_t max,
+                    hb_direction_t direction)
+{
+    std::string key;
+    key.reserve(sizeof(engine) + sizeof(direction) + 3 * sizeof(int32_t) + max * sizeof(uint16_t));
+    key.append((const char*)&engine, sizeof(engine));
+    key.append((const char*)&direction, sizeof(direction));
+    key.append((const char*)&offset, sizeof(offset));
+    key.append((const char*)&count, sizeof(count));
+    key.append((const char*)&max, sizeof(max));
+    key.append((const char*)chars, max * sizeof(uint16_t));
+    return key;
+}
+
+static void
+setShaper(XeTeXLayoutEngine engine, const char* shaper)
+{
+    if (engine->shaper == NULL || strcmp(engine->shaper, shaper) != 0) {
+        free(engine->shaper);
+        engine->shaper = strdup(shaper);
+    }
+}
+
+// fill the HarfBuzz buffer as if the run had been shaped
+static bool
+lookupShapingCache(XeTeXLayoutEngine engine, const std::string& key)
+{
+    auto it = sShapingCache.find(key);
+    if (it == sShapingCache.end())
+        return false;
+    sShapingResults.splice(sShapingResults.begin(), sShapingResults, it->second);
+    const ShapingResult& result = it->second->second;
+    unsigned int glyphCount = result.infos.size();
+    hb_buffer_reset(engine->hbBuffer);
+    hb_buffer_set_segment_properties(engine->hbBuffer, &result.props);
+    hb_buffer_set_content_type(engine->hbBuffer, HB_BUFFER_CONTENT_TYPE_GLYPHS);
+    if (!hb_buffer_set_length(engine->hbBuffer, glyphCount))
+        return false;
+    if (glyphCount > 0) {
+        memcpy(hb_buffer_get_glyph_infos(engine->hbBuffer, NULL), &result.infos[0], glyphCount * sizeof(hb_glyph_info_t));
+        memcpy(hb_buffer_get_glyph_positions(engine->hbBuffer, NULL), &result.positions[0], glyphCount * sizeof(hb_glyph_position_t));
+    }
+    setShaper(engine, result.shaper.c_str());
+    return true;
+}
+
+static void
+storeShapingCache(XeTeXLayoutEngine engine, std::string&& key)
+{
+    unsigned int glyphCount = hb_buffer_get_length(engine->hbBuffer);
+    hb_glyph_info_t* infos = hb_buffer_get_glyph_infos(engine->hbBuffer, NULL);
+    hb_glyph_position_t* positions = hb_buffer_get_glyph_positions(engine->hbBuffer, NULL);
+    ShapingResult result;
+    result.engine = engine;
+    result.infos.assign(infos, infos + glyphCount);
+    result.positions.assign(positions, positions + glyphCount);
+    hb_buffer_get_segment_properties(engine->hbBuffer, &result.props);
+    result.shaper = engine->shaper == NULL ? "" : engine->shaper;
+    if (sShapingResults.size() >= SHAPING_CACHE_SIZE) {
+        sShapingCache.erase(sShapingResults.back().first);
+        sShapingResults.pop_back();
+    }
+    sShapingResults.emplace_front(std::move(key), std::move(result));
+    sShapingCache[sShapingResults.front().first] = sShapingResults.begin();
+}
+
+static void
+purgeShapingCache(XeTeXLayoutEngine engine)
+{
+    for (auto it = sShapingResults.begin(); it != sShapingResults.end(); ) {
+        if (it->second.engine == engine) {
+            sShapingCache.erase(it->first);
+            it = sShapingResults.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+/*******************************************************************/
+#endif
+
 void
 terminatefontmanager()
 {
@@ -662,6 +774,9 @@ createLayoutEngine(PlatformFontRef fontRef, XeTeXFont font, hb_tag_t script, cha
 void
 deleteLayoutEngine(XeTeXLayoutEngine engine)
 {
+#if defined(MIKTEX)
+    purgeShapingCache(engine);
+#endif
     hb_buffer_destroy(engine->hbBuffer);
     delete engine->font;
     free(engine->shaper);
@@ -705,6 +820,12 @@ layoutChars(XeTeXLayoutEngine engine, uint16_t chars[], int32_t offset, int32_t
 
     script = hb_ot_tag_to_script (engine->script);
 
+#if defined(MIKTEX)
+    std::string cacheKey = makeShapingCacheKey(engine, chars, offset, count, max, direction);
+    if (lookupShapingCache(engine, cacheKey))
+        return hb_buffer_get_length(engine->hbBuffer);
+#endif
+
     hb_buffer_reset(engine->hbBuffer);
 
 #if !HB_VERSION_ATLEAST(2,5,0)
@@ -757,6 +878,10 @@ layoutChars(XeTeXLayoutEngine engine, uint16_t chars[], int32_t offset, int32_t
 
     hb_shape_plan_destroy(shape_plan);
 
+#if defined(MIKTEX)
+    storeShapingCache(engine, std::move(cacheKey));
+#endif
+
     int glyphCount = hb_buffer_get_length(engine->hbBuffer);
 
 #ifdef DEBUG
@@ -65,6 +65,7 @@ authorization from the copyright holders.
 #if defined(MIKTEX)
 #define C4PEXTERN extern
 #include "miktex-xetex.h"
+#include <map>
 #include <miktex/Core/CommandLineBuilder>
 #include <miktex/Core/FileType>
 #include <miktex/Core/Process>
@@ -629,6 +630,13 @@ printchars(const unsigned short* str, int len)
 #define UTF16_NATIVE kForm_UTF16LE
 #endif
 
+#if defined(MIKTEX)
+/* converters are never disposed, and a conversion always leaves the
+   converter in its initial state; so font instances can share the
+   converters of a mapping */
+static std::map<std::pair<std::string, char>, TECkit_Converter> loadedMappings;
+#endif
+
 static void*
 load_mapping_file(const char* s, const char* e, char byteMapping)
 {
@@ -638,6 +646,16 @@ load_mapping_file(const char* s, const char* e, char byteMapping)
     strncpy(buffer, s, e - s);
     buffer[e - s] = 0;
     strcat(buffer, ".tec");
+#if defined(MIKTEX)
+    auto loaded = loadedMappings.find({ buffer, byteMapping });
+    if (loaded != loadedMappings.end()) {
+        cnv = loaded->second;
+        if (gettracingfontsstate() > 1)
+            fontmappingwarning(buffer, strlen(buffer), 0); /* tracing */
+        free(buffer);
+        return cnv;
+    }
+#endif
     mapPath = kpse_find_file(buffer, kpse_miscfonts_format, 1);
 
     if (mapPath) {
@@ -669,6 +687,10 @@ load_mapping_file(const char* s, const char* e, char byteMapping)
             fontmappingwarning(buffer, strlen(buffer), 2); /* not loadable */
         else if (gettracingfontsstate() > 1)
             fontmappingwarning(buffer, strlen(buffer), 0); /* tracing */
+#if defined(MIKTEX)
+        if (cnv != NULL)
+            loadedMappings[{ buffer, byteMapping }] = cnv;
+#endif
     } else {
         fontmappingwarning(buffer, strlen(buffer), 1); /* not found */
     }
@@ -2773,6 +2795,9 @@ boolean open_dvi_output(C4P::FileRoot& dviFile)
       processStartInfo.Arguments.push_back(papersize);
     }
     processStartInfo.RedirectStandardInput = true;
+    // room for a few pages: the driver is busy with fonts and images now
+    // and then
+    processStartInfo.StandardInputPipeSize = 1024 * 1024;
     dvipdfmxProcess = MiKTeX::Core::Process::Start(processStartInfo);
     dviFile.Attach(dvipdfmxProcess->get_StandardInput(), true);
     MiKTeX::TeXAndFriends::WebAppInputLine::GetWebAppInputLine()->SetNameOfFile(outPath);
@@ -2883,6 +2908,7 @@ open_dvi_output(FILE** fptr)
 #if defined(MIKTEX)
 int dviclose(C4P::FileRoot& dviFile)
 {
+  MiKTeX::TeXAndFriends::TeXMFApp::GetTeXMFApp()->FlushOutputFile(dviFile);
   if (nopdfoutput)
   {
     MiKTeX::TeXAndFriends::WebAppInputLine::GetWebAppInputLine()->CloseFile(dviFile);
@@ -25,6 +25,8 @@ set(MIKTEX_CONFIG_VALUE_ALLOW_UNRESTRICTED_SUPER_USER "AllowUnrestrictedSuperUse
 set(MIKTEX_CONFIG_VALUE_ALLOWUNSAFEINPUTFILES "AllowUnsafeInputFiles")
 set(MIKTEX_CONFIG_VALUE_ALLOWUNSAFEOUTPUTFILES "AllowUnsafeOutputFiles")
 set(MIKTEX_CONFIG_VALUE_ALTEXTENSIONS "AltExtensions[]")
+set(MIKTEX_CONFIG_VALUE_ARCHIVE_CACHE_DIRECTORY "ArchiveCacheDirectory")
+set(MIKTEX_CONFIG_VALUE_ARCHIVE_CACHE_URL "ArchiveCacheUrl")
 set(MIKTEX_CONFIG_VALUE_AUTOADMIN "AutoAdmin")
 set(MIKTEX_CONFIG_VALUE_AUTOINSTALL "AutoInstall")
 set(MIKTEX_CONFIG_VALUE_COMMONLINKTARGETDIRECTORY "CommonLinkTargetDirectory")
@@ -33,6 +35,7 @@ set(MIKTEX_CONFIG_VALUE_COMMON_CONFIG "CommonConfig")
 set(MIKTEX_CONFIG_VALUE_COMMON_DATA "CommonData")
 set(MIKTEX_CONFIG_VALUE_COMMON_INSTALL "CommonInstall")
 set(MIKTEX_CONFIG_VALUE_COMMON_ROOTS "CommonRoots")
+set(MIKTEX_CONFIG_VALUE_COMPRESS "Compress")
 set(MIKTEX_CONFIG_VALUE_CONFIG "Config")
 set(MIKTEX_CONFIG_VALUE_CREATEAUXDIRECTORY "CreateAuxDirectory")
 set(MIKTEX_CONFIG_VALUE_CREATEOUTPUTDIRECTORY "CreateOutputDirectory")
@@ -55,6 +58,8 @@ set(MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE "LastUserUpdate")
 set(MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE_CHECK "LastUserUpdateCheck")
 set(MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE_DB  "LastUserUpdateDb")
 set(MIKTEX_CONFIG_VALUE_LOCAL_REPOSITORY "LocalRepository")
+set(MIKTEX_CONFIG_VALUE_MAX_CONCURRENT_DOWNLOADS "MaxConcurrentDownloads")
+set(MIKTEX_CONFIG_VALUE_MAX_MIRRORS "MaxMirrors")
 set(MIKTEX_CONFIG_VALUE_MIKTEXDIRECT_ROOT "MiKTeXDirectRoot")
 set(MIKTEX_CONFIG_VALUE_NO_REGISTRY "NoRegistry")
 set(MIKTEX_CONFIG_VALUE_OTHER_COMMON_ROOTS "OtherCommonRoots")
@@ -72,6 +77,7 @@ set(MIKTEX_CONFIG_VALUE_REMOTE_SERVICE "RemoteService_${rand}")
 set(MIKTEX_CONFIG_VALUE_RENEW_FORMATS_ON_UPDATE "RenewFormatsOnUpdate")
 set(MIKTEX_CONFIG_VALUE_REPOSITORY_RELEASE_STATE "RepositoryReleaseState")
 set(MIKTEX_CONFIG_VALUE_REPOSITORY_TYPE "RepositoryType")
+set(MIKTEX_CONFIG_VALUE_SHARED_CACHE_DIRECTORY "SharedCacheDirectory")
 set(MIKTEX_CONFIG_VALUE_SHARED_SETUP "SharedSetup")
 set(MIKTEX_CONFIG_VALUE_SHELLCOMMANDMODE "ShellCommandMode")
 set(MIKTEX_CONFIG_VALUE_STARTUP_FILE "StartupFile")
@@ -130,6 +130,7 @@ set(MIKTEX_REL_TEX_ETC_DIR              "Programs/TeXAndFriends/Knuth/etc")
 set(MIKTEX_REL_TEXIFY_DIR               "Programs/MiKTeX/texify")
 set(MIKTEX_REL_TEXJP_DIR                "Programs/TeXAndFriends/texjp")
 set(MIKTEX_REL_TEXMF_DIR                "Libraries/MiKTeX/TeXAndFriends")
+set(MIKTEX_REL_TEXMF_BENCH_DIR          "Programs/TeXAndFriends/bench")
 set(MIKTEX_REL_TEXWARE_DIR              "Programs/TeXAndFriends/Knuth/texware")
 set(MIKTEX_REL_TEXWORKS_DIR             "Programs/Editors/TeXworks")
 set(MIKTEX_REL_TIE_DIR                  "BuildUtilities/tie")